@@ -91,7 +91,9 @@ static void InitializePlatform() {
             &(const HAPPlatformTCPStreamManagerOptions) {
                     .interfaceName = NULL,       // Listen on all available network interfaces.
                     .port = kHAPNetworkPort_Any, // Listen on unused port number from the ephemeral port range.
-                    .maxConcurrentTCPStreams = kHAPIPSessionStorage_DefaultNumElements });
+                    // One more TCP stream than IP sessions lets the accessory server admit new connections
+                    // by evicting an idle session when all sessions are in use.
+                    .maxConcurrentTCPStreams = kHAPIPSessionStorage_DefaultNumElements + 1 });
 
     // Service discovery.
     static HAPPlatformServiceDiscovery serviceDiscovery;
@@ -132,6 +134,12 @@ static void InitializePlatform() {
 
     platform.hapAccessoryServerOptions.maxPairings = kHAPPairingStorage_MinElements;
 
+    // Flattened attribute database.
+    static HAPAttributeDatabaseElementRef attributeDatabaseElements[HAPAttributeDatabaseGetNumElements(
+            /* numAccessories: */ 1, kAttributeCount)];
+    platform.hapAccessoryServerOptions.attributeDatabase.elements = attributeDatabaseElements;
+    platform.hapAccessoryServerOptions.attributeDatabase.numElements = HAPArrayCount(attributeDatabaseElements);
+
     platform.hapPlatform.authentication.mfiTokenAuth =
             HAPPlatformMFiTokenAuthIsProvisioned(&platform.mfiTokenAuth) ? &platform.mfiTokenAuth : NULL;
 
@@ -234,6 +242,7 @@ static void InitializeIP() {
     static HAPIPReadContextRef ipReadContexts[kAttributeCount];
     static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
     static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static uint8_t ipAccessoriesCacheBytes[kAttributeCount * kHAPIPAccessoriesCache_BytesPerAttribute];
     static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
         .sessions = ipSessions,
         .numSessions = HAPArrayCount(ipSessions),
@@ -241,11 +250,14 @@ static void InitializeIP() {
         .numReadContexts = HAPArrayCount(ipReadContexts),
         .writeContexts = ipWriteContexts,
         .numWriteContexts = HAPArrayCount(ipWriteContexts),
-        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer },
+        .accessoriesCache = { .bytes = ipAccessoriesCacheBytes, .numBytes = sizeof ipAccessoriesCacheBytes }
     };
 
     platform.hapAccessoryServerOptions.ip.transport = &kHAPAccessoryServerTransport_IP;
     platform.hapAccessoryServerOptions.ip.accessoryServerStorage = &ipAccessoryServerStorage;
+    // Close sessions of controllers that connect but do not complete Pair Verify.
+    platform.hapAccessoryServerOptions.ip.sessionIdleTimeouts.unverifiedSession = 10 * HAPSecond;
 
     platform.hapPlatform.ip.tcpStreamManager = &platform.tcpStreamManager;
 }
@@ -254,6 +266,8 @@ static void InitializeIP() {
 #if BLE
 static void InitializeBLE() {
     static HAPBLEGATTTableElementRef gattTableElements[kAttributeCount];
+    static uint16_t gattHandleTable[kAttributeCount * kHAPBLEGATTHandleTable_EntriesPerGATTTableElement];
+    static uint8_t signatureCacheBytes[kAttributeCount * kHAPBLESignatureCache_BytesPerGATTTableElement];
     static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
     static HAPSessionRef session;
     static uint8_t procedureBytes[2048];
@@ -262,6 +276,9 @@ static void InitializeBLE() {
     static HAPBLEAccessoryServerStorage bleAccessoryServerStorage = {
         .gattTableElements = gattTableElements,
         .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .gattHandleTable = gattHandleTable,
+        .numGATTHandleTableEntries = HAPArrayCount(gattHandleTable),
+        .signatureCache = { .bytes = signatureCacheBytes, .numBytes = sizeof signatureCacheBytes },
         .sessionCacheElements = sessionCacheElements,
         .numSessionCacheElements = HAPArrayCount(sessionCacheElements),
         .session = &session,
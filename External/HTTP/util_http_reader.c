@@ -6,6 +6,12 @@
 
 #include "util_http_reader.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #define CR 13
 #define LF 10
 #define SP 32
@@ -34,40 +40,180 @@ void util_http_reader_init(struct util_http_reader* r, int type) {
     r->result_length = 0;
 }
 
+#define CLASS_TOKEN      0x01
+#define CLASS_URI        0x02
+#define CLASS_VERSION    0x04
+#define CLASS_TEXT       0x08
+#define CLASS_DIGIT      0x10
+#define CLASS_WHITESPACE 0x20
+
+#define X     (CLASS_TEXT)
+#define XW    (CLASS_TEXT | CLASS_WHITESPACE)
+#define TX    (CLASS_TOKEN | CLASS_TEXT)
+#define UX    (CLASS_URI | CLASS_TEXT)
+#define UVX   (CLASS_URI | CLASS_VERSION | CLASS_TEXT)
+#define TUX   (CLASS_TOKEN | CLASS_URI | CLASS_TEXT)
+#define TUVX  (CLASS_TOKEN | CLASS_URI | CLASS_VERSION | CLASS_TEXT)
+#define TUVXD (CLASS_TOKEN | CLASS_URI | CLASS_VERSION | CLASS_TEXT | CLASS_DIGIT)
+
+/**
+ * Character classes of all octets.
+ *
+ * - Token: RFC 7230 tchar.
+ * - URI: RFC 3986 unreserved, reserved and '%'.
+ * - Version: Characters of "HTTP/" and digits and '.'.
+ * - Text: All octets except for CTLs, but including HT.
+ */
+static const uint8_t char_classes[256] = {
+    /* 0x00 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x08 */ 0, XW, 0, 0, 0, 0, 0, 0,
+    /* 0x10 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x18 */ 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20 */ XW, TUX, X, TUX, TUX, TUX, TUX, TUX,
+    /* 0x28 */ UX, UX, TUX, TUX, UX, TUX, TUVX, UVX,
+    /* 0x30 */ TUVXD, TUVXD, TUVXD, TUVXD, TUVXD, TUVXD, TUVXD, TUVXD,
+    /* 0x38 */ TUVXD, TUVXD, UX, UX, X, UX, X, UX,
+    /* 0x40 */ UX, TUX, TUX, TUX, TUX, TUX, TUX, TUX,
+    /* 0x48 */ TUVX, TUX, TUX, TUX, TUX, TUX, TUX, TUX,
+    /* 0x50 */ TUVX, TUX, TUX, TUX, TUVX, TUX, TUX, TUX,
+    /* 0x58 */ TUX, TUX, TUX, UX, X, UX, TX, TUX,
+    /* 0x60 */ TX, TUX, TUX, TUX, TUX, TUX, TUX, TUX,
+    /* 0x68 */ TUX, TUX, TUX, TUX, TUX, TUX, TUX, TUX,
+    /* 0x70 */ TUX, TUX, TUX, TUX, TUX, TUX, TUX, TUX,
+    /* 0x78 */ TUX, TUX, TUX, X, TX, X, TUX, 0,
+    /* 0x80 */ X, X, X, X, X, X, X, X,
+    /* 0x88 */ X, X, X, X, X, X, X, X,
+    /* 0x90 */ X, X, X, X, X, X, X, X,
+    /* 0x98 */ X, X, X, X, X, X, X, X,
+    /* 0xA0 */ X, X, X, X, X, X, X, X,
+    /* 0xA8 */ X, X, X, X, X, X, X, X,
+    /* 0xB0 */ X, X, X, X, X, X, X, X,
+    /* 0xB8 */ X, X, X, X, X, X, X, X,
+    /* 0xC0 */ X, X, X, X, X, X, X, X,
+    /* 0xC8 */ X, X, X, X, X, X, X, X,
+    /* 0xD0 */ X, X, X, X, X, X, X, X,
+    /* 0xD8 */ X, X, X, X, X, X, X, X,
+    /* 0xE0 */ X, X, X, X, X, X, X, X,
+    /* 0xE8 */ X, X, X, X, X, X, X, X,
+    /* 0xF0 */ X, X, X, X, X, X, X, X,
+    /* 0xF8 */ X, X, X, X, X, X, X, X,
+};
+
+#undef X
+#undef XW
+#undef TX
+#undef UX
+#undef UVX
+#undef TUX
+#undef TUVX
+#undef TUVXD
+
+HAP_RESULT_USE_CHECK
+static int has_class(int c, uint8_t char_class) {
+    return (char_classes[(uint8_t) c] & char_class) != 0;
+}
+
 HAP_RESULT_USE_CHECK
 static int is_digit(int c) {
-    return ('0' <= c) && (c <= '9');
+    return has_class(c, CLASS_DIGIT);
 }
 
 HAP_RESULT_USE_CHECK
 static int is_whitespace(int c) {
-    return (c == SP) || (c == HT);
+    return has_class(c, CLASS_WHITESPACE);
 }
 
 HAP_RESULT_USE_CHECK
 static int is_token_char(int c) {
-    return (33 <= c) && (c < 127) && (c != '(') && (c != ')') && (c != '<') && (c != '>') && (c != '@') && (c != ',') &&
-           (c != ';') && (c != ':') && (c != '\\') && (c != '"') && (c != '/') && (c != '[') && (c != ']') &&
-           (c != '?') && (c != '=') && (c != '{') && (c != '}');
+    return has_class(c, CLASS_TOKEN);
 }
 
 HAP_RESULT_USE_CHECK
 static int is_uri_char(int c) {
-    return (('A' <= c) && (c <= 'Z')) || (('a' <= c) && (c <= 'z')) || (('0' <= c) && (c <= '9')) || (c == '%') ||
-           (c == '-') || (c == '.') || (c == '_') || (c == '~') || (c == ':') || (c == '/') || (c == '?') ||
-           (c == '#') || (c == '[') || (c == ']') || (c == '@') || (c == '!') || (c == '$') || (c == '&') ||
-           (c == '\'') || (c == '(') || (c == ')') || (c == '*') || (c == '+') || (c == ',') || (c == ';') ||
-           (c == '=');
+    return has_class(c, CLASS_URI);
 }
 
 HAP_RESULT_USE_CHECK
 static int is_version_char(int c) {
-    return (c == 'H') || (c == 'T') || (c == 'P') || (c == '/') || (c == '.') || (('0' <= c) && (c <= '9'));
+    return has_class(c, CLASS_VERSION);
 }
 
+#if defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+/**
+ * Returns a 16-bit mask of the octets in a block that end a run of text.
+ *
+ * - Octets that are not text (including CR and LF) end a run of text.
+ * - If stop_at_quotes is set, '"' and '\\' also end a run of text.
+ */
 HAP_RESULT_USE_CHECK
-static int is_text_char(int c) {
-    return (c < 0) || ((32 <= c) && (c < 127)) || (128 <= c) || (c == HT);
+static uint32_t find_text_stops(const char* block, int stop_at_quotes) {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128((const __m128i*) (const void*) block);
+    __m128i stops = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(-1)), _mm_cmplt_epi8(v, _mm_set1_epi8(SP)));
+    stops = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(HT)), stops);
+    stops = _mm_or_si128(stops, _mm_cmpeq_epi8(v, _mm_set1_epi8(127)));
+    if (stop_at_quotes) {
+        stops = _mm_or_si128(stops, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+        stops = _mm_or_si128(stops, _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+    }
+    return (uint32_t) _mm_movemask_epi8(stops);
+#else
+    static const uint8_t bitWeights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t v = vld1q_u8((const uint8_t*) block);
+    uint8x16_t stops = vbicq_u8(vcltq_u8(v, vdupq_n_u8(SP)), vceqq_u8(v, vdupq_n_u8(HT)));
+    stops = vorrq_u8(stops, vceqq_u8(v, vdupq_n_u8(127)));
+    if (stop_at_quotes) {
+        stops = vorrq_u8(stops, vceqq_u8(v, vdupq_n_u8('"')));
+        stops = vorrq_u8(stops, vceqq_u8(v, vdupq_n_u8('\\')));
+    }
+    uint8x16_t masked = vandq_u8(stops, vld1q_u8(bitWeights));
+    uint8x8_t lo = vget_low_u8(masked);
+    uint8x8_t hi = vget_high_u8(masked);
+    lo = vpadd_u8(lo, lo);
+    lo = vpadd_u8(lo, lo);
+    lo = vpadd_u8(lo, lo);
+    hi = vpadd_u8(hi, hi);
+    hi = vpadd_u8(hi, hi);
+    hi = vpadd_u8(hi, hi);
+    return (uint32_t) vget_lane_u8(lo, 0) | ((uint32_t) vget_lane_u8(hi, 0) << 8);
+#endif
+}
+
+HAP_RESULT_USE_CHECK
+static size_t count_trailing_zeros(uint32_t x) {
+    HAPPrecondition(x != 0);
+    return (size_t) __builtin_ctz(x);
+}
+#endif
+
+/**
+ * Returns the length of the run of text at the beginning of a buffer.
+ *
+ * @param      buffer               Buffer to scan.
+ * @param      length               Length of the buffer.
+ * @param      stop_at_quotes       Whether '"' and '\\' end the run of text.
+ *
+ * @return Index of the first octet that ends the run of text, or @p length if there is none.
+ */
+HAP_RESULT_USE_CHECK
+static size_t scan_text(const char* buffer, size_t length, int stop_at_quotes) {
+    size_t n;
+    HAPPrecondition(buffer != NULL);
+    n = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+    while (length - n >= 16) {
+        uint32_t stops = find_text_stops(&buffer[n], stop_at_quotes);
+        if (stops) {
+            return n + count_trailing_zeros(stops);
+        }
+        n += 16;
+    }
+#endif
+    while ((n < length) && has_class(buffer[n], CLASS_TEXT) &&
+           (!stop_at_quotes || ((buffer[n] != '"') && (buffer[n] != '\\')))) {
+        n++;
+    }
+    return n;
 }
 
 HAP_RESULT_USE_CHECK
@@ -84,34 +230,44 @@ static size_t skip_whitespace(char* buffer, size_t length) {
 }
 
 HAP_RESULT_USE_CHECK
-static size_t read_octets(struct util_http_reader* r, char* buffer, size_t length, int (*predicate)(int)) {
+static size_t read_octets(struct util_http_reader* r, char* buffer, size_t length, uint8_t char_class) {
     size_t n;
     HAPPrecondition(r != NULL);
     HAPPrecondition(buffer != NULL);
-    HAPPrecondition(predicate != NULL);
     n = 0;
     HAPAssert(n <= length);
-    while ((n < length) && predicate(buffer[n])) {
-        n++;
+    if (char_class == CLASS_TEXT) {
+        n = scan_text(buffer, length, /* stop_at_quotes: */ 0);
+    } else {
+        while ((n < length) && has_class(buffer[n], char_class)) {
+            n++;
+        }
     }
-    HAPAssert((n == length) || ((n < length) && !predicate(buffer[n])));
+    HAPAssert((n == length) || ((n < length) && !has_class(buffer[n], char_class)));
     r->result_token = buffer;
     r->result_length = n;
     return n;
 }
 
 HAP_RESULT_USE_CHECK
-static size_t read_octets_and_quotes(struct util_http_reader* r, char* buffer, size_t length, int (*predicate)(int)) {
+static size_t read_octets_and_quotes(struct util_http_reader* r, char* buffer, size_t length) {
     size_t n;
     HAPPrecondition(r != NULL);
     HAPPrecondition(buffer != NULL);
-    HAPPrecondition(predicate != NULL);
     n = 0;
     HAPAssert(n <= length);
-    while ((n < length) && (r->in_quoted_pair || predicate(buffer[n]))) {
+    while (n < length) {
         if (r->in_quoted_pair) {
             r->in_quoted_pair = 0;
-        } else if (r->in_quoted_string) {
+            n++;
+            continue;
+        }
+        n += scan_text(&buffer[n], length - n, /* stop_at_quotes: */ 1);
+        HAPAssert(n <= length);
+        if ((n == length) || !has_class(buffer[n], CLASS_TEXT)) {
+            break;
+        }
+        if (r->in_quoted_string) {
             if (buffer[n] == '\\') {
                 r->in_quoted_pair = 1;
             } else if (buffer[n] == '"') {
@@ -122,7 +278,7 @@ static size_t read_octets_and_quotes(struct util_http_reader* r, char* buffer, s
         }
         n++;
     }
-    HAPAssert((n == length) || ((n < length) && !r->in_quoted_pair && !predicate(buffer[n])));
+    HAPAssert((n == length) || ((n < length) && !r->in_quoted_pair && !has_class(buffer[n], CLASS_TEXT)));
     r->result_token = buffer;
     r->result_length = n;
     return n;
@@ -174,7 +330,7 @@ size_t util_http_reader_read(struct util_http_reader* r, char* buffer, size_t le
                         }
                     } else {
                         HAPAssert(r->substate == SUBSTATE_READING);
-                        n += read_octets(r, &buffer[n], length - n, is_token_char);
+                        n += read_octets(r, &buffer[n], length - n, CLASS_TOKEN);
                         HAPAssert(n <= length);
                         if (n < length) {
                             r->state = util_HTTP_READER_STATE_COMPLETED_METHOD;
@@ -212,7 +368,7 @@ size_t util_http_reader_read(struct util_http_reader* r, char* buffer, size_t le
                         }
                     } else {
                         HAPAssert(r->substate == SUBSTATE_READING);
-                        n += read_octets(r, &buffer[n], length - n, is_uri_char);
+                        n += read_octets(r, &buffer[n], length - n, CLASS_URI);
                         HAPAssert(n <= length);
                         if (n < length) {
                             r->state = util_HTTP_READER_STATE_COMPLETED_URI;
@@ -276,7 +432,7 @@ size_t util_http_reader_read(struct util_http_reader* r, char* buffer, size_t le
                         }
                     } else {
                         HAPAssert(r->substate == SUBSTATE_READING);
-                        n += read_octets(r, &buffer[n], length - n, is_version_char);
+                        n += read_octets(r, &buffer[n], length - n, CLASS_VERSION);
                         HAPAssert(n <= length);
                         if (n < length) {
                             r->state = util_HTTP_READER_STATE_COMPLETED_VERSION;
@@ -319,7 +475,7 @@ size_t util_http_reader_read(struct util_http_reader* r, char* buffer, size_t le
                         }
                     } else {
                         HAPAssert(r->substate == SUBSTATE_READING);
-                        n += read_octets(r, &buffer[n], length - n, is_digit);
+                        n += read_octets(r, &buffer[n], length - n, CLASS_DIGIT);
                         HAPAssert(n <= length);
                         if (n < length) {
                             r->state = util_HTTP_READER_STATE_COMPLETED_STATUS;
@@ -349,7 +505,7 @@ size_t util_http_reader_read(struct util_http_reader* r, char* buffer, size_t le
                     }
                     break;
                 case util_HTTP_READER_STATE_READING_REASON:
-                    n += read_octets(r, &buffer[n], length - n, is_text_char);
+                    n += read_octets(r, &buffer[n], length - n, CLASS_TEXT);
                     HAPAssert(n <= length);
                     if (n < length) {
                         r->state = util_HTTP_READER_STATE_COMPLETED_REASON;
@@ -389,7 +545,7 @@ size_t util_http_reader_read(struct util_http_reader* r, char* buffer, size_t le
                         }
                     } else {
                         HAPAssert(r->substate == SUBSTATE_READING);
-                        n += read_octets(r, &buffer[n], length - n, is_token_char);
+                        n += read_octets(r, &buffer[n], length - n, CLASS_TOKEN);
                         HAPAssert(n <= length);
                         if (n < length) {
                             r->state = util_HTTP_READER_STATE_COMPLETED_HEADER_NAME;
@@ -409,7 +565,7 @@ size_t util_http_reader_read(struct util_http_reader* r, char* buffer, size_t le
                     }
                     break;
                 case util_HTTP_READER_STATE_READING_HEADER_VALUE:
-                    n += read_octets_and_quotes(r, &buffer[n], length - n, is_text_char);
+                    n += read_octets_and_quotes(r, &buffer[n], length - n);
                     HAPAssert(n <= length);
                     if (n < length) {
                         r->state = util_HTTP_READER_STATE_COMPLETED_HEADER_VALUE;
@@ -5,6 +5,7 @@
 // See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
 
 #include "util_json_reader.h"
+#include "util_json_scanner.h"
 
 #define SUBSTATE_NONE 0
 
@@ -38,54 +39,6 @@ void util_json_reader_init(struct util_json_reader* r) {
     r->substate = SUBSTATE_NONE;
 }
 
-HAP_RESULT_USE_CHECK
-static size_t skip_digits(const char* buffer, size_t length) {
-    size_t n;
-    int x;
-    HAPPrecondition(buffer != NULL);
-    n = 0;
-    HAPAssert(n <= length);
-    if (n < length) {
-        x = buffer[n];
-        while (('0' <= x) && (x <= '9')) {
-            n++;
-            HAPAssert(n <= length);
-            if (n < length) {
-                x = buffer[n];
-            } else {
-                x = -1;
-            }
-        }
-    }
-    HAPAssert((n == length) || ((n < length) && ((buffer[n] < '0') || (buffer[n] > '9'))));
-    return n;
-}
-
-HAP_RESULT_USE_CHECK
-static size_t skip_whitespace(const char* buffer, size_t length) {
-    size_t n;
-    int x;
-    HAPPrecondition(buffer != NULL);
-    n = 0;
-    HAPAssert(n <= length);
-    if (n < length) {
-        x = buffer[n];
-        while ((x == ' ') || (x == '\t') || (x == '\n') || (x == '\r')) {
-            n++;
-            HAPAssert(n <= length);
-            if (n < length) {
-                x = buffer[n];
-            } else {
-                x = -1;
-            }
-        }
-    }
-    HAPAssert(
-            (n == length) ||
-            ((n < length) && (buffer[n] != ' ') && (buffer[n] != '\t') && (buffer[n] != '\n') && (buffer[n] != '\r')));
-    return n;
-}
-
 HAP_RESULT_USE_CHECK
 size_t util_json_reader_read(struct util_json_reader* r, const char* buffer, size_t length) {
     size_t n;
@@ -98,7 +51,7 @@ size_t util_json_reader_read(struct util_json_reader* r, const char* buffer, siz
         do {
             switch (r->state) {
                 case util_JSON_READER_STATE_READING_WHITESPACE:
-                    n += skip_whitespace(&buffer[n], length - n);
+                    n += util_json_scanner_skip_whitespace(&buffer[n], length - n);
                     HAPAssert(n <= length);
                     if (n < length) {
                         switch (buffer[n]) {
@@ -253,7 +206,7 @@ size_t util_json_reader_read(struct util_json_reader* r, const char* buffer, siz
                             }
                             break;
                         case SUBSTATE_READING_NUMBER_INTEGER_PART:
-                            n += skip_digits(&buffer[n], length - n);
+                            n += util_json_scanner_skip_digits(&buffer[n], length - n);
                             HAPAssert(n <= length);
                             if (n < length) {
                                 switch (buffer[n]) {
@@ -305,7 +258,7 @@ size_t util_json_reader_read(struct util_json_reader* r, const char* buffer, siz
                             }
                             break;
                         case SUBSTATE_READING_NUMBER_FRACTION_PART_AFTER_DIGIT:
-                            n += skip_digits(&buffer[n], length - n);
+                            n += util_json_scanner_skip_digits(&buffer[n], length - n);
                             HAPAssert(n <= length);
                             if (n < length) {
                                 switch (buffer[n]) {
@@ -379,7 +332,7 @@ size_t util_json_reader_read(struct util_json_reader* r, const char* buffer, siz
                             }
                             break;
                         case SUBSTATE_READING_NUMBER_EXPONENT_PART_AFTER_DIGIT:
-                            n += skip_digits(&buffer[n], length - n);
+                            n += util_json_scanner_skip_digits(&buffer[n], length - n);
                             HAPAssert(n <= length);
                             if (n < length) {
                                 switch (buffer[n]) {
@@ -423,16 +376,19 @@ size_t util_json_reader_read(struct util_json_reader* r, const char* buffer, siz
                             case SUBSTATE_NONE:
                                 if (buffer[n] == '\\') {
                                     r->substate = SUBSTATE_READING_STRING_AFTER_ESCAPE;
+                                    n++;
+                                } else {
+                                    n += util_json_scanner_skip_string_characters(&buffer[n], length - n);
                                 }
                                 break;
                             case SUBSTATE_READING_STRING_AFTER_ESCAPE:
                                 r->substate = SUBSTATE_NONE;
+                                n++;
                                 break;
                             default:
                                 HAPFatalError();
                                 break;
                         }
-                        n++;
                     }
                     HAPAssert(n <= length);
                     if (n < length) {
@@ -0,0 +1,223 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "util_json_scanner.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define util_JSON_SCANNER_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define util_JSON_SCANNER_NEON 1
+#endif
+
+#define BLOCK_MASK ((uint32_t)((1u << util_JSON_SCANNER_BLOCK_SIZE) - 1))
+
+/**
+ * Returns the index of the least significant set bit.
+ *
+ * @param      x                    Value. Must not be 0.
+ *
+ * @return Index of the least significant set bit.
+ */
+HAP_RESULT_USE_CHECK
+static size_t count_trailing_zeros(uint32_t x) {
+    HAPPrecondition(x != 0);
+#if __has_builtin(__builtin_ctz) || defined(__GNUC__)
+    return (size_t) __builtin_ctz(x);
+#else
+    size_t n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+HAP_RESULT_USE_CHECK
+static bool is_whitespace(char x) {
+    return (x == ' ') || (x == '\t') || (x == '\n') || (x == '\r');
+}
+
+HAP_RESULT_USE_CHECK
+static bool is_digit(char x) {
+    return ('0' <= x) && (x <= '9');
+}
+
+HAP_RESULT_USE_CHECK
+static bool is_structural(char x) {
+    return (x == '{') || (x == '}') || (x == '[') || (x == ']') || (x == ':') || (x == ',');
+}
+
+void util_json_scanner_classify_scalar(const char* block, struct util_json_block* masks) {
+    HAPPrecondition(block != NULL);
+    HAPPrecondition(masks != NULL);
+
+    masks->whitespace = 0;
+    masks->structural = 0;
+    masks->quote = 0;
+    masks->backslash = 0;
+    masks->digit = 0;
+    for (size_t i = 0; i < util_JSON_SCANNER_BLOCK_SIZE; i++) {
+        uint32_t bit = (uint32_t) 1 << i;
+        char x = block[i];
+        if (is_whitespace(x)) {
+            masks->whitespace |= bit;
+        } else if (is_structural(x)) {
+            masks->structural |= bit;
+        } else if (x == '"') {
+            masks->quote |= bit;
+        } else if (x == '\\') {
+            masks->backslash |= bit;
+        } else if (is_digit(x)) {
+            masks->digit |= bit;
+        }
+    }
+}
+
+#if util_JSON_SCANNER_NEON
+/**
+ * Collapses a NEON comparison result (0x00 or 0xFF per lane) into a 16-bit mask.
+ */
+HAP_RESULT_USE_CHECK
+static uint32_t neon_movemask(uint8x16_t v) {
+    static const uint8_t bitWeights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t masked = vandq_u8(v, vld1q_u8(bitWeights));
+    uint8x8_t lo = vget_low_u8(masked);
+    uint8x8_t hi = vget_high_u8(masked);
+    lo = vpadd_u8(lo, lo);
+    lo = vpadd_u8(lo, lo);
+    lo = vpadd_u8(lo, lo);
+    hi = vpadd_u8(hi, hi);
+    hi = vpadd_u8(hi, hi);
+    hi = vpadd_u8(hi, hi);
+    return (uint32_t) vget_lane_u8(lo, 0) | ((uint32_t) vget_lane_u8(hi, 0) << 8);
+}
+#endif
+
+void util_json_scanner_classify(const char* block, struct util_json_block* masks) {
+    HAPPrecondition(block != NULL);
+    HAPPrecondition(masks != NULL);
+
+#if util_JSON_SCANNER_SSE2
+    __m128i v = _mm_loadu_si128((const __m128i*) (const void*) block);
+    // '[' and ']' only differ from '{' and '}' in bit 5.
+    __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+
+    __m128i whitespace = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    __m128i structural = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+    __m128i digit = _mm_and_si128(
+            _mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+
+    masks->whitespace = (uint32_t) _mm_movemask_epi8(whitespace);
+    masks->structural = (uint32_t) _mm_movemask_epi8(structural);
+    masks->quote = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    masks->backslash = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+    masks->digit = (uint32_t) _mm_movemask_epi8(digit);
+#elif util_JSON_SCANNER_NEON
+    uint8x16_t v = vld1q_u8((const uint8_t*) block);
+    // '[' and ']' only differ from '{' and '}' in bit 5.
+    uint8x16_t folded = vorrq_u8(v, vdupq_n_u8(0x20));
+
+    uint8x16_t whitespace = vorrq_u8(
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+    uint8x16_t structural = vorrq_u8(
+            vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))),
+            vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(','))));
+    uint8x16_t digit = vandq_u8(vcgeq_u8(v, vdupq_n_u8('0')), vcleq_u8(v, vdupq_n_u8('9')));
+
+    masks->whitespace = neon_movemask(whitespace);
+    masks->structural = neon_movemask(structural);
+    masks->quote = neon_movemask(vceqq_u8(v, vdupq_n_u8('"')));
+    masks->backslash = neon_movemask(vceqq_u8(v, vdupq_n_u8('\\')));
+    masks->digit = neon_movemask(digit);
+#else
+    util_json_scanner_classify_scalar(block, masks);
+#endif
+}
+
+HAP_RESULT_USE_CHECK
+size_t util_json_scanner_skip_whitespace(const char* buffer, size_t length) {
+    HAPPrecondition(buffer != NULL);
+
+    size_t n = 0;
+    // Tokens are usually separated by at most one whitespace byte. Avoid classifying a full block in that case.
+    while ((n < length) && (n < 2) && is_whitespace(buffer[n])) {
+        n++;
+    }
+    if ((n == length) || !is_whitespace(buffer[n])) {
+        return n;
+    }
+    while (length - n >= util_JSON_SCANNER_BLOCK_SIZE) {
+        struct util_json_block masks;
+        util_json_scanner_classify(&buffer[n], &masks);
+        uint32_t stop = ~masks.whitespace & BLOCK_MASK;
+        if (stop) {
+            return n + count_trailing_zeros(stop);
+        }
+        n += util_JSON_SCANNER_BLOCK_SIZE;
+    }
+    while ((n < length) && is_whitespace(buffer[n])) {
+        n++;
+    }
+    HAPAssert((n == length) || ((n < length) && !is_whitespace(buffer[n])));
+    return n;
+}
+
+HAP_RESULT_USE_CHECK
+size_t util_json_scanner_skip_digits(const char* buffer, size_t length) {
+    HAPPrecondition(buffer != NULL);
+
+    size_t n = 0;
+    // Most numbers in HAP requests are short (aid, iid, small values). Avoid classifying a full block in that case.
+    while ((n < length) && (n < 4) && is_digit(buffer[n])) {
+        n++;
+    }
+    if ((n == length) || !is_digit(buffer[n])) {
+        return n;
+    }
+    while (length - n >= util_JSON_SCANNER_BLOCK_SIZE) {
+        struct util_json_block masks;
+        util_json_scanner_classify(&buffer[n], &masks);
+        uint32_t stop = ~masks.digit & BLOCK_MASK;
+        if (stop) {
+            return n + count_trailing_zeros(stop);
+        }
+        n += util_JSON_SCANNER_BLOCK_SIZE;
+    }
+    while ((n < length) && is_digit(buffer[n])) {
+        n++;
+    }
+    HAPAssert((n == length) || ((n < length) && !is_digit(buffer[n])));
+    return n;
+}
+
+HAP_RESULT_USE_CHECK
+size_t util_json_scanner_skip_string_characters(const char* buffer, size_t length) {
+    HAPPrecondition(buffer != NULL);
+
+    size_t n = 0;
+    while (length - n >= util_JSON_SCANNER_BLOCK_SIZE) {
+        struct util_json_block masks;
+        util_json_scanner_classify(&buffer[n], &masks);
+        uint32_t stop = masks.quote | masks.backslash;
+        if (stop) {
+            return n + count_trailing_zeros(stop);
+        }
+        n += util_JSON_SCANNER_BLOCK_SIZE;
+    }
+    while ((n < length) && (buffer[n] != '"') && (buffer[n] != '\\')) {
+        n++;
+    }
+    HAPAssert((n == length) || ((n < length) && ((buffer[n] == '"') || (buffer[n] == '\\'))));
+    return n;
+}
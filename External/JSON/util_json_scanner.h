@@ -0,0 +1,81 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef UTIL_JSON_SCANNER_H
+#define UTIL_JSON_SCANNER_H
+
+#include "HAPPlatform.h"
+
+/**
+ * Number of bytes that are classified at once.
+ */
+#define util_JSON_SCANNER_BLOCK_SIZE 16
+
+/**
+ * Character classes of a block of util_JSON_SCANNER_BLOCK_SIZE bytes.
+ *
+ * - Bit i of each mask is set if byte i of the block belongs to the corresponding class.
+ */
+struct util_json_block {
+    uint32_t whitespace; /**< ' ', '\t', '\n', '\r'. */
+    uint32_t structural; /**< '{', '}', '[', ']', ':', ','. */
+    uint32_t quote;      /**< '"'. */
+    uint32_t backslash;  /**< '\\'. */
+    uint32_t digit;      /**< '0' - '9'. */
+};
+
+/**
+ * Classifies a block of util_JSON_SCANNER_BLOCK_SIZE bytes.
+ *
+ * - Uses SSE2 or NEON when available, and falls back to a portable implementation otherwise.
+ *
+ * @param      block                Block of util_JSON_SCANNER_BLOCK_SIZE bytes.
+ * @param[out] masks                Character classes of the block.
+ */
+void util_json_scanner_classify(const char* block, struct util_json_block* masks);
+
+/**
+ * Classifies a block of util_JSON_SCANNER_BLOCK_SIZE bytes without using vector instructions.
+ *
+ * @param      block                Block of util_JSON_SCANNER_BLOCK_SIZE bytes.
+ * @param[out] masks                Character classes of the block.
+ */
+void util_json_scanner_classify_scalar(const char* block, struct util_json_block* masks);
+
+/**
+ * Returns the number of leading whitespace bytes.
+ *
+ * @param      buffer               Buffer to scan.
+ * @param      length               Length of the buffer.
+ *
+ * @return Index of the first byte that is not whitespace, or @p length if there is none.
+ */
+HAP_RESULT_USE_CHECK
+size_t util_json_scanner_skip_whitespace(const char* buffer, size_t length);
+
+/**
+ * Returns the number of leading decimal digits.
+ *
+ * @param      buffer               Buffer to scan.
+ * @param      length               Length of the buffer.
+ *
+ * @return Index of the first byte that is not a digit, or @p length if there is none.
+ */
+HAP_RESULT_USE_CHECK
+size_t util_json_scanner_skip_digits(const char* buffer, size_t length);
+
+/**
+ * Returns the number of leading string bytes that are neither a quotation mark nor a reverse solidus.
+ *
+ * @param      buffer               Buffer to scan.
+ * @param      length               Length of the buffer.
+ *
+ * @return Index of the first '"' or '\\', or @p length if there is none.
+ */
+HAP_RESULT_USE_CHECK
+size_t util_json_scanner_skip_string_characters(const char* buffer, size_t length);
+
+#endif
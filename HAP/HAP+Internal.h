@@ -59,6 +59,7 @@ extern "C" {
 #include "HAPBLEProcedure.h"
 #include "HAPBLEProtocol+Configuration.h"
 #include "HAPBLEService+Signature.h"
+#include "HAPBLESignatureCache.h"
 #include "HAPBLESession.h"
 
 #include "HAPIP+ByteBuffer.h"
@@ -66,7 +67,6 @@ extern "C" {
 #include "HAPIPAccessoryProtocol.h"
 #include "HAPIPCharacteristic.h"
 #include "HAPIPSecurityProtocol.h"
-#include "HAPIPSession.h"
 
 #include "HAPIPAccessoryServer.h"
 #include "HAPIPServiceDiscovery.h"
@@ -77,7 +77,10 @@ extern "C" {
 #include "HAPAccessorySetup.h"
 #include "HAPAccessorySetupInfo.h"
 #include "HAPAccessoryValidation.h"
+#include "HAPAttributeDatabase.h"
 #include "HAPCharacteristic.h"
+#include "HAPCharacteristicValueCache.h"
+#include "HAPIPSession.h"
 
 #include "HAPJSONUtils.h"
 #include "HAPLog+Attributes.h"
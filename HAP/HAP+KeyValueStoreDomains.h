@@ -85,7 +85,11 @@ extern "C" {
 /**
  * BLE Global State Number.
  *
- * Format: <gsn : uint16_t> <didIncrement (0x01) : uint8_t>, little endian.
+ * Format: <gsn : uint16_t> <flags : uint8_t>, little endian.
+ *
+ * Flags:
+ *     0x01 - Legacy: GSN has been incremented while disconnected. Ignored.
+ *     0x02 - GSN has been reserved ahead of time. GSNs before it may not have been used.
  */
 #define kHAPKeyValueStoreKey_Configuration_BLEGSN ((HAPPlatformKeyValueStoreKey) 0x40)
 
@@ -215,7 +215,7 @@ void HAPTLVWriterGetScratchBytes(
 /**
  * HomeKit Accessory server.
  */
-typedef HAP_OPAQUE(2418) HAPAccessoryServerRef;
+typedef HAP_OPAQUE(2808) HAPAccessoryServerRef;
 HAP_NONNULL_SUPPORT(HAPAccessoryServerRef)
 
 /**
@@ -402,6 +402,22 @@ typedef struct {
      */
     bool supportsAuthorizationData : 1;
 
+    /**
+     * Read values of the characteristic may be served from the characteristic value cache.
+     *
+     * - After a successful read, the value is stored in the characteristic value cache. Subsequent reads are answered
+     *   from the cache without calling the read handler until the HAPAccessoryServerRaiseEvent or
+     *   HAPAccessoryServerRaiseEventOnSession function is called for the characteristic, until a write request
+     *   is handled for the characteristic, or until the time to live of the cache expires.
+     *
+     * - The value must not depend on the session over which it is read. Whenever the value changes,
+     *   the HAPAccessoryServerRaiseEvent function must be called.
+     *
+     * - This property is only supported for the formats Bool, UInt8, UInt16, UInt32, UInt64, Int and Float.
+     *   It is ignored for other formats, and if no characteristic value cache storage is provided.
+     */
+    bool cacheable : 1;
+
     /**
      * These properties only affect connections over IP (Ethernet / Wi-Fi).
      *
@@ -552,6 +568,22 @@ HAP_ENUM_BEGIN(uint8_t, HAPTransportType) { /**
                                             kHAPTransportType_BLE
 } HAP_ENUM_END(uint8_t, HAPTransportType);
 
+/**
+ * Opaque token that identifies a read or write request whose handler completes asynchronously.
+ *
+ * - Each request that may complete asynchronously is assigned a new token.
+ *   Completions with tokens of earlier requests are ignored.
+ *
+ * - Asynchronous completion is supported for reads and writes of GET and PUT /characteristics requests over IP,
+ *   on any number of sessions concurrently. Over Bluetooth LE, requests must be completed synchronously.
+ */
+typedef uint32_t HAPCompletionToken;
+
+/**
+ * Completion token of requests that must be completed synchronously.
+ */
+#define kHAPCompletionToken_None ((HAPCompletionToken) 0)
+
 typedef void HAPCharacteristic;
 typedef struct HAPService HAPService;
 typedef struct HAPAccessory HAPAccessory;
@@ -594,6 +626,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPDataCharacteristicReadRequest;
 
 /**
@@ -642,6 +681,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPDataCharacteristicWriteRequest;
 
 /**
@@ -746,6 +792,7 @@ struct HAPDataCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -776,6 +823,7 @@ struct HAPDataCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -812,6 +860,47 @@ struct HAPDataCharacteristic {
                 HAPAccessoryServerRef* server,
                 const HAPDataCharacteristicSubscriptionRequest* request,
                 void* _Nullable context);
+
+        /**
+         * The callback used to handle streaming read requests.
+         * On success, the value stored in the value buffer is sent back to the controller as the next part
+         * of the value, starting at the given offset.
+         *
+         * - Optional. If set, a GET /characteristics request over IP that reads only this characteristic
+         *   (without the meta, perms, type or ev parameters) is answered by calling this callback repeatedly
+         *   with increasing offsets. The value is base64 encoded and sent incrementally using chunked transfer
+         *   encoding, so it does not need to fit into the scratch buffer or the outbound buffer.
+         * - handleRead is still required and is used for all other reads.
+         * - The callback must not block. Consider prefetching values if it would take too long.
+         * - The callback must return at least one byte unless the end of the value has been reached.
+         * - The complete value must satisfy the constraints of the characteristic.
+         * - If the callback fails after the first part of the value has been sent, the connection is closed.
+         *
+         * @param      server               Accessory server.
+         * @param      request              Request.
+         * @param      offset               Offset of the requested part within the value.
+         * @param[out] valueBytes           Value buffer.
+         * @param      maxValueBytes        Capacity of value buffer.
+         * @param[out] numValueBytes        Length of value buffer.
+         * @param[out] isComplete           Whether the end of the value has been reached.
+         * @param      context              The context parameter given to the HAPAccessoryServerCreate function.
+         *
+         * @return kHAPError_None           If successful.
+         * @return kHAPError_Unknown        If unable to perform operation with requested service or characteristic.
+         * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
+         * @return kHAPError_OutOfResources If out of resources to process request.
+         * @return kHAPError_Busy           If the request failed temporarily.
+         */
+        HAP_RESULT_USE_CHECK
+        HAPError (*_Nullable handleReadChunk)(
+                HAPAccessoryServerRef* server,
+                const HAPDataCharacteristicReadRequest* request,
+                size_t offset,
+                void* valueBytes,
+                size_t maxValueBytes,
+                size_t* numValueBytes,
+                bool* isComplete,
+                void* _Nullable context);
     } callbacks;
 };
 
@@ -854,6 +943,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPBoolCharacteristicReadRequest;
 
 /**
@@ -902,6 +998,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPBoolCharacteristicWriteRequest;
 
 /**
@@ -997,6 +1100,7 @@ struct HAPBoolCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -1024,6 +1128,7 @@ struct HAPBoolCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -1101,6 +1206,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPUInt8CharacteristicReadRequest;
 
 /**
@@ -1149,6 +1261,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPUInt8CharacteristicWriteRequest;
 
 /**
@@ -1289,6 +1408,7 @@ struct HAPUInt8Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -1316,6 +1436,7 @@ struct HAPUInt8Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -1393,6 +1514,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPUInt16CharacteristicReadRequest;
 
 /**
@@ -1441,6 +1569,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPUInt16CharacteristicWriteRequest;
 
 /**
@@ -1550,6 +1685,7 @@ struct HAPUInt16Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -1577,6 +1713,7 @@ struct HAPUInt16Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -1654,6 +1791,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPUInt32CharacteristicReadRequest;
 
 /**
@@ -1702,6 +1846,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPUInt32CharacteristicWriteRequest;
 
 /**
@@ -1811,6 +1962,7 @@ struct HAPUInt32Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -1838,6 +1990,7 @@ struct HAPUInt32Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -1915,6 +2068,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPUInt64CharacteristicReadRequest;
 
 /**
@@ -1963,6 +2123,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPUInt64CharacteristicWriteRequest;
 
 /**
@@ -2072,6 +2239,7 @@ struct HAPUInt64Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -2099,6 +2267,7 @@ struct HAPUInt64Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -2176,6 +2345,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPIntCharacteristicReadRequest;
 
 /**
@@ -2224,6 +2400,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPIntCharacteristicWriteRequest;
 
 /**
@@ -2333,6 +2516,7 @@ struct HAPIntCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -2360,6 +2544,7 @@ struct HAPIntCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -2437,6 +2622,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPFloatCharacteristicReadRequest;
 
 /**
@@ -2485,6 +2677,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPFloatCharacteristicWriteRequest;
 
 /**
@@ -2594,6 +2793,7 @@ struct HAPFloatCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -2621,6 +2821,7 @@ struct HAPFloatCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -2698,6 +2899,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPStringCharacteristicReadRequest;
 
 /**
@@ -2746,6 +2954,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPStringCharacteristicWriteRequest;
 
 /**
@@ -2849,6 +3064,7 @@ struct HAPStringCharacteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -2877,6 +3093,7 @@ struct HAPStringCharacteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -2954,6 +3171,13 @@ typedef struct {
      * The accessory that provides the service.
      */
     const HAPAccessory* accessory;
+
+    /**
+     * Token to complete the read later through HAPAccessoryServerCompleteRead.
+     *
+     * - kHAPCompletionToken_None if the read handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPTLV8CharacteristicReadRequest;
 
 /**
@@ -3002,6 +3226,13 @@ typedef struct {
         const void* _Nullable bytes; /**< Raw AAD data, if applicable. */
         size_t numBytes;             /**< Length of additional authorization data. */
     } authorizationData;
+
+    /**
+     * Token to complete the write later through HAPAccessoryServerCompleteWrite.
+     *
+     * - kHAPCompletionToken_None if the write handler must not return kHAPError_InProgress.
+     */
+    HAPCompletionToken completionToken;
 } HAPTLV8CharacteristicWriteRequest;
 
 /**
@@ -3097,6 +3328,7 @@ struct HAPTLV8Characteristic {
          * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the read completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleRead)(
@@ -3124,6 +3356,7 @@ struct HAPTLV8Characteristic {
          * @return kHAPError_OutOfResources If out of resources to process request.
          * @return kHAPError_NotAuthorized  If additional authorization data is insufficient.
          * @return kHAPError_Busy           If the request failed temporarily.
+         * @return kHAPError_InProgress     If the write completes later through its completion token.
          */
         HAP_RESULT_USE_CHECK
         HAPError (*_Nullable handleWrite)(
@@ -3578,7 +3811,7 @@ typedef HAP_OPAQUE(64) HAPIPWriteContextRef;
 /**
  * IP session descriptor.
  */
-typedef HAP_OPAQUE(832) HAPIPSessionDescriptorRef;
+typedef HAP_OPAQUE(1408) HAPIPSessionDescriptorRef;
 
 /**
  * IP event notification.
@@ -3600,6 +3833,13 @@ typedef HAP_OPAQUE(24) HAPIPEventNotificationRef;
  */
 #define kHAPIPSession_DefaultScratchBufferSize ((size_t) 32768)
 
+/**
+ * Default size for the resident inbound and outbound buffers of an IP session if a session buffer pool is used.
+ *
+ * - Resident buffers must fit at least one encrypted frame and the header of an EVENT message.
+ */
+#define kHAPIPSession_DefaultResidentBufferSize ((size_t) 2048)
+
 /**
  * IP session.
  *
@@ -3623,6 +3863,13 @@ typedef struct {
          *
          * - It is recommended to allocate at least kHAPIPSession_DefaultInboundBufferSize bytes,
          *   but the optimal size may vary depending on the accessory's attribute database.
+         *
+         * - If a write staging buffer is provided in the HAPIPAccessoryServerStorage structure, bodies of
+         *   PUT /characteristics requests do not need to fit into the inbound buffer, and a few kilobytes
+         *   are sufficient for accessories whose other requests are small.
+         *
+         * - If a session buffer pool is provided in the HAPIPAccessoryServerStorage structure, this buffer is only
+         *   used while the session is idle. kHAPIPSession_DefaultResidentBufferSize bytes are sufficient.
          */
         void* bytes;
 
@@ -3641,6 +3888,10 @@ typedef struct {
          *
          * - It is recommended to allocate at least kHAPIPSession_DefaultOutboundBufferSize bytes,
          *   but the optimal size may vary depending on the accessory's attribute database.
+         *
+         * - If a session buffer pool is provided in the HAPIPAccessoryServerStorage structure, this buffer is only
+         *   used for event notifications while all pooled buffers are in use.
+         *   kHAPIPSession_DefaultResidentBufferSize bytes are sufficient.
          */
         void* bytes;
 
@@ -3664,11 +3915,62 @@ typedef struct {
     size_t numEventNotifications;
 } HAPIPSession;
 
+/**
+ * Inbound and outbound buffer of an IP session buffer pool.
+ *
+ * - Pooled buffers are lent to IP sessions while they handle a request. See HAPIPAccessoryServerStorage.
+ *
+ * - The provided memory must remain valid while the accessory server is initialized.
+ */
+typedef struct {
+    /**
+     * Buffer to store received data.
+     */
+    struct {
+        /**
+         * Inbound buffer. Must be at least as large as the inbound buffers of the IP sessions.
+         *
+         * - It is recommended to allocate at least kHAPIPSession_DefaultInboundBufferSize bytes.
+         */
+        void* bytes;
+
+        /**
+         * Size of inbound buffer.
+         */
+        size_t numBytes;
+    } inboundBuffer;
+
+    /**
+     * Buffer to store pending data to be sent.
+     */
+    struct {
+        /**
+         * Outbound buffer. Must be at least as large as the outbound buffers of the IP sessions.
+         *
+         * - It is recommended to allocate at least kHAPIPSession_DefaultOutboundBufferSize bytes.
+         */
+        void* bytes;
+
+        /**
+         * Size of outbound buffer.
+         */
+        size_t numBytes;
+    } outboundBuffer;
+} HAPIPSessionBuffers;
+
 /**
  * Default number of elements in a HAPIPSessionStorage.
  */
 #define kHAPIPSessionStorage_DefaultNumElements ((size_t) 17)
 
+/**
+ * Recommended number of GET /accessories cache bytes per HomeKit characteristic and service.
+ *
+ * - Characteristics with an Apple-defined type typically take 70-100 bytes.
+ *   Vendor-specific types, descriptions and constraints add to that. Services are smaller.
+ */
+#define kHAPIPAccessoriesCache_BytesPerAttribute ((size_t) 128)
+
 /**
  * IP server storage.
  *
@@ -3685,6 +3987,11 @@ typedef struct {
      * - One session must be provided per concurrently supported IP connection.
      *   Each session contains additional memory that needs to be allocated. See HAPIPSession.
      *
+     * - If the TCP stream manager supports more concurrent TCP streams than sessions are provided, a connection
+     *   that arrives while all sessions are in use is admitted by evicting the least recently active session
+     *   on which Pair Verify has not been completed. If there is none, the least recently active idle session
+     *   without event notification subscriptions is evicted. If no session can be evicted, the connection is closed.
+     *
      * - At least eight elements are required for IP (Ethernet / Wi-Fi) accessories.
      */
     HAPIPSession* sessions;
@@ -3737,6 +4044,84 @@ typedef struct {
          */
         size_t numBytes;
     } scratchBuffer;
+
+    /**
+     * Buffer for the cached GET /accessories response. Optional.
+     *
+     * - If provided, the static parts of the GET /accessories response are serialized into this buffer when the
+     *   accessory server starts. Requests are answered by copying the cached response. Only characteristic values
+     *   and event notification states are serialized on request.
+     *
+     * - kHAPIPAccessoriesCache_BytesPerAttribute bytes per HomeKit characteristic and service are sufficient
+     *   for typical attribute databases. If the buffer is too small, or if the configuration number changes while
+     *   the accessory server is running, the whole response is serialized on request instead.
+     *
+     * - The cache refers to characteristics by their flattened attribute database records. It is only used if
+     *   flattened attribute database storage is provided in the accessory server options.
+     */
+    struct {
+        /**
+         * Cache buffer.
+         */
+        void* _Nullable bytes;
+
+        /**
+         * Size of cache buffer.
+         */
+        size_t numBytes;
+    } accessoriesCache;
+
+    /**
+     * Buffer for staging string values of PUT /characteristics requests whose body does not fit into the inbound
+     * buffer of a session. Optional.
+     *
+     * - Such requests are parsed while they are received. Each write request is handled as soon as it is complete.
+     *   Values of data and TLV8 characteristics are base64 decoded into this buffer while they are received.
+     *
+     * - The buffer is used by one session at a time. Large string, data and TLV8 values that are received while
+     *   the buffer is not available, or that do not fit into the buffer, are rejected with an out of resources
+     *   status. Inbound buffers only need to fit the largest request that is parsed as a whole.
+     *
+     * - Malformed requests are answered once they have been received completely. Write requests that precede the
+     *   malformed part of such a request have already been handled by then, and cannot be undone. If there are
+     *   such write requests, the request is answered with 207 Multi-Status and the status of each handled write
+     *   request. Otherwise, it is answered with 400 Bad Request.
+     */
+    struct {
+        /**
+         * Staging buffer.
+         */
+        void* _Nullable bytes;
+
+        /**
+         * Size of staging buffer.
+         */
+        size_t numBytes;
+    } writeStagingBuffer;
+
+    /**
+     * Session buffer pool. Optional.
+     *
+     * - If provided, an IP session borrows a pair of pooled inbound and outbound buffers when it starts to handle
+     *   a request, i.e., once the request header has been received or the request does not fit into the resident
+     *   inbound buffer of the session. The buffers are returned once the response has been sent and no further
+     *   request has been received. Idle sessions only keep their small resident buffers. See HAPIPSession.
+     *
+     * - If all pooled buffers are in use, requests wait until buffers are returned. Event notifications are sent
+     *   using the resident outbound buffer if they fit, and wait otherwise.
+     *
+     * - While a request waits for asynchronous read or write handlers, the buffers are returned if the request
+     *   fits into the resident buffers of the session. They are borrowed again once the request is resumed.
+     *
+     * - Fewer pooled buffers than sessions reduce memory use at the cost of throughput when many controllers
+     *   send requests at the same time.
+     */
+    HAPIPSessionBuffers* _Nullable pooledSessionBuffers;
+
+    /**
+     * Number of pooled session buffers.
+     */
+    size_t numPooledSessionBuffers;
 } HAPIPAccessoryServerStorage;
 HAP_NONNULL_SUPPORT(HAPIPAccessoryServerStorage)
 
@@ -3749,6 +4134,72 @@ extern const HAPIPAccessoryServerTransport kHAPAccessoryServerTransport_IP;
 HAP_NONNULL_SUPPORT(HAPIPAccessoryServerTransport)
 /**@}*/
 
+/**
+ * IP event notification statistics.
+ *
+ * - Raised events are queued per IP session until they are sent in an EVENT message. The queue holds at most one
+ *   event per subscribed characteristic, i.e. repeated events for the same characteristic are coalesced.
+ *
+ * - If an EVENT message does not fit into the outbound buffer, the events that do not fit remain queued
+ *   and are sent as soon as the previous message has been written.
+ */
+typedef struct {
+    /** Number of events that are currently queued over all IP sessions. */
+    size_t numQueuedEvents;
+
+    /** Maximum number of events that have been queued on a single IP session. */
+    size_t maxQueuedEvents;
+
+    /** Number of times that an event remained queued because the outbound buffer was full. */
+    uint64_t numDeferredEvents;
+
+    /** Number of events that have been dropped because they did not fit into an empty outbound buffer. */
+    uint64_t numDroppedEvents;
+} HAPIPEventNotificationStatistics;
+
+/**
+ * Gets the IP event notification statistics of an initialized HomeKit accessory server.
+ *
+ * - Statistics are accumulated since the accessory server has been created.
+ *   If the accessory server does not support IP, all statistics are 0.
+ *
+ * @param      server               An initialized accessory server.
+ * @param[out] statistics           IP event notification statistics.
+ */
+void HAPAccessoryServerGetIPEventNotificationStatistics(
+        HAPAccessoryServerRef* server,
+        HAPIPEventNotificationStatistics* statistics);
+
+/**
+ * IP session buffer pool statistics.
+ */
+typedef struct {
+    /** Number of pooled session buffers that are currently borrowed. */
+    size_t numBorrowedBuffers;
+
+    /** Maximum number of pooled session buffers that have been borrowed at the same time. */
+    size_t maxBorrowedBuffers;
+
+    /** Number of times that pooled session buffers have been borrowed. */
+    uint64_t numBorrows;
+
+    /** Number of times that a request had to wait because all pooled session buffers were borrowed. */
+    uint64_t numWaits;
+} HAPIPSessionBufferPoolStatistics;
+
+/**
+ * Gets the IP session buffer pool statistics of an initialized HomeKit accessory server.
+ *
+ * - Statistics are accumulated since the accessory server has been created.
+ *   If the accessory server does not support IP or does not use a session buffer pool, all statistics are 0.
+ *
+ * @param      server               An initialized accessory server.
+ * @param[out] statistics           IP session buffer pool statistics.
+ */
+void HAPAccessoryServerGetIPSessionBufferPoolStatistics(
+        HAPAccessoryServerRef* server,
+        HAPIPSessionBufferPoolStatistics* statistics);
+
 /**
  * Element of the BLE GATT table.
  *
@@ -3757,6 +4208,23 @@ HAP_NONNULL_SUPPORT(HAPIPAccessoryServerTransport)
  */
 typedef HAP_OPAQUE(56) HAPBLEGATTTableElementRef;
 
+/**
+ * Number of BLE GATT handle table entries per BLE GATT table element.
+ *
+ * - A HomeKit characteristic occupies up to 4 GATT attribute handles (Characteristic declaration, value,
+ *   Client Characteristic Configuration descriptor, Characteristic Instance ID descriptor).
+ *   A HomeKit service occupies 3 (Service declaration, Service Instance ID declaration and value).
+ */
+#define kHAPBLEGATTHandleTable_EntriesPerGATTTableElement ((size_t) 4)
+
+/**
+ * Recommended number of BLE signature cache bytes per BLE GATT table element.
+ *
+ * - Characteristic signatures with a valid range typically take 60-70 bytes including their cache entry.
+ *   User descriptions and valid values add to that. Service signatures are smaller.
+ */
+#define kHAPBLESignatureCache_BytesPerGATTTableElement ((size_t) 80)
+
 /**
  * Minimum number of BLE session cache elements in a HAPBLEAccessoryServerStorage.
  */
@@ -3768,7 +4236,7 @@ typedef HAP_OPAQUE(56) HAPBLEGATTTableElementRef;
  * - For accessories that support Bluetooth LE, at least kHAPBLESessionCache_MinElements
  *   of these elements must be allocated and provided as part of a HAPBLEAccessoryServerStorage structure.
  */
-typedef HAP_OPAQUE(48) HAPBLESessionCacheElementRef;
+typedef HAP_OPAQUE(56) HAPBLESessionCacheElementRef;
 
 /**
  * HAP-BLE procedure.
@@ -3778,6 +4246,13 @@ typedef HAP_OPAQUE(48) HAPBLESessionCacheElementRef;
  */
 typedef HAP_OPAQUE(160) HAPBLEProcedureRef;
 
+/**
+ * Maximum number of BLE sessions in a HAPBLEAccessoryServerStorage.
+ *
+ * - This limits the number of centrals that may be connected concurrently.
+ */
+#define kHAPBLESessions_MaxElements ((size_t) 8)
+
 /**
  * BLE accessory server storage.
  *
@@ -3801,6 +4276,45 @@ typedef struct {
      */
     size_t numGATTTableElements;
 
+    /**
+     * BLE GATT handle table. Optional.
+     *
+     * - If provided, GATT requests are mapped to their BLE GATT table element by indexing this table with
+     *   the GATT attribute handle. Otherwise, the BLE GATT table is searched on every GATT request.
+     *
+     * - kHAPBLEGATTHandleTable_EntriesPerGATTTableElement entries per BLE GATT table element are sufficient if
+     *   the BLE peripheral manager assigns consecutive GATT attribute handles. If the table is too small to cover
+     *   all assigned GATT attribute handles, the BLE GATT table is searched instead.
+     */
+    uint16_t* _Nullable gattHandleTable;
+
+    /**
+     * Number of BLE GATT handle table entries.
+     */
+    size_t numGATTHandleTableEntries;
+
+    /**
+     * Buffer for precomputed HAP-Characteristic-Signature-Read-Responses and HAP-Service-Signature-Read-Responses.
+     * Optional.
+     *
+     * - If provided, signature responses are serialized into this buffer when the accessory server starts,
+     *   and signature requests are answered by copying the precomputed response.
+     *
+     * - kHAPBLESignatureCache_BytesPerGATTTableElement bytes per BLE GATT table element are sufficient
+     *   for typical attribute databases. Signatures that do not fit are serialized on every request instead.
+     */
+    struct {
+        /**
+         * Signature cache buffer.
+         */
+        void* _Nullable bytes;
+
+        /**
+         * Size of signature cache buffer.
+         */
+        size_t numBytes;
+    } signatureCache;
+
     /**
      * BLE Pair Resume session cache. Storage must remain valid.
      *
@@ -3822,11 +4336,29 @@ typedef struct {
 
     /**
      * BLE session storage. Storage must remain valid.
+     *
+     * - Each connected central uses its own session. If numSessions is larger than 1, this is an array of sessions.
      */
     HAPSessionRef* session;
 
+    /**
+     * Number of BLE sessions.
+     *
+     * - This determines how many centrals may be connected concurrently. At most kHAPBLESessions_MaxElements.
+     *   A central that connects while all sessions are in use is disconnected.
+     *
+     * - The accessory keeps advertising while centrals are connected and sessions are unused.
+     *   The BLE peripheral manager must then support advertising during connections.
+     *
+     * - If this is 0, a single session is provided.
+     */
+    size_t numSessions;
+
     /**
      * HAP-BLE procedures. Storage must remain valid.
+     *
+     * - The central that uses the session at a given index uses the HAP-BLE procedure at the same index.
+     *   At least one HAP-BLE procedure per session is required.
      */
     HAPBLEProcedureRef* procedures;
 
@@ -3839,6 +4371,8 @@ typedef struct {
      * Buffer that the HAP-BLE procedures may use.
      *
      * - This must be large enough to fit the largest characteristic value.
+     *
+     * - If multiple sessions are provided, the buffer is divided evenly among their HAP-BLE procedures.
      */
     struct {
         /**
@@ -3878,6 +4412,26 @@ extern const HAPBLEAccessoryServerTransport kHAPAccessoryServerTransport_BLE;
 HAP_NONNULL_SUPPORT(HAPBLEAccessoryServerTransport)
 /**@}*/
 
+/**
+ * Element of a flattened attribute database.
+ */
+typedef HAP_OPAQUE(32) HAPAttributeDatabaseElementRef;
+
+/**
+ * Returns the number of flattened attribute database elements that are needed for an attribute database.
+ *
+ * - One element is needed per accessory, per service and per characteristic.
+ *
+ * @param      numAccessories       Number of accessories, including the primary accessory.
+ * @param      numAttributes        Total number of services and characteristics of all accessories.
+ */
+#define HAPAttributeDatabaseGetNumElements(numAccessories, numAttributes) ((size_t)((numAccessories) + (numAttributes)))
+
+/**
+ * Element of the characteristic value cache.
+ */
+typedef HAP_OPAQUE(48) HAPCharacteristicValueCacheElementRef;
+
 /**
  * Accessory server initialization options.
  */
@@ -3889,6 +4443,52 @@ typedef struct {
      */
     HAPPlatformKeyValueStoreKey maxPairings;
 
+    /**
+     * Flattened attribute database storage. Optional. Storage must remain valid.
+     *
+     * - If provided, the attribute database is flattened into contiguous records when the accessory server is started.
+     *   Accessories, services and characteristics are then looked up through these records instead of walking
+     *   the NULL-terminated accessory, service and characteristic lists.
+     *
+     * - Use HAPAttributeDatabaseGetNumElements to compute the number of elements needed. If the storage is too small
+     *   for the attribute database, the lists are walked instead.
+     */
+    struct {
+        /** Flattened attribute database elements. */
+        HAPAttributeDatabaseElementRef* _Nullable elements;
+
+        /** Number of flattened attribute database elements. */
+        size_t numElements;
+    } attributeDatabase;
+
+    /**
+     * Characteristic value cache storage. Optional. Storage must remain valid.
+     *
+     * - If provided, values of characteristics with the cacheable property are cached when they are read.
+     *   This avoids calling read handlers for repeated reads, e.g. when multiple controllers poll the same
+     *   characteristic or when an event notification is sent to multiple controllers.
+     *
+     * - One element per cacheable characteristic is sufficient. If all elements are in use,
+     *   the least recently used value is evicted. At most UINT16_MAX elements are supported.
+     *
+     * - Cached values are looked up through a hash table. If the attribute database is flattened,
+     *   characteristics are hashed by the index of their characteristic record.
+     */
+    struct {
+        /** Characteristic value cache elements. */
+        HAPCharacteristicValueCacheElementRef* _Nullable elements;
+
+        /** Number of characteristic value cache elements. */
+        size_t numElements;
+
+        /**
+         * Time to live of cached values in milliseconds.
+         *
+         * - If 0, cached values remain valid until they are invalidated by an event or a write.
+         */
+        HAPTime ttl;
+    } valueCache;
+
     /**
      * IP specific initialization options.
      */
@@ -3914,6 +4514,29 @@ typedef struct {
          * IP accessory server storage. Storage must remain valid.
          */
         HAPIPAccessoryServerStorage* _Nullable accessoryServerStorage;
+
+        /**
+         * Idle timeouts of IP sessions in milliseconds.
+         *
+         * - A session is closed once it has not sent or received data for longer than the idle timeout of its state.
+         *
+         * - If an idle timeout is 0, sessions in that state are only closed after 60 seconds of inactivity
+         *   while all IP sessions are in use or while the accessory server is stopping.
+         */
+        struct {
+            /**
+             * Idle timeout of sessions on which Pair Verify has not been completed.
+             *
+             * - A short timeout frees sessions of controllers that connect but never authenticate.
+             *   Sessions that are performing Pair Setup are not affected.
+             */
+            HAPTime unverifiedSession;
+
+            /**
+             * Idle timeout of sessions on which Pair Verify has been completed.
+             */
+            HAPTime verifiedSession;
+        } sessionIdleTimeouts;
     } ip;
 
     /**
@@ -4107,6 +4730,26 @@ typedef struct {
      * @param      context              The context parameter given to the HAPAccessoryServerCreate function.
      */
     void (*handleSessionInvalidate)(HAPAccessoryServerRef* server, HAPSessionRef* session, void* _Nullable context);
+
+    /**
+     * The callback used when a read or write request whose handler returned kHAPError_InProgress is cancelled.
+     *
+     * - Requests are cancelled if they are not completed within 10 seconds, if their session is closed,
+     *   or if the accessory server cannot keep the request while it is pending.
+     *
+     * - The controller is informed that the request failed. A cancelled write should not be applied anymore.
+     *   Completions of cancelled requests are ignored.
+     *
+     * - Optional. The callback must not block.
+     *
+     * @param      server               Accessory server.
+     * @param      completionToken      Completion token of the cancelled request.
+     * @param      context              The context parameter given to the HAPAccessoryServerCreate function.
+     */
+    void (*_Nullable handleCancelledRequest)(
+            HAPAccessoryServerRef* server,
+            HAPCompletionToken completionToken,
+            void* _Nullable context);
 } HAPAccessoryServerCallbacks;
 
 /**
@@ -4163,6 +4806,29 @@ HAP_ENUM_BEGIN(uint8_t, HAPAccessoryServerState) { /** Server is initialized but
 HAP_RESULT_USE_CHECK
 HAPAccessoryServerState HAPAccessoryServerGetState(HAPAccessoryServerRef* server);
 
+/**
+ * Characteristic value cache statistics.
+ */
+typedef struct {
+    /** Number of reads of cacheable characteristics that were served from the characteristic value cache. */
+    uint64_t numHits;
+
+    /** Number of reads of cacheable characteristics that called the read handler. */
+    uint64_t numMisses;
+} HAPCharacteristicValueCacheStatistics;
+
+/**
+ * Gets the characteristic value cache statistics of an initialized HomeKit accessory server.
+ *
+ * - Statistics are accumulated since the accessory server has been created.
+ *
+ * @param      server               An initialized accessory server.
+ * @param[out] statistics           Characteristic value cache statistics.
+ */
+void HAPAccessoryServerGetCharacteristicValueCacheStatistics(
+        HAPAccessoryServerRef* server,
+        HAPCharacteristicValueCacheStatistics* statistics);
+
 /**
  * Returns whether the HomeKit accessory server is paired with any controllers.
  *
@@ -4316,6 +4982,53 @@ void HAPAccessoryServerRaiseEventOnSession(
         const HAPAccessory* accessory,
         HAPSessionRef* session);
 
+/**
+ * Completes a read request for which the read handler returned kHAPError_InProgress.
+ *
+ * - The read is identified by the completion token of the read request.
+ *   Completions of reads that are no longer pending, e.g. because they have been cancelled, are ignored.
+ *
+ * - The value is provided in the representation of the read handler of the characteristic format:
+ *   bool, uint8_t, uint16_t, uint32_t, uint64_t, int32_t or float for numeric formats, the raw bytes for data,
+ *   the UTF-8 bytes without NULL-terminator for string, and the serialized TLV items for TLV8 characteristics.
+ *   The value is copied before this function returns and must satisfy the constraints of the characteristic.
+ *
+ * - Once all pending reads of a request have been completed, the response is sent. Read handlers are not called again.
+ *
+ * - Reads that are not completed within 10 seconds are reported to the controller as busy and are cancelled.
+ *
+ * @param      server               Accessory server.
+ * @param      completionToken      Completion token of the read request.
+ * @param      error                Result of the read. Same values as returned by the read handler,
+ *                                  except kHAPError_InProgress.
+ * @param      valueBytes           Value. Ignored if the read failed.
+ * @param      numValueBytes        Length of value.
+ */
+void HAPAccessoryServerCompleteRead(
+        HAPAccessoryServerRef* server,
+        HAPCompletionToken completionToken,
+        HAPError error,
+        const void* _Nullable valueBytes,
+        size_t numValueBytes);
+
+/**
+ * Completes a write request for which the write handler returned kHAPError_InProgress.
+ *
+ * - The write is identified by the completion token of the write request.
+ *   Completions of writes that are no longer pending, e.g. because they have been cancelled, are ignored.
+ *
+ * - Writes that are not completed within 10 seconds are reported to the controller as busy and are cancelled.
+ *
+ * @param      server               Accessory server.
+ * @param      completionToken      Completion token of the write request.
+ * @param      error                Result of the write. Same values as returned by the write handler,
+ *                                  except kHAPError_InProgress.
+ */
+void HAPAccessoryServerCompleteWrite(
+        HAPAccessoryServerRef* server,
+        HAPCompletionToken completionToken,
+        HAPError error);
+
 /**
  * Restores the given key-value store to factory settings.
  *
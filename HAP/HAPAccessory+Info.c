@@ -97,11 +97,7 @@ HAPError HAPAccessoryGetInfoResponse(
         } break;
         case kHAPTransportType_BLE: {
             HAPBLEAccessoryServerGSN gsn;
-            err = HAPNonnull(server->transports.ble)->getGSN(server->platform.keyValueStore, &gsn);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            HAPNonnull(server->transports.ble)->getGSN(server_, &gsn);
             sn = gsn.gsn;
         } break;
     }
@@ -33,6 +33,37 @@ HAP_ENUM_BEGIN(uint8_t, HAPIPAccessoryServerState) { /** Server state is undefin
                                                      kHAPIPAccessoryServerState_Stopping
 } HAP_ENUM_END(uint8_t, HAPIPAccessoryServerState);
 
+/**
+ * BLE connection.
+ */
+typedef struct {
+    /**
+     * Information about the currently written characteristic.
+     */
+    struct {
+        /** Characteristic being written. */
+        const HAPCharacteristic* _Nullable characteristic;
+
+        /** The service that contains the characteristic. */
+        const HAPCharacteristic* _Nullable service;
+
+        /** The accessory that provides the service. */
+        const HAPAccessory* _Nullable accessory;
+    } write;
+
+    /** Connection handle of the connected controller, if applicable. */
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle;
+
+    /** Negotiated ATT_MTU of the connection. 0 if unknown. */
+    uint16_t mtu;
+
+    /** Whether a HomeKit controller is connected. */
+    bool connected : 1;
+
+    /** Whether the HAP-BLE procedure is attached. */
+    bool procedureAttached : 1;
+} HAPBLEAccessoryServerConnection;
+
 typedef struct {
     /** Transports. */
     struct {
@@ -58,9 +89,79 @@ typedef struct {
     /** Maximum number of allowed pairings. */
     HAPPlatformKeyValueStoreKey maxPairings;
 
+    /**
+     * Configuration number.
+     *
+     * - Loaded from the key-value store when the accessory server starts, and kept in memory afterwards.
+     *   HAPAccessoryServerIncrementCN updates it together with the key-value store.
+     */
+    uint16_t configurationNumber;
+
     /** Accessory to serve. */
     const HAPAccessory* _Nullable primaryAccessory;
 
+    /**
+     * Flattened attribute database.
+     */
+    struct {
+        /** Flattened attribute database elements. */
+        HAPAttributeDatabaseElementRef* _Nullable elements;
+
+        /** Number of flattened attribute database elements. */
+        size_t numElements;
+
+        /** Number of accessory records. 0 if the attribute database is not flattened. */
+        uint16_t numAccessories;
+
+        /** Number of service records. */
+        uint16_t numServices;
+
+        /** Number of characteristic records. */
+        uint16_t numCharacteristics;
+
+        /** Whether accessory records are sorted by accessory instance ID. */
+        bool accessoriesAreSortedByAID : 1;
+    } attributeDatabase;
+
+    /**
+     * Characteristic value cache.
+     */
+    struct {
+        /** Characteristic value cache elements. */
+        HAPCharacteristicValueCacheElementRef* _Nullable elements;
+
+        /** Number of characteristic value cache elements. */
+        size_t numElements;
+
+        /** Time to live of cached values in milliseconds. 0 if cached values do not expire. */
+        HAPTime ttl;
+
+        /** Index of the most recently used characteristic value cache element. */
+        uint16_t mostRecentlyUsed;
+
+        /** Index of the least recently used characteristic value cache element. Unused elements are kept here. */
+        uint16_t leastRecentlyUsed;
+
+        /** Statistics. */
+        HAPCharacteristicValueCacheStatistics statistics;
+    } valueCache;
+
+    /**
+     * Value of an asynchronous read that is being completed through HAPAccessoryServerCompleteRead.
+     *
+     * - Only set while the completed read is handled. The value is used instead of calling the read handler.
+     */
+    struct {
+        /** Value. */
+        const void* _Nullable bytes;
+
+        /** Length of value. */
+        size_t numBytes;
+
+        /** Whether a completed read is being handled. */
+        bool isSet;
+    } completedRead;
+
     /** Apple Authentication Coprocessor manager. */
     HAPMFiHWAuth mfi;
 
@@ -186,14 +287,108 @@ typedef struct {
         /** Timer that on expiry schedules pending event notifications. */
         HAPPlatformTimerRef eventNotificationTimer;
 
+        /** Event notification statistics. The number of queued events is computed on request. */
+        HAPIPEventNotificationStatistics eventNotificationStatistics;
+
         /** Timer that on expiry runs the garbage task. */
         HAPPlatformTimerRef garbageCollectionTimer;
 
         /** Timer that on expiry schedules a maximum idle time check. */
         HAPPlatformTimerRef maxIdleTimeTimer;
 
+        /** Idle timeouts of IP sessions. See HAPAccessoryServerOptions. */
+        struct {
+            /** Idle timeout of sessions on which Pair Verify has not been completed. 0 if not configured. */
+            HAPTime unverifiedSession;
+
+            /** Idle timeout of sessions on which Pair Verify has been completed. 0 if not configured. */
+            HAPTime verifiedSession;
+        } sessionIdleTimeouts;
+
         /** Currently registered Bonjour service. */
         HAPIPServiceDiscoveryType discoverableService;
+
+        /**
+         * Cached GET /accessories response state.
+         *
+         * - Set up when the accessory server starts. If the cache is not valid, responses are serialized on request.
+         *
+         * - The cache is stale if the configuration number changed since it was set up.
+         *   It is set up again once no session is serializing from it.
+         */
+        struct {
+            /** Number of bytes of the cached response. */
+            size_t numBytes;
+
+            /** Configuration number for which the cache was last set up, whether or not that succeeded. */
+            uint16_t configurationNumber;
+
+            /** Whether the cached response is valid. */
+            bool isValid : 1;
+        } accessoriesCache;
+
+        /** Whether the write staging buffer is used by a session. */
+        bool writeStagingBufferIsInUse;
+
+        /**
+         * Completion token that has been assigned most recently to a read or write request.
+         *
+         * - Tokens are assigned in ascending order and wrap around, skipping kHAPCompletionToken_None.
+         */
+        HAPCompletionToken lastCompletionToken;
+
+        /** Timer that on expiry resumes requests whose asynchronous handlers have completed. */
+        HAPPlatformTimerRef pendingRequestTimer;
+
+        /** Timer that on expiry fails asynchronous reads and writes that have not been completed in time. */
+        HAPPlatformTimerRef asynchronousRequestTimer;
+
+        /**
+         * Session buffer pool state.
+         *
+         * - The first bytes of the inbound buffer of a free pooled session buffer store the link to the next free
+         *   pooled session buffer (index + 1), so that 0 denotes the end of the list.
+         */
+        struct {
+            /** First free pooled session buffer (index + 1). 0 if all pooled session buffers are borrowed. */
+            size_t firstFreeBuffers;
+
+            /** Whether sessions wait until pooled session buffers are returned. */
+            bool hasWaitingSessions;
+
+            /** Session buffer pool statistics. */
+            HAPIPSessionBufferPoolStatistics statistics;
+        } sessionBufferPool;
+
+        /**
+         * IP session lists.
+         *
+         * - Each session is in exactly one of the free, open and closed session lists. Periodic work and raised
+         *   events only visit the sessions of the lists they concern instead of all sessions of the storage.
+         */
+        struct {
+            /** Sessions that are not in use. */
+            HAPIPSessionList freeSessions;
+
+            /** Sessions with an accepted TCP stream. */
+            HAPIPSessionList openSessions;
+
+            /** Closed sessions that have not yet been released by garbage collection. */
+            HAPIPSessionList closedSessions;
+
+            /** Open sessions with raised events that have not yet been sent. */
+            HAPIPSessionList eventNotificationSessions;
+
+            /** Open sessions in state kHAPIPSessionState_Waiting. */
+            HAPIPSessionList waitingSessions;
+
+            /**
+             * Waiting sessions with pending asynchronous read or write handlers.
+             *
+             * - Sessions are appended when they start waiting, so the list is ordered by expiration time.
+             */
+            HAPIPSessionList asynchronousRequestSessions;
+        } sessionLists;
     } ip;
 
     /**
@@ -202,41 +397,109 @@ typedef struct {
     struct {
         /**
          * Storage.
-         *
-         * - Implementation note: For now, we use only one procedure.
          */
         HAPBLEAccessoryServerStorage* _Nullable storage;
 
+        /**
+         * Number of BLE sessions, i.e., maximum number of concurrently connected centrals.
+         */
+        uint8_t numSessions;
+
+        /**
+         * BLE GATT handle table state.
+         *
+         * - Set up when the GATT database is registered. If no GATT attribute handles are covered,
+         *   the BLE GATT table is searched instead.
+         */
+        struct {
+            /** GATT attribute handle that corresponds to the first BLE GATT handle table entry. */
+            HAPPlatformBLEPeripheralManagerAttributeHandle firstHandle;
+
+            /** Number of GATT attribute handles covered by the BLE GATT handle table. */
+            uint16_t numHandles;
+        } gattHandleTable;
+
+        /**
+         * BLE signature cache state.
+         *
+         * - Set up when the GATT database is registered. Signatures without a cache entry are serialized on request.
+         */
+        struct {
+            /** Number of cache entries. */
+            size_t numEntries;
+        } signatureCache;
+
         /**
          * Connection information.
+         *
+         * - The connection at a given index uses the BLE session and the HAP-BLE procedure at the same index.
+         */
+        HAPBLEAccessoryServerConnection connections[kHAPBLESessions_MaxElements];
+
+        /**
+         * Pending HAP event notifications of the connected controllers.
+         *
+         * - Characteristics with a pending event are queued in the order in which their events were raised.
+         *   Urgent events (security system, lock and switch events) are queued separately and sent first.
+         *   A characteristic stays queued until its event has been sent to all connections for which it is pending.
+         *
+         * - Links refer to BLE GATT table elements by index + 1, so that 0 denotes the end of a queue.
          */
         struct {
-            /**
-             * Information about the currently written characteristic.
-             */
+            /** Event queues, in order of decreasing priority. */
             struct {
-                /** Characteristic being written. */
-                const HAPCharacteristic* _Nullable characteristic;
+                /** First queued BLE GATT table element (index + 1). 0 if the queue is empty. */
+                uint16_t first;
 
-                /** The service that contains the characteristic. */
-                const HAPCharacteristic* _Nullable service;
+                /** Last queued BLE GATT table element (index + 1). 0 if the queue is empty. */
+                uint16_t last;
+            } queues[2];
+        } pendingEvents;
+
+        /**
+         * Pair Resume session cache state.
+         */
+        struct {
+            /** Most recently used cache entry (index + 1). 0 if the cache is empty. */
+            uint16_t mostRecentlyUsed;
+
+            /** Least recently used cache entry (index + 1). 0 if the cache is empty. */
+            uint16_t leastRecentlyUsed;
+
+            /** First cache entry of the list of released cache entries (index + 1). 0 if the list is empty. */
+            uint16_t firstFreeEntry;
+
+            /** Number of cache entries that have been used at least once. Entries beyond are unused. */
+            uint16_t numInitializedEntries;
+        } sessionCache;
+
+        /**
+         * Persistent advertising state.
+         *
+         * - Loaded from the key-value store when the accessory server starts, and kept in memory afterwards.
+         *   Changes to the broadcast encryption key parameters and to the broadcast configuration of the
+         *   characteristics are written through to the key-value store.
+         *   The GSN is persisted ahead of time for a block of increments, and only when the block is used up.
+         */
+        struct {
+            /** Device ID. */
+            HAPDeviceID deviceID;
 
-                /** The accessory that provides the service. */
-                const HAPAccessory* _Nullable accessory;
-            } write;
+            /** Device ID string, used to compute the setup hash. */
+            HAPDeviceIDString deviceIDString;
 
-            /** Connection handle of the connected controller, if applicable. */
-            HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle;
+            /** GSN state. */
+            HAPBLEAccessoryServerGSN gsn;
 
-            /** Whether a HomeKit controller is connected. */
-            bool connected : 1;
+            /** Number of further GSN increments that are covered by the GSN in the key-value store. */
+            uint16_t numReservedGSNs;
 
-            /** Whether the HAP-BLE procedure is attached. */
-            bool procedureAttached : 1;
-        } connection;
+            /** Broadcast encryption key parameters. */
+            HAPBLEAccessoryServerBroadcastParameters broadcastParameters;
 
-        /** Timestamp for Least Recently Used scheme in Pair Resume session cache. */
-        uint32_t sessionCacheTimestamp;
+            /** Broadcast configuration of the characteristics. */
+            HAPBLECharacteristicBroadcastConfigurationRecord broadcastConfiguration;
+        } persistentState;
 
         /**
          * Advertisement state.
@@ -274,6 +537,13 @@ typedef struct {
 
                 /** Value. */
                 uint8_t value[8];
+
+                /**
+                 * Encrypted GSN, IID and value, followed by the truncated authentication tag.
+                 *
+                 * - Computed once when the broadcasted event starts, and reused for advertising data updates.
+                 */
+                uint8_t encryptedBytes[2 + 2 + 8 + 4];
             } broadcastedEvent;
         } adv;
     } ble;
@@ -405,13 +675,16 @@ HAPError HAPAccessoryServerGetCN(HAPPlatformKeyValueStoreRef keyValueStore, uint
  *
  * - IP: Must be called when an accessory, service or characteristic is added or removed from the accessory server.
  *
- * @param      keyValueStore        Key-value store.
+ * - The in-memory configuration number of the accessory server is updated as well.
+ *   If the accessory server is running, its advertising data is updated.
+ *
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If persistent store access failed.
  */
 HAP_RESULT_USE_CHECK
-HAPError HAPAccessoryServerIncrementCN(HAPPlatformKeyValueStoreRef keyValueStore);
+HAPError HAPAccessoryServerIncrementCN(HAPAccessoryServerRef* server);
 
 /**
  * Resets HomeKit state after a firmware update has occurred.
@@ -568,6 +841,49 @@ void HAPAccessoryServerEnumerateConnectedSessions(
 HAP_RESULT_USE_CHECK
 size_t HAPAccessoryServerGetIPSessionIndex(const HAPAccessoryServerRef* server, const HAPSessionRef* session);
 
+/**
+ * Enumerates the HAP sessions of the open IP sessions of an accessory server.
+ *
+ * @param      server               Accessory server.
+ * @param      callback             Function to call on each HAP session.
+ * @param      context              Context that is passed to the callback.
+ * @param[in,out] shouldContinue    True if enumeration shall continue, False otherwise. Must be true on input.
+ */
+void HAPAccessoryServerEnumerateIPSessions(
+        HAPAccessoryServerRef* server,
+        HAPAccessoryServerEnumerateSessionsCallback callback,
+        void* _Nullable context,
+        bool* shouldContinue);
+
+/**
+ * Gets the BLE session at a given index.
+ *
+ * - The BLE connection and the HAP-BLE procedure at the same index use the BLE session.
+ *
+ * @param      server               Accessory server.
+ * @param      sessionIndex         Index of the BLE session.
+ *
+ * @return BLE session.
+ */
+HAP_RESULT_USE_CHECK
+HAPSessionRef* HAPAccessoryServerGetBLESession(const HAPAccessoryServerRef* server, size_t sessionIndex);
+
+/**
+ * Searches for a BLE session corresponding to a given HAP session and returns the session index.
+ *
+ * @param      server               Accessory server.
+ * @param      session              The session to search for.
+ * @param[out] sessionIndex         The index of the BLE session, if found.
+ *
+ * @return true                     If the session is a BLE session of the accessory server.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPAccessoryServerGetBLESessionIndex(
+        const HAPAccessoryServerRef* server,
+        const HAPSessionRef* session,
+        size_t* sessionIndex);
+
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
 #endif
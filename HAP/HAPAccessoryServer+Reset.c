@@ -61,7 +61,7 @@ HAPError HAPHandleFirmwareUpdate(HAPAccessoryServerRef* server_) {
     // Table 6-7 _hap._tcp Bonjour TXT Record Keys
     // See HomeKit Accessory Protocol Specification R14
     // Section 7.4.2.1.2 Manufacturer Data
-    err = HAPAccessoryServerIncrementCN(keyValueStore);
+    err = HAPAccessoryServerIncrementCN(server_);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -83,7 +83,7 @@ HAPError HAPHandleFirmwareUpdate(HAPAccessoryServerRef* server_) {
     // See HomeKit Accessory Protocol Specification R14
     // Section 7.4.7.4 Broadcast Encryption Key expiration and refresh
     if (server->transports.ble) {
-        err = HAPNonnull(server->transports.ble)->broadcast.expireKey(keyValueStore);
+        err = HAPNonnull(server->transports.ble)->broadcast.expireKey(server_);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
@@ -22,6 +22,8 @@ static void CompleteShutdown(HAPAccessoryServerRef* server_) {
     HAPAccessorySetupInfoHandleAccessoryServerStop(server_);
 
     // Reset state.
+    HAPAttributeDatabaseRelease(server_);
+    HAPCharacteristicValueCacheInvalidateAll(server_);
     server->primaryAccessory = NULL;
     server->ip.bridgedAccessories = NULL;
 
@@ -148,6 +150,15 @@ void HAPAccessoryServerCreate(
     // Copy generic options.
     HAPPrecondition(options->maxPairings >= kHAPPairingStorage_MinElements);
     server->maxPairings = options->maxPairings;
+    HAPPrecondition(options->attributeDatabase.elements || !options->attributeDatabase.numElements);
+    server->attributeDatabase.elements = options->attributeDatabase.elements;
+    server->attributeDatabase.numElements = options->attributeDatabase.numElements;
+    HAPPrecondition(options->valueCache.elements || !options->valueCache.numElements);
+    HAPPrecondition(options->valueCache.numElements <= UINT16_MAX);
+    server->valueCache.elements = options->valueCache.elements;
+    server->valueCache.numElements = options->valueCache.numElements;
+    server->valueCache.ttl = options->valueCache.ttl;
+    HAPCharacteristicValueCacheInvalidateAll(server_);
 
     // Copy platform.
     HAPAssert(sizeof *platform == sizeof server->platform);
@@ -284,10 +295,11 @@ void HAPAccessoryServerRelease(HAPAccessoryServerRef* server_) {
 
     HAPMFiHWAuthRelease(&server->mfi);
 
+    const HAPIPAccessoryServerTransport* _Nullable ipTransport = server->transports.ip;
     HAPRawBufferZero(server_, sizeof *server_);
 
-    if (server->transports.ip) {
-        HAPNonnull(server->transports.ip)->serverEngine.uninstall();
+    if (ipTransport) {
+        HAPNonnull(ipTransport)->serverEngine.uninstall();
     }
 }
 
@@ -307,6 +319,16 @@ HAPAccessoryServerState HAPAccessoryServerGetState(HAPAccessoryServerRef* server
     return server->state;
 }
 
+void HAPAccessoryServerGetCharacteristicValueCacheStatistics(
+        HAPAccessoryServerRef* server_,
+        HAPCharacteristicValueCacheStatistics* statistics) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(statistics);
+
+    *statistics = server->valueCache.statistics;
+}
+
 HAP_RESULT_USE_CHECK
 void* _Nullable HAPAccessoryServerGetClientContext(HAPAccessoryServerRef* server_) {
     HAPPrecondition(server_);
@@ -599,6 +621,18 @@ static void HAPAccessoryServerPrepareStart(
     server->primaryAccessory = primaryAccessory;
     server->ip.bridgedAccessories = bridgedAccessories;
 
+    // Flatten attribute database. Cached values are hashed by characteristic record.
+    HAPAttributeDatabaseCreate(server_);
+    HAPCharacteristicValueCacheInvalidateAll(server_);
+
+    // Load configuration number.
+    err = HAPAccessoryServerGetCN(server->platform.keyValueStore, &server->configurationNumber);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPLogError(&logObject, "Loading configuration number failed.");
+        HAPFatalError();
+    }
+
     // Load LTSK.
     HAPLogDebug(&logObject, "Loading accessory identity.");
     HAPAccessoryServerLoadLTSK(server->platform.keyValueStore, &server->identity.ed_LTSK);
@@ -690,7 +724,7 @@ void HAPAccessoryServerStartBridge(
     // Increment configuration number if necessary.
     if (configurationChanged) {
         HAPLogInfo(&logObject, "Configuration changed. Incrementing CN.");
-        err = HAPAccessoryServerIncrementCN(server->platform.keyValueStore);
+        err = HAPAccessoryServerIncrementCN(server_);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             HAPFatalError();
@@ -1021,18 +1055,20 @@ HAPError HAPAccessoryServerCleanupPairings(HAPAccessoryServerRef* server_) {
 
         // Purge Pair Resume cache.
         if (server->transports.ble) {
-            HAPRawBufferZero(
-                    server->ble.storage->sessionCacheElements,
-                    server->ble.storage->numSessionCacheElements * sizeof *server->ble.storage->sessionCacheElements);
+            HAPPairingBLESessionCacheInvalidateAllEntries(server_);
         }
 
         // Purge broadcast encryption key and advertising identifier.
         // See HomeKit Certification Test Cases R7.2
         // Test Case TCB052
-        err = HAPPlatformKeyValueStoreRemove(
-                server->platform.keyValueStore,
-                kHAPKeyValueStoreDomain_Configuration,
-                kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters);
+        if (server->transports.ble) {
+            err = HAPNonnull(server->transports.ble)->broadcast.purgeParameters(server_);
+        } else {
+            err = HAPPlatformKeyValueStoreRemove(
+                    server->platform.keyValueStore,
+                    kHAPKeyValueStoreDomain_Configuration,
+                    kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters);
+        }
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
@@ -1105,8 +1141,10 @@ HAPError HAPAccessoryServerGetCN(HAPPlatformKeyValueStoreRef keyValueStore, uint
 }
 
 HAP_RESULT_USE_CHECK
-HAPError HAPAccessoryServerIncrementCN(HAPPlatformKeyValueStoreRef keyValueStore) {
-    HAPPrecondition(keyValueStore);
+HAPError HAPAccessoryServerIncrementCN(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPlatformKeyValueStoreRef keyValueStore = server->platform.keyValueStore;
 
     HAPError err;
 
@@ -1155,6 +1193,12 @@ HAPError HAPAccessoryServerIncrementCN(HAPPlatformKeyValueStoreRef keyValueStore
         return err;
     }
 
+    // Update in-memory CN. Downscale to UInt16 as in HAPAccessoryServerGetCN.
+    server->configurationNumber = (uint16_t)((HAPReadLittleUInt32(cnBytes) - 1) % UINT16_MAX + 1);
+    if (server->state == kHAPAccessoryServerState_Running) {
+        HAPAccessoryServerUpdateAdvertisingData(server_);
+    }
+
     return kHAPError_None;
 }
 
@@ -1172,6 +1216,7 @@ void HAPAccessoryServerRaiseEvent(
     HAPError err;
 
     HAPLogCharacteristicDebug(&logObject, characteristic, service, accessory, "Marking characteristic as modified.");
+    HAPCharacteristicValueCacheInvalidate(server_, characteristic, service, accessory);
 
     if (server->transports.ble) {
         err = HAPNonnull(server->transports.ble)->didRaiseEvent(server_, characteristic, service, accessory, NULL);
@@ -1208,6 +1253,8 @@ void HAPAccessoryServerRaiseEventOnSession(
 
     HAPError err;
 
+    HAPCharacteristicValueCacheInvalidate(server_, characteristic, service, accessory);
+
     if (server->transports.ble) {
         err = HAPNonnull(server->transports.ble)->didRaiseEvent(server_, characteristic, service, accessory, session);
         if (err) {
@@ -1228,6 +1275,49 @@ void HAPAccessoryServerRaiseEventOnSession(
     }
 }
 
+void HAPAccessoryServerCompleteRead(
+        HAPAccessoryServerRef* server_,
+        HAPCompletionToken completionToken,
+        HAPError error,
+        const void* _Nullable valueBytes,
+        size_t numValueBytes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(completionToken != kHAPCompletionToken_None);
+    HAPPrecondition(
+            !error || error == kHAPError_Unknown || error == kHAPError_InvalidState ||
+            error == kHAPError_OutOfResources || error == kHAPError_Busy);
+    HAPPrecondition(error || valueBytes || !numValueBytes);
+
+    // Completion tokens are only assigned to requests over IP.
+    const HAPAccessoryServerServerEngine* _Nullable serverEngine =
+            server->transports.ip ? HAPNonnull(server->transports.ip)->serverEngine.get() : NULL;
+    if (!serverEngine || !serverEngine->complete_read) {
+        HAPLog(&logObject, "Ignoring read completion %lu: No pending IP request.", (unsigned long) completionToken);
+        return;
+    }
+    serverEngine->complete_read(server_, completionToken, error, valueBytes, numValueBytes);
+}
+
+void HAPAccessoryServerCompleteWrite(
+        HAPAccessoryServerRef* server_,
+        HAPCompletionToken completionToken,
+        HAPError error) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(completionToken != kHAPCompletionToken_None);
+    HAPPrecondition(error != kHAPError_InProgress);
+
+    // Completion tokens are only assigned to requests over IP.
+    const HAPAccessoryServerServerEngine* _Nullable serverEngine =
+            server->transports.ip ? HAPNonnull(server->transports.ip)->serverEngine.get() : NULL;
+    if (!serverEngine || !serverEngine->complete_write) {
+        HAPLog(&logObject, "Ignoring write completion %lu: No pending IP request.", (unsigned long) completionToken);
+        return;
+    }
+    serverEngine->complete_write(server_, completionToken, error);
+}
+
 void HAPAccessoryServerHandleSubscribe(
         HAPAccessoryServerRef* server,
         HAPSessionRef* session_,
@@ -1524,6 +1614,10 @@ size_t HAPAccessoryServerGetNumServiceInstances(HAPAccessoryServerRef* server_,
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(serviceType);
 
+    if (HAPAttributeDatabaseIsFlattened(server_)) {
+        return HAPAttributeDatabaseGetNumServiceInstances(server_, serviceType);
+    }
+
     HAPServiceTypeIndex serviceTypeIndex = 0;
 
     HAPPrecondition(server->primaryAccessory);
@@ -1567,6 +1661,10 @@ HAPServiceTypeIndex HAPAccessoryServerGetServiceTypeIndex(
     HAPPrecondition(service);
     HAPPrecondition(accessory);
 
+    if (HAPAttributeDatabaseIsFlattened(server_)) {
+        return HAPAttributeDatabaseGetServiceTypeIndex(server_, service, accessory);
+    }
+
     HAPServiceTypeIndex serviceTypeIndex = 0;
 
     HAPPrecondition(server->primaryAccessory);
@@ -1619,6 +1717,15 @@ void HAPAccessoryServerGetServiceFromServiceTypeIndex(
     HAPPrecondition(service);
     HAPPrecondition(accessory);
 
+    if (HAPAttributeDatabaseIsFlattened(server_)) {
+        if (HAPAttributeDatabaseGetServiceFromServiceTypeIndex(
+                    server_, serviceType, serviceTypeIndex, service, accessory)) {
+            return;
+        }
+        HAPLogError(&logObject, "Service type index not found in accessory server's attribute database.");
+        HAPFatalError();
+    }
+
     HAPPrecondition(server->primaryAccessory);
     {
         const HAPAccessory* acc = server->primaryAccessory;
@@ -1672,27 +1779,18 @@ void HAPAccessoryServerEnumerateConnectedSessions(
     bool shouldContinue = true;
 
     if (server->transports.ble && server->ble.storage) {
-        if (server->ble.storage->session && server->ble.connection.connected) {
-            callback(context, server_, HAPNonnull(server->ble.storage->session), &shouldContinue);
-        }
-        if (!shouldContinue) {
-            return;
+        for (size_t i = 0; i < server->ble.numSessions; i++) {
+            if (server->ble.connections[i].connected) {
+                callback(context, server_, &server->ble.storage->session[i], &shouldContinue);
+            }
+            if (!shouldContinue) {
+                return;
+            }
         }
     }
 
     if (server->transports.ip && server->ip.storage) {
-        for (size_t i = 0; shouldContinue && i < server->ip.storage->numSessions; i++) {
-            HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-            HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-            if (!session->server) {
-                continue;
-            }
-            HAPAssert(session->server == server_);
-            if (session->securitySession.type != kHAPIPSecuritySessionType_HAP) {
-                continue;
-            }
-            callback(context, server_, &session->securitySession._.hap, &shouldContinue);
-        }
+        HAPAccessoryServerEnumerateIPSessions(server_, callback, context, &shouldContinue);
         if (!shouldContinue) {
             return;
         }
@@ -0,0 +1,812 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "AttributeDatabase" };
+
+/**
+ * Characteristic record flags.
+ */
+HAP_ENUM_BEGIN(uint16_t, HAPAttributeDatabaseCharacteristicFlags) {
+    /** Characteristic is readable. */
+    kHAPAttributeDatabaseCharacteristicFlags_Readable = 1U << 0U,
+
+    /** Characteristic is writable. */
+    kHAPAttributeDatabaseCharacteristicFlags_Writable = 1U << 1U,
+
+    /** Characteristic supports event notifications. */
+    kHAPAttributeDatabaseCharacteristicFlags_SupportsEventNotification = 1U << 2U,
+
+    /** Characteristic is hidden. */
+    kHAPAttributeDatabaseCharacteristicFlags_Hidden = 1U << 3U,
+
+    /** Reading the characteristic requires admin permissions. */
+    kHAPAttributeDatabaseCharacteristicFlags_ReadRequiresAdminPermissions = 1U << 4U,
+
+    /** Writing the characteristic requires admin permissions. */
+    kHAPAttributeDatabaseCharacteristicFlags_WriteRequiresAdminPermissions = 1U << 5U,
+
+    /** Characteristic requires timed writes. */
+    kHAPAttributeDatabaseCharacteristicFlags_RequiresTimedWrite = 1U << 6U,
+
+    /** Characteristic supports additional authorization data. */
+    kHAPAttributeDatabaseCharacteristicFlags_SupportsAuthorizationData = 1U << 7U,
+
+    /** Characteristic is a control point (IP). */
+    kHAPAttributeDatabaseCharacteristicFlags_IPControlPoint = 1U << 8U,
+
+    /** Characteristic supports write response (IP). */
+    kHAPAttributeDatabaseCharacteristicFlags_IPSupportsWriteResponse = 1U << 9U,
+
+    /** Characteristic and its service are supported over HAP over IP. */
+    kHAPAttributeDatabaseCharacteristicFlags_SupportedOverIP = 1U << 10U
+} HAP_ENUM_END(uint16_t, HAPAttributeDatabaseCharacteristicFlags);
+
+/**
+ * Accessory record.
+ */
+typedef struct {
+    /** Accessory. */
+    const HAPAccessory* accessory;
+
+    /** Accessory instance ID. */
+    uint64_t aid;
+
+    /** Index of the first service record of the accessory. */
+    uint16_t firstService;
+
+    /** Number of service records of the accessory. */
+    uint16_t numServices;
+
+    /** Index of the first characteristic record of the accessory. */
+    uint16_t firstCharacteristic;
+
+    /** Number of characteristic records of the accessory. */
+    uint16_t numCharacteristics;
+
+    /** Whether the characteristic records of the accessory are sorted by instance ID. */
+    bool characteristicsAreSortedByIID : 1;
+} HAPAttributeDatabaseAccessory;
+
+/**
+ * Service record.
+ */
+typedef struct {
+    /** Service. */
+    const HAPService* service;
+
+    /** Instance ID. */
+    uint64_t iid;
+
+    /** Index of the accessory record of the accessory that provides the service. */
+    uint16_t accessoryIndex;
+
+    /** Type index. Index of the first service record with the same service type. */
+    uint16_t typeIndex;
+
+    /** Interned service type. */
+    HAPTypeID typeID;
+
+    /** Index of the service among all services of the same type. */
+    HAPServiceTypeIndex typeInstanceIndex;
+
+    /** Number of services of the same type. Only valid for the first service record with a given service type. */
+    uint16_t numTypeInstances;
+
+    /** First service type record in the bucket of this record (index + 1). 0 if the bucket is empty. */
+    uint16_t typeBucket;
+
+    /** Next service type record in the same bucket (index + 1). Only valid for service type records. */
+    uint16_t nextTypeRecord;
+} HAPAttributeDatabaseService;
+
+/**
+ * Characteristic record.
+ *
+ * - The characteristic is kept as a reference to its format-specific structure, which holds its callbacks.
+ */
+typedef struct {
+    /** Characteristic. */
+    const HAPCharacteristic* characteristic;
+
+    /** Instance ID. */
+    uint64_t iid;
+
+    /** Index of the service record of the service that contains the characteristic. */
+    uint16_t serviceIndex;
+
+    /** Interned characteristic type. */
+    HAPTypeID typeID;
+
+    /** Flags. */
+    HAPAttributeDatabaseCharacteristicFlags flags;
+
+    /** First vendor-specific characteristic type record in the bucket of this record (index + 1). 0 if empty. */
+    uint16_t typeBucket;
+
+    /** Next vendor-specific characteristic type record in the same bucket (index + 1). */
+    uint16_t nextTypeRecord;
+
+    /** Format. */
+    HAPCharacteristicFormat format;
+} HAPAttributeDatabaseCharacteristic;
+
+/**
+ * Flattened attribute database element.
+ *
+ * - Elements hold the accessory records, followed by the service records, followed by the characteristic records.
+ *   Records are in the order of the accessory, service and characteristic lists.
+ *
+ * - The first record of each service type and of each vendor-specific characteristic type is a type record.
+ *   Type records are interned in a hash table with one bucket per service or characteristic record.
+ *   Each record stores the head of its bucket.
+ */
+typedef union {
+    HAPAttributeDatabaseAccessory accessory;
+    HAPAttributeDatabaseService service;
+    HAPAttributeDatabaseCharacteristic characteristic;
+} HAPAttributeDatabaseElement;
+HAP_STATIC_ASSERT(
+        sizeof(HAPAttributeDatabaseElementRef) >= sizeof(HAPAttributeDatabaseElement),
+        HAPAttributeDatabaseElement);
+
+HAP_RESULT_USE_CHECK
+static HAPAttributeDatabaseAccessory* GetAccessoryRecord(HAPAccessoryServer* server, size_t index) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->attributeDatabase.elements);
+    HAPPrecondition(index < server->attributeDatabase.numAccessories);
+
+    HAPAttributeDatabaseElement* elements = (HAPAttributeDatabaseElement*) server->attributeDatabase.elements;
+    return &elements[index].accessory;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPAttributeDatabaseService* GetServiceRecord(HAPAccessoryServer* server, size_t index) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->attributeDatabase.elements);
+    HAPPrecondition(index < server->attributeDatabase.numServices);
+
+    HAPAttributeDatabaseElement* elements = (HAPAttributeDatabaseElement*) server->attributeDatabase.elements;
+    return &elements[server->attributeDatabase.numAccessories + index].service;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPAttributeDatabaseCharacteristic* GetCharacteristicRecord(HAPAccessoryServer* server, size_t index) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->attributeDatabase.elements);
+    HAPPrecondition(index < server->attributeDatabase.numCharacteristics);
+
+    HAPAttributeDatabaseElement* elements = (HAPAttributeDatabaseElement*) server->attributeDatabase.elements;
+    return &elements[server->attributeDatabase.numAccessories + server->attributeDatabase.numServices + index]
+                    .characteristic;
+}
+
+/**
+ * Gets a registered accessory by index.
+ *
+ * @param      server               Accessory server.
+ * @param      index                Index of the accessory. 0 for the primary accessory.
+ *                                  Must not exceed the number of bridged accessories.
+ *
+ * @return Accessory, if the index is in range. NULL if the index refers to the end of the list.
+ */
+HAP_RESULT_USE_CHECK
+static const HAPAccessory* _Nullable GetRegisteredAccessory(HAPAccessoryServer* server, size_t index) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->primaryAccessory);
+
+    if (!index) {
+        return server->primaryAccessory;
+    }
+    return server->ip.bridgedAccessories ? server->ip.bridgedAccessories[index - 1] : NULL;
+}
+
+/**
+ * Packs the properties of a characteristic into characteristic record flags.
+ */
+HAP_RESULT_USE_CHECK
+static HAPAttributeDatabaseCharacteristicFlags
+        GetCharacteristicFlags(const HAPBaseCharacteristic* characteristic, bool isSupportedOverIP) {
+    HAPPrecondition(characteristic);
+
+    HAPAttributeDatabaseCharacteristicFlags flags = 0;
+    if (characteristic->properties.readable) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_Readable;
+    }
+    if (characteristic->properties.writable) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_Writable;
+    }
+    if (characteristic->properties.supportsEventNotification) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_SupportsEventNotification;
+    }
+    if (characteristic->properties.hidden) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_Hidden;
+    }
+    if (HAPCharacteristicReadRequiresAdminPermissions(characteristic)) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_ReadRequiresAdminPermissions;
+    }
+    if (HAPCharacteristicWriteRequiresAdminPermissions(characteristic)) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_WriteRequiresAdminPermissions;
+    }
+    if (characteristic->properties.requiresTimedWrite) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_RequiresTimedWrite;
+    }
+    if (characteristic->properties.supportsAuthorizationData) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_SupportsAuthorizationData;
+    }
+    if (characteristic->properties.ip.controlPoint) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_IPControlPoint;
+    }
+    if (characteristic->properties.ip.supportsWriteResponse) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_IPSupportsWriteResponse;
+    }
+    if (isSupportedOverIP) {
+        flags |= kHAPAttributeDatabaseCharacteristicFlags_SupportedOverIP;
+    }
+    return flags;
+}
+
+HAP_RESULT_USE_CHECK
+HAPTypeID HAPAttributeDatabaseGetTypeID(const HAPUUID* type) {
+    HAPPrecondition(type);
+
+    if (!HAPUUIDIsAppleDefined(type)) {
+        return kHAPTypeID_Vendor;
+    }
+    HAPTypeID typeID = HAPReadLittleUInt32(&type->bytes[12]);
+    if (typeID & kHAPTypeID_Vendor) {
+        return kHAPTypeID_Vendor;
+    }
+    return typeID;
+}
+
+/**
+ * Checks whether a type matches the type of an already interned record.
+ *
+ * @param      typeID               Type ID of the type as returned by HAPAttributeDatabaseGetTypeID.
+ * @param      type                 Type.
+ * @param      otherTypeID          Interned type ID of the record.
+ * @param      otherType            Type of the record.
+ *
+ * @return true                     If the types are equal.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool TypeMatches(HAPTypeID typeID, const HAPUUID* type, HAPTypeID otherTypeID, const HAPUUID* otherType) {
+    HAPPrecondition(type);
+    HAPPrecondition(otherType);
+
+    if (typeID != kHAPTypeID_Vendor) {
+        return typeID == otherTypeID;
+    }
+    return (otherTypeID & kHAPTypeID_Vendor) && HAPUUIDAreEqual(type, otherType);
+}
+
+/**
+ * Computes the bucket of a type.
+ *
+ * @param      typeID               Type ID of the type as returned by HAPAttributeDatabaseGetTypeID.
+ * @param      type                 Type.
+ * @param      numBuckets           Number of buckets.
+ *
+ * @return Index of the record that holds the bucket.
+ */
+HAP_RESULT_USE_CHECK
+static size_t GetTypeBucketIndex(HAPTypeID typeID, const HAPUUID* type, size_t numBuckets) {
+    HAPPrecondition(type);
+    HAPPrecondition(numBuckets);
+
+    uint64_t key = typeID;
+    if (typeID == kHAPTypeID_Vendor) {
+        key = HAPReadLittleUInt64(&type->bytes[0]) ^ HAPReadLittleUInt64(&type->bytes[8]);
+    }
+
+    // Multiplicative hashing still spreads consecutive type IDs and vendor types that share most of their bytes.
+    uint64_t hash = key * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t)((hash >> 32) % numBuckets);
+}
+
+/**
+ * Finds the service type record of a service type.
+ *
+ * @param      server               Accessory server.
+ * @param      serviceType          Service type.
+ *
+ * @return Service type record, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPAttributeDatabaseService* _Nullable
+        FindServiceTypeRecord(HAPAccessoryServer* server, const HAPUUID* serviceType) {
+    HAPPrecondition(server);
+    HAPPrecondition(serviceType);
+
+    HAPTypeID typeID = HAPAttributeDatabaseGetTypeID(serviceType);
+    size_t bucketIndex = GetTypeBucketIndex(typeID, serviceType, server->attributeDatabase.numServices);
+    for (uint16_t link = GetServiceRecord(server, bucketIndex)->typeBucket; link;) {
+        HAPAttributeDatabaseService* typeRecord = GetServiceRecord(server, (size_t)(link - 1));
+        if (TypeMatches(typeID, serviceType, typeRecord->typeID, typeRecord->service->serviceType)) {
+            return typeRecord;
+        }
+        link = typeRecord->nextTypeRecord;
+    }
+    return NULL;
+}
+
+/**
+ * Finds the characteristic type record of a vendor-specific characteristic type.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristicType   Vendor-specific characteristic type.
+ *
+ * @return Characteristic type record, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static const HAPAttributeDatabaseCharacteristic* _Nullable
+        FindVendorCharacteristicTypeRecord(HAPAccessoryServer* server, const HAPUUID* characteristicType) {
+    HAPPrecondition(server);
+    HAPPrecondition(characteristicType);
+    HAPPrecondition(HAPAttributeDatabaseGetTypeID(characteristicType) == kHAPTypeID_Vendor);
+
+    size_t bucketIndex =
+            GetTypeBucketIndex(kHAPTypeID_Vendor, characteristicType, server->attributeDatabase.numCharacteristics);
+    for (uint16_t link = GetCharacteristicRecord(server, bucketIndex)->typeBucket; link;) {
+        const HAPAttributeDatabaseCharacteristic* typeRecord = GetCharacteristicRecord(server, (size_t)(link - 1));
+        if (HAPUUIDAreEqual(
+                    ((const HAPBaseCharacteristic*) typeRecord->characteristic)->characteristicType,
+                    characteristicType)) {
+            return typeRecord;
+        }
+        link = typeRecord->nextTypeRecord;
+    }
+    return NULL;
+}
+
+void HAPAttributeDatabaseCreate(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->primaryAccessory);
+
+    HAPAttributeDatabaseRelease(server_);
+    if (!server->attributeDatabase.elements) {
+        return;
+    }
+
+    // Count records.
+    size_t numAccessories = 0;
+    size_t numServices = 0;
+    size_t numCharacteristics = 0;
+    for (const HAPAccessory* _Nullable accessory = GetRegisteredAccessory(server, 0); accessory;
+         accessory = GetRegisteredAccessory(server, numAccessories)) {
+        numAccessories++;
+        for (size_t i = 0; accessory->services && accessory->services[i]; i++) {
+            const HAPService* service = accessory->services[i];
+            numServices++;
+            for (size_t j = 0; service->characteristics && service->characteristics[j]; j++) {
+                numCharacteristics++;
+            }
+        }
+    }
+    size_t numElements = numAccessories + numServices + numCharacteristics;
+    if (numElements > server->attributeDatabase.numElements || numServices > UINT16_MAX ||
+        numCharacteristics > UINT16_MAX) {
+        HAPLog(&logObject,
+               "Flattened attribute database storage too small (%zu elements needed, %zu available). "
+               "Attribute database is not flattened.",
+               numElements,
+               server->attributeDatabase.numElements);
+        return;
+    }
+    server->attributeDatabase.numAccessories = (uint16_t) numAccessories;
+    server->attributeDatabase.numServices = (uint16_t) numServices;
+    server->attributeDatabase.numCharacteristics = (uint16_t) numCharacteristics;
+    server->attributeDatabase.accessoriesAreSortedByAID = true;
+    HAPRawBufferZero(server->attributeDatabase.elements, numElements * sizeof *server->attributeDatabase.elements);
+
+    // Fill records. Records are zeroed up front as bucket heads are stored in records that are filled later.
+    size_t serviceIndex = 0;
+    size_t characteristicIndex = 0;
+    for (size_t accessoryIndex = 0; accessoryIndex < numAccessories; accessoryIndex++) {
+        const HAPAccessory* accessory = HAPNonnull(GetRegisteredAccessory(server, accessoryIndex));
+        HAPAttributeDatabaseAccessory* accessoryRecord = GetAccessoryRecord(server, accessoryIndex);
+        accessoryRecord->accessory = accessory;
+        accessoryRecord->aid = accessory->aid;
+        accessoryRecord->firstService = (uint16_t) serviceIndex;
+        accessoryRecord->firstCharacteristic = (uint16_t) characteristicIndex;
+        accessoryRecord->characteristicsAreSortedByIID = true;
+        if (accessoryIndex && GetAccessoryRecord(server, accessoryIndex - 1)->aid >= accessory->aid) {
+            server->attributeDatabase.accessoriesAreSortedByAID = false;
+        }
+
+        for (size_t i = 0; accessory->services && accessory->services[i]; i++) {
+            const HAPService* service = accessory->services[i];
+            HAPAttributeDatabaseService* serviceRecord = GetServiceRecord(server, serviceIndex);
+            serviceRecord->service = service;
+            serviceRecord->iid = service->iid;
+            serviceRecord->accessoryIndex = (uint16_t) accessoryIndex;
+
+            // Find service type record, or make this the service type record.
+            HAPAttributeDatabaseService* _Nullable typeRecord = FindServiceTypeRecord(server, service->serviceType);
+            if (typeRecord) {
+                serviceRecord->typeIndex = typeRecord->typeIndex;
+                serviceRecord->typeID = typeRecord->typeID;
+            } else {
+                typeRecord = serviceRecord;
+                serviceRecord->typeIndex = (uint16_t) serviceIndex;
+
+                // Intern vendor-specific service type by the index of its service type record.
+                HAPTypeID typeID = HAPAttributeDatabaseGetTypeID(service->serviceType);
+                serviceRecord->typeID = typeID;
+                if (typeID == kHAPTypeID_Vendor) {
+                    serviceRecord->typeID |= (HAPTypeID) serviceIndex;
+                }
+
+                // Link into bucket.
+                HAPAttributeDatabaseService* bucketRecord =
+                        GetServiceRecord(server, GetTypeBucketIndex(typeID, service->serviceType, numServices));
+                serviceRecord->nextTypeRecord = bucketRecord->typeBucket;
+                bucketRecord->typeBucket = (uint16_t)(serviceIndex + 1);
+            }
+            serviceRecord->typeInstanceIndex = HAPNonnull(typeRecord)->numTypeInstances++;
+            HAPAssert(HAPNonnull(typeRecord)->numTypeInstances); // No overflow.
+            bool isServiceSupportedOverIP = HAPAccessoryServerSupportsService(server_, kHAPTransportType_IP, service);
+
+            for (size_t j = 0; service->characteristics && service->characteristics[j]; j++) {
+                const HAPBaseCharacteristic* characteristic = service->characteristics[j];
+                HAPAttributeDatabaseCharacteristic* characteristicRecord =
+                        GetCharacteristicRecord(server, characteristicIndex);
+                characteristicRecord->characteristic = characteristic;
+                characteristicRecord->iid = characteristic->iid;
+                characteristicRecord->serviceIndex = (uint16_t) serviceIndex;
+                characteristicRecord->format = characteristic->format;
+                characteristicRecord->flags = GetCharacteristicFlags(
+                        characteristic, isServiceSupportedOverIP && HAPIPCharacteristicIsSupported(characteristic));
+                if (accessoryRecord->numCharacteristics &&
+                    GetCharacteristicRecord(server, characteristicIndex - 1)->iid >= characteristic->iid) {
+                    accessoryRecord->characteristicsAreSortedByIID = false;
+                }
+
+                // Intern vendor-specific characteristic type by the index of its characteristic type record.
+                characteristicRecord->typeID = HAPAttributeDatabaseGetTypeID(characteristic->characteristicType);
+                if (characteristicRecord->typeID == kHAPTypeID_Vendor) {
+                    const HAPAttributeDatabaseCharacteristic* _Nullable typeRecord =
+                            FindVendorCharacteristicTypeRecord(server, characteristic->characteristicType);
+                    if (typeRecord) {
+                        characteristicRecord->typeID = typeRecord->typeID;
+                    } else {
+                        characteristicRecord->typeID |= (HAPTypeID) characteristicIndex;
+
+                        // Link into bucket.
+                        HAPAttributeDatabaseCharacteristic* bucketRecord = GetCharacteristicRecord(
+                                server,
+                                GetTypeBucketIndex(
+                                        kHAPTypeID_Vendor, characteristic->characteristicType, numCharacteristics));
+                        characteristicRecord->nextTypeRecord = bucketRecord->typeBucket;
+                        bucketRecord->typeBucket = (uint16_t)(characteristicIndex + 1);
+                    }
+                }
+
+                accessoryRecord->numCharacteristics++;
+                characteristicIndex++;
+            }
+
+            accessoryRecord->numServices++;
+            serviceIndex++;
+        }
+    }
+    HAPAssert(serviceIndex == numServices);
+    HAPAssert(characteristicIndex == numCharacteristics);
+
+    HAPLogInfo(
+            &logObject,
+            "Flattened attribute database: %zu accessories, %zu services, %zu characteristics (%zu bytes).",
+            numAccessories,
+            numServices,
+            numCharacteristics,
+            numElements * sizeof(HAPAttributeDatabaseElementRef));
+}
+
+void HAPAttributeDatabaseRelease(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    server->attributeDatabase.numAccessories = 0;
+    server->attributeDatabase.numServices = 0;
+    server->attributeDatabase.numCharacteristics = 0;
+    server->attributeDatabase.accessoriesAreSortedByAID = false;
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPAttributeDatabaseIsFlattened(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    return server->attributeDatabase.numAccessories != 0;
+}
+
+/**
+ * Finds the accessory record of an accessory by accessory instance ID.
+ *
+ * @param      server               Accessory server.
+ * @param      aid                  Accessory instance ID.
+ *
+ * @return Accessory record, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static const HAPAttributeDatabaseAccessory* _Nullable FindAccessoryRecord(HAPAccessoryServer* server, uint64_t aid) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->attributeDatabase.numAccessories);
+
+    if (server->attributeDatabase.accessoriesAreSortedByAID) {
+        size_t lowerBound = 0;
+        size_t upperBound = server->attributeDatabase.numAccessories;
+        while (lowerBound < upperBound) {
+            size_t index = lowerBound + (upperBound - lowerBound) / 2;
+            const HAPAttributeDatabaseAccessory* accessoryRecord = GetAccessoryRecord(server, index);
+            if (accessoryRecord->aid == aid) {
+                return accessoryRecord;
+            }
+            if (accessoryRecord->aid < aid) {
+                lowerBound = index + 1;
+            } else {
+                upperBound = index;
+            }
+        }
+        return NULL;
+    }
+
+    for (size_t i = 0; i < server->attributeDatabase.numAccessories; i++) {
+        const HAPAttributeDatabaseAccessory* accessoryRecord = GetAccessoryRecord(server, i);
+        if (accessoryRecord->aid == aid) {
+            return accessoryRecord;
+        }
+    }
+    return NULL;
+}
+
+HAP_RESULT_USE_CHECK
+const HAPAccessory* _Nullable HAPAttributeDatabaseFindAccessory(HAPAccessoryServerRef* server_, uint64_t aid) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(HAPAttributeDatabaseIsFlattened(server_));
+
+    const HAPAttributeDatabaseAccessory* _Nullable accessoryRecord = FindAccessoryRecord(server, aid);
+    return accessoryRecord ? accessoryRecord->accessory : NULL;
+}
+
+/**
+ * Finds the characteristic record of an accessory by instance ID.
+ *
+ * @param      server               Accessory server.
+ * @param      accessoryRecord      Accessory record.
+ * @param      iid                  Characteristic instance ID.
+ * @param[out] characteristicIndex  Index of the characteristic record, if found.
+ *
+ * @return true                     If the characteristic record was found.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool FindCharacteristicRecordIndex(
+        HAPAccessoryServer* server,
+        const HAPAttributeDatabaseAccessory* accessoryRecord,
+        uint64_t iid,
+        size_t* characteristicIndex) {
+    HAPPrecondition(server);
+    HAPPrecondition(accessoryRecord);
+    HAPPrecondition(characteristicIndex);
+
+    if (accessoryRecord->characteristicsAreSortedByIID) {
+        size_t lowerBound = accessoryRecord->firstCharacteristic;
+        size_t upperBound = lowerBound + accessoryRecord->numCharacteristics;
+        while (lowerBound < upperBound) {
+            size_t index = lowerBound + (upperBound - lowerBound) / 2;
+            const HAPAttributeDatabaseCharacteristic* record = GetCharacteristicRecord(server, index);
+            if (record->iid == iid) {
+                *characteristicIndex = index;
+                return true;
+            }
+            if (record->iid < iid) {
+                lowerBound = index + 1;
+            } else {
+                upperBound = index;
+            }
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < accessoryRecord->numCharacteristics; i++) {
+        size_t index = accessoryRecord->firstCharacteristic + i;
+        if (GetCharacteristicRecord(server, index)->iid == iid) {
+            *characteristicIndex = index;
+            return true;
+        }
+    }
+    return false;
+}
+
+void HAPAttributeDatabaseFindIPCharacteristic(
+        HAPAccessoryServerRef* server_,
+        uint64_t aid,
+        uint64_t iid,
+        const HAPCharacteristic* _Nullable* _Nonnull characteristic,
+        const HAPService* _Nullable* _Nonnull service,
+        const HAPAccessory* _Nullable* _Nonnull accessory,
+        HAPTypeID* _Nullable characteristicTypeID) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(HAPAttributeDatabaseIsFlattened(server_));
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+
+    *characteristic = NULL;
+    *service = NULL;
+    *accessory = NULL;
+
+    const HAPAttributeDatabaseAccessory* _Nullable accessoryRecord = FindAccessoryRecord(server, aid);
+    if (!accessoryRecord) {
+        return;
+    }
+
+    // Find characteristic record. Instance IDs are unique within an accessory.
+    size_t characteristicIndex;
+    if (!FindCharacteristicRecordIndex(server, accessoryRecord, iid, &characteristicIndex)) {
+        return;
+    }
+    const HAPAttributeDatabaseCharacteristic* characteristicRecord =
+            GetCharacteristicRecord(server, characteristicIndex);
+    if (!(characteristicRecord->flags & kHAPAttributeDatabaseCharacteristicFlags_SupportedOverIP)) {
+        return;
+    }
+
+    *characteristic = characteristicRecord->characteristic;
+    *service = GetServiceRecord(server, characteristicRecord->serviceIndex)->service;
+    *accessory = accessoryRecord->accessory;
+    if (characteristicTypeID) {
+        *characteristicTypeID = characteristicRecord->typeID;
+    }
+}
+
+HAP_RESULT_USE_CHECK
+size_t HAPAttributeDatabaseGetCharacteristicIndex(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(HAPAttributeDatabaseIsFlattened(server_));
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+
+    // Characteristics and services may be shared between accessories, so the record is matched by all three.
+    const HAPAttributeDatabaseAccessory* _Nullable accessoryRecord = FindAccessoryRecord(server, accessory->aid);
+    size_t index;
+    if (accessoryRecord && accessoryRecord->accessory == accessory &&
+        FindCharacteristicRecordIndex(
+                server, HAPNonnull(accessoryRecord), ((const HAPBaseCharacteristic*) characteristic)->iid, &index)) {
+        const HAPAttributeDatabaseCharacteristic* characteristicRecord = GetCharacteristicRecord(server, index);
+        if (characteristicRecord->characteristic == characteristic &&
+            GetServiceRecord(server, characteristicRecord->serviceIndex)->service == service) {
+            return index;
+        }
+    }
+
+    HAPLogCharacteristicError(
+            &logObject,
+            characteristic,
+            service,
+            accessory,
+            "Characteristic not found in accessory server's attribute database.");
+    HAPFatalError();
+}
+
+void HAPAttributeDatabaseGetCharacteristic(
+        HAPAccessoryServerRef* server_,
+        size_t characteristicIndex,
+        const HAPCharacteristic* _Nonnull* _Nonnull characteristic,
+        const HAPService* _Nonnull* _Nonnull service,
+        const HAPAccessory* _Nonnull* _Nonnull accessory,
+        HAPTypeID* _Nullable characteristicTypeID) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(HAPAttributeDatabaseIsFlattened(server_));
+    HAPPrecondition(characteristicIndex < server->attributeDatabase.numCharacteristics);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+
+    const HAPAttributeDatabaseCharacteristic* characteristicRecord =
+            GetCharacteristicRecord(server, characteristicIndex);
+    const HAPAttributeDatabaseService* serviceRecord = GetServiceRecord(server, characteristicRecord->serviceIndex);
+    *characteristic = characteristicRecord->characteristic;
+    *service = serviceRecord->service;
+    *accessory = GetAccessoryRecord(server, serviceRecord->accessoryIndex)->accessory;
+    if (characteristicTypeID) {
+        *characteristicTypeID = characteristicRecord->typeID;
+    }
+}
+
+HAP_RESULT_USE_CHECK
+size_t HAPAttributeDatabaseGetCharacteristicServiceIndex(HAPAccessoryServerRef* server_, size_t characteristicIndex) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(HAPAttributeDatabaseIsFlattened(server_));
+    HAPPrecondition(characteristicIndex < server->attributeDatabase.numCharacteristics);
+
+    return GetCharacteristicRecord(server, characteristicIndex)->serviceIndex;
+}
+
+HAP_RESULT_USE_CHECK
+size_t HAPAttributeDatabaseGetNumServiceInstances(HAPAccessoryServerRef* server_, const HAPUUID* serviceType) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(HAPAttributeDatabaseIsFlattened(server_));
+    HAPPrecondition(serviceType);
+
+    const HAPAttributeDatabaseService* _Nullable typeRecord = FindServiceTypeRecord(server, serviceType);
+    return typeRecord ? typeRecord->numTypeInstances : 0;
+}
+
+HAP_RESULT_USE_CHECK
+HAPServiceTypeIndex HAPAttributeDatabaseGetServiceTypeIndex(
+        HAPAccessoryServerRef* server_,
+        const HAPService* service,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(HAPAttributeDatabaseIsFlattened(server_));
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+
+    for (size_t i = 0; i < server->attributeDatabase.numAccessories; i++) {
+        const HAPAttributeDatabaseAccessory* accessoryRecord = GetAccessoryRecord(server, i);
+        if (accessoryRecord->accessory != accessory) {
+            continue;
+        }
+        for (size_t j = 0; j < accessoryRecord->numServices; j++) {
+            const HAPAttributeDatabaseService* serviceRecord =
+                    GetServiceRecord(server, accessoryRecord->firstService + j);
+            if (serviceRecord->service == service) {
+                return serviceRecord->typeInstanceIndex;
+            }
+        }
+        break;
+    }
+
+    HAPLogServiceError(&logObject, service, accessory, "Service not found in accessory server's attribute database.");
+    HAPFatalError();
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPAttributeDatabaseGetServiceFromServiceTypeIndex(
+        HAPAccessoryServerRef* server_,
+        const HAPUUID* serviceType,
+        HAPServiceTypeIndex serviceTypeIndex,
+        const HAPService* _Nonnull* _Nonnull service,
+        const HAPAccessory* _Nonnull* _Nonnull accessory) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(HAPAttributeDatabaseIsFlattened(server_));
+    HAPPrecondition(serviceType);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+
+    const HAPAttributeDatabaseService* _Nullable typeRecord = FindServiceTypeRecord(server, serviceType);
+    if (!typeRecord || serviceTypeIndex >= typeRecord->numTypeInstances) {
+        return false;
+    }
+    for (size_t i = typeRecord->typeIndex; i < server->attributeDatabase.numServices; i++) {
+        const HAPAttributeDatabaseService* serviceRecord = GetServiceRecord(server, i);
+        if (serviceRecord->typeID == typeRecord->typeID && serviceRecord->typeInstanceIndex == serviceTypeIndex) {
+            *service = serviceRecord->service;
+            *accessory = GetAccessoryRecord(server, serviceRecord->accessoryIndex)->accessory;
+            return true;
+        }
+    }
+    HAPFatalError();
+}
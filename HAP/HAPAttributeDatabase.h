@@ -0,0 +1,246 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_ATTRIBUTE_DATABASE_H
+#define HAP_ATTRIBUTE_DATABASE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Interned service or characteristic type.
+ *
+ * - Apple-defined types are identified by their short UUID. The IDs of the types in HAPServiceTypes.h and
+ *   HAPCharacteristicTypes.h are therefore known at compile time and are identical for all accessory servers.
+ *
+ * - Vendor-specific types have kHAPTypeID_Vendor set. They are interned when the attribute database is flattened.
+ *   Service types and characteristic types are interned separately.
+ */
+typedef uint32_t HAPTypeID;
+
+/**
+ * Flag that is set for vendor-specific types.
+ */
+#define kHAPTypeID_Vendor ((HAPTypeID)(1U << 31U))
+
+/**
+ * Service type IDs that are checked by the accessory server.
+ */
+/**@{*/
+#define kHAPServiceTypeID_AccessoryInformation   ((HAPTypeID) 0x3E)
+#define kHAPServiceTypeID_Pairing                ((HAPTypeID) 0x55)
+#define kHAPServiceTypeID_HAPProtocolInformation ((HAPTypeID) 0xA2)
+/**@}*/
+
+/**
+ * Characteristic type IDs that are checked by the accessory server.
+ */
+/**@{*/
+#define kHAPCharacteristicTypeID_Identify                ((HAPTypeID) 0x14)
+#define kHAPCharacteristicTypeID_ProgrammableSwitchEvent ((HAPTypeID) 0x73)
+#define kHAPCharacteristicTypeID_ServiceSignature        ((HAPTypeID) 0xA5)
+/**@}*/
+
+/**
+ * Gets the type ID of an Apple-defined service or characteristic type.
+ *
+ * - Vendor-specific types are only interned when the attribute database is flattened.
+ *   For those, kHAPTypeID_Vendor is returned.
+ *
+ * @param      type                 Service or characteristic type.
+ *
+ * @return Type ID if the type is Apple-defined. kHAPTypeID_Vendor otherwise.
+ */
+HAP_RESULT_USE_CHECK
+HAPTypeID HAPAttributeDatabaseGetTypeID(const HAPUUID* type);
+
+/**
+ * Flattens the attribute database of the registered accessories into the flattened attribute database storage.
+ *
+ * - If no storage is provided or if it is too small, the attribute database is not flattened.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPAttributeDatabaseCreate(HAPAccessoryServerRef* server);
+
+/**
+ * Discards the flattened attribute database.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPAttributeDatabaseRelease(HAPAccessoryServerRef* server);
+
+/**
+ * Returns whether the attribute database of the registered accessories is flattened.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return true                     If the attribute database is flattened.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPAttributeDatabaseIsFlattened(HAPAccessoryServerRef* server);
+
+/**
+ * Finds an accessory by accessory instance ID.
+ *
+ * - The attribute database must be flattened.
+ *
+ * @param      server               Accessory server.
+ * @param      aid                  Accessory instance ID.
+ *
+ * @return Accessory with the given accessory instance ID, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+const HAPAccessory* _Nullable HAPAttributeDatabaseFindAccessory(HAPAccessoryServerRef* server, uint64_t aid);
+
+/**
+ * Finds a characteristic that is supported over HAP over IP by accessory instance ID and instance ID.
+ *
+ * - The attribute database must be flattened.
+ *
+ * @param      server               Accessory server.
+ * @param      aid                  Accessory instance ID.
+ * @param      iid                  Characteristic instance ID.
+ * @param[out] characteristic       Characteristic, if found. NULL otherwise.
+ * @param[out] service              The service that contains the characteristic, if found. NULL otherwise.
+ * @param[out] accessory            The accessory that provides the service, if found. NULL otherwise.
+ * @param[out] characteristicTypeID Interned characteristic type, if found. Optional.
+ */
+void HAPAttributeDatabaseFindIPCharacteristic(
+        HAPAccessoryServerRef* server,
+        uint64_t aid,
+        uint64_t iid,
+        const HAPCharacteristic* _Nullable* _Nonnull characteristic,
+        const HAPService* _Nullable* _Nonnull service,
+        const HAPAccessory* _Nullable* _Nonnull accessory,
+        HAPTypeID* _Nullable characteristicTypeID);
+
+/**
+ * Gets the index of a characteristic record.
+ *
+ * - The attribute database must be flattened.
+ *
+ * - Characteristic records are in the order of the accessory, service and characteristic lists.
+ *   The index of a characteristic is stable until the attribute database is flattened again.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ *
+ * @return Index of the characteristic record.
+ */
+HAP_RESULT_USE_CHECK
+size_t HAPAttributeDatabaseGetCharacteristicIndex(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory);
+
+/**
+ * Gets a characteristic by the index of its characteristic record.
+ *
+ * - The attribute database must be flattened.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristicIndex  Index of the characteristic record.
+ * @param[out] characteristic       Characteristic.
+ * @param[out] service              The service that contains the characteristic.
+ * @param[out] accessory            The accessory that provides the service.
+ * @param[out] characteristicTypeID Interned characteristic type. Optional.
+ */
+void HAPAttributeDatabaseGetCharacteristic(
+        HAPAccessoryServerRef* server,
+        size_t characteristicIndex,
+        const HAPCharacteristic* _Nonnull* _Nonnull characteristic,
+        const HAPService* _Nonnull* _Nonnull service,
+        const HAPAccessory* _Nonnull* _Nonnull accessory,
+        HAPTypeID* _Nullable characteristicTypeID);
+
+/**
+ * Gets the index of the service record of the service that contains a characteristic.
+ *
+ * - The attribute database must be flattened.
+ *
+ * - Service records are in the order of the accessory and service lists.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristicIndex  Index of the characteristic record.
+ *
+ * @return Index of the service record.
+ */
+HAP_RESULT_USE_CHECK
+size_t HAPAttributeDatabaseGetCharacteristicServiceIndex(HAPAccessoryServerRef* server, size_t characteristicIndex);
+
+/**
+ * Returns the number of services of a given type.
+ *
+ * - The attribute database must be flattened.
+ *
+ * @param      server               Accessory server.
+ * @param      serviceType          Service type.
+ *
+ * @return Number of services of the given type.
+ */
+HAP_RESULT_USE_CHECK
+size_t HAPAttributeDatabaseGetNumServiceInstances(HAPAccessoryServerRef* server, const HAPUUID* serviceType);
+
+/**
+ * Returns the index of a service among all services of the same type.
+ *
+ * - The attribute database must be flattened.
+ *
+ * @param      server               Accessory server.
+ * @param      service              Service.
+ * @param      accessory            The accessory that provides the service.
+ *
+ * @return Index of the service among all services of the same type.
+ */
+HAP_RESULT_USE_CHECK
+HAPServiceTypeIndex HAPAttributeDatabaseGetServiceTypeIndex(
+        HAPAccessoryServerRef* server,
+        const HAPService* service,
+        const HAPAccessory* accessory);
+
+/**
+ * Finds a service by its index among all services of the same type.
+ *
+ * - The attribute database must be flattened.
+ *
+ * @param      server               Accessory server.
+ * @param      serviceType          Service type.
+ * @param      serviceTypeIndex     Index of the service among all services of the given type.
+ * @param[out] service              Service, if found.
+ * @param[out] accessory            The accessory that provides the service, if found.
+ *
+ * @return true                     If the service was found.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPAttributeDatabaseGetServiceFromServiceTypeIndex(
+        HAPAccessoryServerRef* server,
+        const HAPUUID* serviceType,
+        HAPServiceTypeIndex serviceTypeIndex,
+        const HAPService* _Nonnull* _Nonnull service,
+        const HAPAccessory* _Nonnull* _Nonnull accessory);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
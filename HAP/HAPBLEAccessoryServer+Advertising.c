@@ -8,18 +8,99 @@
 
 static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "BLEAccessoryServer" };
 
+/**
+ * GSN flag: The GSN has been reserved ahead of time, and GSNs before it may not have been used.
+ */
+#define kGSNFlag_IsReserved ((uint8_t) 0x02)
+
+/**
+ * Advances a GSN by a number of increments. The GSN wraps around to 1 after UINT16_MAX.
+ *
+ * @param      gsn                  GSN.
+ * @param      numIncrements        Number of increments.
+ *
+ * @return Advanced GSN.
+ */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerGetGSN(HAPPlatformKeyValueStoreRef keyValueStore, HAPBLEAccessoryServerGSN* gsn) {
-    HAPPrecondition(keyValueStore);
+static uint16_t AdvanceGSN(uint16_t gsn, uint16_t numIncrements) {
     HAPPrecondition(gsn);
 
+    return (uint16_t)(((uint32_t) gsn - 1 + numIncrements) % UINT16_MAX + 1);
+}
+
+/**
+ * Writes a GSN to the key-value store.
+ *
+ * @param      server               Accessory server.
+ * @param      gsn                  GSN.
+ * @param      isReserved           Whether the GSN has been reserved ahead of time.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteGSN(HAPAccessoryServer* server, uint16_t gsn, bool isReserved) {
+    HAPPrecondition(server);
+    HAPPrecondition(gsn);
+
+    HAPError err;
+
+    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn), isReserved ? kGSNFlag_IsReserved : (uint8_t) 0x00 };
+    err = HAPPlatformKeyValueStoreSet(
+            server->platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEGSN,
+            gsnBytes,
+            sizeof gsnBytes);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerLoadPersistentState(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
     HAPError err;
 
+    HAPRawBufferZero(&server->ble.persistentState, sizeof server->ble.persistentState);
+
+    // Load Device ID.
+    err = HAPDeviceIDGet(server->platform.keyValueStore, &server->ble.persistentState.deviceID);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+    err = HAPDeviceIDGetAsString(server->platform.keyValueStore, &server->ble.persistentState.deviceIDString);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    // Load broadcast encryption key parameters.
+    err = HAPBLEAccessoryServerBroadcastLoadParameters(server_);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    // Load broadcast configuration of the characteristics.
+    err = HAPBLECharacteristicLoadBroadcastConfiguration(server_);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    // Load GSN.
     bool found;
     size_t numBytes;
     uint8_t gsnBytes[sizeof(uint16_t) + sizeof(uint8_t)];
     err = HAPPlatformKeyValueStoreGet(
-            keyValueStore,
+            server->platform.keyValueStore,
             kHAPKeyValueStoreDomain_Configuration,
             kHAPKeyValueStoreKey_Configuration_BLEGSN,
             gsnBytes,
@@ -37,13 +118,63 @@ HAPError HAPBLEAccessoryServerGetGSN(HAPPlatformKeyValueStoreRef keyValueStore,
         HAPLog(&logObject, "Invalid GSN length %lu.", (unsigned long) numBytes);
         return kHAPError_Unknown;
     }
-
-    HAPRawBufferZero(gsn, sizeof *gsn);
+    HAPBLEAccessoryServerGSN* gsn = &server->ble.persistentState.gsn;
     gsn->gsn = HAPReadLittleUInt16(&gsnBytes[0]);
-    gsn->didIncrement = (gsnBytes[2] & 0x01u) == 0x01;
+    if (!gsn->gsn) {
+        HAPLog(&logObject, "Invalid GSN %u.", gsn->gsn);
+        return kHAPError_Unknown;
+    }
+
+    // After an unexpected restart, the GSN continues after the last reserved GSN. The skipped GSNs have not been
+    // advertised, but the broadcast encryption key must still expire if its expiration GSN has been skipped.
+    if (gsnBytes[2] & kGSNFlag_IsReserved) {
+        uint16_t keyExpirationGSN = server->ble.persistentState.broadcastParameters.keyExpirationGSN;
+        HAPLogInfo(&logObject, "Continuing after reserved GSN: %u.", gsn->gsn);
+        if (keyExpirationGSN) {
+            uint16_t numSkippedGSNs = (uint16_t)(((uint32_t) gsn->gsn + UINT16_MAX - keyExpirationGSN) % UINT16_MAX);
+            if (numSkippedGSNs && numSkippedGSNs <= kHAPBLEAccessoryServerGSN_NumReservedGSNs) {
+                err = HAPBLEAccessoryServerBroadcastExpireKey(server_);
+                if (err) {
+                    HAPAssert(err == kHAPError_Unknown);
+                    return err;
+                }
+            }
+        }
+    }
+
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerSaveGSN(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    if (!server->ble.persistentState.numReservedGSNs) {
+        return kHAPError_None;
+    }
+
+    err = WriteGSN(server, server->ble.persistentState.gsn.gsn, /* isReserved: */ false);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+    server->ble.persistentState.numReservedGSNs = 0;
+
     return kHAPError_None;
 }
 
+void HAPBLEAccessoryServerGetGSN(HAPAccessoryServerRef* server_, HAPBLEAccessoryServerGSN* gsn) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(gsn);
+
+    HAPAssert(server->ble.persistentState.gsn.gsn);
+    *gsn = server->ble.persistentState.gsn;
+}
+
 HAP_RESULT_USE_CHECK
 HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
         HAPAccessoryServerRef* server_,
@@ -77,9 +208,18 @@ HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
     // The accessory shall not advertise while it is connected to a HomeKit controller.
     // See HomeKit Accessory Protocol Specification R14
     // Section 7.4.1.4 Advertising Interval
+    // The regular advertisement is kept while further controllers may connect to unused BLE sessions.
     if (server->ble.adv.connected) {
-        *isActive = false;
-        return kHAPError_None;
+        size_t numConnections = 0;
+        for (size_t i = 0; i < server->ble.numSessions; i++) {
+            if (server->ble.connections[i].connected) {
+                numConnections++;
+            }
+        }
+        if (numConnections >= server->ble.numSessions) {
+            *isActive = false;
+            return kHAPError_None;
+        }
     }
 
     if (server->ble.adv.broadcastedEvent.iid) {
@@ -88,24 +228,14 @@ HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
         // Section 7.4.2.2 HAP BLE Encrypted Notification Advertisement Format
 
         uint16_t keyExpirationGSN;
-        HAPBLEAccessoryServerBroadcastEncryptionKey broadcastKey;
         HAPDeviceID advertisingID;
-        err = HAPBLEAccessoryServerBroadcastGetParameters(
-                server->platform.keyValueStore, &keyExpirationGSN, &broadcastKey, &advertisingID);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
+        HAPBLEAccessoryServerBroadcastGetParameters(server_, &keyExpirationGSN, NULL, &advertisingID);
         if (!keyExpirationGSN) {
             HAPLog(&logObject, "Started broadcasted event without valid key. Corrupted data?");
             return kHAPError_Unknown;
         }
         HAPBLEAccessoryServerGSN gsn;
-        err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
+        HAPBLEAccessoryServerGetGSN(server_, &gsn);
 
         // Interval.
         *advertisingInterval = 0;
@@ -150,35 +280,13 @@ HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
             HAPRawBufferCopyBytes(adv, advertisingID.bytes, sizeof advertisingID.bytes);
             adv += sizeof advertisingID.bytes;
         }
-        uint8_t* encryptedBytes = adv;
-        /* 0x0C   GSN */ HAPWriteLittleUInt16(adv, gsn.gsn);
-        adv += 2;
-        /* 0x0E   IID */ HAPWriteLittleUInt16(adv, server->ble.adv.broadcastedEvent.iid);
-        adv += 2;
-        /* 0x10 Value */ {
+        /* 0x0C    Ev */ {
+            // GSN, IID, Value and Tag, encrypted when the broadcasted event started.
             HAPRawBufferCopyBytes(
-                    adv, server->ble.adv.broadcastedEvent.value, sizeof server->ble.adv.broadcastedEvent.value);
-            adv += sizeof server->ble.adv.broadcastedEvent.value;
-        }
-        /* 0x18   Tag */ {
-            // See HomeKit Accessory Protocol Specification R14
-            // Section 5.9 AEAD Algorithm.
-            // See HomeKit Accessory Protocol Specification R14
-            // Section 7.4.7.3 Broadcast Encryption Key Generation
-            uint8_t tagBytes[CHACHA20_POLY1305_TAG_BYTES];
-            uint8_t nonceBytes[] = { HAPExpandLittleUInt64((uint64_t) gsn.gsn) };
-            HAP_chacha20_poly1305_encrypt_aad(
-                    tagBytes,
-                    encryptedBytes,
-                    encryptedBytes,
-                    (size_t)(adv - encryptedBytes),
-                    advertisingID.bytes,
-                    sizeof advertisingID.bytes,
-                    nonceBytes,
-                    sizeof nonceBytes,
-                    broadcastKey.value);
-            HAPRawBufferCopyBytes(adv, tagBytes, 4);
-            adv += 4;
+                    adv,
+                    server->ble.adv.broadcastedEvent.encryptedBytes,
+                    sizeof server->ble.adv.broadcastedEvent.encryptedBytes);
+            adv += sizeof server->ble.adv.broadcastedEvent.encryptedBytes;
         }
 
         *numAdvertisingBytes = (size_t)(adv - (uint8_t*) advertisingBytes);
@@ -285,51 +393,30 @@ HAPError HAPBLEAccessoryServerGetAdvertisingParameters(
         /* 0x05   STL */ *adv++ = (uint8_t)(0x2D + (hasSetupID ? 4 : 0));
         /* 0x06    SF */ *adv++ = (uint8_t)(HAPAccessoryServerIsPaired(server_) ? 0U << 0U : 1U << 0U);
         /* 0x07 DevID */ {
-            HAPDeviceID deviceID;
-            err = HAPDeviceIDGet(server->platform.keyValueStore, &deviceID);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
-            HAPAssert(sizeof deviceID.bytes == 6);
-            HAPRawBufferCopyBytes(adv, deviceID.bytes, sizeof deviceID.bytes);
-            adv += sizeof deviceID.bytes;
+            const HAPDeviceID* deviceID = &server->ble.persistentState.deviceID;
+            HAPAssert(sizeof deviceID->bytes == 6);
+            HAPRawBufferCopyBytes(adv, deviceID->bytes, sizeof deviceID->bytes);
+            adv += sizeof deviceID->bytes;
         }
         /* 0x0D  ACID */ HAPWriteLittleUInt16(adv, (uint16_t) server->primaryAccessory->category);
         adv += 2;
         /* 0x0F   GSN */ {
             HAPBLEAccessoryServerGSN gsn;
-            err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            HAPBLEAccessoryServerGetGSN(server_, &gsn);
             HAPWriteLittleUInt16(adv, gsn.gsn);
             adv += 2;
         }
         /* 0x11    CN */ {
-            uint16_t cn;
-            err = HAPAccessoryServerGetCN(server->platform.keyValueStore, &cn);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            uint16_t cn = server->configurationNumber;
+            HAPAssert(cn);
             *adv++ = (uint8_t)((cn - 1) % UINT8_MAX + 1);
         }
         /* 0x12    CV */ *adv++ = 0x02;
         /* 0x13    SH */ {
             if (hasSetupID) {
-                // Get Device ID string.
-                HAPDeviceIDString deviceIDString;
-                err = HAPDeviceIDGetAsString(server->platform.keyValueStore, &deviceIDString);
-                if (err) {
-                    HAPAssert(err == kHAPError_Unknown);
-                    return err;
-                }
-
                 // Get setup hash.
                 HAPAccessorySetupSetupHash setupHash;
-                HAPAccessorySetupGetSetupHash(&setupHash, &setupID, &deviceIDString);
+                HAPAccessorySetupGetSetupHash(&setupHash, &setupID, &server->ble.persistentState.deviceIDString);
 
                 // Append.
                 HAPAssert(sizeof setupHash.bytes == 4);
@@ -522,8 +609,6 @@ HAPError HAPBLEAccessoryServerDidConnect(HAPAccessoryServerRef* server_) {
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(!server->ble.adv.connected);
 
-    HAPError err;
-
     server->ble.adv.connected = true;
 
     // Stop fast advertisement timer.
@@ -544,24 +629,7 @@ HAPError HAPBLEAccessoryServerDidConnect(HAPAccessoryServerRef* server_) {
     }
 
     // Reset disconnected events coalescing.
-    HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-    gsn.didIncrement = false;
-    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn.gsn), gsn.didIncrement ? (uint8_t) 0x01 : (uint8_t) 0x00 };
-    err = HAPPlatformKeyValueStoreSet(
-            server->platform.keyValueStore,
-            kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEGSN,
-            gsnBytes,
-            sizeof gsnBytes);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    server->ble.persistentState.gsn.didIncrement = false;
 
     // Reset broadcasted events.
     HAPRawBufferZero(&server->ble.adv.broadcastedEvent, sizeof server->ble.adv.broadcastedEvent);
@@ -597,24 +665,7 @@ HAPError HAPBLEAccessoryServerDidDisconnect(HAPAccessoryServerRef* server_) {
     }
 
     // Reset GSN update coalescing.
-    HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-    gsn.didIncrement = false;
-    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn.gsn), gsn.didIncrement ? (uint8_t) 0x01 : (uint8_t) 0x00 };
-    err = HAPPlatformKeyValueStoreSet(
-            server->platform.keyValueStore,
-            kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEGSN,
-            gsnBytes,
-            sizeof gsnBytes);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    server->ble.persistentState.gsn.didIncrement = false;
 
     HAPAssert(!server->ble.adv.broadcastedEvent.iid);
 
@@ -644,56 +695,85 @@ static HAPError HAPBLEAccessoryServerIncrementGSN(HAPAccessoryServerRef* server_
 
     HAPError err;
 
-    // Get key expiration GSN.
-    uint16_t keyExpirationGSN;
-    err = HAPBLEAccessoryServerBroadcastGetParameters(server->platform.keyValueStore, &keyExpirationGSN, NULL, NULL);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-
-    // Get GSN.
-    HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    HAPBLEAccessoryServerGSN* gsn = &server->ble.persistentState.gsn;
 
     // Expire broadcast encryption key if necessary.
-    if (gsn.gsn == keyExpirationGSN) {
-        err = HAPBLEAccessoryServerBroadcastExpireKey(server->platform.keyValueStore);
+    uint16_t keyExpirationGSN;
+    HAPBLEAccessoryServerBroadcastGetParameters(server_, &keyExpirationGSN, NULL, NULL);
+    if (gsn->gsn == keyExpirationGSN) {
+        err = HAPBLEAccessoryServerBroadcastExpireKey(server_);
         if (err) {
             HAPAssert(err == kHAPError_Unknown);
             return err;
         }
     }
 
-    // Increment GSN.
-    if (gsn.gsn == UINT16_MAX) {
-        gsn.gsn = 1;
-    } else {
-        gsn.gsn++;
+    // Reserve GSNs ahead of time, so that the key-value store is only written once every few increments.
+    if (!server->ble.persistentState.numReservedGSNs) {
+        err = WriteGSN(
+                server, AdvanceGSN(gsn->gsn, kHAPBLEAccessoryServerGSN_NumReservedGSNs), /* isReserved: */ true);
+        if (err) {
+            HAPAssert(err == kHAPError_Unknown);
+            return err;
+        }
+        server->ble.persistentState.numReservedGSNs = kHAPBLEAccessoryServerGSN_NumReservedGSNs;
     }
-    gsn.didIncrement = true;
-    HAPLogInfo(&logObject, "New GSN: %u.", gsn.gsn);
 
-    // Save GSN state.
-    uint8_t gsnBytes[] = { HAPExpandLittleUInt16(gsn.gsn), gsn.didIncrement ? (uint8_t) 0x01 : (uint8_t) 0x00 };
-    err = HAPPlatformKeyValueStoreSet(
-            server->platform.keyValueStore,
-            kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEGSN,
-            gsnBytes,
-            sizeof gsnBytes);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    // Increment GSN.
+    gsn->gsn = AdvanceGSN(gsn->gsn, 1);
+    gsn->didIncrement = true;
+    server->ble.persistentState.numReservedGSNs--;
+    HAPLogInfo(&logObject, "New GSN: %u.", gsn->gsn);
 
     return kHAPError_None;
 }
 
+/**
+ * Encrypts the broadcasted event with the current GSN and broadcast encryption key.
+ *
+ * @param      server_              Accessory server.
+ *
+ * @see HomeKit Accessory Protocol Specification R14
+ *      Section 7.4.2.2.2 Manufacturer Data
+ */
+static void EncryptBroadcastedEvent(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ble.adv.broadcastedEvent.iid);
+
+    uint16_t keyExpirationGSN;
+    HAPBLEAccessoryServerBroadcastEncryptionKey broadcastKey;
+    HAPDeviceID advertisingID;
+    HAPBLEAccessoryServerBroadcastGetParameters(server_, &keyExpirationGSN, &broadcastKey, &advertisingID);
+    HAPAssert(keyExpirationGSN);
+    HAPBLEAccessoryServerGSN gsn;
+    HAPBLEAccessoryServerGetGSN(server_, &gsn);
+
+    uint8_t* bytes = server->ble.adv.broadcastedEvent.encryptedBytes;
+    /* 0x00   GSN */ HAPWriteLittleUInt16(&bytes[0x00], gsn.gsn);
+    /* 0x02   IID */ HAPWriteLittleUInt16(&bytes[0x02], server->ble.adv.broadcastedEvent.iid);
+    /* 0x04 Value */ HAPRawBufferCopyBytes(&bytes[0x04], server->ble.adv.broadcastedEvent.value, 8);
+    /* 0x0C   Tag */ {
+        // See HomeKit Accessory Protocol Specification R14
+        // Section 5.9 AEAD Algorithm.
+        // See HomeKit Accessory Protocol Specification R14
+        // Section 7.4.7.3 Broadcast Encryption Key Generation
+        uint8_t tagBytes[CHACHA20_POLY1305_TAG_BYTES];
+        uint8_t nonceBytes[] = { HAPExpandLittleUInt64((uint64_t) gsn.gsn) };
+        HAP_chacha20_poly1305_encrypt_aad(
+                tagBytes,
+                bytes,
+                bytes,
+                0x0C,
+                advertisingID.bytes,
+                sizeof advertisingID.bytes,
+                nonceBytes,
+                sizeof nonceBytes,
+                broadcastKey.value);
+        HAPRawBufferCopyBytes(&bytes[0x0C], tagBytes, 4);
+    }
+}
+
 HAP_RESULT_USE_CHECK
 HAPError HAPBLEAccessoryServerDidRaiseEvent(
         HAPAccessoryServerRef* server_,
@@ -713,21 +793,8 @@ HAPError HAPBLEAccessoryServerDidRaiseEvent(
 
     if (characteristic->properties.supportsEventNotification) {
         // Connected event.
-        if (server->ble.connection.connected && (!session || session == server->ble.storage->session)) {
-            const HAPCharacteristic* writtenCharacteristic = server->ble.connection.write.characteristic;
-            const HAPService* writtenService = server->ble.connection.write.service;
-            const HAPAccessory* writtenAccessory = server->ble.connection.write.accessory;
-            if (characteristic_ == writtenCharacteristic && service == writtenService &&
-                accessory == writtenAccessory) {
-                HAPLogCharacteristicInfo(
-                        &logObject,
-                        characteristic,
-                        service,
-                        accessory,
-                        "Suppressing notification as the characteristic is currently being written.");
-            } else {
-                HAPBLEPeripheralManagerRaiseEvent(server_, characteristic_, service, accessory);
-            }
+        if (server->ble.adv.connected) {
+            HAPBLEPeripheralManagerRaiseEvent(server_, characteristic_, service, accessory, session);
         }
     }
 
@@ -743,18 +810,9 @@ HAPError HAPBLEAccessoryServerDidRaiseEvent(
         // Section 7.4.6.2 Broadcasted Events
         if (!server->ble.adv.connected) {
             uint16_t keyExpirationGSN;
-            err = HAPBLEAccessoryServerBroadcastGetParameters(
-                    server->platform.keyValueStore, &keyExpirationGSN, NULL, NULL);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            HAPBLEAccessoryServerBroadcastGetParameters(server_, &keyExpirationGSN, NULL, NULL);
             HAPBLEAccessoryServerGSN gsn;
-            err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            HAPBLEAccessoryServerGetGSN(server_, &gsn);
 
             // Characteristic changes while in a broadcast encryption key expired state shall not use broadcasted events
             // and must fall back to disconnected/connected events until the controller has re-generated a new broadcast
@@ -764,12 +822,8 @@ HAPError HAPBLEAccessoryServerDidRaiseEvent(
             if (keyExpirationGSN && keyExpirationGSN != gsn.gsn) {
                 HAPBLECharacteristicBroadcastInterval interval;
                 bool enabled;
-                err = HAPBLECharacteristicGetBroadcastConfiguration(
-                        characteristic, service, accessory, &enabled, &interval, server->platform.keyValueStore);
-                if (err) {
-                    HAPAssert(err == kHAPError_Unknown);
-                    return err;
-                }
+                HAPBLECharacteristicGetBroadcastConfiguration(
+                        characteristic, service, accessory, &enabled, &interval, server_);
 
                 if (enabled) {
                     // For additional characteristic changes before the completion of the 3 second period and before
@@ -991,6 +1045,7 @@ HAPError HAPBLEAccessoryServerDidRaiseEvent(
                             server->ble.adv.broadcastedEvent.interval = interval;
                             HAPAssert(characteristic->iid <= UINT16_MAX);
                             server->ble.adv.broadcastedEvent.iid = (uint16_t) characteristic->iid;
+                            EncryptBroadcastedEvent(server_);
                             HAPLogCharacteristicInfo(
                                     &logObject, characteristic, service, accessory, "Broadcasted Event.");
                         }
@@ -1027,11 +1082,7 @@ HAPError HAPBLEAccessoryServerDidRaiseEvent(
         // Section 7.4.6.3 Disconnected Events
 
         HAPBLEAccessoryServerGSN gsn;
-        err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
+        HAPBLEAccessoryServerGetGSN(server_, &gsn);
 
         // The GSN should increment only once for multiple characteristic value changes while in in disconnected state
         // until the accessory state changes from disconnected to connected.
@@ -1113,11 +1164,7 @@ HAPError HAPBLEAccessoryServerDidSendEventNotification(
     // See HomeKit Accessory Protocol Specification R14
     // Section 7.4.6.1 Connected Events
     HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    HAPBLEAccessoryServerGetGSN(server_, &gsn);
 
     // The GSN should increment only once for multiple characteristic value changes while in in disconnected state
     // until the accessory state changes from disconnected to connected.
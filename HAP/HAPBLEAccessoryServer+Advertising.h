@@ -26,16 +26,45 @@ typedef struct {
 } HAPBLEAccessoryServerGSN;
 
 /**
- * BLE: Fetches GSN state.
+ * BLE: Number of GSN increments that are reserved with each write of the GSN to the key-value store.
  *
- * @param      keyValueStore        Key-value store
- * @param[out] gsn                  GSN.
+ * - After an unexpected restart, the GSN continues after the last reserved GSN.
+ */
+#define kHAPBLEAccessoryServerGSN_NumReservedGSNs ((uint16_t) 16)
+
+/**
+ * BLE: Loads the persistent advertising state from the key-value store.
+ *
+ * - This must be called when the accessory server starts. Afterwards, the state is kept in memory.
+ *
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
  */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerGetGSN(HAPPlatformKeyValueStoreRef keyValueStore, HAPBLEAccessoryServerGSN* gsn);
+HAPError HAPBLEAccessoryServerLoadPersistentState(HAPAccessoryServerRef* server);
+
+/**
+ * BLE: Saves the current GSN to the key-value store, releasing GSNs that have been reserved ahead of time.
+ *
+ * - This should be called when the accessory server stops, so that no GSNs are skipped after a restart.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerSaveGSN(HAPAccessoryServerRef* server);
+
+/**
+ * BLE: Fetches GSN state.
+ *
+ * @param      server               Accessory server.
+ * @param[out] gsn                  GSN.
+ */
+void HAPBLEAccessoryServerGetGSN(HAPAccessoryServerRef* server, HAPBLEAccessoryServerGSN* gsn);
 
 /**
  * BLE: Get advertisement parameters.
@@ -8,13 +8,6 @@
 
 static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "BLEAccessoryServer" };
 
-typedef struct {
-    uint16_t keyExpirationGSN;
-    HAPBLEAccessoryServerBroadcastEncryptionKey key;
-    bool hasAdvertisingID;
-    HAPDeviceID advertisingID;
-} HAPBLEAccessoryServerBroadcastParameters;
-
 #define HAP_BLE_ACCESSORY_SERVER_GET_BROADCAST_PARAMETERS_OR_RETURN_ERROR(keyValueStore, parameters) \
     do { \
         bool found; \
@@ -49,50 +42,100 @@ typedef struct {
         HAPRawBufferCopyBytes((parameters)->advertisingID.bytes, &parametersBytes[35], 6); \
     } while (0)
 
+/**
+ * Saves broadcast encryption key parameters to the key-value store and updates the in-memory copy.
+ *
+ * @param      server               Accessory server.
+ * @param      parameters           Broadcast encryption key parameters.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerBroadcastGetParameters(
-        HAPPlatformKeyValueStoreRef keyValueStore,
+static HAPError SaveParameters(HAPAccessoryServer* server, const HAPBLEAccessoryServerBroadcastParameters* parameters) {
+    HAPPrecondition(server);
+    HAPPrecondition(parameters);
+
+    HAPError err;
+
+    uint8_t parametersBytes
+            [sizeof(uint16_t) + sizeof(HAPBLEAccessoryServerBroadcastEncryptionKey) + sizeof(uint8_t) +
+             sizeof(HAPDeviceID)];
+    HAPWriteLittleUInt16(&parametersBytes[0], parameters->keyExpirationGSN);
+    HAPAssert(sizeof parameters->key.value == 32);
+    HAPRawBufferCopyBytes(&parametersBytes[2], parameters->key.value, 32);
+    parametersBytes[34] = parameters->hasAdvertisingID ? (uint8_t) 0x01 : (uint8_t) 0x00;
+    HAPAssert(sizeof parameters->advertisingID.bytes == 6);
+    HAPRawBufferCopyBytes(&parametersBytes[35], parameters->advertisingID.bytes, 6);
+    err = HAPPlatformKeyValueStoreSet(
+            server->platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters,
+            parametersBytes,
+            sizeof parametersBytes);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    HAPRawBufferCopyBytes(
+            &server->ble.persistentState.broadcastParameters,
+            parameters,
+            sizeof server->ble.persistentState.broadcastParameters);
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerBroadcastLoadParameters(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    HAPBLEAccessoryServerBroadcastParameters parameters;
+    HAP_BLE_ACCESSORY_SERVER_GET_BROADCAST_PARAMETERS_OR_RETURN_ERROR(server->platform.keyValueStore, &parameters);
+    HAPRawBufferCopyBytes(
+            &server->ble.persistentState.broadcastParameters,
+            &parameters,
+            sizeof server->ble.persistentState.broadcastParameters);
+    return kHAPError_None;
+}
+
+void HAPBLEAccessoryServerBroadcastGetParameters(
+        HAPAccessoryServerRef* server_,
         uint16_t* keyExpirationGSN,
         HAPBLEAccessoryServerBroadcastEncryptionKey* _Nullable broadcastKey,
         HAPDeviceID* _Nullable advertisingID) {
-    HAPPrecondition(keyValueStore);
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(keyExpirationGSN);
 
-    HAPError err;
-
-    // Get parameters.
-    HAPBLEAccessoryServerBroadcastParameters parameters;
-    HAP_BLE_ACCESSORY_SERVER_GET_BROADCAST_PARAMETERS_OR_RETURN_ERROR(keyValueStore, &parameters);
+    const HAPBLEAccessoryServerBroadcastParameters* parameters = &server->ble.persistentState.broadcastParameters;
 
     // Copy result.
-    *keyExpirationGSN = parameters.keyExpirationGSN;
-    if (parameters.keyExpirationGSN) {
+    *keyExpirationGSN = parameters->keyExpirationGSN;
+    if (parameters->keyExpirationGSN) {
         if (broadcastKey) {
-            HAPRawBufferCopyBytes(HAPNonnull(broadcastKey), &parameters.key, sizeof *broadcastKey);
+            HAPRawBufferCopyBytes(HAPNonnull(broadcastKey), &parameters->key, sizeof *broadcastKey);
             HAPLogSensitiveBufferDebug(
                     &logObject,
-                    parameters.key.value,
-                    sizeof parameters.key.value,
+                    parameters->key.value,
+                    sizeof parameters->key.value,
                     "BLE Broadcast Encryption Key (Expires after GSN %u).",
-                    parameters.keyExpirationGSN);
+                    parameters->keyExpirationGSN);
         }
     }
     if (advertisingID) {
-        if (parameters.hasAdvertisingID) {
-            HAPRawBufferCopyBytes(HAPNonnull(advertisingID), &parameters.advertisingID, sizeof *advertisingID);
+        if (parameters->hasAdvertisingID) {
+            HAPRawBufferCopyBytes(HAPNonnull(advertisingID), &parameters->advertisingID, sizeof *advertisingID);
         } else {
             // Fallback to Device ID.
             // See HomeKit Accessory Protocol Specification R14
             // Section 7.4.2.2.2 Manufacturer Data
-            err = HAPDeviceIDGet(keyValueStore, HAPNonnull(advertisingID));
-            if (err) {
-                HAPAssert(err == kHAPError_Unknown);
-                return err;
-            }
+            HAPRawBufferCopyBytes(
+                    HAPNonnull(advertisingID), &server->ble.persistentState.deviceID, sizeof *advertisingID);
         }
     }
-
-    return kHAPError_None;
 }
 
 HAP_RESULT_USE_CHECK
@@ -111,11 +154,7 @@ HAPError
 
     // Get GSN.
     HAPBLEAccessoryServerGSN gsn;
-    err = HAPBLEAccessoryServerGetGSN(server->platform.keyValueStore, &gsn);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
+    HAPBLEAccessoryServerGetGSN(session->server, &gsn);
 
     // The broadcast encryption key shall expire and automatically and must be discarded by the
     // accessory after 32,767 (2^15 - 1) increments in GSN after the current broadcast key was
@@ -188,21 +227,7 @@ HAPError
     }
 
     // Save.
-    uint8_t parametersBytes
-            [sizeof(uint16_t) + sizeof(HAPBLEAccessoryServerBroadcastEncryptionKey) + sizeof(uint8_t) +
-             sizeof(HAPDeviceID)];
-    HAPWriteLittleUInt16(&parametersBytes[0], parameters.keyExpirationGSN);
-    HAPAssert(sizeof parameters.key.value == 32);
-    HAPRawBufferCopyBytes(&parametersBytes[2], parameters.key.value, 32);
-    parametersBytes[34] = parameters.hasAdvertisingID ? (uint8_t) 0x01 : (uint8_t) 0x00;
-    HAPAssert(sizeof parameters.advertisingID.bytes == 6);
-    HAPRawBufferCopyBytes(&parametersBytes[35], parameters.advertisingID.bytes, 6);
-    err = HAPPlatformKeyValueStoreSet(
-            server->platform.keyValueStore,
-            kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters,
-            parametersBytes,
-            sizeof parametersBytes);
+    err = SaveParameters(server, &parameters);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -213,16 +238,17 @@ HAPError
 
 HAP_RESULT_USE_CHECK
 HAPError HAPBLEAccessoryServerBroadcastSetAdvertisingID(
-        HAPPlatformKeyValueStoreRef keyValueStore,
+        HAPAccessoryServerRef* server_,
         const HAPDeviceID* advertisingID) {
-    HAPPrecondition(keyValueStore);
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(advertisingID);
 
     HAPError err;
 
     // Get state.
     HAPBLEAccessoryServerBroadcastParameters parameters;
-    HAP_BLE_ACCESSORY_SERVER_GET_BROADCAST_PARAMETERS_OR_RETURN_ERROR(keyValueStore, &parameters);
+    HAP_BLE_ACCESSORY_SERVER_GET_BROADCAST_PARAMETERS_OR_RETURN_ERROR(server->platform.keyValueStore, &parameters);
 
     // Copy advertising identifier.
     parameters.hasAdvertisingID = true;
@@ -230,21 +256,7 @@ HAPError HAPBLEAccessoryServerBroadcastSetAdvertisingID(
     HAPRawBufferCopyBytes(&parameters.advertisingID, advertisingID, sizeof parameters.advertisingID);
 
     // Save.
-    uint8_t parametersBytes
-            [sizeof(uint16_t) + sizeof(HAPBLEAccessoryServerBroadcastEncryptionKey) + sizeof(uint8_t) +
-             sizeof(HAPDeviceID)];
-    HAPWriteLittleUInt16(&parametersBytes[0], parameters.keyExpirationGSN);
-    HAPAssert(sizeof parameters.key.value == 32);
-    HAPRawBufferCopyBytes(&parametersBytes[2], parameters.key.value, 32);
-    parametersBytes[34] = parameters.hasAdvertisingID ? (uint8_t) 0x01 : (uint8_t) 0x00;
-    HAPAssert(sizeof parameters.advertisingID.bytes == 6);
-    HAPRawBufferCopyBytes(&parametersBytes[35], parameters.advertisingID.bytes, 6);
-    err = HAPPlatformKeyValueStoreSet(
-            keyValueStore,
-            kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters,
-            parametersBytes,
-            sizeof parametersBytes);
+    err = SaveParameters(server, &parameters);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -254,8 +266,9 @@ HAPError HAPBLEAccessoryServerBroadcastSetAdvertisingID(
 }
 
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerBroadcastExpireKey(HAPPlatformKeyValueStoreRef keyValueStore) {
-    HAPPrecondition(keyValueStore);
+HAPError HAPBLEAccessoryServerBroadcastExpireKey(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
 
     HAPError err;
 
@@ -263,32 +276,39 @@ HAPError HAPBLEAccessoryServerBroadcastExpireKey(HAPPlatformKeyValueStoreRef key
 
     // Get state.
     HAPBLEAccessoryServerBroadcastParameters parameters;
-    HAP_BLE_ACCESSORY_SERVER_GET_BROADCAST_PARAMETERS_OR_RETURN_ERROR(keyValueStore, &parameters);
+    HAP_BLE_ACCESSORY_SERVER_GET_BROADCAST_PARAMETERS_OR_RETURN_ERROR(server->platform.keyValueStore, &parameters);
 
     // Expire encryption key.
     parameters.keyExpirationGSN = 0;
     HAPRawBufferZero(&parameters.key, sizeof parameters.key);
 
     // Save.
-    uint8_t parametersBytes
-            [sizeof(uint16_t) + sizeof(HAPBLEAccessoryServerBroadcastEncryptionKey) + sizeof(uint8_t) +
-             sizeof(HAPDeviceID)];
-    HAPWriteLittleUInt16(&parametersBytes[0], parameters.keyExpirationGSN);
-    HAPAssert(sizeof parameters.key.value == 32);
-    HAPRawBufferCopyBytes(&parametersBytes[2], parameters.key.value, 32);
-    parametersBytes[34] = parameters.hasAdvertisingID ? (uint8_t) 0x01 : (uint8_t) 0x00;
-    HAPAssert(sizeof parameters.advertisingID.bytes == 6);
-    HAPRawBufferCopyBytes(&parametersBytes[35], parameters.advertisingID.bytes, 6);
-    err = HAPPlatformKeyValueStoreSet(
-            keyValueStore,
+    err = SaveParameters(server, &parameters);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerBroadcastPurgeParameters(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    err = HAPPlatformKeyValueStoreRemove(
+            server->platform.keyValueStore,
             kHAPKeyValueStoreDomain_Configuration,
-            kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters,
-            parametersBytes,
-            sizeof parametersBytes);
+            kHAPKeyValueStoreKey_Configuration_BLEBroadcastParameters);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
     }
 
+    HAPRawBufferZero(
+            &server->ble.persistentState.broadcastParameters, sizeof server->ble.persistentState.broadcastParameters);
     return kHAPError_None;
 }
@@ -31,23 +31,49 @@ HAP_STATIC_ASSERT(
         HAPBLEAccessoryServerBroadcastEncryptionKey);
 HAP_NONNULL_SUPPORT(HAPBLEAccessoryServerBroadcastEncryptionKey)
 
+/**
+ * BLE: Broadcast encryption key and accessory advertising identifier.
+ */
+typedef struct {
+    /** GSN after which the broadcast encryption key expires. 0 if key is expired. */
+    uint16_t keyExpirationGSN;
+
+    /** Broadcast encryption key. */
+    HAPBLEAccessoryServerBroadcastEncryptionKey key;
+
+    /** Whether an accessory advertising identifier has been set. */
+    bool hasAdvertisingID;
+
+    /** Accessory advertising identifier, if set. */
+    HAPDeviceID advertisingID;
+} HAPBLEAccessoryServerBroadcastParameters;
+
+/**
+ * BLE: Loads the broadcast encryption key parameters from the key-value store.
+ *
+ * - This must be called when the accessory server starts. Afterwards, the parameters are kept in memory.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerBroadcastLoadParameters(HAPAccessoryServerRef* server);
+
 /**
  * BLE: Fetches broadcast encryption key parameters.
  *
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  * @param[out] keyExpirationGSN     GSN after which the broadcast encryption key expires. 0 if key is expired.
  * @param[out] broadcastKey         Broadcast encryption key, if available.
  * @param[out] advertisingID        Accessory advertising identifier.
  *
- * @return kHAPError_None           If successful.
- * @return kHAPError_Unknown        If an I/O error occurred.
- *
  * @see HomeKit Accessory Protocol Specification R14
  *      Section 7.4.7.3 Broadcast Encryption Key Generation
  */
-HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerBroadcastGetParameters(
-        HAPPlatformKeyValueStoreRef keyValueStore,
+void HAPBLEAccessoryServerBroadcastGetParameters(
+        HAPAccessoryServerRef* server,
         uint16_t* keyExpirationGSN,
         HAPBLEAccessoryServerBroadcastEncryptionKey* _Nullable broadcastKey,
         HAPDeviceID* _Nullable advertisingID);
@@ -70,7 +96,7 @@ HAPError HAPBLEAccessoryServerBroadcastGenerateKey(HAPSessionRef* session, const
 /**
  * BLE: Set accessory advertising identifier.
  *
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  * @param      advertisingID        New accessory advertising identifier.
  *
  * @return kHAPError_None           If successful.
@@ -81,13 +107,13 @@ HAPError HAPBLEAccessoryServerBroadcastGenerateKey(HAPSessionRef* session, const
  */
 HAP_RESULT_USE_CHECK
 HAPError HAPBLEAccessoryServerBroadcastSetAdvertisingID(
-        HAPPlatformKeyValueStoreRef keyValueStore,
+        HAPAccessoryServerRef* server,
         const HAPDeviceID* advertisingID);
 
 /**
  * BLE: Invalidate broadcast encryption key.
  *
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
@@ -96,7 +122,21 @@ HAPError HAPBLEAccessoryServerBroadcastSetAdvertisingID(
  *      Section 7.4.7.4 Broadcast Encryption Key expiration and refresh
  */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLEAccessoryServerBroadcastExpireKey(HAPPlatformKeyValueStoreRef keyValueStore);
+HAPError HAPBLEAccessoryServerBroadcastExpireKey(HAPAccessoryServerRef* server);
+
+/**
+ * BLE: Removes the broadcast encryption key and the accessory advertising identifier.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ *
+ * @see HomeKit Certification Test Cases R7.2
+ *      Test Case TCB052
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLEAccessoryServerBroadcastPurgeParameters(HAPAccessoryServerRef* server);
 
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
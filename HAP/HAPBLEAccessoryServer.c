@@ -19,20 +19,26 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
     HAPPrecondition(options->ble.accessoryServerStorage);
     HAPBLEAccessoryServerStorage* storage = options->ble.accessoryServerStorage;
     HAPPrecondition(storage->gattTableElements);
+    HAPPrecondition(!storage->numGATTHandleTableEntries || storage->gattHandleTable);
+    HAPPrecondition(!storage->signatureCache.numBytes || storage->signatureCache.bytes);
     HAPPrecondition(storage->sessionCacheElements);
     HAPPrecondition(storage->numSessionCacheElements >= kHAPBLESessionCache_MinElements);
+    HAPPrecondition(storage->numSessionCacheElements < UINT16_MAX);
     HAPPrecondition(storage->session);
+    HAPPrecondition(storage->numSessions <= kHAPBLESessions_MaxElements);
+    size_t numSessions = storage->numSessions ? storage->numSessions : 1;
     HAPPrecondition(storage->procedures);
-    HAPPrecondition(storage->numProcedures >= 1);
+    HAPPrecondition(storage->numProcedures >= numSessions);
     HAPPrecondition(storage->procedureBuffer.bytes);
-    HAPPrecondition(storage->procedureBuffer.numBytes >= 1);
+    HAPPrecondition(storage->procedureBuffer.numBytes >= numSessions);
     HAPRawBufferZero(storage->gattTableElements, storage->numGATTTableElements * sizeof *storage->gattTableElements);
     HAPRawBufferZero(
             storage->sessionCacheElements, storage->numSessionCacheElements * sizeof *storage->sessionCacheElements);
-    HAPRawBufferZero(storage->session, sizeof *storage->session);
+    HAPRawBufferZero(storage->session, numSessions * sizeof *storage->session);
     HAPRawBufferZero(storage->procedures, storage->numProcedures * sizeof *storage->procedures);
     HAPRawBufferZero(storage->procedureBuffer.bytes, storage->procedureBuffer.numBytes);
     server->ble.storage = storage;
+    server->ble.numSessions = (uint8_t) numSessions;
 
     // Copy advertising configuration.
     HAPPrecondition(options->ble.preferredAdvertisingInterval >= kHAPBLEAdvertisingInterval_Minimum);
@@ -65,9 +71,8 @@ static void PrepareStart(HAPAccessoryServerRef* server_) {
 
     HAPBLEAccessoryServerStorage* storage = HAPNonnull(server->ble.storage);
     HAPRawBufferZero(storage->gattTableElements, storage->numGATTTableElements * sizeof *storage->gattTableElements);
-    HAPRawBufferZero(
-            storage->sessionCacheElements, storage->numSessionCacheElements * sizeof *storage->sessionCacheElements);
-    HAPRawBufferZero(storage->session, sizeof *storage->session);
+    HAPPairingBLESessionCacheInvalidateAllEntries(server_);
+    HAPRawBufferZero(storage->session, server->ble.numSessions * sizeof *storage->session);
     HAPRawBufferZero(storage->procedures, storage->numProcedures * sizeof *storage->procedures);
     HAPRawBufferZero(storage->procedureBuffer.bytes, storage->procedureBuffer.numBytes);
 }
@@ -109,6 +114,13 @@ static void Start(HAPAccessoryServerRef* server_) {
     HAPAssert(HAPStringGetNumBytes(primaryAccessory->name) <= 64);
     HAPPlatformBLEPeripheralManagerSetDeviceName(blePeripheralManager, primaryAccessory->name);
 
+    // Load persistent advertising state.
+    err = HAPBLEAccessoryServerLoadPersistentState(server_);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPFatalError();
+    }
+
     // Register GATT db.
     HAPBLEPeripheralManagerRegister(server_);
 }
@@ -123,16 +135,23 @@ static void TryStop(HAPAccessoryServerRef* server_, bool* didStop) {
     *didStop = false;
 
     // Close all connections.
-    if (server->ble.connection.connected) {
-        HAPSession* session = (HAPSession*) server->ble.storage->session;
+    bool isConnected = false;
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        const HAPBLEAccessoryServerConnection* connection = &server->ble.connections[i];
+        if (!connection->connected) {
+            continue;
+        }
+        HAPSession* session = (HAPSession*) HAPAccessoryServerGetBLESession(server_, i);
         if (HAPBLESessionIsSafeToDisconnect(&session->_.ble)) {
             HAPLogInfo(&logObject, "Disconnecting BLE connection - Server is shutting down.");
-            HAPPlatformBLEPeripheralManagerCancelCentralConnection(
-                    blePeripheralManager, server->ble.connection.connectionHandle);
+            HAPPlatformBLEPeripheralManagerCancelCentralConnection(blePeripheralManager, connection->connectionHandle);
         } else {
             HAPLogInfo(&logObject, "Waiting for pending BLE data to be written.");
         }
-        HAPLogInfo(&logObject, "Delaying shutdown. Waiting for BLE connection to terminate.");
+        isConnected = true;
+    }
+    if (isConnected) {
+        HAPLogInfo(&logObject, "Delaying shutdown. Waiting for BLE connections to terminate.");
         return;
     }
 
@@ -140,9 +159,48 @@ static void TryStop(HAPAccessoryServerRef* server_, bool* didStop) {
     HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
     HAPPlatformBLEPeripheralManagerSetDelegate(blePeripheralManager, NULL);
 
+    // Save GSN, so that reserved GSNs are not skipped after a restart.
+    HAPError err = HAPBLEAccessoryServerSaveGSN(server_);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        HAPLog(&logObject, "Failed to save GSN. GSNs reserved ahead of time will be skipped after a restart.");
+    }
+
     *didStop = true;
 }
 
+HAP_RESULT_USE_CHECK
+HAPSessionRef* HAPAccessoryServerGetBLESession(const HAPAccessoryServerRef* server_, size_t sessionIndex) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ble.storage);
+    HAPPrecondition(sessionIndex < server->ble.numSessions);
+
+    return &server->ble.storage->session[sessionIndex];
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPAccessoryServerGetBLESessionIndex(
+        const HAPAccessoryServerRef* server_,
+        const HAPSessionRef* session,
+        size_t* sessionIndex) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(session);
+    HAPPrecondition(sessionIndex);
+
+    if (!server->ble.storage) {
+        return false;
+    }
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        if (session == &server->ble.storage->session[i]) {
+            *sessionIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
 static void UpdateAdvertisingData(HAPAccessoryServerRef* server_) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
@@ -206,7 +264,8 @@ const HAPBLEAccessoryServerTransport kHAPAccessoryServerTransport_BLE = {
     .didRaiseEvent = HAPBLEAccessoryServerDidRaiseEvent,
     .updateAdvertisingData = UpdateAdvertisingData,
     .getGSN = HAPBLEAccessoryServerGetGSN,
-    .broadcast = { .expireKey = HAPBLEAccessoryServerBroadcastExpireKey },
+    .broadcast = { .expireKey = HAPBLEAccessoryServerBroadcastExpireKey,
+                   .purgeParameters = HAPBLEAccessoryServerBroadcastPurgeParameters },
     .peripheralManager = { .release = HAPBLEPeripheralManagerRelease,
                            .handleSessionAccept = HAPBLEPeripheralManagerHandleSessionAccept,
                            .handleSessionInvalidate = HAPBLEPeripheralManagerHandleSessionInvalidate },
@@ -38,12 +38,14 @@ struct HAPBLEAccessoryServerTransport {
 
     void (*updateAdvertisingData)(HAPAccessoryServerRef* server);
 
-    HAP_RESULT_USE_CHECK
-    HAPError (*getGSN)(HAPPlatformKeyValueStoreRef keyValueStore, HAPBLEAccessoryServerGSN* gsn);
+    void (*getGSN)(HAPAccessoryServerRef* server, HAPBLEAccessoryServerGSN* gsn);
 
     struct {
         HAP_RESULT_USE_CHECK
-        HAPError (*expireKey)(HAPPlatformKeyValueStoreRef keyValueStore);
+        HAPError (*expireKey)(HAPAccessoryServerRef* server);
+
+        HAP_RESULT_USE_CHECK
+        HAPError (*purgeParameters)(HAPAccessoryServerRef* server);
     } broadcast;
 
     struct {
@@ -131,93 +131,188 @@ static HAPError GetBroadcastConfiguration(
     return kHAPError_None;
 }
 
+/**
+ * Finds the broadcast configuration of a characteristic.
+ *
+ * @param      record               Broadcast configuration of the characteristics of an accessory.
+ * @param      cid                  Characteristic ID.
+ * @param[out] offset               Offset of the broadcast configuration of the characteristic, if found.
+ *                                  Otherwise, offset at which the broadcast configuration needs to be inserted.
+ *
+ * @return true                     If the characteristic has a broadcast configuration.
+ * @return false                    Otherwise.
+ */
 HAP_RESULT_USE_CHECK
-HAPError HAPBLECharacteristicGetBroadcastConfiguration(
-        const HAPCharacteristic* characteristic_,
-        const HAPService* service,
-        const HAPAccessory* accessory,
-        bool* broadcastsEnabled,
-        HAPBLECharacteristicBroadcastInterval* broadcastInterval,
-        HAPPlatformKeyValueStoreRef keyValueStore) {
-    HAPPrecondition(characteristic_);
-    const HAPBaseCharacteristic* characteristic = characteristic_;
-    HAPPrecondition(characteristic->properties.ble.supportsBroadcastNotification);
-    HAPPrecondition(service);
-    HAPPrecondition(accessory);
-    HAPPrecondition(broadcastsEnabled);
-    HAPPrecondition(broadcastInterval);
-    HAPPrecondition(keyValueStore);
+static bool FindCharacteristic(
+        const HAPBLECharacteristicBroadcastConfigurationRecord* record,
+        uint16_t cid,
+        size_t* offset) {
+    HAPPrecondition(record);
+    HAPPrecondition(record->numBytes >= 2 && !((record->numBytes - 2) % 3));
+    HAPPrecondition(offset);
+
+    // Configurations are sorted by characteristic ID.
+    size_t i;
+    for (i = 2; i < record->numBytes; i += 3) {
+        uint16_t itemCID = HAPReadLittleUInt16(&record->bytes[i]);
+        if (itemCID < cid) {
+            continue;
+        }
+        if (itemCID > cid) {
+            break;
+        }
+
+        *offset = i;
+        return true;
+    }
+    *offset = i;
+    return false;
+}
+
+/**
+ * Saves the broadcast configuration of the characteristics of an accessory.
+ *
+ * - The in-memory copy is only updated if the key-value store was updated successfully.
+ *
+ * @param      server               Accessory server.
+ * @param      record               Updated broadcast configuration.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SaveBroadcastConfiguration(
+        HAPAccessoryServer* server,
+        const HAPBLECharacteristicBroadcastConfigurationRecord* record) {
+    HAPPrecondition(server);
+    HAPPrecondition(record);
+    HAPPrecondition(record->numBytes >= 2 && !((record->numBytes - 2) % 3));
 
     HAPError err;
 
-    HAPAssert(accessory->aid == 1);
-    uint16_t aid = (uint16_t) accessory->aid;
-    HAPAssert(characteristic->iid <= UINT16_MAX);
-    uint16_t cid = (uint16_t) characteristic->iid;
+    if (record->numBytes == 2) {
+        err = HAPPlatformKeyValueStoreRemove(
+                server->platform.keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, record->key);
+    } else {
+        err = HAPPlatformKeyValueStoreSet(
+                server->platform.keyValueStore,
+                kHAPKeyValueStoreDomain_CharacteristicConfiguration,
+                record->key,
+                record->bytes,
+                record->numBytes);
+    }
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
+    }
+
+    HAPRawBufferCopyBytes(
+            &server->ble.persistentState.broadcastConfiguration,
+            record,
+            sizeof server->ble.persistentState.broadcastConfiguration);
+    if (record->numBytes == 2) {
+        server->ble.persistentState.broadcastConfiguration.numBytes = 0;
+    }
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLECharacteristicLoadBroadcastConfiguration(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    HAPBLECharacteristicBroadcastConfigurationRecord* record = &server->ble.persistentState.broadcastConfiguration;
+    HAPRawBufferZero(record, sizeof *record);
 
     // Get configuration.
+    // Only accessory ID 1 is supported on Bluetooth LE.
     HAPPlatformKeyValueStoreKey key;
     size_t numBytes;
-    uint8_t bytes[2 + 3 * 42 + 1]; // 128 + 1, allows for 42 concurrent broadcasts on a single KVS key.
+    uint8_t bytes[kHAPBLECharacteristicBroadcastConfiguration_MaxBytes + 1];
     bool found;
-    err = GetBroadcastConfiguration(aid, &found, bytes, sizeof bytes, &numBytes, &key, keyValueStore);
+    err = GetBroadcastConfiguration(1, &found, bytes, sizeof bytes, &numBytes, &key, server->platform.keyValueStore);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
     }
     if (!found) {
-        *broadcastsEnabled = false;
         return kHAPError_None;
     }
-    HAPAssert(numBytes >= 2 && !((numBytes - 2) % 3));
-    HAPAssert(HAPReadLittleUInt16(bytes) == aid);
+    HAPAssert(numBytes >= 2 && numBytes <= sizeof record->bytes && !((numBytes - 2) % 3));
+    HAPAssert(HAPReadLittleUInt16(bytes) == 1);
 
-    // Find characteristic.
+    // Validate configuration.
     for (size_t i = 2; i < numBytes; i += 3) {
-        uint16_t itemCID = HAPReadLittleUInt16(&bytes[i]);
-        if (itemCID < cid) {
-            continue;
-        }
-        if (itemCID > cid) {
-            break;
-        }
-
-        // Found. Extract configuration.
         uint8_t broadcastConfiguration = bytes[i + 2];
         if (!HAPBLECharacteristicIsValidBroadcastInterval(broadcastConfiguration)) {
-            HAPLogCharacteristic(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Invalid stored broadcast interval: 0x%02x.",
-                    broadcastConfiguration);
+            HAPLog(&logObject,
+                   "Invalid stored broadcast interval for characteristic 0x%04X: 0x%02x.",
+                   HAPReadLittleUInt16(&bytes[i]),
+                   broadcastConfiguration);
             return kHAPError_Unknown;
         }
-        *broadcastsEnabled = true;
-        *broadcastInterval = (HAPBLECharacteristicBroadcastInterval) broadcastConfiguration;
-        return kHAPError_None;
     }
 
-    // Not found.
-    *broadcastsEnabled = false;
+    HAPRawBufferCopyBytes(record->bytes, bytes, numBytes);
+    record->numBytes = (uint8_t) numBytes;
+    record->key = key;
     return kHAPError_None;
 }
 
+void HAPBLECharacteristicGetBroadcastConfiguration(
+        const HAPCharacteristic* characteristic_,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        bool* broadcastsEnabled,
+        HAPBLECharacteristicBroadcastInterval* broadcastInterval,
+        HAPAccessoryServerRef* server_) {
+    HAPPrecondition(characteristic_);
+    const HAPBaseCharacteristic* characteristic = characteristic_;
+    HAPPrecondition(characteristic->properties.ble.supportsBroadcastNotification);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(broadcastsEnabled);
+    HAPPrecondition(broadcastInterval);
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+
+    HAPAssert(accessory->aid == 1);
+    HAPAssert(characteristic->iid <= UINT16_MAX);
+    uint16_t cid = (uint16_t) characteristic->iid;
+
+    // Find characteristic.
+    const HAPBLECharacteristicBroadcastConfigurationRecord* record =
+            &server->ble.persistentState.broadcastConfiguration;
+    size_t i;
+    if (!record->numBytes || !FindCharacteristic(record, cid, &i)) {
+        *broadcastsEnabled = false;
+        return;
+    }
+
+    // Found. Extract configuration.
+    uint8_t broadcastConfiguration = record->bytes[i + 2];
+    HAPAssert(HAPBLECharacteristicIsValidBroadcastInterval(broadcastConfiguration));
+    *broadcastsEnabled = true;
+    *broadcastInterval = (HAPBLECharacteristicBroadcastInterval) broadcastConfiguration;
+}
+
 HAP_RESULT_USE_CHECK
 HAPError HAPBLECharacteristicEnableBroadcastNotifications(
         const HAPCharacteristic* characteristic_,
         const HAPService* service,
         const HAPAccessory* accessory,
         HAPBLECharacteristicBroadcastInterval broadcastInterval,
-        HAPPlatformKeyValueStoreRef keyValueStore) {
+        HAPAccessoryServerRef* server_) {
     HAPPrecondition(characteristic_);
     const HAPBaseCharacteristic* characteristic = characteristic_;
     HAPPrecondition(characteristic->properties.ble.supportsBroadcastNotification);
     HAPPrecondition(service);
     HAPPrecondition(accessory);
     HAPPrecondition(HAPBLECharacteristicIsValidBroadcastInterval(broadcastInterval));
-    HAPPrecondition(keyValueStore);
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
 
     HAPError err;
 
@@ -235,77 +330,42 @@ HAPError HAPBLECharacteristicEnableBroadcastNotifications(
     uint16_t cid = (uint16_t) characteristic->iid;
 
     // Get configuration.
-    HAPPlatformKeyValueStoreKey key;
-    size_t numBytes;
-    uint8_t bytes[2 + 3 * 42 + 1]; // 128 + 1, allows for 42 concurrent broadcasts on a single KVS key.
-    bool found;
-    err = GetBroadcastConfiguration(aid, &found, bytes, sizeof bytes, &numBytes, &key, keyValueStore);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-    if (!found) {
-        key = 0;
-        HAPWriteLittleUInt16(bytes, aid);
-        numBytes = 2;
+    HAPBLECharacteristicBroadcastConfigurationRecord record;
+    HAPRawBufferCopyBytes(&record, &server->ble.persistentState.broadcastConfiguration, sizeof record);
+    if (!record.numBytes) {
+        record.key = 0;
+        HAPWriteLittleUInt16(record.bytes, aid);
+        record.numBytes = 2;
     }
-    HAPAssert(numBytes >= 2 && !((numBytes - 2) % 3));
-    HAPAssert(HAPReadLittleUInt16(bytes) == aid);
+    HAPAssert(HAPReadLittleUInt16(record.bytes) == aid);
 
     // Find characteristic.
     size_t i;
-    for (i = 2; i < numBytes; i += 3) {
-        uint16_t itemCID = HAPReadLittleUInt16(&bytes[i]);
-        if (itemCID < cid) {
-            continue;
-        }
-        if (itemCID > cid) {
-            break;
+    if (FindCharacteristic(&record, cid, &i)) {
+        // Update configuration.
+        if ((HAPBLECharacteristicBroadcastInterval) record.bytes[i + 2] == broadcastInterval) {
+            return kHAPError_None;
         }
-
-        // Found. Extract configuration.
-        uint8_t broadcastConfiguration = bytes[i + 2];
-        if (!HAPBLECharacteristicIsValidBroadcastInterval(broadcastConfiguration)) {
+        record.bytes[i + 2] = broadcastInterval;
+    } else {
+        // Add configuration.
+        if (record.numBytes + 3 > sizeof record.bytes) {
             HAPLogCharacteristic(
                     &logObject,
                     characteristic,
                     service,
                     accessory,
-                    "Invalid stored broadcast interval: 0x%02x.",
-                    broadcastConfiguration);
+                    "Not enough space to store characteristic configuration.");
             return kHAPError_Unknown;
         }
-
-        // Update configuration.
-        if ((HAPBLECharacteristicBroadcastInterval) broadcastConfiguration == broadcastInterval) {
-            return kHAPError_None;
-        }
-        bytes[i + 2] = broadcastInterval;
-        err = HAPPlatformKeyValueStoreSet(
-                keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key, bytes, numBytes);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
-        return kHAPError_None;
+        HAPRawBufferCopyBytes(&record.bytes[i + 3], &record.bytes[i], record.numBytes - i);
+        HAPWriteLittleUInt16(&record.bytes[i], cid);
+        record.bytes[i + 2] = broadcastInterval;
+        record.numBytes += 3;
     }
 
-    // Add configuration.
-    if (numBytes >= sizeof bytes - 1 - 3) {
-        HAPLogCharacteristic(
-                &logObject,
-                characteristic,
-                service,
-                accessory,
-                "Not enough space to store characteristic configuration.");
-        return kHAPError_Unknown;
-    }
-    HAPRawBufferCopyBytes(&bytes[i + 3], &bytes[i], numBytes - i);
-    HAPWriteLittleUInt16(&bytes[i], cid);
-    bytes[i + 2] = broadcastInterval;
-    numBytes += 3;
-    err = HAPPlatformKeyValueStoreSet(
-            keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key, bytes, numBytes);
+    // Save configuration.
+    err = SaveBroadcastConfiguration(server, &record);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
         return err;
@@ -318,78 +378,45 @@ HAPError HAPBLECharacteristicDisableBroadcastNotifications(
         const HAPCharacteristic* characteristic_,
         const HAPService* service,
         const HAPAccessory* accessory,
-        HAPPlatformKeyValueStoreRef keyValueStore) {
+        HAPAccessoryServerRef* server_) {
     HAPPrecondition(characteristic_);
     const HAPBaseCharacteristic* characteristic = characteristic_;
     HAPPrecondition(characteristic->properties.ble.supportsBroadcastNotification);
     HAPPrecondition(service);
     HAPPrecondition(accessory);
-    HAPPrecondition(keyValueStore);
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
 
     HAPError err;
 
     HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Disabling broadcasts.");
 
     HAPAssert(accessory->aid == 1);
-    uint16_t aid = (uint16_t) accessory->aid;
     HAPAssert(characteristic->iid <= UINT16_MAX);
     uint16_t cid = (uint16_t) characteristic->iid;
 
     // Get configuration.
-    HAPPlatformKeyValueStoreKey key;
-    size_t numBytes;
-    uint8_t bytes[2 + 3 * 42 + 1]; // 128 + 1, allows for 42 concurrent broadcasts on a single KVS key.
-    bool found;
-    err = GetBroadcastConfiguration(aid, &found, bytes, sizeof bytes, &numBytes, &key, keyValueStore);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        return err;
-    }
-    if (!found) {
+    HAPBLECharacteristicBroadcastConfigurationRecord record;
+    HAPRawBufferCopyBytes(&record, &server->ble.persistentState.broadcastConfiguration, sizeof record);
+    if (!record.numBytes) {
         return kHAPError_None;
     }
-    HAPAssert(numBytes >= 2 && !((numBytes - 2) % 3));
-    HAPAssert(HAPReadLittleUInt16(bytes) == aid);
 
     // Find characteristic.
     size_t i;
-    for (i = 2; i < numBytes; i += 3) {
-        uint16_t itemCID = HAPReadLittleUInt16(&bytes[i]);
-        if (itemCID < cid) {
-            continue;
-        }
-        if (itemCID > cid) {
-            break;
-        }
+    if (!FindCharacteristic(&record, cid, &i)) {
+        return kHAPError_None;
+    }
 
-        // Found. Extract configuration.
-        uint8_t broadcastConfiguration = bytes[i + 2];
-        if (!HAPBLECharacteristicIsValidBroadcastInterval(broadcastConfiguration)) {
-            HAPLogCharacteristic(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Invalid stored broadcast interval: 0x%02x.",
-                    broadcastConfiguration);
-            return kHAPError_Unknown;
-        }
+    // Remove configuration.
+    record.numBytes -= 3;
+    HAPRawBufferCopyBytes(&record.bytes[i], &record.bytes[i + 3], record.numBytes - i);
 
-        // Remove configuration.
-        numBytes -= 3;
-        HAPRawBufferCopyBytes(&bytes[i], &bytes[i + 3], numBytes - i);
-        if (numBytes == 2) {
-            err = HAPPlatformKeyValueStoreRemove(
-                    keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key);
-        } else {
-            err = HAPPlatformKeyValueStoreSet(
-                    keyValueStore, kHAPKeyValueStoreDomain_CharacteristicConfiguration, key, bytes, numBytes);
-        }
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            return err;
-        }
-        return kHAPError_None;
+    // Save configuration.
+    err = SaveBroadcastConfiguration(server, &record);
+    if (err) {
+        HAPAssert(err == kHAPError_Unknown);
+        return err;
     }
     return kHAPError_None;
 }
@@ -33,6 +33,32 @@ HAP_ENUM_BEGIN(uint8_t, HAPBLECharacteristicBroadcastInterval) { /** 20 ms (Defa
                                                                  kHAPBLECharacteristicBroadcastInterval_2560Ms = 0x03
 } HAP_ENUM_END(uint8_t, HAPBLECharacteristicBroadcastInterval);
 
+/**
+ * Maximum length of the broadcast configuration of an accessory.
+ *
+ * - Allows for 42 concurrent broadcasts on a single KVS key.
+ */
+#define kHAPBLECharacteristicBroadcastConfiguration_MaxBytes ((size_t)(2 + 3 * 42))
+
+/**
+ * Broadcast configuration of the characteristics of an accessory.
+ *
+ * - In-memory copy of the characteristic configuration in the key-value store.
+ */
+typedef struct {
+    /** Characteristic configuration. Format: see kHAPKeyValueStoreDomain_CharacteristicConfiguration. */
+    uint8_t bytes[kHAPBLECharacteristicBroadcastConfiguration_MaxBytes];
+
+    /** Length of the characteristic configuration. 0 if no characteristic configuration is stored. */
+    uint8_t numBytes;
+
+    /** Key of the characteristic configuration, if stored. */
+    HAPPlatformKeyValueStoreKey key;
+} HAPBLECharacteristicBroadcastConfigurationRecord;
+HAP_STATIC_ASSERT(
+        kHAPBLECharacteristicBroadcastConfiguration_MaxBytes <= UINT8_MAX,
+        HAPBLECharacteristicBroadcastConfigurationRecord);
+
 /**
  * Checks whether a value represents a valid broadcast interval.
  *
@@ -44,6 +70,19 @@ HAP_ENUM_BEGIN(uint8_t, HAPBLECharacteristicBroadcastInterval) { /** 20 ms (Defa
 HAP_RESULT_USE_CHECK
 bool HAPBLECharacteristicIsValidBroadcastInterval(uint8_t value);
 
+/**
+ * Loads the broadcast configuration of the characteristics from the key-value store.
+ *
+ * - This must be called when the accessory server starts. Afterwards, the configuration is kept in memory.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If an I/O error occurred.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLECharacteristicLoadBroadcastConfiguration(HAPAccessoryServerRef* server);
+
 /**
  * Gets the broadcast configuration of a characteristic.
  *
@@ -52,22 +91,18 @@ bool HAPBLECharacteristicIsValidBroadcastInterval(uint8_t value);
  * @param      accessory            The accessory that provides the service.
  * @param[out] broadcastsEnabled    Whether broadcast notifications are enabled.
  * @param[out] broadcastInterval    Broadcast interval, if broadcast notifications are enabled.
- * @param      keyValueStore        Key-value store.
- *
- * @return kHAPError_None           If successful.
- * @return kHAPError_Unknown        If an I/O error occurred.
+ * @param      server               Accessory server.
  *
  * @see HomeKit Accessory Protocol Specification R14
  *      Section 7.3.5.8 HAP Characteristic Configuration Procedure
  */
-HAP_RESULT_USE_CHECK
-HAPError HAPBLECharacteristicGetBroadcastConfiguration(
+void HAPBLECharacteristicGetBroadcastConfiguration(
         const HAPCharacteristic* characteristic,
         const HAPService* service,
         const HAPAccessory* accessory,
         bool* broadcastsEnabled,
         HAPBLECharacteristicBroadcastInterval* broadcastInterval,
-        HAPPlatformKeyValueStoreRef keyValueStore);
+        HAPAccessoryServerRef* server);
 
 /**
  * Enables broadcasts for a characteristic.
@@ -76,7 +111,7 @@ HAPError HAPBLECharacteristicGetBroadcastConfiguration(
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
  * @param      broadcastInterval    Broadcast interval.
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
@@ -90,7 +125,7 @@ HAPError HAPBLECharacteristicEnableBroadcastNotifications(
         const HAPService* service,
         const HAPAccessory* accessory,
         HAPBLECharacteristicBroadcastInterval broadcastInterval,
-        HAPPlatformKeyValueStoreRef keyValueStore);
+        HAPAccessoryServerRef* server);
 
 /**
  * Disables broadcasts for a characteristic.
@@ -98,7 +133,7 @@ HAPError HAPBLECharacteristicEnableBroadcastNotifications(
  * @param      characteristic       Characteristic. Characteristic must support broadcasts.
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
@@ -111,7 +146,7 @@ HAPError HAPBLECharacteristicDisableBroadcastNotifications(
         const HAPCharacteristic* characteristic,
         const HAPService* service,
         const HAPAccessory* accessory,
-        HAPPlatformKeyValueStoreRef keyValueStore);
+        HAPAccessoryServerRef* server);
 
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
@@ -24,7 +24,7 @@ extern "C" {
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
  * @param      requestReader        Reader to parse Characteristic Configuration from. Reader content becomes invalid.
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
@@ -39,7 +39,7 @@ HAPError HAPBLECharacteristicHandleConfigurationRequest(
         const HAPService* service,
         const HAPAccessory* accessory,
         HAPTLVReaderRef* requestReader,
-        HAPPlatformKeyValueStoreRef keyValueStore);
+        HAPAccessoryServerRef* server);
 
 /**
  * Serializes the body of a HAP-Characteristic-Configuration-Response.
@@ -48,7 +48,7 @@ HAPError HAPBLECharacteristicHandleConfigurationRequest(
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
  * @param      responseWriter       Writer to serialize Characteristic Configuration into.
- * @param      keyValueStore        Key-value store.
+ * @param      server               Accessory server.
  *
  * @return kHAPError_None           If successful.
  * @return kHAPError_Unknown        If an I/O error occurred.
@@ -63,7 +63,7 @@ HAPError HAPBLECharacteristicGetConfigurationResponse(
         const HAPService* service,
         const HAPAccessory* accessory,
         HAPTLVWriterRef* responseWriter,
-        HAPPlatformKeyValueStoreRef keyValueStore);
+        HAPAccessoryServerRef* server);
 
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
@@ -48,6 +48,9 @@ typedef struct {
 
     /** Status of the procedure. */
     HAPBLEFallbackProcedureStatus status;
+
+    /** Index of the connection that uses the procedure. */
+    uint8_t connectionIndex;
 } HAPBLEFallbackProcedure;
 
 HAP_STATIC_ASSERT(sizeof(HAPBLEFallbackProcedure) <= 16, HAPBLEFallbackProcedureMustBeKeptSmall);
@@ -96,42 +99,70 @@ typedef struct {
     HAPPlatformBLEPeripheralManagerAttributeHandle iidHandle;
 
     /**
-     * State related about the connected controller.
+     * State related about the connected controllers.
+     *
+     * - Per-connection state is kept in bit masks. Bit i refers to the connection at index i.
      */
     struct {
         /**
          * Fallback procedure in case there are not enough resources to use a full-featured one.
+         *
+         * - The fallback procedure of a characteristic can only be used by one connection at a time.
          */
         HAPBLEFallbackProcedure fallbackProcedure;
 
         /**
-         * Whether or not the connected central subscribed to this characteristic.
+         * Connections whose central subscribed to this characteristic.
          *
          * - This is only available for HomeKit characteristics that support HAP Events.
          */
-        bool centralSubscribed : 1;
+        uint8_t subscribedConnections;
 
         /**
-         * Whether or not the characteristic value changed since the last read by the connected controller.
+         * Connections for which the characteristic value changed since the last read by their controller.
          *
          * - This is only maintained for HomeKit characteristics that support HAP Events.
+         * - Characteristics with a pending event are linked into one of the pending event queues.
          */
-        bool pendingEvent : 1;
+        uint8_t pendingEventConnections;
+
+        /** Next BLE GATT table element in the same pending event queue (index + 1). 0 if last. */
+        uint16_t nextPendingEvent;
     } connectionState;
 } HAPBLEGATTTableElement;
 HAP_STATIC_ASSERT(sizeof(HAPBLEGATTTableElementRef) >= sizeof(HAPBLEGATTTableElement), HAPBLEGATTTableElement);
+HAP_STATIC_ASSERT(kHAPBLESessions_MaxElements <= 8, HAPBLEGATTTableElement_ConnectionBitMasks);
 HAP_NONNULL_SUPPORT(HAPBLEGATTTableElement)
 
 /**
- * Resets the state of HAP Events.
+ * Gets the bit that refers to a connection in the per-connection bit masks of a GATT attribute structure.
+ *
+ * @param      connectionIndex      Index of the connection.
+ *
+ * @return Bit mask with the bit of the connection set.
+ */
+HAP_RESULT_USE_CHECK
+static uint8_t GetConnectionMask(size_t connectionIndex) {
+    HAPPrecondition(connectionIndex < kHAPBLESessions_MaxElements);
+
+    return (uint8_t)(1U << connectionIndex);
+}
+
+/**
+ * Resets the state of HAP Events of a connection.
+ *
+ * - Events that are still pending for other connections stay queued in their position.
  *
  * @param      server_              Accessory server.
+ * @param      connectionIndex      Index of the connection.
  */
-static void ResetEventState(HAPAccessoryServerRef* server_) {
+static void ResetEventState(HAPAccessoryServerRef* server_, size_t connectionIndex) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(connectionIndex < server->ble.numSessions);
+    uint8_t connectionMask = GetConnectionMask(connectionIndex);
 
-    HAPLogDebug(&logObject, "%s", __func__);
+    HAPLogDebug(&logObject, "%s(%zu)", __func__, connectionIndex);
 
     for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
         HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
@@ -140,21 +171,79 @@ static void ResetEventState(HAPAccessoryServerRef* server_) {
             break;
         }
 
-        gattAttribute->connectionState.centralSubscribed = false;
-        gattAttribute->connectionState.pendingEvent = false;
+        gattAttribute->connectionState.subscribedConnections &= (uint8_t) ~connectionMask;
+    }
+
+    for (size_t priority = 0; priority < HAPArrayCount(server->ble.pendingEvents.queues); priority++) {
+        uint16_t previous = 0;
+        uint16_t* link = &server->ble.pendingEvents.queues[priority].first;
+        while (*link) {
+            HAPAssert(*link <= server->ble.storage->numGATTTableElements);
+            HAPBLEGATTTableElement* gattAttribute =
+                    (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[*link - 1U];
+            gattAttribute->connectionState.pendingEventConnections &= (uint8_t) ~connectionMask;
+            if (gattAttribute->connectionState.pendingEventConnections) {
+                previous = *link;
+                link = &gattAttribute->connectionState.nextPendingEvent;
+            } else {
+                *link = gattAttribute->connectionState.nextPendingEvent;
+                gattAttribute->connectionState.nextPendingEvent = 0;
+            }
+        }
+        server->ble.pendingEvents.queues[priority].last = previous;
+    }
+}
+
+/**
+ * HAP event priority.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPBLEEventPriority) {
+    /** Security system, lock and switch events. */
+    kHAPBLEEventPriority_Urgent,
+
+    /** Other events. */
+    kHAPBLEEventPriority_Normal
+} HAP_ENUM_END(uint8_t, HAPBLEEventPriority);
+
+/**
+ * Determines the priority of HAP events for a characteristic.
+ *
+ * - Changes of security system and lock state and programmable switch events are time critical
+ *   and should not queue up behind bulk state changes of other characteristics.
+ *
+ * @param      characteristic       Characteristic.
+ *
+ * @return Priority of HAP events for the characteristic.
+ */
+HAP_RESULT_USE_CHECK
+static HAPBLEEventPriority GetEventPriority(const HAPBaseCharacteristic* characteristic) {
+    HAPPrecondition(characteristic);
+
+    static const HAPUUID* const urgentCharacteristicTypes[] = { &kHAPCharacteristicType_SecuritySystemCurrentState,
+                                                                &kHAPCharacteristicType_SecuritySystemAlarmType,
+                                                                &kHAPCharacteristicType_LockCurrentState,
+                                                                &kHAPCharacteristicType_LockLastKnownAction,
+                                                                &kHAPCharacteristicType_ProgrammableSwitchEvent };
+    for (size_t i = 0; i < HAPArrayCount(urgentCharacteristicTypes); i++) {
+        if (HAPUUIDAreEqual(characteristic->characteristicType, urgentCharacteristicTypes[i])) {
+            return kHAPBLEEventPriority_Urgent;
+        }
     }
+    return kHAPBLEEventPriority_Normal;
 }
 
 /**
- * Aborts all fallback HAP-BLE procedures.
+ * Aborts all fallback HAP-BLE procedures of a connection.
  *
  * @param      server_              Accessory server.
+ * @param      connectionIndex      Index of the connection.
  */
-static void AbortAllFallbackProcedures(HAPAccessoryServerRef* server_) {
+static void AbortAllFallbackProcedures(HAPAccessoryServerRef* server_, size_t connectionIndex) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(connectionIndex < server->ble.numSessions);
 
-    HAPLogDebug(&logObject, "%s", __func__);
+    HAPLogDebug(&logObject, "%s(%zu)", __func__, connectionIndex);
 
     for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
         HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
@@ -163,7 +252,8 @@ static void AbortAllFallbackProcedures(HAPAccessoryServerRef* server_) {
             break;
         }
 
-        if (gattAttribute->connectionState.fallbackProcedure.timer) {
+        if (gattAttribute->connectionState.fallbackProcedure.timer &&
+            gattAttribute->connectionState.fallbackProcedure.connectionIndex == connectionIndex) {
             const HAPAccessory* accessory = gattAttribute->accessory;
             HAPAssert(gattAttribute->service);
             HAPAssert(gattAttribute->characteristic);
@@ -189,24 +279,62 @@ void HAPBLEPeripheralManagerRelease(HAPAccessoryServerRef* server_) {
     HAPPlatformBLEPeripheralManager* blePeripheralManager = server->platform.ble.blePeripheralManager;
 
     // Abort procedures.
-    AbortAllFallbackProcedures(server_);
-    if (server->ble.connection.procedureAttached) {
-        HAPBLEProcedureDestroy(&server->ble.storage->procedures[0]);
-        server->ble.connection.procedureAttached = false;
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        HAPBLEAccessoryServerConnection* connection = &server->ble.connections[i];
+        AbortAllFallbackProcedures(server_, i);
+        if (connection->procedureAttached) {
+            HAPBLEProcedureDestroy(&server->ble.storage->procedures[i]);
+            connection->procedureAttached = false;
+        }
     }
 
     // Abort connections.
-    if (server->ble.connection.connected) {
-        HAPAssert(server->ble.storage->session);
-        HAPSessionRelease(server_, server->ble.storage->session);
-        server->ble.connection.connected = false;
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        HAPBLEAccessoryServerConnection* connection = &server->ble.connections[i];
+        if (connection->connected) {
+            HAPSessionRelease(server_, HAPAccessoryServerGetBLESession(server_, i));
+            connection->connected = false;
+        }
     }
 
+    HAPRawBufferZero(&server->ble.pendingEvents, sizeof server->ble.pendingEvents);
+
     // Deregister platform callbacks.
     HAPPlatformBLEPeripheralManagerRemoveAllServices(blePeripheralManager);
+    HAPRawBufferZero(&server->ble.gattHandleTable, sizeof server->ble.gattHandleTable);
+    HAPBLESignatureCacheRelease(server_);
     HAPPlatformBLEPeripheralManagerSetDelegate(blePeripheralManager, NULL);
 }
 
+/**
+ * Finds the connection of a connected central.
+ *
+ * @param      server_              Accessory server.
+ * @param      connectionHandle     Connection handle of the central.
+ * @param[out] connectionIndex      Index of the connection, if found.
+ *
+ * @return true                     If the central is connected.
+ * @return false                    Otherwise, e.g., if the central has been rejected because all sessions were in use.
+ */
+HAP_RESULT_USE_CHECK
+static bool FindConnection(
+        HAPAccessoryServerRef* server_,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        size_t* connectionIndex) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(connectionIndex);
+
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        const HAPBLEAccessoryServerConnection* connection = &server->ble.connections[i];
+        if (connection->connected && connection->connectionHandle == connectionHandle) {
+            *connectionIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
 static void HandleConnectedCentral(
         HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
         HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
@@ -215,23 +343,50 @@ static void HandleConnectedCentral(
     HAPPrecondition(context);
     HAPAccessoryServerRef* server_ = context;
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
-    HAPPrecondition(server->ble.storage->session);
-    HAPSessionRef* session = server->ble.storage->session;
 
     HAPError err;
 
     HAPLogInfo(&logObject, "%s(0x%04x)", __func__, connectionHandle);
-    HAPPrecondition(!server->ble.connection.connected);
-
-    AbortAllFallbackProcedures(server_);
-    ResetEventState(server_);
-    server->ble.connection.connectionHandle = connectionHandle;
-    server->ble.connection.connected = true;
-
-    err = HAPBLEAccessoryServerDidConnect(server_);
-    if (err) {
-        HAPAssert(err == kHAPError_Unknown);
-        HAPFatalError();
+    size_t connectionIndex;
+    HAPPrecondition(!FindConnection(server_, connectionHandle, &connectionIndex));
+
+    // Find unused session.
+    size_t numConnections = 0;
+    connectionIndex = server->ble.numSessions;
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        if (server->ble.connections[i].connected) {
+            numConnections++;
+        } else if (connectionIndex == server->ble.numSessions) {
+            connectionIndex = i;
+        }
+    }
+    if (connectionIndex == server->ble.numSessions) {
+        HAPLog(&logObject,
+               "Rejecting connection 0x%04x: All %u BLE sessions are in use.",
+               connectionHandle,
+               server->ble.numSessions);
+        HAPPlatformBLEPeripheralManagerCancelCentralConnection(blePeripheralManager, connectionHandle);
+        return;
+    }
+    HAPBLEAccessoryServerConnection* connection = &server->ble.connections[connectionIndex];
+    HAPSessionRef* session = HAPAccessoryServerGetBLESession(server_, connectionIndex);
+
+    AbortAllFallbackProcedures(server_, connectionIndex);
+    ResetEventState(server_, connectionIndex);
+    connection->connectionHandle = connectionHandle;
+    connection->mtu = 0;
+    connection->connected = true;
+
+    // Advertising state only tracks whether any central is connected.
+    // Advertising is stopped once all sessions are in use.
+    if (!numConnections) {
+        err = HAPBLEAccessoryServerDidConnect(server_);
+        if (err) {
+            HAPAssert(err == kHAPError_Unknown);
+            HAPFatalError();
+        }
+    } else {
+        HAPAccessoryServerUpdateAdvertisingData(server_);
     }
 
     HAPSessionCreate(server_, session, kHAPTransportType_BLE);
@@ -245,25 +400,35 @@ static void HandleDisconnectedCentral(
     HAPPrecondition(context);
     HAPAccessoryServerRef* server_ = context;
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
-    HAPPrecondition(server->ble.storage->session);
-    HAPSessionRef* session = server->ble.storage->session;
 
     HAPError err;
 
     HAPLogInfo(&logObject, "%s(0x%04x)", __func__, connectionHandle);
-    HAPPrecondition(server->ble.connection.connected);
-    HAPPrecondition(connectionHandle == server->ble.connection.connectionHandle);
+    size_t connectionIndex;
+    if (!FindConnection(server_, connectionHandle, &connectionIndex)) {
+        HAPLog(&logObject, "Ignoring disconnection of rejected connection 0x%04x.", connectionHandle);
+        return;
+    }
+    HAPBLEAccessoryServerConnection* connection = &server->ble.connections[connectionIndex];
+    HAPSessionRef* session = HAPAccessoryServerGetBLESession(server_, connectionIndex);
 
-    server->ble.connection.connected = false;
-    if (server->ble.connection.procedureAttached) {
-        HAPAssert(server->ble.storage->numProcedures >= 1);
-        HAPBLEProcedureDestroy(&server->ble.storage->procedures[0]);
+    connection->connected = false;
+    if (connection->procedureAttached) {
+        HAPBLEProcedureDestroy(&server->ble.storage->procedures[connectionIndex]);
     }
-    AbortAllFallbackProcedures(server_);
+    AbortAllFallbackProcedures(server_, connectionIndex);
     HAPSessionRelease(server_, session);
-    ResetEventState(server_);
-    HAPRawBufferZero(&server->ble.connection, sizeof server->ble.connection);
-
+    ResetEventState(server_, connectionIndex);
+    HAPRawBufferZero(connection, sizeof *connection);
+
+    // Advertising state only tracks whether any central is connected.
+    // Advertising is resumed once a session is no longer in use.
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        if (server->ble.connections[i].connected) {
+            HAPAccessoryServerUpdateAdvertisingData(server_);
+            return;
+        }
+    }
     err = HAPBLEAccessoryServerDidDisconnect(server_);
     if (err) {
         HAPAssert(err == kHAPError_Unknown);
@@ -271,114 +436,294 @@ static void HandleDisconnectedCentral(
     }
 }
 
+static void HandleUpdatedMTU(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        uint16_t mtu,
+        void* _Nullable context) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(context);
+    HAPAccessoryServerRef* server_ = context;
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(mtu >= kHAPPlatformBLEPeripheralManager_MinMTU);
+
+    HAPLogInfo(&logObject, "%s(0x%04x, %u)", __func__, connectionHandle, mtu);
+    size_t connectionIndex;
+    if (!FindConnection(server_, connectionHandle, &connectionIndex)) {
+        return;
+    }
+
+    server->ble.connections[connectionIndex].mtu = mtu;
+}
+
 /**
- * Continues sending of pending HAP event notifications.
+ * Continues sending of pending HAP event notifications to a connection.
+ *
+ * - Pending events are sent in order of priority, and in the order in which they were raised within a priority.
+ *   Events for characteristics to which the controller has not subscribed, or whose values may only be delivered to
+ *   admin controllers, are dropped for the connection.
+ *
+ * - An event is dequeued once it has been sent to or dropped for all connections for which it is pending.
  *
  * @param      server_              Accessory server.
+ * @param      connectionIndex      Index of the connection.
  */
-static void SendPendingEventNotifications(HAPAccessoryServerRef* server_) {
+static void SendPendingEventNotifications(HAPAccessoryServerRef* server_, size_t connectionIndex) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(server->platform.ble.blePeripheralManager);
     HAPPlatformBLEPeripheralManagerRef blePeripheralManager = server->platform.ble.blePeripheralManager;
-    HAPPrecondition(server->ble.connection.connected);
-    HAPPrecondition(server->ble.storage->session);
-    HAPSessionRef* session = server->ble.storage->session;
+    HAPPrecondition(connectionIndex < server->ble.numSessions);
+    const HAPBLEAccessoryServerConnection* connection = &server->ble.connections[connectionIndex];
+    HAPPrecondition(connection->connected);
+    HAPSessionRef* session = HAPAccessoryServerGetBLESession(server_, connectionIndex);
+    uint8_t connectionMask = GetConnectionMask(connectionIndex);
 
     HAPError err;
 
-    for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
-        HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
-        const HAPBaseCharacteristic* characteristic = gattAttribute->characteristic;
-        const HAPService* service = gattAttribute->service;
-        const HAPAccessory* accessory = gattAttribute->accessory;
-        if (!accessory) {
-            break;
-        }
-        HAPAssert(service);
-        if (!characteristic) {
-            continue;
+    for (size_t priority = 0; priority < HAPArrayCount(server->ble.pendingEvents.queues); priority++) {
+        uint16_t previous = 0;
+        uint16_t* link = &server->ble.pendingEvents.queues[priority].first;
+        while (*link) {
+            HAPAssert(*link <= server->ble.storage->numGATTTableElements);
+            HAPBLEGATTTableElement* gattAttribute =
+                    (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[*link - 1U];
+            HAPAssert(gattAttribute->connectionState.pendingEventConnections);
+            if (!(gattAttribute->connectionState.pendingEventConnections & connectionMask)) {
+                previous = *link;
+                link = &gattAttribute->connectionState.nextPendingEvent;
+                continue;
+            }
+            const HAPBaseCharacteristic* characteristic = HAPNonnullVoid(gattAttribute->characteristic);
+            const HAPService* service = HAPNonnull(gattAttribute->service);
+            const HAPAccessory* accessory = HAPNonnull(gattAttribute->accessory);
+            HAPAssert(characteristic->properties.supportsEventNotification);
+            HAPAssert(gattAttribute->valueHandle);
+            HAPAssert(gattAttribute->cccDescriptorHandle);
+            HAPAssert(gattAttribute->iidHandle);
+
+            bool isDeliverable = false;
+            if (characteristic->iid > UINT16_MAX) {
+                HAPLogCharacteristicError(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "Not sending Handle Value Indication because characteristic instance ID is not supported.");
+            } else if (!(gattAttribute->connectionState.subscribedConnections & connectionMask)) {
+                HAPLogCharacteristicDebug(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "Dropping event because the controller has not subscribed to the characteristic.");
+            } else if (!HAPSessionIsSecured(session)) {
+                HAPLogCharacteristicInfo(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "Not sending Handle Value Indication because the session is not secured.");
+                return;
+            } else if (HAPSessionIsTransient(session)) {
+                HAPLogCharacteristicInfo(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "Not sending Handle Value Indication because the session is transient.");
+                return;
+            } else if (
+                    HAPCharacteristicReadRequiresAdminPermissions(characteristic) &&
+                    !HAPSessionControllerIsAdmin(session)) {
+                HAPLogCharacteristicInfo(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "Not sending Handle Value Indication because event notification values will only be delivered "
+                        "to controllers with admin permissions.");
+            } else {
+                isDeliverable = true;
+            }
+            if (isDeliverable) {
+                err = HAPPlatformBLEPeripheralManagerSendHandleValueIndication(
+                        blePeripheralManager,
+                        connection->connectionHandle,
+                        gattAttribute->valueHandle,
+                        /* bytes: */ NULL,
+                        /* numBytes: */ 0);
+                if (err == kHAPError_InvalidState) {
+                    HAPLogCharacteristicInfo(
+                            &logObject,
+                            characteristic,
+                            service,
+                            accessory,
+                            "Delayed event sending until ready to update subscribers.");
+                    return;
+                } else if (err) {
+                    HAPAssert(err == kHAPError_OutOfResources);
+                    HAPFatalError();
+                }
+            }
+
+            // Dequeue event once it has been sent to or dropped for all connections.
+            // Undeliverable events are dropped so that they are not visited again on later passes.
+            gattAttribute->connectionState.pendingEventConnections &= (uint8_t) ~connectionMask;
+            if (gattAttribute->connectionState.pendingEventConnections) {
+                previous = *link;
+                link = &gattAttribute->connectionState.nextPendingEvent;
+            } else {
+                *link = gattAttribute->connectionState.nextPendingEvent;
+                if (!*link) {
+                    server->ble.pendingEvents.queues[priority].last = previous;
+                }
+                gattAttribute->connectionState.nextPendingEvent = 0;
+            }
+            if (!isDeliverable) {
+                continue;
+            }
+            HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Sent event.");
+
+            err = HAPBLEAccessoryServerDidSendEventNotification(server_, characteristic, service, accessory);
+            if (err) {
+                HAPAssert(err == kHAPError_Unknown);
+                HAPFatalError();
+            }
         }
+    }
+}
+
+/**
+ * BLE GATT handle table entry for GATT attribute handles that are not linked to a GATT attribute structure.
+ */
+#define kGATTHandleTableEntry_None ((uint16_t) UINT16_MAX)
+
+/**
+ * Validates a GATT attribute structure.
+ *
+ * @param      gattAttribute        GATT attribute structure.
+ */
+static void ValidateGATTAttribute(const HAPBLEGATTTableElement* gattAttribute) {
+    HAPPrecondition(gattAttribute);
+
+    HAPAssert(gattAttribute->accessory);
+    HAPAssert(gattAttribute->service);
+    if (!gattAttribute->characteristic) {
+        HAPAssert(!gattAttribute->valueHandle);
+        HAPAssert(!gattAttribute->cccDescriptorHandle);
+    } else {
+        const HAPBaseCharacteristic* characteristic = gattAttribute->characteristic;
+        HAPAssert(gattAttribute->valueHandle);
         if (!characteristic->properties.supportsEventNotification) {
-            HAPAssert(!gattAttribute->connectionState.centralSubscribed);
-            HAPAssert(!gattAttribute->connectionState.pendingEvent);
-            continue;
-        }
-        if (characteristic->iid > UINT16_MAX) {
-            HAPLogCharacteristicError(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Not sending Handle Value Indication because characteristic instance ID is not supported.");
-            continue;
+            HAPAssert(!gattAttribute->cccDescriptorHandle);
         }
-        HAPAssert(gattAttribute->valueHandle);
-        HAPAssert(gattAttribute->cccDescriptorHandle);
-        HAPAssert(gattAttribute->iidHandle);
+    }
+    HAPAssert(gattAttribute->iidHandle);
+}
 
-        if (!gattAttribute->connectionState.centralSubscribed) {
-            continue;
-        }
-        if (!gattAttribute->connectionState.pendingEvent) {
-            continue;
-        }
-        if (!HAPSessionIsSecured(session)) {
-            HAPLogCharacteristicInfo(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Not sending Handle Value Indication because the session is not secured.");
-            return;
-        }
-        if (HAPSessionIsTransient(session)) {
-            HAPLogCharacteristicInfo(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Not sending Handle Value Indication because the session is transient.");
-            return;
+/**
+ * Links a GATT attribute handle to a GATT attribute structure in the BLE GATT handle table.
+ *
+ * @param      server_              Accessory server.
+ * @param      attributeHandle      GATT attribute handle. 0 if not available.
+ * @param      index                Index of the GATT attribute structure in the BLE GATT table.
+ */
+static void LinkGATTAttributeHandle(
+        HAPAccessoryServerRef* server_,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle,
+        uint16_t index) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ble.storage->gattHandleTable);
+    uint16_t* gattHandleTable = server->ble.storage->gattHandleTable;
+
+    if (!attributeHandle) {
+        return;
+    }
+    HAPAssert(attributeHandle >= server->ble.gattHandleTable.firstHandle);
+    size_t i = (size_t)(attributeHandle - server->ble.gattHandleTable.firstHandle);
+    HAPAssert(i < server->ble.gattHandleTable.numHandles);
+    HAPAssert(gattHandleTable[i] == kGATTHandleTableEntry_None);
+    gattHandleTable[i] = index;
+}
+
+/**
+ * Sets up the BLE GATT handle table after all GATT attribute handles have been assigned.
+ *
+ * - If no BLE GATT handle table is available or if it is too small, GATT attribute structures are looked up
+ *   by searching the BLE GATT table.
+ *
+ * @param      server_              Accessory server.
+ */
+static void SetUpGATTHandleTable(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPRawBufferZero(&server->ble.gattHandleTable, sizeof server->ble.gattHandleTable);
+
+    // Determine range of assigned GATT attribute handles.
+    size_t numGATTAttributes = 0;
+    HAPPlatformBLEPeripheralManagerAttributeHandle minHandle = UINT16_MAX;
+    HAPPlatformBLEPeripheralManagerAttributeHandle maxHandle = 0;
+    for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
+        const HAPBLEGATTTableElement* gattAttribute =
+                (const HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
+        if (!gattAttribute->accessory) {
+            break;
         }
-        if (HAPCharacteristicReadRequiresAdminPermissions(characteristic) && !HAPSessionControllerIsAdmin(session)) {
-            HAPLogCharacteristicInfo(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Not sending Handle Value Indication because event notification values will only be delivered to "
-                    "controllers with admin permissions.");
-            continue;
+        ValidateGATTAttribute(gattAttribute);
+
+        const HAPPlatformBLEPeripheralManagerAttributeHandle handles[] = { gattAttribute->valueHandle,
+                                                                           gattAttribute->cccDescriptorHandle,
+                                                                           gattAttribute->iidHandle };
+        for (size_t j = 0; j < HAPArrayCount(handles); j++) {
+            if (handles[j]) {
+                minHandle = HAPMin(minHandle, handles[j]);
+                maxHandle = HAPMax(maxHandle, handles[j]);
+            }
         }
-
-        err = HAPPlatformBLEPeripheralManagerSendHandleValueIndication(
-                blePeripheralManager,
-                server->ble.connection.connectionHandle,
-                gattAttribute->valueHandle,
-                /* bytes: */ NULL,
-                /* numBytes: */ 0);
-        if (err == kHAPError_InvalidState) {
-            HAPLogCharacteristicInfo(
-                    &logObject,
-                    characteristic,
-                    service,
-                    accessory,
-                    "Delayed event sending until ready to update subscribers.");
-            return;
-        } else if (err) {
-            HAPAssert(err == kHAPError_OutOfResources);
-            HAPFatalError();
+        numGATTAttributes++;
+    }
+    if (!numGATTAttributes) {
+        return;
+    }
+    if (numGATTAttributes >= kGATTHandleTableEntry_None) {
+        HAPLog(&logObject, "Too many GATT attributes for GATT handle table. Searching GATT table instead.");
+        return;
+    }
+    size_t numHandles = (size_t)(maxHandle - minHandle) + 1;
+    if (numHandles > server->ble.storage->numGATTHandleTableEntries) {
+        if (server->ble.storage->gattHandleTable) {
+            HAPLog(&logObject,
+                   "GATT handle table capacity not large enough to store %zu handles (%zu available). "
+                   "Searching GATT table instead.",
+                   numHandles,
+                   server->ble.storage->numGATTHandleTableEntries);
         }
-        gattAttribute->connectionState.pendingEvent = false;
-        HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Sent event.");
+        return;
+    }
+    HAPAssert(server->ble.storage->gattHandleTable);
+    uint16_t* gattHandleTable = server->ble.storage->gattHandleTable;
 
-        err = HAPBLEAccessoryServerDidSendEventNotification(server_, characteristic, service, accessory);
-        if (err) {
-            HAPAssert(err == kHAPError_Unknown);
-            HAPFatalError();
-        }
+    // Link GATT attribute handles.
+    for (size_t i = 0; i < numHandles; i++) {
+        gattHandleTable[i] = kGATTHandleTableEntry_None;
     }
+    server->ble.gattHandleTable.firstHandle = minHandle;
+    server->ble.gattHandleTable.numHandles = (uint16_t) numHandles;
+    for (size_t i = 0; i < numGATTAttributes; i++) {
+        const HAPBLEGATTTableElement* gattAttribute =
+                (const HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
+        LinkGATTAttributeHandle(server_, gattAttribute->valueHandle, (uint16_t) i);
+        LinkGATTAttributeHandle(server_, gattAttribute->cccDescriptorHandle, (uint16_t) i);
+        LinkGATTAttributeHandle(server_, gattAttribute->iidHandle, (uint16_t) i);
+    }
+    HAPLogDebug(
+            &logObject,
+            "GATT handle table covers handles 0x%04x - 0x%04x.",
+            (unsigned int) minHandle,
+            (unsigned int) maxHandle);
 }
 
 /**
@@ -397,39 +742,101 @@ static HAPBLEGATTTableElement* _Nullable GetGATTAttribute(
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(attributeHandle);
 
-    for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
-        HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
-        if (!gattAttribute->accessory) {
-            break;
-        }
-
-        // Validate GATT attribute.
-        HAPAssert(gattAttribute->service);
-        if (!gattAttribute->characteristic) {
-            HAPAssert(!gattAttribute->valueHandle);
-            HAPAssert(!gattAttribute->cccDescriptorHandle);
-        } else {
-            const HAPBaseCharacteristic* characteristic = gattAttribute->characteristic;
-            HAPAssert(gattAttribute->valueHandle);
-            if (!characteristic->properties.supportsEventNotification) {
-                HAPAssert(!gattAttribute->cccDescriptorHandle);
+    if (server->ble.gattHandleTable.numHandles) {
+        // Direct lookup.
+        HAPAssert(server->ble.storage->gattHandleTable);
+        HAPPlatformBLEPeripheralManagerAttributeHandle firstHandle = server->ble.gattHandleTable.firstHandle;
+        if (attributeHandle >= firstHandle && attributeHandle - firstHandle < server->ble.gattHandleTable.numHandles) {
+            uint16_t index = server->ble.storage->gattHandleTable[attributeHandle - firstHandle];
+            if (index != kGATTHandleTableEntry_None) {
+                HAPAssert(index < server->ble.storage->numGATTTableElements);
+                return (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[index];
             }
         }
-        HAPAssert(gattAttribute->iidHandle);
+    } else {
+        for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
+            HAPBLEGATTTableElement* gattAttribute =
+                    (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
+            if (!gattAttribute->accessory) {
+                break;
+            }
 
-        // Check for match.
-        if (attributeHandle == gattAttribute->valueHandle || attributeHandle == gattAttribute->cccDescriptorHandle ||
-            attributeHandle == gattAttribute->iidHandle) {
-            return gattAttribute;
+            // Check for match.
+            if (attributeHandle == gattAttribute->valueHandle ||
+                attributeHandle == gattAttribute->cccDescriptorHandle || attributeHandle == gattAttribute->iidHandle) {
+                return gattAttribute;
+            }
         }
     }
     HAPLog(&logObject, "GATT attribute structure not found for handle 0x%04x", (unsigned int) attributeHandle);
     return NULL;
 }
 
+/**
+ * Finds the GATT attribute structure of a characteristic.
+ *
+ * - If the attribute database is flattened, the index of the GATT attribute structure is derived from the indices
+ *   of the characteristic record and of its service record. GATT attribute structures are registered in the order
+ *   of the service lists and characteristic lists of the primary accessory, each service followed by its
+ *   characteristics, and the records of the primary accessory come first. Otherwise, the BLE GATT table is searched.
+ *
+ * @param      server_              Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param[out] gattAttributeIndex   Index of the GATT attribute structure in the BLE GATT table, if found.
+ *
+ * @return true                     If the GATT attribute structure was found.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool FindCharacteristicGATTAttribute(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        size_t* gattAttributeIndex) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(gattAttributeIndex);
+
+    if (HAPAttributeDatabaseIsFlattened(server_) && accessory == server->primaryAccessory) {
+        size_t characteristicIndex =
+                HAPAttributeDatabaseGetCharacteristicIndex(server_, characteristic, service, accessory);
+        size_t i = HAPAttributeDatabaseGetCharacteristicServiceIndex(server_, characteristicIndex) + 1 +
+                   characteristicIndex;
+        HAPAssert(i < server->ble.storage->numGATTTableElements);
+        const HAPBLEGATTTableElement* gattAttribute =
+                (const HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
+        HAPAssert(gattAttribute->characteristic == characteristic);
+        HAPAssert(gattAttribute->service == service);
+        *gattAttributeIndex = i;
+        return true;
+    }
+
+    for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
+        const HAPBLEGATTTableElement* gattAttribute =
+                (const HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
+        if (!gattAttribute->accessory) {
+            break;
+        }
+
+        if (gattAttribute->characteristic == characteristic && gattAttribute->service == service &&
+            gattAttribute->accessory == accessory) {
+            *gattAttributeIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
 HAP_RESULT_USE_CHECK
 static bool AreNotificationsEnabled(
         HAPAccessoryServerRef* server,
+        size_t connectionIndex,
         HAPSessionRef* session,
         HAPBLEGATTTableElement* gattAttribute) {
     HAPPrecondition(server);
@@ -439,18 +846,15 @@ static bool AreNotificationsEnabled(
     const HAPService* service HAP_UNUSED = HAPNonnull(gattAttribute->service);
     const HAPAccessory* accessory = HAPNonnull(gattAttribute->accessory);
 
+    bool isEnabled = (gattAttribute->connectionState.subscribedConnections & GetConnectionMask(connectionIndex)) != 0;
     HAPLogCharacteristicInfo(
-            &logObject,
-            characteristic,
-            service,
-            accessory,
-            "Events are %s.",
-            gattAttribute->connectionState.centralSubscribed ? "enabled" : "disabled");
-    return gattAttribute->connectionState.centralSubscribed;
+            &logObject, characteristic, service, accessory, "Events are %s.", isEnabled ? "enabled" : "disabled");
+    return isEnabled;
 }
 
 static void SetNotificationsEnabled(
         HAPAccessoryServerRef* server,
+        size_t connectionIndex,
         HAPSessionRef* session,
         HAPBLEGATTTableElement* gattAttribute,
         bool enable) {
@@ -460,13 +864,18 @@ static void SetNotificationsEnabled(
     const HAPCharacteristic* characteristic = gattAttribute->characteristic;
     const HAPService* service = gattAttribute->service;
     const HAPAccessory* accessory = gattAttribute->accessory;
+    uint8_t connectionMask = GetConnectionMask(connectionIndex);
 
     HAPLogCharacteristicInfo(
             &logObject, characteristic, service, accessory, "%s events.", enable ? "Enabling" : "Disabling");
-    if (gattAttribute->connectionState.centralSubscribed == enable) {
+    if (((gattAttribute->connectionState.subscribedConnections & connectionMask) != 0) == enable) {
         return;
     }
-    gattAttribute->connectionState.centralSubscribed = enable;
+    if (enable) {
+        gattAttribute->connectionState.subscribedConnections |= connectionMask;
+    } else {
+        gattAttribute->connectionState.subscribedConnections &= (uint8_t) ~connectionMask;
+    }
 
     // Inform application.
     if (HAPSessionIsSecured(session)) {
@@ -493,7 +902,7 @@ static void SetNotificationsEnabled(
     }
 
     // Subscription state changed. Continue sending events.
-    SendPendingEventNotifications(server);
+    SendPendingEventNotifications(server, connectionIndex);
 }
 
 #if !DEBUG_DISABLE_TIMEOUTS
@@ -510,6 +919,7 @@ static void FallbackProcedureTimerExpired(HAPPlatformTimerRef timer, void* _Null
     // See HomeKit Accessory Protocol Specification R14
     // Section 7.5 Testing Bluetooth LE Accessories
 
+    size_t connectionIndex = server->ble.numSessions;
     for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
         HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
 
@@ -527,6 +937,7 @@ static void FallbackProcedureTimerExpired(HAPPlatformTimerRef timer, void* _Null
 
         HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Fallback procedure expired.");
 
+        connectionIndex = gattAttribute->connectionState.fallbackProcedure.connectionIndex;
 #if !DEBUG_DISABLE_TIMEOUTS
         HAPPlatformTimerDeregister(gattAttribute->connectionState.fallbackProcedure.timer);
 #endif
@@ -535,9 +946,9 @@ static void FallbackProcedureTimerExpired(HAPPlatformTimerRef timer, void* _Null
                 sizeof gattAttribute->connectionState.fallbackProcedure);
     }
 
-    HAPAssert(server->ble.connection.connected);
-    HAPAssert(server->ble.storage->session);
-    HAPSessionRef* session = server->ble.storage->session;
+    HAPAssert(connectionIndex < server->ble.numSessions);
+    HAPAssert(server->ble.connections[connectionIndex].connected);
+    HAPSessionRef* session = HAPAccessoryServerGetBLESession(server_, connectionIndex);
     HAPSessionInvalidate(server_, session, /* terminateLink: */ true);
 }
 #endif
@@ -587,6 +998,7 @@ __attribute__((type_tag_for_datatype(HAPBLEProcedureType, HAPBLEFallbackProcedur
  * Gets the HAP-BLE procedure for a GATT attribute.
  *
  * @param      server_              Accessory server.
+ * @param      connectionIndex      Index of the connection over which the request has been received.
  * @param      session_             The session over which the request has been received.
  * @param      gattAttribute        The GATT attribute that is accessed.
  * @param[out] procedureType        Type of the attached procedure.
@@ -595,8 +1007,9 @@ __attribute__((type_tag_for_datatype(HAPBLEProcedureType, HAPBLEFallbackProcedur
  * @return kHAPError_None           If successful.
  * @return kHAPError_InvalidState   If no procedure can be fetched at this time.
  */
-HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError GetProcedure(
+HAP_PWT_HAPBLEProcedureType(6, 5) HAP_RESULT_USE_CHECK static HAPError GetProcedure(
         HAPAccessoryServerRef* server_,
+        size_t connectionIndex,
         HAPSessionRef* session_,
         HAPBLEGATTTableElement* gattAttribute,
         HAPBLEProcedureType* procedureType,
@@ -615,12 +1028,13 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError GetProced
     const HAPAccessory* accessory = gattAttribute->accessory;
     HAPPrecondition(procedureType);
     HAPPrecondition(procedure);
+    HAPPrecondition(connectionIndex < server->ble.numSessions);
+    const HAPBLEAccessoryServerConnection* connection = &server->ble.connections[connectionIndex];
 
-    // For now, we only support 1 concurrent full-featured procedure.
+    // Each connection has its own full-featured procedure.
     HAPPrecondition(server->ble.storage->procedures);
-    HAPPrecondition(server->ble.storage->procedures);
-    HAPPrecondition(server->ble.storage->numProcedures >= 1);
-    HAPBLEProcedureRef* fullProcedure = &server->ble.storage->procedures[0];
+    HAPPrecondition(connectionIndex < server->ble.storage->numProcedures);
+    HAPBLEProcedureRef* fullProcedure = &server->ble.storage->procedures[connectionIndex];
 
     // Every characteristic supports a fallback procedure.
     HAPBLEFallbackProcedure* fallbackProcedure = &gattAttribute->connectionState.fallbackProcedure;
@@ -628,8 +1042,7 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError GetProced
     // If session is terminal, no more requests may be accepted.
     if (HAPBLESessionIsTerminal(&session->_.ble)) {
         HAPLogCharacteristic(&logObject, characteristic, service, accessory, "Rejecting request: Session is terminal.");
-        HAPPlatformBLEPeripheralManagerCancelCentralConnection(
-                blePeripheralManager, server->ble.connection.connectionHandle);
+        HAPPlatformBLEPeripheralManagerCancelCentralConnection(blePeripheralManager, connection->connectionHandle);
         return kHAPError_InvalidState;
     }
 
@@ -644,18 +1057,18 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError GetProced
                 accessory,
                 "Aborting fallback procedure (%s).",
                 "Characteristic drops security session");
-        AbortAllFallbackProcedures(server_);
+        AbortAllFallbackProcedures(server_, connectionIndex);
     }
 
     // Check if already attached to the same characteristic (fallback procedure).
-    if (gattAttribute->connectionState.fallbackProcedure.timer) {
+    if (fallbackProcedure->timer && fallbackProcedure->connectionIndex == connectionIndex) {
         *procedureType = kHAPBLEProcedureType_Fallback;
         *procedure = fallbackProcedure;
         return kHAPError_None;
     }
 
     // Check if already attached to the same characteristic (full procedure).
-    if (server->ble.connection.procedureAttached) {
+    if (connection->procedureAttached) {
         const HAPBaseCharacteristic* attachedCharacteristic = HAPBLEProcedureGetAttachedCharacteristic(fullProcedure);
         HAPAssert(attachedCharacteristic);
 
@@ -689,15 +1102,16 @@ static HAPError HandleReadRequest(
     HAPPrecondition(numBytes);
     HAPPrecondition(context);
     HAPAccessoryServerRef* server_ = context;
-    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
-    HAPPrecondition(server->ble.storage->session);
-    HAPSessionRef* session = server->ble.storage->session;
 
     HAPError err;
 
     HAPLogDebug(&logObject, "%s(0x%04x, 0x%04x)", __func__, connectionHandle, attributeHandle);
-    HAPPrecondition(server->ble.connection.connected);
-    HAPPrecondition(connectionHandle == server->ble.connection.connectionHandle);
+    size_t connectionIndex;
+    if (!FindConnection(server_, connectionHandle, &connectionIndex)) {
+        HAPLog(&logObject, "Rejecting read request from rejected connection 0x%04x.", connectionHandle);
+        return kHAPError_InvalidState;
+    }
+    HAPSessionRef* session = HAPAccessoryServerGetBLESession(server_, connectionIndex);
     HAPBLEGATTTableElement* _Nullable gattAttribute = GetGATTAttribute(server_, attributeHandle);
     HAPPrecondition(gattAttribute);
     const HAPBaseCharacteristic* _Nullable characteristic = gattAttribute->characteristic;
@@ -713,7 +1127,7 @@ static HAPError HandleReadRequest(
         // Get HAP-BLE procedure.
         HAPBLEProcedureType procedureType;
         void* procedure;
-        err = GetProcedure(server_, session, gattAttribute, &procedureType, &procedure);
+        err = GetProcedure(server_, connectionIndex, session, gattAttribute, &procedureType, &procedure);
         if (err) {
             HAPAssert(err == kHAPError_InvalidState);
             HAPSessionInvalidate(server_, session, /* terminateLink: */ true);
@@ -839,7 +1253,7 @@ static HAPError HandleReadRequest(
         }
 
         // Continue sending events (if security state changed).
-        SendPendingEventNotifications(server_);
+        SendPendingEventNotifications(server_, connectionIndex);
     } else if (attributeHandle == gattAttribute->cccDescriptorHandle) {
         HAPAssert(characteristic);
         HAPAssert(service);
@@ -865,7 +1279,7 @@ static HAPError HandleReadRequest(
                     "Not enough space available to write Client Characteristic Configuration descriptor value.");
             return kHAPError_OutOfResources;
         }
-        bool isEnabled = AreNotificationsEnabled(server_, session, gattAttribute);
+        bool isEnabled = AreNotificationsEnabled(server_, connectionIndex, session, gattAttribute);
         HAPWriteLittleUInt16(bytes, isEnabled ? 0x0002u : 0x0000u);
         *numBytes = sizeof(uint16_t);
     } else {
@@ -916,7 +1330,11 @@ static HAPError HandleReadRequest(
 /**
  * Attaches a HAP-BLE procedure.
  *
+ * - Each connection has its own full-featured procedure that uses an equal share of the procedure buffer.
+ *   The fallback procedure of a characteristic is used by at most one connection at a time.
+ *
  * @param      server_              Accessory server.
+ * @param      connectionIndex      Index of the connection over which the request has been received.
  * @param      session_             The session over which the request has been received.
  * @param      gattAttribute        The GATT attribute that is accessed.
  * @param[out] procedureType        Type of the attached procedure.
@@ -927,8 +1345,9 @@ static HAPError HandleReadRequest(
  * @return kHAPError_InvalidState   If no procedure can be fetched at this time.
  * @return kHAPError_OutOfResources If no procedure is available.
  */
-HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachProcedure(
+HAP_PWT_HAPBLEProcedureType(6, 5) HAP_RESULT_USE_CHECK static HAPError AttachProcedure(
         HAPAccessoryServerRef* server_,
+        size_t connectionIndex,
         HAPSessionRef* session_,
         HAPBLEGATTTableElement* gattAttribute,
         HAPBLEProcedureType* procedureType,
@@ -950,16 +1369,17 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachPro
     HAPPrecondition(procedureType);
     HAPPrecondition(procedure);
     HAPPrecondition(isNewProcedure);
+    HAPPrecondition(connectionIndex < server->ble.numSessions);
+    HAPBLEAccessoryServerConnection* connection = &server->ble.connections[connectionIndex];
 
 #if !DEBUG_DISABLE_TIMEOUTS
     HAPError err;
 #endif
 
-    // For now, we only support 1 concurrent full-featured procedure.
+    // Each connection has its own full-featured procedure.
     HAPPrecondition(server->ble.storage->procedures);
-    HAPPrecondition(server->ble.storage->procedures);
-    HAPPrecondition(server->ble.storage->numProcedures >= 1);
-    HAPBLEProcedureRef* fullProcedure = &server->ble.storage->procedures[0];
+    HAPPrecondition(connectionIndex < server->ble.storage->numProcedures);
+    HAPBLEProcedureRef* fullProcedure = &server->ble.storage->procedures[connectionIndex];
 
     // Every characteristic supports a fallback procedure.
     HAPBLEFallbackProcedure* fallbackProcedure = &gattAttribute->connectionState.fallbackProcedure;
@@ -967,14 +1387,13 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachPro
     // If session is terminal, no more requests may be accepted.
     if (HAPBLESessionIsTerminal(&session->_.ble)) {
         HAPLogCharacteristic(&logObject, characteristic, service, accessory, "Rejecting request: Session is terminal.");
-        HAPPlatformBLEPeripheralManagerCancelCentralConnection(
-                blePeripheralManager, server->ble.connection.connectionHandle);
+        HAPPlatformBLEPeripheralManagerCancelCentralConnection(blePeripheralManager, connection->connectionHandle);
         return kHAPError_InvalidState;
     }
 
     // Handle shut down.
     if (server->state != kHAPAccessoryServerState_Running) {
-        if (server->ble.connection.procedureAttached && HAPBLEProcedureIsInProgress(fullProcedure)) {
+        if (connection->procedureAttached && HAPBLEProcedureIsInProgress(fullProcedure)) {
             // Allow finishing procedure to avoid dealing with bugs from halfway completed procedures.
             // Fallback procedures do not modify any state, so it's okay to abort them while they are ongoing.
             // Procedures have a timeout so this cannot delay forever.
@@ -988,8 +1407,7 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachPro
             // Do not start new procedures and abort pending fallback procedures.
             HAPLogCharacteristic(
                     &logObject, characteristic, service, accessory, "Rejecting request: Shutdown requested.");
-            HAPPlatformBLEPeripheralManagerCancelCentralConnection(
-                    blePeripheralManager, server->ble.connection.connectionHandle);
+            HAPPlatformBLEPeripheralManagerCancelCentralConnection(blePeripheralManager, connection->connectionHandle);
             return kHAPError_InvalidState;
         }
     }
@@ -1005,11 +1423,11 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachPro
                 accessory,
                 "Aborting fallback procedure (%s).",
                 "Characteristic drops security session");
-        AbortAllFallbackProcedures(server_);
+        AbortAllFallbackProcedures(server_, connectionIndex);
     }
 
     // Check if already attached to the same characteristic (fallback procedure).
-    if (gattAttribute->connectionState.fallbackProcedure.timer) {
+    if (fallbackProcedure->timer && fallbackProcedure->connectionIndex == connectionIndex) {
         *procedureType = kHAPBLEProcedureType_Fallback;
         *procedure = fallbackProcedure;
         *isNewProcedure = false;
@@ -1017,7 +1435,7 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachPro
     }
 
     // Detach full-featured procedure from previous characteristic if necessary.
-    if (server->ble.connection.procedureAttached) {
+    if (connection->procedureAttached) {
         const HAPBaseCharacteristic* attachedCharacteristic = HAPBLEProcedureGetAttachedCharacteristic(fullProcedure);
         HAPAssert(attachedCharacteristic);
 
@@ -1045,7 +1463,15 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachPro
                         attachedCharacteristic->debugDescription,
                         "Characteristic drops security session");
 
-                AbortAllFallbackProcedures(server_);
+                AbortAllFallbackProcedures(server_, connectionIndex);
+            } else if (fallbackProcedure->timer) {
+                HAPLogCharacteristic(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "Fallback procedure is in use by another connection. Rejecting request.");
+                return kHAPError_OutOfResources;
             } else {
                 HAPLogCharacteristic(
                         &logObject,
@@ -1075,6 +1501,7 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachPro
 #else
                 fallbackProcedure->timer = 1;
 #endif
+                fallbackProcedure->connectionIndex = (uint8_t) connectionIndex;
                 HAPBLESessionDidStartBLEProcedure(server_, session_);
 
                 *procedureType = kHAPBLEProcedureType_Fallback;
@@ -1094,21 +1521,22 @@ HAP_PWT_HAPBLEProcedureType(5, 4) HAP_RESULT_USE_CHECK static HAPError AttachPro
                 (unsigned long long) attachedCharacteristic->iid,
                 attachedCharacteristic->debugDescription);
         HAPBLEProcedureDestroy(fullProcedure);
-        server->ble.connection.procedureAttached = false;
+        connection->procedureAttached = false;
     }
 
     // Attach to new characteristic.
     HAPLogCharacteristicDebug(&logObject, characteristic, service, accessory, "Attaching procedure.");
+    size_t numProcedureBytes = server->ble.storage->procedureBuffer.numBytes / server->ble.numSessions;
     HAPBLEProcedureAttach(
             fullProcedure,
-            server->ble.storage->procedureBuffer.bytes,
-            server->ble.storage->procedureBuffer.numBytes,
+            (uint8_t*) server->ble.storage->procedureBuffer.bytes + connectionIndex * numProcedureBytes,
+            numProcedureBytes,
             server_,
             session_,
             characteristic,
             service,
             accessory);
-    server->ble.connection.procedureAttached = true;
+    connection->procedureAttached = true;
 
     *procedureType = kHAPBLEProcedureType_Full;
     *procedure = fullProcedure;
@@ -1130,15 +1558,16 @@ static HAPError HandleWriteRequest(
     HAPPrecondition(numBytes);
     HAPPrecondition(context);
     HAPAccessoryServerRef* server_ = context;
-    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
-    HAPPrecondition(server->ble.storage->session);
-    HAPSessionRef* session = server->ble.storage->session;
 
     HAPError err;
 
     HAPLogDebug(&logObject, "%s(0x%04x, 0x%04x)", __func__, connectionHandle, attributeHandle);
-    HAPPrecondition(server->ble.connection.connected);
-    HAPPrecondition(connectionHandle == server->ble.connection.connectionHandle);
+    size_t connectionIndex;
+    if (!FindConnection(server_, connectionHandle, &connectionIndex)) {
+        HAPLog(&logObject, "Rejecting write request from rejected connection 0x%04x.", connectionHandle);
+        return kHAPError_InvalidState;
+    }
+    HAPSessionRef* session = HAPAccessoryServerGetBLESession(server_, connectionIndex);
     HAPBLEGATTTableElement* _Nullable gattAttribute = GetGATTAttribute(server_, attributeHandle);
     HAPPrecondition(gattAttribute);
     const HAPBaseCharacteristic* _Nullable characteristic = gattAttribute->characteristic;
@@ -1155,7 +1584,8 @@ static HAPError HandleWriteRequest(
         HAPBLEProcedureType procedureType;
         void* procedure;
         bool isNewProcedure;
-        err = AttachProcedure(server_, session, gattAttribute, &procedureType, &procedure, &isNewProcedure);
+        err = AttachProcedure(
+                server_, connectionIndex, session, gattAttribute, &procedureType, &procedure, &isNewProcedure);
         if (err) {
             HAPAssert(err == kHAPError_InvalidState || err == kHAPError_OutOfResources);
             HAPSessionInvalidate(server_, session, /* terminateLink: */ true);
@@ -1369,7 +1799,7 @@ static HAPError HandleWriteRequest(
         }
 
         // Continue sending events (if security state changed).
-        SendPendingEventNotifications(server_);
+        SendPendingEventNotifications(server_, connectionIndex);
     } else if (attributeHandle == gattAttribute->cccDescriptorHandle) {
         HAPAssert(characteristic);
         HAPAssert(service);
@@ -1404,7 +1834,7 @@ static HAPError HandleWriteRequest(
             return kHAPError_InvalidData;
         }
         bool eventsEnabled = (v & 0x0002) != 0;
-        SetNotificationsEnabled(server_, session, gattAttribute, eventsEnabled);
+        SetNotificationsEnabled(server_, connectionIndex, session, gattAttribute, eventsEnabled);
     } else {
         HAPAssert(attributeHandle == gattAttribute->iidHandle);
         HAPAssert(service);
@@ -1443,14 +1873,14 @@ static void HandleReadyToUpdateSubscribers(
     HAPPrecondition(blePeripheralManager);
     HAPPrecondition(context);
     HAPAccessoryServerRef* server_ = context;
-    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
-    HAPPrecondition(server->ble.connection.connected);
 
     HAPLogDebug(&logObject, "%s(0x%04x)", __func__, connectionHandle);
-    HAPPrecondition(server->ble.connection.connected);
-    HAPPrecondition(connectionHandle == server->ble.connection.connectionHandle);
+    size_t connectionIndex;
+    if (!FindConnection(server_, connectionHandle, &connectionIndex)) {
+        return;
+    }
 
-    SendPendingEventNotifications(server_);
+    SendPendingEventNotifications(server_, connectionIndex);
 }
 
 void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server_) {
@@ -1478,7 +1908,8 @@ void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server_) {
                                                                .handleReadRequest = HandleReadRequest,
                                                                .handleWriteRequest = HandleWriteRequest,
                                                                .handleReadyToUpdateSubscribers =
-                                                                       HandleReadyToUpdateSubscribers });
+                                                                       HandleReadyToUpdateSubscribers,
+                                                               .handleUpdatedMTU = HandleUpdatedMTU });
 
     // Register DB.
     size_t o = 0;
@@ -1631,6 +2062,8 @@ void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server_) {
     }
 
     // Finalize GATT database.
+    SetUpGATTHandleTable(server_);
+    HAPBLESignatureCacheCreate(server_);
     HAPPlatformBLEPeripheralManagerPublishServices(blePeripheralManager);
 }
 
@@ -1638,7 +2071,8 @@ void HAPBLEPeripheralManagerRaiseEvent(
         HAPAccessoryServerRef* server_,
         const HAPCharacteristic* characteristic_,
         const HAPService* service,
-        const HAPAccessory* accessory) {
+        const HAPAccessory* accessory,
+        HAPSessionRef* _Nullable session) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(characteristic_);
@@ -1646,21 +2080,66 @@ void HAPBLEPeripheralManagerRaiseEvent(
     HAPPrecondition(service);
     HAPPrecondition(accessory);
 
-    for (size_t i = 0; i < server->ble.storage->numGATTTableElements; i++) {
-        HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
-        if (!gattAttribute->accessory) {
-            break;
+    // Determine connections to notify.
+    uint8_t connectionMask = 0;
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        const HAPBLEAccessoryServerConnection* connection = &server->ble.connections[i];
+        if (!connection->connected || (session && session != HAPAccessoryServerGetBLESession(server_, i))) {
+            continue;
         }
+        if (connection->write.characteristic == characteristic_ && connection->write.service == service &&
+            connection->write.accessory == accessory) {
+            HAPLogCharacteristicInfo(
+                    &logObject,
+                    characteristic,
+                    service,
+                    accessory,
+                    "Suppressing notification as the characteristic is currently being written.");
+            continue;
+        }
+        connectionMask |= GetConnectionMask(i);
+    }
+    if (!connectionMask) {
+        return;
+    }
 
-        if (gattAttribute->characteristic == characteristic && gattAttribute->service == service &&
-            gattAttribute->accessory == accessory) {
-            HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Scheduling event.");
-            gattAttribute->connectionState.pendingEvent = true;
-            SendPendingEventNotifications(server_);
-            return;
+    size_t i;
+    if (!FindCharacteristicGATTAttribute(server_, characteristic_, service, accessory, &i)) {
+        HAPLogCharacteristic(&logObject, characteristic, service, accessory, "GATT attribute structure not found.");
+        return;
+    }
+    HAPBLEGATTTableElement* gattAttribute = (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[i];
+    if (gattAttribute->connectionState.pendingEventConnections) {
+        // Repeated events are coalesced. The event is sent once, in the position of the first raise.
+        HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Event already pending.");
+        gattAttribute->connectionState.pendingEventConnections |= connectionMask;
+    } else {
+        HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Scheduling event.");
+        HAPAssert(!gattAttribute->connectionState.nextPendingEvent);
+        HAPAssert(i < UINT16_MAX);
+        gattAttribute->connectionState.pendingEventConnections = connectionMask;
+
+        // Enqueue event.
+        HAPBLEEventPriority priority = GetEventPriority(characteristic);
+        HAPAssert(priority < HAPArrayCount(server->ble.pendingEvents.queues));
+        uint16_t* first = &server->ble.pendingEvents.queues[priority].first;
+        uint16_t* last = &server->ble.pendingEvents.queues[priority].last;
+        if (*last) {
+            HAPBLEGATTTableElement* lastGATTAttribute =
+                    (HAPBLEGATTTableElement*) &server->ble.storage->gattTableElements[*last - 1U];
+            HAPAssert(!lastGATTAttribute->connectionState.nextPendingEvent);
+            lastGATTAttribute->connectionState.nextPendingEvent = (uint16_t)(i + 1);
+        } else {
+            HAPAssert(!*first);
+            *first = (uint16_t)(i + 1);
+        }
+        *last = (uint16_t)(i + 1);
+    }
+    for (size_t j = 0; j < server->ble.numSessions; j++) {
+        if (connectionMask & GetConnectionMask(j)) {
+            SendPendingEventNotifications(server_, j);
         }
     }
-    HAPLogCharacteristic(&logObject, characteristic, service, accessory, "GATT attribute structure not found.");
 }
 
 void HAPBLEPeripheralManagerHandleSessionAccept(HAPAccessoryServerRef* server_, HAPSessionRef* session) {
@@ -1671,9 +2150,11 @@ void HAPBLEPeripheralManagerHandleSessionAccept(HAPAccessoryServerRef* server_,
     if (!server->transports.ble) {
         return;
     }
-    if (session != server->ble.storage->session) {
+    size_t connectionIndex;
+    if (!HAPAccessoryServerGetBLESessionIndex(server_, session, &connectionIndex)) {
         return;
     }
+    uint8_t connectionMask = GetConnectionMask(connectionIndex);
 
     // On BLE event subscriptions may be enabled before the HomeKit session is secured.
     // If this happens we have delayed informing the application about the updated subscription state
@@ -1695,7 +2176,7 @@ void HAPBLEPeripheralManagerHandleSessionAccept(HAPAccessoryServerRef* server_,
         }
 
         // Inform application.
-        if (gattAttribute->connectionState.centralSubscribed) {
+        if (gattAttribute->connectionState.subscribedConnections & connectionMask) {
             HAPLogCharacteristic(
                     &logObject,
                     characteristic,
@@ -1707,7 +2188,9 @@ void HAPBLEPeripheralManagerHandleSessionAccept(HAPAccessoryServerRef* server_,
     }
 
     // Continue sending events.
-    SendPendingEventNotifications(server_);
+    if (server->ble.connections[connectionIndex].connected) {
+        SendPendingEventNotifications(server_, connectionIndex);
+    }
 }
 
 void HAPBLEPeripheralManagerHandleSessionInvalidate(HAPAccessoryServerRef* server_, HAPSessionRef* session) {
@@ -1717,9 +2200,11 @@ void HAPBLEPeripheralManagerHandleSessionInvalidate(HAPAccessoryServerRef* serve
     if (!server->transports.ble) {
         return;
     }
-    if (session != server->ble.storage->session) {
+    size_t connectionIndex;
+    if (!HAPAccessoryServerGetBLESessionIndex(server_, session, &connectionIndex)) {
         return;
     }
+    uint8_t connectionMask = GetConnectionMask(connectionIndex);
 
     // Inform application that controller has unsubscribed from all characteristics.
     // Note that on BLE the actual subscription state persists across sequential sessions until there is a disconnect.
@@ -1740,7 +2225,7 @@ void HAPBLEPeripheralManagerHandleSessionInvalidate(HAPAccessoryServerRef* serve
         }
 
         // Inform application.
-        if (gattAttribute->connectionState.centralSubscribed) {
+        if (gattAttribute->connectionState.subscribedConnections & connectionMask) {
             HAPLogCharacteristicDebug(
                     &logObject, characteristic, service, accessory, "Informing application about disabling of events.");
             HAPAccessoryServerHandleUnsubscribe(server_, session, characteristic, service, accessory);
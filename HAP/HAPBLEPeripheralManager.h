@@ -34,16 +34,20 @@ void HAPBLEPeripheralManagerRegister(HAPAccessoryServerRef* server);
 /**
  * Raises an event notification for a given characteristic in a given service provided by a given accessory object.
  *
+ * - The event is not sent to a connection that is currently writing the characteristic.
+ *
  * @param      server               Accessory server.
  * @param      characteristic       The characteristic whose value has changed.
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
+ * @param      session              The session on which to raise the event. NULL to raise it on all connections.
  */
 void HAPBLEPeripheralManagerRaiseEvent(
         HAPAccessoryServerRef* server,
         const HAPCharacteristic* characteristic,
         const HAPService* service,
-        const HAPAccessory* accessory);
+        const HAPAccessory* accessory,
+        HAPSessionRef* _Nullable session);
 
 /**
  * Informs the peripheral manager that a HomeKit Session was accepted.
@@ -278,7 +278,8 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
             DestroyRequestBodyAndCreateResponseBodyWriter(bleProcedure_, &writer);
 
             // Serialize HAP-Service-Signature-Read-Response.
-            err = HAPBLEServiceGetSignatureReadResponse(request.iid == iid ? service : NULL, &writer);
+            err = HAPBLESignatureCacheGetServiceSignatureReadResponse(
+                    bleProcedure->server, request.iid == iid ? service : NULL, &writer);
             if (err) {
                 HAPAssert(err == kHAPError_OutOfResources);
                 SEND_ERROR_AND_RETURN(kHAPBLEPDUStatus_InvalidRequest);
@@ -326,7 +327,8 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
             DestroyRequestBodyAndCreateResponseBodyWriter(bleProcedure_, &writer);
 
             // Serialize HAP-Characteristic-Signature-Read-Response.
-            err = HAPBLECharacteristicGetSignatureReadResponse(characteristic, service, &writer);
+            err = HAPBLESignatureCacheGetCharacteristicSignatureReadResponse(
+                    bleProcedure->server, characteristic, service, &writer);
             if (err) {
                 HAPAssert(err == kHAPError_OutOfResources);
                 SEND_ERROR_AND_RETURN(kHAPBLEPDUStatus_InvalidRequest);
@@ -374,7 +376,7 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
 
             // Handle HAP-Characteristic-Configuration-Request.
             err = HAPBLECharacteristicHandleConfigurationRequest(
-                    characteristic, service, accessory, &request.bodyReader, server->platform.keyValueStore);
+                    characteristic, service, accessory, &request.bodyReader, bleProcedure->server);
             if (err) {
                 HAPAssert(err == kHAPError_Unknown || err == kHAPError_InvalidData);
                 HAPLogCharacteristic(
@@ -394,7 +396,7 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
 
             // Serialize HAP-Characteristic-Configuration-Response.
             err = HAPBLECharacteristicGetConfigurationResponse(
-                    characteristic, service, accessory, &writer, server->platform.keyValueStore);
+                    characteristic, service, accessory, &writer, bleProcedure->server);
             if (err) {
                 HAPAssert(err == kHAPError_Unknown || err == kHAPError_OutOfResources);
                 SEND_ERROR_AND_RETURN(kHAPBLEPDUStatus_InvalidRequest);
@@ -858,13 +860,18 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
             }
 
             // Destroy request body and process HAP-Characteristic-Write-Request.
-            HAPAssert(server->ble.connection.connected);
-            HAPAssert(!server->ble.connection.write.characteristic);
-            HAPAssert(!server->ble.connection.write.service);
-            HAPAssert(!server->ble.connection.write.accessory);
-            server->ble.connection.write.characteristic = characteristic;
-            server->ble.connection.write.service = service;
-            server->ble.connection.write.accessory = accessory;
+            size_t sessionIndex;
+            bool found = HAPAccessoryServerGetBLESessionIndex(
+                    bleProcedure->server, bleProcedure->session, &sessionIndex);
+            HAPAssert(found);
+            HAPBLEAccessoryServerConnection* connection = &server->ble.connections[sessionIndex];
+            HAPAssert(connection->connected);
+            HAPAssert(!connection->write.characteristic);
+            HAPAssert(!connection->write.service);
+            HAPAssert(!connection->write.accessory);
+            connection->write.characteristic = characteristic;
+            connection->write.service = service;
+            connection->write.accessory = accessory;
             bool hasExpired;
             err = HAPBLECharacteristicParseAndWriteValue(
                     bleProcedure->server,
@@ -876,9 +883,9 @@ static HAPError HAPBLEProcedureProcessTransaction(HAPBLEProcedureRef* bleProcedu
                     isTimedWrite ? &bleProcedure->_.timedWrite.timedWriteStartTime : NULL,
                     &hasExpired,
                     &hasReturnResponse);
-            server->ble.connection.write.characteristic = NULL;
-            server->ble.connection.write.service = NULL;
-            server->ble.connection.write.accessory = NULL;
+            connection->write.characteristic = NULL;
+            connection->write.service = NULL;
+            connection->write.accessory = NULL;
             if (err == kHAPError_NotAuthorized) {
                 HAPLogCharacteristic(
                         &logObject,
@@ -1255,6 +1262,24 @@ HAPError HAPBLEProcedureHandleGATTRead(
         return kHAPError_InvalidState;
     }
 
+    // If further response fragments follow, size them to fill the "Read Request" and "Read Blob Request" operations
+    // that transfer them. Each of them transfers up to ATT_MTU - 1 bytes. If the last operation is filled completely,
+    // the central cannot tell that the response is complete and sends another "Read Blob Request".
+    // See Bluetooth Core Specification Version 5
+    // Vol 3 Part F Section 3.4.4.4 Read Response and Section 3.4.4.6 Read Blob Response
+    size_t maxIntermediateBytes = maxBytes;
+    size_t sessionIndex;
+    bool found = HAPAccessoryServerGetBLESessionIndex(bleProcedure->server, bleProcedure->session, &sessionIndex);
+    HAPAssert(found);
+    uint16_t mtu = ((const HAPAccessoryServer*) bleProcedure->server)->ble.connections[sessionIndex].mtu;
+    if (mtu) {
+        HAPAssert(mtu >= kHAPPlatformBLEPeripheralManager_MinMTU);
+        size_t numOperationBytes = (size_t) mtu - 1;
+        if (maxBytes + 1 >= numOperationBytes) {
+            maxIntermediateBytes = maxBytes - (maxBytes + 1) % numOperationBytes;
+        }
+    }
+
     // Encrypted packets have an auth tag in the end. Available capacity is lower in that case.
     if (bleProcedure->startedSecured) {
         if (maxBytes < CHACHA20_POLY1305_TAG_BYTES) {
@@ -1267,6 +1292,8 @@ HAPError HAPBLEProcedureHandleGATTRead(
             return kHAPError_OutOfResources;
         }
         maxBytes -= CHACHA20_POLY1305_TAG_BYTES;
+        HAPAssert(maxIntermediateBytes >= CHACHA20_POLY1305_TAG_BYTES);
+        maxIntermediateBytes -= CHACHA20_POLY1305_TAG_BYTES;
     }
 
     // Process pending request.
@@ -1280,7 +1307,8 @@ HAPError HAPBLEProcedureHandleGATTRead(
 
     // Prepare next response fragment.
     bool isFinalFragment;
-    err = HAPBLETransactionHandleRead(&bleProcedure->transaction, bytes, maxBytes, numBytes, &isFinalFragment);
+    err = HAPBLETransactionHandleRead(
+            &bleProcedure->transaction, bytes, maxBytes, maxIntermediateBytes, numBytes, &isFinalFragment);
     if (err) {
         HAPAssert(err == kHAPError_InvalidState || err == kHAPError_OutOfResources);
         return err;
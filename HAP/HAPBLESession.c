@@ -54,16 +54,19 @@ static void SafeToDisconnectTimerExpired(HAPPlatformTimerRef timer, void* _Nulla
 
     bleSession->isSafeToDisconnect = true;
 
+    size_t sessionIndex;
+    bool found = HAPAccessoryServerGetBLESessionIndex(server_, bleSession->session, &sessionIndex);
+    HAPAssert(found);
+    const HAPBLEAccessoryServerConnection* connection = &server->ble.connections[sessionIndex];
+
     if (HAPBLESessionIsTerminal(bleSession)) {
         HAPLogInfo(
                 &logObject,
                 "Disconnecting BLE connection - Security session marked terminal (safe to disconnect timer).");
-        HAPPlatformBLEPeripheralManagerCancelCentralConnection(
-                blePeripheralManager, server->ble.connection.connectionHandle);
+        HAPPlatformBLEPeripheralManagerCancelCentralConnection(blePeripheralManager, connection->connectionHandle);
     } else if (server->state != kHAPAccessoryServerState_Running) {
         HAPLogInfo(&logObject, "Disconnecting BLE connection - Server is stopping (safe to disconnect timer).");
-        HAPPlatformBLEPeripheralManagerCancelCentralConnection(
-                blePeripheralManager, server->ble.connection.connectionHandle);
+        HAPPlatformBLEPeripheralManagerCancelCentralConnection(blePeripheralManager, connection->connectionHandle);
     }
 }
 
@@ -137,10 +140,13 @@ void HAPBLESessionInvalidate(HAPAccessoryServerRef* server_, HAPBLESession* bleS
 
     if (terminateLink) {
         bleSession->isTerminal = true;
-        if (HAPBLESessionIsSafeToDisconnect(bleSession) && server->ble.connection.connected) {
+        size_t sessionIndex;
+        if (HAPBLESessionIsSafeToDisconnect(bleSession) &&
+            HAPAccessoryServerGetBLESessionIndex(server_, bleSession->session, &sessionIndex) &&
+            server->ble.connections[sessionIndex].connected) {
             HAPLogInfo(&logObject, "Disconnecting connection - Security session marked terminal.");
             HAPPlatformBLEPeripheralManagerCancelCentralConnection(
-                    blePeripheralManager, server->ble.connection.connectionHandle);
+                    blePeripheralManager, server->ble.connections[sessionIndex].connectionHandle);
         }
     }
     if (bleSession->pairingProcedureTimer) {
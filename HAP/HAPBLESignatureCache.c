@@ -0,0 +1,345 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "BLESignatureCache" };
+
+/**
+ * Kind of signature stored in a cache entry.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPBLESignatureCacheEntryKind) { /** HAP-Characteristic-Signature-Read-Response. */
+                                                         kHAPBLESignatureCacheEntryKind_Characteristic = 1,
+
+                                                         /** HAP-Service-Signature-Read-Response. */
+                                                         kHAPBLESignatureCacheEntryKind_Service
+} HAP_ENUM_END(uint8_t, HAPBLESignatureCacheEntryKind);
+
+/**
+ * BLE signature cache entry.
+ *
+ * - The signature cache buffer holds the serialized signatures, starting at the beginning of the buffer,
+ *   and an array of cache entries at the end of the buffer. Cache entries are sorted by kind and instance ID.
+ */
+typedef struct {
+    /** Offset of the serialized signature within the signature cache buffer. */
+    uint32_t offset;
+
+    /** Length of the serialized signature. */
+    uint16_t numBytes;
+
+    /** Instance ID of the characteristic or service. */
+    uint16_t iid;
+
+    /** Kind of signature. */
+    HAPBLESignatureCacheEntryKind kind;
+
+    /** Type of the last TLV item in the serialized signature. */
+    HAPTLVType lastType;
+} HAPBLESignatureCacheEntry;
+
+/**
+ * Gets the end of the signature cache buffer, aligned for cache entries.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return Aligned end of the signature cache buffer.
+ */
+HAP_RESULT_USE_CHECK
+static uintptr_t GetAlignedEnd(HAPAccessoryServer* server) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->ble.storage->signatureCache.bytes);
+
+    // Cache entries only contain fields of up to 4 bytes.
+    uintptr_t end =
+            (uintptr_t) server->ble.storage->signatureCache.bytes + server->ble.storage->signatureCache.numBytes;
+    return end - end % sizeof(uint32_t);
+}
+
+/**
+ * Gets the array of cache entries.
+ *
+ * @param      server               Accessory server.
+ * @param      numEntries           Number of cache entries.
+ *
+ * @return Array of cache entries.
+ */
+HAP_RESULT_USE_CHECK
+static HAPBLESignatureCacheEntry* GetEntries(HAPAccessoryServer* server, size_t numEntries) {
+    HAPPrecondition(server);
+
+    return (HAPBLESignatureCacheEntry*) (GetAlignedEnd(server) - numEntries * sizeof(HAPBLESignatureCacheEntry));
+}
+
+/**
+ * Compares two cache entries by kind and instance ID.
+ *
+ * @param      entry                Cache entry.
+ * @param      kind                 Kind of signature to compare with.
+ * @param      iid                  Instance ID to compare with.
+ *
+ * @return < 0                      If the cache entry is ordered before the given key.
+ * @return 0                        If the cache entry matches the given key.
+ * @return > 0                      If the cache entry is ordered after the given key.
+ */
+HAP_RESULT_USE_CHECK
+static int CompareEntry(const HAPBLESignatureCacheEntry* entry, HAPBLESignatureCacheEntryKind kind, uint16_t iid) {
+    HAPPrecondition(entry);
+
+    if (entry->kind != kind) {
+        return entry->kind < kind ? -1 : 1;
+    }
+    if (entry->iid != iid) {
+        return entry->iid < iid ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Serializes a signature into the signature cache buffer and adds a cache entry for it.
+ *
+ * @param      server               Accessory server.
+ * @param      kind                 Kind of signature.
+ * @param      characteristic       Characteristic. NULL for service signatures.
+ * @param      service              Service.
+ * @param[in,out] numSignatureBytes Number of bytes used by serialized signatures.
+ *
+ * @return true                     If the signature has been added.
+ * @return false                    If the signature cache buffer is full.
+ */
+HAP_RESULT_USE_CHECK
+static bool AddEntry(
+        HAPAccessoryServer* server,
+        HAPBLESignatureCacheEntryKind kind,
+        const HAPCharacteristic* _Nullable characteristic,
+        const HAPService* service,
+        size_t* numSignatureBytes) {
+    HAPPrecondition(server);
+    HAPPrecondition(service);
+    HAPPrecondition(numSignatureBytes);
+
+    HAPError err;
+
+    uint8_t* bytes = server->ble.storage->signatureCache.bytes;
+    uintptr_t end = (uintptr_t) GetEntries(server, server->ble.signatureCache.numEntries + 1);
+    if (end < (uintptr_t) &bytes[*numSignatureBytes]) {
+        return false;
+    }
+    size_t maxBytes = (size_t)(end - (uintptr_t) &bytes[*numSignatureBytes]);
+
+    // Serialize signature.
+    HAPTLVWriterRef writer;
+    HAPTLVWriterCreate(&writer, &bytes[*numSignatureBytes], HAPMin(maxBytes, UINT16_MAX));
+    uint16_t iid;
+    if (kind == kHAPBLESignatureCacheEntryKind_Characteristic) {
+        HAPPrecondition(characteristic);
+        iid = (uint16_t)((const HAPBaseCharacteristic*) characteristic)->iid;
+        err = HAPBLECharacteristicGetSignatureReadResponse(HAPNonnullVoid(characteristic), service, &writer);
+    } else {
+        HAPPrecondition(!characteristic);
+        iid = (uint16_t) service->iid;
+        err = HAPBLEServiceGetSignatureReadResponse(service, &writer);
+    }
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        return false;
+    }
+    const HAPTLVWriter* tlvWriter = (const HAPTLVWriter*) &writer;
+
+    // Add cache entry.
+    HAPBLESignatureCacheEntry* entry = GetEntries(server, server->ble.signatureCache.numEntries + 1);
+    HAPRawBufferZero(entry, sizeof *entry);
+    entry->offset = (uint32_t) *numSignatureBytes;
+    entry->numBytes = (uint16_t) tlvWriter->numBytes;
+    entry->iid = iid;
+    entry->kind = kind;
+    entry->lastType = tlvWriter->lastType;
+    server->ble.signatureCache.numEntries++;
+    *numSignatureBytes += tlvWriter->numBytes;
+    return true;
+}
+
+void HAPBLESignatureCacheCreate(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ble.storage);
+    HAPPrecondition(server->primaryAccessory);
+    const HAPAccessory* accessory = server->primaryAccessory;
+
+    HAPBLESignatureCacheRelease(server_);
+    if (!server->ble.storage->signatureCache.bytes) {
+        return;
+    }
+    HAPPrecondition(server->ble.storage->signatureCache.numBytes <= UINT32_MAX);
+
+    // Serialize signatures. Cache entries are added in reverse order in front of the previously added ones.
+    // Signatures that do not fit are skipped so that smaller signatures later in the database may still be cached.
+    size_t numSignatureBytes = 0;
+    bool isFull = false;
+    size_t numSignatures = 0;
+    if (accessory->services) {
+        for (size_t i = 0; accessory->services[i]; i++) {
+            const HAPService* service = accessory->services[i];
+            if (!HAPAccessoryServerSupportsService(server_, kHAPTransportType_BLE, service)) {
+                continue;
+            }
+            numSignatures++;
+            if (!AddEntry(server, kHAPBLESignatureCacheEntryKind_Service, NULL, service, &numSignatureBytes)) {
+                isFull = true;
+            }
+            if (service->characteristics) {
+                for (size_t j = 0; service->characteristics[j]; j++) {
+                    const HAPCharacteristic* characteristic = service->characteristics[j];
+                    numSignatures++;
+                    if (!AddEntry(
+                                server,
+                                kHAPBLESignatureCacheEntryKind_Characteristic,
+                                characteristic,
+                                service,
+                                &numSignatureBytes)) {
+                        isFull = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // Sort cache entries. Attribute databases are usually ordered by instance ID already.
+    size_t numEntries = server->ble.signatureCache.numEntries;
+    HAPBLESignatureCacheEntry* entries = GetEntries(server, numEntries);
+    for (size_t i = 1; i < numEntries; i++) {
+        HAPBLESignatureCacheEntry entry = entries[i];
+        size_t j = i;
+        while (j && CompareEntry(&entries[j - 1], entry.kind, entry.iid) > 0) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = entry;
+    }
+
+    if (isFull) {
+        HAPLog(&logObject,
+               "Signature cache capacity not large enough to store all signatures (%zu / %zu stored). "
+               "Remaining signatures are serialized on request.",
+               numEntries,
+               numSignatures);
+    }
+    HAPLogDebug(
+            &logObject,
+            "Signature cache: %zu signatures (%zu bytes + %zu bytes index).",
+            numEntries,
+            numSignatureBytes,
+            numEntries * sizeof(HAPBLESignatureCacheEntry));
+}
+
+void HAPBLESignatureCacheRelease(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPRawBufferZero(&server->ble.signatureCache, sizeof server->ble.signatureCache);
+}
+
+/**
+ * Finds the cache entry for a signature.
+ *
+ * @param      server               Accessory server.
+ * @param      kind                 Kind of signature.
+ * @param      iid                  Instance ID of the characteristic or service.
+ *
+ * @return Cache entry, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static const HAPBLESignatureCacheEntry* _Nullable FindEntry(
+        HAPAccessoryServer* server,
+        HAPBLESignatureCacheEntryKind kind,
+        uint64_t iid) {
+    HAPPrecondition(server);
+
+    size_t numEntries = server->ble.signatureCache.numEntries;
+    if (!numEntries || iid > UINT16_MAX) {
+        return NULL;
+    }
+    const HAPBLESignatureCacheEntry* entries = GetEntries(server, numEntries);
+    size_t lower = 0;
+    size_t upper = numEntries;
+    while (lower < upper) {
+        size_t middle = lower + (upper - lower) / 2;
+        int result = CompareEntry(&entries[middle], kind, (uint16_t) iid);
+        if (!result) {
+            return &entries[middle];
+        }
+        if (result < 0) {
+            lower = middle + 1;
+        } else {
+            upper = middle;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Appends the signature of a cache entry to a response writer.
+ *
+ * @param      server               Accessory server.
+ * @param      entry                Cache entry.
+ * @param      responseWriter       Writer to serialize signature into.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If writer does not have enough capacity.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError AppendEntry(
+        HAPAccessoryServer* server,
+        const HAPBLESignatureCacheEntry* entry,
+        HAPTLVWriterRef* responseWriter) {
+    HAPPrecondition(server);
+    HAPPrecondition(entry);
+    HAPPrecondition(responseWriter);
+
+    const uint8_t* bytes = server->ble.storage->signatureCache.bytes;
+    return HAPTLVWriterAppendSerialized(responseWriter, &bytes[entry->offset], entry->numBytes, entry->lastType);
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLESignatureCacheGetCharacteristicSignatureReadResponse(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        HAPTLVWriterRef* responseWriter) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(responseWriter);
+
+    const HAPBLESignatureCacheEntry* _Nullable entry = FindEntry(
+            server,
+            kHAPBLESignatureCacheEntryKind_Characteristic,
+            ((const HAPBaseCharacteristic*) characteristic)->iid);
+    if (entry) {
+        return AppendEntry(server, HAPNonnull(entry), responseWriter);
+    }
+    return HAPBLECharacteristicGetSignatureReadResponse(characteristic, service, responseWriter);
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPBLESignatureCacheGetServiceSignatureReadResponse(
+        HAPAccessoryServerRef* server_,
+        const HAPService* _Nullable service,
+        HAPTLVWriterRef* responseWriter) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(responseWriter);
+
+    if (service) {
+        const HAPBLESignatureCacheEntry* _Nullable entry =
+                FindEntry(server, kHAPBLESignatureCacheEntryKind_Service, service->iid);
+        if (entry) {
+            return AppendEntry(server, HAPNonnull(entry), responseWriter);
+        }
+    }
+    return HAPBLEServiceGetSignatureReadResponse(service, responseWriter);
+}
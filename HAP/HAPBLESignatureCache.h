@@ -0,0 +1,84 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_BLE_SIGNATURE_CACHE_H
+#define HAP_BLE_SIGNATURE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Precomputes the signature responses of the primary accessory into the BLE signature cache.
+ *
+ * - Signatures that do not fit into the BLE signature cache are serialized on request.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPBLESignatureCacheCreate(HAPAccessoryServerRef* server);
+
+/**
+ * Invalidates all entries of the BLE signature cache.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPBLESignatureCacheRelease(HAPAccessoryServerRef* server);
+
+/**
+ * Serializes the body of a HAP-Characteristic-Signature-Read-Response, using the BLE signature cache if possible.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      responseWriter       Writer to serialize Characteristic Signature into.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If writer does not have enough capacity.
+ *
+ * @see HomeKit Accessory Protocol Specification R14
+ *      Section 7.3.4.2 HAP-Characteristic-Signature-Read-Response
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLESignatureCacheGetCharacteristicSignatureReadResponse(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        HAPTLVWriterRef* responseWriter);
+
+/**
+ * Serializes the body of a HAP-Service-Signature-Read-Response, using the BLE signature cache if possible.
+ *
+ * @param      server               Accessory server.
+ * @param      service              Service. NULL if the request had an invalid IID.
+ * @param      responseWriter       Writer to serialize Service Signature into.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If writer does not have enough capacity.
+ *
+ * @see HomeKit Accessory Protocol Specification R14
+ *      Section 7.3.4.13 HAP-Service-Signature-Read-Response
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPBLESignatureCacheGetServiceSignatureReadResponse(
+        HAPAccessoryServerRef* server,
+        const HAPService* _Nullable service,
+        HAPTLVWriterRef* responseWriter);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
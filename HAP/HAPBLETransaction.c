@@ -207,15 +207,51 @@ void HAPBLETransactionSetResponse(
     }
 }
 
+/**
+ * Computes the length of the next response body fragment.
+ *
+ * @param      bleTransaction       Transaction.
+ * @param      numHeaderBytes       Length of the PDU header.
+ * @param      maxBytes             Capacity of the PDU.
+ * @param      maxIntermediateBytes Preferred capacity of the PDU if further fragments follow.
+ *
+ * @return Length of the next response body fragment.
+ */
+HAP_RESULT_USE_CHECK
+static size_t GetResponseFragmentLength(
+        const HAPBLETransaction* bleTransaction,
+        size_t numHeaderBytes,
+        size_t maxBytes,
+        size_t maxIntermediateBytes) {
+    HAPPrecondition(bleTransaction);
+    HAPPrecondition(numHeaderBytes <= maxBytes);
+    HAPPrecondition(maxIntermediateBytes <= maxBytes);
+
+    size_t numRemainingBytes = bleTransaction->_.response.totalBodyBytes - bleTransaction->_.response.bodyOffset;
+    HAPAssert(numRemainingBytes <= UINT16_MAX);
+    if (maxBytes - numHeaderBytes >= numRemainingBytes) {
+        // Final fragment.
+        return numRemainingBytes;
+    }
+
+    // Further fragments follow.
+    if (maxIntermediateBytes > numHeaderBytes) {
+        return maxIntermediateBytes - numHeaderBytes;
+    }
+    return maxBytes - numHeaderBytes;
+}
+
 HAP_RESULT_USE_CHECK
 HAPError HAPBLETransactionHandleRead(
         HAPBLETransaction* bleTransaction,
         void* bytes,
         size_t maxBytes,
+        size_t maxIntermediateBytes,
         size_t* numBytes,
         bool* isFinalFragment) {
     HAPPrecondition(bleTransaction);
     HAPPrecondition(bytes);
+    HAPPrecondition(maxIntermediateBytes <= maxBytes);
     HAPPrecondition(numBytes);
     HAPPrecondition(isFinalFragment);
 
@@ -236,11 +272,8 @@ HAPError HAPBLETransactionHandleRead(
             }
 
             // Calculate body fragment length.
-            size_t numFragmentBytes = bleTransaction->_.response.totalBodyBytes;
-            HAPAssert(numFragmentBytes <= UINT16_MAX);
-            if (maxBytes - numHeaderBytes < numFragmentBytes) {
-                numFragmentBytes = maxBytes - numHeaderBytes;
-            }
+            size_t numFragmentBytes =
+                    GetResponseFragmentLength(bleTransaction, numHeaderBytes, maxBytes, maxIntermediateBytes);
 
             // Serialize HAP-BLE PDU.
             HAPBLEPDU pdu;
@@ -275,11 +308,8 @@ HAPError HAPBLETransactionHandleRead(
             }
 
             // Calculate body fragment length.
-            size_t numFragmentBytes = bleTransaction->_.response.totalBodyBytes - bleTransaction->_.response.bodyOffset;
-            HAPAssert(numFragmentBytes <= UINT16_MAX);
-            if (maxBytes - numHeaderBytes < numFragmentBytes) {
-                numFragmentBytes = maxBytes - numHeaderBytes;
-            }
+            size_t numFragmentBytes =
+                    GetResponseFragmentLength(bleTransaction, numHeaderBytes, maxBytes, maxIntermediateBytes);
             HAPAssert(bleTransaction->_.response.bodyBytes);
 
             // Serialize HAP-BLE PDU.
@@ -170,6 +170,7 @@ void HAPBLETransactionSetResponse(
  * @param      bleTransaction       Transaction.
  * @param[out] bytes                Buffer to put fragment data into.
  * @param      maxBytes             Capacity of buffer.
+ * @param      maxIntermediateBytes Capacity to use if further fragments follow. At most maxBytes.
  * @param[out] numBytes             Length of fragment put into buffer.
  * @param[out] isFinalFragment      true If all data fragments have been produced; false Otherwise.
  *
@@ -182,6 +183,7 @@ HAPError HAPBLETransactionHandleRead(
         HAPBLETransaction* bleTransaction,
         void* bytes,
         size_t maxBytes,
+        size_t maxIntermediateBytes,
         size_t* numBytes,
         bool* isFinalFragment);
 
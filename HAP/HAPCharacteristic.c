@@ -42,6 +42,167 @@ bool HAPCharacteristicWriteRequiresAdminPermissions(const HAPCharacteristic* cha
     return writeRequiresAdminPermissions;
 }
 
+/**
+ * Handles a read or write handler that reported that the request completes asynchronously.
+ *
+ * - Asynchronous completion is only supported for requests that have been assigned a completion token.
+ *   Other requests must be answered immediately and are reported as failed temporarily.
+ *
+ * @param      completionToken      Completion token of the request.
+ * @param      characteristic       The characteristic that is accessed.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ *
+ * @return kHAPError_InProgress     If the request completes asynchronously.
+ * @return kHAPError_Busy           If the request does not support asynchronous completion.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError HandleInProgress(
+        HAPCompletionToken completionToken,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory) {
+    if (completionToken == kHAPCompletionToken_None) {
+        HAPLogCharacteristic(
+                &logObject,
+                characteristic,
+                service,
+                accessory,
+                "Request does not support asynchronous completion. Reporting as busy.");
+        return kHAPError_Busy;
+    }
+
+    HAPLogCharacteristicInfo(
+            &logObject,
+            characteristic,
+            service,
+            accessory,
+            "Request completes asynchronously (completion token %lu).",
+            (unsigned long) completionToken);
+    return kHAPError_InProgress;
+}
+
+/**
+ * Returns whether the value of a read is provided by HAPAccessoryServerCompleteRead instead of the read handler.
+ *
+ * @param      server_              Accessory server.
+ *
+ * @return true                     If an asynchronous read is being completed.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsReadBeingCompleted(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+
+    return server->completedRead.isSet;
+}
+
+/**
+ * Gets the value of an asynchronous read that is being completed through HAPAccessoryServerCompleteRead.
+ *
+ * @param      server_              Accessory server.
+ * @param      characteristic       The characteristic that is read.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param[out] valueBytes           Value buffer.
+ * @param      maxValueBytes        Capacity of value buffer.
+ * @param[out] numValueBytes        Length of value. If NULL, the value must have a length of exactly @p maxValueBytes.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the value buffer is not large enough.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError GetCompletedReadValue(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        void* valueBytes,
+        size_t maxValueBytes,
+        size_t* _Nullable numValueBytes) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(server->completedRead.isSet);
+    HAPPrecondition(valueBytes);
+
+    HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Using value of completed read.");
+    if (!numValueBytes) {
+        // Numeric values are passed in the representation of the read handler.
+        HAPPrecondition(server->completedRead.numBytes == maxValueBytes);
+    } else if (server->completedRead.numBytes > maxValueBytes) {
+        HAPLogCharacteristic(
+                &logObject,
+                characteristic,
+                service,
+                accessory,
+                "Completed read value too long: %zu bytes (available %zu bytes).",
+                server->completedRead.numBytes,
+                maxValueBytes);
+        return kHAPError_OutOfResources;
+    }
+    if (server->completedRead.numBytes) {
+        HAPRawBufferCopyBytes(
+                valueBytes, HAPNonnullVoid(server->completedRead.bytes), server->completedRead.numBytes);
+    }
+    if (numValueBytes) {
+        *numValueBytes = server->completedRead.numBytes;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Appends the serialized TLV items of an asynchronous read that is being completed through
+ * HAPAccessoryServerCompleteRead.
+ *
+ * @param      server_              Accessory server.
+ * @param      characteristic       The characteristic that is read.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param      responseWriter       TLV writer to append the TLV items to.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the TLV writer does not have enough capacity.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError AppendCompletedReadTLVItems(
+        HAPAccessoryServerRef* server_,
+        const HAPTLV8Characteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        HAPTLVWriterRef* responseWriter) {
+    HAPPrecondition(server_);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) server_;
+    HAPPrecondition(server->completedRead.isSet);
+    HAPPrecondition(responseWriter);
+
+    HAPError err;
+
+    HAPLogCharacteristicInfo(&logObject, characteristic, service, accessory, "Using value of completed read.");
+    if (!server->completedRead.numBytes) {
+        return kHAPError_None;
+    }
+
+    // Find type of the last TLV item.
+    const uint8_t* bytes = HAPNonnullVoid(server->completedRead.bytes);
+    size_t numBytes = server->completedRead.numBytes;
+    HAPTLVType lastType = 0;
+    for (size_t i = 0; i < numBytes;) {
+        HAPPrecondition(numBytes - i >= 2);
+        lastType = bytes[i];
+        HAPPrecondition(bytes[i + 1] <= numBytes - i - 2);
+        i += 2 + bytes[i + 1];
+    }
+
+    err = HAPTLVWriterAppendSerialized(responseWriter, bytes, numBytes, lastType);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        HAPLogCharacteristic(&logObject, characteristic, service, accessory, "Completed read value too long.");
+        return err;
+    }
+    return kHAPError_None;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #define IS_VALUE_IN_RANGE(value, constraints) \
@@ -104,11 +265,30 @@ HAPError HAPDataCharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(
-            server, request, valueBytes, maxValueBytes, numValueBytes, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = GetCompletedReadValue(
+                server,
+                request->characteristic,
+                request->service,
+                request->accessory,
+                valueBytes,
+                maxValueBytes,
+                numValueBytes);
+    } else {
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(
+                server, request, valueBytes, maxValueBytes, numValueBytes, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -141,6 +321,83 @@ HAPError HAPDataCharacteristicHandleRead(
     return kHAPError_None;
 }
 
+HAP_RESULT_USE_CHECK
+HAPError HAPDataCharacteristicHandleReadChunk(
+        HAPAccessoryServerRef* server,
+        const HAPDataCharacteristicReadRequest* request,
+        size_t offset,
+        void* valueBytes,
+        size_t maxValueBytes,
+        size_t* numValueBytes,
+        bool* isComplete,
+        void* _Nullable context) {
+    HAPPrecondition(server);
+    HAPPrecondition(request);
+    HAPPrecondition(request->characteristic);
+    HAPPrecondition(request->characteristic->format == kHAPCharacteristicFormat_Data);
+    HAPPrecondition(request->characteristic->debugDescription);
+    HAPPrecondition(request->characteristic->callbacks.handleReadChunk);
+    HAPPrecondition(request->accessory);
+    HAPPrecondition(valueBytes);
+    HAPPrecondition(maxValueBytes);
+    HAPPrecondition(numValueBytes);
+    HAPPrecondition(isComplete);
+
+    HAPError err;
+
+    // Call handler.
+    HAPLogCharacteristicDebug(
+            &logObject,
+            request->characteristic,
+            request->service,
+            request->accessory,
+            "Calling read chunk handler (offset %zu).",
+            offset);
+    *isComplete = false;
+    err = request->characteristic->callbacks.handleReadChunk(
+            server, request, offset, valueBytes, maxValueBytes, numValueBytes, isComplete, context);
+    if (err) {
+        HAPAssert(
+                err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
+                err == kHAPError_Busy);
+        HAPLogCharacteristic(
+                &logObject,
+                request->characteristic,
+                request->service,
+                request->accessory,
+                "Read chunk handler failed with error %u.",
+                err);
+        return err;
+    }
+    if (*numValueBytes > maxValueBytes) {
+        HAPLogCharacteristicError(
+                &logObject,
+                request->characteristic,
+                request->service,
+                request->accessory,
+                "Read data chunk exceeds available buffer space (%zu bytes / available %zu bytes).",
+                *numValueBytes,
+                maxValueBytes);
+        HAPFatalError();
+    }
+    if (!*numValueBytes && !*isComplete) {
+        HAPLogCharacteristicError(
+                &logObject,
+                request->characteristic,
+                request->service,
+                request->accessory,
+                "Read chunk handler returned an empty chunk before the end of the value.");
+        HAPFatalError();
+    }
+
+    // Validate constraints.
+    HAPAssert(offset <= SIZE_MAX - *numValueBytes);
+    HAPAssert(HAPDataCharacteristicIsValueFulfillingConstraints(
+            request->characteristic, request->service, request->accessory, offset + *numValueBytes));
+
+    return kHAPError_None;
+}
+
 HAP_RESULT_USE_CHECK
 HAPError HAPDataCharacteristicHandleWrite(
         HAPAccessoryServerRef* server,
@@ -169,6 +426,12 @@ HAPError HAPDataCharacteristicHandleWrite(
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, valueBytes, numValueBytes, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -265,10 +528,29 @@ HAPError HAPBoolCharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = GetCompletedReadValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value, NULL);
+    } else {
+        // Serve value from cache.
+        if (HAPCharacteristicValueCacheGet(
+                    server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+            return kHAPError_None;
+        }
+
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, value, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -287,6 +569,10 @@ HAPError HAPBoolCharacteristicHandleRead(
     HAPAssert(HAPBoolCharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Store value in cache.
+    HAPCharacteristicValueCacheSet(
+            server, request->characteristic, request->service, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -312,10 +598,19 @@ HAPError HAPBoolCharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Invalidate cached value.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->service, request->accessory);
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -474,10 +769,29 @@ HAPError HAPUInt8CharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = GetCompletedReadValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value, NULL);
+    } else {
+        // Serve value from cache.
+        if (HAPCharacteristicValueCacheGet(
+                    server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+            return kHAPError_None;
+        }
+
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, value, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -496,6 +810,10 @@ HAPError HAPUInt8CharacteristicHandleRead(
     HAPAssert(HAPUInt8CharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Store value in cache.
+    HAPCharacteristicValueCacheSet(
+            server, request->characteristic, request->service, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -521,10 +839,19 @@ HAPError HAPUInt8CharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Invalidate cached value.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->service, request->accessory);
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -630,10 +957,29 @@ HAPError HAPUInt16CharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = GetCompletedReadValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value, NULL);
+    } else {
+        // Serve value from cache.
+        if (HAPCharacteristicValueCacheGet(
+                    server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+            return kHAPError_None;
+        }
+
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, value, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -652,6 +998,10 @@ HAPError HAPUInt16CharacteristicHandleRead(
     HAPAssert(HAPUInt16CharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Store value in cache.
+    HAPCharacteristicValueCacheSet(
+            server, request->characteristic, request->service, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -677,10 +1027,19 @@ HAPError HAPUInt16CharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Invalidate cached value.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->service, request->accessory);
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -786,10 +1145,29 @@ HAPError HAPUInt32CharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = GetCompletedReadValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value, NULL);
+    } else {
+        // Serve value from cache.
+        if (HAPCharacteristicValueCacheGet(
+                    server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+            return kHAPError_None;
+        }
+
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, value, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -808,6 +1186,10 @@ HAPError HAPUInt32CharacteristicHandleRead(
     HAPAssert(HAPUInt32CharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Store value in cache.
+    HAPCharacteristicValueCacheSet(
+            server, request->characteristic, request->service, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -833,10 +1215,19 @@ HAPError HAPUInt32CharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Invalidate cached value.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->service, request->accessory);
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -942,10 +1333,29 @@ HAPError HAPUInt64CharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = GetCompletedReadValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value, NULL);
+    } else {
+        // Serve value from cache.
+        if (HAPCharacteristicValueCacheGet(
+                    server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+            return kHAPError_None;
+        }
+
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, value, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -964,6 +1374,10 @@ HAPError HAPUInt64CharacteristicHandleRead(
     HAPAssert(HAPUInt64CharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Store value in cache.
+    HAPCharacteristicValueCacheSet(
+            server, request->characteristic, request->service, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -989,10 +1403,19 @@ HAPError HAPUInt64CharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Invalidate cached value.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->service, request->accessory);
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -1098,10 +1521,29 @@ HAPError HAPIntCharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = GetCompletedReadValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value, NULL);
+    } else {
+        // Serve value from cache.
+        if (HAPCharacteristicValueCacheGet(
+                    server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+            return kHAPError_None;
+        }
+
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, value, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -1120,6 +1562,10 @@ HAPError HAPIntCharacteristicHandleRead(
     HAPAssert(HAPIntCharacteristicIsValueFulfillingConstraints(
             request->characteristic, request->service, request->accessory, *value));
 
+    // Store value in cache.
+    HAPCharacteristicValueCacheSet(
+            server, request->characteristic, request->service, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -1145,10 +1591,19 @@ HAPError HAPIntCharacteristicHandleWrite(
         return kHAPError_InvalidData;
     }
 
+    // Invalidate cached value.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->service, request->accessory);
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -1310,10 +1765,29 @@ HAPError HAPFloatCharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, value, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = GetCompletedReadValue(
+                server, request->characteristic, request->service, request->accessory, value, sizeof *value, NULL);
+    } else {
+        // Serve value from cache.
+        if (HAPCharacteristicValueCacheGet(
+                    server, request->characteristic, request->service, request->accessory, value, sizeof *value)) {
+            return kHAPError_None;
+        }
+
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, value, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -1335,6 +1809,10 @@ HAPError HAPFloatCharacteristicHandleRead(
     // Round to step.
     *value = HAPFloatCharacteristicRoundValueToStep(request->characteristic, *value);
 
+    // Store value in cache.
+    HAPCharacteristicValueCacheSet(
+            server, request->characteristic, request->service, request->accessory, value, sizeof *value);
+
     return kHAPError_None;
 }
 
@@ -1363,10 +1841,19 @@ HAPError HAPFloatCharacteristicHandleWrite(
     // Round to step.
     value = HAPFloatCharacteristicRoundValueToStep(request->characteristic, value);
 
+    // Invalidate cached value.
+    HAPCharacteristicValueCacheInvalidate(server, request->characteristic, request->service, request->accessory);
+
     // Call handler.
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -1486,10 +1973,33 @@ HAPError HAPStringCharacteristicHandleRead(
     // Set NULL-terminator.
     value[maxValueBytes - 1] = '\0';
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, value, maxValueBytes, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        size_t numValueBytes;
+        err = GetCompletedReadValue(
+                server,
+                request->characteristic,
+                request->service,
+                request->accessory,
+                value,
+                maxValueBytes - 1,
+                &numValueBytes);
+        if (!err) {
+            value[numValueBytes] = '\0';
+        }
+    } else {
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, value, maxValueBytes, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -1561,6 +2071,12 @@ HAPError HAPStringCharacteristicHandleWrite(
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, value, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -1643,10 +2159,23 @@ HAPError HAPTLV8CharacteristicHandleRead(
 
     HAPError err;
 
-    // Call handler.
-    HAPLogCharacteristicInfo(
-            &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
-    err = request->characteristic->callbacks.handleRead(server, request, responseWriter, context);
+    if (IsReadBeingCompleted(server)) {
+        // Use value of completed read.
+        err = AppendCompletedReadTLVItems(
+                server, request->characteristic, request->service, request->accessory, responseWriter);
+    } else {
+        // Call handler.
+        HAPLogCharacteristicInfo(
+                &logObject, request->characteristic, request->service, request->accessory, "Calling read handler.");
+        err = request->characteristic->callbacks.handleRead(server, request, responseWriter, context);
+        if (err == kHAPError_InProgress) {
+            err = HandleInProgress(
+                    request->completionToken, request->characteristic, request->service, request->accessory);
+            if (err == kHAPError_InProgress) {
+                return err;
+            }
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_OutOfResources ||
@@ -1685,6 +2214,12 @@ HAPError HAPTLV8CharacteristicHandleWrite(
     HAPLogCharacteristicInfo(
             &logObject, request->characteristic, request->service, request->accessory, "Calling write handler.");
     err = request->characteristic->callbacks.handleWrite(server, request, requestReader, context);
+    if (err == kHAPError_InProgress) {
+        err = HandleInProgress(request->completionToken, request->characteristic, request->service, request->accessory);
+        if (err == kHAPError_InProgress) {
+            return err;
+        }
+    }
     if (err) {
         HAPAssert(
                 err == kHAPError_Unknown || err == kHAPError_InvalidState || err == kHAPError_InvalidData ||
@@ -333,6 +333,38 @@ HAPError HAPDataCharacteristicHandleRead(
         size_t* numValueBytes,
         void* _Nullable context);
 
+/**
+ * Reads the next part of a Data characteristic value using the streaming read handler.
+ *
+ * - It is ensured that the value read so far satisfies the constraints of the characteristic.
+ * - At least one byte is returned unless the end of the value has been reached.
+ *
+ * @param      server               Accessory server.
+ * @param      request              Request.
+ * @param      offset               Offset of the requested part within the value.
+ * @param[out] valueBytes           Value buffer.
+ * @param      maxValueBytes        Capacity of value buffer.
+ * @param[out] numValueBytes        Length of value buffer.
+ * @param[out] isComplete           Whether the end of the value has been reached.
+ * @param      context              The context parameter given to the HAPAccessoryServerCreate function.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If unable to perform operation with requested service or characteristic.
+ * @return kHAPError_InvalidState   If the request cannot be processed in the current state.
+ * @return kHAPError_OutOfResources If out of resources to process request.
+ * @return kHAPError_Busy           If the request failed temporarily.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPDataCharacteristicHandleReadChunk(
+        HAPAccessoryServerRef* server,
+        const HAPDataCharacteristicReadRequest* request,
+        size_t offset,
+        void* valueBytes,
+        size_t maxValueBytes,
+        size_t* numValueBytes,
+        bool* isComplete,
+        void* _Nullable context);
+
 /**
  * Writes a Data characteristic value.
  *
@@ -0,0 +1,452 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "CharacteristicValueCache" };
+
+/**
+ * Index that refers to no characteristic value cache element.
+ */
+#define kHAPCharacteristicValueCache_NoElement ((uint16_t) UINT16_MAX)
+
+/**
+ * Characteristic value cache element.
+ *
+ * - Elements are looked up through a hash table whose buckets are threaded through the elements.
+ *   If the attribute database is flattened, characteristics are hashed by the index of their characteristic record.
+ *
+ * - Elements are linked into a list that is ordered by last use. Unused elements are at the least recently used end.
+ */
+typedef struct {
+    /** Characteristic. NULL if the element is unused. */
+    const HAPCharacteristic* _Nullable characteristic;
+
+    /** The service that contains the characteristic. */
+    const HAPService* _Nullable service;
+
+    /** The accessory that provides the service. */
+    const HAPAccessory* _Nullable accessory;
+
+    /** Time at which the value has been stored. */
+    HAPTime storeTime;
+
+    /** Value. */
+    uint8_t valueBytes[kHAPCharacteristicValueCache_MaxValueBytes];
+
+    /** Index of the first element in the hash bucket with the same index as this element. */
+    uint16_t bucket;
+
+    /** Index of the next element in the same hash bucket. */
+    uint16_t nextInBucket;
+
+    /** Index of the next more recently used element. */
+    uint16_t moreRecentlyUsed;
+
+    /** Index of the next less recently used element. */
+    uint16_t lessRecentlyUsed;
+} HAPCharacteristicValueCacheElement;
+HAP_STATIC_ASSERT(
+        sizeof(HAPCharacteristicValueCacheElementRef) >= sizeof(HAPCharacteristicValueCacheElement),
+        HAPCharacteristicValueCacheElement);
+
+/**
+ * Returns whether values of a characteristic may be cached.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ *
+ * @return true                     If values of the characteristic may be cached.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsCacheable(const HAPAccessoryServer* server, const HAPCharacteristic* characteristic_) {
+    HAPPrecondition(server);
+    HAPPrecondition(characteristic_);
+    const HAPBaseCharacteristic* characteristic = characteristic_;
+
+    if (!server->valueCache.numElements || !characteristic->properties.cacheable) {
+        return false;
+    }
+    switch (characteristic->format) {
+        case kHAPCharacteristicFormat_Bool:
+        case kHAPCharacteristicFormat_UInt8:
+        case kHAPCharacteristicFormat_UInt16:
+        case kHAPCharacteristicFormat_UInt32:
+        case kHAPCharacteristicFormat_UInt64:
+        case kHAPCharacteristicFormat_Int:
+        case kHAPCharacteristicFormat_Float: {
+            return true;
+        }
+        case kHAPCharacteristicFormat_Data:
+        case kHAPCharacteristicFormat_String:
+        case kHAPCharacteristicFormat_TLV8: {
+            return false;
+        }
+    }
+    HAPFatalError();
+}
+
+/**
+ * Gets a cache element by index.
+ *
+ * @param      server               Accessory server.
+ * @param      index                Index of the cache element.
+ *
+ * @return Cache element.
+ */
+HAP_RESULT_USE_CHECK
+static HAPCharacteristicValueCacheElement* GetElement(HAPAccessoryServer* server, size_t index) {
+    HAPPrecondition(server);
+    HAPPrecondition(index < server->valueCache.numElements);
+
+    return &((HAPCharacteristicValueCacheElement*) HAPNonnull(server->valueCache.elements))[index];
+}
+
+/**
+ * Gets the index of a cache element.
+ *
+ * @param      server               Accessory server.
+ * @param      element              Cache element.
+ *
+ * @return Index of the cache element.
+ */
+HAP_RESULT_USE_CHECK
+static uint16_t GetElementIndex(const HAPAccessoryServer* server, const HAPCharacteristicValueCacheElement* element) {
+    HAPPrecondition(server);
+    HAPPrecondition(element);
+
+    const HAPCharacteristicValueCacheElement* elements =
+            (const HAPCharacteristicValueCacheElement*) HAPNonnull(server->valueCache.elements);
+    HAPAssert(element >= elements && (size_t)(element - elements) < server->valueCache.numElements);
+    return (uint16_t)(element - elements);
+}
+
+/**
+ * Gets the cache element that holds the hash bucket of a characteristic.
+ *
+ * - If the attribute database is flattened, the index of the characteristic record is used as the key.
+ *   Otherwise, the key is derived from the accessory instance ID and the characteristic instance ID.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ *
+ * @return Cache element that holds the hash bucket.
+ */
+HAP_RESULT_USE_CHECK
+static HAPCharacteristicValueCacheElement* GetBucketElement(
+        HAPAccessoryServer* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+
+    size_t key;
+    if (service && HAPAttributeDatabaseIsFlattened((HAPAccessoryServerRef*) server)) {
+        key = HAPAttributeDatabaseGetCharacteristicIndex(
+                (HAPAccessoryServerRef*) server, characteristic, HAPNonnull(service), accessory);
+    } else {
+        key = (size_t)(accessory->aid * 31 + ((const HAPBaseCharacteristic*) characteristic)->iid);
+    }
+    return GetElement(server, key % server->valueCache.numElements);
+}
+
+/**
+ * Finds the cache element of a characteristic.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ *
+ * @return Cache element of the characteristic, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPCharacteristicValueCacheElement* _Nullable FindElement(
+        HAPAccessoryServer* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+
+    const HAPCharacteristicValueCacheElement* bucketElement =
+            GetBucketElement(server, characteristic, service, accessory);
+    for (uint16_t i = bucketElement->bucket; i != kHAPCharacteristicValueCache_NoElement;) {
+        HAPCharacteristicValueCacheElement* element = GetElement(server, i);
+        if (element->characteristic == characteristic && element->service == service &&
+            element->accessory == accessory) {
+            return element;
+        }
+        i = element->nextInBucket;
+    }
+    return NULL;
+}
+
+/**
+ * Returns whether a used cache element has expired.
+ *
+ * @param      server               Accessory server.
+ * @param      element              Cache element.
+ * @param      now                  Current time.
+ *
+ * @return true                     If the time to live of the cached value has expired.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsElementExpired(
+        const HAPAccessoryServer* server,
+        const HAPCharacteristicValueCacheElement* element,
+        HAPTime now) {
+    HAPPrecondition(server);
+    HAPPrecondition(element);
+    HAPPrecondition(element->characteristic);
+
+    return server->valueCache.ttl && now - element->storeTime >= server->valueCache.ttl;
+}
+
+/**
+ * Removes a cache element from the list that is ordered by last use.
+ *
+ * @param      server               Accessory server.
+ * @param      element              Cache element.
+ */
+static void UnlinkElement(HAPAccessoryServer* server, HAPCharacteristicValueCacheElement* element) {
+    HAPPrecondition(server);
+    HAPPrecondition(element);
+
+    if (element->moreRecentlyUsed != kHAPCharacteristicValueCache_NoElement) {
+        GetElement(server, element->moreRecentlyUsed)->lessRecentlyUsed = element->lessRecentlyUsed;
+    } else {
+        HAPAssert(server->valueCache.mostRecentlyUsed == GetElementIndex(server, element));
+        server->valueCache.mostRecentlyUsed = element->lessRecentlyUsed;
+    }
+    if (element->lessRecentlyUsed != kHAPCharacteristicValueCache_NoElement) {
+        GetElement(server, element->lessRecentlyUsed)->moreRecentlyUsed = element->moreRecentlyUsed;
+    } else {
+        HAPAssert(server->valueCache.leastRecentlyUsed == GetElementIndex(server, element));
+        server->valueCache.leastRecentlyUsed = element->moreRecentlyUsed;
+    }
+    element->moreRecentlyUsed = kHAPCharacteristicValueCache_NoElement;
+    element->lessRecentlyUsed = kHAPCharacteristicValueCache_NoElement;
+}
+
+/**
+ * Moves a cache element to the most recently used end of the list that is ordered by last use.
+ *
+ * @param      server               Accessory server.
+ * @param      element              Cache element.
+ */
+static void MarkElementUsed(HAPAccessoryServer* server, HAPCharacteristicValueCacheElement* element) {
+    HAPPrecondition(server);
+    HAPPrecondition(element);
+
+    uint16_t index = GetElementIndex(server, element);
+    if (server->valueCache.mostRecentlyUsed == index) {
+        return;
+    }
+    UnlinkElement(server, element);
+    element->lessRecentlyUsed = server->valueCache.mostRecentlyUsed;
+    if (server->valueCache.mostRecentlyUsed != kHAPCharacteristicValueCache_NoElement) {
+        GetElement(server, server->valueCache.mostRecentlyUsed)->moreRecentlyUsed = index;
+    } else {
+        server->valueCache.leastRecentlyUsed = index;
+    }
+    server->valueCache.mostRecentlyUsed = index;
+}
+
+/**
+ * Releases a used cache element and moves it to the least recently used end of the list that is ordered by last use.
+ *
+ * @param      server               Accessory server.
+ * @param      element              Cache element.
+ */
+static void ReleaseElement(HAPAccessoryServer* server, HAPCharacteristicValueCacheElement* element) {
+    HAPPrecondition(server);
+    HAPPrecondition(element);
+    HAPPrecondition(element->characteristic);
+    HAPPrecondition(element->accessory);
+
+    // Remove from hash bucket.
+    uint16_t index = GetElementIndex(server, element);
+    HAPCharacteristicValueCacheElement* bucketElement = GetBucketElement(
+            server, HAPNonnull(element->characteristic), element->service, HAPNonnull(element->accessory));
+    uint16_t* link = &bucketElement->bucket;
+    while (*link != index) {
+        HAPAssert(*link != kHAPCharacteristicValueCache_NoElement);
+        link = &GetElement(server, *link)->nextInBucket;
+    }
+    *link = element->nextInBucket;
+    element->nextInBucket = kHAPCharacteristicValueCache_NoElement;
+
+    element->characteristic = NULL;
+    element->service = NULL;
+    element->accessory = NULL;
+    element->storeTime = 0;
+    HAPRawBufferZero(element->valueBytes, sizeof element->valueBytes);
+
+    // Move to least recently used end.
+    if (server->valueCache.leastRecentlyUsed == index) {
+        return;
+    }
+    UnlinkElement(server, element);
+    element->moreRecentlyUsed = server->valueCache.leastRecentlyUsed;
+    if (server->valueCache.leastRecentlyUsed != kHAPCharacteristicValueCache_NoElement) {
+        GetElement(server, server->valueCache.leastRecentlyUsed)->lessRecentlyUsed = index;
+    } else {
+        server->valueCache.mostRecentlyUsed = index;
+    }
+    server->valueCache.leastRecentlyUsed = index;
+}
+
+/**
+ * Gets the cache element that is replaced when storing a value of a characteristic without a cache element.
+ *
+ * - Unused elements are preferred. Otherwise, the least recently used element is evicted.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return Unused cache element to replace.
+ */
+HAP_RESULT_USE_CHECK
+static HAPCharacteristicValueCacheElement* GetElementToReplace(HAPAccessoryServer* server) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->valueCache.numElements);
+
+    HAPCharacteristicValueCacheElement* element = GetElement(server, server->valueCache.leastRecentlyUsed);
+    if (element->characteristic) {
+        HAPLogCharacteristicDebug(
+                &logObject,
+                HAPNonnull(element->characteristic),
+                element->service,
+                HAPNonnull(element->accessory),
+                "Evicting cached value.");
+        ReleaseElement(server, element);
+    }
+    return element;
+}
+
+void HAPCharacteristicValueCacheInvalidateAll(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    server->valueCache.mostRecentlyUsed = kHAPCharacteristicValueCache_NoElement;
+    server->valueCache.leastRecentlyUsed = kHAPCharacteristicValueCache_NoElement;
+    if (server->valueCache.numElements) {
+        HAPRawBufferZero(
+                HAPNonnull(server->valueCache.elements),
+                server->valueCache.numElements * sizeof *server->valueCache.elements);
+        for (size_t i = 0; i < server->valueCache.numElements; i++) {
+            HAPCharacteristicValueCacheElement* element = GetElement(server, i);
+            element->bucket = kHAPCharacteristicValueCache_NoElement;
+            element->nextInBucket = kHAPCharacteristicValueCache_NoElement;
+            element->moreRecentlyUsed = i ? (uint16_t)(i - 1) : kHAPCharacteristicValueCache_NoElement;
+            element->lessRecentlyUsed =
+                    i + 1 < server->valueCache.numElements ? (uint16_t)(i + 1) : kHAPCharacteristicValueCache_NoElement;
+        }
+        server->valueCache.mostRecentlyUsed = 0;
+        server->valueCache.leastRecentlyUsed = (uint16_t)(server->valueCache.numElements - 1);
+    }
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPCharacteristicValueCacheGet(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory,
+        void* valueBytes,
+        size_t numValueBytes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+    HAPPrecondition(valueBytes);
+    HAPPrecondition(numValueBytes <= kHAPCharacteristicValueCache_MaxValueBytes);
+
+    if (!IsCacheable(server, characteristic)) {
+        return false;
+    }
+
+    HAPCharacteristicValueCacheElement* _Nullable element = FindElement(server, characteristic, service, accessory);
+    if (element && IsElementExpired(server, element, HAPPlatformClockGetCurrent())) {
+        HAPLogCharacteristicDebug(&logObject, characteristic, service, accessory, "Cached value expired.");
+        ReleaseElement(server, HAPNonnull(element));
+        element = NULL;
+    }
+    if (!element) {
+        server->valueCache.statistics.numMisses++;
+        return false;
+    }
+
+    HAPLogCharacteristicDebug(&logObject, characteristic, service, accessory, "Serving value from cache.");
+    HAPRawBufferCopyBytes(valueBytes, element->valueBytes, numValueBytes);
+    MarkElementUsed(server, HAPNonnull(element));
+    server->valueCache.statistics.numHits++;
+    return true;
+}
+
+void HAPCharacteristicValueCacheSet(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory,
+        const void* valueBytes,
+        size_t numValueBytes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+    HAPPrecondition(valueBytes);
+    HAPPrecondition(numValueBytes <= kHAPCharacteristicValueCache_MaxValueBytes);
+
+    if (!IsCacheable(server, characteristic)) {
+        return;
+    }
+
+    HAPCharacteristicValueCacheElement* _Nullable element = FindElement(server, characteristic, service, accessory);
+    if (!element) {
+        element = GetElementToReplace(server);
+        element->characteristic = characteristic;
+        element->service = service;
+        element->accessory = accessory;
+
+        HAPCharacteristicValueCacheElement* bucketElement =
+                GetBucketElement(server, characteristic, service, accessory);
+        element->nextInBucket = bucketElement->bucket;
+        bucketElement->bucket = GetElementIndex(server, HAPNonnull(element));
+    }
+    element->storeTime = HAPPlatformClockGetCurrent();
+    HAPRawBufferZero(element->valueBytes, sizeof element->valueBytes);
+    HAPRawBufferCopyBytes(element->valueBytes, valueBytes, numValueBytes);
+    MarkElementUsed(server, HAPNonnull(element));
+}
+
+void HAPCharacteristicValueCacheInvalidate(
+        HAPAccessoryServerRef* server_,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(characteristic);
+    HAPPrecondition(accessory);
+
+    if (!IsCacheable(server, characteristic)) {
+        return;
+    }
+
+    HAPCharacteristicValueCacheElement* _Nullable element = FindElement(server, characteristic, service, accessory);
+    if (element) {
+        HAPLogCharacteristicDebug(&logObject, characteristic, service, accessory, "Invalidating cached value.");
+        ReleaseElement(server, HAPNonnull(element));
+    }
+}
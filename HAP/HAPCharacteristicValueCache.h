@@ -0,0 +1,98 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_CHARACTERISTIC_VALUE_CACHE_H
+#define HAP_CHARACTERISTIC_VALUE_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAP+Internal.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Maximum number of bytes of a cached characteristic value.
+ */
+#define kHAPCharacteristicValueCache_MaxValueBytes ((size_t) 8)
+
+/**
+ * Invalidates all entries of the characteristic value cache.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPCharacteristicValueCacheInvalidateAll(HAPAccessoryServerRef* server);
+
+/**
+ * Gets the cached value of a characteristic.
+ *
+ * - Only characteristics with the cacheable property are looked up. Hits and misses are counted.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param[out] valueBytes           Value buffer.
+ * @param      numValueBytes        Length of value. At most kHAPCharacteristicValueCache_MaxValueBytes.
+ *
+ * @return true                     If a valid cached value has been copied into the value buffer.
+ * @return false                    Otherwise. The read handler must be called.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPCharacteristicValueCacheGet(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory,
+        void* valueBytes,
+        size_t numValueBytes);
+
+/**
+ * Stores the value of a characteristic in the characteristic value cache.
+ *
+ * - Values of characteristics without the cacheable property are not stored.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param      valueBytes           Value buffer.
+ * @param      numValueBytes        Length of value. At most kHAPCharacteristicValueCache_MaxValueBytes.
+ */
+void HAPCharacteristicValueCacheSet(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory,
+        const void* valueBytes,
+        size_t numValueBytes);
+
+/**
+ * Invalidates the cached value of a characteristic.
+ *
+ * @param      server               Accessory server.
+ * @param      characteristic       Characteristic.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ */
+void HAPCharacteristicValueCacheInvalidate(
+        HAPAccessoryServerRef* server,
+        const HAPCharacteristic* characteristic,
+        const HAPService* _Nullable service,
+        const HAPAccessory* accessory);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
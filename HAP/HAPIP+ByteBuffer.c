@@ -27,7 +27,7 @@ void HAPIPByteBufferShiftLeft(HAPIPByteBuffer* byteBuffer, size_t numBytes) {
     HAPPrecondition(byteBuffer->position <= byteBuffer->limit);
     HAPPrecondition(byteBuffer->limit <= byteBuffer->capacity);
 
-    HAPRawBufferCopyBytes(byteBuffer->data, &byteBuffer->data[numBytes], byteBuffer->position - numBytes);
+    HAPRawBufferCopyBytes(byteBuffer->data, &byteBuffer->data[numBytes], byteBuffer->limit - numBytes);
     byteBuffer->position -= numBytes;
     byteBuffer->limit -= numBytes;
 }
@@ -51,6 +51,8 @@ void HAPIPByteBufferFlip(HAPIPByteBuffer* byteBuffer);
 /**
  * Discards bytes form a byte buffer.
  *
+ * - Bytes between position and limit are preserved.
+ *
  * @param      byteBuffer           Byte buffer.
  * @param      numBytes             Number of bytes to discard.
  */
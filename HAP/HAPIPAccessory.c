@@ -24,6 +24,27 @@ static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .categor
  */
 #define kHAPIPAccessorySerialization_DefaultMaxDataBytes ((size_t) 2097152)
 
+/**
+ * Marker in the cached GET /accessories response that is replaced with a characteristic value.
+ *
+ * - Markers are followed by the index of the characteristic record in the flattened attribute database.
+ *   Control characters are escaped in JSON strings, so markers cannot occur elsewhere in the cached response.
+ */
+#define kHAPIPAccessoriesCacheMarker_Value ((char) 0x01)
+
+/**
+ * Marker in the cached GET /accessories response that is replaced with an event notification state.
+ *
+ * - Markers are followed by the index of the characteristic record in the flattened attribute database.
+ *   Control characters are escaped in JSON strings, so markers cannot occur elsewhere in the cached response.
+ */
+#define kHAPIPAccessoriesCacheMarker_EventNotifications ((char) 0x02)
+
+/**
+ * Number of bytes of a marker in the cached GET /accessories response, including the index that follows it.
+ */
+#define kHAPIPAccessoriesCacheMarker_NumBytes ((size_t) 3)
+
 /**
  * Accessory serialization state.
  */
@@ -188,13 +209,22 @@ HAP_ENUM_BEGIN(uint8_t, HAPIPAccessorySerializationState) {
     kHAPIPAccessorySerializationState_CharacteristicValidValuesRangeEnd_Value,
     kHAPIPAccessorySerializationState_CharacteristicValidValuesRange_Separator,
 
+    kHAPIPAccessorySerializationState_CachedResponse,
+
     kHAPIPAccessorySerializationState_ResponseIsComplete
 } HAP_ENUM_END(uint8_t, HAPIPAccessorySerializationState);
 
-void HAPIPAccessoryCreateSerializationContext(HAPIPAccessorySerializationContext* context) {
+void HAPIPAccessoryCreateSerializationContext(
+        HAPIPAccessorySerializationContext* context,
+        HAPAccessoryServerRef* server) {
     HAPPrecondition(context);
+    HAPPrecondition(server);
 
     HAPRawBufferZero(context, sizeof *context);
+    if (HAPIPAccessoryAccessoriesCacheIsValid(server)) {
+        context->isCached = true;
+        context->state = kHAPIPAccessorySerializationState_CachedResponse;
+    }
 }
 
 bool HAPIPAccessorySerializationIsComplete(HAPIPAccessorySerializationContext* context) {
@@ -219,6 +249,14 @@ static const HAPAccessory* _Nullable GetCurrentAcessory(
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(server->primaryAccessory);
 
+    if (context->isCached) {
+        const HAPCharacteristic* characteristic;
+        const HAPService* service;
+        const HAPAccessory* accessory;
+        HAPAttributeDatabaseGetCharacteristic(
+                server_, context->cachedCharacteristicIndex, &characteristic, &service, &accessory, NULL);
+        return accessory;
+    }
     return context->accessoryIndex == 0 ?
                    server->primaryAccessory :
                    (server->ip.bridgedAccessories ? server->ip.bridgedAccessories[context->accessoryIndex - 1] : NULL);
@@ -238,6 +276,14 @@ static const HAPService* _Nullable GetCurrentService(
     HAPPrecondition(context);
     HAPPrecondition(server);
 
+    if (context->isCached) {
+        const HAPCharacteristic* characteristic;
+        const HAPService* service;
+        const HAPAccessory* accessory;
+        HAPAttributeDatabaseGetCharacteristic(
+                server, context->cachedCharacteristicIndex, &characteristic, &service, &accessory, NULL);
+        return service;
+    }
     const HAPAccessory* accessory = GetCurrentAcessory(context, server);
     HAPAssert(accessory);
 
@@ -258,17 +304,77 @@ static const HAPCharacteristic* _Nullable GetCurrentCharacteristic(
     HAPPrecondition(context);
     HAPPrecondition(server);
 
+    if (context->isCached) {
+        const HAPCharacteristic* characteristic;
+        const HAPService* service;
+        const HAPAccessory* accessory;
+        HAPAttributeDatabaseGetCharacteristic(
+                server, context->cachedCharacteristicIndex, &characteristic, &service, &accessory, NULL);
+        return characteristic;
+    }
     const HAPService* service = GetCurrentService(context, server);
     HAPAssert(service);
 
     return service->characteristics[context->characteristicIndex];
 }
 
+/**
+ * Gets the interned type of the current characteristic in the given serialization context.
+ *
+ * @param      context              Serialization context.
+ * @param      server               Accessory server.
+ *
+ * @return Interned characteristic type.
+ */
 HAP_RESULT_USE_CHECK
-HAPError HAPIPAccessorySerializeReadResponse(
+static HAPTypeID GetCurrentCharacteristicTypeID(
+        HAPIPAccessorySerializationContext* context,
+        HAPAccessoryServerRef* server) {
+    HAPPrecondition(context);
+    HAPPrecondition(server);
+
+    if (context->isCached) {
+        const HAPCharacteristic* characteristic;
+        const HAPService* service;
+        const HAPAccessory* accessory;
+        HAPTypeID characteristicTypeID;
+        HAPAttributeDatabaseGetCharacteristic(
+                server,
+                context->cachedCharacteristicIndex,
+                &characteristic,
+                &service,
+                &accessory,
+                &characteristicTypeID);
+        return characteristicTypeID;
+    }
+    const HAPBaseCharacteristic* characteristic = GetCurrentCharacteristic(context, server);
+    HAPAssert(characteristic);
+
+    return HAPAttributeDatabaseGetTypeID(characteristic->characteristicType);
+}
+
+/**
+ * Incrementally serializes a GET /accessories response.
+ *
+ * - If no session is given, markers are serialized instead of characteristic values and event notification states.
+ *   This is used to create the cached GET /accessories response.
+ *
+ * @param      context              Serialization context to incrementally serialize the response.
+ * @param      server_              Accessory server.
+ * @param      session              IP session descriptor. NULL to serialize the cached response.
+ * @param[out] bytes                Buffer to fill.
+ * @param      minBytes             Minimum number of bytes to serialize, until the response is complete.
+ * @param      maxBytes             Maximum number of bytes to serialize in a single invocation of this function.
+ * @param      numBytes             Number of bytes serialized.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If the supplied buffer is not large enough.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SerializeReadResponse(
         HAPIPAccessorySerializationContext* context,
         HAPAccessoryServerRef* server_,
-        HAPIPSessionDescriptorRef* session,
+        HAPIPSessionDescriptorRef* _Nullable session,
         char* bytes,
         size_t minBytes,
         size_t maxBytes,
@@ -278,7 +384,7 @@ HAPError HAPIPAccessorySerializeReadResponse(
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(server->primaryAccessory);
-    HAPPrecondition(session);
+    HAPPrecondition(session || !context->isCached);
     HAPPrecondition(bytes);
     HAPPrecondition(minBytes >= 1);
     HAPPrecondition(maxBytes >= minBytes);
@@ -379,6 +485,22 @@ HAPError HAPIPAccessorySerializeReadResponse(
         HAPAssert(*numBytes <= maxBytes); \
     } while (0)
 
+#define APPEND_CACHE_MARKER_OR_RETURN_ERROR(marker) \
+    do { \
+        HAPAssert(*numBytes <= maxBytes); \
+        if (maxBytes - *numBytes < kHAPIPAccessoriesCacheMarker_NumBytes) { \
+            HAPLogError(&logObject, "Not enough resources to serialize GET /accessories response."); \
+            return kHAPError_OutOfResources; \
+        } \
+        size_t characteristicIndex = HAPAttributeDatabaseGetCharacteristicIndex( \
+                server_, GET_CURRENT_CHARACTERISTIC(), GET_CURRENT_SERVICE(), GET_CURRENT_ACCESSORY()); \
+        HAPAssert(characteristicIndex <= UINT16_MAX); \
+        bytes[*numBytes] = (marker); \
+        HAPWriteLittleUInt16(&bytes[*numBytes + 1], characteristicIndex); \
+        *numBytes += kHAPIPAccessoriesCacheMarker_NumBytes; \
+        HAPAssert(*numBytes <= maxBytes); \
+    } while (0)
+
     *numBytes = 0;
 
     do {
@@ -858,6 +980,11 @@ HAPError HAPIPAccessorySerializeReadResponse(
                 const HAPBaseCharacteristic* baseCharacteristic = GET_CURRENT_CHARACTERISTIC();
                 HAPAssert(baseCharacteristic);
                 HAPAssert(baseCharacteristic->properties.readable);
+                if (!session) {
+                    APPEND_CACHE_MARKER_OR_RETURN_ERROR(kHAPIPAccessoriesCacheMarker_Value);
+                    context->state = kHAPIPAccessorySerializationState_CharacteristicValue_ValueSeparator;
+                    continue;
+                }
                 HAPIPSessionReadResult readResult;
 
                 HAPAssert(*numBytes <= maxBytes);
@@ -880,16 +1007,17 @@ HAPError HAPIPAccessorySerializeReadResponse(
                 HAPAssert(accessory);
                 const HAPService* service = GET_CURRENT_SERVICE();
                 HAPAssert(service);
+                HAPTypeID characteristicTypeID = GetCurrentCharacteristicTypeID(context, server_);
                 HAPIPSessionHandleReadRequest(
-                        session,
+                        HAPNonnull(session),
                         kHAPIPSessionContext_GetAccessories,
                         baseCharacteristic,
                         service,
                         accessory,
+                        characteristicTypeID,
                         &readResult,
                         &dataBuffer);
-                if (HAPUUIDAreEqual(
-                            baseCharacteristic->characteristicType, &kHAPCharacteristicType_ProgrammableSwitchEvent)) {
+                if (characteristicTypeID == kHAPCharacteristicTypeID_ProgrammableSwitchEvent) {
                     // A read of this characteristic must always return a null value for IP accessories.
                     // See HomeKit Accessory Protocol Specification R14
                     // Section 9.75 Programmable Switch Event
@@ -954,7 +1082,11 @@ HAPError HAPIPAccessorySerializeReadResponse(
 
                 HAPAssert(*numBytes <= maxBytes);
 
-                context->state = kHAPIPAccessorySerializationState_CharacteristicValue_ValueSeparator;
+                if (context->isCached) {
+                    context->state = kHAPIPAccessorySerializationState_CachedResponse;
+                } else {
+                    context->state = kHAPIPAccessorySerializationState_CharacteristicValue_ValueSeparator;
+                }
             }
                 continue;
             case kHAPIPAccessorySerializationState_CharacteristicValue_ValueSeparator: {
@@ -1086,11 +1218,21 @@ HAPError HAPIPAccessorySerializeReadResponse(
                 HAPAssert(service);
                 const HAPBaseCharacteristic* baseCharacteristic = GET_CURRENT_CHARACTERISTIC();
                 HAPAssert(baseCharacteristic);
+                if (!session) {
+                    APPEND_CACHE_MARKER_OR_RETURN_ERROR(kHAPIPAccessoriesCacheMarker_EventNotifications);
+                    context->state = kHAPIPAccessorySerializationState_CharacteristicEventNotifications_ValueSeparator;
+                    continue;
+                }
                 APPEND_STRING_OR_RETURN_ERROR(
-                        HAPIPSessionAreEventNotificationsEnabled(session, baseCharacteristic, service, accessory) ?
+                        HAPIPSessionAreEventNotificationsEnabled(
+                                HAPNonnull(session), baseCharacteristic, service, accessory) ?
                                 "true" :
                                 "false");
-                context->state = kHAPIPAccessorySerializationState_CharacteristicEventNotifications_ValueSeparator;
+                if (context->isCached) {
+                    context->state = kHAPIPAccessorySerializationState_CachedResponse;
+                } else {
+                    context->state = kHAPIPAccessorySerializationState_CharacteristicEventNotifications_ValueSeparator;
+                }
             }
                 continue;
             case kHAPIPAccessorySerializationState_CharacteristicEventNotifications_ValueSeparator: {
@@ -1734,6 +1876,43 @@ HAPError HAPIPAccessorySerializeReadResponse(
                 context->state = kHAPIPAccessorySerializationState_CharacteristicValidValuesRangeEnd_Value;
             }
                 continue;
+            case kHAPIPAccessorySerializationState_CachedResponse: {
+                HAPAssert(context->isCached);
+                const char* cacheBytes = HAPNonnull(server->ip.storage)->accessoriesCache.bytes;
+                size_t numCacheBytes = server->ip.accessoriesCache.numBytes;
+                HAPAssert(cacheBytes);
+                HAPAssert(context->cacheOffset <= numCacheBytes);
+
+                // Copy static bytes up to the next marker.
+                HAPAssert(*numBytes <= maxBytes);
+                size_t i = context->cacheOffset;
+                size_t end = HAPMin(numCacheBytes, context->cacheOffset + (maxBytes - *numBytes));
+                while (i < end && cacheBytes[i] != kHAPIPAccessoriesCacheMarker_Value &&
+                       cacheBytes[i] != kHAPIPAccessoriesCacheMarker_EventNotifications) {
+                    i++;
+                }
+                HAPRawBufferCopyBytes(&bytes[*numBytes], &cacheBytes[context->cacheOffset], i - context->cacheOffset);
+                *numBytes += i - context->cacheOffset;
+                context->cacheOffset = i;
+                HAPAssert(*numBytes <= maxBytes);
+
+                if (context->cacheOffset == numCacheBytes) {
+                    context->state = kHAPIPAccessorySerializationState_ResponseIsComplete;
+                } else if (i < end) {
+                    // Serialize characteristic value or event notification state at marker.
+                    HAPAssert(numCacheBytes - context->cacheOffset >= kHAPIPAccessoriesCacheMarker_NumBytes);
+                    char marker = cacheBytes[context->cacheOffset];
+                    context->cachedCharacteristicIndex = HAPReadLittleUInt16(&cacheBytes[context->cacheOffset + 1]);
+                    context->cacheOffset += kHAPIPAccessoriesCacheMarker_NumBytes;
+                    if (marker == kHAPIPAccessoriesCacheMarker_Value) {
+                        context->state = kHAPIPAccessorySerializationState_CharacteristicValue_Value;
+                    } else {
+                        HAPAssert(marker == kHAPIPAccessoriesCacheMarker_EventNotifications);
+                        context->state = kHAPIPAccessorySerializationState_CharacteristicEventNotifications_Value;
+                    }
+                }
+            }
+                continue;
             case kHAPIPAccessorySerializationState_ResponseIsComplete: {
             }
                 HAPFatalError();
@@ -1741,6 +1920,7 @@ HAPError HAPIPAccessorySerializeReadResponse(
         HAPFatalError();
     } while ((*numBytes < minBytes) && (context->state != kHAPIPAccessorySerializationState_ResponseIsComplete));
 
+#undef APPEND_CACHE_MARKER_OR_RETURN_ERROR
 #undef APPEND_FLOAT_OR_RETURN_ERROR
 #undef APPEND_INT32_OR_RETURN_ERROR
 #undef APPEND_UINT64_OR_RETURN_ERROR
@@ -1753,3 +1933,115 @@ HAPError HAPIPAccessorySerializeReadResponse(
 
     return kHAPError_None;
 }
+
+HAP_RESULT_USE_CHECK
+HAPError HAPIPAccessorySerializeReadResponse(
+        HAPIPAccessorySerializationContext* context,
+        HAPAccessoryServerRef* server,
+        HAPIPSessionDescriptorRef* session,
+        char* bytes,
+        size_t minBytes,
+        size_t maxBytes,
+        size_t* numBytes) {
+    HAPPrecondition(session);
+
+    return SerializeReadResponse(context, server, session, bytes, minBytes, maxBytes, numBytes);
+}
+
+void HAPIPAccessoryCreateAccessoriesCache(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ip.storage);
+    HAPPrecondition(server->primaryAccessory);
+
+    HAPError err;
+
+    HAPIPAccessoryReleaseAccessoriesCache(server_);
+    char* _Nullable cacheBytes = HAPNonnull(server->ip.storage)->accessoriesCache.bytes;
+    size_t maxCacheBytes = HAPNonnull(server->ip.storage)->accessoriesCache.numBytes;
+    if (!cacheBytes || !maxCacheBytes) {
+        return;
+    }
+    if (!HAPAttributeDatabaseIsFlattened(server_)) {
+        HAPLog(&logObject, "Attribute database is not flattened. Not caching GET /accessories response.");
+        return;
+    }
+
+    HAPIPAccessorySerializationContext context;
+    HAPRawBufferZero(&context, sizeof context);
+    size_t numCacheBytes;
+    err = SerializeReadResponse(
+            &context,
+            server_,
+            /* session: */ NULL,
+            HAPNonnull(cacheBytes),
+            maxCacheBytes,
+            maxCacheBytes,
+            &numCacheBytes);
+    if (err || !HAPIPAccessorySerializationIsComplete(&context)) {
+        HAPAssert(!err || err == kHAPError_OutOfResources);
+        HAPLog(&logObject,
+               "GET /accessories cache capacity not large enough (%zu bytes). "
+               "Responses are serialized on request.",
+               maxCacheBytes);
+        return;
+    }
+
+    server->ip.accessoriesCache.numBytes = numCacheBytes;
+    server->ip.accessoriesCache.isValid = true;
+    HAPLogDebug(
+            &logObject,
+            "GET /accessories cache: %zu bytes (configuration number %u).",
+            numCacheBytes,
+            server->ip.accessoriesCache.configurationNumber);
+}
+
+void HAPIPAccessoryReleaseAccessoriesCache(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPRawBufferZero(&server->ip.accessoriesCache, sizeof server->ip.accessoriesCache);
+    server->ip.accessoriesCache.configurationNumber = server->configurationNumber;
+}
+
+/**
+ * Returns whether a session is serializing a GET /accessories response from the cache.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return true                     If the cache is in use.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsAccessoriesCacheInUse(HAPAccessoryServer* server) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->ip.storage);
+
+    for (size_t i = 0; i < HAPNonnull(server->ip.storage)->numSessions; i++) {
+        HAPIPSessionDescriptor* session =
+                (HAPIPSessionDescriptor*) &HAPNonnull(server->ip.storage)->sessions[i].descriptor;
+        if (session->server && session->state != kHAPIPSessionState_Idle &&
+            session->accessorySerializationContext.isCached &&
+            !HAPIPAccessorySerializationIsComplete(&session->accessorySerializationContext)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HAPIPAccessoryAccessoriesCacheIsValid(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    // The cache is stale once the in-memory configuration number changed since the cache was set up.
+    // Sessions that are still serializing from the cache keep using it, so it is only set up again afterwards.
+    if (server->ip.accessoriesCache.configurationNumber != server->configurationNumber) {
+        if (IsAccessoriesCacheInUse(server)) {
+            return false;
+        }
+        HAPLogInfo(&logObject, "Configuration number changed. Setting up GET /accessories cache again.");
+        HAPIPAccessoryCreateAccessoriesCache(server_);
+    }
+
+    return server->ip.accessoriesCache.isValid;
+}
@@ -45,14 +45,69 @@ typedef struct {
      * Characteristic index.
      */
     uint8_t characteristicIndex;
+
+    /**
+     * Whether the response is serialized from the cached GET /accessories response.
+     */
+    bool isCached;
+
+    /**
+     * Index of the characteristic record whose value or event notification state is serialized from the cache.
+     */
+    uint16_t cachedCharacteristicIndex;
+
+    /**
+     * Offset of the next byte of the cached GET /accessories response to serialize.
+     */
+    size_t cacheOffset;
 } HAPIPAccessorySerializationContext;
 
+/**
+ * Serializes the static parts of the GET /accessories response into the cache buffer.
+ *
+ * - If no cache buffer is provided, if it is too small, or if the attribute database is not flattened,
+ *   the response is serialized without the cache.
+ *
+ * - The cache is tied to the in-memory configuration number of the accessory server.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPIPAccessoryCreateAccessoriesCache(HAPAccessoryServerRef* server);
+
+/**
+ * Discards the cached GET /accessories response.
+ *
+ * - The cache is set up again when the configuration number changes.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPIPAccessoryReleaseAccessoriesCache(HAPAccessoryServerRef* server);
+
+/**
+ * Returns whether the cached GET /accessories response is valid.
+ *
+ * - If the configuration number changed since the cache was created, the cache is created again.
+ *   While sessions are still serializing responses from the stale cache, it is reported as not valid.
+ *
+ * @param      server               Accessory server.
+ *
+ * @return true                     If GET /accessories responses are serialized from the cache.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPIPAccessoryAccessoriesCacheIsValid(HAPAccessoryServerRef* server);
+
 /**
  * Creates a new serialization context.
  *
+ * - If the cached GET /accessories response is valid, the response is serialized from the cache.
+ *
  * @param      context              An serialization context.
+ * @param      server               Accessory server.
  */
-void HAPIPAccessoryCreateSerializationContext(HAPIPAccessorySerializationContext* context);
+void HAPIPAccessoryCreateSerializationContext(
+        HAPIPAccessorySerializationContext* context,
+        HAPAccessoryServerRef* server);
 
 /**
  * Returns whether the incremental response serialization for the given serialization context is complete.
@@ -6,6 +6,8 @@
 
 #include "HAP+Internal.h"
 
+#include "util_base64.h"
+
 static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .category = "IPAccessoryProtocol" };
 
 typedef struct {
@@ -94,6 +96,10 @@ static const HAPAccessory* _Nullable GetAccessory(HAPAccessoryServerRef* server_
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(server->primaryAccessory);
 
+    if (HAPAttributeDatabaseIsFlattened(server_)) {
+        return HAPAttributeDatabaseFindAccessory(server_, aid);
+    }
+
     const HAPAccessory* accessory = NULL;
 
     if (server->primaryAccessory->aid == aid) {
@@ -116,14 +122,28 @@ static const HAPAccessory* _Nullable GetAccessory(HAPAccessoryServerRef* server_
  * @param      server               Accessory server.
  * @param      aid                  Accessory instance ID.
  * @param      iid                  Characteristic instance ID.
+ * @param[out] characteristicTypeID Interned characteristic type, if found. Optional.
  *
  * @return The characteristic object for the provided accessory instance ID and characteristic instance ID or NULL, if
  *         no corresponding characteristic object was found.
  */
 HAP_RESULT_USE_CHECK
-static const HAPCharacteristic* _Nullable GetCharacteristic(HAPAccessoryServerRef* server, uint64_t aid, uint64_t iid) {
+static const HAPCharacteristic* _Nullable GetCharacteristic(
+        HAPAccessoryServerRef* server,
+        uint64_t aid,
+        uint64_t iid,
+        HAPTypeID* _Nullable characteristicTypeID) {
     HAPPrecondition(server);
 
+    if (HAPAttributeDatabaseIsFlattened(server)) {
+        const HAPCharacteristic* _Nullable characteristic;
+        const HAPService* _Nullable service;
+        const HAPAccessory* _Nullable accessory;
+        HAPAttributeDatabaseFindIPCharacteristic(
+                server, aid, iid, &characteristic, &service, &accessory, characteristicTypeID);
+        return characteristic;
+    }
+
     const HAPAccessory* accessory = GetAccessory(server, aid);
 
     if (accessory) {
@@ -140,6 +160,9 @@ static const HAPCharacteristic* _Nullable GetCharacteristic(HAPAccessoryServerRe
                 if (characteristic_->iid != iid) {
                     continue;
                 }
+                if (characteristicTypeID) {
+                    *characteristicTypeID = HAPAttributeDatabaseGetTypeID(characteristic_->characteristicType);
+                }
                 return characteristic_;
             }
         }
@@ -305,7 +328,8 @@ size_t HAPIPAccessoryProtocolGetNumCharacteristicReadResponseBytes(
     for (i = 0; i < numReadContexts; i++) {
         readContext = (HAPIPReadContext*) &readContexts[i];
 
-        const HAPBaseCharacteristic* chr_ = GetCharacteristic(server, readContext->aid, readContext->iid);
+        HAPTypeID chrTypeID = 0;
+        const HAPBaseCharacteristic* chr_ = GetCharacteristic(server, readContext->aid, readContext->iid, &chrTypeID);
         HAPAssert(chr_ || (readContext->status != 0));
         r += (i == 0 ? 15 : 16) + HAPUInt64GetNumDescriptionBytes(readContext->aid) +
              HAPUInt64GetNumDescriptionBytes(readContext->iid);
@@ -349,7 +373,7 @@ size_t HAPIPAccessoryProtocolGetNumCharacteristicReadResponseBytes(
         if (readContext->status == 0) {
             HAPAssert(chr_);
             r += success ? 9 : 20;
-            if (HAPUUIDAreEqual(chr_->characteristicType, &kHAPCharacteristicType_ProgrammableSwitchEvent)) {
+            if (chrTypeID == kHAPCharacteristicTypeID_ProgrammableSwitchEvent) {
                 r += 4;
             } else {
                 switch (chr_->format) {
@@ -573,7 +597,8 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicReadResponseBytes(
     for (i = 0; i < numReadContexts; i++) {
         readContext = (HAPIPReadContext*) &readContexts[i];
 
-        const HAPBaseCharacteristic* chr_ = GetCharacteristic(server, readContext->aid, readContext->iid);
+        HAPTypeID chrTypeID = 0;
+        const HAPBaseCharacteristic* chr_ = GetCharacteristic(server, readContext->aid, readContext->iid, &chrTypeID);
         HAPAssert(chr_ || (readContext->status != 0));
         err = HAPIPByteBufferAppendStringWithFormat(buffer, "%s{\"aid\":", i == 0 ? "" : ",");
         if (err) {
@@ -649,7 +674,7 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicReadResponseBytes(
                     goto error;
                 }
             }
-            if (HAPUUIDAreEqual(chr_->characteristicType, &kHAPCharacteristicType_ProgrammableSwitchEvent)) {
+            if (chrTypeID == kHAPCharacteristicTypeID_ProgrammableSwitchEvent) {
                 // A read of this characteristic must always return a null value for IP accessories.
                 // See HomeKit Accessory Protocol Specification R14
                 // Section 9.75 Programmable Switch Event
@@ -1054,6 +1079,78 @@ error:
     return kHAPError_OutOfResources;
 }
 
+/**
+ * Parses the number of a "value" member of a characteristic write request.
+ *
+ * @param      number               NULL-terminated number.
+ * @param[out] type                 Type of the value.
+ * @param[out] intValue             Value, if the type is kHAPIPWriteValueType_Int.
+ * @param[out] unsignedIntValue     Value, if the type is kHAPIPWriteValueType_UInt.
+ * @param[out] floatValue           Value, if the type is kHAPIPWriteValueType_Float.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the number is malformed or out of range.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError GetWriteRequestNumberValue(
+        const char* number,
+        HAPIPWriteValueType* type,
+        int32_t* intValue,
+        uint64_t* unsignedIntValue,
+        float* floatValue) {
+    HAPPrecondition(number);
+    HAPPrecondition(type);
+    HAPPrecondition(intValue);
+    HAPPrecondition(unsignedIntValue);
+    HAPPrecondition(floatValue);
+
+    HAPError err;
+
+    bool frac = false;
+    for (size_t i = 0; number[i]; i++) {
+        if (number[i] == '.') {
+            frac = true;
+            break;
+        }
+    }
+    if (frac) {
+        float fval;
+        err = HAPFloatFromString(number, &fval);
+        if (err) {
+            HAPAssert(err == kHAPError_InvalidData);
+            return err;
+        }
+        *floatValue = fval;
+        *type = kHAPIPWriteValueType_Float;
+        return kHAPError_None;
+    }
+    int64_t llval;
+    err = HAPInt64FromString(number, &llval);
+    if (!err) {
+        if (llval < 0) {
+            if (llval < INT32_MIN) {
+                return kHAPError_InvalidData;
+            }
+            *intValue = (int32_t) llval;
+            *type = kHAPIPWriteValueType_Int;
+        } else {
+            *unsignedIntValue = (uint64_t) llval;
+            *type = kHAPIPWriteValueType_UInt;
+        }
+        return kHAPError_None;
+    }
+    HAPAssert(err == kHAPError_InvalidData);
+    uint64_t ullval;
+    err = HAPUInt64FromString(number, &ullval);
+    if (err) {
+        HAPAssert(err == kHAPError_InvalidData);
+        return err;
+    }
+    *unsignedIntValue = ullval;
+    *type = kHAPIPWriteValueType_UInt;
+    return kHAPError_None;
+}
+
 HAP_RESULT_USE_CHECK
 static size_t read_characteristic_write_request_parameters(
         struct util_json_reader* r,
@@ -1062,12 +1159,8 @@ static size_t read_characteristic_write_request_parameters(
         HAPIPWriteRequestParameters* parameters,
         HAPError* err) {
     size_t i, j, k, n;
-    int frac;
     uint64_t aid, iid;
     unsigned int ev, remote;
-    float fval;
-    int64_t llval;
-    uint64_t ullval;
     char number[64];
     unsigned int response;
 
@@ -1100,7 +1193,7 @@ static size_t read_characteristic_write_request_parameters(
     HAPAssert(j <= k);
     HAPAssert(k <= length);
     if (j - i == 5) {
-        if (HAPRawBufferAreEqual(&buffer[i], "\"aid\"", 5)) {
+        if (HAPRawBufferAreEqualPublic(&buffer[i], "\"aid\"", 5)) {
             k += util_json_reader_read(r, &buffer[k], length - k);
             if (r->state != util_JSON_READER_STATE_BEGINNING_NUMBER) {
                 *err = kHAPError_InvalidData;
@@ -1123,7 +1216,7 @@ static size_t read_characteristic_write_request_parameters(
                 *err = kHAPError_InvalidData;
                 goto exit;
             }
-        } else if (HAPRawBufferAreEqual(&buffer[i], "\"iid\"", 5)) {
+        } else if (HAPRawBufferAreEqualPublic(&buffer[i], "\"iid\"", 5)) {
             k += util_json_reader_read(r, &buffer[k], length - k);
             if (r->state != util_JSON_READER_STATE_BEGINNING_NUMBER) {
                 *err = kHAPError_InvalidData;
@@ -1155,7 +1248,7 @@ static size_t read_characteristic_write_request_parameters(
             }
             k += skippedBytes;
         }
-    } else if ((j - i == 7) && HAPRawBufferAreEqual(&buffer[i], "\"value\"", 7)) {
+    } else if ((j - i == 7) && HAPRawBufferAreEqualPublic(&buffer[i], "\"value\"", 7)) {
         k += util_json_reader_read(r, &buffer[k], length - k);
         switch (r->state) {
             case util_JSON_READER_STATE_BEGINNING_NUMBER: {
@@ -1170,11 +1263,7 @@ static size_t read_characteristic_write_request_parameters(
                 HAPAssert(k <= length);
                 n = 0;
                 HAPAssert(n <= sizeof number);
-                frac = 0;
                 while ((i < k) && (n < sizeof number)) {
-                    if (!frac && (buffer[i] == '.')) {
-                        frac = 1;
-                    }
                     number[n] = buffer[i];
                     n++;
                     i++;
@@ -1182,39 +1271,15 @@ static size_t read_characteristic_write_request_parameters(
                 if (n < sizeof number) {
                     HAPAssert(i == k);
                     number[n] = '\0';
-                    if (frac) {
-                        *err = HAPFloatFromString(number, &fval);
-                        if (*err) {
-                            HAPAssert(*err == kHAPError_InvalidData);
-                            goto exit;
-                        }
-                        parameters->value.floatValue = fval;
-                        parameters->type = kHAPIPWriteValueType_Float;
-                    } else {
-                        *err = HAPInt64FromString(number, &llval);
-                        if (!*err) {
-                            if (llval < 0) {
-                                if (llval >= INT32_MIN) {
-                                    parameters->value.intValue = (int32_t) llval;
-                                    parameters->type = kHAPIPWriteValueType_Int;
-                                } else {
-                                    *err = kHAPError_InvalidData;
-                                    goto exit;
-                                }
-                            } else {
-                                parameters->value.unsignedIntValue = (uint64_t) llval;
-                                parameters->type = kHAPIPWriteValueType_UInt;
-                            }
-                        } else {
-                            HAPAssert(*err == kHAPError_InvalidData);
-                            *err = HAPUInt64FromString(number, &ullval);
-                            if (*err) {
-                                HAPAssert(*err == kHAPError_InvalidData);
-                                goto exit;
-                            }
-                            parameters->value.unsignedIntValue = ullval;
-                            parameters->type = kHAPIPWriteValueType_UInt;
-                        }
+                    *err = GetWriteRequestNumberValue(
+                            number,
+                            &parameters->type,
+                            &parameters->value.intValue,
+                            &parameters->value.unsignedIntValue,
+                            &parameters->value.floatValue);
+                    if (*err) {
+                        HAPAssert(*err == kHAPError_InvalidData);
+                        goto exit;
                     }
                 } else {
                     *err = kHAPError_InvalidData;
@@ -1272,7 +1337,7 @@ static size_t read_characteristic_write_request_parameters(
             }
                 goto exit;
         }
-    } else if ((j - i == 4) && HAPRawBufferAreEqual(&buffer[i], "\"ev\"", 4)) {
+    } else if ((j - i == 4) && HAPRawBufferAreEqualPublic(&buffer[i], "\"ev\"", 4)) {
         k += util_json_reader_read(r, &buffer[k], length - k);
         switch (r->state) {
             case util_JSON_READER_STATE_BEGINNING_NUMBER:
@@ -1322,7 +1387,7 @@ static size_t read_characteristic_write_request_parameters(
                 *err = kHAPError_InvalidData;
                 goto exit;
         }
-    } else if ((j - i == 10) && HAPRawBufferAreEqual(&buffer[i], "\"authData\"", 10)) {
+    } else if ((j - i == 10) && HAPRawBufferAreEqualPublic(&buffer[i], "\"authData\"", 10)) {
         k += util_json_reader_read(r, &buffer[k], length - k);
         if (r->state != util_JSON_READER_STATE_BEGINNING_STRING) {
             *err = kHAPError_InvalidData;
@@ -1351,7 +1416,7 @@ static size_t read_characteristic_write_request_parameters(
             HAPAssert(*err == kHAPError_InvalidData);
             goto exit;
         }
-    } else if ((j - i == 8) && HAPRawBufferAreEqual(&buffer[i], "\"remote\"", 8)) {
+    } else if ((j - i == 8) && HAPRawBufferAreEqualPublic(&buffer[i], "\"remote\"", 8)) {
         k += util_json_reader_read(r, &buffer[k], length - k);
         switch (r->state) {
             case util_JSON_READER_STATE_BEGINNING_NUMBER:
@@ -1401,7 +1466,7 @@ static size_t read_characteristic_write_request_parameters(
                 *err = kHAPError_InvalidData;
                 goto exit;
         }
-    } else if ((j - i == 3) && HAPRawBufferAreEqual(&buffer[i], "\"r\"", 3)) {
+    } else if ((j - i == 3) && HAPRawBufferAreEqualPublic(&buffer[i], "\"r\"", 3)) {
         k += util_json_reader_read(r, &buffer[k], length - k);
         switch (r->state) {
             case util_JSON_READER_STATE_BEGINNING_NUMBER:
@@ -1598,7 +1663,7 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicWriteRequests(
         HAPAssert(i <= j);
         HAPAssert(j <= k);
         HAPAssert(k <= numBytes);
-        if ((j - i == 17) && HAPRawBufferAreEqual(&bytes[i], "\"characteristics\"", 17)) {
+        if ((j - i == 17) && HAPRawBufferAreEqualPublic(&bytes[i], "\"characteristics\"", 17)) {
             k += util_json_reader_read(&json_reader, &bytes[k], numBytes - k);
             if (json_reader.state != util_JSON_READER_STATE_BEGINNING_ARRAY) {
                 return kHAPError_InvalidData;
@@ -1619,7 +1684,7 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicWriteRequests(
             if (json_reader.state != util_JSON_READER_STATE_COMPLETED_ARRAY) {
                 return kHAPError_InvalidData;
             }
-        } else if ((j - i == 5) && HAPRawBufferAreEqual(&bytes[i], "\"pid\"", 5)) {
+        } else if ((j - i == 5) && HAPRawBufferAreEqualPublic(&bytes[i], "\"pid\"", 5)) {
             if (*hasPID) {
                 HAPLog(&logObject, "Multiple PID entries detected.");
                 return kHAPError_InvalidData;
@@ -1674,6 +1739,728 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicWriteRequests(
     return kHAPError_None;
 }
 
+void HAPIPWriteRequestParserCreate(
+        HAPIPWriteRequestParser* parser,
+        void* _Nullable stagingBytes,
+        size_t maxStagingBytes) {
+    HAPPrecondition(parser);
+    HAPPrecondition(!maxStagingBytes || stagingBytes);
+
+    HAPRawBufferZero(parser, sizeof *parser);
+    util_json_reader_init(&parser->jsonReader);
+    parser->state = kHAPIPWriteRequestParserState_BeforeRequest;
+    parser->stagingBytes = stagingBytes;
+    parser->maxStagingBytes = stagingBytes ? maxStagingBytes : 0;
+}
+
+/**
+ * Returns whether the member name that has been read equals a given name.
+ *
+ * @param      parser               Parser.
+ * @param      name                 Member name.
+ *
+ * @return true                     If the member name equals @p name.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool WriteRequestParserTokenIsEqual(const HAPIPWriteRequestParser* parser, const char* name) {
+    HAPAssert(parser);
+    HAPAssert(name);
+
+    size_t numNameBytes = HAPStringGetNumBytes(name);
+    return !parser->isTokenTruncated && parser->numTokenBytes == numNameBytes &&
+           HAPRawBufferAreEqualPublic(parser->tokenBytes, name, numNameBytes);
+}
+
+/**
+ * Appends a piece of a member name or number to the token that is being read.
+ *
+ * - One byte is kept available to NULL-terminate the token.
+ *
+ * @param      parser               Parser.
+ * @param      bytes                Piece of the token.
+ * @param      numBytes             Length of @p bytes.
+ */
+static void WriteRequestParserAppendTokenBytes(HAPIPWriteRequestParser* parser, const char* bytes, size_t numBytes) {
+    HAPAssert(parser);
+    HAPAssert(bytes);
+
+    if (parser->isTokenTruncated || numBytes >= sizeof parser->tokenBytes - parser->numTokenBytes) {
+        parser->isTokenTruncated = true;
+        return;
+    }
+    HAPRawBufferCopyBytes(&parser->tokenBytes[parser->numTokenBytes], bytes, numBytes);
+    parser->numTokenBytes += numBytes;
+}
+
+/**
+ * Reads the unsigned integer token that has been read.
+ *
+ * @param      parser               Parser.
+ * @param[out] value                Value.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the token is not an unsigned integer.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteRequestParserGetUInt64Token(const HAPIPWriteRequestParser* parser, uint64_t* value) {
+    HAPAssert(parser);
+    HAPAssert(value);
+
+    if (parser->isTokenTruncated ||
+        try_read_uint64(parser->tokenBytes, parser->numTokenBytes, value) != parser->numTokenBytes) {
+        return kHAPError_InvalidData;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Reads the boolean token that has been read. Booleans may be represented as 0 or 1.
+ *
+ * @param      parser               Parser.
+ * @param      event                State of the JSON reader that completed the token.
+ * @param[out] value                Value.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the token is not a boolean.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteRequestParserGetBoolToken(const HAPIPWriteRequestParser* parser, int event, bool* value) {
+    HAPAssert(parser);
+    HAPAssert(value);
+
+    switch (event) {
+        case util_JSON_READER_STATE_COMPLETED_FALSE: {
+            *value = false;
+            return kHAPError_None;
+        }
+        case util_JSON_READER_STATE_COMPLETED_TRUE: {
+            *value = true;
+            return kHAPError_None;
+        }
+        case util_JSON_READER_STATE_COMPLETED_NUMBER: {
+            unsigned int x;
+            if (parser->isTokenTruncated ||
+                try_read_uint(parser->tokenBytes, parser->numTokenBytes, &x) != parser->numTokenBytes || x > 1) {
+                return kHAPError_InvalidData;
+            }
+            *value = x == 1;
+            return kHAPError_None;
+        }
+        default: {
+            return kHAPError_InvalidData;
+        }
+    }
+}
+
+/**
+ * Starts staging a string value or authorization data.
+ *
+ * - Values of data and TLV8 characteristics are base64 decoded while they are received if the characteristic is
+ *   already known.
+ *
+ * @param      server               Accessory server.
+ * @param      parser               Parser.
+ */
+static void WriteRequestParserBeginString(HAPAccessoryServerRef* server, HAPIPWriteRequestParser* parser) {
+    HAPAssert(server);
+    HAPAssert(parser);
+
+    parser->stringOffset = parser->numStagedBytes;
+    parser->numBase64Bytes = 0;
+    parser->numEscapeBytes = 0;
+    parser->isBase64Padded = false;
+    parser->isDecodingBase64 = false;
+    if (parser->member == kHAPIPWriteRequestParserMember_Value && parser->hasAID && parser->hasIID) {
+        const HAPBaseCharacteristic* _Nullable characteristic = GetCharacteristic(
+                server, parser->writeContext.aid, parser->writeContext.iid, /* characteristicTypeID: */ NULL);
+        if (characteristic && (characteristic->format == kHAPCharacteristicFormat_Data ||
+                               characteristic->format == kHAPCharacteristicFormat_TLV8)) {
+            parser->isDecodingBase64 = true;
+        }
+    }
+}
+
+/**
+ * Decodes a character of a base64 encoded value into the staging buffer.
+ *
+ * @param      parser               Parser.
+ * @param      c                    Character.
+ */
+static void WriteRequestParserAppendBase64Character(HAPIPWriteRequestParser* parser, char c) {
+    HAPAssert(parser);
+    HAPAssert(parser->numBase64Bytes < sizeof parser->base64Bytes);
+
+    if (parser->writeContextError) {
+        return;
+    }
+    if (parser->isBase64Padded) {
+        parser->writeContextError = kHAPError_InvalidData;
+        return;
+    }
+    parser->base64Bytes[parser->numBase64Bytes] = c;
+    parser->numBase64Bytes++;
+    if (parser->numBase64Bytes < sizeof parser->base64Bytes) {
+        return;
+    }
+    parser->numBase64Bytes = 0;
+    if (!parser->stagingBytes) {
+        parser->writeContextError = kHAPError_OutOfResources;
+        return;
+    }
+    HAPAssert(parser->numStagedBytes <= parser->maxStagingBytes);
+    size_t numDecodedBytes;
+    HAPError err = util_base64_decode(
+            parser->base64Bytes,
+            sizeof parser->base64Bytes,
+            &parser->stagingBytes[parser->numStagedBytes],
+            parser->maxStagingBytes - parser->numStagedBytes,
+            &numDecodedBytes);
+    if (err) {
+        HAPAssert(err == kHAPError_InvalidData || err == kHAPError_OutOfResources);
+        parser->writeContextError = err;
+        return;
+    }
+    parser->numStagedBytes += numDecodedBytes;
+    parser->isBase64Padded = parser->base64Bytes[sizeof parser->base64Bytes - 1] == '=';
+}
+
+/**
+ * Stages a piece of a string value or authorization data.
+ *
+ * @param      parser               Parser.
+ * @param      bytes                Piece of the string, without quotation marks.
+ * @param      numBytes             Length of @p bytes.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the string contains a malformed escape sequence.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteRequestParserAppendStringBytes(
+        HAPIPWriteRequestParser* parser,
+        const char* bytes,
+        size_t numBytes) {
+    HAPAssert(parser);
+    HAPAssert(bytes);
+
+    if (!parser->isDecodingBase64) {
+        if (!numBytes || parser->writeContextError) {
+            return kHAPError_None;
+        }
+        if (numBytes > parser->maxStagingBytes - parser->numStagedBytes) {
+            parser->writeContextError = kHAPError_OutOfResources;
+            return kHAPError_None;
+        }
+        HAPRawBufferCopyBytes(&parser->stagingBytes[parser->numStagedBytes], bytes, numBytes);
+        parser->numStagedBytes += numBytes;
+        return kHAPError_None;
+    }
+
+    for (size_t i = 0; i < numBytes; i++) {
+        char c = bytes[i];
+        if (!parser->numEscapeBytes) {
+            if (c != '\\') {
+                WriteRequestParserAppendBase64Character(parser, c);
+                continue;
+            }
+        } else if (parser->numEscapeBytes >= sizeof parser->escapeBytes) {
+            return kHAPError_InvalidData;
+        }
+        parser->escapeBytes[parser->numEscapeBytes] = c;
+        parser->numEscapeBytes++;
+        if (parser->numEscapeBytes < sizeof parser->escapeBytes &&
+            (parser->numEscapeBytes < 2 || parser->escapeBytes[1] == 'u')) {
+            continue;
+        }
+        size_t numUnescapedBytes = parser->numEscapeBytes;
+        parser->numEscapeBytes = 0;
+        if (!HAPUTF8IsValidData(parser->escapeBytes, numUnescapedBytes)) {
+            return kHAPError_InvalidData;
+        }
+        HAPError err = HAPJSONUtilsUnescapeStringData(parser->escapeBytes, &numUnescapedBytes);
+        if (err) {
+            HAPAssert(err == kHAPError_InvalidData);
+            return err;
+        }
+        if (numUnescapedBytes != 1) {
+            if (!parser->writeContextError) {
+                parser->writeContextError = kHAPError_InvalidData;
+            }
+            continue;
+        }
+        WriteRequestParserAppendBase64Character(parser, parser->escapeBytes[0]);
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Completes a staged string value or authorization data.
+ *
+ * @param      parser               Parser.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the string is malformed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteRequestParserCompleteString(HAPIPWriteRequestParser* parser) {
+    HAPAssert(parser);
+    HAPAssert(parser->stringOffset <= parser->numStagedBytes);
+
+    HAPError err;
+
+    if (parser->isDecodingBase64) {
+        if (parser->numEscapeBytes) {
+            return kHAPError_InvalidData;
+        }
+        if (parser->numBase64Bytes && !parser->writeContextError) {
+            parser->writeContextError = kHAPError_InvalidData;
+        }
+    } else if (!parser->writeContextError) {
+        size_t numStringBytes = parser->numStagedBytes - parser->stringOffset;
+        if (numStringBytes) {
+            char* stringBytes = &parser->stagingBytes[parser->stringOffset];
+            if (!HAPUTF8IsValidData(stringBytes, numStringBytes)) {
+                return kHAPError_InvalidData;
+            }
+            err = HAPJSONUtilsUnescapeStringData(stringBytes, &numStringBytes);
+            if (err) {
+                HAPAssert(err == kHAPError_InvalidData);
+                return err;
+            }
+            parser->numStagedBytes = parser->stringOffset + numStringBytes;
+        }
+    }
+    if (parser->writeContextError) {
+        return kHAPError_None;
+    }
+
+    // Empty strings are represented by a non-NULL pointer, like in requests that are parsed as a whole.
+    static char emptyString[1];
+    char* stringBytes = parser->stagingBytes ? &parser->stagingBytes[parser->stringOffset] : emptyString;
+    size_t numStringBytes = parser->numStagedBytes - parser->stringOffset;
+    if (parser->member == kHAPIPWriteRequestParserMember_AuthData) {
+        parser->writeContext.authorizationData.bytes = stringBytes;
+        parser->writeContext.authorizationData.numBytes = numStringBytes;
+    } else {
+        HAPAssert(parser->member == kHAPIPWriteRequestParserMember_Value);
+        parser->writeContext.type = kHAPIPWriteValueType_String;
+        parser->writeContext.value.stringValue.bytes = stringBytes;
+        parser->writeContext.value.stringValue.numBytes = numStringBytes;
+        parser->writeContext.isValueDecoded = parser->isDecodingBase64;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Identifies the member whose name has been read.
+ *
+ * @param      parser               Parser.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the member is not allowed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteRequestParserCompleteMemberName(HAPIPWriteRequestParser* parser) {
+    HAPAssert(parser);
+
+    parser->member = kHAPIPWriteRequestParserMember_Unknown;
+    if (!parser->isInWriteRequest) {
+        if (WriteRequestParserTokenIsEqual(parser, "characteristics")) {
+            parser->member = kHAPIPWriteRequestParserMember_Characteristics;
+        } else if (WriteRequestParserTokenIsEqual(parser, "pid")) {
+            if (parser->hasPID) {
+                HAPLog(&logObject, "Multiple PID entries detected.");
+                return kHAPError_InvalidData;
+            }
+            parser->member = kHAPIPWriteRequestParserMember_PID;
+        }
+    } else if (WriteRequestParserTokenIsEqual(parser, "aid")) {
+        parser->member = kHAPIPWriteRequestParserMember_AID;
+    } else if (WriteRequestParserTokenIsEqual(parser, "iid")) {
+        parser->member = kHAPIPWriteRequestParserMember_IID;
+    } else if (WriteRequestParserTokenIsEqual(parser, "value")) {
+        parser->member = kHAPIPWriteRequestParserMember_Value;
+    } else if (WriteRequestParserTokenIsEqual(parser, "ev")) {
+        parser->member = kHAPIPWriteRequestParserMember_EV;
+    } else if (WriteRequestParserTokenIsEqual(parser, "authData")) {
+        parser->member = kHAPIPWriteRequestParserMember_AuthData;
+    } else if (WriteRequestParserTokenIsEqual(parser, "remote")) {
+        parser->member = kHAPIPWriteRequestParserMember_Remote;
+    } else if (WriteRequestParserTokenIsEqual(parser, "r")) {
+        parser->member = kHAPIPWriteRequestParserMember_Response;
+    }
+    parser->numSkippedLevels = 0;
+    return kHAPError_None;
+}
+
+/**
+ * Handles a JSON reader event within the value of an unknown member.
+ *
+ * @param      parser               Parser.
+ * @param      event                State of the JSON reader.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the value is malformed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteRequestParserSkipValue(HAPIPWriteRequestParser* parser, int event) {
+    HAPAssert(parser);
+
+    switch (event) {
+        case util_JSON_READER_STATE_BEGINNING_OBJECT:
+        case util_JSON_READER_STATE_BEGINNING_ARRAY: {
+            parser->numSkippedLevels++;
+        } break;
+        case util_JSON_READER_STATE_COMPLETED_OBJECT:
+        case util_JSON_READER_STATE_COMPLETED_ARRAY: {
+            if (!parser->numSkippedLevels) {
+                return kHAPError_InvalidData;
+            }
+            parser->numSkippedLevels--;
+            if (!parser->numSkippedLevels) {
+                parser->state = kHAPIPWriteRequestParserState_AfterMember;
+            }
+        } break;
+        case util_JSON_READER_STATE_COMPLETED_NUMBER:
+        case util_JSON_READER_STATE_COMPLETED_STRING:
+        case util_JSON_READER_STATE_COMPLETED_FALSE:
+        case util_JSON_READER_STATE_COMPLETED_TRUE:
+        case util_JSON_READER_STATE_COMPLETED_NULL: {
+            if (!parser->numSkippedLevels) {
+                parser->state = kHAPIPWriteRequestParserState_AfterMember;
+            }
+        } break;
+        case util_JSON_READER_STATE_AFTER_NAME_SEPARATOR:
+        case util_JSON_READER_STATE_AFTER_VALUE_SEPARATOR: {
+            if (!parser->numSkippedLevels) {
+                return kHAPError_InvalidData;
+            }
+        } break;
+        default: {
+        } break;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Handles a JSON reader event within the value of a known member.
+ *
+ * @param      server               Accessory server.
+ * @param      parser               Parser.
+ * @param      event                State of the JSON reader.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the value is malformed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteRequestParserHandleValue(
+        HAPAccessoryServerRef* server,
+        HAPIPWriteRequestParser* parser,
+        int event) {
+    HAPAssert(server);
+    HAPAssert(parser);
+
+    HAPError err;
+
+    HAPIPWriteRequestParserMember member = parser->member;
+    bool isBooleanMember = member == kHAPIPWriteRequestParserMember_Value ||
+                           member == kHAPIPWriteRequestParserMember_EV ||
+                           member == kHAPIPWriteRequestParserMember_Remote ||
+                           member == kHAPIPWriteRequestParserMember_Response;
+    switch (event) {
+        case util_JSON_READER_STATE_BEGINNING_ARRAY: {
+            if (member != kHAPIPWriteRequestParserMember_Characteristics) {
+                return kHAPError_InvalidData;
+            }
+            parser->state = kHAPIPWriteRequestParserState_BeforeWriteRequest;
+            return kHAPError_None;
+        }
+        case util_JSON_READER_STATE_BEGINNING_NUMBER: {
+            if (member == kHAPIPWriteRequestParserMember_Characteristics ||
+                member == kHAPIPWriteRequestParserMember_AuthData) {
+                return kHAPError_InvalidData;
+            }
+            parser->numTokenBytes = 0;
+            parser->isTokenTruncated = false;
+            return kHAPError_None;
+        }
+        case util_JSON_READER_STATE_BEGINNING_STRING: {
+            if (member != kHAPIPWriteRequestParserMember_Value && member != kHAPIPWriteRequestParserMember_AuthData) {
+                return kHAPError_InvalidData;
+            }
+            WriteRequestParserBeginString(server, parser);
+            return kHAPError_None;
+        }
+        case util_JSON_READER_STATE_BEGINNING_FALSE:
+        case util_JSON_READER_STATE_BEGINNING_TRUE: {
+            return isBooleanMember ? kHAPError_None : kHAPError_InvalidData;
+        }
+        case util_JSON_READER_STATE_COMPLETED_NUMBER:
+        case util_JSON_READER_STATE_COMPLETED_FALSE:
+        case util_JSON_READER_STATE_COMPLETED_TRUE: {
+            parser->state = kHAPIPWriteRequestParserState_AfterMember;
+        } break;
+        case util_JSON_READER_STATE_COMPLETED_STRING: {
+            parser->state = kHAPIPWriteRequestParserState_AfterMember;
+            return WriteRequestParserCompleteString(parser);
+        }
+        default: {
+            return kHAPError_InvalidData;
+        }
+    }
+
+    HAPIPWriteContext* writeContext = &parser->writeContext;
+    switch (member) {
+        case kHAPIPWriteRequestParserMember_PID: {
+            err = WriteRequestParserGetUInt64Token(parser, &parser->pid);
+            if (err) {
+                HAPLogBuffer(&logObject, parser->tokenBytes, parser->numTokenBytes, "Invalid PID requested.");
+                return err;
+            }
+            parser->hasPID = true;
+        } break;
+        case kHAPIPWriteRequestParserMember_AID: {
+            err = WriteRequestParserGetUInt64Token(parser, &writeContext->aid);
+            if (err) {
+                return err;
+            }
+            parser->hasAID = true;
+        } break;
+        case kHAPIPWriteRequestParserMember_IID: {
+            err = WriteRequestParserGetUInt64Token(parser, &writeContext->iid);
+            if (err) {
+                return err;
+            }
+            parser->hasIID = true;
+        } break;
+        case kHAPIPWriteRequestParserMember_Value: {
+            writeContext->isValueDecoded = false;
+            if (event == util_JSON_READER_STATE_COMPLETED_NUMBER) {
+                if (parser->isTokenTruncated) {
+                    return kHAPError_InvalidData;
+                }
+                parser->tokenBytes[parser->numTokenBytes] = '\0';
+                return GetWriteRequestNumberValue(
+                        parser->tokenBytes,
+                        &writeContext->type,
+                        &writeContext->value.intValue,
+                        &writeContext->value.unsignedIntValue,
+                        &writeContext->value.floatValue);
+            }
+            writeContext->value.unsignedIntValue = event == util_JSON_READER_STATE_COMPLETED_TRUE ? 1 : 0;
+            writeContext->type = kHAPIPWriteValueType_UInt;
+        } break;
+        case kHAPIPWriteRequestParserMember_EV: {
+            bool value;
+            err = WriteRequestParserGetBoolToken(parser, event, &value);
+            if (err) {
+                return err;
+            }
+            writeContext->ev = value ? kHAPIPEventNotificationState_Enabled : kHAPIPEventNotificationState_Disabled;
+        } break;
+        case kHAPIPWriteRequestParserMember_Remote: {
+            err = WriteRequestParserGetBoolToken(parser, event, &writeContext->remote);
+            if (err) {
+                return err;
+            }
+        } break;
+        case kHAPIPWriteRequestParserMember_Response: {
+            err = WriteRequestParserGetBoolToken(parser, event, &writeContext->response);
+            if (err) {
+                return err;
+            }
+        } break;
+        case kHAPIPWriteRequestParserMember_Unknown:
+        case kHAPIPWriteRequestParserMember_Characteristics:
+        case kHAPIPWriteRequestParserMember_AuthData: {
+            HAPFatalError();
+        }
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Handles a JSON reader event.
+ *
+ * @param      server               Accessory server.
+ * @param      parser               Parser.
+ * @param      event                State of the JSON reader.
+ * @param[out] hasWriteRequest      Set to true if a write request object has been completed.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If the request is malformed.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError WriteRequestParserHandleEvent(
+        HAPAccessoryServerRef* server,
+        HAPIPWriteRequestParser* parser,
+        int event,
+        bool* hasWriteRequest) {
+    HAPAssert(server);
+    HAPAssert(parser);
+    HAPAssert(hasWriteRequest);
+
+    switch (parser->state) {
+        case kHAPIPWriteRequestParserState_BeforeRequest: {
+            if (event != util_JSON_READER_STATE_BEGINNING_OBJECT) {
+                return kHAPError_InvalidData;
+            }
+            parser->state = kHAPIPWriteRequestParserState_BeforeMember;
+        } break;
+        case kHAPIPWriteRequestParserState_BeforeMember: {
+            if (event != util_JSON_READER_STATE_BEGINNING_STRING) {
+                return kHAPError_InvalidData;
+            }
+            parser->numTokenBytes = 0;
+            parser->isTokenTruncated = false;
+            parser->state = kHAPIPWriteRequestParserState_MemberName;
+        } break;
+        case kHAPIPWriteRequestParserState_MemberName: {
+            HAPAssert(event == util_JSON_READER_STATE_COMPLETED_STRING);
+            parser->state = kHAPIPWriteRequestParserState_AfterMemberName;
+            return WriteRequestParserCompleteMemberName(parser);
+        }
+        case kHAPIPWriteRequestParserState_AfterMemberName: {
+            if (event != util_JSON_READER_STATE_AFTER_NAME_SEPARATOR) {
+                return kHAPError_InvalidData;
+            }
+            parser->state = kHAPIPWriteRequestParserState_MemberValue;
+        } break;
+        case kHAPIPWriteRequestParserState_MemberValue: {
+            if (parser->member == kHAPIPWriteRequestParserMember_Unknown) {
+                return WriteRequestParserSkipValue(parser, event);
+            }
+            return WriteRequestParserHandleValue(server, parser, event);
+        }
+        case kHAPIPWriteRequestParserState_AfterMember: {
+            if (event == util_JSON_READER_STATE_AFTER_VALUE_SEPARATOR) {
+                parser->state = kHAPIPWriteRequestParserState_BeforeMember;
+            } else if (event != util_JSON_READER_STATE_COMPLETED_OBJECT) {
+                return kHAPError_InvalidData;
+            } else if (!parser->isInWriteRequest) {
+                parser->state = kHAPIPWriteRequestParserState_AfterRequest;
+            } else {
+                if (!parser->hasAID || !parser->hasIID) {
+                    return kHAPError_InvalidData;
+                }
+                parser->isInWriteRequest = false;
+                parser->state = kHAPIPWriteRequestParserState_AfterWriteRequest;
+                *hasWriteRequest = true;
+            }
+        } break;
+        case kHAPIPWriteRequestParserState_BeforeWriteRequest: {
+            if (event != util_JSON_READER_STATE_BEGINNING_OBJECT) {
+                return kHAPError_InvalidData;
+            }
+            HAPRawBufferZero(&parser->writeContext, sizeof parser->writeContext);
+            parser->writeContextError = kHAPError_None;
+            parser->numStagedBytes = parser->numRetainedStagingBytes;
+            parser->hasAID = false;
+            parser->hasIID = false;
+            parser->isInWriteRequest = true;
+            parser->state = kHAPIPWriteRequestParserState_BeforeMember;
+        } break;
+        case kHAPIPWriteRequestParserState_AfterWriteRequest: {
+            if (event == util_JSON_READER_STATE_AFTER_VALUE_SEPARATOR) {
+                parser->state = kHAPIPWriteRequestParserState_BeforeWriteRequest;
+            } else if (event == util_JSON_READER_STATE_COMPLETED_ARRAY) {
+                parser->state = kHAPIPWriteRequestParserState_AfterMember;
+            } else {
+                return kHAPError_InvalidData;
+            }
+        } break;
+        case kHAPIPWriteRequestParserState_AfterRequest: {
+            return kHAPError_InvalidData;
+        }
+    }
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPIPWriteRequestParserRead(
+        HAPAccessoryServerRef* server,
+        HAPIPWriteRequestParser* parser,
+        const char* bytes,
+        size_t numBytes,
+        size_t* numBytesRead,
+        bool* hasWriteRequest) {
+    HAPPrecondition(server);
+    HAPPrecondition(parser);
+    HAPPrecondition(bytes);
+    HAPPrecondition(numBytesRead);
+    HAPPrecondition(hasWriteRequest);
+
+    HAPError err;
+
+    *numBytesRead = 0;
+    *hasWriteRequest = false;
+    while (*numBytesRead < numBytes && !*hasWriteRequest) {
+        int previousState = parser->jsonReader.state;
+        const char* chunkBytes = &bytes[*numBytesRead];
+        size_t numChunkBytes = util_json_reader_read(&parser->jsonReader, chunkBytes, numBytes - *numBytesRead);
+        *numBytesRead += numChunkBytes;
+        int state = parser->jsonReader.state;
+        if (state == util_JSON_READER_STATE_ERROR) {
+            return kHAPError_InvalidData;
+        }
+
+        // Collect the contents of strings and numbers. Strings include their quotation marks.
+        if (previousState == util_JSON_READER_STATE_BEGINNING_STRING ||
+            previousState == util_JSON_READER_STATE_READING_STRING) {
+            if (previousState == util_JSON_READER_STATE_BEGINNING_STRING) {
+                HAPAssert(numChunkBytes && chunkBytes[0] == '"');
+                chunkBytes++;
+                numChunkBytes--;
+            }
+            if (state == util_JSON_READER_STATE_COMPLETED_STRING) {
+                HAPAssert(numChunkBytes && chunkBytes[numChunkBytes - 1] == '"');
+                numChunkBytes--;
+            }
+            if (parser->state == kHAPIPWriteRequestParserState_MemberName) {
+                WriteRequestParserAppendTokenBytes(parser, chunkBytes, numChunkBytes);
+            } else if (
+                    parser->state == kHAPIPWriteRequestParserState_MemberValue &&
+                    (parser->member == kHAPIPWriteRequestParserMember_Value ||
+                     parser->member == kHAPIPWriteRequestParserMember_AuthData)) {
+                err = WriteRequestParserAppendStringBytes(parser, chunkBytes, numChunkBytes);
+                if (err) {
+                    HAPAssert(err == kHAPError_InvalidData);
+                    return err;
+                }
+            }
+        } else if (
+                previousState == util_JSON_READER_STATE_BEGINNING_NUMBER ||
+                previousState == util_JSON_READER_STATE_READING_NUMBER) {
+            WriteRequestParserAppendTokenBytes(parser, chunkBytes, numChunkBytes);
+        }
+
+        if (state != util_JSON_READER_STATE_READING_WHITESPACE && state != util_JSON_READER_STATE_READING_NUMBER &&
+            state != util_JSON_READER_STATE_READING_STRING && state != util_JSON_READER_STATE_READING_FALSE &&
+            state != util_JSON_READER_STATE_READING_TRUE && state != util_JSON_READER_STATE_READING_NULL) {
+            err = WriteRequestParserHandleEvent(server, parser, state, hasWriteRequest);
+            if (err) {
+                HAPAssert(err == kHAPError_InvalidData);
+                return err;
+            }
+        }
+    }
+    return kHAPError_None;
+}
+
+void HAPIPWriteRequestParserRetainStagedBytes(HAPIPWriteRequestParser* parser) {
+    HAPPrecondition(parser);
+    HAPPrecondition(parser->state == kHAPIPWriteRequestParserState_AfterWriteRequest);
+
+    parser->numRetainedStagingBytes = parser->numStagedBytes;
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPIPWriteRequestParserIsComplete(const HAPIPWriteRequestParser* parser) {
+    HAPPrecondition(parser);
+
+    return parser->state == kHAPIPWriteRequestParserState_AfterRequest;
+}
+
 HAP_RESULT_USE_CHECK
 size_t HAPIPAccessoryProtocolGetNumCharacteristicWriteResponseBytes(
         HAPAccessoryServerRef* server,
@@ -1691,7 +2478,8 @@ size_t HAPIPAccessoryProtocolGetNumCharacteristicWriteResponseBytes(
              HAPUInt64GetNumDescriptionBytes(writeContext->iid) + HAPInt32GetNumDescriptionBytes(writeContext->status);
         if ((writeContext->status == 0) && writeContext->response) {
             r += 9;
-            const HAPBaseCharacteristic* chr_ = GetCharacteristic(server, writeContext->aid, writeContext->iid);
+            const HAPBaseCharacteristic* chr_ = GetCharacteristic(
+                    server, writeContext->aid, writeContext->iid, /* characteristicTypeID: */ NULL);
             HAPAssert(chr_);
             switch (chr_->format) {
                 case kHAPCharacteristicFormat_Bool: {
@@ -1723,6 +2511,102 @@ size_t HAPIPAccessoryProtocolGetNumCharacteristicWriteResponseBytes(
     return r;
 }
 
+HAP_RESULT_USE_CHECK
+HAPError HAPIPAccessoryProtocolGetCharacteristicWriteResponseObjectBytes(
+        HAPAccessoryServerRef* server,
+        HAPIPWriteContextRef* writeContext_,
+        HAPIPByteBuffer* buffer) {
+    HAPPrecondition(server);
+    HAPPrecondition(writeContext_);
+    HAPIPWriteContext* writeContext = (HAPIPWriteContext*) writeContext_;
+    HAPPrecondition(buffer);
+
+    HAPError err;
+
+    char scratch_string[64];
+
+    char aidDescription[64];
+    err = HAPUInt64GetDescription(uintval(writeContext->aid), aidDescription, sizeof aidDescription);
+    HAPAssert(!err);
+    char iidDescription[64];
+    err = HAPUInt64GetDescription(uintval(writeContext->iid), iidDescription, sizeof iidDescription);
+    HAPAssert(!err);
+    err = HAPIPByteBufferAppendStringWithFormat(
+            buffer,
+            "{\"aid\":%s,\"iid\":%s,\"status\":%ld",
+            aidDescription,
+            iidDescription,
+            (long) writeContext->status);
+    if (err) {
+        goto error;
+    }
+    if ((writeContext->status == 0) && writeContext->response) {
+        const HAPBaseCharacteristic* chr_ =
+                GetCharacteristic(server, writeContext->aid, writeContext->iid, /* characteristicTypeID: */ NULL);
+        HAPAssert(chr_);
+        switch (chr_->format) {
+            case kHAPCharacteristicFormat_Bool: {
+                err = HAPIPByteBufferAppendStringWithFormat(
+                        buffer, ",\"value\":%s", writeContext->value.unsignedIntValue ? "1" : "0");
+            } break;
+            case kHAPCharacteristicFormat_UInt8:
+            case kHAPCharacteristicFormat_UInt16:
+            case kHAPCharacteristicFormat_UInt32:
+            case kHAPCharacteristicFormat_UInt64: {
+                err = HAPIPByteBufferAppendStringWithFormat(buffer, ",\"value\":");
+                if (err) {
+                    goto error;
+                }
+                err = HAPUInt64GetDescription(
+                        uintval(writeContext->value.unsignedIntValue), scratch_string, sizeof scratch_string);
+                HAPAssert(!err);
+                err = HAPIPByteBufferAppendStringWithFormat(buffer, "%s", scratch_string);
+            } break;
+            case kHAPCharacteristicFormat_Int: {
+                err = HAPIPByteBufferAppendStringWithFormat(
+                        buffer, ",\"value\":%ld", (long) writeContext->value.intValue);
+            } break;
+            case kHAPCharacteristicFormat_Float: {
+                err = HAPJSONUtilsGetFloatDescription(
+                        writeContext->value.floatValue, scratch_string, sizeof scratch_string);
+                HAPAssert(!err);
+                err = HAPIPByteBufferAppendStringWithFormat(buffer, ",\"value\":%s", scratch_string);
+            } break;
+            case kHAPCharacteristicFormat_String:
+            case kHAPCharacteristicFormat_TLV8:
+            case kHAPCharacteristicFormat_Data: {
+                err = HAPIPByteBufferAppendStringWithFormat(buffer, ",\"value\":\"");
+                if (err) {
+                    goto error;
+                }
+                size_t bufferMark = buffer->position;
+                err = HAPIPByteBufferAppendStringWithFormat(buffer, "%s", writeContext->value.stringValue.bytes);
+                if (err) {
+                    goto error;
+                }
+                size_t numStringDataBytes = writeContext->value.stringValue.numBytes;
+                err = HAPJSONUtilsEscapeStringData(
+                        &buffer->data[bufferMark], buffer->limit - bufferMark, &numStringDataBytes);
+                if (err) {
+                    goto error;
+                }
+                buffer->position = bufferMark + numStringDataBytes;
+                err = HAPIPByteBufferAppendStringWithFormat(buffer, "\"");
+            } break;
+        }
+        if (err) {
+            goto error;
+        }
+    }
+    err = HAPIPByteBufferAppendStringWithFormat(buffer, "}");
+    if (err) {
+        goto error;
+    }
+    return kHAPError_None;
+error:
+    return kHAPError_OutOfResources;
+}
+
 HAP_RESULT_USE_CHECK
 HAPError HAPIPAccessoryProtocolGetCharacteristicWriteResponseBytes(
         HAPAccessoryServerRef* server,
@@ -1736,88 +2620,19 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicWriteResponseBytes(
     HAPError err;
 
     size_t i;
-    char scratch_string[64];
 
     err = HAPIPByteBufferAppendStringWithFormat(buffer, "{\"characteristics\":[");
     if (err) {
         goto error;
     }
     for (i = 0; i < numWriteContexts; i++) {
-        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &writeContexts[i];
-        char aidDescription[64];
-        err = HAPUInt64GetDescription(uintval(writeContext->aid), aidDescription, sizeof aidDescription);
-        HAPAssert(!err);
-        char iidDescription[64];
-        err = HAPUInt64GetDescription(uintval(writeContext->iid), iidDescription, sizeof iidDescription);
-        HAPAssert(!err);
-        err = HAPIPByteBufferAppendStringWithFormat(
-                buffer,
-                "%s{\"aid\":%s,\"iid\":%s,\"status\":%ld",
-                i == 0 ? "" : ",",
-                aidDescription,
-                iidDescription,
-                (long) writeContext->status);
-        if (err) {
-            goto error;
-        }
-        if ((writeContext->status == 0) && writeContext->response) {
-            const HAPBaseCharacteristic* chr_ = GetCharacteristic(server, writeContext->aid, writeContext->iid);
-            HAPAssert(chr_);
-            switch (chr_->format) {
-                case kHAPCharacteristicFormat_Bool: {
-                    err = HAPIPByteBufferAppendStringWithFormat(
-                            buffer, ",\"value\":%s", writeContext->value.unsignedIntValue ? "1" : "0");
-                } break;
-                case kHAPCharacteristicFormat_UInt8:
-                case kHAPCharacteristicFormat_UInt16:
-                case kHAPCharacteristicFormat_UInt32:
-                case kHAPCharacteristicFormat_UInt64: {
-                    err = HAPIPByteBufferAppendStringWithFormat(buffer, ",\"value\":");
-                    if (err) {
-                        goto error;
-                    }
-                    err = HAPUInt64GetDescription(
-                            uintval(writeContext->value.unsignedIntValue), scratch_string, sizeof scratch_string);
-                    HAPAssert(!err);
-                    err = HAPIPByteBufferAppendStringWithFormat(buffer, "%s", scratch_string);
-                } break;
-                case kHAPCharacteristicFormat_Int: {
-                    err = HAPIPByteBufferAppendStringWithFormat(
-                            buffer, ",\"value\":%ld", (long) writeContext->value.intValue);
-                } break;
-                case kHAPCharacteristicFormat_Float: {
-                    err = HAPJSONUtilsGetFloatDescription(
-                            writeContext->value.floatValue, scratch_string, sizeof scratch_string);
-                    HAPAssert(!err);
-                    err = HAPIPByteBufferAppendStringWithFormat(buffer, ",\"value\":%s", scratch_string);
-                } break;
-                case kHAPCharacteristicFormat_String:
-                case kHAPCharacteristicFormat_TLV8:
-                case kHAPCharacteristicFormat_Data: {
-                    err = HAPIPByteBufferAppendStringWithFormat(buffer, ",\"value\":\"");
-                    if (err) {
-                        goto error;
-                    }
-                    size_t bufferMark = buffer->position;
-                    err = HAPIPByteBufferAppendStringWithFormat(buffer, "%s", writeContext->value.stringValue.bytes);
-                    if (err) {
-                        goto error;
-                    }
-                    size_t numStringDataBytes = writeContext->value.stringValue.numBytes;
-                    err = HAPJSONUtilsEscapeStringData(
-                            &buffer->data[bufferMark], buffer->limit - bufferMark, &numStringDataBytes);
-                    if (err) {
-                        goto error;
-                    }
-                    buffer->position = bufferMark + numStringDataBytes;
-                    err = HAPIPByteBufferAppendStringWithFormat(buffer, "\"");
-                } break;
-            }
+        if (i) {
+            err = HAPIPByteBufferAppendStringWithFormat(buffer, ",");
             if (err) {
                 goto error;
             }
         }
-        err = HAPIPByteBufferAppendStringWithFormat(buffer, "}");
+        err = HAPIPAccessoryProtocolGetCharacteristicWriteResponseObjectBytes(server, &writeContexts[i], buffer);
         if (err) {
             goto error;
         }
@@ -1849,7 +2664,8 @@ size_t HAPIPAccessoryProtocolGetNumEventNotificationBytes(
         r += (i == 0 ? 24 : 25) + HAPUInt64GetNumDescriptionBytes(readContext->aid) +
              HAPUInt64GetNumDescriptionBytes(readContext->iid);
         if (readContext->status == 0) {
-            const HAPBaseCharacteristic* chr_ = GetCharacteristic(server, readContext->aid, readContext->iid);
+            const HAPBaseCharacteristic* chr_ = GetCharacteristic(
+                    server, readContext->aid, readContext->iid, /* characteristicTypeID: */ NULL);
             HAPAssert(chr_);
             switch (chr_->format) {
                 case kHAPCharacteristicFormat_Bool: {
@@ -1927,7 +2743,8 @@ HAPError HAPIPAccessoryProtocolGetEventNotificationBytes(
         }
 
         if (readContext->status == 0) {
-            const HAPBaseCharacteristic* chr_ = GetCharacteristic(server, readContext->aid, readContext->iid);
+            const HAPBaseCharacteristic* chr_ = GetCharacteristic(
+                    server, readContext->aid, readContext->iid, /* characteristicTypeID: */ NULL);
             HAPAssert(chr_);
             switch (chr_->format) {
                 case kHAPCharacteristicFormat_Bool: {
@@ -2039,7 +2856,7 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicWritePreparation(
         HAPAssert(i <= j);
         HAPAssert(j <= k);
         HAPAssert(k <= numBytes);
-        if ((j - i == 5) && HAPRawBufferAreEqual(&bytes[i], "\"ttl\"", 5)) {
+        if ((j - i == 5) && HAPRawBufferAreEqualPublic(&bytes[i], "\"ttl\"", 5)) {
             if (hasTTL) {
                 HAPLog(&logObject, "Multiple TTL entries detected.");
                 goto error;
@@ -2069,7 +2886,7 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicWritePreparation(
             } else {
                 goto error;
             }
-        } else if ((j - i == 5) && HAPRawBufferAreEqual(&bytes[i], "\"pid\"", 5)) {
+        } else if ((j - i == 5) && HAPRawBufferAreEqualPublic(&bytes[i], "\"pid\"", 5)) {
             if (hasPID) {
                 HAPLog(&logObject, "Multiple PID entries detected.");
                 goto error;
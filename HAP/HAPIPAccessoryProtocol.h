@@ -12,6 +12,7 @@ extern "C" {
 #endif
 
 #include "HAP+Internal.h"
+#include "util_json_reader.h"
 
 #if __has_feature(nullability)
 #pragma clang assume_nonnull begin
@@ -25,6 +26,7 @@ typedef struct {
     uint64_t aid;
     uint64_t iid;
     int32_t status;
+    HAPCompletionToken completionToken; /**< Completion token of a read that completes asynchronously. */
     union {
         int32_t intValue;
         uint64_t unsignedIntValue;
@@ -102,6 +104,7 @@ typedef struct {
     bool remote;
     HAPIPEventNotificationState ev;
     bool response;
+    bool isValueDecoded; /**< Whether a base64 encoded value has already been decoded. */
 } HAPIPWriteContext;
 HAP_STATIC_ASSERT(sizeof(HAPIPWriteContextRef) >= sizeof(HAPIPWriteContext), HAPIPWriteContext);
 
@@ -130,12 +133,254 @@ HAPError HAPIPAccessoryProtocolGetCharacteristicWriteRequests(
         bool* hasPID,
         uint64_t* pid);
 
+/**
+ * Maximum number of bytes of a member name or number in a PUT /characteristics request parsed by a
+ * HAPIPWriteRequestParser. Longer member names are treated as unknown members.
+ */
+#define kHAPIPWriteRequestParser_MaxTokenBytes ((size_t) 64)
+
+/**
+ * Position of a HAPIPWriteRequestParser within a PUT /characteristics request.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPIPWriteRequestParserState) {
+    /** Before the request object. */
+    kHAPIPWriteRequestParserState_BeforeRequest,
+
+    /** Before a member of the request object or of a write request object. */
+    kHAPIPWriteRequestParserState_BeforeMember,
+
+    /** Reading a member name. */
+    kHAPIPWriteRequestParserState_MemberName,
+
+    /** After a member name, before the name separator. */
+    kHAPIPWriteRequestParserState_AfterMemberName,
+
+    /** Reading a member value. */
+    kHAPIPWriteRequestParserState_MemberValue,
+
+    /** After a member value. */
+    kHAPIPWriteRequestParserState_AfterMember,
+
+    /** Before a write request object in the "characteristics" array. */
+    kHAPIPWriteRequestParserState_BeforeWriteRequest,
+
+    /** After a write request object in the "characteristics" array. */
+    kHAPIPWriteRequestParserState_AfterWriteRequest,
+
+    /** After the request object. */
+    kHAPIPWriteRequestParserState_AfterRequest
+} HAP_ENUM_END(uint8_t, HAPIPWriteRequestParserState);
+
+/**
+ * Member of a PUT /characteristics request whose value is being read by a HAPIPWriteRequestParser.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPIPWriteRequestParserMember) {
+    /** Unknown member. The value is skipped. */
+    kHAPIPWriteRequestParserMember_Unknown,
+
+    /** "characteristics" array of the request object. */
+    kHAPIPWriteRequestParserMember_Characteristics,
+
+    /** "pid" of the request object. */
+    kHAPIPWriteRequestParserMember_PID,
+
+    /** "aid" of a write request. */
+    kHAPIPWriteRequestParserMember_AID,
+
+    /** "iid" of a write request. */
+    kHAPIPWriteRequestParserMember_IID,
+
+    /** "value" of a write request. */
+    kHAPIPWriteRequestParserMember_Value,
+
+    /** "ev" of a write request. */
+    kHAPIPWriteRequestParserMember_EV,
+
+    /** "authData" of a write request. */
+    kHAPIPWriteRequestParserMember_AuthData,
+
+    /** "remote" of a write request. */
+    kHAPIPWriteRequestParserMember_Remote,
+
+    /** "r" of a write request. */
+    kHAPIPWriteRequestParserMember_Response
+} HAP_ENUM_END(uint8_t, HAPIPWriteRequestParserMember);
+
+/**
+ * Incremental parser for PUT /characteristics requests.
+ *
+ * - The request body is passed in arbitrarily split pieces. Each write request is reported as soon as its object
+ *   is complete, so the body does not need to be buffered as a whole.
+ *
+ * - String values and authorization data are staged in a caller provided buffer. Values of data and TLV8
+ *   characteristics are base64 decoded while they are received if the characteristic is known at that time,
+ *   i.e. if "aid" and "iid" precede "value".
+ */
+typedef struct {
+    /** JSON reader. */
+    struct util_json_reader jsonReader;
+
+    /** Position within the request. */
+    HAPIPWriteRequestParserState state;
+
+    /** Member whose name or value is being read. */
+    HAPIPWriteRequestParserMember member;
+
+    /** Whether the parser is within a write request object. */
+    bool isInWriteRequest : 1;
+
+    /** Whether the member name exceeded kHAPIPWriteRequestParser_MaxTokenBytes. */
+    bool isTokenTruncated : 1;
+
+    /** Whether the current write request contains an "aid". */
+    bool hasAID : 1;
+
+    /** Whether the current write request contains an "iid". */
+    bool hasIID : 1;
+
+    /** Whether the string that is being staged is base64 decoded while it is received. */
+    bool isDecodingBase64 : 1;
+
+    /** Whether the base64 string that is being decoded contained padding. */
+    bool isBase64Padded : 1;
+
+    /** Whether the request contains a "pid". */
+    bool hasPID : 1;
+
+    /** Number of nested arrays and objects within a skipped value. */
+    size_t numSkippedLevels;
+
+    /** Member name or number that is being read. */
+    char tokenBytes[kHAPIPWriteRequestParser_MaxTokenBytes];
+
+    /** Length of the member name or number that is being read. */
+    size_t numTokenBytes;
+
+    /** Characters of an incomplete base64 group. */
+    char base64Bytes[4];
+
+    /** Number of characters of the incomplete base64 group. */
+    uint8_t numBase64Bytes;
+
+    /** Incomplete escape sequence within a base64 string. */
+    char escapeBytes[sizeof "\\u0000" - 1];
+
+    /** Length of the incomplete escape sequence. */
+    uint8_t numEscapeBytes;
+
+    /** Buffer for staging string values and authorization data. */
+    char* _Nullable stagingBytes;
+
+    /** Capacity of the staging buffer. */
+    size_t maxStagingBytes;
+
+    /** Number of staged bytes that are retained across write requests. */
+    size_t numRetainedStagingBytes;
+
+    /** Number of staged bytes. */
+    size_t numStagedBytes;
+
+    /** Offset of the string that is being staged. */
+    size_t stringOffset;
+
+    /**
+     * Write request that is being read. After a write request has been reported, contains the write request.
+     *
+     * - String values and authorization data refer to the staging buffer.
+     */
+    HAPIPWriteContext writeContext;
+
+    /**
+     * Error that prevents the reported write request from being handled.
+     *
+     * - kHAPError_InvalidData if the value could not be decoded.
+     * - kHAPError_OutOfResources if the value or authorization data did not fit into the staging buffer.
+     */
+    HAPError writeContextError;
+
+    /** PID, if the request contains a "pid". */
+    uint64_t pid;
+} HAPIPWriteRequestParser;
+
+/**
+ * Initializes a parser for a PUT /characteristics request.
+ *
+ * @param[out] parser               Parser.
+ * @param      stagingBytes         Buffer for staging string values and authorization data. Optional.
+ * @param      maxStagingBytes      Capacity of @p stagingBytes.
+ */
+void HAPIPWriteRequestParserCreate(
+        HAPIPWriteRequestParser* parser,
+        void* _Nullable stagingBytes,
+        size_t maxStagingBytes);
+
+/**
+ * Feeds a piece of a PUT /characteristics request body to a parser.
+ *
+ * - Parsing stops after a write request object is complete. The write request is available in the writeContext
+ *   member of the parser until the next invocation.
+ *
+ * @param      server               Accessory server.
+ * @param      parser               Parser.
+ * @param      bytes                Piece of the request body.
+ * @param      numBytes             Length of @p bytes.
+ * @param[out] numBytesRead         Number of bytes of @p bytes that have been consumed.
+ * @param[out] hasWriteRequest      True if a write request object has been completed. False otherwise.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidData    If request malformed.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPIPWriteRequestParserRead(
+        HAPAccessoryServerRef* server,
+        HAPIPWriteRequestParser* parser,
+        const char* bytes,
+        size_t numBytes,
+        size_t* numBytesRead,
+        bool* hasWriteRequest);
+
+/**
+ * Retains the bytes that have been staged for the reported write request.
+ *
+ * - Subsequent write requests are staged behind the retained bytes.
+ *
+ * @param      parser               Parser.
+ */
+void HAPIPWriteRequestParserRetainStagedBytes(HAPIPWriteRequestParser* parser);
+
+/**
+ * Returns whether a parser has read a complete PUT /characteristics request.
+ *
+ * @param      parser               Parser.
+ *
+ * @return true                     If the request object is complete.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPIPWriteRequestParserIsComplete(const HAPIPWriteRequestParser* parser);
+
 HAP_RESULT_USE_CHECK
 size_t HAPIPAccessoryProtocolGetNumCharacteristicWriteResponseBytes(
         HAPAccessoryServerRef* server,
         HAPIPWriteContextRef* writeContexts,
         size_t numWriteContexts);
 
+/**
+ * Serializes the response object of a single characteristic write request.
+ *
+ * @param      server               Accessory server.
+ * @param      writeContext         Handled write request.
+ * @param      buffer               Buffer to append the response object to.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If @p buffer is not large enough.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPIPAccessoryProtocolGetCharacteristicWriteResponseObjectBytes(
+        HAPAccessoryServerRef* server,
+        HAPIPWriteContextRef* writeContext,
+        HAPIPByteBuffer* buffer);
+
 HAP_RESULT_USE_CHECK
 HAPError HAPIPAccessoryProtocolGetCharacteristicWriteResponseBytes(
         HAPAccessoryServerRef* server,
@@ -63,6 +63,11 @@ static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .categor
 
 /**@}*/
 
+/**
+ * Internal status code of a request whose handler completes asynchronously. Never sent to controllers.
+ */
+#define kHAPIPAccessoryServerStatusCode_InProgress ((int32_t) 1)
+
 /**
  * Predefined HTTP/1.1 response indicating successful request completion with an empty response body.
  */
@@ -137,14 +142,32 @@ static const HAPLogObject logObject = { .subsystem = kHAP_LogSubsystem, .categor
  * Maximum time an IP session can stay idle before it will be closed by the accessory server.
  *
  * - Maximum idle time will on be enforced during shutdown of the accessory server or at maximum capacity.
+ *
+ * - Shorter idle timeouts may be configured per session state. See HAPAccessoryServerOptions.
  */
 #define kHAPIPSession_MaxIdleTime ((HAPTime)(60 * HAPSecond))
 
+/**
+ * Time after its last activity during which an IP session with Pair Verify in progress is not evicted
+ * to admit a new connection.
+ *
+ * - Pair Verify M1 does not require credentials. Sessions that stall during Pair Verify are therefore only
+ *   protected for a limited time, so that a flood of connections cannot hold all IP sessions.
+ */
+#define kHAPIPSession_PairVerifyGracePeriod ((HAPTime)(10 * HAPSecond))
+
 /**
  * Maximum delay during which event notifications will be coalesced into a single message.
  */
 #define kHAPIPAccessoryServer_MaxEventNotificationDelay ((HAPTime)(1 * HAPSecond))
 
+/**
+ * Maximum time a request waits for an asynchronous read or write handler to complete.
+ *
+ * - Reads and writes that have not been completed in time are reported as busy.
+ */
+#define kHAPIPAccessoryServer_MaxAsynchronousRequestTime ((HAPTime)(10 * HAPSecond))
+
 static void log_result(HAPLogType type, char* msg, int result, const char* function, const char* file, int line) {
     HAPAssert(msg);
     HAPAssert(function);
@@ -184,13 +207,19 @@ static void get_db_ctx(
         uint64_t iid,
         const HAPCharacteristic** chr,
         const HAPService** svc,
-        const HAPAccessory** acc) {
+        const HAPAccessory** acc,
+        HAPTypeID* _Nullable chrTypeID) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
     HAPPrecondition(chr);
     HAPPrecondition(svc);
     HAPPrecondition(acc);
 
+    if (HAPAttributeDatabaseIsFlattened(server_)) {
+        HAPAttributeDatabaseFindIPCharacteristic(server_, aid, iid, chr, svc, acc, chrTypeID);
+        return;
+    }
+
     *chr = NULL;
     *svc = NULL;
     *acc = NULL;
@@ -236,6 +265,9 @@ static void get_db_ctx(
             }
         }
     }
+    if (*chr && chrTypeID) {
+        *chrTypeID = HAPAttributeDatabaseGetTypeID(((const HAPBaseCharacteristic*) *chr)->characteristicType);
+    }
 }
 
 static void publish_homeKit_service(HAPAccessoryServerRef* server_) {
@@ -253,6 +285,166 @@ static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManag
 
 static void schedule_max_idle_time_timer(HAPAccessoryServerRef* server_);
 
+/**
+ * Gets the IP session that contains an IP session descriptor.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return IP session.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSession* GetIPSession(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+
+    // The IP session descriptor is the first member of the IP session.
+    return (HAPIPSession*) (void*) session;
+}
+
+/**
+ * Gets the links of an IP session in the session lists of a kind.
+ *
+ * @param      ipSession            IP session.
+ * @param      kind                 Kind of session list.
+ *
+ * @return Session list links.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSessionListLinks* GetSessionListLinks(HAPIPSession* ipSession, HAPIPSessionListKind kind) {
+    HAPPrecondition(ipSession);
+    HAPPrecondition(kind < kHAPIPSessionListKind_NumKinds);
+
+    HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
+    return &session->listLinks[kind];
+}
+
+/**
+ * Initializes an empty IP session list.
+ *
+ * @param[out] list                 Session list.
+ * @param      kind                 Kind of session list.
+ */
+static void InitializeSessionList(HAPIPSessionList* list, HAPIPSessionListKind kind) {
+    HAPPrecondition(list);
+    HAPPrecondition(kind < kHAPIPSessionListKind_NumKinds);
+
+    HAPRawBufferZero(list, sizeof *list);
+    list->kind = kind;
+}
+
+/**
+ * Appends an IP session to a session list.
+ *
+ * @param      list                 Session list.
+ * @param      ipSession            IP session that is not linked into a session list of the same kind.
+ */
+static void AppendSessionToList(HAPIPSessionList* list, HAPIPSession* ipSession) {
+    HAPPrecondition(list);
+    HAPPrecondition(ipSession);
+    HAPIPSessionListLinks* links = GetSessionListLinks(ipSession, list->kind);
+    HAPPrecondition(!links->list);
+
+    links->list = list;
+    links->prev = list->last;
+    links->next = NULL;
+    if (list->last) {
+        GetSessionListLinks(HAPNonnull(list->last), list->kind)->next = ipSession;
+    } else {
+        list->first = ipSession;
+    }
+    list->last = ipSession;
+    list->numSessions++;
+}
+
+/**
+ * Removes an IP session from the session list of a kind that contains it, if any.
+ *
+ * @param      ipSession            IP session.
+ * @param      kind                 Kind of session list.
+ */
+static void RemoveSessionFromList(HAPIPSession* ipSession, HAPIPSessionListKind kind) {
+    HAPPrecondition(ipSession);
+    HAPIPSessionListLinks* links = GetSessionListLinks(ipSession, kind);
+    if (!links->list) {
+        return;
+    }
+    HAPIPSessionList* list = HAPNonnull(links->list);
+
+    if (links->prev) {
+        GetSessionListLinks(HAPNonnull(links->prev), kind)->next = links->next;
+    } else {
+        list->first = links->next;
+    }
+    if (links->next) {
+        GetSessionListLinks(HAPNonnull(links->next), kind)->prev = links->prev;
+    } else {
+        list->last = links->prev;
+    }
+    HAPAssert(list->numSessions > 0);
+    list->numSessions--;
+    HAPRawBufferZero(links, sizeof *links);
+}
+
+/**
+ * Removes the first IP session from a session list.
+ *
+ * @param      list                 Session list.
+ *
+ * @return First session of the list, if the list is not empty. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSession* _Nullable PopFirstSessionOfList(HAPIPSessionList* list) {
+    HAPPrecondition(list);
+
+    HAPIPSession* _Nullable ipSession = list->first;
+    if (ipSession) {
+        RemoveSessionFromList(HAPNonnull(ipSession), list->kind);
+    }
+    return ipSession;
+}
+
+/**
+ * Moves all IP sessions of a session list to an empty session list of the same kind.
+ *
+ * - Used to visit the sessions of a list exactly once while the visited sessions are removed or added again.
+ *   Sessions that are removed from the source list while they are pending are removed from the target list.
+ *
+ * @param      list                 Session list.
+ * @param[out] targetList           Empty session list that receives the sessions.
+ */
+static void MoveSessionsOfList(HAPIPSessionList* list, HAPIPSessionList* targetList) {
+    HAPPrecondition(list);
+    HAPPrecondition(targetList);
+
+    InitializeSessionList(targetList, list->kind);
+    for (HAPIPSession* _Nullable ipSession = list->first; ipSession;) {
+        HAPIPSessionListLinks* links = GetSessionListLinks(HAPNonnull(ipSession), list->kind);
+        HAPAssert(links->list == list);
+        links->list = targetList;
+        ipSession = links->next;
+    }
+    targetList->first = list->first;
+    targetList->last = list->last;
+    targetList->numSessions = list->numSessions;
+    InitializeSessionList(list, list->kind);
+}
+
+/**
+ * Gets the next IP session of a session list.
+ *
+ * @param      ipSession            IP session that is linked into a session list of the kind.
+ * @param      kind                 Kind of session list.
+ *
+ * @return Next session of the list, if available. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSession* _Nullable GetNextSessionOfList(HAPIPSession* ipSession, HAPIPSessionListKind kind) {
+    HAPPrecondition(ipSession);
+    HAPIPSessionListLinks* links = GetSessionListLinks(ipSession, kind);
+    HAPPrecondition(links->list);
+
+    return links->next;
+}
+
 static void HAPIPSessionDestroy(HAPIPSession* ipSession) {
     HAPPrecondition(ipSession);
 
@@ -263,6 +455,9 @@ static void HAPIPSessionDestroy(HAPIPSession* ipSession) {
 
     HAPLogDebug(&logObject, "session:%p:releasing session", (const void*) session);
 
+    for (size_t i = 0; i < kHAPIPSessionListKind_NumKinds; i++) {
+        HAPAssert(!session->listLinks[i].list);
+    }
     HAPRawBufferZero(&ipSession->descriptor, sizeof ipSession->descriptor);
     HAPRawBufferZero(ipSession->inboundBuffer.bytes, ipSession->inboundBuffer.numBytes);
     HAPRawBufferZero(ipSession->outboundBuffer.bytes, ipSession->outboundBuffer.numBytes);
@@ -279,23 +474,20 @@ static void collect_garbage(HAPAccessoryServerRef* server_) {
         server->ip.garbageCollectionTimer = 0;
     }
 
-    size_t n = 0;
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
-            continue;
-        }
-
-        if (session->state == kHAPIPSessionState_Idle) {
-            HAPIPSessionDestroy(ipSession);
-            HAPAssert(server->ip.numSessions > 0);
-            server->ip.numSessions--;
-        } else {
-            n++;
+    for (;;) {
+        HAPIPSession* _Nullable ipSession = PopFirstSessionOfList(&server->ip.sessionLists.closedSessions);
+        if (!ipSession) {
+            break;
         }
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        HAPAssert(session->server);
+        HAPAssert(session->state == kHAPIPSessionState_Idle);
+        HAPIPSessionDestroy(HAPNonnull(ipSession));
+        AppendSessionToList(&server->ip.sessionLists.freeSessions, HAPNonnull(ipSession));
+        HAPAssert(server->ip.numSessions > 0);
+        server->ip.numSessions--;
     }
-    HAPAssert(n == server->ip.numSessions);
+    HAPAssert(server->ip.sessionLists.openSessions.numSessions == server->ip.numSessions);
 
     // If there are open sessions, wait until they are closed before continuing.
     if (HAPPlatformTCPStreamManagerIsListenerOpen(HAPNonnull(server->platform.ip.tcpStreamManager)) ||
@@ -313,6 +505,14 @@ static void collect_garbage(HAPAccessoryServerRef* server_) {
         HAPPlatformTimerDeregister(server->ip.maxIdleTimeTimer);
         server->ip.maxIdleTimeTimer = 0;
     }
+    if (server->ip.pendingRequestTimer) {
+        HAPPlatformTimerDeregister(server->ip.pendingRequestTimer);
+        server->ip.pendingRequestTimer = 0;
+    }
+    if (server->ip.asynchronousRequestTimer) {
+        HAPPlatformTimerDeregister(server->ip.asynchronousRequestTimer);
+        server->ip.asynchronousRequestTimer = 0;
+    }
     HAPLogDebug(&logObject, "Completing accessory server state transition.");
     if (server->ip.nextState == kHAPIPAccessoryServerState_Running) {
         server->ip.state = kHAPIPAccessoryServerState_Running;
@@ -369,6 +569,110 @@ static void handle_max_idle_time_timer(HAPPlatformTimerRef timer, void* _Nullabl
 
 static void CloseSession(HAPIPSessionDescriptor* session);
 
+static void end_streaming_write(HAPIPSessionDescriptor* session);
+
+static void schedule_pending_requests(HAPAccessoryServerRef* server_);
+
+/**
+ * Returns whether an IP session is idle, i.e., whether it is neither handling a request nor sending a response.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If the session is idle.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsSessionIdle(const HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+
+    return (session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
+           !session->streamingWrite.isActive;
+}
+
+/**
+ * Returns whether Pair Verify has been completed on an IP session.
+ *
+ * - The security session becomes secured before the first encrypted request is received on the session.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If Pair Verify has been completed on the session.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsSessionVerified(const HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+
+    return session->securitySession.isSecured ||
+           (session->securitySession.type == kHAPIPSecuritySessionType_HAP &&
+            HAPSessionIsSecured(&session->securitySession._.hap));
+}
+
+/**
+ * Returns whether Pair Setup is currently performed on an IP session.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If Pair Setup is currently performed on the session.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsSessionPairing(const HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) session->server;
+
+    return server->pairSetup.sessionThatIsCurrentlyPairing == &session->securitySession._.hap;
+}
+
+/**
+ * Returns whether Pair Verify is currently performed on an IP session.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If Pair Verify has been started but not completed on the session.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsSessionVerifying(const HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+
+    if (!session->securitySession.isOpen || session->securitySession.type != kHAPIPSecuritySessionType_HAP ||
+        IsSessionVerified(session)) {
+        return false;
+    }
+    const HAPSession* hapSession = (const HAPSession*) &session->securitySession._.hap;
+    return hapSession->state.pairVerify.state != 0;
+}
+
+/**
+ * Gets the idle timeout of an IP session.
+ *
+ * @param      session              IP session descriptor.
+ * @param      isEnforcingMaxIdleTime Whether kHAPIPSession_MaxIdleTime is enforced.
+ *
+ * @return Idle timeout of the session. 0 if the session is not closed while it is idle.
+ */
+HAP_RESULT_USE_CHECK
+static HAPTime GetSessionIdleTimeout(const HAPIPSessionDescriptor* session, bool isEnforcingMaxIdleTime) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    const HAPAccessoryServer* server = (const HAPAccessoryServer*) session->server;
+
+    HAPTime idleTimeout;
+    if (IsSessionVerified(session)) {
+        idleTimeout = server->ip.sessionIdleTimeouts.verifiedSession;
+    } else if (!IsSessionPairing(session)) {
+        idleTimeout = server->ip.sessionIdleTimeouts.unverifiedSession;
+    } else {
+        idleTimeout = 0;
+    }
+    if (isEnforcingMaxIdleTime && (!idleTimeout || idleTimeout > kHAPIPSession_MaxIdleTime)) {
+        idleTimeout = kHAPIPSession_MaxIdleTime;
+    }
+    return idleTimeout;
+}
+
 static void schedule_max_idle_time_timer(HAPAccessoryServerRef* server_) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
@@ -389,25 +693,34 @@ static void schedule_max_idle_time_timer(HAPAccessoryServerRef* server_) {
         HAPPlatformTCPStreamManagerCloseListener(HAPNonnull(server->platform.ip.tcpStreamManager));
     }
 
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
+    // The maximum idle time is only enforced when all sessions are in use or when the accessory server is stopping.
+    // Open sessions are only visited while idle sessions may be closed.
+    bool isEnforcingMaxIdleTime = (server->ip.numSessions == server->ip.storage->numSessions) ||
+                                  (server->ip.state == kHAPIPAccessoryServerState_Stopping);
+    bool isClosingIdleSessions = isEnforcingMaxIdleTime || server->ip.sessionIdleTimeouts.unverifiedSession ||
+                                 server->ip.sessionIdleTimeouts.verifiedSession;
+    HAPIPSession* _Nullable nextIPSession =
+            isClosingIdleSessions ? server->ip.sessionLists.openSessions.first : NULL;
+    while (nextIPSession) {
+        HAPIPSession* ipSession = HAPNonnull(nextIPSession);
+        nextIPSession = GetNextSessionOfList(ipSession, kHAPIPSessionListKind_Slot);
         HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
-            continue;
-        }
+        HAPAssert(session->server);
 
-        if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
-            (server->ip.state == kHAPIPAccessoryServerState_Stopping)) {
+        if (IsSessionIdle(session) && (server->ip.state == kHAPIPAccessoryServerState_Stopping)) {
             CloseSession(session);
         } else if (
-                ((session->state == kHAPIPSessionState_Reading) || (session->state == kHAPIPSessionState_Writing)) &&
-                ((server->ip.numSessions == server->ip.storage->numSessions) ||
-                 (server->ip.state == kHAPIPAccessoryServerState_Stopping))) {
+                (session->state == kHAPIPSessionState_Reading) || (session->state == kHAPIPSessionState_Writing) ||
+                (session->state == kHAPIPSessionState_Waiting)) {
+            HAPTime idleTimeout = GetSessionIdleTimeout(session, isEnforcingMaxIdleTime);
+            if (!idleTimeout) {
+                continue;
+            }
             HAPAssert(clock_now_ms >= session->stamp);
             HAPTime dt_ms = clock_now_ms - session->stamp;
-            if (dt_ms < kHAPIPSession_MaxIdleTime) {
-                HAPAssert(kHAPIPSession_MaxIdleTime <= INT64_MAX);
-                int64_t t_ms = (int64_t)(kHAPIPSession_MaxIdleTime - dt_ms);
+            if (dt_ms < idleTimeout) {
+                HAPAssert(idleTimeout - dt_ms <= INT64_MAX);
+                int64_t t_ms = (int64_t)(idleTimeout - dt_ms);
                 if ((timeout_ms == -1) || (t_ms < timeout_ms)) {
                     timeout_ms = t_ms;
                 }
@@ -453,8 +766,10 @@ static void RegisterSession(HAPIPSessionDescriptor* session) {
     HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
     HAPPrecondition(server->ip.numSessions < server->ip.storage->numSessions);
 
+    AppendSessionToList(&server->ip.sessionLists.openSessions, GetIPSession(session));
     server->ip.numSessions++;
-    if (server->ip.numSessions == server->ip.storage->numSessions) {
+    if ((server->ip.numSessions == server->ip.storage->numSessions) ||
+        server->ip.sessionIdleTimeouts.unverifiedSession || server->ip.sessionIdleTimeouts.verifiedSession) {
         schedule_max_idle_time_timer(session->server);
     }
 }
@@ -465,82 +780,515 @@ static void handle_characteristic_unsubscribe_request(
         const HAPService* svc,
         const HAPAccessory* acc);
 
-static void CloseSession(HAPIPSessionDescriptor* session) {
+/**
+ * Adds a raised event of an event notification context to the event queue of a session.
+ *
+ * - Sessions with raised events are linked into the queue of sessions with raised events of the accessory server.
+ *
+ * @param      session              IP session descriptor.
+ * @param      eventNotification    Event notification context without a raised event.
+ */
+static void set_event_notification_flag(HAPIPSessionDescriptor* session, HAPIPEventNotification* eventNotification) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
     HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(eventNotification);
+    HAPPrecondition(!eventNotification->flag);
 
-    HAPAssert(session->state != kHAPIPSessionState_Idle);
+    eventNotification->flag = true;
+    if (!session->numEventNotificationFlags) {
+        AppendSessionToList(&server->ip.sessionLists.eventNotificationSessions, GetIPSession(session));
+    }
+    session->numEventNotificationFlags++;
+}
 
-    HAPError err;
+/**
+ * Removes the raised event of an event notification context from the event queue of a session.
+ *
+ * @param      session              IP session descriptor.
+ * @param      eventNotification    Event notification context with a raised event.
+ */
+static void clear_event_notification_flag(HAPIPSessionDescriptor* session, HAPIPEventNotification* eventNotification) {
+    HAPPrecondition(session);
+    HAPPrecondition(eventNotification);
+    HAPPrecondition(eventNotification->flag);
+
+    eventNotification->flag = false;
+    HAPAssert(session->numEventNotificationFlags > 0);
+    session->numEventNotificationFlags--;
+    if (!session->numEventNotificationFlags) {
+        RemoveSessionFromList(GetIPSession(session), kHAPIPSessionListKind_EventNotifications);
+        session->eventNotificationsAreWaitingForBuffers = false;
+    }
+    if (eventNotification->isDue) {
+        eventNotification->isDue = false;
+        HAPAssert(session->numDueEventNotifications > 0);
+        session->numDueEventNotifications--;
+    }
+}
 
-    HAPLogDebug(&logObject, "session:%p:closing", (const void*) session);
+/**
+ * Updates the values of write contexts after the inbound buffer that they refer to has been moved.
+ *
+ * - The write contexts may be stored at an unaligned location, e.g. when they are saved in the outbound buffer.
+ *
+ * @param      contexts             Write contexts.
+ * @param      numContexts          Number of write contexts.
+ * @param      data                 Previous memory location of the inbound buffer.
+ * @param      numDataBytes         Size of the previous memory location.
+ * @param      newData              New memory location of the inbound buffer.
+ */
+static void move_write_context_values(
+        void* contexts,
+        size_t numContexts,
+        const char* data,
+        size_t numDataBytes,
+        char* newData) {
+    HAPPrecondition(contexts);
+    HAPPrecondition(data);
+    HAPPrecondition(newData);
 
-    while (session->numEventNotifications) {
-        HAPIPEventNotification* eventNotification =
-                (HAPIPEventNotification*) &session->eventNotifications[session->numEventNotifications - 1];
-        const HAPCharacteristic* characteristic;
-        const HAPService* service;
-        const HAPAccessory* accessory;
-        get_db_ctx(
-                session->server, eventNotification->aid, eventNotification->iid, &characteristic, &service, &accessory);
-        if (eventNotification->flag) {
-            HAPAssert(session->numEventNotificationFlags);
-            session->numEventNotificationFlags--;
+    for (size_t i = 0; i < numContexts; i++) {
+        HAPIPWriteContextRef contextRef;
+        void* bytes = &((HAPIPWriteContextRef*) contexts)[i];
+        HAPRawBufferCopyBytes(&contextRef, bytes, sizeof contextRef);
+        HAPIPWriteContext* context = (HAPIPWriteContext*) &contextRef;
+        char** values[] = { &context->authorizationData.bytes, NULL };
+        if (context->type == kHAPIPWriteValueType_String) {
+            values[1] = &context->value.stringValue.bytes;
         }
-        session->numEventNotifications--;
-        handle_characteristic_unsubscribe_request(session, characteristic, service, accessory);
-    }
-    if (session->securitySession.isOpen) {
-        HAPLogDebug(&logObject, "session:%p:closing security context", (const void*) session);
-        switch (session->securitySession.type) {
-            case kHAPIPSecuritySessionType_HAP: {
-                HAPLogDebug(&logObject, "Closing HAP session.");
-                HAPSessionRelease(HAPNonnull(session->server), &session->securitySession._.hap);
-                HAPRawBufferZero(&session->securitySession, sizeof session->securitySession);
-            } break;
-            case kHAPIPSecuritySessionType_MFiSAP: {
-                HAPLogDebug(&logObject, "Closing MFi SAP session.");
-                HAPRawBufferZero(&session->securitySession, sizeof session->securitySession);
-            } break;
+        for (size_t j = 0; j < HAPArrayCount(values); j++) {
+            if (values[j] && *values[j] && *values[j] >= data && *values[j] <= &data[numDataBytes]) {
+                *values[j] = &newData[*values[j] - data];
+            }
         }
-        HAPAssert(!session->securitySession.type);
-        HAPAssert(!session->securitySession.isSecured);
-        HAPAssert(!session->securitySession.isOpen);
-    }
-    if (session->tcpStreamIsOpen) {
-        HAPLogDebug(&logObject, "session:%p:closing TCP stream", (const void*) session);
-        HAPPlatformTCPStreamClose(HAPNonnull(server->platform.ip.tcpStreamManager), session->tcpStream);
-        session->tcpStreamIsOpen = false;
+        HAPRawBufferCopyBytes(bytes, &contextRef, sizeof contextRef);
     }
-    session->state = kHAPIPSessionState_Idle;
-    if (!server->ip.garbageCollectionTimer) {
-        err = HAPPlatformTimerRegister(
-                &server->ip.garbageCollectionTimer, 0, handle_garbage_collection_timer, session->server);
-        if (err) {
-            HAPLog(&logObject, "Not enough resources to schedule garbage collection!");
-            HAPFatalError();
+}
+
+/**
+ * Moves the data of an inbound buffer to another memory location.
+ *
+ * - Pointers of the HTTP reader into the inbound buffer are updated.
+ *   So are the values of the write contexts of a pending PUT /characteristics request.
+ *
+ * @param      session              IP session descriptor.
+ * @param      bytes                Memory location.
+ * @param      numBytes             Size of memory location.
+ */
+static void move_inbound_buffer(HAPIPSessionDescriptor* session, void* bytes, size_t numBytes) {
+    HAPPrecondition(session);
+    HAPPrecondition(bytes);
+    HAPPrecondition(session->inboundBuffer.position <= numBytes);
+    HAPPrecondition(session->inboundBuffer.limit <= numBytes);
+
+    char* data = session->inboundBuffer.data;
+    char* newData = bytes;
+    HAPRawBufferCopyBytes(
+            newData, data, HAPMax(session->inboundBuffer.position, session->inboundBuffer.limit));
+    char** tokens[] = { &session->httpMethod.bytes,
+                        &session->httpURI.bytes,
+                        &session->httpHeaderFieldName.bytes,
+                        &session->httpHeaderFieldValue.bytes,
+                        &session->httpReader.result_token };
+    for (size_t i = 0; i < HAPArrayCount(tokens); i++) {
+        if (*tokens[i] && *tokens[i] >= data && *tokens[i] <= &data[session->inboundBuffer.capacity]) {
+            *tokens[i] = &newData[*tokens[i] - data];
         }
-        HAPAssert(server->ip.garbageCollectionTimer);
     }
 
-    HAPLogDebug(&logObject, "session:%p:closed", (const void*) session);
+    // Values of the write contexts of a pending PUT /characteristics request refer to the request.
+    if (session->pendingRequest.areWriteContextsSaved) {
+        move_write_context_values(
+                &session->outboundBuffer.data[session->outboundBuffer.position],
+                session->pendingRequest.numWriteContexts,
+                data,
+                session->inboundBuffer.capacity,
+                newData);
+    }
+
+    session->inboundBuffer.data = newData;
+    session->inboundBuffer.capacity = numBytes;
 }
 
-static void OpenSecuritySession(HAPIPSessionDescriptor* session) {
+/**
+ * Returns the number of bytes of the read or write contexts of a pending request that are saved in the outbound buffer.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return Number of saved bytes, starting at the position of the outbound buffer.
+ */
+HAP_RESULT_USE_CHECK
+static size_t get_num_saved_pending_request_bytes(const HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
-    HAPPrecondition(session->server);
-    HAPPrecondition(!session->securitySession.isOpen);
-    HAPPrecondition(!session->securitySession.isSecured);
 
-    HAPLogDebug(&logObject, "Opening HAP session.");
-    session->securitySession.type = kHAPIPSecuritySessionType_HAP;
-    HAPSessionCreate(HAPNonnull(session->server), &session->securitySession._.hap, kHAPTransportType_IP);
-
-    session->securitySession.isOpen = true;
+    if (session->pendingRequest.numReadContexts) {
+        return session->pendingRequest.numReadContexts * sizeof(HAPIPReadContextRef) +
+               session->pendingRequest.numReadValueBytes;
+    }
+    if (session->pendingRequest.areWriteContextsSaved) {
+        return session->pendingRequest.numWriteContexts * sizeof(HAPIPWriteContextRef);
+    }
+    return 0;
 }
 
-static void write_msg(HAPIPByteBuffer* b, const char* msg) {
+/**
+ * Borrows pooled session buffers and uses them as inbound and outbound buffer.
+ *
+ * - The received data is moved into the pooled inbound buffer. The outbound buffer must be empty,
+ *   except for read or write contexts of a pending request that are saved in it. Those are moved as well.
+ *
+ * - The limit of the inbound buffer is kept. The caller must update it if data is being received.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If the session uses pooled session buffers or no session buffer pool is used.
+ * @return false                    If all pooled session buffers are borrowed.
+ */
+HAP_RESULT_USE_CHECK
+static bool borrow_session_buffers(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
+
+    if (!storage->numPooledSessionBuffers || session->borrowedBuffers) {
+        return true;
+    }
+    if (!server->ip.sessionBufferPool.firstFreeBuffers) {
+        server->ip.sessionBufferPool.hasWaitingSessions = true;
+        return false;
+    }
+
+    HAPAssert(server->ip.sessionBufferPool.firstFreeBuffers <= storage->numPooledSessionBuffers);
+    HAPIPSessionBuffers* buffers =
+            &HAPNonnull(storage->pooledSessionBuffers)[server->ip.sessionBufferPool.firstFreeBuffers - 1];
+    HAPRawBufferCopyBytes(
+            &server->ip.sessionBufferPool.firstFreeBuffers,
+            buffers->inboundBuffer.bytes,
+            sizeof server->ip.sessionBufferPool.firstFreeBuffers);
+    session->borrowedBuffers = buffers;
+
+    move_inbound_buffer(session, buffers->inboundBuffer.bytes, buffers->inboundBuffer.numBytes);
+    HAPAssert(session->outboundBuffer.position == 0);
+    HAPAssert(session->outboundBuffer.limit == session->outboundBuffer.capacity);
+    size_t numSavedBytes = get_num_saved_pending_request_bytes(session);
+    HAPAssert(numSavedBytes <= buffers->outboundBuffer.numBytes);
+    HAPRawBufferCopyBytes(buffers->outboundBuffer.bytes, session->outboundBuffer.data, numSavedBytes);
+    session->outboundBuffer.data = buffers->outboundBuffer.bytes;
+    session->outboundBuffer.capacity = buffers->outboundBuffer.numBytes;
+    session->outboundBuffer.limit = buffers->outboundBuffer.numBytes;
+
+    HAPIPSessionBufferPoolStatistics* statistics = &server->ip.sessionBufferPool.statistics;
+    statistics->numBorrowedBuffers++;
+    statistics->maxBorrowedBuffers = HAPMax(statistics->maxBorrowedBuffers, statistics->numBorrowedBuffers);
+    statistics->numBorrows++;
+    return true;
+}
+
+/**
+ * Links the pooled session buffers of a session back into the list of free pooled session buffers.
+ *
+ * - The session must no longer refer to the pooled session buffers.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void release_borrowed_buffers(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
+    HAPPrecondition(session->borrowedBuffers);
+
+    HAPIPSessionBuffers* buffers = HAPNonnull(session->borrowedBuffers);
+    HAPAssert(buffers >= storage->pooledSessionBuffers);
+    size_t index = (size_t)(buffers - HAPNonnull(storage->pooledSessionBuffers));
+    HAPAssert(index < storage->numPooledSessionBuffers);
+    HAPRawBufferCopyBytes(
+            buffers->inboundBuffer.bytes,
+            &server->ip.sessionBufferPool.firstFreeBuffers,
+            sizeof server->ip.sessionBufferPool.firstFreeBuffers);
+    server->ip.sessionBufferPool.firstFreeBuffers = index + 1;
+    session->borrowedBuffers = NULL;
+
+    HAPAssert(server->ip.sessionBufferPool.statistics.numBorrowedBuffers > 0);
+    server->ip.sessionBufferPool.statistics.numBorrowedBuffers--;
+    if (server->ip.sessionBufferPool.hasWaitingSessions) {
+        server->ip.sessionBufferPool.hasWaitingSessions = false;
+        schedule_pending_requests(session->server);
+    }
+}
+
+/**
+ * Returns pooled session buffers and uses the resident buffers of the session again.
+ *
+ * - The data of the inbound and outbound buffers is discarded.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void return_session_buffers(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->borrowedBuffers);
+
+    HAPIPSession* ipSession = GetIPSession(session);
+    session->inboundBuffer.data = ipSession->inboundBuffer.bytes;
+    session->inboundBuffer.capacity = ipSession->inboundBuffer.numBytes;
+    session->inboundBuffer.limit = ipSession->inboundBuffer.numBytes;
+    session->inboundBuffer.position = 0;
+    session->inboundBufferMark = 0;
+    session->outboundBuffer.data = ipSession->outboundBuffer.bytes;
+    session->outboundBuffer.capacity = ipSession->outboundBuffer.numBytes;
+    session->outboundBuffer.limit = ipSession->outboundBuffer.numBytes;
+    session->outboundBuffer.position = 0;
+    session->outboundBufferMark = 0;
+    release_borrowed_buffers(session);
+}
+
+/**
+ * Returns the pooled session buffers of a session whose request waits for asynchronous handlers.
+ *
+ * - The request in the inbound buffer and the read or write contexts that are saved in the outbound buffer are moved
+ *   into the resident buffers of the session. Pooled session buffers are borrowed again once the request is resumed.
+ *
+ * - If the pending request does not fit into the resident buffers, the pooled session buffers are kept until
+ *   the request is resumed. Handlers must complete within kHAPIPAccessoryServer_MaxAsynchronousRequestTime.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void return_session_buffers_while_waiting(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->state == kHAPIPSessionState_Waiting);
+    HAPPrecondition(!session->streamingWrite.isActive);
+
+    if (!session->borrowedBuffers) {
+        return;
+    }
+
+    HAPIPSession* ipSession = GetIPSession(session);
+    size_t numSavedBytes = get_num_saved_pending_request_bytes(session);
+    if (session->outboundBuffer.position ||
+        HAPMax(session->inboundBuffer.position, session->inboundBuffer.limit) > ipSession->inboundBuffer.numBytes ||
+        numSavedBytes > ipSession->outboundBuffer.numBytes) {
+        HAPLogDebug(
+                &logObject,
+                "session:%p:pending request does not fit into resident buffers. Keeping pooled session buffers.",
+                (const void*) session);
+        return;
+    }
+
+    move_inbound_buffer(session, ipSession->inboundBuffer.bytes, ipSession->inboundBuffer.numBytes);
+    HAPRawBufferCopyBytes(ipSession->outboundBuffer.bytes, session->outboundBuffer.data, numSavedBytes);
+    session->outboundBuffer.data = ipSession->outboundBuffer.bytes;
+    session->outboundBuffer.capacity = ipSession->outboundBuffer.numBytes;
+    session->outboundBuffer.limit = ipSession->outboundBuffer.numBytes;
+    release_borrowed_buffers(session);
+}
+
+static void schedule_asynchronous_request_timer(HAPAccessoryServerRef* server_);
+
+/**
+ * Moves a session into state kHAPIPSessionState_Waiting.
+ *
+ * - The session is linked into the queue of waiting sessions that is visited by the pending request timer.
+ *
+ * - If the session waits for asynchronous read or write handlers, they must complete within
+ *   kHAPIPAccessoryServer_MaxAsynchronousRequestTime. The session is appended to the list of sessions with
+ *   asynchronous requests, which is therefore ordered by expiration time.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void enter_waiting_state(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->state != kHAPIPSessionState_Idle);
+    HAPPrecondition(session->state != kHAPIPSessionState_Waiting);
+
+    session->state = kHAPIPSessionState_Waiting;
+    AppendSessionToList(&server->ip.sessionLists.waitingSessions, GetIPSession(session));
+    if (session->pendingRequest.numPendingReads || session->pendingRequest.isWritePending) {
+        session->pendingRequest.expirationTime =
+                HAPPlatformClockGetCurrent() + kHAPIPAccessoryServer_MaxAsynchronousRequestTime;
+        HAPIPSession* _Nullable lastIPSession = server->ip.sessionLists.asynchronousRequestSessions.last;
+        if (lastIPSession) {
+            HAPIPSessionDescriptor* lastSession = (HAPIPSessionDescriptor*) &HAPNonnull(lastIPSession)->descriptor;
+            HAPAssert(lastSession->pendingRequest.expirationTime <= session->pendingRequest.expirationTime);
+        }
+        AppendSessionToList(&server->ip.sessionLists.asynchronousRequestSessions, GetIPSession(session));
+        schedule_asynchronous_request_timer(session->server);
+    }
+}
+
+/**
+ * Cancels the pending reads and writes of a session whose request waits for asynchronous handlers.
+ *
+ * - Pending reads and writes are reported as busy. The application is informed about each cancelled completion token,
+ *   and later completions with those tokens are ignored.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void cancel_asynchronous_requests(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->state == kHAPIPSessionState_Waiting);
+
+    RemoveSessionFromList(GetIPSession(session), kHAPIPSessionListKind_AsynchronousRequests);
+    if (session->pendingRequest.numPendingReads) {
+        // Saved read contexts are not necessarily aligned.
+        char* bytes = &session->outboundBuffer.data[session->outboundBuffer.position];
+        for (size_t i = 0; i < session->pendingRequest.numReadContexts; i++) {
+            HAPIPReadContext readContext;
+            HAPRawBufferCopyBytes(&readContext, &bytes[i * sizeof(HAPIPReadContextRef)], sizeof readContext);
+            if (readContext.status == kHAPIPAccessoryServerStatusCode_InProgress) {
+                readContext.status = kHAPIPAccessoryServerStatusCode_ResourceIsBusy;
+                HAPRawBufferCopyBytes(&bytes[i * sizeof(HAPIPReadContextRef)], &readContext, sizeof readContext);
+                session->pendingRequest.numPendingReads--;
+                HAPLogInfo(
+                        &logObject,
+                        "session:%p:cancelling read (completion token %lu)",
+                        (const void*) session,
+                        (unsigned long) readContext.completionToken);
+                if (server->callbacks.handleCancelledRequest) {
+                    server->callbacks.handleCancelledRequest(
+                            session->server, readContext.completionToken, server->context);
+                }
+            }
+        }
+        HAPAssert(!session->pendingRequest.numPendingReads);
+    }
+    if (session->pendingRequest.isWritePending) {
+        session->pendingRequest.writeError = kHAPError_Busy;
+        session->pendingRequest.isWritePending = false;
+        session->pendingRequest.isWriteCompleted = true;
+        HAPLogInfo(
+                &logObject,
+                "session:%p:cancelling write (completion token %lu)",
+                (const void*) session,
+                (unsigned long) session->pendingRequest.writeCompletionToken);
+        if (server->callbacks.handleCancelledRequest) {
+            server->callbacks.handleCancelledRequest(
+                    session->server, session->pendingRequest.writeCompletionToken, server->context);
+        }
+    }
+}
+
+/**
+ * Suspends a request until pooled session buffers are returned by another session.
+ *
+ * - The request is kept in the inbound buffer and is handled again once the session is resumed.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void wait_for_session_buffers(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->state == kHAPIPSessionState_Reading);
+    HAPPrecondition(!session->borrowedBuffers);
+
+    HAPLogDebug(&logObject, "session:%p:waiting for pooled session buffers", (const void*) session);
+    session->pendingRequest.isWaitingForBuffers = true;
+    enter_waiting_state(session);
+    server->ip.sessionBufferPool.statistics.numWaits++;
+}
+
+static void CloseSession(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+
+    HAPAssert(session->state != kHAPIPSessionState_Idle);
+
+    HAPError err;
+
+    HAPLogDebug(&logObject, "session:%p:closing", (const void*) session);
+
+    while (session->numEventNotifications) {
+        HAPIPEventNotification* eventNotification =
+                (HAPIPEventNotification*) &session->eventNotifications[session->numEventNotifications - 1];
+        const HAPCharacteristic* characteristic;
+        const HAPService* service;
+        const HAPAccessory* accessory;
+        get_db_ctx(
+                session->server,
+                eventNotification->aid,
+                eventNotification->iid,
+                &characteristic,
+                &service,
+                &accessory,
+                /* chrTypeID: */ NULL);
+        if (eventNotification->flag) {
+            clear_event_notification_flag(session, eventNotification);
+        }
+        session->numEventNotifications--;
+        handle_characteristic_unsubscribe_request(session, characteristic, service, accessory);
+    }
+    if (session->securitySession.isOpen) {
+        HAPLogDebug(&logObject, "session:%p:closing security context", (const void*) session);
+        switch (session->securitySession.type) {
+            case kHAPIPSecuritySessionType_HAP: {
+                HAPLogDebug(&logObject, "Closing HAP session.");
+                HAPSessionRelease(HAPNonnull(session->server), &session->securitySession._.hap);
+                HAPRawBufferZero(&session->securitySession, sizeof session->securitySession);
+            } break;
+            case kHAPIPSecuritySessionType_MFiSAP: {
+                HAPLogDebug(&logObject, "Closing MFi SAP session.");
+                HAPRawBufferZero(&session->securitySession, sizeof session->securitySession);
+            } break;
+        }
+        HAPAssert(!session->securitySession.type);
+        HAPAssert(!session->securitySession.isSecured);
+        HAPAssert(!session->securitySession.isOpen);
+    }
+    if (session->tcpStreamIsOpen) {
+        HAPLogDebug(&logObject, "session:%p:closing TCP stream", (const void*) session);
+        HAPPlatformTCPStreamClose(HAPNonnull(server->platform.ip.tcpStreamManager), session->tcpStream);
+        session->tcpStreamIsOpen = false;
+    }
+    if (session->streamingWrite.isActive) {
+        end_streaming_write(session);
+    }
+    if (session->pendingRequest.numPendingReads || session->pendingRequest.isWritePending) {
+        cancel_asynchronous_requests(session);
+    }
+    HAPRawBufferZero(&session->pendingRequest, sizeof session->pendingRequest);
+    if (session->borrowedBuffers) {
+        return_session_buffers(session);
+    }
+    session->eventNotificationsAreWaitingForBuffers = false;
+    session->state = kHAPIPSessionState_Idle;
+    RemoveSessionFromList(GetIPSession(session), kHAPIPSessionListKind_Waiting);
+    HAPAssert(!session->listLinks[kHAPIPSessionListKind_EventNotifications].list);
+    RemoveSessionFromList(GetIPSession(session), kHAPIPSessionListKind_Slot);
+    AppendSessionToList(&server->ip.sessionLists.closedSessions, GetIPSession(session));
+    if (!server->ip.garbageCollectionTimer) {
+        err = HAPPlatformTimerRegister(
+                &server->ip.garbageCollectionTimer, 0, handle_garbage_collection_timer, session->server);
+        if (err) {
+            HAPLog(&logObject, "Not enough resources to schedule garbage collection!");
+            HAPFatalError();
+        }
+        HAPAssert(server->ip.garbageCollectionTimer);
+    }
+
+    HAPLogDebug(&logObject, "session:%p:closed", (const void*) session);
+}
+
+static void OpenSecuritySession(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(!session->securitySession.isOpen);
+    HAPPrecondition(!session->securitySession.isSecured);
+
+    HAPLogDebug(&logObject, "Opening HAP session.");
+    session->securitySession.type = kHAPIPSecuritySessionType_HAP;
+    HAPSessionCreate(HAPNonnull(session->server), &session->securitySession._.hap, kHAPTransportType_IP);
+
+    session->securitySession.isOpen = true;
+}
+
+static void write_msg(HAPIPByteBuffer* b, const char* msg) {
     HAPError err;
 
     err = HAPIPByteBufferAppendStringWithFormat(b, "%s", msg);
@@ -703,15 +1451,22 @@ static void schedule_event_notifications(HAPAccessoryServerRef* server_) {
 
     HAPError err;
 
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
-            continue;
+    // Each session with raised events is visited once. Sessions are queued again before their events are written,
+    // and leave the queue once all of their raised events have been sent.
+    HAPIPSessionList eventNotificationSessions;
+    MoveSessionsOfList(&server->ip.sessionLists.eventNotificationSessions, &eventNotificationSessions);
+    for (;;) {
+        HAPIPSession* _Nullable ipSession = PopFirstSessionOfList(&eventNotificationSessions);
+        if (!ipSession) {
+            break;
         }
+        AppendSessionToList(&server->ip.sessionLists.eventNotificationSessions, HAPNonnull(ipSession));
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        HAPAssert(session->server);
+        HAPAssert(session->numEventNotificationFlags > 0);
 
         if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
-            (session->numEventNotificationFlags > 0)) {
+            !session->streamingWrite.isActive && !session->eventNotificationsAreWaitingForBuffers) {
             write_event_notifications(session);
         }
     }
@@ -719,21 +1474,22 @@ static void schedule_event_notifications(HAPAccessoryServerRef* server_) {
     HAPTime clock_now_ms = HAPPlatformClockGetCurrent();
     int64_t timeout_ms = -1;
 
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
-        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
-            continue;
-        }
+    for (HAPIPSession* _Nullable ipSession = server->ip.sessionLists.eventNotificationSessions.first; ipSession;
+         ipSession = GetNextSessionOfList(HAPNonnull(ipSession), kHAPIPSessionListKind_EventNotifications)) {
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        HAPAssert(session->server);
 
         if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
-            (session->numEventNotificationFlags > 0)) {
+            !session->streamingWrite.isActive && (session->numEventNotificationFlags > 0) &&
+            !session->eventNotificationsAreWaitingForBuffers) {
             HAPAssert(clock_now_ms >= session->eventNotificationStamp);
             HAPTime dt_ms = clock_now_ms - session->eventNotificationStamp;
             HAP_DIAGNOSTIC_PUSH
             HAP_DIAGNOSTIC_IGNORED_ARMCC(186)
             HAP_DIAGNOSTIC_IGNORED_GCC("-Wtype-limits")
-            if (dt_ms < kHAPIPAccessoryServer_MaxEventNotificationDelay) {
+            if (session->numDueEventNotifications > 0) {
+                timeout_ms = 0;
+            } else if (dt_ms < kHAPIPAccessoryServer_MaxEventNotificationDelay) {
                 HAPAssert(kHAPIPAccessoryServer_MaxEventNotificationDelay <= INT64_MAX);
                 int64_t t_ms = (int64_t)(kHAPIPAccessoryServer_MaxEventNotificationDelay - dt_ms);
                 if ((timeout_ms == -1) || (t_ms < timeout_ms)) {
@@ -767,70 +1523,228 @@ static void schedule_event_notifications(HAPAccessoryServerRef* server_) {
     }
 }
 
-static void handle_characteristic_subscribe_request(
-        HAPIPSessionDescriptor* session,
-        const HAPCharacteristic* chr,
-        const HAPService* svc,
-        const HAPAccessory* acc) {
+static void handle_io_progression(HAPIPSessionDescriptor* session);
+
+/**
+ * Resumes a request whose asynchronous read and write handlers have been completed.
+ *
+ * - The request is still stored in the inbound buffer and is handled again. The values of completed reads have been
+ *   saved along with the read contexts, and the remaining write requests are handled after the completed write.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void resume_pending_request(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
-    HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
-    HAPPrecondition(session->securitySession.isOpen);
-    HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
-    HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
-    HAPPrecondition(chr);
-    HAPPrecondition(svc);
-    HAPPrecondition(acc);
+    HAPPrecondition(session->state == kHAPIPSessionState_Waiting);
 
-    HAPAccessoryServerHandleSubscribe(HAPNonnull(session->server), &session->securitySession._.hap, chr, svc, acc);
+    HAPLogDebug(&logObject, "session:%p:resuming request", (const void*) session);
+    session->pendingRequest.isWaitingForBuffers = false;
+    session->state = kHAPIPSessionState_Reading;
+    RemoveSessionFromList(GetIPSession(session), kHAPIPSessionListKind_Waiting);
+    session->stamp = HAPPlatformClockGetCurrent();
+    handle_input(session);
+    handle_io_progression(session);
 }
 
-static void handle_characteristic_unsubscribe_request(
-        HAPIPSessionDescriptor* session,
-        const HAPCharacteristic* chr,
-        const HAPService* svc,
-        const HAPAccessory* acc) {
-    HAPPrecondition(session);
-    HAPPrecondition(session->server);
-    HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
-    HAPPrecondition(session->securitySession.isOpen);
-    HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
-    HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
-    HAPPrecondition(chr);
-    HAPPrecondition(svc);
-    HAPPrecondition(acc);
+static void handle_pending_request_timer(HAPPlatformTimerRef timer, void* _Nullable context) {
+    HAPPrecondition(context);
+    HAPAccessoryServerRef* server_ = context;
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(timer == server->ip.pendingRequestTimer);
+    server->ip.pendingRequestTimer = 0;
+
+    bool hasWaitingEventNotifications = false;
+    for (HAPIPSession* _Nullable ipSession = server->ip.sessionLists.eventNotificationSessions.first; ipSession;
+         ipSession = GetNextSessionOfList(HAPNonnull(ipSession), kHAPIPSessionListKind_EventNotifications)) {
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        if (session->eventNotificationsAreWaitingForBuffers) {
+            session->eventNotificationsAreWaitingForBuffers = false;
+            hasWaitingEventNotifications = true;
+        }
+    }
 
-    HAPAccessoryServerHandleUnsubscribe(HAPNonnull(session->server), &session->securitySession._.hap, chr, svc, acc);
+    // Each waiting session is visited once. Sessions that cannot be resumed yet are queued again.
+    HAPIPSessionList waitingSessions;
+    MoveSessionsOfList(&server->ip.sessionLists.waitingSessions, &waitingSessions);
+    for (;;) {
+        HAPIPSession* _Nullable ipSession = PopFirstSessionOfList(&waitingSessions);
+        if (!ipSession) {
+            break;
+        }
+        AppendSessionToList(&server->ip.sessionLists.waitingSessions, HAPNonnull(ipSession));
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        HAPAssert(session->server);
+        HAPAssert(session->state == kHAPIPSessionState_Waiting);
+        if (session->pendingRequest.numPendingReads || session->pendingRequest.isWritePending) {
+            continue;
+        }
+        if (session->pendingRequest.isWaitingForBuffers && !server->ip.sessionBufferPool.firstFreeBuffers) {
+            server->ip.sessionBufferPool.hasWaitingSessions = true;
+            continue;
+        }
+        resume_pending_request(session);
+    }
+    if (hasWaitingEventNotifications) {
+        schedule_event_notifications(server_);
+    }
 }
 
-static void handle_characteristic_read_request(
-        HAPIPSessionDescriptor* session,
-        const HAPCharacteristic* chr,
-        const HAPService* svc,
-        const HAPAccessory* acc,
-        HAPIPReadContextRef* ctx,
-        HAPIPByteBuffer* data_buffer);
-
 /**
- * Converts a characteristic write request error to the corresponding HAP status code.
+ * Schedules resumption of requests that are no longer waiting for asynchronous handlers or pooled session buffers.
  *
- * @param      error                Write request error.
- *
- * @return HAP write request status code.
- *
- * @see HomeKit Accessory Protocol Specification R14
- *      Table 6-11 HAP Status Codes
+ * @param      server_              Accessory server.
  */
-static int32_t ConvertCharacteristicWriteErrorToStatusCode(HAPError error) {
-    switch (error) {
-        case kHAPError_None: {
-            return kHAPIPAccessoryServerStatusCode_Success;
-        }
-        case kHAPError_Unknown: {
-            return kHAPIPAccessoryServerStatusCode_UnableToPerformOperation;
-        }
-        case kHAPError_InvalidState: {
-            return kHAPIPAccessoryServerStatusCode_UnableToPerformOperation;
+static void schedule_pending_requests(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    if (!server->ip.pendingRequestTimer) {
+        err = HAPPlatformTimerRegister(&server->ip.pendingRequestTimer, 0, handle_pending_request_timer, server_);
+        if (err) {
+            HAPLog(&logObject, "Not enough resources to schedule pending request timer!");
+            HAPFatalError();
+        }
+        HAPAssert(server->ip.pendingRequestTimer);
+    }
+}
+
+/**
+ * Reports the pending reads and writes of a waiting session as busy and schedules resumption of the request.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void fail_asynchronous_request(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(session->state == kHAPIPSessionState_Waiting);
+
+    HAPLog(&logObject, "session:%p:asynchronous handlers did not complete in time", (const void*) session);
+    cancel_asynchronous_requests(session);
+    schedule_pending_requests(session->server);
+}
+
+static void handle_asynchronous_request_timer(HAPPlatformTimerRef timer, void* _Nullable context) {
+    HAPPrecondition(context);
+    HAPAccessoryServerRef* server_ = context;
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(timer == server->ip.asynchronousRequestTimer);
+    server->ip.asynchronousRequestTimer = 0;
+
+    // Sessions with asynchronous requests are ordered by expiration time.
+    HAPTime now = HAPPlatformClockGetCurrent();
+    for (;;) {
+        HAPIPSession* _Nullable ipSession = server->ip.sessionLists.asynchronousRequestSessions.first;
+        if (!ipSession) {
+            break;
+        }
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        if (session->pendingRequest.expirationTime > now) {
+            break;
+        }
+        fail_asynchronous_request(session);
+    }
+
+    schedule_asynchronous_request_timer(server_);
+}
+
+/**
+ * Schedules the asynchronous request timer for the first session with asynchronous requests that expires.
+ *
+ * - If the timer is already scheduled, it is kept. When it fires for a session that has been completed in the
+ *   meantime, it is scheduled again for the next session that expires.
+ *
+ * @param      server_              Accessory server.
+ */
+static void schedule_asynchronous_request_timer(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPError err;
+
+    HAPIPSession* _Nullable ipSession = server->ip.sessionLists.asynchronousRequestSessions.first;
+    if (server->ip.asynchronousRequestTimer || !ipSession) {
+        return;
+    }
+    HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+    err = HAPPlatformTimerRegister(
+            &server->ip.asynchronousRequestTimer,
+            session->pendingRequest.expirationTime,
+            handle_asynchronous_request_timer,
+            server_);
+    if (err) {
+        HAPLog(&logObject, "Not enough resources to schedule asynchronous request timer!");
+        HAPFatalError();
+    }
+    HAPAssert(server->ip.asynchronousRequestTimer);
+}
+
+static void handle_characteristic_subscribe_request(
+        HAPIPSessionDescriptor* session,
+        const HAPCharacteristic* chr,
+        const HAPService* svc,
+        const HAPAccessory* acc) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
+    HAPPrecondition(session->securitySession.isOpen);
+    HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
+    HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
+    HAPPrecondition(chr);
+    HAPPrecondition(svc);
+    HAPPrecondition(acc);
+
+    HAPAccessoryServerHandleSubscribe(HAPNonnull(session->server), &session->securitySession._.hap, chr, svc, acc);
+}
+
+static void handle_characteristic_unsubscribe_request(
+        HAPIPSessionDescriptor* session,
+        const HAPCharacteristic* chr,
+        const HAPService* svc,
+        const HAPAccessory* acc) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
+    HAPPrecondition(session->securitySession.isOpen);
+    HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
+    HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
+    HAPPrecondition(chr);
+    HAPPrecondition(svc);
+    HAPPrecondition(acc);
+
+    HAPAccessoryServerHandleUnsubscribe(HAPNonnull(session->server), &session->securitySession._.hap, chr, svc, acc);
+}
+
+static void handle_characteristic_read_request(
+        HAPIPSessionDescriptor* session,
+        const HAPCharacteristic* chr,
+        const HAPService* svc,
+        const HAPAccessory* acc,
+        HAPIPReadContextRef* ctx,
+        HAPIPByteBuffer* data_buffer);
+
+/**
+ * Converts a characteristic write request error to the corresponding HAP status code.
+ *
+ * @param      error                Write request error.
+ *
+ * @return HAP write request status code.
+ *
+ * @see HomeKit Accessory Protocol Specification R14
+ *      Table 6-11 HAP Status Codes
+ */
+static int32_t ConvertCharacteristicWriteErrorToStatusCode(HAPError error) {
+    switch (error) {
+        case kHAPError_None: {
+            return kHAPIPAccessoryServerStatusCode_Success;
+        }
+        case kHAPError_Unknown: {
+            return kHAPIPAccessoryServerStatusCode_UnableToPerformOperation;
+        }
+        case kHAPError_InvalidState: {
+            return kHAPIPAccessoryServerStatusCode_UnableToPerformOperation;
         }
         case kHAPError_InvalidData: {
             return kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
@@ -844,10 +1758,120 @@ static int32_t ConvertCharacteristicWriteErrorToStatusCode(HAPError error) {
         case kHAPError_Busy: {
             return kHAPIPAccessoryServerStatusCode_ResourceIsBusy;
         }
+        case kHAPError_InProgress: {
+            return kHAPIPAccessoryServerStatusCode_InProgress;
+        }
     }
     HAPFatalError();
 }
 
+/**
+ * Assigns a completion token to a read or write request whose handler is about to be called.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return Completion token, if the handler may complete asynchronously. kHAPCompletionToken_None otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPCompletionToken assign_completion_token(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+
+    if (!session->handlersMayCompleteAsynchronously) {
+        return kHAPCompletionToken_None;
+    }
+    server->ip.lastCompletionToken++;
+    if (server->ip.lastCompletionToken == kHAPCompletionToken_None) {
+        server->ip.lastCompletionToken++;
+    }
+    return server->ip.lastCompletionToken;
+}
+
+/**
+ * Handles the write response of a characteristic write request that has been handled successfully.
+ *
+ * - If the characteristic supports write responses, its value is read. The value is included in the response
+ *   if the controller requested it. Otherwise, it is discarded.
+ *
+ * @param      session              IP session descriptor.
+ * @param      characteristic       The characteristic that has been written.
+ * @param      service              The service that contains the characteristic.
+ * @param      accessory            The accessory that provides the service.
+ * @param      context              Request context.
+ * @param      dataBuffer           Buffer for values of type data, string or TLV8.
+ */
+static void handle_characteristic_write_response(
+        HAPIPSessionDescriptor* session,
+        const HAPCharacteristic* characteristic,
+        const HAPService* service,
+        const HAPAccessory* accessory,
+        HAPIPWriteContextRef* context,
+        HAPIPByteBuffer* dataBuffer) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(characteristic);
+    HAPPrecondition(service);
+    HAPPrecondition(accessory);
+    HAPPrecondition(context);
+    HAPIPWriteContext* writeContext = (HAPIPWriteContext*) context;
+    HAPPrecondition(writeContext->status == kHAPIPAccessoryServerStatusCode_Success);
+    HAPPrecondition(dataBuffer);
+
+    const HAPBaseCharacteristic* baseCharacteristic = characteristic;
+
+    if (baseCharacteristic->properties.ip.supportsWriteResponse) {
+        HAPIPByteBuffer dataBufferSnapshot;
+        HAPRawBufferCopyBytes(&dataBufferSnapshot, dataBuffer, sizeof dataBufferSnapshot);
+        HAPIPReadContext readContext;
+        HAPRawBufferZero(&readContext, sizeof readContext);
+        readContext.aid = writeContext->aid;
+        readContext.iid = writeContext->iid;
+        // The value of a write response is always read immediately.
+        bool handlersMayCompleteAsynchronously = session->handlersMayCompleteAsynchronously;
+        session->handlersMayCompleteAsynchronously = false;
+        handle_characteristic_read_request(
+                session,
+                characteristic,
+                service,
+                accessory,
+                (HAPIPReadContextRef*) &readContext,
+                dataBuffer);
+        session->handlersMayCompleteAsynchronously = handlersMayCompleteAsynchronously;
+        writeContext->status = readContext.status;
+        if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
+            if (writeContext->response) {
+                switch (baseCharacteristic->format) {
+                    case kHAPCharacteristicFormat_Bool:
+                    case kHAPCharacteristicFormat_UInt8:
+                    case kHAPCharacteristicFormat_UInt16:
+                    case kHAPCharacteristicFormat_UInt32:
+                    case kHAPCharacteristicFormat_UInt64: {
+                        writeContext->value.unsignedIntValue = readContext.value.unsignedIntValue;
+                    } break;
+                    case kHAPCharacteristicFormat_Int: {
+                        writeContext->value.intValue = readContext.value.intValue;
+                    } break;
+                    case kHAPCharacteristicFormat_Float: {
+                        writeContext->value.floatValue = readContext.value.floatValue;
+                    } break;
+                    case kHAPCharacteristicFormat_Data:
+                    case kHAPCharacteristicFormat_String:
+                    case kHAPCharacteristicFormat_TLV8: {
+                        writeContext->value.stringValue.bytes = readContext.value.stringValue.bytes;
+                        writeContext->value.stringValue.numBytes = readContext.value.stringValue.numBytes;
+                    } break;
+                }
+            } else {
+                // Ignore value of read operation and revert possible changes to data buffer.
+                HAPRawBufferCopyBytes(dataBuffer, &dataBufferSnapshot, sizeof *dataBuffer);
+            }
+        }
+    } else if (writeContext->response) {
+        writeContext->status = kHAPIPAccessoryServerStatusCode_ReadFromWriteOnlyCharacteristic;
+    }
+}
+
 static void handle_characteristic_write_request(
         HAPIPSessionDescriptor* session,
         const HAPCharacteristic* characteristic,
@@ -908,6 +1932,7 @@ static void handle_characteristic_write_request(
                         ((HAPIPEventNotification*) &session->eventNotifications[i])->aid = writeContext->aid;
                         ((HAPIPEventNotification*) &session->eventNotifications[i])->iid = writeContext->iid;
                         ((HAPIPEventNotification*) &session->eventNotifications[i])->flag = false;
+                        ((HAPIPEventNotification*) &session->eventNotifications[i])->isDue = false;
                         session->numEventNotifications++;
                         handle_characteristic_subscribe_request(session, characteristic, service, accessory);
                     }
@@ -915,8 +1940,8 @@ static void handle_characteristic_write_request(
             } else if (writeContext->ev == kHAPIPEventNotificationState_Disabled) {
                 session->numEventNotifications--;
                 if (((HAPIPEventNotification*) &session->eventNotifications[i])->flag) {
-                    HAPAssert(session->numEventNotificationFlags > 0);
-                    session->numEventNotificationFlags--;
+                    clear_event_notification_flag(
+                            session, (HAPIPEventNotification*) &session->eventNotifications[i]);
                 }
                 while (i < session->numEventNotifications) {
                     HAPRawBufferCopyBytes(
@@ -962,16 +1987,20 @@ static void handle_characteristic_write_request(
                 }
             }
             if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
+                HAPCompletionToken completionToken = assign_completion_token(session);
                 switch (baseCharacteristic->format) {
                     case kHAPCharacteristicFormat_Data: {
                         if (writeContext->type == kHAPIPWriteValueType_String) {
                             HAPAssert(writeContext->value.stringValue.bytes);
-                            int r = util_base64_decode(
-                                    writeContext->value.stringValue.bytes,
-                                    writeContext->value.stringValue.numBytes,
-                                    writeContext->value.stringValue.bytes,
-                                    writeContext->value.stringValue.numBytes,
-                                    &writeContext->value.stringValue.numBytes);
+                            int r = 0;
+                            if (!writeContext->isValueDecoded) {
+                                r = util_base64_decode(
+                                        writeContext->value.stringValue.bytes,
+                                        writeContext->value.stringValue.numBytes,
+                                        writeContext->value.stringValue.bytes,
+                                        writeContext->value.stringValue.numBytes,
+                                        &writeContext->value.stringValue.numBytes);
+                            }
                             if (r == 0) {
                                 HAPAssert(writeContext->value.stringValue.bytes);
                                 err = HAPDataCharacteristicHandleWrite(
@@ -984,7 +2013,8 @@ static void handle_characteristic_write_request(
                                                 .accessory = accessory,
                                                 .remote = writeContext->remote,
                                                 .authorizationData = { .bytes = authorizationDataBytes,
-                                                                       .numBytes = numAuthorizationDataBytes } },
+                                                                       .numBytes = numAuthorizationDataBytes },
+                                                .completionToken = completionToken },
                                         HAPNonnull(writeContext->value.stringValue.bytes),
                                         writeContext->value.stringValue.numBytes,
                                         HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
@@ -1009,7 +2039,8 @@ static void handle_characteristic_write_request(
                                             .accessory = accessory,
                                             .remote = writeContext->remote,
                                             .authorizationData = { .bytes = authorizationDataBytes,
-                                                                   .numBytes = numAuthorizationDataBytes } },
+                                                                   .numBytes = numAuthorizationDataBytes },
+                                            .completionToken = completionToken },
                                     (bool) writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1030,7 +2061,8 @@ static void handle_characteristic_write_request(
                                             .accessory = accessory,
                                             .remote = writeContext->remote,
                                             .authorizationData = { .bytes = authorizationDataBytes,
-                                                                   .numBytes = numAuthorizationDataBytes } },
+                                                                   .numBytes = numAuthorizationDataBytes },
+                                            .completionToken = completionToken },
                                     (uint8_t) writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1051,7 +2083,8 @@ static void handle_characteristic_write_request(
                                             .accessory = accessory,
                                             .remote = writeContext->remote,
                                             .authorizationData = { .bytes = authorizationDataBytes,
-                                                                   .numBytes = numAuthorizationDataBytes } },
+                                                                   .numBytes = numAuthorizationDataBytes },
+                                            .completionToken = completionToken },
                                     (uint16_t) writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1072,7 +2105,8 @@ static void handle_characteristic_write_request(
                                             .accessory = accessory,
                                             .remote = writeContext->remote,
                                             .authorizationData = { .bytes = authorizationDataBytes,
-                                                                   .numBytes = numAuthorizationDataBytes } },
+                                                                   .numBytes = numAuthorizationDataBytes },
+                                            .completionToken = completionToken },
                                     (uint32_t) writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1092,7 +2126,8 @@ static void handle_characteristic_write_request(
                                             .accessory = accessory,
                                             .remote = writeContext->remote,
                                             .authorizationData = { .bytes = authorizationDataBytes,
-                                                                   .numBytes = numAuthorizationDataBytes } },
+                                                                   .numBytes = numAuthorizationDataBytes },
+                                            .completionToken = completionToken },
                                     writeContext->value.unsignedIntValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1117,7 +2152,8 @@ static void handle_characteristic_write_request(
                                             .accessory = accessory,
                                             .remote = writeContext->remote,
                                             .authorizationData = { .bytes = authorizationDataBytes,
-                                                                   .numBytes = numAuthorizationDataBytes } },
+                                                                   .numBytes = numAuthorizationDataBytes },
+                                            .completionToken = completionToken },
                                     writeContext->value.intValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1147,7 +2183,8 @@ static void handle_characteristic_write_request(
                                             .accessory = accessory,
                                             .remote = writeContext->remote,
                                             .authorizationData = { .bytes = authorizationDataBytes,
-                                                                   .numBytes = numAuthorizationDataBytes } },
+                                                                   .numBytes = numAuthorizationDataBytes },
+                                            .completionToken = completionToken },
                                     writeContext->value.floatValue,
                                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                             writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1181,7 +2218,8 @@ static void handle_characteristic_write_request(
                                                 .accessory = accessory,
                                                 .remote = writeContext->remote,
                                                 .authorizationData = { .bytes = authorizationDataBytes,
-                                                                       .numBytes = numAuthorizationDataBytes } },
+                                                                       .numBytes = numAuthorizationDataBytes },
+                                                .completionToken = completionToken },
                                         &dataBuffer->data[dataBuffer->position],
                                         HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                                 writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1193,12 +2231,15 @@ static void handle_characteristic_write_request(
                     case kHAPCharacteristicFormat_TLV8: {
                         if (writeContext->type == kHAPIPWriteValueType_String) {
                             HAPAssert(writeContext->value.stringValue.bytes);
-                            int r = util_base64_decode(
-                                    writeContext->value.stringValue.bytes,
-                                    writeContext->value.stringValue.numBytes,
-                                    writeContext->value.stringValue.bytes,
-                                    writeContext->value.stringValue.numBytes,
-                                    &writeContext->value.stringValue.numBytes);
+                            int r = 0;
+                            if (!writeContext->isValueDecoded) {
+                                r = util_base64_decode(
+                                        writeContext->value.stringValue.bytes,
+                                        writeContext->value.stringValue.numBytes,
+                                        writeContext->value.stringValue.bytes,
+                                        writeContext->value.stringValue.numBytes,
+                                        &writeContext->value.stringValue.numBytes);
+                            }
                             if (r == 0) {
                                 HAPTLVReaderRef tlvReader;
                                 HAPTLVReaderCreate(
@@ -1215,7 +2256,8 @@ static void handle_characteristic_write_request(
                                                 .accessory = accessory,
                                                 .remote = writeContext->remote,
                                                 .authorizationData = { .bytes = authorizationDataBytes,
-                                                                       .numBytes = numAuthorizationDataBytes } },
+                                                                       .numBytes = numAuthorizationDataBytes },
+                                                .completionToken = completionToken },
                                         &tlvReader,
                                         HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
                                 writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(err);
@@ -1225,54 +2267,12 @@ static void handle_characteristic_write_request(
                         }
                     } break;
                 }
+                if (writeContext->status == kHAPIPAccessoryServerStatusCode_InProgress) {
+                    session->pendingRequest.writeCompletionToken = completionToken;
+                }
                 if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
-                    if (baseCharacteristic->properties.ip.supportsWriteResponse) {
-                        HAPIPByteBuffer dataBufferSnapshot;
-                        HAPRawBufferCopyBytes(&dataBufferSnapshot, dataBuffer, sizeof dataBufferSnapshot);
-                        HAPIPReadContext readContext;
-                        HAPRawBufferZero(&readContext, sizeof readContext);
-                        readContext.aid = writeContext->aid;
-                        readContext.iid = writeContext->iid;
-                        handle_characteristic_read_request(
-                                session,
-                                characteristic,
-                                service,
-                                accessory,
-                                (HAPIPReadContextRef*) &readContext,
-                                dataBuffer);
-                        writeContext->status = readContext.status;
-                        if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
-                            if (writeContext->response) {
-                                switch (baseCharacteristic->format) {
-                                    case kHAPCharacteristicFormat_Bool:
-                                    case kHAPCharacteristicFormat_UInt8:
-                                    case kHAPCharacteristicFormat_UInt16:
-                                    case kHAPCharacteristicFormat_UInt32:
-                                    case kHAPCharacteristicFormat_UInt64: {
-                                        writeContext->value.unsignedIntValue = readContext.value.unsignedIntValue;
-                                    } break;
-                                    case kHAPCharacteristicFormat_Int: {
-                                        writeContext->value.intValue = readContext.value.intValue;
-                                    } break;
-                                    case kHAPCharacteristicFormat_Float: {
-                                        writeContext->value.floatValue = readContext.value.floatValue;
-                                    } break;
-                                    case kHAPCharacteristicFormat_Data:
-                                    case kHAPCharacteristicFormat_String:
-                                    case kHAPCharacteristicFormat_TLV8: {
-                                        writeContext->value.stringValue.bytes = readContext.value.stringValue.bytes;
-                                        writeContext->value.stringValue.numBytes =
-                                                readContext.value.stringValue.numBytes;
-                                    } break;
-                                }
-                            } else {
-                                // Ignore value of read operation and revert possible changes to data buffer.
-                                HAPRawBufferCopyBytes(dataBuffer, &dataBufferSnapshot, sizeof *dataBuffer);
-                            }
-                        }
-                    } else if (writeContext->response) {
-                        writeContext->status = kHAPIPAccessoryServerStatusCode_ReadFromWriteOnlyCharacteristic;
-                    }
+                    handle_characteristic_write_response(
+                            session, characteristic, service, accessory, context, dataBuffer);
                 }
             }
         } else {
@@ -1282,170 +2282,746 @@ static void handle_characteristic_write_request(
 }
 
 /**
- * Handles a set of characteristic write requests.
- *
- * @param      session              IP session descriptor.
- * @param      contexts             Request contexts.
- * @param      numContexts          Length of @p contexts.
- * @param      dataBuffer           Buffer for values of type data, string or TLV8.
- * @param      timedWrite           Whether the request was a valid Execute Write Request or a regular Write Request.
+ * Handles a set of characteristic write requests.
+ *
+ * - If a write handler completes asynchronously, the remaining write requests are not handled.
+ *   The pending write is recorded in the pending request state of the session.
+ *
+ * @param      session              IP session descriptor.
+ * @param      contexts             Request contexts.
+ * @param      numContexts          Length of @p contexts.
+ * @param      dataBuffer           Buffer for values of type data, string or TLV8.
+ * @param      timedWrite           Whether the request was a valid Execute Write Request or a regular Write Request.
+ */
+static void handle_characteristic_write_requests(
+        HAPIPSessionDescriptor* session,
+        HAPIPWriteContextRef* contexts,
+        size_t numContexts,
+        HAPIPByteBuffer* dataBuffer,
+        bool timedWrite) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
+    HAPPrecondition(session->securitySession.isOpen);
+    HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
+    HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
+    HAPPrecondition(contexts);
+    HAPPrecondition(dataBuffer);
+
+    for (size_t i = 0; i < numContexts; i++) {
+        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[i];
+        const HAPCharacteristic* characteristic;
+        const HAPService* service;
+        const HAPAccessory* accessory;
+        get_db_ctx(
+                session->server,
+                writeContext->aid,
+                writeContext->iid,
+                &characteristic,
+                &service,
+                &accessory,
+                /* chrTypeID: */ NULL);
+        if (characteristic) {
+            HAPAssert(service);
+            HAPAssert(accessory);
+            server->ip.characteristicWriteRequestContext.ipSession = GetIPSession(session);
+            server->ip.characteristicWriteRequestContext.characteristic = characteristic;
+            server->ip.characteristicWriteRequestContext.service = service;
+            server->ip.characteristicWriteRequestContext.accessory = accessory;
+            const HAPBaseCharacteristic* baseCharacteristic = characteristic;
+            if ((writeContext->type != kHAPIPWriteValueType_None) &&
+                baseCharacteristic->properties.requiresTimedWrite && !timedWrite) {
+                // If the accessory receives a standard write request on a characteristic which requires timed write,
+                // the accessory must respond with HAP status error code -70410 (HAPIPStatusErrorCodeInvalidWrite).
+                // See HomeKit Accessory Protocol Specification R14
+                // Section 6.7.2.4 Timed Write Procedures
+                HAPLogCharacteristic(
+                        &logObject,
+                        characteristic,
+                        service,
+                        accessory,
+                        "Rejected write: Only timed writes are supported.");
+                writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
+            } else {
+                handle_characteristic_write_request(
+                        session, characteristic, service, accessory, &contexts[i], dataBuffer);
+            }
+            server->ip.characteristicWriteRequestContext.ipSession = NULL;
+            server->ip.characteristicWriteRequestContext.characteristic = NULL;
+            server->ip.characteristicWriteRequestContext.service = NULL;
+            server->ip.characteristicWriteRequestContext.accessory = NULL;
+        } else {
+            writeContext->status = kHAPIPAccessoryServerStatusCode_ResourceDoesNotExist;
+        }
+        if (writeContext->status == kHAPIPAccessoryServerStatusCode_InProgress) {
+            // The remaining write requests are handled once the pending write has completed.
+            HAPLogDebug(&logObject, "session:%p:waiting for write to complete", (const void*) session);
+            session->pendingRequest.aid = writeContext->aid;
+            session->pendingRequest.iid = writeContext->iid;
+            session->pendingRequest.isWritePending = true;
+            return;
+        }
+    }
+}
+
+/**
+ * Checks whether the response to a set of handled characteristic write requests requires a Multi-Status response.
+ *
+ * @param      contexts             Request contexts.
+ * @param      numContexts          Length of @p contexts.
+ *
+ * @return true                     If a write failed or a write response was requested.
+ * @return false                    If all writes have been handled successfully without write response.
+ */
+HAP_RESULT_USE_CHECK
+static bool characteristic_write_requests_require_multi_status(
+        const HAPIPWriteContextRef* contexts,
+        size_t numContexts) {
+    HAPPrecondition(contexts);
+
+    for (size_t i = 0; i < numContexts; i++) {
+        const HAPIPWriteContext* writeContext = (const HAPIPWriteContext*) &contexts[i];
+        if ((writeContext->status != kHAPIPAccessoryServerStatusCode_Success) || writeContext->response) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks whether the "pid" of an Execute Write Request matches the timed write that has been prepared on a session.
+ *
+ * @param      session              IP session.
+ * @param      pid                  PID of the Execute Write Request.
+ *
+ * @return true                     If a timed write with the given PID is prepared and has not yet expired.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool timed_write_is_valid(HAPIPSessionDescriptor* session, uint64_t pid) {
+    HAPPrecondition(session);
+
+    return session->timedWriteExpirationTime &&
+           session->timedWriteExpirationTime >= HAPPlatformClockGetCurrent() && session->timedWritePID == pid;
+}
+
+/**
+ * Saves the write contexts of a PUT /characteristics request whose write handler completes asynchronously.
+ *
+ * - The write contexts are copied into the unused space of the outbound buffer of the session, so that other sessions
+ *   may use the write contexts while the write is pending. Values of the write contexts refer to the request that is
+ *   kept in the inbound buffer of the session.
+ *
+ * - The unused space of the outbound buffer must be large enough to hold the write contexts.
+ *
+ * @param      session              IP session descriptor.
+ * @param      contexts             Write contexts.
+ * @param      numContexts          Length of @p contexts.
+ */
+static void save_write_contexts(
+        HAPIPSessionDescriptor* session,
+        const HAPIPWriteContextRef* contexts,
+        size_t numContexts) {
+    HAPPrecondition(session);
+    HAPPrecondition(contexts);
+
+    size_t numContextBytes = numContexts * sizeof *contexts;
+    HAPPrecondition(numContextBytes <= session->outboundBuffer.limit - session->outboundBuffer.position);
+    HAPRawBufferCopyBytes(&session->outboundBuffer.data[session->outboundBuffer.position], contexts, numContextBytes);
+    session->pendingRequest.areWriteContextsSaved = true;
+}
+
+/**
+ * Handles the write requests of a PUT /characteristics request that have been parsed into the write contexts and
+ * prepares the response.
+ *
+ * - Write handlers may only complete asynchronously if the write contexts can be saved in the outbound buffer.
+ *   If a write handler completes asynchronously, the session waits until the write has been completed. The write
+ *   contexts are saved in the meantime. Once the session is resumed, the remaining write requests are handled.
+ *
+ * @param      session              IP session descriptor.
+ */
+static void handle_put_characteristics_write_requests(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(!session->pendingRequest.isWritePending);
+
+    HAPIPWriteContextRef* contexts = server->ip.storage->writeContexts;
+    size_t numContexts = session->pendingRequest.numWriteContexts;
+    HAPAssert(numContexts <= server->ip.storage->numWriteContexts);
+
+    HAPIPByteBuffer dataBuffer;
+    dataBuffer.data = server->ip.storage->scratchBuffer.bytes;
+    dataBuffer.capacity = server->ip.storage->scratchBuffer.numBytes;
+    dataBuffer.limit = server->ip.storage->scratchBuffer.numBytes;
+    dataBuffer.position = 0;
+    HAPAssert(dataBuffer.data);
+
+    size_t index = 0;
+    if (session->pendingRequest.isWriteCompleted) {
+        index = session->pendingRequest.writeContextIndex;
+        HAPAssert(index < numContexts);
+        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[index];
+        HAPAssert(writeContext->status == kHAPIPAccessoryServerStatusCode_InProgress);
+        writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(session->pendingRequest.writeError);
+        session->pendingRequest.isWriteCompleted = false;
+
+        // Values of write responses are stored in the scratch buffer that may have been used by other sessions while
+        // the write was pending. They are read again.
+        for (size_t i = 0; i <= index; i++) {
+            writeContext = (HAPIPWriteContext*) &contexts[i];
+            if ((writeContext->status == kHAPIPAccessoryServerStatusCode_Success) &&
+                ((i == index) || writeContext->response)) {
+                const HAPCharacteristic* characteristic;
+                const HAPService* service;
+                const HAPAccessory* accessory;
+                get_db_ctx(
+                        session->server,
+                        writeContext->aid,
+                        writeContext->iid,
+                        &characteristic,
+                        &service,
+                        &accessory,
+                        /* chrTypeID: */ NULL);
+                HAPAssert(characteristic);
+                handle_characteristic_write_response(
+                        session,
+                        HAPNonnull(characteristic),
+                        HAPNonnull(service),
+                        HAPNonnull(accessory),
+                        &contexts[i],
+                        &dataBuffer);
+            }
+        }
+        index++;
+    }
+
+    session->handlersMayCompleteAsynchronously =
+            numContexts * sizeof *contexts <= session->outboundBuffer.limit - session->outboundBuffer.position;
+    handle_characteristic_write_requests(
+            session, &contexts[index], numContexts - index, &dataBuffer, session->pendingRequest.isTimedWrite);
+    session->handlersMayCompleteAsynchronously = false;
+    if (session->pendingRequest.isWritePending) {
+        while (((const HAPIPWriteContext*) &contexts[index])->status != kHAPIPAccessoryServerStatusCode_InProgress) {
+            index++;
+            HAPAssert(index < numContexts);
+        }
+        session->pendingRequest.writeContextIndex = index;
+        save_write_contexts(session, contexts, numContexts);
+        enter_waiting_state(session);
+        return;
+    }
+
+    if (characteristic_write_requests_require_multi_status(contexts, numContexts)) {
+        write_characteristic_write_response(session, contexts, numContexts);
+    } else {
+        write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
+    }
+
+    // Reset timed write transaction.
+    if (session->timedWriteExpirationTime && session->pendingRequest.isTimedWrite) {
+        session->timedWriteExpirationTime = 0;
+        session->timedWritePID = 0;
+    }
+
+    HAPRawBufferZero(&session->pendingRequest, sizeof session->pendingRequest);
+}
+
+static void put_characteristics(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
+    HAPPrecondition(session->securitySession.isOpen);
+    HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
+    HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
+
+    HAPError err;
+    size_t i, contexts_count;
+    bool pid_valid;
+    uint64_t pid;
+
+    if (session->pendingRequest.isWriteCompleted) {
+        // Resume request after the pending write has been completed.
+        HAPAssert(session->pendingRequest.areWriteContextsSaved);
+        HAPRawBufferCopyBytes(
+                server->ip.storage->writeContexts,
+                &session->outboundBuffer.data[session->outboundBuffer.position],
+                session->pendingRequest.numWriteContexts * sizeof *server->ip.storage->writeContexts);
+        session->pendingRequest.areWriteContextsSaved = false;
+        handle_put_characteristics_write_requests(session);
+        return;
+    }
+
+    HAPAssert(session->inboundBuffer.data);
+    HAPAssert(session->inboundBuffer.position <= session->inboundBuffer.limit);
+    HAPAssert(session->inboundBuffer.limit <= session->inboundBuffer.capacity);
+    HAPAssert(session->httpReaderPosition <= session->inboundBuffer.position);
+    if (session->httpContentLength.isDefined) {
+        HAPAssert(session->httpContentLength.value <= session->inboundBuffer.position - session->httpReaderPosition);
+        err = HAPIPAccessoryProtocolGetCharacteristicWriteRequests(
+                &session->inboundBuffer.data[session->httpReaderPosition],
+                session->httpContentLength.value,
+                server->ip.storage->writeContexts,
+                server->ip.storage->numWriteContexts,
+                &contexts_count,
+                &pid_valid,
+                &pid);
+        if (!err) {
+            if (pid_valid && !timed_write_is_valid(session, pid)) {
+                // If the accessory receives an Execute Write Request after the TTL has expired it must ignore the
+                // request and respond with HAP status error code -70410 (HAPIPStatusErrorCodeInvalidWrite).
+                // See HomeKit Accessory Protocol Specification R14
+                // Section 6.7.2.4 Timed Write Procedures
+                HAPLog(&logObject, "Rejecting expired Execute Write Request.");
+                for (i = 0; i < contexts_count; i++) {
+                    ((HAPIPWriteContext*) &server->ip.storage->writeContexts[i])->status =
+                            kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
+                }
+                HAPAssert(i == contexts_count);
+                write_characteristic_write_response(session, server->ip.storage->writeContexts, contexts_count);
+            } else if (contexts_count == 0) {
+                write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
+            } else {
+                session->pendingRequest.numWriteContexts = contexts_count;
+                session->pendingRequest.isTimedWrite = pid_valid;
+                handle_put_characteristics_write_requests(session);
+                return;
+            }
+            // Reset timed write transaction.
+            if (session->timedWriteExpirationTime && pid_valid) {
+                session->timedWriteExpirationTime = 0;
+                session->timedWritePID = 0;
+            }
+        } else if (err == kHAPError_OutOfResources) {
+            write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_OutOfResources);
+        } else {
+            write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_BadRequest);
+        }
+    } else {
+        write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_BadRequest);
+    }
+}
+
+static void prepare_writing_response(HAPIPSessionDescriptor* session);
+
+/**
+ * Releases the resources of a streaming write.
+ *
+ * @param      session              IP session.
+ */
+static void end_streaming_write(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+
+    if (session->streamingWrite.hasStagingBuffer) {
+        HAPAssert(server->ip.writeStagingBufferIsInUse);
+        server->ip.writeStagingBufferIsInUse = false;
+    }
+    HAPRawBufferZero(&session->streamingWrite, sizeof session->streamingWrite);
+}
+
+/**
+ * Starts a streaming write if the received request is a PUT /characteristics request.
+ *
+ * - The request headers are discarded from the inbound buffer. The body is passed to handle_streaming_write as it
+ *   is received.
+ *
+ * @param      session              IP session.
+ *
+ * @return true                     If a streaming write has been started.
+ * @return false                    If the request cannot be handled as a streaming write.
+ */
+HAP_RESULT_USE_CHECK
+static bool begin_streaming_write(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->securitySession.isOpen);
+    HAPPrecondition(!session->streamingWrite.isActive);
+
+    HAPAssert(session->httpReader.state == util_HTTP_READER_STATE_DONE);
+    HAPAssert(session->httpReaderPosition <= session->inboundBuffer.position);
+    if (!session->httpContentLength.isDefined || (session->httpURI.numBytes < 16) ||
+        !HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/characteristics", 16) ||
+        (session->httpMethod.numBytes != 3) ||
+        !HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "PUT", 3)) {
+        return false;
+    }
+    if ((session->securitySession.type != kHAPIPSecuritySessionType_HAP) ||
+        !(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) ||
+        HAPSessionIsTransient(&session->securitySession._.hap)) {
+        return false;
+    }
+
+    HAPLogBufferDebug(
+            &logObject,
+            session->inboundBuffer.data,
+            session->httpReaderPosition,
+            "session:%p:>",
+            (const void*) session);
+    HAPLogDebug(
+            &logObject,
+            "session:%p:streaming write (%lu bytes)",
+            (const void*) session,
+            (unsigned long) session->httpContentLength.value);
+    HAPIPByteBufferShiftLeft(&session->inboundBuffer, session->httpReaderPosition);
+    session->httpReaderPosition = 0;
+
+    HAPRawBufferZero(&session->streamingWrite, sizeof session->streamingWrite);
+    void* _Nullable stagingBytes = NULL;
+    size_t maxStagingBytes = 0;
+    if (server->ip.storage->writeStagingBuffer.bytes) {
+        if (!server->ip.writeStagingBufferIsInUse) {
+            server->ip.writeStagingBufferIsInUse = true;
+            session->streamingWrite.hasStagingBuffer = true;
+            stagingBytes = server->ip.storage->writeStagingBuffer.bytes;
+            maxStagingBytes = server->ip.storage->writeStagingBuffer.numBytes;
+        } else {
+            HAPLog(&logObject, "Write staging buffer is in use by another session.");
+        }
+    }
+    HAPIPWriteRequestParserCreate(&session->streamingWrite.parser, stagingBytes, maxStagingBytes);
+    session->streamingWrite.numRemainingBodyBytes = session->httpContentLength.value;
+    session->streamingWrite.isActive = true;
+
+    HAPIPByteBufferClear(&session->outboundBuffer);
+    write_msg(&session->outboundBuffer, "{\"characteristics\":[");
+    return true;
+}
+
+/**
+ * Handles a write request of a streaming write.
+ *
+ * - If the request contains a "pid", the write request is handled as part of the prepared timed write.
+ *
+ * @param      session              IP session.
+ * @param      writeContext         Write request.
+ */
+static void execute_streamed_write_request(HAPIPSessionDescriptor* session, HAPIPWriteContextRef* writeContext) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->streamingWrite.isActive);
+    HAPPrecondition(writeContext);
+
+    bool timedWrite = false;
+    if (session->streamingWrite.parser.hasPID) {
+        if (!session->streamingWrite.isPIDChecked) {
+            session->streamingWrite.isPIDValid = timed_write_is_valid(session, session->streamingWrite.parser.pid);
+            session->streamingWrite.isPIDChecked = true;
+            if (!session->streamingWrite.isPIDValid) {
+                HAPLog(&logObject, "Rejecting expired Execute Write Request.");
+            }
+        }
+        if (!session->streamingWrite.isPIDValid) {
+            ((HAPIPWriteContext*) writeContext)->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
+            return;
+        }
+        timedWrite = true;
+    }
+
+    HAPIPByteBuffer dataBuffer;
+    dataBuffer.data = server->ip.storage->scratchBuffer.bytes;
+    dataBuffer.capacity = server->ip.storage->scratchBuffer.numBytes;
+    dataBuffer.limit = server->ip.storage->scratchBuffer.numBytes;
+    dataBuffer.position = 0;
+    handle_characteristic_write_requests(session, writeContext, 1, &dataBuffer, timedWrite);
+}
+
+/**
+ * Serializes the response of a write request of a streaming write into the outbound buffer.
+ *
+ * @param      session              IP session.
+ * @param      writeContext         Handled write request.
+ */
+static void write_streamed_write_response(HAPIPSessionDescriptor* session, HAPIPWriteContextRef* writeContext) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(session->streamingWrite.isActive);
+    HAPPrecondition(writeContext);
+
+    HAPError err;
+
+    if (characteristic_write_requests_require_multi_status(writeContext, 1)) {
+        session->streamingWrite.isMultiStatus = true;
+    }
+    if (session->streamingWrite.isOutOfResources) {
+        return;
+    }
+    size_t mark = session->outboundBuffer.position;
+    if (session->streamingWrite.numWriteResponses) {
+        err = HAPIPByteBufferAppendStringWithFormat(&session->outboundBuffer, ",");
+    } else {
+        err = kHAPError_None;
+    }
+    if (!err) {
+        err = HAPIPAccessoryProtocolGetCharacteristicWriteResponseObjectBytes(
+                HAPNonnull(session->server), writeContext, &session->outboundBuffer);
+    }
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        HAPLog(&logObject, "Out of resources (outbound buffer too small).");
+        session->outboundBuffer.position = mark;
+        session->streamingWrite.isOutOfResources = true;
+        return;
+    }
+    session->streamingWrite.numWriteResponses++;
+}
+
+/**
+ * Checks whether the characteristic of a write request requires timed writes.
+ *
+ * @param      session              IP session.
+ * @param      writeContext         Write request.
+ *
+ * @return true                     If the characteristic exists and requires timed writes.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool characteristic_write_request_requires_timed_write(
+        HAPIPSessionDescriptor* session,
+        const HAPIPWriteContextRef* writeContext) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(writeContext);
+
+    const HAPIPWriteContext* context = (const HAPIPWriteContext*) writeContext;
+    const HAPCharacteristic* characteristic;
+    const HAPService* service;
+    const HAPAccessory* accessory;
+    get_db_ctx(
+            session->server,
+            context->aid,
+            context->iid,
+            &characteristic,
+            &service,
+            &accessory,
+            /* chrTypeID: */ NULL);
+    return characteristic && ((const HAPBaseCharacteristic*) characteristic)->properties.requiresTimedWrite;
+}
+
+/**
+ * Handles a write request that has been reported by the parser of a streaming write.
+ *
+ * @param      session              IP session.
+ */
+static void handle_streamed_write_request(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(session->streamingWrite.isActive);
+
+    HAPIPWriteRequestParser* parser = &session->streamingWrite.parser;
+    HAPIPWriteContextRef* writeContext = (HAPIPWriteContextRef*) &parser->writeContext;
+    if (parser->writeContextError) {
+        parser->writeContext.status = ConvertCharacteristicWriteErrorToStatusCode(parser->writeContextError);
+    } else if (
+            !parser->hasPID && session->timedWriteExpirationTime &&
+            characteristic_write_request_requires_timed_write(session, writeContext)) {
+        // The "pid" may follow the "characteristics" array. Write requests to characteristics that require timed
+        // writes are held back until the end of the request so that they can be handled as part of the prepared
+        // timed write.
+        if (session->streamingWrite.hasDeferredWriteContext) {
+            HAPLog(&logObject, "Only one write request can be deferred until the PID is known.");
+            parser->writeContext.status = kHAPIPAccessoryServerStatusCode_OutOfResources;
+        } else {
+            HAPRawBufferCopyBytes(
+                    &session->streamingWrite.deferredWriteContext, writeContext, sizeof *writeContext);
+            HAPIPWriteRequestParserRetainStagedBytes(parser);
+            session->streamingWrite.hasDeferredWriteContext = true;
+            return;
+        }
+    } else {
+        session->handlersMayCompleteAsynchronously = true;
+        execute_streamed_write_request(session, writeContext);
+        session->handlersMayCompleteAsynchronously = false;
+        if (session->pendingRequest.isWritePending) {
+            // The response is serialized once the write has been completed.
+            return;
+        }
+    }
+    write_streamed_write_response(session, writeContext);
+}
+
+/**
+ * Serializes the response of a write request of a streaming write whose write handler has been completed.
+ *
+ * @param      session              IP session.
+ */
+static void resume_streamed_write_request(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(session->streamingWrite.isActive);
+    HAPPrecondition(session->pendingRequest.isWriteCompleted);
+
+    HAPIPWriteContext* writeContext = &session->streamingWrite.parser.writeContext;
+    HAPAssert(writeContext->status == kHAPIPAccessoryServerStatusCode_InProgress);
+    writeContext->status = ConvertCharacteristicWriteErrorToStatusCode(session->pendingRequest.writeError);
+    if (writeContext->status == kHAPIPAccessoryServerStatusCode_Success) {
+        const HAPCharacteristic* characteristic;
+        const HAPService* service;
+        const HAPAccessory* accessory;
+        get_db_ctx(
+                session->server,
+                writeContext->aid,
+                writeContext->iid,
+                &characteristic,
+                &service,
+                &accessory,
+                /* chrTypeID: */ NULL);
+        HAPAssert(characteristic);
+
+        HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+        HAPIPByteBuffer dataBuffer;
+        dataBuffer.data = server->ip.storage->scratchBuffer.bytes;
+        dataBuffer.capacity = server->ip.storage->scratchBuffer.numBytes;
+        dataBuffer.limit = server->ip.storage->scratchBuffer.numBytes;
+        dataBuffer.position = 0;
+        handle_characteristic_write_response(
+                session,
+                HAPNonnull(characteristic),
+                HAPNonnull(service),
+                HAPNonnull(accessory),
+                (HAPIPWriteContextRef*) writeContext,
+                &dataBuffer);
+    }
+    HAPRawBufferZero(&session->pendingRequest, sizeof session->pendingRequest);
+    write_streamed_write_response(session, (HAPIPWriteContextRef*) writeContext);
+}
+
+/**
+ * Completes a streaming write and prepares the response.
  *
- * @return 0                        If all writes could be handled successfully.
- * @return -1                       Otherwise (Multi-Status).
+ * @param      session              IP session.
  */
-HAP_RESULT_USE_CHECK
-static int handle_characteristic_write_requests(
-        HAPIPSessionDescriptor* session,
-        HAPIPWriteContextRef* contexts,
-        size_t numContexts,
-        HAPIPByteBuffer* dataBuffer,
-        bool timedWrite) {
+static void finish_streaming_write(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
-    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
-    HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
-    HAPPrecondition(session->securitySession.isOpen);
-    HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
-    HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
-    HAPPrecondition(contexts);
-    HAPPrecondition(dataBuffer);
+    HAPPrecondition(session->streamingWrite.isActive);
+    HAPPrecondition(!session->streamingWrite.numRemainingBodyBytes);
 
-    int r = 0;
+    HAPError err;
 
-    for (size_t i = 0; i < numContexts; i++) {
-        HAPIPWriteContext* writeContext = (HAPIPWriteContext*) &contexts[i];
-        const HAPCharacteristic* characteristic;
-        const HAPService* service;
-        const HAPAccessory* accessory;
-        get_db_ctx(session->server, writeContext->aid, writeContext->iid, &characteristic, &service, &accessory);
-        if (characteristic) {
-            HAPAssert(service);
-            HAPAssert(accessory);
-            server->ip.characteristicWriteRequestContext.ipSession = NULL;
-            for (size_t j = 0; j < server->ip.storage->numSessions; j++) {
-                HAPIPSession* ipSession = &server->ip.storage->sessions[j];
-                HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-                if (t->server && (t == session)) {
-                    HAPAssert(!server->ip.characteristicWriteRequestContext.ipSession);
-                    server->ip.characteristicWriteRequestContext.ipSession = ipSession;
-                }
-            }
-            HAPAssert(server->ip.characteristicWriteRequestContext.ipSession);
-            server->ip.characteristicWriteRequestContext.characteristic = characteristic;
-            server->ip.characteristicWriteRequestContext.service = service;
-            server->ip.characteristicWriteRequestContext.accessory = accessory;
-            const HAPBaseCharacteristic* baseCharacteristic = characteristic;
-            if ((writeContext->type != kHAPIPWriteValueType_None) &&
-                baseCharacteristic->properties.requiresTimedWrite && !timedWrite) {
-                // If the accessory receives a standard write request on a characteristic which requires timed write,
-                // the accessory must respond with HAP status error code -70410 (HAPIPStatusErrorCodeInvalidWrite).
-                // See HomeKit Accessory Protocol Specification R14
-                // Section 6.7.2.4 Timed Write Procedures
-                HAPLogCharacteristic(
-                        &logObject,
-                        characteristic,
-                        service,
-                        accessory,
-                        "Rejected write: Only timed writes are supported.");
-                writeContext->status = kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
-            } else {
-                handle_characteristic_write_request(
-                        session, characteristic, service, accessory, &contexts[i], dataBuffer);
-            }
-            server->ip.characteristicWriteRequestContext.ipSession = NULL;
-            server->ip.characteristicWriteRequestContext.characteristic = NULL;
-            server->ip.characteristicWriteRequestContext.service = NULL;
-            server->ip.characteristicWriteRequestContext.accessory = NULL;
-        } else {
-            writeContext->status = kHAPIPAccessoryServerStatusCode_ResourceDoesNotExist;
+    HAPIPWriteRequestParser* parser = &session->streamingWrite.parser;
+    bool isComplete = !session->streamingWrite.isMalformed && HAPIPWriteRequestParserIsComplete(parser);
+    if (isComplete && session->streamingWrite.hasDeferredWriteContext) {
+        execute_streamed_write_request(session, &session->streamingWrite.deferredWriteContext);
+        write_streamed_write_response(session, &session->streamingWrite.deferredWriteContext);
+    }
+
+    // Reset timed write transaction.
+    if (session->timedWriteExpirationTime && parser->hasPID) {
+        session->timedWriteExpirationTime = 0;
+        session->timedWritePID = 0;
+    }
+
+    bool hasHandledWriteRequests =
+            session->streamingWrite.numWriteResponses || session->streamingWrite.isOutOfResources;
+    if (!isComplete && !hasHandledWriteRequests) {
+        HAPLog(&logObject, "Malformed PUT /characteristics request.");
+        HAPIPByteBufferClear(&session->outboundBuffer);
+        write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_BadRequest);
+    } else if (isComplete && !session->streamingWrite.isMultiStatus) {
+        HAPIPByteBufferClear(&session->outboundBuffer);
+        write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
+    } else {
+        if (!isComplete) {
+            // Write requests that preceded the malformed part have already been handled and cannot be undone.
+            // Their status is reported so that the controller learns which of them have been applied.
+            HAPLog(&logObject, "Malformed PUT /characteristics request. Reporting handled write requests.");
         }
-        if ((r == 0) && (writeContext->status != kHAPIPAccessoryServerStatusCode_Success)) {
-            r = -1;
+        char header[128];
+        err = HAPIPByteBufferAppendStringWithFormat(&session->outboundBuffer, "]}");
+        if (!err) {
+            err = HAPStringWithFormat(
+                    header,
+                    sizeof header,
+                    "HTTP/1.1 207 Multi-Status\r\n"
+                    "Content-Type: application/hap+json\r\n"
+                    "Content-Length: %lu\r\n\r\n",
+                    (unsigned long) session->outboundBuffer.position);
+            HAPAssert(!err);
         }
-        if ((r == 0) && writeContext->response) {
-            r = -1;
+        size_t numHeaderBytes = HAPStringGetNumBytes(header);
+        if (err || session->streamingWrite.isOutOfResources ||
+            numHeaderBytes > session->outboundBuffer.limit - session->outboundBuffer.position) {
+            HAPLog(&logObject, "Out of resources (outbound buffer too small).");
+            HAPIPByteBufferClear(&session->outboundBuffer);
+            write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_OutOfResources);
+        } else {
+            HAPRawBufferCopyBytes(
+                    &session->outboundBuffer.data[numHeaderBytes],
+                    session->outboundBuffer.data,
+                    session->outboundBuffer.position);
+            HAPRawBufferCopyBytes(session->outboundBuffer.data, header, numHeaderBytes);
+            session->outboundBuffer.position += numHeaderBytes;
         }
     }
 
-    return r;
+    end_streaming_write(session);
+    prepare_writing_response(session);
 }
 
-static void put_characteristics(HAPIPSessionDescriptor* session) {
+/**
+ * Passes the received body bytes of a streaming write to its parser and handles completed write requests.
+ *
+ * @param      session              IP session.
+ */
+static void handle_streaming_write(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
-    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
-    HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
-    HAPPrecondition(session->securitySession.isOpen);
-    HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
-    HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
+    HAPPrecondition(session->streamingWrite.isActive);
 
     HAPError err;
-    int r;
-    size_t i, contexts_count;
-    bool pid_valid;
-    uint64_t pid;
-    HAPIPByteBuffer data_buffer;
 
     HAPAssert(session->inboundBuffer.data);
     HAPAssert(session->inboundBuffer.position <= session->inboundBuffer.limit);
     HAPAssert(session->inboundBuffer.limit <= session->inboundBuffer.capacity);
-    HAPAssert(session->httpReaderPosition <= session->inboundBuffer.position);
-    if (session->httpContentLength.isDefined) {
-        HAPAssert(session->httpContentLength.value <= session->inboundBuffer.position - session->httpReaderPosition);
-        err = HAPIPAccessoryProtocolGetCharacteristicWriteRequests(
-                &session->inboundBuffer.data[session->httpReaderPosition],
-                session->httpContentLength.value,
-                server->ip.storage->writeContexts,
-                server->ip.storage->numWriteContexts,
-                &contexts_count,
-                &pid_valid,
-                &pid);
-        if (!err) {
-            if ((session->timedWriteExpirationTime && pid_valid &&
-                 session->timedWriteExpirationTime < HAPPlatformClockGetCurrent()) ||
-                (session->timedWriteExpirationTime && pid_valid && session->timedWritePID != pid) ||
-                (!session->timedWriteExpirationTime && pid_valid)) {
-                // If the accessory receives an Execute Write Request after the TTL has expired it must ignore the
-                // request and respond with HAP status error code -70410 (HAPIPStatusErrorCodeInvalidWrite).
-                // See HomeKit Accessory Protocol Specification R14
-                // Section 6.7.2.4 Timed Write Procedures
-                HAPLog(&logObject, "Rejecting expired Execute Write Request.");
-                for (i = 0; i < contexts_count; i++) {
-                    ((HAPIPWriteContext*) &server->ip.storage->writeContexts[i])->status =
-                            kHAPIPAccessoryServerStatusCode_InvalidValueInWrite;
-                }
-                HAPAssert(i == contexts_count);
-                write_characteristic_write_response(session, server->ip.storage->writeContexts, contexts_count);
-            } else if (contexts_count == 0) {
-                write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
-            } else {
-                data_buffer.data = server->ip.storage->scratchBuffer.bytes;
-                data_buffer.capacity = server->ip.storage->scratchBuffer.numBytes;
-                data_buffer.limit = server->ip.storage->scratchBuffer.numBytes;
-                data_buffer.position = 0;
-                HAPAssert(data_buffer.data);
-                HAPAssert(data_buffer.position <= data_buffer.limit);
-                HAPAssert(data_buffer.limit <= data_buffer.capacity);
-                r = handle_characteristic_write_requests(
-                        session, server->ip.storage->writeContexts, contexts_count, &data_buffer, pid_valid);
-                if (r == 0) {
-                    write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
-                } else {
-                    write_characteristic_write_response(session, server->ip.storage->writeContexts, contexts_count);
-                }
-            }
-            // Reset timed write transaction.
-            if (session->timedWriteExpirationTime && pid_valid) {
-                session->timedWriteExpirationTime = 0;
-                session->timedWritePID = 0;
+    HAPAssert(!session->httpReaderPosition);
+    if (session->pendingRequest.isWriteCompleted) {
+        resume_streamed_write_request(session);
+    }
+    size_t numBytes = session->inboundBuffer.position;
+    if (numBytes > session->streamingWrite.numRemainingBodyBytes) {
+        numBytes = session->streamingWrite.numRemainingBodyBytes;
+    }
+    HAPLogBufferDebug(&logObject, session->inboundBuffer.data, numBytes, "session:%p:>", (const void*) session);
+
+    size_t offset = 0;
+    while (offset < numBytes && !session->streamingWrite.isMalformed) {
+        size_t numBytesRead;
+        bool hasWriteRequest;
+        err = HAPIPWriteRequestParserRead(
+                HAPNonnull(session->server),
+                &session->streamingWrite.parser,
+                &session->inboundBuffer.data[offset],
+                numBytes - offset,
+                &numBytesRead,
+                &hasWriteRequest);
+        if (err) {
+            HAPAssert(err == kHAPError_InvalidData);
+            // The remaining body is discarded. The request is rejected once it has been received completely.
+            session->streamingWrite.isMalformed = true;
+            break;
+        }
+        offset += numBytesRead;
+        if (hasWriteRequest) {
+            handle_streamed_write_request(session);
+            if (session->pendingRequest.isWritePending) {
+                // The remaining body is handled once the write has been completed.
+                numBytes = offset;
+                enter_waiting_state(session);
+                break;
             }
-        } else if (err == kHAPError_OutOfResources) {
-            write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_OutOfResources);
-        } else {
-            write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_BadRequest);
         }
-    } else {
-        write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_BadRequest);
+    }
+    HAPIPByteBufferShiftLeft(&session->inboundBuffer, numBytes);
+    session->streamingWrite.numRemainingBodyBytes -= numBytes;
+    if (!session->streamingWrite.numRemainingBodyBytes && (session->state != kHAPIPSessionState_Waiting)) {
+        finish_streaming_write(session);
     }
 }
 
@@ -1482,6 +3058,9 @@ static int32_t ConvertCharacteristicReadErrorToStatusCode(HAPError error) {
         case kHAPError_Busy: {
             return kHAPIPAccessoryServerStatusCode_ResourceIsBusy;
         }
+        case kHAPError_InProgress: {
+            return kHAPIPAccessoryServerStatusCode_InProgress;
+        }
     }
     HAPFatalError();
 }
@@ -1522,6 +3101,7 @@ static void handle_characteristic_read_request(
     HAPAssert(data_buffer->limit <= data_buffer->capacity);
     HAPIPReadContext* readContext = (HAPIPReadContext*) ctx;
     readContext->status = kHAPIPAccessoryServerStatusCode_Success;
+    readContext->completionToken = assign_completion_token(session);
     switch (chr->format) {
         case kHAPCharacteristicFormat_Data: {
             err = HAPDataCharacteristicHandleRead(
@@ -1530,14 +3110,15 @@ static void handle_characteristic_read_request(
                                                                 .session = &session->securitySession._.hap,
                                                                 .characteristic = (const HAPDataCharacteristic*) chr,
                                                                 .service = svc,
-                                                                .accessory = acc },
+                                                                .accessory = acc,
+                                                                .completionToken = readContext->completionToken },
                     &data_buffer->data[data_buffer->position],
                     data_buffer->limit - data_buffer->position,
                     &sval_length,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
-                if (sval_length <= data_buffer->limit - data_buffer->position) {
+                if (util_base64_encoded_len(sval_length) < data_buffer->limit - data_buffer->position) {
                     util_base64_encode(
                             &data_buffer->data[data_buffer->position],
                             sval_length,
@@ -1566,7 +3147,8 @@ static void handle_characteristic_read_request(
                                                                 .session = &session->securitySession._.hap,
                                                                 .characteristic = (const HAPBoolCharacteristic*) chr,
                                                                 .service = svc,
-                                                                .accessory = acc },
+                                                                .accessory = acc,
+                                                                .completionToken = readContext->completionToken },
                     &bool_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
@@ -1581,7 +3163,8 @@ static void handle_characteristic_read_request(
                                                                  .session = &session->securitySession._.hap,
                                                                  .characteristic = (const HAPUInt8Characteristic*) chr,
                                                                  .service = svc,
-                                                                 .accessory = acc },
+                                                                 .accessory = acc,
+                                                                 .completionToken = readContext->completionToken },
                     &uint8_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
@@ -1597,7 +3180,8 @@ static void handle_characteristic_read_request(
                                                                   .characteristic =
                                                                           (const HAPUInt16Characteristic*) chr,
                                                                   .service = svc,
-                                                                  .accessory = acc },
+                                                                  .accessory = acc,
+                                                                  .completionToken = readContext->completionToken },
                     &uint16_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
@@ -1613,7 +3197,8 @@ static void handle_characteristic_read_request(
                                                                   .characteristic =
                                                                           (const HAPUInt32Characteristic*) chr,
                                                                   .service = svc,
-                                                                  .accessory = acc },
+                                                                  .accessory = acc,
+                                                                  .completionToken = readContext->completionToken },
                     &uint32_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
@@ -1629,7 +3214,8 @@ static void handle_characteristic_read_request(
                                                                   .characteristic =
                                                                           (const HAPUInt64Characteristic*) chr,
                                                                   .service = svc,
-                                                                  .accessory = acc },
+                                                                  .accessory = acc,
+                                                                  .completionToken = readContext->completionToken },
                     &uint64_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
@@ -1644,7 +3230,8 @@ static void handle_characteristic_read_request(
                                                                .session = &session->securitySession._.hap,
                                                                .characteristic = (const HAPIntCharacteristic*) chr,
                                                                .service = svc,
-                                                               .accessory = acc },
+                                                               .accessory = acc,
+                                                               .completionToken = readContext->completionToken },
                     &int_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
@@ -1659,7 +3246,8 @@ static void handle_characteristic_read_request(
                                                                  .session = &session->securitySession._.hap,
                                                                  .characteristic = (const HAPFloatCharacteristic*) chr,
                                                                  .service = svc,
-                                                                 .accessory = acc },
+                                                                 .accessory = acc,
+                                                                 .completionToken = readContext->completionToken },
                     &float_val,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
@@ -1675,7 +3263,8 @@ static void handle_characteristic_read_request(
                                                                   .characteristic =
                                                                           (const HAPStringCharacteristic*) chr,
                                                                   .service = svc,
-                                                                  .accessory = acc },
+                                                                  .accessory = acc,
+                                                                  .completionToken = readContext->completionToken },
                     &data_buffer->data[data_buffer->position],
                     data_buffer->limit - data_buffer->position,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
@@ -1703,12 +3292,14 @@ static void handle_characteristic_read_request(
                                                                 .session = &session->securitySession._.hap,
                                                                 .characteristic = (const HAPTLV8Characteristic*) chr,
                                                                 .service = svc,
-                                                                .accessory = acc },
+                                                                .accessory = acc,
+                                                                .completionToken = readContext->completionToken },
                     &tlv8_writer,
                     HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
             readContext->status = ConvertCharacteristicReadErrorToStatusCode(err);
             if (readContext->status == kHAPIPAccessoryServerStatusCode_Success) {
-                if (((HAPTLVWriter*) &tlv8_writer)->numBytes <= data_buffer->limit - data_buffer->position) {
+                if (util_base64_encoded_len(((HAPTLVWriter*) &tlv8_writer)->numBytes) <
+                    data_buffer->limit - data_buffer->position) {
                     util_base64_encode(
                             &data_buffer->data[data_buffer->position],
                             ((HAPTLVWriter*) &tlv8_writer)->numBytes,
@@ -1752,12 +3343,13 @@ static int handle_characteristic_read_requests(
     const HAPCharacteristic* c;
     const HAPService* svc;
     const HAPAccessory* acc;
+    HAPTypeID chrTypeID;
     HAPAssert(contexts);
     r = 0;
     for (i = 0; i < contexts_count; i++) {
         HAPIPReadContext* readContext = (HAPIPReadContext*) &contexts[i];
 
-        get_db_ctx(session->server, readContext->aid, readContext->iid, &c, &svc, &acc);
+        get_db_ctx(session->server, readContext->aid, readContext->iid, &c, &svc, &acc, &chrTypeID);
         if (c) {
             const HAPBaseCharacteristic* chr = c;
             HAPAssert(chr->iid == readContext->iid);
@@ -1778,7 +3370,7 @@ static int handle_characteristic_read_requests(
                 HAPSessionControllerIsAdmin(&session->securitySession._.hap)) {
                 if (chr->properties.readable) {
                     if ((session_context != kHAPIPSessionContext_EventNotification) &&
-                        HAPUUIDAreEqual(chr->characteristicType, &kHAPCharacteristicType_ProgrammableSwitchEvent)) {
+                        chrTypeID == kHAPCharacteristicTypeID_ProgrammableSwitchEvent) {
                         // A read of this characteristic must always return a null value for IP accessories.
                         // See HomeKit Accessory Protocol Specification R14
                         // Section 9.75 Programmable Switch Event
@@ -1808,6 +3400,382 @@ static int handle_characteristic_read_requests(
     return r;
 }
 
+static void handle_chunked_response(HAPIPSessionDescriptor* session);
+
+/**
+ * Appends the remainder of a JSON fragment of a streaming read response.
+ *
+ * @param      session              IP session descriptor.
+ * @param      fragment             JSON fragment.
+ * @param      bytes                Buffer.
+ * @param      maxBytes             Capacity of buffer.
+ * @param[in,out] numBytes          Number of bytes in buffer.
+ *
+ * @return true                     If the fragment has been serialized completely.
+ * @return false                    Otherwise (buffer is full).
+ */
+HAP_RESULT_USE_CHECK
+static bool AppendStreamingReadFragment(
+        HAPIPSessionDescriptor* session,
+        const char* fragment,
+        char* bytes,
+        size_t maxBytes,
+        size_t* numBytes) {
+    HAPPrecondition(session);
+    HAPPrecondition(fragment);
+    HAPPrecondition(bytes);
+    HAPPrecondition(numBytes);
+    HAPPrecondition(*numBytes <= maxBytes);
+
+    size_t numFragmentBytes = HAPStringGetNumBytes(fragment);
+    HAPAssert(session->streamingRead.numSerializedBytes <= numFragmentBytes);
+    size_t n = HAPMin(numFragmentBytes - session->streamingRead.numSerializedBytes, maxBytes - *numBytes);
+    HAPRawBufferCopyBytes(&bytes[*numBytes], &fragment[session->streamingRead.numSerializedBytes], n);
+    *numBytes += n;
+    session->streamingRead.numSerializedBytes += n;
+    if (session->streamingRead.numSerializedBytes < numFragmentBytes) {
+        return false;
+    }
+    session->streamingRead.numSerializedBytes = 0;
+    return true;
+}
+
+/**
+ * Serializes the next part of the body of a streaming read response.
+ *
+ * - The body is identical to the one of a regular GET /characteristics response reading a single Data characteristic.
+ * - Value chunks are read from the streaming read handler directly into the buffer and base64 encoded in place.
+ *
+ * @param      session              IP session descriptor.
+ * @param[out] bytes                Buffer.
+ * @param      minBytes             Minimum number of bytes to serialize unless the body is complete.
+ * @param      maxBytes             Capacity of buffer.
+ * @param[out] numBytes             Number of bytes serialized.
+ */
+static void SerializeStreamingReadResponse(
+        HAPIPSessionDescriptor* session,
+        char* bytes,
+        size_t minBytes,
+        size_t maxBytes,
+        size_t* numBytes) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(session->streamingRead.characteristic);
+    HAPPrecondition(session->streamingRead.service);
+    HAPPrecondition(session->streamingRead.accessory);
+    HAPPrecondition(bytes);
+    HAPPrecondition(minBytes <= maxBytes);
+    HAPPrecondition(numBytes);
+
+    HAPError err;
+
+    *numBytes = 0;
+    while ((*numBytes < minBytes) && (session->streamingRead.state == kHAPIPStreamingReadState_Prefix ||
+                                      session->streamingRead.state == kHAPIPStreamingReadState_Value ||
+                                      session->streamingRead.state == kHAPIPStreamingReadState_Suffix)) {
+        switch (session->streamingRead.state) {
+            case kHAPIPStreamingReadState_Prefix: {
+                char aidDescription[64];
+                err = HAPUInt64GetDescription(
+                        session->streamingRead.accessory->aid, aidDescription, sizeof aidDescription);
+                HAPAssert(!err);
+                char iidDescription[64];
+                err = HAPUInt64GetDescription(
+                        session->streamingRead.characteristic->iid, iidDescription, sizeof iidDescription);
+                HAPAssert(!err);
+                char prefix[sizeof "{\"characteristics\":[{\"aid\":,\"iid\":,\"value\":\"" + 2 * 64];
+                err = HAPStringWithFormat(
+                        prefix,
+                        sizeof prefix,
+                        "{\"characteristics\":[{\"aid\":%s,\"iid\":%s,\"value\":\"",
+                        aidDescription,
+                        iidDescription);
+                HAPAssert(!err);
+                if (AppendStreamingReadFragment(session, prefix, bytes, maxBytes, numBytes)) {
+                    session->streamingRead.state = kHAPIPStreamingReadState_Value;
+                }
+            } break;
+            case kHAPIPStreamingReadState_Value: {
+                // Flush an encoded group that did not fit into the buffer before.
+                if (session->streamingRead.numEncodedBytes) {
+                    size_t n = HAPMin(session->streamingRead.numEncodedBytes, maxBytes - *numBytes);
+                    HAPRawBufferCopyBytes(&bytes[*numBytes], session->streamingRead.encodedBytes, n);
+                    *numBytes += n;
+                    session->streamingRead.numEncodedBytes -= (uint8_t) n;
+                    HAPRawBufferCopyBytes(
+                            session->streamingRead.encodedBytes,
+                            &session->streamingRead.encodedBytes[n],
+                            session->streamingRead.numEncodedBytes);
+                    break;
+                }
+                if (session->streamingRead.isValueComplete) {
+                    HAPAssert(!session->streamingRead.numPendingBytes);
+                    session->streamingRead.state = kHAPIPStreamingReadState_Suffix;
+                    break;
+                }
+
+                // Read as many base64 groups as are needed to reach the minimum length and fit into the buffer.
+                // If not even a single group fits, it is encoded separately and serialized partially.
+                uint8_t groupBytes[3];
+                uint8_t* valueBytes;
+                size_t numGroups = HAPMin((minBytes - *numBytes + 3) / 4, (maxBytes - *numBytes) / 4);
+                if (numGroups) {
+                    valueBytes = (uint8_t*) &bytes[*numBytes];
+                } else {
+                    valueBytes = groupBytes;
+                    numGroups = 1;
+                }
+                size_t numPendingBytes = session->streamingRead.numPendingBytes;
+                HAPRawBufferCopyBytes(valueBytes, session->streamingRead.pendingBytes, numPendingBytes);
+                size_t numValueBytes;
+                bool isComplete;
+                err = HAPDataCharacteristicHandleReadChunk(
+                        HAPNonnull(session->server),
+                        &(const HAPDataCharacteristicReadRequest) {
+                                .transportType = kHAPTransportType_IP,
+                                .session = &session->securitySession._.hap,
+                                .characteristic = HAPNonnull(session->streamingRead.characteristic),
+                                .service = HAPNonnull(session->streamingRead.service),
+                                .accessory = HAPNonnull(session->streamingRead.accessory) },
+                        session->streamingRead.offset,
+                        &valueBytes[numPendingBytes],
+                        numGroups * 3 - numPendingBytes,
+                        &numValueBytes,
+                        &isComplete,
+                        HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
+                if (err) {
+                    HAPLogCharacteristic(
+                            &logObject,
+                            session->streamingRead.characteristic,
+                            session->streamingRead.service,
+                            session->streamingRead.accessory,
+                            "Streaming read failed after %zu bytes. Aborting response.",
+                            session->streamingRead.offset);
+                    session->streamingRead.state = kHAPIPStreamingReadState_Aborted;
+                    break;
+                }
+                session->streamingRead.offset += numValueBytes;
+                size_t numBytesToEncode = numPendingBytes + numValueBytes;
+                if (!isComplete) {
+                    session->streamingRead.numPendingBytes = (uint8_t)(numBytesToEncode % 3);
+                    numBytesToEncode -= session->streamingRead.numPendingBytes;
+                    HAPRawBufferCopyBytes(
+                            session->streamingRead.pendingBytes,
+                            &valueBytes[numBytesToEncode],
+                            session->streamingRead.numPendingBytes);
+                } else {
+                    session->streamingRead.numPendingBytes = 0;
+                    session->streamingRead.isValueComplete = true;
+                }
+                size_t numEncodedBytes;
+                if (valueBytes == groupBytes) {
+                    util_base64_encode(
+                            groupBytes,
+                            numBytesToEncode,
+                            session->streamingRead.encodedBytes,
+                            sizeof session->streamingRead.encodedBytes,
+                            &numEncodedBytes);
+                    session->streamingRead.numEncodedBytes = (uint8_t) numEncodedBytes;
+                } else {
+                    util_base64_encode(
+                            valueBytes, numBytesToEncode, &bytes[*numBytes], maxBytes - *numBytes, &numEncodedBytes);
+                    HAPAssert(numEncodedBytes <= maxBytes - *numBytes);
+                    *numBytes += numEncodedBytes;
+                }
+            } break;
+            case kHAPIPStreamingReadState_Suffix: {
+                if (AppendStreamingReadFragment(session, "\"}]}", bytes, maxBytes, numBytes)) {
+                    HAPLogCharacteristicInfo(
+                            &logObject,
+                            session->streamingRead.characteristic,
+                            session->streamingRead.service,
+                            session->streamingRead.accessory,
+                            "Streamed %zu bytes.",
+                            session->streamingRead.offset);
+                    session->streamingRead.state = kHAPIPStreamingReadState_Complete;
+                }
+            } break;
+            case kHAPIPStreamingReadState_Idle:
+            case kHAPIPStreamingReadState_Complete:
+            case kHAPIPStreamingReadState_Aborted: {
+                HAPFatalError();
+            }
+        }
+    }
+}
+
+/**
+ * Starts a streaming read response if a GET /characteristics request reads a single Data characteristic
+ * that supports streaming reads.
+ *
+ * - The first part of the value is read before the response is started so that errors can still be reported
+ *   with a regular response. In that case, the regular read path is used.
+ *
+ * @param      session              IP session descriptor.
+ * @param      readContexts         Read contexts.
+ * @param      numReadContexts      Number of read contexts.
+ * @param      parameters           Read request parameters.
+ *
+ * @return true                     If a streaming read response has been started.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool begin_streaming_read(
+        HAPIPSessionDescriptor* session,
+        HAPIPReadContextRef* readContexts,
+        size_t numReadContexts,
+        const HAPIPReadRequestParameters* parameters) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPPrecondition(readContexts);
+    HAPPrecondition(parameters);
+    HAPPrecondition(!session->chunkedResponseIsInProgress);
+
+    HAPError err;
+
+    if (numReadContexts != 1 || parameters->meta || parameters->perms || parameters->type || parameters->ev) {
+        return false;
+    }
+    HAPIPReadContext* readContext = (HAPIPReadContext*) &readContexts[0];
+    const HAPCharacteristic* c;
+    const HAPService* svc;
+    const HAPAccessory* acc;
+    get_db_ctx(session->server, readContext->aid, readContext->iid, &c, &svc, &acc, /* characteristicTypeID: */ NULL);
+    if (!c) {
+        return false;
+    }
+    const HAPBaseCharacteristic* chr = c;
+    if (chr->format != kHAPCharacteristicFormat_Data || !chr->properties.readable ||
+        !((const HAPDataCharacteristic*) chr)->callbacks.handleReadChunk ||
+        (HAPCharacteristicReadRequiresAdminPermissions(chr) &&
+         !HAPSessionControllerIsAdmin(&session->securitySession._.hap))) {
+        return false;
+    }
+
+    HAPRawBufferZero(&session->streamingRead, sizeof session->streamingRead);
+    session->streamingRead.characteristic = (const HAPDataCharacteristic*) chr;
+    session->streamingRead.service = svc;
+    session->streamingRead.accessory = acc;
+
+    // Read the first part of the value. It is kept as pending bytes until the response body is serialized.
+    size_t numValueBytes;
+    bool isComplete;
+    err = HAPDataCharacteristicHandleReadChunk(
+            HAPNonnull(session->server),
+            &(const HAPDataCharacteristicReadRequest) { .transportType = kHAPTransportType_IP,
+                                                        .session = &session->securitySession._.hap,
+                                                        .characteristic = (const HAPDataCharacteristic*) chr,
+                                                        .service = svc,
+                                                        .accessory = acc },
+            /* offset: */ 0,
+            session->streamingRead.pendingBytes,
+            sizeof session->streamingRead.pendingBytes,
+            &numValueBytes,
+            &isComplete,
+            HAPAccessoryServerGetClientContext(HAPNonnull(session->server)));
+    if (err) {
+        HAPRawBufferZero(&session->streamingRead, sizeof session->streamingRead);
+        return false;
+    }
+    session->streamingRead.offset = numValueBytes;
+    if (isComplete) {
+        // Encode the short value right away. It always fits into a single base64 group.
+        util_base64_encode(
+                session->streamingRead.pendingBytes,
+                numValueBytes,
+                session->streamingRead.encodedBytes,
+                sizeof session->streamingRead.encodedBytes,
+                &numValueBytes);
+        session->streamingRead.numEncodedBytes = (uint8_t) numValueBytes;
+        session->streamingRead.isValueComplete = true;
+    } else {
+        session->streamingRead.numPendingBytes = (uint8_t) numValueBytes;
+    }
+    session->streamingRead.state = kHAPIPStreamingReadState_Prefix;
+
+    HAPLogCharacteristicInfo(
+            &logObject,
+            session->streamingRead.characteristic,
+            session->streamingRead.service,
+            session->streamingRead.accessory,
+            "Streaming read.");
+    err = HAPIPByteBufferAppendStringWithFormat(
+            &session->outboundBuffer,
+            "HTTP/1.1 200 OK\r\n"
+            "Transfer-Encoding: chunked\r\n"
+            "Content-Type: application/hap+json\r\n\r\n");
+    HAPAssert(!err);
+    handle_chunked_response(session);
+    return true;
+}
+
+/**
+ * Saves the read contexts of a GET /characteristics request whose read handlers complete asynchronously.
+ *
+ * - The read contexts and the values in the scratch buffer are copied into the unused space of the outbound buffer of
+ *   the session, as other sessions may use the read contexts and the scratch buffer while the reads are pending.
+ *
+ * @param      session              IP session descriptor.
+ * @param      contexts             Read contexts.
+ * @param      numContexts          Length of @p contexts.
+ * @param      dataBuffer           Scratch buffer containing the values of the read contexts.
+ *
+ * @return true                     If the read contexts have been saved.
+ * @return false                    If the outbound buffer is too small.
+ */
+HAP_RESULT_USE_CHECK
+static bool save_read_contexts(
+        HAPIPSessionDescriptor* session,
+        const HAPIPReadContextRef* contexts,
+        size_t numContexts,
+        const HAPIPByteBuffer* dataBuffer) {
+    HAPPrecondition(session);
+    HAPPrecondition(contexts);
+    HAPPrecondition(numContexts);
+    HAPPrecondition(dataBuffer);
+
+    size_t numContextBytes = numContexts * sizeof *contexts;
+    size_t numFreeBytes = session->outboundBuffer.limit - session->outboundBuffer.position;
+    if (numContextBytes > numFreeBytes || dataBuffer->position > numFreeBytes - numContextBytes) {
+        return false;
+    }
+    char* bytes = &session->outboundBuffer.data[session->outboundBuffer.position];
+    HAPRawBufferCopyBytes(bytes, contexts, numContextBytes);
+    HAPRawBufferCopyBytes(&bytes[numContextBytes], dataBuffer->data, dataBuffer->position);
+    session->pendingRequest.numReadContexts = numContexts;
+    session->pendingRequest.numReadValueBytes = dataBuffer->position;
+    return true;
+}
+
+/**
+ * Restores the read contexts of a GET /characteristics request that have been saved while reads were pending.
+ *
+ * - The values are copied back to the beginning of the scratch buffer so that the read contexts refer to them again.
+ *
+ * @param      session              IP session descriptor.
+ * @param      contexts             Read contexts.
+ * @param      numContexts          Length of @p contexts.
+ * @param      dataBuffer           Scratch buffer.
+ */
+static void restore_read_contexts(
+        HAPIPSessionDescriptor* session,
+        HAPIPReadContextRef* contexts,
+        size_t numContexts,
+        HAPIPByteBuffer* dataBuffer) {
+    HAPPrecondition(session);
+    HAPPrecondition(contexts);
+    HAPPrecondition(numContexts == session->pendingRequest.numReadContexts);
+    HAPPrecondition(dataBuffer);
+    HAPPrecondition(!dataBuffer->position);
+
+    size_t numContextBytes = numContexts * sizeof *contexts;
+    const char* bytes = &session->outboundBuffer.data[session->outboundBuffer.position];
+    HAPRawBufferCopyBytes(contexts, bytes, numContextBytes);
+    HAPAssert(session->pendingRequest.numReadValueBytes <= dataBuffer->limit);
+    HAPRawBufferCopyBytes(dataBuffer->data, &bytes[numContextBytes], session->pendingRequest.numReadValueBytes);
+    dataBuffer->position = session->pendingRequest.numReadValueBytes;
+}
+
 static void get_characteristics(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
@@ -1826,7 +3794,7 @@ static void get_characteristics(HAPIPSessionDescriptor* session) {
 
     HAPAssert(
             (session->httpURI.numBytes >= 16) &&
-            HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/characteristics", 16));
+            HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/characteristics", 16));
     if ((session->httpURI.numBytes >= 17) && (session->httpURI.bytes[16] == '?')) {
         err = HAPIPAccessoryProtocolGetCharacteristicReadRequests(
                 &session->httpURI.bytes[17],
@@ -1838,6 +3806,8 @@ static void get_characteristics(HAPIPSessionDescriptor* session) {
         if (!err) {
             if (contexts_count == 0) {
                 write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
+            } else if (begin_streaming_read(session, server->ip.storage->readContexts, contexts_count, &parameters)) {
+                // Response is streamed using chunked transfer encoding.
             } else {
                 data_buffer.data = server->ip.storage->scratchBuffer.bytes;
                 data_buffer.capacity = server->ip.storage->scratchBuffer.numBytes;
@@ -1846,12 +3816,65 @@ static void get_characteristics(HAPIPSessionDescriptor* session) {
                 HAPAssert(data_buffer.data);
                 HAPAssert(data_buffer.position <= data_buffer.limit);
                 HAPAssert(data_buffer.limit <= data_buffer.capacity);
-                r = handle_characteristic_read_requests(
-                        session,
-                        kHAPIPSessionContext_GetCharacteristics,
-                        server->ip.storage->readContexts,
-                        contexts_count,
-                        &data_buffer);
+                if (session->pendingRequest.numReadContexts) {
+                    // Resume request after the pending reads have been completed or cancelled.
+                    HAPAssert(!session->pendingRequest.numPendingReads);
+                    restore_read_contexts(session, server->ip.storage->readContexts, contexts_count, &data_buffer);
+                    r = 0;
+                    for (size_t i = 0; i < contexts_count; i++) {
+                        const HAPIPReadContext* readContext =
+                                (const HAPIPReadContext*) &server->ip.storage->readContexts[i];
+                        if (readContext->status != kHAPIPAccessoryServerStatusCode_Success) {
+                            r = -1;
+                        }
+                    }
+                    HAPRawBufferZero(&session->pendingRequest, sizeof session->pendingRequest);
+                } else {
+                    // Read handlers may only complete asynchronously if the read contexts can be saved.
+                    session->handlersMayCompleteAsynchronously =
+                            contexts_count * sizeof *server->ip.storage->readContexts <=
+                            session->outboundBuffer.limit - session->outboundBuffer.position;
+                    r = handle_characteristic_read_requests(
+                            session,
+                            kHAPIPSessionContext_GetCharacteristics,
+                            server->ip.storage->readContexts,
+                            contexts_count,
+                            &data_buffer);
+                    session->handlersMayCompleteAsynchronously = false;
+                    size_t numPendingReads = 0;
+                    for (size_t i = 0; i < contexts_count; i++) {
+                        const HAPIPReadContext* readContext =
+                                (const HAPIPReadContext*) &server->ip.storage->readContexts[i];
+                        if (readContext->status == kHAPIPAccessoryServerStatusCode_InProgress) {
+                            numPendingReads++;
+                        }
+                    }
+                    if (numPendingReads) {
+                        if (save_read_contexts(
+                                    session, server->ip.storage->readContexts, contexts_count, &data_buffer)) {
+                            // Values of pending reads are added to the saved read contexts once they are completed.
+                            HAPLogDebug(
+                                    &logObject,
+                                    "session:%p:waiting for %lu reads to complete",
+                                    (const void*) session,
+                                    (unsigned long) numPendingReads);
+                            session->pendingRequest.numPendingReads = numPendingReads;
+                            enter_waiting_state(session);
+                            return;
+                        }
+                        HAPLog(&logObject, "Outbound buffer too small to wait for pending reads. Reporting as busy.");
+                        for (size_t i = 0; i < contexts_count; i++) {
+                            HAPIPReadContext* readContext = (HAPIPReadContext*) &server->ip.storage->readContexts[i];
+                            if (readContext->status == kHAPIPAccessoryServerStatusCode_InProgress) {
+                                readContext->status = kHAPIPAccessoryServerStatusCode_ResourceIsBusy;
+                                if (server->callbacks.handleCancelledRequest) {
+                                    server->callbacks.handleCancelledRequest(
+                                            session->server, readContext->completionToken, server->context);
+                                }
+                            }
+                        }
+                    }
+                }
                 content_length = HAPIPAccessoryProtocolGetNumCharacteristicReadResponseBytes(
                         HAPNonnull(session->server), server->ip.storage->readContexts, contexts_count, &parameters);
                 HAPAssert(session->outboundBuffer.data);
@@ -1904,7 +3927,26 @@ static void get_characteristics(HAPIPSessionDescriptor* session) {
     }
 }
 
-static void handle_accessory_serialization(HAPIPSessionDescriptor* session) {
+/**
+ * Returns whether the body of the chunked response of a session has been serialized completely.
+ *
+ * @param      session              IP session descriptor.
+ *
+ * @return true                     If the body has been serialized completely or if a streaming read was aborted.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool chunked_response_is_complete(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+
+    if (session->streamingRead.state != kHAPIPStreamingReadState_Idle) {
+        return session->streamingRead.state == kHAPIPStreamingReadState_Complete ||
+               session->streamingRead.state == kHAPIPStreamingReadState_Aborted;
+    }
+    return HAPIPAccessorySerializationIsComplete(&session->accessorySerializationContext);
+}
+
+static void handle_chunked_response(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
     HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
@@ -1917,7 +3959,7 @@ static void handle_accessory_serialization(HAPIPSessionDescriptor* session) {
     HAPAssert(session->outboundBuffer.data);
     HAPAssert(session->outboundBuffer.capacity);
 
-    if (session->accessorySerializationIsInProgress) {
+    if (session->chunkedResponseIsInProgress) {
         HAPAssert(session->outboundBuffer.position == session->outboundBuffer.limit);
         if (session->securitySession.isSecured) {
             HAPAssert(session->outboundBuffer.limit <= session->outboundBufferMark);
@@ -1941,55 +3983,70 @@ static void handle_accessory_serialization(HAPIPSessionDescriptor* session) {
 
     if ((session->outboundBuffer.position < session->outboundBuffer.limit) &&
         (session->outboundBuffer.position < kHAPIPSecurityProtocol_MaxFrameBytes) &&
-        !HAPIPAccessorySerializationIsComplete(&session->accessorySerializationContext)) {
+        !chunked_response_is_complete(session)) {
         size_t numBytesSerialized;
         size_t maxBytes = session->outboundBuffer.limit - session->outboundBuffer.position;
         size_t minBytes =
                 kHAPIPSecurityProtocol_MaxFrameBytes < maxBytes ? kHAPIPSecurityProtocol_MaxFrameBytes : maxBytes;
-        err = HAPIPAccessorySerializeReadResponse(
-                &session->accessorySerializationContext,
-                HAPNonnull(session->server),
-                (HAPIPSessionDescriptorRef*) session,
-                &session->outboundBuffer.data[session->outboundBuffer.position],
-                minBytes,
-                maxBytes,
-                &numBytesSerialized);
-        if (err) {
-            HAPAssert(err == kHAPError_OutOfResources);
-            HAPLogError(&logObject, "Invalid configuration (outbound buffer too small).");
-            HAPFatalError();
+        if (session->streamingRead.state != kHAPIPStreamingReadState_Idle) {
+            SerializeStreamingReadResponse(
+                    session,
+                    &session->outboundBuffer.data[session->outboundBuffer.position],
+                    minBytes,
+                    maxBytes,
+                    &numBytesSerialized);
+        } else {
+            err = HAPIPAccessorySerializeReadResponse(
+                    &session->accessorySerializationContext,
+                    HAPNonnull(session->server),
+                    (HAPIPSessionDescriptorRef*) session,
+                    &session->outboundBuffer.data[session->outboundBuffer.position],
+                    minBytes,
+                    maxBytes,
+                    &numBytesSerialized);
+            if (err) {
+                HAPAssert(err == kHAPError_OutOfResources);
+                HAPLogError(&logObject, "Invalid configuration (outbound buffer too small).");
+                HAPFatalError();
+            }
         }
-        HAPAssert(numBytesSerialized > 0);
+        bool isAborted = session->streamingRead.state == kHAPIPStreamingReadState_Aborted;
+        HAPAssert((numBytesSerialized > 0) || isAborted);
         HAPAssert(numBytesSerialized <= maxBytes);
-        HAPAssert(
-                (numBytesSerialized >= minBytes) ||
-                HAPIPAccessorySerializationIsComplete(&session->accessorySerializationContext));
+        HAPAssert((numBytesSerialized >= minBytes) || chunked_response_is_complete(session));
 
         // maxProtocolBytes = max(8, size_t represented in HEX + '\r' + '\n' + '\0')
         char protocolBytes[HAPMax(8, sizeof(size_t) * 2 + 2 + 1)];
 
-        err = HAPStringWithFormat(protocolBytes, sizeof protocolBytes, "%zX\r\n", numBytesSerialized);
-        HAPAssert(!err);
-        size_t numProtocolBytes = HAPStringGetNumBytes(protocolBytes);
+        size_t numProtocolBytes;
+        if (numBytesSerialized) {
+            err = HAPStringWithFormat(protocolBytes, sizeof protocolBytes, "%zX\r\n", numBytesSerialized);
+            HAPAssert(!err);
+            numProtocolBytes = HAPStringGetNumBytes(protocolBytes);
 
-        if (numProtocolBytes > session->outboundBuffer.limit - session->outboundBuffer.position) {
-            HAPLogError(&logObject, "Invalid configuration (outbound buffer too small).");
-            HAPFatalError();
-        }
-        if (numBytesSerialized > session->outboundBuffer.limit - session->outboundBuffer.position - numProtocolBytes) {
-            HAPLogError(&logObject, "Invalid configuration (outbound buffer too small).");
-            HAPFatalError();
-        }
+            if (numProtocolBytes > session->outboundBuffer.limit - session->outboundBuffer.position) {
+                HAPLogError(&logObject, "Invalid configuration (outbound buffer too small).");
+                HAPFatalError();
+            }
+            if (numBytesSerialized >
+                session->outboundBuffer.limit - session->outboundBuffer.position - numProtocolBytes) {
+                HAPLogError(&logObject, "Invalid configuration (outbound buffer too small).");
+                HAPFatalError();
+            }
 
-        HAPRawBufferCopyBytes(
-                &session->outboundBuffer.data[session->outboundBuffer.position + numProtocolBytes],
-                &session->outboundBuffer.data[session->outboundBuffer.position],
-                numBytesSerialized);
-        HAPRawBufferCopyBytes(
-                &session->outboundBuffer.data[session->outboundBuffer.position], protocolBytes, numProtocolBytes);
-        session->outboundBuffer.position += numProtocolBytes + numBytesSerialized;
+            HAPRawBufferCopyBytes(
+                    &session->outboundBuffer.data[session->outboundBuffer.position + numProtocolBytes],
+                    &session->outboundBuffer.data[session->outboundBuffer.position],
+                    numBytesSerialized);
+            HAPRawBufferCopyBytes(
+                    &session->outboundBuffer.data[session->outboundBuffer.position], protocolBytes, numProtocolBytes);
+            session->outboundBuffer.position += numProtocolBytes + numBytesSerialized;
+        }
 
-        if (HAPIPAccessorySerializationIsComplete(&session->accessorySerializationContext)) {
+        if (isAborted) {
+            // The last chunk is omitted so that the controller cannot mistake the truncated value for a complete one.
+            err = HAPStringWithFormat(protocolBytes, sizeof protocolBytes, "%s", numBytesSerialized ? "\r\n" : "");
+        } else if (chunked_response_is_complete(session)) {
             err = HAPStringWithFormat(protocolBytes, sizeof protocolBytes, "\r\n0\r\n\r\n");
         } else {
             err = HAPStringWithFormat(protocolBytes, sizeof protocolBytes, "\r\n");
@@ -2056,9 +4113,15 @@ static void handle_accessory_serialization(HAPIPSessionDescriptor* session) {
 
         session->state = kHAPIPSessionState_Writing;
 
-        session->accessorySerializationIsInProgress = true;
+        session->chunkedResponseIsInProgress = true;
+    } else if (session->streamingRead.state == kHAPIPStreamingReadState_Aborted) {
+        HAPLog(&logObject, "Streaming read aborted, closing session.");
+        HAPRawBufferZero(&session->streamingRead, sizeof session->streamingRead);
+        session->chunkedResponseIsInProgress = false;
+        CloseSession(session);
     } else {
-        session->accessorySerializationIsInProgress = false;
+        HAPRawBufferZero(&session->streamingRead, sizeof session->streamingRead);
+        session->chunkedResponseIsInProgress = false;
 
         session->state = kHAPIPSessionState_Reading;
         prepare_reading_request(session);
@@ -2075,7 +4138,7 @@ static void get_accessories(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session->securitySession.isOpen);
     HAPPrecondition(session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled);
     HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
-    HAPPrecondition(!session->accessorySerializationIsInProgress);
+    HAPPrecondition(!session->chunkedResponseIsInProgress);
 
     HAPError err;
 
@@ -2089,8 +4152,8 @@ static void get_accessories(HAPIPSessionDescriptor* session) {
             "Content-Type: application/hap+json\r\n\r\n");
     HAPAssert(!err);
 
-    HAPIPAccessoryCreateSerializationContext(&session->accessorySerializationContext);
-    handle_accessory_serialization(session);
+    HAPIPAccessoryCreateSerializationContext(&session->accessorySerializationContext, HAPNonnull(session->server));
+    handle_chunked_response(session);
 }
 
 static void handle_pairing_data(
@@ -2168,16 +4231,18 @@ static void handle_pairing_data(
                                     p_tlv8_buffer,
                                     tlv8_length);
                             session->outboundBuffer.position += tlv8_length;
-                            for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-                                HAPIPSession* ipSession = &server->ip.storage->sessions[i];
+                            HAPIPSession* _Nullable nextIPSession = server->ip.sessionLists.openSessions.first;
+                            while (nextIPSession) {
+                                HAPIPSession* ipSession = HAPNonnull(nextIPSession);
+                                nextIPSession = GetNextSessionOfList(ipSession, kHAPIPSessionListKind_Slot);
                                 HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-                                if (!t->server) {
-                                    continue;
-                                }
+                                HAPAssert(t->server);
 
                                 // Other sessions whose pairing has been removed during the pairing session
                                 // need to be closed as soon as possible.
-                                if (t != session && t->state == kHAPIPSessionState_Reading &&
+                                if (t != session &&
+                                    (t->state == kHAPIPSessionState_Reading ||
+                                     t->state == kHAPIPSessionState_Waiting) &&
                                     t->securitySession.type == kHAPIPSecuritySessionType_HAP &&
                                     t->securitySession.isSecured && !HAPSessionIsSecured(&t->securitySession._.hap)) {
                                     HAPLogInfo(&logObject, "Closing other session whose pairing has been removed.");
@@ -2571,9 +4636,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
         HAPPrecondition(session->securitySession.type == kHAPIPSecuritySessionType_HAP);
 
         if ((session->httpURI.numBytes == 9) &&
-            HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/identify", 9)) {
+            HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/identify", 9)) {
             if ((session->httpMethod.numBytes == 4) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 if (!HAPAccessoryServerIsPaired(HAPNonnull(session->server))) {
                     identify_primary_accessory(session);
                 } else {
@@ -2584,17 +4649,17 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 11) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/pair-setup", 11)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/pair-setup", 11)) {
             if ((session->httpMethod.numBytes == 4) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 if (!session->securitySession.isSecured) {
                     // Close existing transient session.
-                    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-                        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
+                    HAPIPSession* _Nullable nextIPSession = server->ip.sessionLists.openSessions.first;
+                    while (nextIPSession) {
+                        HAPIPSession* ipSession = HAPNonnull(nextIPSession);
+                        nextIPSession = GetNextSessionOfList(ipSession, kHAPIPSessionListKind_Slot);
                         HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-                        if (!t->server) {
-                            continue;
-                        }
+                        HAPAssert(t->server);
                         // TODO Make this finish writing ongoing responses. Similar to Remove Pairing.
                         if (t != session && t->securitySession.type == kHAPIPSecuritySessionType_HAP &&
                             HAPSessionIsTransient(&t->securitySession._.hap)) {
@@ -2616,9 +4681,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 12) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/pair-verify", 12)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/pair-verify", 12)) {
             if ((session->httpMethod.numBytes == 4) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 if (!session->securitySession.isSecured) {
                     handle_pairing_data(session, HAPSessionHandlePairVerifyWrite, HAPSessionHandlePairVerifyRead);
                 } else {
@@ -2630,9 +4695,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 9) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/pairings", 9)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/pairings", 9)) {
             if ((session->httpMethod.numBytes == 4) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
                     if (!HAPSessionIsTransient(&session->securitySession._.hap)) {
                         handle_pairing_data(session, HAPSessionHandlePairingsWrite, HAPSessionHandlePairingsRead);
@@ -2657,9 +4722,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 15) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/secure-message", 15)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/secure-message", 15)) {
             if ((session->httpMethod.numBytes == 4) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
                     handle_secure_message(session);
                 } else {
@@ -2674,9 +4739,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 7) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/config", 7)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/config", 7)) {
             if ((session->httpMethod.numBytes == 4) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
                     if (!HAPSessionIsTransient(&session->securitySession._.hap)) {
                         HAPLog(&logObject, "Rejected POST /config: Session is not transient.");
@@ -2702,9 +4767,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 11) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/configured", 11)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/configured", 11)) {
             if ((session->httpMethod.numBytes == 4) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 HAPLog(&logObject, "Received unexpected /configured on _hap._tcp endpoint. Replying with success.");
                 write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_NoContent);
             } else {
@@ -2712,9 +4777,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 12) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/accessories", 12)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/accessories", 12)) {
             if ((session->httpMethod.numBytes == 3) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "GET", 3)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "GET", 3)) {
                 if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
                     if (!HAPSessionIsTransient(&session->securitySession._.hap)) {
                         get_accessories(session);
@@ -2741,9 +4806,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes >= 16) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/characteristics", 16)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/characteristics", 16)) {
             if ((session->httpMethod.numBytes == 3) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "GET", 3)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "GET", 3)) {
                 if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
                     if (!HAPSessionIsTransient(&session->securitySession._.hap)) {
                         get_characteristics(session);
@@ -2758,7 +4823,7 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
                 }
             } else if (
                     (session->httpMethod.numBytes == 3) &&
-                    HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "PUT", 3)) {
+                    HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "PUT", 3)) {
                 if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
                     if (!HAPSessionIsTransient(&session->securitySession._.hap)) {
                         put_characteristics(session);
@@ -2785,9 +4850,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 8) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/prepare", 8)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/prepare", 8)) {
             if ((session->httpMethod.numBytes == 3) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "PUT", 3)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "PUT", 3)) {
                 if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
                     if (!HAPSessionIsTransient(&session->securitySession._.hap)) {
                         put_prepare(session);
@@ -2814,9 +4879,9 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
             }
         } else if (
                 (session->httpURI.numBytes == 9) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpURI.bytes), "/resource", 9)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpURI.bytes), "/resource", 9)) {
             if ((session->httpMethod.numBytes == 4) &&
-                HAPRawBufferAreEqual(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
+                HAPRawBufferAreEqualPublic(HAPNonnull(session->httpMethod.bytes), "POST", 4)) {
                 if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
                     if (!HAPSessionIsTransient(&session->securitySession._.hap)) {
                         post_resource(session);
@@ -2861,18 +4926,67 @@ static void handle_http_request(HAPIPSessionDescriptor* session) {
     }
 }
 
+/**
+ * Finalizes the response in the outbound buffer, encrypts it and prepares the session for writing.
+ *
+ * @param      session              IP session.
+ */
+static void prepare_writing_response(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+
+    size_t encrypted_length;
+
+    HAPAssert(session->outboundBuffer.data);
+    HAPAssert(session->outboundBuffer.position <= session->outboundBuffer.limit);
+    HAPAssert(session->outboundBuffer.limit <= session->outboundBuffer.capacity);
+    HAPIPByteBufferFlip(&session->outboundBuffer);
+    HAPLogBufferDebug(
+            &logObject,
+            session->outboundBuffer.data,
+            session->outboundBuffer.limit,
+            "session:%p:<",
+            (const void*) session);
+
+    if (session->securitySession.type == kHAPIPSecuritySessionType_HAP && session->securitySession.isSecured) {
+        encrypted_length = HAPIPSecurityProtocolGetNumEncryptedBytes(
+                session->outboundBuffer.limit - session->outboundBuffer.position);
+        if (encrypted_length > session->outboundBuffer.capacity - session->outboundBuffer.position) {
+            HAPLog(&logObject, "Out of resources (outbound buffer too small).");
+            session->outboundBuffer.limit = session->outboundBuffer.capacity;
+            write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_OutOfResources);
+            HAPIPByteBufferFlip(&session->outboundBuffer);
+            encrypted_length = HAPIPSecurityProtocolGetNumEncryptedBytes(
+                    session->outboundBuffer.limit - session->outboundBuffer.position);
+            HAPAssert(encrypted_length <= session->outboundBuffer.capacity - session->outboundBuffer.position);
+        }
+        HAPIPSecurityProtocolEncryptData(
+                HAPNonnull(session->server), &session->securitySession._.hap, &session->outboundBuffer);
+        HAPAssert(encrypted_length == session->outboundBuffer.limit - session->outboundBuffer.position);
+    }
+    session->state = kHAPIPSessionState_Writing;
+}
+
 static void handle_http(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
     HAPPrecondition(session->securitySession.isOpen);
 
-    size_t content_length, encrypted_length;
+    size_t content_length;
     HAPAssert(session->inboundBuffer.data);
     HAPAssert(session->inboundBuffer.position <= session->inboundBuffer.limit);
     HAPAssert(session->inboundBuffer.limit <= session->inboundBuffer.capacity);
     HAPAssert(session->httpReaderPosition <= session->inboundBuffer.position);
     HAPAssert(session->httpReader.state == util_HTTP_READER_STATE_DONE);
     HAPAssert(!session->httpParserError);
+    if (session->streamingWrite.isActive) {
+        handle_streaming_write(session);
+        return;
+    }
+    if (!borrow_session_buffers(session)) {
+        wait_for_session_buffers(session);
+        return;
+    }
     if (session->httpContentLength.isDefined) {
         content_length = session->httpContentLength.value;
     } else {
@@ -2887,43 +5001,28 @@ static void handle_http(HAPIPSessionDescriptor* session) {
                 "session:%p:>",
                 (const void*) session);
         handle_http_request(session);
+        if (session->state == kHAPIPSessionState_Waiting) {
+            // The request is kept in the inbound buffer until the session is resumed.
+            if (!session->streamingWrite.isActive) {
+                return_session_buffers_while_waiting(session);
+            }
+            return;
+        }
         HAPIPByteBufferShiftLeft(&session->inboundBuffer, session->httpReaderPosition + content_length);
-        if (session->accessorySerializationIsInProgress) {
+        if (session->chunkedResponseIsInProgress) {
             // Session is already prepared for writing
             HAPAssert(session->outboundBuffer.data);
             HAPAssert(session->outboundBuffer.position <= session->outboundBuffer.limit);
             HAPAssert(session->outboundBuffer.limit <= session->outboundBuffer.capacity);
             HAPAssert(session->state == kHAPIPSessionState_Writing);
         } else {
-            HAPAssert(session->outboundBuffer.data);
-            HAPAssert(session->outboundBuffer.position <= session->outboundBuffer.limit);
-            HAPAssert(session->outboundBuffer.limit <= session->outboundBuffer.capacity);
-            HAPIPByteBufferFlip(&session->outboundBuffer);
-            HAPLogBufferDebug(
-                    &logObject,
-                    session->outboundBuffer.data,
-                    session->outboundBuffer.limit,
-                    "session:%p:<",
-                    (const void*) session);
-
-            if (session->securitySession.type == kHAPIPSecuritySessionType_HAP && session->securitySession.isSecured) {
-                encrypted_length = HAPIPSecurityProtocolGetNumEncryptedBytes(
-                        session->outboundBuffer.limit - session->outboundBuffer.position);
-                if (encrypted_length > session->outboundBuffer.capacity - session->outboundBuffer.position) {
-                    HAPLog(&logObject, "Out of resources (outbound buffer too small).");
-                    session->outboundBuffer.limit = session->outboundBuffer.capacity;
-                    write_msg(&session->outboundBuffer, kHAPIPAccessoryServerResponse_OutOfResources);
-                    HAPIPByteBufferFlip(&session->outboundBuffer);
-                    encrypted_length = HAPIPSecurityProtocolGetNumEncryptedBytes(
-                            session->outboundBuffer.limit - session->outboundBuffer.position);
-                    HAPAssert(encrypted_length <= session->outboundBuffer.capacity - session->outboundBuffer.position);
-                }
-                HAPIPSecurityProtocolEncryptData(
-                        HAPNonnull(session->server), &session->securitySession._.hap, &session->outboundBuffer);
-                HAPAssert(encrypted_length == session->outboundBuffer.limit - session->outboundBuffer.position);
-            }
-            session->state = kHAPIPSessionState_Writing;
+            prepare_writing_response(session);
         }
+    } else if (
+            (content_length > session->inboundBuffer.capacity - session->httpReaderPosition) &&
+            begin_streaming_write(session)) {
+        // The body does not fit into the inbound buffer. It is parsed while it is received.
+        handle_streaming_write(session);
     }
 }
 
@@ -3039,7 +5138,7 @@ static void read_http_content_type(HAPIPSessionDescriptor* session) {
     do { \
         size_t numContentTypeStringBytes = sizeof(contentTypeString) - 1; \
         if (session->httpHeaderFieldValue.numBytes - i >= numContentTypeStringBytes && \
-            HAPRawBufferAreEqual( \
+            HAPRawBufferAreEqualPublic( \
                     &session->httpHeaderFieldValue.bytes[i], (contentTypeString), numContentTypeStringBytes)) { \
             session->httpContentType = (contentType); \
             i += numContentTypeStringBytes; \
@@ -3076,6 +5175,47 @@ static void read_http_content_type(HAPIPSessionDescriptor* session) {
     }
 }
 
+/** Lower case name of the Content-Length header field. */
+#define kHTTPHeaderFieldName_ContentLength "content-length"
+
+/** Lower case name of the Content-Type header field. */
+#define kHTTPHeaderFieldName_ContentType "content-type"
+
+/**
+ * Checks whether an HTTP header field name matches a lower case header field name, ignoring case.
+ *
+ * @param      bytes                Header field name.
+ * @param      numBytes             Length of header field name.
+ * @param      lowercaseName        Lower case header field name to compare with.
+ * @param      numLowercaseNameBytes Length of lower case header field name.
+ *
+ * @return true                     If the header field names match.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool HTTPHeaderFieldNameIsEqual(
+        const char* bytes,
+        size_t numBytes,
+        const char* lowercaseName,
+        size_t numLowercaseNameBytes) {
+    HAPPrecondition(bytes);
+    HAPPrecondition(lowercaseName);
+
+    if (numBytes != numLowercaseNameBytes) {
+        return false;
+    }
+    for (size_t i = 0; i < numBytes; i++) {
+        char c = bytes[i];
+        if (('A' <= c) && (c <= 'Z')) {
+            c = (char) (c - 'A' + 'a');
+        }
+        if (c != lowercaseName[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static void read_http(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
@@ -3114,21 +5254,12 @@ static void read_http(HAPIPSessionDescriptor* session) {
             case util_HTTP_READER_STATE_COMPLETED_HEADER_VALUE: {
                 update_token(r, &session->httpHeaderFieldValue.bytes, &session->httpHeaderFieldValue.numBytes);
                 HAPAssert(session->httpHeaderFieldName.bytes);
-                if ((session->httpHeaderFieldName.numBytes == 14) &&
-                    (session->httpHeaderFieldName.bytes[0] == 'C' || session->httpHeaderFieldName.bytes[0] == 'c') &&
-                    (session->httpHeaderFieldName.bytes[1] == 'O' || session->httpHeaderFieldName.bytes[1] == 'o') &&
-                    (session->httpHeaderFieldName.bytes[2] == 'N' || session->httpHeaderFieldName.bytes[2] == 'n') &&
-                    (session->httpHeaderFieldName.bytes[3] == 'T' || session->httpHeaderFieldName.bytes[3] == 't') &&
-                    (session->httpHeaderFieldName.bytes[4] == 'E' || session->httpHeaderFieldName.bytes[4] == 'e') &&
-                    (session->httpHeaderFieldName.bytes[5] == 'N' || session->httpHeaderFieldName.bytes[5] == 'n') &&
-                    (session->httpHeaderFieldName.bytes[6] == 'T' || session->httpHeaderFieldName.bytes[6] == 't') &&
-                    (session->httpHeaderFieldName.bytes[7] == '-') &&
-                    (session->httpHeaderFieldName.bytes[8] == 'L' || session->httpHeaderFieldName.bytes[8] == 'l') &&
-                    (session->httpHeaderFieldName.bytes[9] == 'E' || session->httpHeaderFieldName.bytes[9] == 'e') &&
-                    (session->httpHeaderFieldName.bytes[10] == 'N' || session->httpHeaderFieldName.bytes[10] == 'n') &&
-                    (session->httpHeaderFieldName.bytes[11] == 'G' || session->httpHeaderFieldName.bytes[11] == 'g') &&
-                    (session->httpHeaderFieldName.bytes[12] == 'T' || session->httpHeaderFieldName.bytes[12] == 't') &&
-                    (session->httpHeaderFieldName.bytes[13] == 'H' || session->httpHeaderFieldName.bytes[13] == 'h')) {
+                // Only the length of the header field name needs to be checked for headers that are not used by HAP.
+                if (HTTPHeaderFieldNameIsEqual(
+                            session->httpHeaderFieldName.bytes,
+                            session->httpHeaderFieldName.numBytes,
+                            kHTTPHeaderFieldName_ContentLength,
+                            sizeof kHTTPHeaderFieldName_ContentLength - 1)) {
                     if (hasContentLength) {
                         HAPLog(&logObject, "Request has multiple Content-Length headers.");
                         session->httpParserError = true;
@@ -3136,31 +5267,11 @@ static void read_http(HAPIPSessionDescriptor* session) {
                         hasContentLength = true;
                         read_http_content_length(session);
                     }
-                } else if (
-                        (session->httpHeaderFieldName.numBytes == 12) &&
-                        (session->httpHeaderFieldName.bytes[0] == 'C' ||
-                         session->httpHeaderFieldName.bytes[0] == 'c') &&
-                        (session->httpHeaderFieldName.bytes[1] == 'O' ||
-                         session->httpHeaderFieldName.bytes[1] == 'o') &&
-                        (session->httpHeaderFieldName.bytes[2] == 'N' ||
-                         session->httpHeaderFieldName.bytes[2] == 'n') &&
-                        (session->httpHeaderFieldName.bytes[3] == 'T' ||
-                         session->httpHeaderFieldName.bytes[3] == 't') &&
-                        (session->httpHeaderFieldName.bytes[4] == 'E' ||
-                         session->httpHeaderFieldName.bytes[4] == 'e') &&
-                        (session->httpHeaderFieldName.bytes[5] == 'N' ||
-                         session->httpHeaderFieldName.bytes[5] == 'n') &&
-                        (session->httpHeaderFieldName.bytes[6] == 'T' ||
-                         session->httpHeaderFieldName.bytes[6] == 't') &&
-                        (session->httpHeaderFieldName.bytes[7] == '-') &&
-                        (session->httpHeaderFieldName.bytes[8] == 'T' ||
-                         session->httpHeaderFieldName.bytes[8] == 't') &&
-                        (session->httpHeaderFieldName.bytes[9] == 'Y' ||
-                         session->httpHeaderFieldName.bytes[9] == 'y') &&
-                        (session->httpHeaderFieldName.bytes[10] == 'P' ||
-                         session->httpHeaderFieldName.bytes[10] == 'p') &&
-                        (session->httpHeaderFieldName.bytes[11] == 'E' ||
-                         session->httpHeaderFieldName.bytes[11] == 'e')) {
+                } else if (HTTPHeaderFieldNameIsEqual(
+                                   session->httpHeaderFieldName.bytes,
+                                   session->httpHeaderFieldName.numBytes,
+                                   kHTTPHeaderFieldName_ContentType,
+                                   sizeof kHTTPHeaderFieldName_ContentType - 1)) {
                     if (hasContentType) {
                         HAPLog(&logObject, "Request has multiple Content-Type headers.");
                         session->httpParserError = true;
@@ -3185,71 +5296,248 @@ static void read_http(HAPIPSessionDescriptor* session) {
               session->httpParserError)));
 }
 
-static void handle_input(HAPIPSessionDescriptor* session) {
+static void handle_input(HAPIPSessionDescriptor* session) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->securitySession.isOpen);
+
+    int r;
+
+    HAPAssert(session->inboundBuffer.data);
+    HAPAssert(session->inboundBuffer.position <= session->inboundBuffer.limit);
+    HAPAssert(session->inboundBuffer.limit <= session->inboundBuffer.capacity);
+    HAPAssert(session->inboundBufferMark <= session->inboundBuffer.position);
+    session->inboundBuffer.limit = session->inboundBuffer.position;
+    if (session->securitySession.type == kHAPIPSecuritySessionType_HAP &&
+        HAPSessionIsSecured(&session->securitySession._.hap)) {
+        // TODO Should be moved to handle_completed_output, maybe.
+        if (!session->securitySession.isSecured) {
+            HAPLogDebug(&logObject, "Established HAP security session.");
+            session->securitySession.isSecured = true;
+        }
+        session->inboundBuffer.position = session->inboundBufferMark;
+        r = HAPIPSecurityProtocolDecryptData(
+                HAPNonnull(session->server), &session->securitySession._.hap, &session->inboundBuffer);
+    } else {
+        HAPAssert(
+                session->securitySession.type != kHAPIPSecuritySessionType_HAP || !session->securitySession.isSecured);
+        r = 0;
+    }
+    if (r == 0) {
+        read_http(session);
+        if ((session->httpReader.state == util_HTTP_READER_STATE_ERROR) || session->httpParserError) {
+            log_protocol_error(
+                    kHAPLogType_Info, "Unexpected request.", &session->inboundBuffer, __func__, HAP_FILE, __LINE__);
+            CloseSession(session);
+        } else {
+            if (session->httpReader.state == util_HTTP_READER_STATE_DONE) {
+                handle_http(session);
+            }
+            session->inboundBufferMark = session->inboundBuffer.position;
+            session->inboundBuffer.position = session->inboundBuffer.limit;
+            session->inboundBuffer.limit = session->inboundBuffer.capacity;
+            if ((session->state == kHAPIPSessionState_Reading) &&
+                (session->inboundBuffer.position == session->inboundBuffer.limit) && !session->borrowedBuffers &&
+                HAPNonnull(server->ip.storage)->numPooledSessionBuffers) {
+                // The request does not fit into the resident inbound buffer.
+                if (borrow_session_buffers(session)) {
+                    session->inboundBuffer.limit = session->inboundBuffer.capacity;
+                } else {
+                    wait_for_session_buffers(session);
+                }
+            }
+            if ((session->state == kHAPIPSessionState_Reading) &&
+                (session->inboundBuffer.position == session->inboundBuffer.limit)) {
+                log_protocol_error(
+                        kHAPLogType_Info,
+                        "Unexpected request. Closing connection (inbound buffer too small).",
+                        &session->inboundBuffer,
+                        __func__,
+                        HAP_FILE,
+                        __LINE__);
+                CloseSession(session);
+            }
+        }
+    } else {
+        HAPAssert(r == -1);
+        HAPLog(&logObject, "Decryption error.");
+        CloseSession(session);
+    }
+}
+
+static void HandleTCPStreamEvent(
+        HAPPlatformTCPStreamManagerRef tcpStreamManager,
+        HAPPlatformTCPStreamRef tcpStream,
+        HAPPlatformTCPStreamEvent event,
+        void* _Nullable context);
+
+/**
+ * Appends the header of an EVENT message to the outbound buffer.
+ *
+ * @param      session              IP session descriptor.
+ * @param      content_length       Length of the body of the EVENT message.
+ */
+static void write_event_notification_header(HAPIPSessionDescriptor* session, size_t content_length) {
+    HAPPrecondition(session);
+
+    HAPError err;
+
+    HAPAssert(session->outboundBuffer.data);
+    HAPAssert(session->outboundBuffer.position <= session->outboundBuffer.limit);
+    HAPAssert(session->outboundBuffer.limit <= session->outboundBuffer.capacity);
+    err = HAPIPByteBufferAppendStringWithFormat(
+            &session->outboundBuffer,
+            "EVENT/1.0 200 OK\r\n"
+            "Content-Type: application/hap+json\r\n"
+            "Content-Length: %zu\r\n\r\n",
+            content_length);
+    if (err) {
+        HAPAssert(err == kHAPError_OutOfResources);
+        HAPLog(&logObject, "Invalid configuration (outbound buffer too small).");
+        HAPFatalError();
+    }
+}
+
+/**
+ * Returns whether an EVENT message with the values of the first read contexts fits into the outbound buffer.
+ *
+ * @param      session              IP session descriptor.
+ * @param      numReadContexts      Number of read contexts whose values are sent.
+ *
+ * @return true                     If the EVENT message fits into the outbound buffer.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool is_event_notification_message_fitting(HAPIPSessionDescriptor* session, size_t numReadContexts) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->outboundBuffer.position == 0);
+
+    size_t content_length = HAPIPAccessoryProtocolGetNumEventNotificationBytes(
+            HAPNonnull(session->server), server->ip.storage->readContexts, numReadContexts);
+    write_event_notification_header(session, content_length);
+    size_t numHeaderBytes = session->outboundBuffer.position;
+    session->outboundBuffer.position = 0;
+
+    if (content_length > session->outboundBuffer.limit - numHeaderBytes) {
+        return false;
+    }
+    if (session->securitySession.isSecured) {
+        size_t encrypted_length = HAPIPSecurityProtocolGetNumEncryptedBytes(numHeaderBytes + content_length);
+        if (encrypted_length > session->outboundBuffer.capacity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Gets the number of read contexts whose values fit into an EVENT message in the outbound buffer.
+ *
+ * @param      session              IP session descriptor.
+ * @param      maxReadContexts      Maximum number of read contexts, starting with the first one.
+ *
+ * @return Number of read contexts whose values fit, starting with the first one.
+ */
+HAP_RESULT_USE_CHECK
+static size_t get_num_fitting_event_notifications(HAPIPSessionDescriptor* session, size_t maxReadContexts) {
+    HAPPrecondition(session);
+
+    size_t numReadContexts = 0;
+    while (numReadContexts < maxReadContexts) {
+        size_t n = maxReadContexts - (maxReadContexts - numReadContexts) / 2;
+        if (is_event_notification_message_fitting(session, n)) {
+            numReadContexts = n;
+        } else {
+            maxReadContexts = n - 1;
+        }
+    }
+    return numReadContexts;
+}
+
+/**
+ * Serializes an EVENT message with the values of the first read contexts and starts writing it.
+ *
+ * - The EVENT message must fit into the outbound buffer.
+ *
+ * @param      session              IP session descriptor.
+ * @param      numReadContexts      Number of read contexts whose values are sent.
+ */
+static void write_event_notification_message(HAPIPSessionDescriptor* session, size_t numReadContexts) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(session->outboundBuffer.position == 0);
+    HAPPrecondition(numReadContexts > 0);
+
+    HAPError err;
+
+    size_t content_length = HAPIPAccessoryProtocolGetNumEventNotificationBytes(
+            HAPNonnull(session->server), server->ip.storage->readContexts, numReadContexts);
+    write_event_notification_header(session, content_length);
+    HAPAssert(content_length <= session->outboundBuffer.limit - session->outboundBuffer.position);
+    size_t mark = session->outboundBuffer.position;
+    err = HAPIPAccessoryProtocolGetEventNotificationBytes(
+            HAPNonnull(session->server), server->ip.storage->readContexts, numReadContexts, &session->outboundBuffer);
+    HAPAssert(!err && (session->outboundBuffer.position - mark == content_length));
+    HAPIPByteBufferFlip(&session->outboundBuffer);
+    HAPLogBufferDebug(
+            &logObject,
+            session->outboundBuffer.data,
+            session->outboundBuffer.limit,
+            "session:%p:<",
+            (const void*) session);
+    if (session->securitySession.isSecured) {
+        size_t encrypted_length = HAPIPSecurityProtocolGetNumEncryptedBytes(
+                session->outboundBuffer.limit - session->outboundBuffer.position);
+        HAPAssert(encrypted_length <= session->outboundBuffer.capacity - session->outboundBuffer.position);
+        HAPIPSecurityProtocolEncryptData(
+                HAPNonnull(session->server), &session->securitySession._.hap, &session->outboundBuffer);
+        HAPAssert(encrypted_length == session->outboundBuffer.limit - session->outboundBuffer.position);
+    } else {
+        HAPAssert(kHAPIPAccessoryServer_SessionSecurityDisabled);
+    }
+    session->state = kHAPIPSessionState_Writing;
+    HAPPlatformTCPStreamEvent interests = { .hasBytesAvailable = false, .hasSpaceAvailable = true };
+    HAPPlatformTCPStreamUpdateInterests(
+            HAPNonnull(server->platform.ip.tcpStreamManager),
+            session->tcpStream,
+            interests,
+            HandleTCPStreamEvent,
+            session);
+}
+
+/**
+ * Queues an event again whose value did not fit into the outbound buffer.
+ *
+ * - The event is sent without coalescing delay as soon as the outbound buffer has been written.
+ *
+ * @param      session              IP session descriptor.
+ * @param      aid                  Accessory instance ID.
+ * @param      iid                  Characteristic instance ID.
+ */
+static void defer_event_notification(HAPIPSessionDescriptor* session, uint64_t aid, uint64_t iid) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
-    HAPPrecondition(session->securitySession.isOpen);
-
-    int r;
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
 
-    HAPAssert(session->inboundBuffer.data);
-    HAPAssert(session->inboundBuffer.position <= session->inboundBuffer.limit);
-    HAPAssert(session->inboundBuffer.limit <= session->inboundBuffer.capacity);
-    HAPAssert(session->inboundBufferMark <= session->inboundBuffer.position);
-    session->inboundBuffer.limit = session->inboundBuffer.position;
-    if (session->securitySession.type == kHAPIPSecuritySessionType_HAP &&
-        HAPSessionIsSecured(&session->securitySession._.hap)) {
-        // TODO Should be moved to handle_completed_output, maybe.
-        if (!session->securitySession.isSecured) {
-            HAPLogDebug(&logObject, "Established HAP security session.");
-            session->securitySession.isSecured = true;
-        }
-        session->inboundBuffer.position = session->inboundBufferMark;
-        r = HAPIPSecurityProtocolDecryptData(
-                HAPNonnull(session->server), &session->securitySession._.hap, &session->inboundBuffer);
-    } else {
-        HAPAssert(
-                session->securitySession.type != kHAPIPSecuritySessionType_HAP || !session->securitySession.isSecured);
-        r = 0;
-    }
-    if (r == 0) {
-        read_http(session);
-        if ((session->httpReader.state == util_HTTP_READER_STATE_ERROR) || session->httpParserError) {
-            log_protocol_error(
-                    kHAPLogType_Info, "Unexpected request.", &session->inboundBuffer, __func__, HAP_FILE, __LINE__);
-            CloseSession(session);
-        } else {
-            if (session->httpReader.state == util_HTTP_READER_STATE_DONE) {
-                handle_http(session);
-            }
-            session->inboundBufferMark = session->inboundBuffer.position;
-            session->inboundBuffer.position = session->inboundBuffer.limit;
-            session->inboundBuffer.limit = session->inboundBuffer.capacity;
-            if ((session->state == kHAPIPSessionState_Reading) &&
-                (session->inboundBuffer.position == session->inboundBuffer.limit)) {
-                log_protocol_error(
-                        kHAPLogType_Info,
-                        "Unexpected request. Closing connection (inbound buffer too small).",
-                        &session->inboundBuffer,
-                        __func__,
-                        HAP_FILE,
-                        __LINE__);
-                CloseSession(session);
-            }
+    for (size_t i = 0; i < session->numEventNotifications; i++) {
+        HAPIPEventNotification* eventNotification = (HAPIPEventNotification*) &session->eventNotifications[i];
+        if (eventNotification->aid == aid && eventNotification->iid == iid) {
+            HAPAssert(!eventNotification->flag);
+            HAPAssert(!eventNotification->isDue);
+            set_event_notification_flag(session, eventNotification);
+            eventNotification->isDue = true;
+            session->numDueEventNotifications++;
+            server->ip.eventNotificationStatistics.numDeferredEvents++;
+            return;
         }
-    } else {
-        HAPAssert(r == -1);
-        HAPLog(&logObject, "Decryption error.");
-        CloseSession(session);
     }
+    HAPFatalError();
 }
 
-static void HandleTCPStreamEvent(
-        HAPPlatformTCPStreamManagerRef tcpStreamManager,
-        HAPPlatformTCPStreamRef tcpStream,
-        HAPPlatformTCPStreamEvent event,
-        void* _Nullable context);
-
 static void write_event_notifications(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session);
     HAPPrecondition(session->server);
@@ -3259,12 +5547,11 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
     HAPPrecondition(!HAPSessionIsTransient(&session->securitySession._.hap));
     HAPPrecondition(session->state == kHAPIPSessionState_Reading);
     HAPPrecondition(session->inboundBuffer.position == 0);
+    HAPPrecondition(!session->streamingWrite.isActive);
     HAPPrecondition(session->numEventNotificationFlags > 0);
     HAPPrecondition(session->numEventNotificationFlags <= session->numEventNotifications);
     HAPPrecondition(session->numEventNotifications <= session->maxEventNotifications);
 
-    HAPError err;
-
     if (session->securitySession.isSecured || kHAPIPAccessoryServer_SessionSecurityDisabled) {
         HAPTime clock_now_ms = HAPPlatformClockGetCurrent();
         HAPAssert(clock_now_ms >= session->eventNotificationStamp);
@@ -3276,7 +5563,9 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
             HAPIPEventNotification* eventNotification = (HAPIPEventNotification*) &session->eventNotifications[i];
             if (eventNotification->flag) {
                 bool notifyNow;
-                if (dt_ms >= kHAPIPAccessoryServer_MaxEventNotificationDelay) {
+                if (eventNotification->isDue) {
+                    notifyNow = true;
+                } else if (dt_ms >= kHAPIPAccessoryServer_MaxEventNotificationDelay) {
                     notifyNow = true;
                     session->eventNotificationStamp = clock_now_ms;
                 } else {
@@ -3288,19 +5577,19 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
                     const HAPCharacteristic* characteristic_;
                     const HAPService* service;
                     const HAPAccessory* accessory;
+                    HAPTypeID characteristicTypeID;
                     get_db_ctx(
                             session->server,
                             eventNotification->aid,
                             eventNotification->iid,
                             &characteristic_,
                             &service,
-                            &accessory);
+                            &accessory,
+                            &characteristicTypeID);
                     HAPAssert(accessory);
                     HAPAssert(service);
                     HAPAssert(characteristic_);
-                    const HAPBaseCharacteristic* characteristic = characteristic_;
-                    notifyNow = HAPUUIDAreEqual(
-                            characteristic->characteristicType, &kHAPCharacteristicType_ProgrammableSwitchEvent);
+                    notifyNow = characteristicTypeID == kHAPCharacteristicTypeID_ProgrammableSwitchEvent;
                     if (notifyNow) {
                         HAPLogCharacteristicDebug(
                                 &logObject,
@@ -3318,9 +5607,7 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
                     readContext->aid = eventNotification->aid;
                     readContext->iid = eventNotification->iid;
                     numReadContexts++;
-                    eventNotification->flag = false;
-                    HAPAssert(session->numEventNotificationFlags > 0);
-                    session->numEventNotificationFlags--;
+                    clear_event_notification_flag(session, eventNotification);
                 }
             }
         }
@@ -3342,78 +5629,62 @@ static void write_event_notifications(HAPIPSessionDescriptor* session) {
                     &data_buffer);
             (void) r;
 
-            size_t content_length = HAPIPAccessoryProtocolGetNumEventNotificationBytes(
-                    HAPNonnull(session->server), server->ip.storage->readContexts, numReadContexts);
+            // Values that did not fit into the scratch buffer after earlier values are read again later.
+            size_t maxSentEvents = numReadContexts;
+            for (size_t i = 1; i < numReadContexts; i++) {
+                const HAPIPReadContext* readContext = (const HAPIPReadContext*) &server->ip.storage->readContexts[i];
+                if (readContext->status == kHAPIPAccessoryServerStatusCode_OutOfResources) {
+                    maxSentEvents = i;
+                    break;
+                }
+            }
 
-            HAPAssert(session->outboundBuffer.data);
-            HAPAssert(session->outboundBuffer.position <= session->outboundBuffer.limit);
-            HAPAssert(session->outboundBuffer.limit <= session->outboundBuffer.capacity);
-            size_t mark = session->outboundBuffer.position;
-            err = HAPIPByteBufferAppendStringWithFormat(
-                    &session->outboundBuffer,
-                    "EVENT/1.0 200 OK\r\n"
-                    "Content-Type: application/hap+json\r\n"
-                    "Content-Length: %zu\r\n\r\n",
-                    content_length);
-            if (err) {
-                HAPAssert(err == kHAPError_OutOfResources);
-                HAPLog(&logObject, "Invalid configuration (outbound buffer too small).");
-                HAPFatalError();
+            // Send as many events as fit into the outbound buffer. The remaining events stay queued.
+            // Pooled session buffers are only borrowed if the events do not fit into the resident outbound buffer.
+            size_t numSentEvents = get_num_fitting_event_notifications(session, maxSentEvents);
+            bool isWaitingForBuffers = false;
+            if (numSentEvents < maxSentEvents && server->ip.storage->numPooledSessionBuffers &&
+                !session->borrowedBuffers) {
+                if (server->ip.sessionBufferPool.firstFreeBuffers) {
+                    bool borrowed = borrow_session_buffers(session);
+                    HAPAssert(borrowed);
+                    numSentEvents = get_num_fitting_event_notifications(session, maxSentEvents);
+                } else {
+                    isWaitingForBuffers = true;
+                }
             }
-            if (content_length <= session->outboundBuffer.limit - session->outboundBuffer.position) {
-                mark = session->outboundBuffer.position;
-                err = HAPIPAccessoryProtocolGetEventNotificationBytes(
-                        HAPNonnull(session->server),
-                        server->ip.storage->readContexts,
-                        numReadContexts,
-                        &session->outboundBuffer);
-                HAPAssert(!err && (session->outboundBuffer.position - mark == content_length));
-                HAPIPByteBufferFlip(&session->outboundBuffer);
-                HAPLogBufferDebug(
+            size_t numDeferredEvents = numReadContexts - numSentEvents;
+            if (numSentEvents) {
+                write_event_notification_message(session, numSentEvents);
+            } else if (isWaitingForBuffers) {
+                HAPLogDebug(
                         &logObject,
-                        session->outboundBuffer.data,
-                        session->outboundBuffer.limit,
-                        "session:%p:<",
+                        "session:%p:event notifications waiting for pooled session buffers",
                         (const void*) session);
-                if (session->securitySession.isSecured) {
-                    size_t encrypted_length = HAPIPSecurityProtocolGetNumEncryptedBytes(
-                            session->outboundBuffer.limit - session->outboundBuffer.position);
-                    if (encrypted_length <= session->outboundBuffer.capacity - session->outboundBuffer.position) {
-                        HAPIPSecurityProtocolEncryptData(
-                                HAPNonnull(session->server), &session->securitySession._.hap, &session->outboundBuffer);
-                        HAPAssert(encrypted_length == session->outboundBuffer.limit - session->outboundBuffer.position);
-                        session->state = kHAPIPSessionState_Writing;
-                    } else {
-                        HAPLog(&logObject, "Skipping event notifications (outbound buffer too small).");
-                        HAPIPByteBufferClear(&session->outboundBuffer);
-                    }
-                } else {
-                    HAPAssert(kHAPIPAccessoryServer_SessionSecurityDisabled);
-                    HAP_DIAGNOSTIC_IGNORED_ICCARM(Pe111)
-                    session->state = kHAPIPSessionState_Writing;
-                    HAP_DIAGNOSTIC_RESTORE_ICCARM(Pe111)
-                }
-                if (session->state == kHAPIPSessionState_Writing) {
-                    HAPPlatformTCPStreamEvent interests = { .hasBytesAvailable = false, .hasSpaceAvailable = true };
-                    HAPPlatformTCPStreamUpdateInterests(
-                            HAPNonnull(server->platform.ip.tcpStreamManager),
-                            session->tcpStream,
-                            interests,
-                            HandleTCPStreamEvent,
-                            session);
-                }
+                session->eventNotificationsAreWaitingForBuffers = true;
+                server->ip.sessionBufferPool.hasWaitingSessions = true;
             } else {
-                HAPLog(&logObject, "Skipping event notifications (outbound buffer too small).");
-                session->outboundBuffer.position = mark;
+                HAPLog(&logObject, "Dropping event notification (outbound buffer too small).");
+                server->ip.eventNotificationStatistics.numDroppedEvents++;
+                numDeferredEvents--;
+            }
+            if (numDeferredEvents) {
+                HAPLog(&logObject, "Deferring %zu event notifications (buffer space exhausted).", numDeferredEvents);
+                for (size_t i = numReadContexts - numDeferredEvents; i < numReadContexts; i++) {
+                    const HAPIPReadContext* readContext =
+                            (const HAPIPReadContext*) &server->ip.storage->readContexts[i];
+                    defer_event_notification(session, readContext->aid, readContext->iid);
+                }
+            }
+            if (session->state == kHAPIPSessionState_Reading && session->borrowedBuffers) {
+                return_session_buffers(session);
             }
         }
     } else {
         for (size_t i = 0; i < session->numEventNotifications; i++) {
             HAPIPEventNotification* eventNotification = (HAPIPEventNotification*) &session->eventNotifications[i];
             if (eventNotification->flag) {
-                eventNotification->flag = false;
-                HAPAssert(session->numEventNotificationFlags > 0);
-                session->numEventNotificationFlags--;
+                clear_event_notification_flag(session, eventNotification);
             }
         }
         HAPAssert(session->numEventNotificationFlags == 0);
@@ -3426,7 +5697,11 @@ static void handle_io_progression(HAPIPSessionDescriptor* session) {
     HAPPrecondition(session->server);
     HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
 
-    if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0)) {
+    if ((session->state == kHAPIPSessionState_Reading) && (session->inboundBuffer.position == 0) &&
+        !session->streamingWrite.isActive) {
+        if (session->borrowedBuffers) {
+            return_session_buffers(session);
+        }
         if (server->ip.state == kHAPIPAccessoryServerState_Stopping) {
             CloseSession(session);
         } else {
@@ -3530,8 +5805,8 @@ static void WriteOutboundData(HAPIPSessionDescriptor* session) {
                 !HAPSessionIsSecured(&session->securitySession._.hap)) {
                 HAPLogDebug(&logObject, "Pairing removed, closing session.");
                 CloseSession(session);
-            } else if (session->accessorySerializationIsInProgress) {
-                handle_accessory_serialization(session);
+            } else if (session->chunkedResponseIsInProgress) {
+                handle_chunked_response(session);
             } else {
                 HAPIPByteBufferClear(b);
                 handle_output_completion(session);
@@ -3632,6 +5907,53 @@ static void HandleTCPStreamEvent(
     }
 }
 
+/**
+ * Gets the IP session that is evicted to admit a new connection while all IP sessions are in use.
+ *
+ * - Sessions on which Pair Verify has not been completed are evicted first, the least recently active one.
+ *   If there are none, the least recently active idle session without event notification subscriptions is evicted.
+ *
+ * - Sessions that are performing Pair Setup are not evicted. Sessions that are performing Pair Verify are not evicted
+ *   until they have been inactive for kHAPIPSession_PairVerifyGracePeriod.
+ *
+ * @param      server_              Accessory server.
+ *
+ * @return IP session descriptor of the session to evict, if any. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSessionDescriptor* _Nullable GetSessionToEvict(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+
+    HAPTime now = HAPPlatformClockGetCurrent();
+    HAPIPSessionDescriptor* _Nullable evictedSession = NULL;
+    for (HAPIPSession* _Nullable ipSession = server->ip.sessionLists.openSessions.first; ipSession;
+         ipSession = GetNextSessionOfList(HAPNonnull(ipSession), kHAPIPSessionListKind_Slot)) {
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        HAPAssert(session->server);
+
+        if (IsSessionPairing(session)) {
+            continue;
+        }
+        if (IsSessionVerifying(session) && now - session->stamp < kHAPIPSession_PairVerifyGracePeriod) {
+            continue;
+        }
+        bool isVerified = IsSessionVerified(session);
+        if (isVerified && (!IsSessionIdle(session) || session->numEventNotifications)) {
+            continue;
+        }
+        if (evictedSession) {
+            HAPIPSessionDescriptor* t = HAPNonnull(evictedSession);
+            bool tIsVerified = IsSessionVerified(t);
+            if ((isVerified && !tIsVerified) || (isVerified == tIsVerified && session->stamp >= t->stamp)) {
+                continue;
+            }
+        }
+        evictedSession = session;
+    }
+    return evictedSession;
+}
+
 static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManager, void* _Nullable context) {
     HAPPrecondition(context);
     HAPAccessoryServerRef* server_ = context;
@@ -3653,25 +5975,35 @@ static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManag
         return;
     }
 
-    // Find free IP session.
-    HAPIPSession* ipSession = NULL;
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSessionDescriptor* descriptor = (HAPIPSessionDescriptor*) &server->ip.storage->sessions[i].descriptor;
-        if (!descriptor->server) {
-            ipSession = &server->ip.storage->sessions[i];
-            break;
+    // Reclaim closed sessions. If all sessions are still in use, evict a session to admit the new connection.
+    if (!server->ip.sessionLists.freeSessions.numSessions && server->ip.sessionLists.closedSessions.numSessions) {
+        collect_garbage(server_);
+    }
+    if (!server->ip.sessionLists.freeSessions.numSessions) {
+        HAPIPSessionDescriptor* _Nullable evictedSession = GetSessionToEvict(server_);
+        if (evictedSession) {
+            HAPLogInfo(
+                    &logObject,
+                    "session:%p:evicting to admit new connection",
+                    (const void*) HAPNonnull(evictedSession));
+            CloseSession(HAPNonnull(evictedSession));
+        }
+        if (server->ip.sessionLists.closedSessions.numSessions) {
+            collect_garbage(server_);
         }
     }
-    if (!ipSession) {
-        HAPLog(&logObject,
-               "Failed to allocate session."
-               " (Number of supported accessory server sessions should be consistent with"
-               " the maximum number of concurrent streams supported by TCP stream manager.)");
+
+    // Allocate free IP session.
+    HAPIPSession* _Nullable freeIPSession = PopFirstSessionOfList(&server->ip.sessionLists.freeSessions);
+    if (!freeIPSession) {
+        HAPLog(&logObject, "Failed to allocate session. No session can be evicted to admit new connection.");
         HAPPlatformTCPStreamClose(HAPNonnull(server->platform.ip.tcpStreamManager), tcpStream);
         return;
     }
+    HAPIPSession* ipSession = HAPNonnull(freeIPSession);
 
     HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &ipSession->descriptor;
+    HAPAssert(!t->server);
     HAPRawBufferZero(t, sizeof *t);
     t->server = server_;
     t->tcpStream = tcpStream;
@@ -3693,6 +6025,7 @@ static void HandlePendingTCPStream(HAPPlatformTCPStreamManagerRef tcpStreamManag
     t->maxEventNotifications = ipSession->numEventNotifications;
     t->numEventNotifications = 0;
     t->numEventNotificationFlags = 0;
+    t->numDueEventNotifications = 0;
     t->eventNotificationStamp = 0;
     t->timedWriteExpirationTime = 0;
     t->timedWritePID = 0;
@@ -3804,6 +6137,10 @@ static void engine_init(HAPAccessoryServerRef* server_) {
             &logObject,
             "Storage configuration: scratchBuffer.numBytes = %lu",
             (unsigned long) server->ip.storage->scratchBuffer.numBytes);
+    HAPLogDebug(
+            &logObject,
+            "Storage configuration: numPooledSessionBuffers = %lu",
+            (unsigned long) server->ip.storage->numPooledSessionBuffers);
 
     HAPAssert(server->ip.state == kHAPIPAccessoryServerState_Undefined);
 
@@ -3905,6 +6242,8 @@ static void engine_start(HAPAccessoryServerRef* server_) {
     server->ip.state = kHAPIPAccessoryServerState_Running;
     HAPAccessoryServerDelegateScheduleHandleUpdatedState(server_);
 
+    HAPIPAccessoryCreateAccessoriesCache(server_);
+
     HAPAssert(!HAPPlatformTCPStreamManagerIsListenerOpen(HAPNonnull(server->platform.ip.tcpStreamManager)));
 
     HAPPlatformTCPStreamManagerOpenListener(
@@ -3937,6 +6276,72 @@ static HAPError engine_stop(HAPAccessoryServerRef* server_) {
     return kHAPError_None;
 }
 
+/**
+ * Gets the IP session whose security session storage contains a HAP session.
+ *
+ * - HAP sessions of IP sessions are stored in the IP session storage, so the IP session is derived from the address
+ *   of the HAP session without visiting other sessions.
+ *
+ * @param      server               Accessory server.
+ * @param      securitySession      HAP session.
+ *
+ * @return IP session if the HAP session is stored in the IP session storage. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSession* _Nullable GetIPSessionForSecuritySession(
+        const HAPAccessoryServer* server,
+        const HAPSessionRef* securitySession) {
+    HAPPrecondition(server);
+    HAPPrecondition(server->ip.storage);
+    const HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
+    HAPPrecondition(securitySession);
+
+    HAPIPSessionDescriptor* firstSession = (HAPIPSessionDescriptor*) &storage->sessions[0].descriptor;
+    uintptr_t firstAddress = (uintptr_t) &firstSession->securitySession._.hap;
+    uintptr_t address = (uintptr_t) securitySession;
+    if (address < firstAddress) {
+        return NULL;
+    }
+    size_t index = (size_t)(address - firstAddress) / sizeof storage->sessions[0];
+    if (index >= storage->numSessions) {
+        return NULL;
+    }
+    HAPIPSession* ipSession = &storage->sessions[index];
+    HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
+    if (&session->securitySession._.hap != securitySession) {
+        return NULL;
+    }
+    return ipSession;
+}
+
+/**
+ * Finds the IP session that belongs to a HAP session.
+ *
+ * @param      server_              Accessory server.
+ * @param      securitySession      HAP session.
+ *
+ * @return IP session descriptor if the HAP session belongs to an open IP session. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSessionDescriptor* _Nullable GetSessionForSecuritySession(
+        HAPAccessoryServerRef* server_,
+        const HAPSessionRef* securitySession) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(securitySession);
+
+    HAPIPSession* _Nullable ipSession = GetIPSessionForSecuritySession(server, securitySession);
+    if (!ipSession) {
+        return NULL;
+    }
+    HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+    if (!session->server || (session->state == kHAPIPSessionState_Idle) ||
+        (session->securitySession.type != kHAPIPSecuritySessionType_HAP)) {
+        return NULL;
+    }
+    return session;
+}
+
 HAP_RESULT_USE_CHECK
 static HAPError engine_raise_event_on_session_(
         HAPAccessoryServerRef* server_,
@@ -3958,12 +6363,17 @@ static HAPError engine_raise_event_on_session_(
     uint64_t aid = accessory_->aid;
     uint64_t iid = ((const HAPBaseCharacteristic*) characteristic_)->iid;
 
-    for (size_t i = 0; i < server->ip.storage->numSessions; i++) {
-        HAPIPSession* ipSession = &server->ip.storage->sessions[i];
+    // Events that are raised for a single HAP session only visit the IP session of that HAP session.
+    HAPIPSession* _Nullable nextIPSession = server->ip.sessionLists.openSessions.first;
+    if (securitySession_) {
+        HAPIPSessionDescriptor* _Nullable t = GetSessionForSecuritySession(server_, HAPNonnull(securitySession_));
+        nextIPSession = t ? GetIPSession(HAPNonnull(t)) : NULL;
+    }
+    while (nextIPSession) {
+        HAPIPSession* ipSession = HAPNonnull(nextIPSession);
+        nextIPSession = securitySession_ ? NULL : GetNextSessionOfList(ipSession, kHAPIPSessionListKind_Slot);
         HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
-        if (!session->server) {
-            continue;
-        }
+        HAPAssert(session->server);
         if (session->securitySession.type != kHAPIPSecuritySessionType_HAP) {
             if (!securitySession_) {
                 HAPLogDebug(&logObject, "Not flagging event pending on non-HAP session.");
@@ -3996,8 +6406,9 @@ static HAPError engine_raise_event_on_session_(
                      (((HAPIPEventNotification*) &session->eventNotifications[j])->iid == iid)));
             if ((j < session->numEventNotifications) &&
                 !((HAPIPEventNotification*) &session->eventNotifications[j])->flag) {
-                ((HAPIPEventNotification*) &session->eventNotifications[j])->flag = true;
-                session->numEventNotificationFlags++;
+                set_event_notification_flag(session, (HAPIPEventNotification*) &session->eventNotifications[j]);
+                server->ip.eventNotificationStatistics.maxQueuedEvents = HAPMax(
+                        server->ip.eventNotificationStatistics.maxQueuedEvents, session->numEventNotificationFlags);
                 events_raised++;
             }
         }
@@ -4049,6 +6460,220 @@ static HAPError engine_raise_event_on_session(
     return engine_raise_event_on_session_(server, characteristic, service, accessory, session);
 }
 
+/**
+ * Finds the session whose pending GET /characteristics request contains the pending read with a completion token.
+ *
+ * @param      server_              Accessory server.
+ * @param      completionToken      Completion token of the read.
+ * @param[out] index                Index of the read context of the pending read, if found.
+ *
+ * @return Session with the pending read, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPIPSessionDescriptor* _Nullable GetSessionForPendingRead(
+        HAPAccessoryServerRef* server_,
+        HAPCompletionToken completionToken,
+        size_t* index) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(index);
+
+    for (HAPIPSession* _Nullable ipSession = server->ip.sessionLists.asynchronousRequestSessions.first; ipSession;
+         ipSession = GetNextSessionOfList(HAPNonnull(ipSession), kHAPIPSessionListKind_AsynchronousRequests)) {
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        if (!session->pendingRequest.numPendingReads) {
+            continue;
+        }
+
+        // Saved read contexts are not necessarily aligned.
+        const char* bytes = &session->outboundBuffer.data[session->outboundBuffer.position];
+        for (size_t i = 0; i < session->pendingRequest.numReadContexts; i++) {
+            HAPIPReadContext readContext;
+            HAPRawBufferCopyBytes(&readContext, &bytes[i * sizeof(HAPIPReadContextRef)], sizeof readContext);
+            if ((readContext.status == kHAPIPAccessoryServerStatusCode_InProgress) &&
+                (readContext.completionToken == completionToken)) {
+                *index = i;
+                return session;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Adds the value of a completed read to the saved read contexts of a pending GET /characteristics request.
+ *
+ * - The value is serialized behind the values that have already been saved. Values of saved read contexts refer to
+ *   the scratch buffer into which they are restored once the request is resumed.
+ *
+ * @param      session              IP session descriptor.
+ * @param      readContext          Read context of the completed read.
+ * @param      valueBytes           Value of the completed read.
+ * @param      numValueBytes        Length of @p valueBytes.
+ */
+static void handle_completed_read(
+        HAPIPSessionDescriptor* session,
+        HAPIPReadContext* readContext,
+        const void* _Nullable valueBytes,
+        size_t numValueBytes) {
+    HAPPrecondition(session);
+    HAPPrecondition(session->server);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) session->server;
+    HAPPrecondition(readContext);
+
+    const HAPCharacteristic* characteristic;
+    const HAPService* service;
+    const HAPAccessory* accessory;
+    get_db_ctx(
+            session->server,
+            readContext->aid,
+            readContext->iid,
+            &characteristic,
+            &service,
+            &accessory,
+            /* chrTypeID: */ NULL);
+    HAPAssert(characteristic);
+
+    size_t numContextBytes = session->pendingRequest.numReadContexts * sizeof(HAPIPReadContextRef);
+    size_t numFreeBytes = session->outboundBuffer.limit - session->outboundBuffer.position;
+    HAPAssert(numContextBytes + session->pendingRequest.numReadValueBytes <= numFreeBytes);
+    HAPIPByteBuffer dataBuffer;
+    dataBuffer.data = &session->outboundBuffer.data[session->outboundBuffer.position + numContextBytes];
+    dataBuffer.capacity = numFreeBytes - numContextBytes;
+    dataBuffer.limit = HAPMin(dataBuffer.capacity, server->ip.storage->scratchBuffer.numBytes);
+    dataBuffer.position = session->pendingRequest.numReadValueBytes;
+    HAPAssert(dataBuffer.position <= dataBuffer.limit);
+
+    server->completedRead.bytes = valueBytes;
+    server->completedRead.numBytes = numValueBytes;
+    server->completedRead.isSet = true;
+    handle_characteristic_read_request(
+            session,
+            HAPNonnull(characteristic),
+            HAPNonnull(service),
+            HAPNonnull(accessory),
+            (HAPIPReadContextRef*) readContext,
+            &dataBuffer);
+    HAPRawBufferZero(&server->completedRead, sizeof server->completedRead);
+    HAPAssert(readContext->status != kHAPIPAccessoryServerStatusCode_InProgress);
+    if (readContext->status != kHAPIPAccessoryServerStatusCode_Success) {
+        return;
+    }
+
+    switch (((const HAPBaseCharacteristic*) characteristic)->format) {
+        case kHAPCharacteristicFormat_Data:
+        case kHAPCharacteristicFormat_String:
+        case kHAPCharacteristicFormat_TLV8: {
+            HAPAssert(readContext->value.stringValue.bytes);
+            char* scratchBytes = server->ip.storage->scratchBuffer.bytes;
+            size_t offset = (size_t)(readContext->value.stringValue.bytes - dataBuffer.data);
+            readContext->value.stringValue.bytes = &scratchBytes[offset];
+        } break;
+        case kHAPCharacteristicFormat_Bool:
+        case kHAPCharacteristicFormat_UInt8:
+        case kHAPCharacteristicFormat_UInt16:
+        case kHAPCharacteristicFormat_UInt32:
+        case kHAPCharacteristicFormat_UInt64:
+        case kHAPCharacteristicFormat_Int:
+        case kHAPCharacteristicFormat_Float: {
+        } break;
+    }
+    session->pendingRequest.numReadValueBytes = dataBuffer.position;
+}
+
+static void engine_complete_read(
+        HAPAccessoryServerRef* server_,
+        HAPCompletionToken completionToken,
+        HAPError error,
+        const void* _Nullable valueBytes,
+        size_t numValueBytes) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(completionToken != kHAPCompletionToken_None);
+
+    size_t index;
+    HAPIPSessionDescriptor* _Nullable session_ = GetSessionForPendingRead(server_, completionToken, &index);
+    if (!session_) {
+        HAPLog(&logObject, "Ignoring read completion %lu: No pending read.", (unsigned long) completionToken);
+        return;
+    }
+    HAPIPSessionDescriptor* session = HAPNonnull(session_);
+    HAPAssert(session->state == kHAPIPSessionState_Waiting);
+
+    HAPIPReadContext readContext;
+    HAPRawBufferCopyBytes(
+            &readContext,
+            &session->outboundBuffer.data[session->outboundBuffer.position + index * sizeof(HAPIPReadContextRef)],
+            sizeof readContext);
+    if (error) {
+        readContext.status = ConvertCharacteristicReadErrorToStatusCode(error);
+    } else {
+        handle_completed_read(session, &readContext, valueBytes, numValueBytes);
+        if ((readContext.status == kHAPIPAccessoryServerStatusCode_OutOfResources) && !session->borrowedBuffers &&
+            !session->outboundBuffer.position && server->ip.sessionBufferPool.firstFreeBuffers) {
+            // Retry with pooled session buffers, as the resident outbound buffer of the session is too small.
+            bool borrowed = borrow_session_buffers(session);
+            HAPAssert(borrowed);
+            handle_completed_read(session, &readContext, valueBytes, numValueBytes);
+        }
+    }
+    HAPRawBufferCopyBytes(
+            &session->outboundBuffer.data[session->outboundBuffer.position + index * sizeof(HAPIPReadContextRef)],
+            &readContext,
+            sizeof readContext);
+
+    HAPAssert(session->pendingRequest.numPendingReads);
+    session->pendingRequest.numPendingReads--;
+    if (!session->pendingRequest.numPendingReads) {
+        RemoveSessionFromList(GetIPSession(session), kHAPIPSessionListKind_AsynchronousRequests);
+        schedule_pending_requests(server_);
+    }
+}
+
+static void engine_complete_write(HAPAccessoryServerRef* server_, HAPCompletionToken completionToken, HAPError error) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(completionToken != kHAPCompletionToken_None);
+
+    HAPIPSessionDescriptor* _Nullable session_ = NULL;
+    for (HAPIPSession* _Nullable ipSession = server->ip.sessionLists.asynchronousRequestSessions.first; ipSession;
+         ipSession = GetNextSessionOfList(HAPNonnull(ipSession), kHAPIPSessionListKind_AsynchronousRequests)) {
+        HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        if (t->pendingRequest.isWritePending && (t->pendingRequest.writeCompletionToken == completionToken)) {
+            session_ = t;
+            break;
+        }
+    }
+    if (!session_) {
+        HAPLog(&logObject, "Ignoring write completion %lu: No pending write.", (unsigned long) completionToken);
+        return;
+    }
+    HAPIPSessionDescriptor* session = HAPNonnull(session_);
+    HAPAssert(session->state == kHAPIPSessionState_Waiting);
+
+    // The completed write may have changed the value of the characteristic.
+    const HAPCharacteristic* characteristic;
+    const HAPService* service;
+    const HAPAccessory* accessory;
+    get_db_ctx(
+            server_,
+            session->pendingRequest.aid,
+            session->pendingRequest.iid,
+            &characteristic,
+            &service,
+            &accessory,
+            /* chrTypeID: */ NULL);
+    HAPAssert(characteristic);
+    HAPCharacteristicValueCacheInvalidate(
+            server_, HAPNonnull(characteristic), HAPNonnull(service), HAPNonnull(accessory));
+
+    session->pendingRequest.writeError = error;
+    session->pendingRequest.isWritePending = false;
+    session->pendingRequest.isWriteCompleted = true;
+    RemoveSessionFromList(GetIPSession(session), kHAPIPSessionListKind_AsynchronousRequests);
+    schedule_pending_requests(server_);
+}
+
 static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptions* options) {
     HAPPrecondition(server_);
     HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
@@ -4071,6 +6696,8 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
     HAPPrecondition(storage->readContexts);
     HAPPrecondition(storage->writeContexts);
     HAPPrecondition(storage->scratchBuffer.bytes);
+    HAPPrecondition(!storage->accessoriesCache.numBytes || storage->accessoriesCache.bytes);
+    HAPPrecondition(!storage->writeStagingBuffer.numBytes || storage->writeStagingBuffer.bytes);
     HAPPrecondition(storage->sessions);
     HAPPrecondition(storage->numSessions);
     for (size_t i = 0; i < storage->numSessions; i++) {
@@ -4079,6 +6706,18 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
         HAPPrecondition(session->outboundBuffer.bytes);
         HAPPrecondition(session->eventNotifications);
     }
+    HAPPrecondition(!storage->numPooledSessionBuffers || storage->pooledSessionBuffers);
+    for (size_t i = 0; i < storage->numPooledSessionBuffers; i++) {
+        HAPIPSessionBuffers* buffers = &HAPNonnull(storage->pooledSessionBuffers)[i];
+        HAPPrecondition(buffers->inboundBuffer.bytes);
+        HAPPrecondition(buffers->inboundBuffer.numBytes >= sizeof(size_t));
+        HAPPrecondition(buffers->outboundBuffer.bytes);
+        for (size_t j = 0; j < storage->numSessions; j++) {
+            HAPIPSession* session = &storage->sessions[j];
+            HAPPrecondition(buffers->inboundBuffer.numBytes >= session->inboundBuffer.numBytes);
+            HAPPrecondition(buffers->outboundBuffer.numBytes >= session->outboundBuffer.numBytes);
+        }
+    }
     HAPRawBufferZero(storage->readContexts, storage->numReadContexts * sizeof *storage->readContexts);
     HAPRawBufferZero(storage->writeContexts, storage->numWriteContexts * sizeof *storage->writeContexts);
     HAPRawBufferZero(storage->scratchBuffer.bytes, storage->scratchBuffer.numBytes);
@@ -4092,6 +6731,8 @@ static void Create(HAPAccessoryServerRef* server_, const HAPAccessoryServerOptio
                 ipSession->numEventNotifications * sizeof *ipSession->eventNotifications);
     }
     server->ip.storage = options->ip.accessoryServerStorage;
+    server->ip.sessionIdleTimeouts.unverifiedSession = options->ip.sessionIdleTimeouts.unverifiedSession;
+    server->ip.sessionIdleTimeouts.verifiedSession = options->ip.sessionIdleTimeouts.verifiedSession;
 
     // Install server engine.
     HAPNonnull(server->transports.ip)->serverEngine.install();
@@ -4114,6 +6755,31 @@ static void PrepareStart(HAPAccessoryServerRef* server_) {
                 ipSession->eventNotifications,
                 ipSession->numEventNotifications * sizeof *ipSession->eventNotifications);
     }
+
+    // Link all pooled session buffers into the list of free pooled session buffers.
+    for (size_t i = 0; i < storage->numPooledSessionBuffers; i++) {
+        HAPIPSessionBuffers* buffers = &HAPNonnull(storage->pooledSessionBuffers)[i];
+        HAPRawBufferZero(buffers->inboundBuffer.bytes, buffers->inboundBuffer.numBytes);
+        HAPRawBufferZero(buffers->outboundBuffer.bytes, buffers->outboundBuffer.numBytes);
+        size_t nextFreeBuffers = i + 1 < storage->numPooledSessionBuffers ? i + 2 : 0;
+        HAPRawBufferCopyBytes(buffers->inboundBuffer.bytes, &nextFreeBuffers, sizeof nextFreeBuffers);
+    }
+    server->ip.sessionBufferPool.firstFreeBuffers = storage->numPooledSessionBuffers ? 1 : 0;
+    server->ip.sessionBufferPool.hasWaitingSessions = false;
+    server->ip.sessionBufferPool.statistics.numBorrowedBuffers = 0;
+
+    // Link all sessions into the list of free sessions.
+    InitializeSessionList(&server->ip.sessionLists.freeSessions, kHAPIPSessionListKind_Slot);
+    InitializeSessionList(&server->ip.sessionLists.openSessions, kHAPIPSessionListKind_Slot);
+    InitializeSessionList(&server->ip.sessionLists.closedSessions, kHAPIPSessionListKind_Slot);
+    InitializeSessionList(
+            &server->ip.sessionLists.eventNotificationSessions, kHAPIPSessionListKind_EventNotifications);
+    InitializeSessionList(&server->ip.sessionLists.waitingSessions, kHAPIPSessionListKind_Waiting);
+    InitializeSessionList(
+            &server->ip.sessionLists.asynchronousRequestSessions, kHAPIPSessionListKind_AsynchronousRequests);
+    for (size_t i = 0; i < storage->numSessions; i++) {
+        AppendSessionToList(&server->ip.sessionLists.freeSessions, &storage->sessions[i]);
+    }
 }
 
 static void WillStart(HAPAccessoryServerRef* server_) {
@@ -4163,7 +6829,38 @@ const HAPAccessoryServerServerEngine HAPIPAccessoryServerServerEngine = { .init
                                                                           .stop = engine_stop,
                                                                           .raise_event = engine_raise_event,
                                                                           .raise_event_on_session =
-                                                                                  engine_raise_event_on_session };
+                                                                                  engine_raise_event_on_session,
+                                                                          .complete_read = engine_complete_read,
+                                                                          .complete_write = engine_complete_write };
+
+void HAPAccessoryServerGetIPEventNotificationStatistics(
+        HAPAccessoryServerRef* server_,
+        HAPIPEventNotificationStatistics* statistics) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(statistics);
+
+    *statistics = server->ip.eventNotificationStatistics;
+    statistics->numQueuedEvents = 0;
+    if (!server->transports.ip) {
+        return;
+    }
+    for (HAPIPSession* _Nullable ipSession = server->ip.sessionLists.eventNotificationSessions.first; ipSession;
+         ipSession = GetNextSessionOfList(HAPNonnull(ipSession), kHAPIPSessionListKind_EventNotifications)) {
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+        statistics->numQueuedEvents += session->numEventNotificationFlags;
+    }
+}
+
+void HAPAccessoryServerGetIPSessionBufferPoolStatistics(
+        HAPAccessoryServerRef* server_,
+        HAPIPSessionBufferPoolStatistics* statistics) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(statistics);
+
+    *statistics = server->ip.sessionBufferPool.statistics;
+}
 
 HAP_RESULT_USE_CHECK
 size_t HAPAccessoryServerGetIPSessionIndex(const HAPAccessoryServerRef* server_, const HAPSessionRef* session) {
@@ -4173,19 +6870,40 @@ size_t HAPAccessoryServerGetIPSessionIndex(const HAPAccessoryServerRef* server_,
 
     const HAPIPAccessoryServerStorage* storage = HAPNonnull(server->ip.storage);
 
-    for (size_t i = 0; i < storage->numSessions; i++) {
-        HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &storage->sessions[i].descriptor;
-        if (!t->server) {
-            continue;
-        }
-        if (t->securitySession.type != kHAPIPSecuritySessionType_HAP) {
+    HAPIPSession* _Nullable ipSession = GetIPSessionForSecuritySession(server, session);
+    if (!ipSession) {
+        HAPFatalError();
+    }
+    HAPIPSessionDescriptor* t = (HAPIPSessionDescriptor*) &HAPNonnull(ipSession)->descriptor;
+    if (!t->server || t->securitySession.type != kHAPIPSecuritySessionType_HAP) {
+        HAPFatalError();
+    }
+    return (size_t)(HAPNonnull(ipSession) - storage->sessions);
+}
+
+void HAPAccessoryServerEnumerateIPSessions(
+        HAPAccessoryServerRef* server_,
+        HAPAccessoryServerEnumerateSessionsCallback callback,
+        void* _Nullable context,
+        bool* shouldContinue) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ip.storage);
+    HAPPrecondition(callback);
+    HAPPrecondition(shouldContinue);
+    HAPPrecondition(*shouldContinue);
+
+    HAPIPSession* _Nullable nextIPSession = server->ip.sessionLists.openSessions.first;
+    while (*shouldContinue && nextIPSession) {
+        HAPIPSession* ipSession = HAPNonnull(nextIPSession);
+        nextIPSession = GetNextSessionOfList(ipSession, kHAPIPSessionListKind_Slot);
+        HAPIPSessionDescriptor* session = (HAPIPSessionDescriptor*) &ipSession->descriptor;
+        HAPAssert(session->server == server_);
+        if (session->securitySession.type != kHAPIPSecuritySessionType_HAP) {
             continue;
         }
-        if (&t->securitySession._.hap == session) {
-            return i;
-        }
+        callback(context, server_, &session->securitySession._.hap, shouldContinue);
     }
-    HAPFatalError();
 }
 
 HAP_RESULT_USE_CHECK
@@ -4229,6 +6947,7 @@ void HAPIPSessionHandleReadRequest(
         const HAPCharacteristic* characteristic,
         const HAPService* service,
         const HAPAccessory* accessory,
+        HAPTypeID characteristicTypeID,
         HAPIPSessionReadResult* readResult,
         HAPIPByteBuffer* dataBuffer) {
     HAPPrecondition(session_);
@@ -4255,8 +6974,7 @@ void HAPIPSessionHandleReadRequest(
         HAPSessionControllerIsAdmin(&session->securitySession._.hap)) {
         if (baseCharacteristic->properties.readable) {
             if ((sessionContext != kHAPIPSessionContext_EventNotification) &&
-                HAPUUIDAreEqual(
-                        baseCharacteristic->characteristicType, &kHAPCharacteristicType_ProgrammableSwitchEvent)) {
+                characteristicTypeID == kHAPCharacteristicTypeID_ProgrammableSwitchEvent) {
                 // A read of this characteristic must always return a null value for IP accessories.
                 // See HomeKit Accessory Protocol Specification R14
                 // Section 9.75 Programmable Switch Event
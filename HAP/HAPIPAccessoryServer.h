@@ -39,6 +39,13 @@ typedef struct {
             const HAPService* service,
             const HAPAccessory* accessory,
             const HAPSessionRef* session);
+    void (*complete_read)(
+            HAPAccessoryServerRef* server,
+            HAPCompletionToken completionToken,
+            HAPError error,
+            const void* _Nullable valueBytes,
+            size_t numValueBytes);
+    void (*complete_write)(HAPAccessoryServerRef* server, HAPCompletionToken completionToken, HAPError error);
 } HAPAccessoryServerServerEngine;
 
 extern const HAPAccessoryServerServerEngine HAPIPAccessoryServerServerEngine;
@@ -123,7 +130,10 @@ HAP_ENUM_BEGIN(uint8_t, HAPIPSessionState) { /** Accessory server session is idl
                                              kHAPIPSessionState_Reading,
 
                                              /** Accessory server session is writing. */
-                                             kHAPIPSessionState_Writing
+                                             kHAPIPSessionState_Writing,
+
+                                             /** Accessory server session waits for asynchronous handlers. */
+                                             kHAPIPSessionState_Waiting
 } HAP_ENUM_END(uint8_t, HAPIPSessionState);
 
 /**
@@ -142,6 +152,28 @@ HAP_ENUM_BEGIN(uint8_t, HAPIPAccessoryServerContentType) { /** Unknown HTTP/1.1
                                                            kHAPIPAccessoryServerContentType_Application_PairingTLV8
 } HAP_ENUM_END(uint8_t, HAPIPAccessoryServerContentType);
 
+/**
+ * Streaming read state.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPIPStreamingReadState) { /** No streaming read is in progress. */
+                                                   kHAPIPStreamingReadState_Idle,
+
+                                                   /** Serializing the JSON prefix that precedes the value. */
+                                                   kHAPIPStreamingReadState_Prefix,
+
+                                                   /** Serializing the base64 encoded value. */
+                                                   kHAPIPStreamingReadState_Value,
+
+                                                   /** Serializing the JSON suffix that follows the value. */
+                                                   kHAPIPStreamingReadState_Suffix,
+
+                                                   /** The response has been serialized completely. */
+                                                   kHAPIPStreamingReadState_Complete,
+
+                                                   /** Reading the value failed after the response was started. */
+                                                   kHAPIPStreamingReadState_Aborted
+} HAP_ENUM_END(uint8_t, HAPIPStreamingReadState);
+
 /**
  * IP specific event notification state.
  */
@@ -154,9 +186,71 @@ typedef struct {
 
     /** Flag indicating whether an event has been raised for the given characteristic in the given accessory. */
     bool flag;
+
+    /**
+     * Whether the raised event has been deferred because the outbound buffer was full.
+     *
+     * - Deferred events are not coalesced again and are sent as soon as the outbound buffer has been written.
+     */
+    bool isDue;
 } HAPIPEventNotification;
 HAP_STATIC_ASSERT(sizeof(HAPIPEventNotificationRef) >= sizeof(HAPIPEventNotification), event_notification);
 
+/**
+ * Kind of IP session list. A session is linked into at most one list of each kind.
+ */
+HAP_ENUM_BEGIN(uint8_t, HAPIPSessionListKind) { /** Lists of free, open and closed sessions. */
+                                                kHAPIPSessionListKind_Slot,
+
+                                                /** Queue of sessions with raised events that have not been sent. */
+                                                kHAPIPSessionListKind_EventNotifications,
+
+                                                /** Queue of sessions in state kHAPIPSessionState_Waiting. */
+                                                kHAPIPSessionListKind_Waiting,
+
+                                                /** Queue of sessions with pending asynchronous handlers. */
+                                                kHAPIPSessionListKind_AsynchronousRequests
+} HAP_ENUM_END(uint8_t, HAPIPSessionListKind);
+
+/**
+ * Number of IP session list kinds.
+ */
+#define kHAPIPSessionListKind_NumKinds ((size_t) 4)
+
+/**
+ * Intrusive doubly linked list of IP sessions.
+ *
+ * - Sessions are linked through the list links of their session descriptor, so adding and removing sessions
+ *   does not depend on the number of sessions of the accessory server.
+ */
+typedef struct {
+    /** First session of the list. */
+    HAPIPSession* _Nullable first;
+
+    /** Last session of the list. */
+    HAPIPSession* _Nullable last;
+
+    /** Number of sessions in the list. */
+    size_t numSessions;
+
+    /** Kind of the list. */
+    HAPIPSessionListKind kind;
+} HAPIPSessionList;
+
+/**
+ * Links of an IP session in an IP session list.
+ */
+typedef struct {
+    /** List that contains the session. NULL if the session is not linked into a list of this kind. */
+    HAPIPSessionList* _Nullable list;
+
+    /** Previous session of the list. */
+    HAPIPSession* _Nullable prev;
+
+    /** Next session of the list. */
+    HAPIPSession* _Nullable next;
+} HAPIPSessionListLinks;
+
 /**
  * IP specific accessory server session descriptor.
  */
@@ -173,6 +267,9 @@ typedef struct {
     /** IP session state. */
     HAPIPSessionState state;
 
+    /** Links of the session in the session lists of the accessory server, indexed by HAPIPSessionListKind. */
+    HAPIPSessionListLinks listLinks[kHAPIPSessionListKind_NumKinds];
+
     /** Time stamp of last activity on this session. */
     HAPTime stamp;
 
@@ -194,6 +291,11 @@ typedef struct {
      */
     size_t outboundBufferMark;
 
+    /**
+     * Pooled session buffers that are used as inbound and outbound buffer. NULL if the resident buffers are used.
+     */
+    HAPIPSessionBuffers* _Nullable borrowedBuffers;
+
     /** HTTP reader. */
     struct util_http_reader httpReader;
 
@@ -303,6 +405,16 @@ typedef struct {
      */
     size_t numEventNotificationFlags;
 
+    /**
+     * The number of raised events on this session that have been deferred because the outbound buffer was full.
+     */
+    size_t numDueEventNotifications;
+
+    /**
+     * Flag indicating whether raised events on this session wait until pooled session buffers are returned.
+     */
+    bool eventNotificationsAreWaitingForBuffers;
+
     /**
      * Time stamp of last event notification on this session.
      */
@@ -324,9 +436,148 @@ typedef struct {
     HAPIPAccessorySerializationContext accessorySerializationContext;
 
     /**
-     * Flag indicating whether incremental serialization of accessory attribute database is in progress.
+     * Streaming read of a single Data characteristic value.
+     */
+    struct {
+        /** Characteristic whose value is read. */
+        const HAPDataCharacteristic* _Nullable characteristic;
+
+        /** The service that contains the characteristic. */
+        const HAPService* _Nullable service;
+
+        /** The accessory that provides the service. */
+        const HAPAccessory* _Nullable accessory;
+
+        /** Number of value bytes that have been read so far. */
+        size_t offset;
+
+        /** Number of bytes of the current JSON prefix or suffix that have been serialized. */
+        size_t numSerializedBytes;
+
+        /** Value bytes that have been read but not yet encoded (less than one base64 group). */
+        uint8_t pendingBytes[2];
+
+        /** Number of pending value bytes. */
+        uint8_t numPendingBytes;
+
+        /** Encoded base64 group that did not fit into the outbound buffer. */
+        char encodedBytes[4];
+
+        /** Number of encoded bytes that have not yet been serialized. */
+        uint8_t numEncodedBytes;
+
+        /** Flag indicating whether the end of the value has been reached. */
+        bool isValueComplete : 1;
+
+        /** Streaming read state. */
+        HAPIPStreamingReadState state;
+    } streamingRead;
+
+    /**
+     * Streaming write of a PUT /characteristics request whose body does not fit into the inbound buffer.
+     */
+    struct {
+        /** Parser for the request body. */
+        HAPIPWriteRequestParser parser;
+
+        /** Write request that is deferred until the "pid" of the request is known. */
+        HAPIPWriteContextRef deferredWriteContext;
+
+        /** Number of body bytes that have not yet been received. */
+        size_t numRemainingBodyBytes;
+
+        /** Number of write responses that have been serialized into the outbound buffer. */
+        size_t numWriteResponses;
+
+        /** Flag indicating whether a streaming write is in progress. */
+        bool isActive : 1;
+
+        /** Flag indicating whether the session uses the write staging buffer. */
+        bool hasStagingBuffer : 1;
+
+        /** Flag indicating whether a write request has been deferred. */
+        bool hasDeferredWriteContext : 1;
+
+        /** Flag indicating whether a write failed or requested a response. */
+        bool isMultiStatus : 1;
+
+        /** Flag indicating whether the write responses did not fit into the outbound buffer. */
+        bool isOutOfResources : 1;
+
+        /** Flag indicating whether the request body is malformed. */
+        bool isMalformed : 1;
+
+        /** Flag indicating whether the "pid" of the request has been validated. */
+        bool isPIDChecked : 1;
+
+        /** Flag indicating whether the "pid" of the request matches the prepared timed write. */
+        bool isPIDValid : 1;
+    } streamingWrite;
+
+    /**
+     * Request that waits for asynchronous read or write handlers to complete.
+     */
+    struct {
+        /** Number of read handlers that have not yet completed. */
+        size_t numPendingReads;
+
+        /** Number of read contexts of the GET /characteristics request that are saved in the outbound buffer. */
+        size_t numReadContexts;
+
+        /** Number of bytes of values of the saved read contexts. */
+        size_t numReadValueBytes;
+
+        /** Time after which pending reads and writes are reported as busy and cancelled. */
+        HAPTime expirationTime;
+
+        /** Accessory instance ID of the pending write. */
+        uint64_t aid;
+
+        /** Instance ID of the pending write. */
+        uint64_t iid;
+
+        /** Completion token of the pending write. */
+        HAPCompletionToken writeCompletionToken;
+
+        /** Index of the pending write in the write contexts of a PUT /characteristics request. */
+        size_t writeContextIndex;
+
+        /** Number of write contexts of the PUT /characteristics request. */
+        size_t numWriteContexts;
+
+        /** Result of the completed write. */
+        HAPError writeError;
+
+        /** Flag indicating whether a write handler has not yet completed. */
+        bool isWritePending : 1;
+
+        /** Flag indicating whether a write handler has completed and the request has not yet been resumed. */
+        bool isWriteCompleted : 1;
+
+        /** Flag indicating whether the write contexts of the request are saved in the outbound buffer. */
+        bool areWriteContextsSaved : 1;
+
+        /** Flag indicating whether the PUT /characteristics request is a valid Execute Write Request. */
+        bool isTimedWrite : 1;
+
+        /** Flag indicating whether the request waits until pooled session buffers are returned by another session. */
+        bool isWaitingForBuffers : 1;
+    } pendingRequest;
+
+    /**
+     * Flag indicating whether a response using chunked transfer encoding is in progress.
+     *
+     * - Used for incremental serialization of the accessory attribute database and for streaming reads.
+     */
+    bool chunkedResponseIsInProgress;
+
+    /**
+     * Flag indicating whether the read and write handlers that are called for the current request are assigned
+     * completion tokens.
+     *
+     * - Only set while the characteristic requests of GET and PUT /characteristics requests are dispatched.
      */
-    bool accessorySerializationIsInProgress;
+    bool handlersMayCompleteAsynchronously;
 } HAPIPSessionDescriptor;
 HAP_STATIC_ASSERT(sizeof(HAPIPSessionDescriptorRef) >= sizeof(HAPIPSessionDescriptor), HAPIPSessionDescriptor);
 
@@ -79,6 +79,7 @@ bool HAPIPSessionAreEventNotificationsEnabled(
  * @param      characteristic       The characteristic whose event notification state is to be returned.
  * @param      service              The service that contains the characteristic.
  * @param      accessory            The accessory that provides the service.
+ * @param      characteristicTypeID Interned characteristic type.
  * @param      readResult           The result of the of the read request.
  * @param      dataBuffer           Buffer to store data blobs, strings, or a set of one or more TLV8's.
  */
@@ -88,6 +89,7 @@ void HAPIPSessionHandleReadRequest(
         const HAPCharacteristic* characteristic,
         const HAPService* service,
         const HAPAccessory* accessory,
+        HAPTypeID characteristicTypeID,
         HAPIPSessionReadResult* readResult,
         HAPIPByteBuffer* dataBuffer);
 
@@ -102,8 +102,8 @@ static bool HAPMACAddressValidateRandomStaticBLEDeviceAddress(HAPMACAddress* mac
         { .bytes = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } },
     };
 
-    if (HAPRawBufferAreEqual(macAddress->bytes, invalidMACAddresses[0].bytes, sizeof(HAPMACAddress)) ||
-        HAPRawBufferAreEqual(macAddress->bytes, invalidMACAddresses[1].bytes, sizeof(HAPMACAddress))) {
+    if (HAPRawBufferAreEqualPublic(macAddress->bytes, invalidMACAddresses[0].bytes, sizeof(HAPMACAddress)) ||
+        HAPRawBufferAreEqualPublic(macAddress->bytes, invalidMACAddresses[1].bytes, sizeof(HAPMACAddress))) {
         return false;
     }
 
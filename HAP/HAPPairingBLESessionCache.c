@@ -7,18 +7,151 @@
 #include "HAP+Internal.h"
 
 /**
- * BLE: Pair Resume cache entry.
+ * BLE: Pair Resume cache element.
+ *
+ * - The session cache is a hash table keyed by session ID with one bucket per element.
+ *   Each element stores the head of its bucket, and the cache entry that it holds, if any.
+ *   Cache entries stay in their element until they are removed, so shared secrets are never copied within the cache.
+ *
+ * - Cache entries in use are linked into a list ordered by last use, used for eviction.
+ *   Released elements are linked into a free list through their bucket link.
+ *
+ * - Links refer to elements by index + 1, so that 0 denotes the end of a list and zeroed storage is an empty cache.
  */
 typedef struct {
-    HAPPairingBLESessionID sessionID;
-    uint8_t sharedSecret[X25519_SCALAR_BYTES];
-    int pairingID;
-    uint32_t lastUsed; // 0: invalid, >0: timestamp
-} HAPPairingBLESessionCacheEntry;
+    /** First cache entry in the bucket of this element (index + 1). 0 if the bucket is empty. */
+    uint16_t bucket;
+
+    /**
+     * Cache entry.
+     */
+    struct {
+        HAPPairingBLESessionID sessionID;
+        uint8_t sharedSecret[X25519_SCALAR_BYTES];
+        int16_t pairingID;
+
+        /** Next cache entry in the same bucket, or next released element (index + 1). */
+        uint16_t next;
+
+        /** Next more recently used cache entry (index + 1). */
+        uint16_t moreRecentlyUsed;
+
+        /** Next less recently used cache entry (index + 1). */
+        uint16_t lessRecentlyUsed;
+
+        bool isActive;
+    } entry;
+} HAPPairingBLESessionCacheElement;
 
 HAP_STATIC_ASSERT(
-        sizeof(HAPBLESessionCacheElementRef) >= sizeof(HAPPairingBLESessionCacheEntry),
-        HAPPairingBLESessionCacheEntry);
+        sizeof(HAPBLESessionCacheElementRef) >= sizeof(HAPPairingBLESessionCacheElement),
+        HAPPairingBLESessionCacheElement);
+
+/**
+ * Gets a session cache element by index.
+ *
+ * @param      server               Accessory server.
+ * @param      index                Index of the session cache element.
+ *
+ * @return Session cache element.
+ */
+HAP_RESULT_USE_CHECK
+static HAPPairingBLESessionCacheElement* GetElement(HAPAccessoryServer* server, size_t index) {
+    HAPPrecondition(server);
+    HAPPrecondition(index < server->ble.storage->numSessionCacheElements);
+
+    return (HAPPairingBLESessionCacheElement*) &server->ble.storage->sessionCacheElements[index];
+}
+
+/**
+ * Computes the bucket of a session ID.
+ *
+ * @param      server               Accessory server.
+ * @param      sessionID            Session ID.
+ *
+ * @return Index of the session cache element that holds the bucket.
+ */
+HAP_RESULT_USE_CHECK
+static size_t GetBucketIndex(HAPAccessoryServer* server, const HAPPairingBLESessionID* sessionID) {
+    HAPPrecondition(server);
+    HAPPrecondition(sessionID);
+
+    // Session IDs are derived from the shared secret using HKDF and are uniformly distributed.
+    // Multiplicative hashing still spreads session IDs that only differ in a few bits.
+    uint64_t hash = HAPReadLittleUInt64(sessionID->value) * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t)((hash >> 32) % server->ble.storage->numSessionCacheElements);
+}
+
+/**
+ * Finds the cache entry for a session ID.
+ *
+ * @param      server               Accessory server.
+ * @param      sessionID            Session ID.
+ * @param[out] index                Index of the session cache element holding the cache entry, if found.
+ *
+ * @return true                     If a cache entry was found.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool FindEntry(HAPAccessoryServer* server, const HAPPairingBLESessionID* sessionID, size_t* index) {
+    HAPPrecondition(server);
+    HAPPrecondition(sessionID);
+    HAPPrecondition(index);
+
+    for (uint16_t link = GetElement(server, GetBucketIndex(server, sessionID))->bucket; link;) {
+        const HAPPairingBLESessionCacheElement* element = GetElement(server, link - 1U);
+        HAPAssert(element->entry.isActive);
+        // Session IDs identify resumable shared secrets. Compare them in constant time.
+        if (HAPRawBufferAreEqual(&element->entry.sessionID, sessionID, sizeof *sessionID)) {
+            *index = link - 1U;
+            return true;
+        }
+        link = element->entry.next;
+    }
+    return false;
+}
+
+/**
+ * Removes a cache entry and zeroes its shared secret. The session cache element is released.
+ *
+ * @param      server               Accessory server.
+ * @param      index                Index of the session cache element holding the cache entry.
+ */
+static void RemoveEntry(HAPAccessoryServer* server, size_t index) {
+    HAPPrecondition(server);
+
+    HAPPairingBLESessionCacheElement* element = GetElement(server, index);
+    HAPAssert(element->entry.isActive);
+
+    // Unlink from bucket.
+    uint16_t* link = &GetElement(server, GetBucketIndex(server, &element->entry.sessionID))->bucket;
+    while (*link != index + 1) {
+        HAPAssert(*link);
+        link = &GetElement(server, *link - 1U)->entry.next;
+    }
+    *link = element->entry.next;
+
+    // Unlink from list ordered by last use.
+    if (element->entry.moreRecentlyUsed) {
+        GetElement(server, element->entry.moreRecentlyUsed - 1U)->entry.lessRecentlyUsed =
+                element->entry.lessRecentlyUsed;
+    } else {
+        HAPAssert(server->ble.sessionCache.mostRecentlyUsed == index + 1);
+        server->ble.sessionCache.mostRecentlyUsed = element->entry.lessRecentlyUsed;
+    }
+    if (element->entry.lessRecentlyUsed) {
+        GetElement(server, element->entry.lessRecentlyUsed - 1U)->entry.moreRecentlyUsed =
+                element->entry.moreRecentlyUsed;
+    } else {
+        HAPAssert(server->ble.sessionCache.leastRecentlyUsed == index + 1);
+        server->ble.sessionCache.leastRecentlyUsed = element->entry.moreRecentlyUsed;
+    }
+
+    // Zero entry and release element.
+    HAPRawBufferZero(&element->entry, sizeof element->entry);
+    element->entry.next = server->ble.sessionCache.firstFreeEntry;
+    server->ble.sessionCache.firstFreeEntry = (uint16_t)(index + 1);
+}
 
 void HAPPairingBLESessionCacheFetch(
         HAPAccessoryServerRef* server_,
@@ -33,16 +166,13 @@ void HAPPairingBLESessionCacheFetch(
     HAPPrecondition(pairingID);
 
     // Fetch session.
-    for (size_t i = 0; i < server->ble.storage->numSessionCacheElements; i++) {
-        HAPPairingBLESessionCacheEntry* cacheEntry =
-                (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[i];
-
-        if (cacheEntry->lastUsed && HAPRawBufferAreEqual(&cacheEntry->sessionID, sessionID, sizeof *sessionID)) {
-            HAPRawBufferCopyBytes(sharedSecret, cacheEntry->sharedSecret, sizeof cacheEntry->sharedSecret);
-            *pairingID = cacheEntry->pairingID;
-            HAPRawBufferZero(cacheEntry, sizeof *cacheEntry);
-            return;
-        }
+    size_t index;
+    if (FindEntry(server, sessionID, &index)) {
+        const HAPPairingBLESessionCacheElement* element = GetElement(server, index);
+        HAPRawBufferCopyBytes(sharedSecret, element->entry.sharedSecret, sizeof element->entry.sharedSecret);
+        *pairingID = element->entry.pairingID;
+        RemoveEntry(server, index);
+        return;
     }
 
     // Not found.
@@ -60,45 +190,52 @@ void HAPPairingBLESessionCacheSave(
     HAPPrecondition(sessionID);
     HAPPrecondition(sharedSecret);
     HAPPrecondition(pairingID >= 0);
+    HAPPrecondition(pairingID <= INT16_MAX);
 
-    // Find free cache entry.
-    size_t index = 0;
-    {
-        // Search least recently used.
-        uint32_t min = UINT32_MAX;
-        for (size_t i = 0; i < server->ble.storage->numSessionCacheElements; i++) {
-            HAPPairingBLESessionCacheEntry* cacheEntry =
-                    (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[i];
-
-            if (cacheEntry->lastUsed < min) {
-                min = cacheEntry->lastUsed;
-                index = i;
-            }
-        }
+    // Remove previous session with the same session ID.
+    size_t index;
+    if (FindEntry(server, sessionID, &index)) {
+        RemoveEntry(server, index);
+    }
+
+    // Find free cache element.
+    if (server->ble.sessionCache.firstFreeEntry) {
+        index = server->ble.sessionCache.firstFreeEntry - 1U;
+        server->ble.sessionCache.firstFreeEntry = GetElement(server, index)->entry.next;
+    } else if (server->ble.sessionCache.numInitializedEntries < server->ble.storage->numSessionCacheElements) {
+        index = server->ble.sessionCache.numInitializedEntries++;
+    } else {
+        // Evict least recently used.
+        HAPAssert(server->ble.sessionCache.leastRecentlyUsed);
+        index = server->ble.sessionCache.leastRecentlyUsed - 1U;
+        RemoveEntry(server, index);
+        HAPAssert(server->ble.sessionCache.firstFreeEntry == index + 1);
+        server->ble.sessionCache.firstFreeEntry = GetElement(server, index)->entry.next;
     }
-    HAPPairingBLESessionCacheEntry* cacheEntry =
-            (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[index];
+    HAPPairingBLESessionCacheElement* element = GetElement(server, index);
+    HAPAssert(!element->entry.isActive);
 
     // Save session.
-    HAPRawBufferCopyBytes(&cacheEntry->sessionID, sessionID, sizeof *sessionID);
-    HAPRawBufferCopyBytes(cacheEntry->sharedSecret, sharedSecret, sizeof cacheEntry->sharedSecret);
-    cacheEntry->pairingID = pairingID;
-
-    // Update least recently used.
-    server->ble.sessionCacheTimestamp++;
-    if (server->ble.sessionCacheTimestamp == 0) {
-        // Overflow => reset time stamps.
-        for (size_t i = 0; i < server->ble.storage->numSessionCacheElements; i++) {
-            HAPPairingBLESessionCacheEntry* e =
-                    (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[i];
-
-            if (e->lastUsed) {
-                e->lastUsed = 1;
-            }
-        }
-        server->ble.sessionCacheTimestamp = 2;
+    HAPRawBufferCopyBytes(&element->entry.sessionID, sessionID, sizeof *sessionID);
+    HAPRawBufferCopyBytes(element->entry.sharedSecret, sharedSecret, sizeof element->entry.sharedSecret);
+    element->entry.pairingID = (int16_t) pairingID;
+    element->entry.isActive = true;
+
+    // Link into bucket.
+    HAPPairingBLESessionCacheElement* bucketElement = GetElement(server, GetBucketIndex(server, sessionID));
+    element->entry.next = bucketElement->bucket;
+    bucketElement->bucket = (uint16_t)(index + 1);
+
+    // Link as most recently used.
+    element->entry.moreRecentlyUsed = 0;
+    element->entry.lessRecentlyUsed = server->ble.sessionCache.mostRecentlyUsed;
+    if (server->ble.sessionCache.mostRecentlyUsed) {
+        GetElement(server, server->ble.sessionCache.mostRecentlyUsed - 1U)->entry.moreRecentlyUsed =
+                (uint16_t)(index + 1);
+    } else {
+        server->ble.sessionCache.leastRecentlyUsed = (uint16_t)(index + 1);
     }
-    cacheEntry->lastUsed = server->ble.sessionCacheTimestamp;
+    server->ble.sessionCache.mostRecentlyUsed = (uint16_t)(index + 1);
 }
 
 void HAPPairingBLESessionCacheInvalidateEntriesForPairing(HAPAccessoryServerRef* server_, int pairingID) {
@@ -108,12 +245,22 @@ void HAPPairingBLESessionCacheInvalidateEntriesForPairing(HAPAccessoryServerRef*
     HAPPrecondition(pairingID >= 0);
 
     // Remove sessions for pairing. There may be multiple (e.g. pairing synced to multiple controllers).
-    for (size_t i = 0; i < server->ble.storage->numSessionCacheElements; i++) {
-        HAPPairingBLESessionCacheEntry* cacheEntry =
-                (HAPPairingBLESessionCacheEntry*) &server->ble.storage->sessionCacheElements[i];
+    for (size_t i = 0; i < server->ble.sessionCache.numInitializedEntries; i++) {
+        const HAPPairingBLESessionCacheElement* element = GetElement(server, i);
 
-        if (cacheEntry->pairingID == pairingID) {
-            HAPRawBufferZero(cacheEntry, sizeof *cacheEntry);
+        if (element->entry.isActive && element->entry.pairingID == pairingID) {
+            RemoveEntry(server, i);
         }
     }
 }
+
+void HAPPairingBLESessionCacheInvalidateAllEntries(HAPAccessoryServerRef* server_) {
+    HAPPrecondition(server_);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) server_;
+    HAPPrecondition(server->ble.storage);
+
+    HAPRawBufferZero(
+            server->ble.storage->sessionCacheElements,
+            server->ble.storage->numSessionCacheElements * sizeof *server->ble.storage->sessionCacheElements);
+    HAPRawBufferZero(&server->ble.sessionCache, sizeof server->ble.sessionCache);
+}
@@ -69,6 +69,13 @@ void HAPPairingBLESessionCacheSave(
  */
 void HAPPairingBLESessionCacheInvalidateEntriesForPairing(HAPAccessoryServerRef* server, int pairingID);
 
+/**
+ * Invalidates all Pair Resume cache entries.
+ *
+ * @param      server               Accessory server.
+ */
+void HAPPairingBLESessionCacheInvalidateAllEntries(HAPAccessoryServerRef* server);
+
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
 #endif
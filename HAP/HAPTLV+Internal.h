@@ -140,6 +140,26 @@ typedef struct {
 } HAPTLVWriter;
 HAP_STATIC_ASSERT(sizeof(HAPTLVWriterRef) >= sizeof(HAPTLVWriter), HAPTLVWriter);
 
+/**
+ * Appends serialized TLV data to a TLV writer.
+ *
+ * - The serialized TLV data must have been produced by a TLV writer and is copied as is.
+ *
+ * @param      writer               Writer to append TLV data to.
+ * @param      bytes                Serialized TLV data.
+ * @param      numBytes             Length of serialized TLV data.
+ * @param      lastType             Type of the last TLV item in the serialized TLV data.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_OutOfResources If writer does not have enough capacity.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPTLVWriterAppendSerialized(
+        HAPTLVWriterRef* writer,
+        const void* bytes,
+        size_t numBytes,
+        HAPTLVType lastType);
+
 /**
  * Allocates bytes of memory inside a scratch buffer.
  *
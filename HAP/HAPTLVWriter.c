@@ -79,6 +79,36 @@ HAPError HAPTLVWriterAppend(HAPTLVWriterRef* writer_, const HAPTLV* tlv) {
     return kHAPError_None;
 }
 
+HAP_RESULT_USE_CHECK
+HAPError HAPTLVWriterAppendSerialized(
+        HAPTLVWriterRef* writer_,
+        const void* bytes_,
+        size_t numBytes,
+        HAPTLVType lastType) {
+    HAPPrecondition(writer_);
+    HAPTLVWriter* writer = (HAPTLVWriter*) writer_;
+    HAPPrecondition(bytes_);
+    const uint8_t* bytes = bytes_;
+
+    if (!numBytes) {
+        return kHAPError_None;
+    }
+    HAPPrecondition(numBytes >= 2);
+    if (writer->numBytes) {
+        HAPPrecondition(bytes[0] != writer->lastType);
+    }
+
+    if (writer->maxBytes - writer->numBytes < numBytes) {
+        HAPLog(&logObject, "Not enough memory to write serialized TLV data.");
+        return kHAPError_OutOfResources;
+    }
+    uint8_t* destinationBytes = HAPNonnullVoid(writer->bytes);
+    HAPRawBufferCopyBytes(&destinationBytes[writer->numBytes], bytes, numBytes);
+    writer->numBytes += numBytes;
+    writer->lastType = lastType;
+    return kHAPError_None;
+}
+
 void HAPTLVWriterGetBuffer(const HAPTLVWriterRef* writer_, void* _Nonnull* _Nonnull bytes, size_t* numBytes) {
     HAPPrecondition(writer_);
     const HAPTLVWriter* writer = (const HAPTLVWriter*) writer_;
@@ -13,7 +13,7 @@ bool HAPUUIDAreEqual(const HAPUUID* uuid, const HAPUUID* otherUUID) {
     HAPPrecondition(uuid);
     HAPPrecondition(otherUUID);
 
-    return HAPRawBufferAreEqual(uuid->bytes, otherUUID->bytes, sizeof uuid->bytes);
+    return HAPRawBufferAreEqualPublic(uuid->bytes, otherUUID->bytes, sizeof uuid->bytes);
 }
 
 HAP_RESULT_USE_CHECK
@@ -23,7 +23,7 @@ bool HAPUUIDIsAppleDefined(const HAPUUID* uuid) {
     // See HomeKit Accessory Protocol Specification R14
     // Section 6.6.1 Service and Characteristic Types
     static const uint8_t hapBase[] = { 0x91, 0x52, 0x76, 0xBB, 0x26, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00 };
-    return HAPRawBufferAreEqual(uuid->bytes, hapBase, sizeof hapBase) != 0;
+    return HAPRawBufferAreEqualPublic(uuid->bytes, hapBase, sizeof hapBase) != 0;
 }
 
 HAP_RESULT_USE_CHECK
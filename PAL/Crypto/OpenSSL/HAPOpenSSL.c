@@ -434,6 +434,17 @@ static void copy_and_free_if_overlapping(uint8_t** tmp, uint8_t** out, size_t n)
     }
 }
 
+// OpenSSL 3 only accepts 96-bit nonces for ChaCha20-Poly1305. Shorter nonces are zero-padded at the front,
+// which is equivalent for messages below 256 GB.
+#define CHACHA20_POLY1305_NONCE_BYTES_MAX 12
+
+static const uint8_t* get_padded_nonce(uint8_t iv[CHACHA20_POLY1305_NONCE_BYTES_MAX], const uint8_t* n, size_t n_len) {
+    HAPPrecondition(n_len <= CHACHA20_POLY1305_NONCE_BYTES_MAX);
+    memset(iv, 0, CHACHA20_POLY1305_NONCE_BYTES_MAX - n_len);
+    memcpy(&iv[CHACHA20_POLY1305_NONCE_BYTES_MAX - n_len], n, n_len);
+    return iv;
+}
+
 void HAP_chacha20_poly1305_init(
         HAP_chacha20_poly1305_ctx* ctx,
         const uint8_t* n,
@@ -459,9 +470,8 @@ void HAP_chacha20_poly1305_update_enc(
         HAPAssert(ret == 1);
         ret = EVP_CIPHER_CTX_ctrl(handle->ctx, EVP_CTRL_AEAD_SET_TAG, CHACHA20_POLY1305_TAG_BYTES, NULL);
         HAPAssert(ret == 1);
-        ret = EVP_CIPHER_CTX_ctrl(handle->ctx, EVP_CTRL_AEAD_SET_IVLEN, n_len, NULL);
-        HAPAssert(ret == 1);
-        ret = EVP_EncryptInit_ex(handle->ctx, NULL, NULL, k, n);
+        uint8_t iv[CHACHA20_POLY1305_NONCE_BYTES_MAX];
+        ret = EVP_EncryptInit_ex(handle->ctx, NULL, NULL, k, get_padded_nonce(iv, n, n_len));
         HAPAssert(ret == 1);
     }
     if (m_len > 0) {
@@ -512,9 +522,8 @@ void HAP_chacha20_poly1305_update_dec(
         handle->ctx = EVP_CIPHER_CTX_new();
         int ret = EVP_DecryptInit_ex(handle->ctx, EVP_chacha20_poly1305(), 0, 0, 0);
         HAPAssert(ret == 1);
-        ret = EVP_CIPHER_CTX_ctrl(handle->ctx, EVP_CTRL_AEAD_SET_IVLEN, n_len, NULL);
-        HAPAssert(ret == 1);
-        ret = EVP_DecryptInit_ex(handle->ctx, NULL, NULL, k, n);
+        uint8_t iv[CHACHA20_POLY1305_NONCE_BYTES_MAX];
+        ret = EVP_DecryptInit_ex(handle->ctx, NULL, NULL, k, get_padded_nonce(iv, n, n_len));
         HAPAssert(ret == 1);
     }
     if (c_len > 0) {
@@ -59,18 +59,6 @@ static int32_t BigintComp(const Bigint* x, const Bigint* y) {
     return 0;
 }
 
-// z = x + y
-static void BigintAdd(const Bigint* x, const Bigint* y, Bigint* z) {
-    uint32_t c = 0, i = 0, nx = x->len, ny = y->len;
-    while (i < nx || i < ny || c != 0) {
-        c += (i < nx ? x->w[i] : 0) + (i < ny ? y->w[i] : 0);
-        z->w[i] = c & kInt_BitMask;
-        c >>= kInt_BitsPerWord;
-        i++;
-    }
-    z->len = i;
-}
-
 // x = x * n, 2 <= n <= 10
 static void BigintMul(Bigint* x, uint32_t n) {
     uint32_t c = 0, i = 0, nx = x->len;
@@ -110,6 +98,474 @@ static uint32_t BigintDivRem(Bigint* x, const Bigint* y) {
     return q;
 }
 
+//----------------------------- 64-bit Helpers ------------------------------
+
+// Returns the number of leading zero bits of x, x != 0
+static int CountLeadingZeros64(uint64_t x) {
+    HAPAssert(x);
+#if __has_builtin(__builtin_clzll) || defined(__GNUC__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    while (!(x & 0x8000000000000000)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// (high, low) = x * y
+static void Multiply64(uint64_t x, uint64_t y, uint64_t* high, uint64_t* low) {
+    uint64_t xLo = (uint32_t) x, xHi = x >> 32;
+    uint64_t yLo = (uint32_t) y, yHi = y >> 32;
+    uint64_t p0 = xLo * yLo, p1 = xLo * yHi, p2 = xHi * yLo, p3 = xHi * yHi;
+    uint64_t mid = (p0 >> 32) + (uint32_t) p1 + (uint32_t) p2;
+    *low = (mid << 32) | (uint32_t) p0;
+    *high = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+}
+
+//----------------------------- Shortest Decimal (Ryu) ------------------------------
+
+// See Ulf Adams, "Ryu: Fast Float-to-String Conversion", PLDI 2018.
+
+#define kRyu_Pow5InvBitCount (59)
+#define kRyu_Pow5BitCount    (61)
+
+// ceil(2^(pow5bits(i) - 1 + kRyu_Pow5InvBitCount) / 5^i)
+static const uint64_t ryuPow5InvSplit[31] = {
+    0x0800000000000001, 0x0666666666666667, 0x051EB851EB851EB9, 0x04189374BC6A7EFA,
+    0x068DB8BAC710CB2A, 0x053E2D6238DA3C22, 0x0431BDE82D7B634E, 0x06B5FCA6AF2BD216,
+    0x055E63B88C230E78, 0x044B82FA09B5A52D, 0x06DF37F675EF6EAE, 0x057F5FF85E592558,
+    0x0465E6604B7A8447, 0x0709709A125DA071, 0x05A126E1A84AE6C1, 0x0480EBE7B9D58567,
+    0x0734ACA5F6226F0B, 0x05C3BD5191B525A3, 0x049C97747490EAE9, 0x0760F253EDB4AB0E,
+    0x05E72843249088D8, 0x04B8ED0283A6D3E0, 0x078E480405D7B966, 0x060B6CD004AC9452,
+    0x04D5F0A66A23A9DB, 0x07BCB43D769F762B, 0x063090312BB2C4EF, 0x04F3A68DBC8F03F3,
+    0x07EC3DAF94180651, 0x065697BFA9ACD1DA, 0x051212FFBAF0A7E2,
+};
+
+// 5^i normalized to kRyu_Pow5BitCount bits
+static const uint64_t ryuPow5Split[47] = {
+    0x1000000000000000, 0x1400000000000000, 0x1900000000000000, 0x1F40000000000000,
+    0x1388000000000000, 0x186A000000000000, 0x1E84800000000000, 0x1312D00000000000,
+    0x17D7840000000000, 0x1DCD650000000000, 0x12A05F2000000000, 0x174876E800000000,
+    0x1D1A94A200000000, 0x12309CE540000000, 0x16BCC41E90000000, 0x1C6BF52634000000,
+    0x11C37937E0800000, 0x16345785D8A00000, 0x1BC16D674EC80000, 0x1158E460913D0000,
+    0x15AF1D78B58C4000, 0x1B1AE4D6E2EF5000, 0x10F0CF064DD59200, 0x152D02C7E14AF680,
+    0x1A784379D99DB420, 0x108B2A2C28029094, 0x14ADF4B7320334B9, 0x19D971E4FE8401E7,
+    0x1027E72F1F128130, 0x1431E0FAE6D7217C, 0x193E5939A08CE9DB, 0x1F8DEF8808B02452,
+    0x13B8B5B5056E16B3, 0x18A6E32246C99C60, 0x1ED09BEAD87C0378, 0x13426172C74D822B,
+    0x1812F9CF7920E2B6, 0x1E17B84357691B64, 0x12CED32A16A1B11E, 0x178287F49C4A1D66,
+    0x1D6329F1C35CA4BF, 0x125DFA371A19E6F7, 0x16F578C4E0A060B5, 0x1CB2D6F618C878E3,
+    0x11EFC659CF7D4B8D, 0x166BB7F0435C9E71, 0x1C06A5EC5433C60D,
+};
+
+// Returns ceil(log2(5^e)), 0 <= e <= 3528 (1 for e == 0)
+static int32_t Pow5Bits(int32_t e) {
+    return (int32_t)(((uint32_t) e * 1217359) >> 19) + 1;
+}
+
+// Returns floor(log10(2^e)), 0 <= e <= 1650
+static uint32_t Log10Pow2(int32_t e) {
+    return ((uint32_t) e * 78913) >> 18;
+}
+
+// Returns floor(log10(5^e)), 0 <= e <= 2620
+static uint32_t Log10Pow5(int32_t e) {
+    return ((uint32_t) e * 732923) >> 20;
+}
+
+// Returns true if value is divisible by 5^p
+static bool IsMultipleOfPowerOf5(uint32_t value, uint32_t p) {
+    uint32_t count = 0;
+    while (value && value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+// Returns true if value is divisible by 2^p
+static bool IsMultipleOfPowerOf2(uint32_t value, uint32_t p) {
+    return (value & ((1U << p) - 1)) == 0;
+}
+
+// Returns (m * factor) >> shift, shift > 32
+static uint32_t MulShift32(uint32_t m, uint64_t factor, int32_t shift) {
+    HAPAssert(shift > 32);
+    uint64_t bits0 = (uint64_t) m * (uint32_t) factor;
+    uint64_t bits1 = (uint64_t) m * (uint32_t)(factor >> 32);
+    uint64_t sum = (bits0 >> 32) + bits1;
+    return (uint32_t)(sum >> (shift - 32));
+}
+
+// Computes the shortest decimal that rounds to the float given by mant * 2^exp2 (without hidden bit and bias).
+// |value| == *digits * 10^*exp10, *digits < 10^9
+static void RyuGetShortestDecimal(uint32_t mant, int exp2, uint32_t* digits, int32_t* exp10) {
+    int32_t e2;
+    uint32_t m2;
+    if (exp2 == 0) { // denormalized
+        e2 = 1 - 127 - 23 - 2;
+        m2 = mant;
+    } else { // normalized
+        e2 = exp2 - 127 - 23 - 2;
+        m2 = 0x800000 | mant;
+    }
+    bool acceptBounds = (m2 & 1) == 0; // Round to even.
+
+    // Interval of values that round to the float: [mm, mp] * 2^e2 (bounds included if acceptBounds).
+    uint32_t mv = 4 * m2;
+    uint32_t mp = 4 * m2 + 2;
+    uint32_t mmShift = mant != 0 || exp2 <= 1; // Lower delta is delta/2 at power of 2 boundaries.
+    uint32_t mm = 4 * m2 - 1 - mmShift;
+
+    // Convert to decimal: [vm, vp] * 10^e10.
+    uint32_t vr, vp, vm;
+    int32_t e10;
+    bool vmIsTrailingZeros = false;
+    bool vrIsTrailingZeros = false;
+    uint32_t lastRemovedDigit = 0;
+    if (e2 >= 0) {
+        uint32_t q = Log10Pow2(e2);
+        e10 = (int32_t) q;
+        int32_t k = kRyu_Pow5InvBitCount + Pow5Bits((int32_t) q) - 1;
+        int32_t i = -e2 + (int32_t) q + k;
+        vr = MulShift32(mv, ryuPow5InvSplit[q], i);
+        vp = MulShift32(mp, ryuPow5InvSplit[q], i);
+        vm = MulShift32(mm, ryuPow5InvSplit[q], i);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            // One removed digit is needed even if no digits are removed below.
+            int32_t l = kRyu_Pow5InvBitCount + Pow5Bits((int32_t)(q - 1)) - 1;
+            lastRemovedDigit = MulShift32(mv, ryuPow5InvSplit[q - 1], -e2 + (int32_t) q - 1 + l) % 10;
+        }
+        if (q <= 9) {
+            // Only one of mp, mv and mm can be a multiple of 5, if any.
+            if (mv % 5 == 0) {
+                vrIsTrailingZeros = IsMultipleOfPowerOf5(mv, q);
+            } else if (acceptBounds) {
+                vmIsTrailingZeros = IsMultipleOfPowerOf5(mm, q);
+            } else {
+                vp -= IsMultipleOfPowerOf5(mp, q);
+            }
+        }
+    } else {
+        uint32_t q = Log10Pow5(-e2);
+        e10 = (int32_t) q + e2;
+        int32_t i = -e2 - (int32_t) q;
+        int32_t k = Pow5Bits(i) - kRyu_Pow5BitCount;
+        int32_t j = (int32_t) q - k;
+        vr = MulShift32(mv, ryuPow5Split[i], j);
+        vp = MulShift32(mp, ryuPow5Split[i], j);
+        vm = MulShift32(mm, ryuPow5Split[i], j);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            j = (int32_t) q - 1 - (Pow5Bits(i + 1) - kRyu_Pow5BitCount);
+            lastRemovedDigit = MulShift32(mv, ryuPow5Split[i + 1], j) % 10;
+        }
+        if (q <= 1) {
+            // mv = 4 * m2 always has at least two trailing zero bits.
+            vrIsTrailingZeros = true;
+            if (acceptBounds) {
+                vmIsTrailingZeros = mmShift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 31) {
+            vrIsTrailingZeros = IsMultipleOfPowerOf2(mv, q - 1);
+        }
+    }
+
+    // Remove digits while the interval still contains a shorter decimal.
+    int32_t removed = 0;
+    uint32_t output;
+    if (vmIsTrailingZeros || vrIsTrailingZeros) {
+        while (vp / 10 > vm / 10) {
+            vmIsTrailingZeros &= vm % 10 == 0;
+            vrIsTrailingZeros &= lastRemovedDigit == 0;
+            lastRemovedDigit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vmIsTrailingZeros) {
+            while (vm % 10 == 0) {
+                vrIsTrailingZeros &= lastRemovedDigit == 0;
+                lastRemovedDigit = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+            // Round to even.
+            lastRemovedDigit = 4;
+        }
+        output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+    } else {
+        while (vp / 10 > vm / 10) {
+            lastRemovedDigit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || lastRemovedDigit >= 5);
+    }
+    *digits = output;
+    *exp10 = e10 + removed;
+}
+
+//----------------------------- Decimal to Binary (Eisel-Lemire) ------------------------------
+
+// See Daniel Lemire, "Number Parsing at a Gigabyte per Second", Software: Practice and Experience 51(8), 2021.
+
+#define kFloat_MinPowerOf10 (-64)
+#define kFloat_MaxPowerOf10 (38)
+
+// 5^q normalized to 128 bits (most significant bit set), kFloat_MinPowerOf10 <= q <= kFloat_MaxPowerOf10.
+// Negative powers are rounded up.
+static const uint64_t powersOf5[][2] = {
+    { 0xA87FEA27A539E9A5, 0x3F2398D747B36224 }, // 5^-64
+    { 0xD29FE4B18E88640E, 0x8EEC7F0D19A03AAD }, // 5^-63
+    { 0x83A3EEEEF9153E89, 0x1953CF68300424AC }, // 5^-62
+    { 0xA48CEAAAB75A8E2B, 0x5FA8C3423C052DD7 }, // 5^-61
+    { 0xCDB02555653131B6, 0x3792F412CB06794D }, // 5^-60
+    { 0x808E17555F3EBF11, 0xE2BBD88BBEE40BD0 }, // 5^-59
+    { 0xA0B19D2AB70E6ED6, 0x5B6ACEAEAE9D0EC4 }, // 5^-58
+    { 0xC8DE047564D20A8B, 0xF245825A5A445275 }, // 5^-57
+    { 0xFB158592BE068D2E, 0xEED6E2F0F0D56712 }, // 5^-56
+    { 0x9CED737BB6C4183D, 0x55464DD69685606B }, // 5^-55
+    { 0xC428D05AA4751E4C, 0xAA97E14C3C26B886 }, // 5^-54
+    { 0xF53304714D9265DF, 0xD53DD99F4B3066A8 }, // 5^-53
+    { 0x993FE2C6D07B7FAB, 0xE546A8038EFE4029 }, // 5^-52
+    { 0xBF8FDB78849A5F96, 0xDE98520472BDD033 }, // 5^-51
+    { 0xEF73D256A5C0F77C, 0x963E66858F6D4440 }, // 5^-50
+    { 0x95A8637627989AAD, 0xDDE7001379A44AA8 }, // 5^-49
+    { 0xBB127C53B17EC159, 0x5560C018580D5D52 }, // 5^-48
+    { 0xE9D71B689DDE71AF, 0xAAB8F01E6E10B4A6 }, // 5^-47
+    { 0x9226712162AB070D, 0xCAB3961304CA70E8 }, // 5^-46
+    { 0xB6B00D69BB55C8D1, 0x3D607B97C5FD0D22 }, // 5^-45
+    { 0xE45C10C42A2B3B05, 0x8CB89A7DB77C506A }, // 5^-44
+    { 0x8EB98A7A9A5B04E3, 0x77F3608E92ADB242 }, // 5^-43
+    { 0xB267ED1940F1C61C, 0x55F038B237591ED3 }, // 5^-42
+    { 0xDF01E85F912E37A3, 0x6B6C46DEC52F6688 }, // 5^-41
+    { 0x8B61313BBABCE2C6, 0x2323AC4B3B3DA015 }, // 5^-40
+    { 0xAE397D8AA96C1B77, 0xABEC975E0A0D081A }, // 5^-39
+    { 0xD9C7DCED53C72255, 0x96E7BD358C904A21 }, // 5^-38
+    { 0x881CEA14545C7575, 0x7E50D64177DA2E54 }, // 5^-37
+    { 0xAA242499697392D2, 0xDDE50BD1D5D0B9E9 }, // 5^-36
+    { 0xD4AD2DBFC3D07787, 0x955E4EC64B44E864 }, // 5^-35
+    { 0x84EC3C97DA624AB4, 0xBD5AF13BEF0B113E }, // 5^-34
+    { 0xA6274BBDD0FADD61, 0xECB1AD8AEACDD58E }, // 5^-33
+    { 0xCFB11EAD453994BA, 0x67DE18EDA5814AF2 }, // 5^-32
+    { 0x81CEB32C4B43FCF4, 0x80EACF948770CED7 }, // 5^-31
+    { 0xA2425FF75E14FC31, 0xA1258379A94D028D }, // 5^-30
+    { 0xCAD2F7F5359A3B3E, 0x096EE45813A04330 }, // 5^-29
+    { 0xFD87B5F28300CA0D, 0x8BCA9D6E188853FC }, // 5^-28
+    { 0x9E74D1B791E07E48, 0x775EA264CF55347E }, // 5^-27
+    { 0xC612062576589DDA, 0x95364AFE032A819E }, // 5^-26
+    { 0xF79687AED3EEC551, 0x3A83DDBD83F52205 }, // 5^-25
+    { 0x9ABE14CD44753B52, 0xC4926A9672793543 }, // 5^-24
+    { 0xC16D9A0095928A27, 0x75B7053C0F178294 }, // 5^-23
+    { 0xF1C90080BAF72CB1, 0x5324C68B12DD6339 }, // 5^-22
+    { 0x971DA05074DA7BEE, 0xD3F6FC16EBCA5E04 }, // 5^-21
+    { 0xBCE5086492111AEA, 0x88F4BB1CA6BCF585 }, // 5^-20
+    { 0xEC1E4A7DB69561A5, 0x2B31E9E3D06C32E6 }, // 5^-19
+    { 0x9392EE8E921D5D07, 0x3AFF322E62439FD0 }, // 5^-18
+    { 0xB877AA3236A4B449, 0x09BEFEB9FAD487C3 }, // 5^-17
+    { 0xE69594BEC44DE15B, 0x4C2EBE687989A9B4 }, // 5^-16
+    { 0x901D7CF73AB0ACD9, 0x0F9D37014BF60A11 }, // 5^-15
+    { 0xB424DC35095CD80F, 0x538484C19EF38C95 }, // 5^-14
+    { 0xE12E13424BB40E13, 0x2865A5F206B06FBA }, // 5^-13
+    { 0x8CBCCC096F5088CB, 0xF93F87B7442E45D4 }, // 5^-12
+    { 0xAFEBFF0BCB24AAFE, 0xF78F69A51539D749 }, // 5^-11
+    { 0xDBE6FECEBDEDD5BE, 0xB573440E5A884D1C }, // 5^-10
+    { 0x89705F4136B4A597, 0x31680A88F8953031 }, // 5^-9
+    { 0xABCC77118461CEFC, 0xFDC20D2B36BA7C3E }, // 5^-8
+    { 0xD6BF94D5E57A42BC, 0x3D32907604691B4D }, // 5^-7
+    { 0x8637BD05AF6C69B5, 0xA63F9A49C2C1B110 }, // 5^-6
+    { 0xA7C5AC471B478423, 0x0FCF80DC33721D54 }, // 5^-5
+    { 0xD1B71758E219652B, 0xD3C36113404EA4A9 }, // 5^-4
+    { 0x83126E978D4FDF3B, 0x645A1CAC083126EA }, // 5^-3
+    { 0xA3D70A3D70A3D70A, 0x3D70A3D70A3D70A4 }, // 5^-2
+    { 0xCCCCCCCCCCCCCCCC, 0xCCCCCCCCCCCCCCCD }, // 5^-1
+    { 0x8000000000000000, 0x0000000000000000 }, // 5^0
+    { 0xA000000000000000, 0x0000000000000000 }, // 5^1
+    { 0xC800000000000000, 0x0000000000000000 }, // 5^2
+    { 0xFA00000000000000, 0x0000000000000000 }, // 5^3
+    { 0x9C40000000000000, 0x0000000000000000 }, // 5^4
+    { 0xC350000000000000, 0x0000000000000000 }, // 5^5
+    { 0xF424000000000000, 0x0000000000000000 }, // 5^6
+    { 0x9896800000000000, 0x0000000000000000 }, // 5^7
+    { 0xBEBC200000000000, 0x0000000000000000 }, // 5^8
+    { 0xEE6B280000000000, 0x0000000000000000 }, // 5^9
+    { 0x9502F90000000000, 0x0000000000000000 }, // 5^10
+    { 0xBA43B74000000000, 0x0000000000000000 }, // 5^11
+    { 0xE8D4A51000000000, 0x0000000000000000 }, // 5^12
+    { 0x9184E72A00000000, 0x0000000000000000 }, // 5^13
+    { 0xB5E620F480000000, 0x0000000000000000 }, // 5^14
+    { 0xE35FA931A0000000, 0x0000000000000000 }, // 5^15
+    { 0x8E1BC9BF04000000, 0x0000000000000000 }, // 5^16
+    { 0xB1A2BC2EC5000000, 0x0000000000000000 }, // 5^17
+    { 0xDE0B6B3A76400000, 0x0000000000000000 }, // 5^18
+    { 0x8AC7230489E80000, 0x0000000000000000 }, // 5^19
+    { 0xAD78EBC5AC620000, 0x0000000000000000 }, // 5^20
+    { 0xD8D726B7177A8000, 0x0000000000000000 }, // 5^21
+    { 0x878678326EAC9000, 0x0000000000000000 }, // 5^22
+    { 0xA968163F0A57B400, 0x0000000000000000 }, // 5^23
+    { 0xD3C21BCECCEDA100, 0x0000000000000000 }, // 5^24
+    { 0x84595161401484A0, 0x0000000000000000 }, // 5^25
+    { 0xA56FA5B99019A5C8, 0x0000000000000000 }, // 5^26
+    { 0xCECB8F27F4200F3A, 0x0000000000000000 }, // 5^27
+    { 0x813F3978F8940984, 0x4000000000000000 }, // 5^28
+    { 0xA18F07D736B90BE5, 0x5000000000000000 }, // 5^29
+    { 0xC9F2C9CD04674EDE, 0xA400000000000000 }, // 5^30
+    { 0xFC6F7C4045812296, 0x4D00000000000000 }, // 5^31
+    { 0x9DC5ADA82B70B59D, 0xF020000000000000 }, // 5^32
+    { 0xC5371912364CE305, 0x6C28000000000000 }, // 5^33
+    { 0xF684DF56C3E01BC6, 0xC732000000000000 }, // 5^34
+    { 0x9A130B963A6C115C, 0x3C7F400000000000 }, // 5^35
+    { 0xC097CE7BC90715B3, 0x4B9F100000000000 }, // 5^36
+    { 0xF0BDC21ABB48DB20, 0x1E86D40000000000 }, // 5^37
+    { 0x96769950B50D88F4, 0x1314448000000000 }, // 5^38
+};
+
+// Returns floor(log2(10^q)) for -64 <= q <= 38
+static int32_t Log2Pow10(int32_t q) {
+    int32_t x = q * 217706; // log2(10) * 2^16
+    return x >= 0 ? x / 65536 : -((-x + 65535) / 65536);
+}
+
+// Computes the float bits nearest to mant * 10^exp10.
+// Returns false if the result cannot be determined from a 128-bit product, in which case the slow path is needed.
+static bool ComputeFloatBitsFast(uint64_t mant, int exp10, uint32_t* bits) {
+    HAPAssert(mant);
+    HAPAssert(exp10 >= kFloat_MinPowerOf10 && exp10 <= kFloat_MaxPowerOf10);
+
+    // Normalize mantissa.
+    int lz = CountLeadingZeros64(mant);
+    uint64_t w = mant << lz;
+
+    // Multiply with 5^exp10.
+    // The lower half of the power is only needed if the bits below the 24+2 result bits are all set.
+    const uint64_t* power = powersOf5[exp10 - kFloat_MinPowerOf10];
+    uint64_t high, low;
+    Multiply64(w, power[0], &high, &low);
+    if ((high & 0x3FFFFFFFFF) == 0x3FFFFFFFFF) {
+        uint64_t high2, low2;
+        Multiply64(w, power[1], &high2, &low2);
+        low += high2;
+        if (high2 > low) {
+            high++;
+        }
+        if (low == 0xFFFFFFFFFFFFFFFF && exp10 < -27) {
+            // Truncated power may be too small.
+            return false;
+        }
+    }
+
+    // Extract 24+2 mantissa bits.
+    int upperBit = (int) (high >> 63);
+    int shift = upperBit + 64 - 23 - 3;
+    uint64_t m = high >> shift;
+    int e2 = Log2Pow10(exp10) + 63 + upperBit - lz + 127; // Biased base 2 exponent.
+    if (e2 <= 0) {
+        // Denormalized float.
+        if (-e2 + 1 >= 64) {
+            *bits = 0;
+            return true;
+        }
+        m >>= -e2 + 1;
+        m += m & 1;
+        m >>= 1;
+        // Rounding overflow turns into the smallest normalized float.
+        *bits = (uint32_t) m;
+        return true;
+    }
+    if (low <= 1 && exp10 >= -17 && exp10 <= 10 && (m & 3) == 1 && (m << shift) == high) {
+        // Exactly halfway: round to even.
+        m &= ~(uint64_t) 1;
+    }
+    m += m & 1;
+    m >>= 1;
+    if (m >= 0x1000000) {
+        // Rounding overflow.
+        m = 0x800000;
+        e2++;
+    }
+    if (e2 >= 0xFF) {
+        // Exponent overflow.
+        *bits = 0x7F800000; // inf
+    } else {
+        *bits = ((uint32_t) e2 << 23) + ((uint32_t) m & 0x7FFFFF);
+    }
+    return true;
+}
+
+// Computes the float bits nearest to mant * 10^exp10 using Bigint arithmetic.
+// -63 <= exp10 <= 38, mant != 0
+static uint32_t ComputeFloatBits(uint64_t mant, int exp10) {
+    // Base change.
+    Bigint X, S;
+    BigintInit(&X, mant);
+    BigintInit(&S, 1);
+    int exp2 = 0; // Base 2 exponent.
+    /* |value| == X * 10^exp10 */
+    while (exp10 > 0) {
+        BigintMul(&X, 5); // * 10/2
+        exp10--;
+        exp2++;
+    }
+    while (exp10 < 0) {
+        BigintMul(&S, 5); // * 10/2
+        exp10++;
+        exp2--;
+    }
+    while (BigintComp(&X, &S) >= 0) {
+        BigintMul(&S, 2);
+        exp2++;
+    }
+    while (BigintComp(&X, &S) < 0) {
+        BigintMul(&X, 2);
+        exp2--;
+    }
+    /* |value| == X/S * 2^exp2, 1 <= X/S < 2, X,S < 2^150 */
+
+    // Assemble float bits.
+    uint32_t bits = 0; // Mantissa bits (1.23).
+    int numBits = 24;  // Number of mantissa bits.
+    if (exp2 >= -150) {
+        // No underflow.
+        if (exp2 < -126) {
+            // Denormalized float.
+            numBits = 150 + exp2;
+            exp2 = -126;
+        }
+        for (int i = 0; i < numBits; i++) {
+            bits = bits * 2 + BigintDivRem(&X, &S);
+            BigintMul(&X, 2);
+        }
+        // Round to even.
+        if (BigintComp(&X, &S) + (int32_t)(bits & 1) > 0) {
+            bits++;
+        }
+        if (bits >= 0x1000000) {
+            // Rounding overflow.
+            bits >>= 1;
+            exp2++;
+        }
+        if (exp2 > 127) {
+            // Exponent overflow.
+            bits = 0x7F800000; // inf
+        } else {
+            // Include exponent.
+            bits += ((uint32_t)(exp2 + 126) << 23);
+        }
+    }
+    return bits;
+}
+
 //-----------------------------------------------------------
 
 HAP_RESULT_USE_CHECK
@@ -205,62 +661,9 @@ HAPError HAPFloatFromString(const char* string, float* value) {
     }
     /* -63 <= exp10 <= 38 */
 
-    // Base change.
-    Bigint X, S;
-    BigintInit(&X, mant);
-    BigintInit(&S, 1);
-    int exp2 = 0; // Base 2 exponent.
-    /* |value| == X * 10^exp10 */
-    while (exp10 > 0) {
-        BigintMul(&X, 5); // * 10/2
-        exp10--;
-        exp2++;
-    }
-    while (exp10 < 0) {
-        BigintMul(&S, 5); // * 10/2
-        exp10++;
-        exp2--;
-    }
-    while (BigintComp(&X, &S) >= 0) {
-        BigintMul(&S, 2);
-        exp2++;
-    }
-    while (BigintComp(&X, &S) < 0) {
-        BigintMul(&X, 2);
-        exp2--;
-    }
-    /* |value| == X/S * 2^exp2, 1 <= X/S < 2, X,S < 2^150 */
-
-    // Assemble float bits.
-    uint32_t bits = 0; // Mantissa bits (1.23).
-    int numBits = 24;  // Number of mantissa bits.
-    if (exp2 >= -150) {
-        // No underflow.
-        if (exp2 < -126) {
-            // Denormalized float.
-            numBits = 150 + exp2;
-            exp2 = -126;
-        }
-        for (i = 0; i < numBits; i++) {
-            bits = bits * 2 + BigintDivRem(&X, &S);
-            BigintMul(&X, 2);
-        }
-        // Round to even.
-        if (BigintComp(&X, &S) + (int32_t)(bits & 1) > 0) {
-            bits++;
-        }
-        if (bits >= 0x1000000) {
-            // Rounding overflow.
-            bits >>= 1;
-            exp2++;
-        }
-        if (exp2 > 127) {
-            // Exponent overflow.
-            bits = 0x7F800000; // inf
-        } else {
-            // Include exponent.
-            bits += ((uint32_t)(exp2 + 126) << 23);
-        }
+    uint32_t bits;
+    if (!ComputeFloatBitsFast(mant, exp10, &bits)) {
+        bits = ComputeFloatBits(mant, exp10);
     }
     *value = HAPFloatFromBitPattern(bits + sign);
     return kHAPError_None;
@@ -295,12 +698,8 @@ HAPError HAPFloatGetDescription(char* bytes, size_t maxBytes, float value) {
             bytes[i] = 0;
         }
         return kHAPError_None;
-    } else if (exp2) { // normalized
-        mant |= 0x800000;
-    } else { // denormalized
-        exp2 = 1;
     }
-    if (mant == 0) {
+    if (exp2 == 0 && mant == 0) {
         if (i + 1 >= maxBytes) {
             return kHAPError_OutOfResources;
         }
@@ -309,111 +708,59 @@ HAPError HAPFloatGetDescription(char* bytes, size_t maxBytes, float value) {
         return kHAPError_None;
     }
 
-    // Base change.
-    Bigint X, D, S, T;
-    BigintInit(&X, mant * 2);
-    BigintInit(&D, 1);
-    BigintInit(&S, 0x800000 * 2); // Position of decimal point.
-    exp2 -= 127;
-    /* |value| == X/S * 2^exp2, delta == D/S * 2^exp2, X/S <= 2, 0 < X < 2^25, -127 <= exp2 <= 127 */
-    int exp10 = 0;
-    while (exp2 < 0) {
-        if (BigintComp(&X, &S) <= 0) { // X/S <= 1
-            BigintMul(&X, 5);
-            BigintMul(&D, 5);
-            exp10--;
-        } else { // X/S > 1
-            BigintMul(&S, 2);
-        }
-        exp2++;
+    // Shortest digits.
+    uint32_t decimal;
+    int32_t exp10;
+    RyuGetShortestDecimal(mant, exp2, &decimal, &exp10);
+    char digits[9]; // Digits in reverse order.
+    int numDig = 0; // Number of digits.
+    do {
+        digits[numDig++] = (char) ('0' + decimal % 10);
+        decimal /= 10;
+    } while (decimal);
+    exp10 += numDig - 1;
+    /* |value| == d.ddd * 10^exp10 */
+
+    int dpPos = 0; // Position of decimal point.
+    if (exp10 >= -4 && exp10 <= 5) {
+        // Eliminate small exponents.
+        dpPos = exp10;
+        exp10 = 0;
     }
-    while (exp2 > 0) {
-        if (BigintComp(&X, &S) <= 0) { // X/S <= 1
-            BigintMul(&X, 2);
-            BigintMul(&D, 2);
-        } else { // X/S > 1
-            BigintMul(&S, 5);
-            exp10++;
-        }
-        exp2--;
+    size_t numBytes = (size_t) numDig;
+    if (dpPos < 0) {
+        numBytes += (size_t)(1 - dpPos); // Leading "0." and zeros.
+    } else if (numDig <= dpPos) {
+        numBytes = (size_t) dpPos + 1; // Trailing zeros.
+    } else if (numDig > dpPos + 1) {
+        numBytes++; // Decimal point.
+    }
+    if (exp10) {
+        numBytes += 4;
+    }
+    if (i + numBytes >= maxBytes) {
+        return kHAPError_OutOfResources;
     }
-    /* |value| == X/S * 10^exp10, delta == D/S * 10^exp10, 1/5 < X/S <= 5, X,S < 2^114 */
 
     // Write digits.
-    int32_t odd = bits & 1; // Original mantissa is odd.
-    uint32_t digit;         // Actual digit.
-    int32_t low;            // low <= 0 => digit is in range.
-    int32_t high;           // high <= 0 => (digit + 1) is in range.
-    int dpPos = 0;          // Position of decimal point.
-    int numDig = 0;         // Number of written digits.
-    for (;;) {
-        digit = BigintDivRem(&X, &S);
-        /* X/S is difference between generated digits and precise value, X/S < 1 */
-        if ((bits & 0x7FFFFF) == 0) { // Special case:
-            BigintAdd(&X, &X, &T);    // Lower delta is delta/2.
-            low = BigintComp(&T, &D); // X/S < D/S/2
-        } else {
-            low = BigintComp(&X, &D) + odd; // X/S </<= D/S
-        }
-        BigintAdd(&D, &X, &T);
-        high = BigintComp(&S, &T) + odd; // 1 - X/S </<= D/S
-        if (numDig == 0 && digit == 0 && high > 0) {
-            exp10--; // Suppress leading zero.
-        } else {
-            if (numDig == 0 && exp10 >= -4 && exp10 <= 5) {
-                // Eliminate small exponents.
-                dpPos = exp10;
-                exp10 = 0;
-                if (dpPos < 0) {
-                    // Write leading decimal point.
-                    if (i + (size_t)(2 - dpPos) >= maxBytes) {
-                        return kHAPError_OutOfResources;
-                    }
-                    bytes[i++] = '0';
-                    bytes[i++] = '.';
-                    while (dpPos < -1) {
-                        bytes[i++] = '0';
-                        dpPos++;
-                    }
-                }
-            }
-            if ((low <= 0 || high <= 0) && numDig >= dpPos) {
-                // No more digits needed.
-                break;
-            }
-            if (i + 2 >= maxBytes) {
-                return kHAPError_OutOfResources;
-            }
-            bytes[i++] = (char) (digit + '0'); // Write digit.
-            if (numDig == dpPos) {
-                bytes[i++] = '.'; // Write decimal point.
-            }
-            numDig++;
+    if (dpPos < 0) {
+        // Write leading decimal point.
+        bytes[i++] = '0';
+        bytes[i++] = '.';
+        while (dpPos < -1) {
+            bytes[i++] = '0';
+            dpPos++;
         }
-        BigintMul(&X, 10);
-        BigintMul(&D, 10);
     }
-    // Handle last digit.
-    if (low > 0) {          // Only digit+1 in range.
-        digit++;            // Use digit+1.
-    } else if (high <= 0) { // digit and digit+1 in range.
-        // Round to even.
-        BigintAdd(&X, &X, &T);
-        if (BigintComp(&T, &S) + (int32_t)(digit & 1) > 0) { // X/S >=/> 1/2
-            digit++;
+    for (int n = 0; n < numDig || n <= dpPos; n++) {
+        bytes[i++] = n < numDig ? digits[numDig - 1 - n] : '0';
+        if (n == dpPos && n + 1 < numDig) {
+            bytes[i++] = '.'; // Write decimal point.
         }
     }
-    if (i + 1 >= maxBytes) {
-        return kHAPError_OutOfResources;
-    }
-    // Write last digit (no decimal point).
-    bytes[i++] = (char) (digit + '0');
 
     // Write exponent.
     if (exp10) {
-        if (i + 4 >= maxBytes) {
-            return kHAPError_OutOfResources;
-        }
         bytes[i++] = 'e';
         if (exp10 < 0) {
             bytes[i++] = '-';
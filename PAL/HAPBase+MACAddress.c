@@ -28,7 +28,7 @@ bool HAPMACAddressAreEqual(const HAPMACAddress* value, const HAPMACAddress* othe
     HAPPrecondition(value);
     HAPPrecondition(otherValue);
 
-    return HAPRawBufferAreEqual(value->bytes, otherValue->bytes, sizeof value->bytes);
+    return HAPRawBufferAreEqualPublic(value->bytes, otherValue->bytes, sizeof value->bytes);
 }
 
 HAP_RESULT_USE_CHECK
@@ -7,12 +7,59 @@
 #include "HAPPlatform.h"
 #include "HAPCrypto.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RAW_BUFFER_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RAW_BUFFER_NEON 1
+#endif
+
+/**
+ * Machine word that may alias any other type.
+ */
+#if defined(__GNUC__)
+typedef size_t __attribute__((__may_alias__)) Word;
+#else
+typedef size_t Word;
+#endif
+
+/**
+ * Number of bytes that are processed at once using vector instructions.
+ */
+#define kBlockSize 16
+
+/**
+ * Determines whether a pointer is aligned to a machine word.
+ */
+#define IsWordAligned(bytes) (((uintptr_t)(bytes) % sizeof(Word)) == 0)
+
 void HAPRawBufferZero(void* bytes, size_t numBytes) {
     HAPPrecondition(bytes);
 
     uint8_t* b = bytes;
+    size_t i = 0;
 
-    for (size_t i = 0; i < numBytes; i++) {
+#if RAW_BUFFER_SSE2
+    while (numBytes - i >= kBlockSize) {
+        _mm_storeu_si128((__m128i*) (void*) &b[i], _mm_setzero_si128());
+        i += kBlockSize;
+    }
+#elif RAW_BUFFER_NEON
+    while (numBytes - i >= kBlockSize) {
+        vst1q_u8(&b[i], vdupq_n_u8(0));
+        i += kBlockSize;
+    }
+#else
+    while (i < numBytes && !IsWordAligned(&b[i])) {
+        b[i++] = 0;
+    }
+    while (numBytes - i >= sizeof(Word)) {
+        *(Word*) (void*) &b[i] = 0;
+        i += sizeof(Word);
+    }
+#endif
+    for (; i < numBytes; i++) {
         b[i] = 0;
     }
 }
@@ -24,12 +71,63 @@ void HAPRawBufferCopyBytes(void* destinationBytes, const void* sourceBytes, size
     uint8_t* destination = destinationBytes;
     const uint8_t* source = sourceBytes;
 
+    // Overlapping buffers are supported. Each block is loaded completely before it is stored, so copying forward is
+    // safe if the destination is before the source, and copying backward is safe otherwise.
     if (destinationBytes < sourceBytes) {
-        for (size_t i = 0; i < numBytes; i++) {
+        size_t i = 0;
+#if RAW_BUFFER_SSE2
+        while (numBytes - i >= kBlockSize) {
+            __m128i x = _mm_loadu_si128((const __m128i*) (const void*) &source[i]);
+            _mm_storeu_si128((__m128i*) (void*) &destination[i], x);
+            i += kBlockSize;
+        }
+#elif RAW_BUFFER_NEON
+        while (numBytes - i >= kBlockSize) {
+            vst1q_u8(&destination[i], vld1q_u8(&source[i]));
+            i += kBlockSize;
+        }
+#else
+        if (IsWordAligned((uintptr_t) destination - (uintptr_t) source)) {
+            while (i < numBytes && !IsWordAligned(&destination[i])) {
+                destination[i] = source[i];
+                i++;
+            }
+            while (numBytes - i >= sizeof(Word)) {
+                *(Word*) (void*) &destination[i] = *(const Word*) (const void*) &source[i];
+                i += sizeof(Word);
+            }
+        }
+#endif
+        for (; i < numBytes; i++) {
             destination[i] = source[i];
         }
     } else if (destinationBytes > sourceBytes) {
-        for (size_t i = numBytes; i > 0; i--) {
+        size_t i = numBytes;
+#if RAW_BUFFER_SSE2
+        while (i >= kBlockSize) {
+            __m128i x = _mm_loadu_si128((const __m128i*) (const void*) &source[i - kBlockSize]);
+            _mm_storeu_si128((__m128i*) (void*) &destination[i - kBlockSize], x);
+            i -= kBlockSize;
+        }
+#elif RAW_BUFFER_NEON
+        while (i >= kBlockSize) {
+            vst1q_u8(&destination[i - kBlockSize], vld1q_u8(&source[i - kBlockSize]));
+            i -= kBlockSize;
+        }
+#else
+        if (IsWordAligned((uintptr_t) destination - (uintptr_t) source)) {
+            while (i > 0 && !IsWordAligned(&destination[i])) {
+                destination[i - 1] = source[i - 1];
+                i--;
+            }
+            while (i >= sizeof(Word)) {
+                *(Word*) (void*) &destination[i - sizeof(Word)] =
+                        *(const Word*) (const void*) &source[i - sizeof(Word)];
+                i -= sizeof(Word);
+            }
+        }
+#endif
+        for (; i > 0; i--) {
             destination[i - 1] = source[i - 1];
         }
     }
@@ -46,6 +144,50 @@ bool HAPRawBufferAreEqual(const void* bytes, const void* otherBytes, size_t numB
     return HAP_constant_time_equal(bytes, otherBytes, numBytes) == 1;
 }
 
+HAP_RESULT_USE_CHECK
+bool HAPRawBufferAreEqualPublic(const void* bytes, const void* otherBytes, size_t numBytes) {
+    HAPPrecondition(bytes);
+    HAPPrecondition(otherBytes);
+
+    const uint8_t* b = bytes;
+    const uint8_t* o = otherBytes;
+    size_t i = 0;
+
+#if RAW_BUFFER_SSE2
+    while (numBytes - i >= kBlockSize) {
+        __m128i x = _mm_loadu_si128((const __m128i*) (const void*) &b[i]);
+        __m128i y = _mm_loadu_si128((const __m128i*) (const void*) &o[i]);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) {
+            return false;
+        }
+        i += kBlockSize;
+    }
+#elif RAW_BUFFER_NEON
+    while (numBytes - i >= kBlockSize) {
+        uint64x2_t x = vreinterpretq_u64_u8(veorq_u8(vld1q_u8(&b[i]), vld1q_u8(&o[i])));
+        if (vgetq_lane_u64(x, 0) | vgetq_lane_u64(x, 1)) {
+            return false;
+        }
+        i += kBlockSize;
+    }
+#else
+    if (IsWordAligned(&b[i]) && IsWordAligned(&o[i])) {
+        while (numBytes - i >= sizeof(Word)) {
+            if (*(const Word*) (const void*) &b[i] != *(const Word*) (const void*) &o[i]) {
+                return false;
+            }
+            i += sizeof(Word);
+        }
+    }
+#endif
+    for (; i < numBytes; i++) {
+        if (b[i] != o[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
 HAP_RESULT_USE_CHECK
 bool HAPRawBufferIsZero(const void* bytes, size_t numBytes) {
     HAPPrecondition(bytes);
@@ -6,15 +6,94 @@
 
 #include "HAPPlatform.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define UTF8_SSE2 1
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define UTF8_LOOKUP 1
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define UTF8_NEON 1
+#if defined(__aarch64__)
+#define UTF8_LOOKUP 1
+#endif
+#endif
+
+#define kUTF8_BlockSize 16
+
+/**
+ * Returns the number of leading bytes that are contained in blocks consisting of ASCII characters only.
+ *
+ * - The returned number of bytes is a multiple of kUTF8_BlockSize. Remaining bytes need to be validated separately.
+ */
 HAP_RESULT_USE_CHECK
-bool HAPUTF8IsValidData(const void* bytes, size_t numBytes) {
-    HAPPrecondition(bytes);
+static size_t GetNumASCIIBlockBytes(const uint8_t* bytes, size_t numBytes) {
+    size_t i = 0;
+#if UTF8_SSE2
+    while (numBytes - i >= 2 * kUTF8_BlockSize) {
+        __m128i a = _mm_loadu_si128((const __m128i*) (const void*) &bytes[i]);
+        __m128i b = _mm_loadu_si128((const __m128i*) (const void*) &bytes[i + kUTF8_BlockSize]);
+        if (_mm_movemask_epi8(_mm_or_si128(a, b))) {
+            break;
+        }
+        i += 2 * kUTF8_BlockSize;
+    }
+    while (numBytes - i >= kUTF8_BlockSize) {
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*) (const void*) &bytes[i]))) {
+            break;
+        }
+        i += kUTF8_BlockSize;
+    }
+#elif UTF8_NEON
+    while (numBytes - i >= 2 * kUTF8_BlockSize) {
+        uint8x16_t x = vorrq_u8(vld1q_u8(&bytes[i]), vld1q_u8(&bytes[i + kUTF8_BlockSize]));
+        uint64x2_t y = vreinterpretq_u64_u8(vandq_u8(x, vdupq_n_u8(0x80)));
+        if (vgetq_lane_u64(y, 0) | vgetq_lane_u64(y, 1)) {
+            break;
+        }
+        i += 2 * kUTF8_BlockSize;
+    }
+    while (numBytes - i >= kUTF8_BlockSize) {
+        uint64x2_t y = vreinterpretq_u64_u8(vandq_u8(vld1q_u8(&bytes[i]), vdupq_n_u8(0x80)));
+        if (vgetq_lane_u64(y, 0) | vgetq_lane_u64(y, 1)) {
+            break;
+        }
+        i += kUTF8_BlockSize;
+    }
+#else
+    while (numBytes - i >= kUTF8_BlockSize) {
+        uint8_t x = 0;
+        for (size_t j = 0; j < kUTF8_BlockSize; j++) {
+            x |= bytes[i + j];
+        }
+        if (x & 0x80) {
+            break;
+        }
+        i += kUTF8_BlockSize;
+    }
+#endif
+    return i;
+}
+
+#if !UTF8_LOOKUP
+
+/**
+ * Byte-at-a-time UTF-8 validation state.
+ */
+typedef struct {
+    int error;  // Error state in bit 0.
+    int state;  // Number of leading 1 bits == number of outstanding continuation bytes.
+    int prefix; // Prefix byte if value is second byte.
+} UTF8State;
 
+static void UTF8StateUpdate(UTF8State* s, const uint8_t* bytes, size_t numBytes) {
     // See http://www.unicode.org/versions/Unicode6.0.0/ch03.pdf - Table 3-7, page 94.
 
-    int error = 0;  // Error state in bit 0.
-    int state = 0;  // Number of leading 1 bits == number of outstanding continuation bytes.
-    int prefix = 0; // Prefix byte if value is second byte.
+    int error = s->error;
+    int state = s->state;
+    int prefix = s->prefix;
 
     // state     value    -> more  first  second -> error  state'    prefix
     // 0xxxxxxx  0xxxxxxx     0      0      x        0    00000000  00000000
@@ -25,7 +104,7 @@ bool HAPUTF8IsValidData(const void* bytes, size_t numBytes) {
     // 110xxxx0  110xxxxx     1      1      1        1
 
     for (size_t i = 0; i < numBytes; i++) {
-        int value = ((const uint8_t*) bytes)[i];
+        int value = bytes[i];
         int more = state >> 7;         // More continuation bytes expected.
         int first = value >> 7;        // First bit.
         int second = (value >> 6) & 1; // Second bit.
@@ -50,8 +129,248 @@ bool HAPUTF8IsValidData(const void* bytes, size_t numBytes) {
         state = (uint8_t)((prefix | (-more & state)) << 1);
     }
 
+    s->error = error;
+    s->state = state;
+    s->prefix = prefix;
+}
+
+#endif
+
+#if UTF8_LOOKUP
+
+// Lookup based validation of 16 bytes at a time.
+// See John Keiser, Daniel Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte",
+// Software: Practice and Experience 51(5), 2021.
+//
+// Each error class is a bit. For every pair of consecutive bytes, three tables are indexed with the high nibble of the
+// first byte, the low nibble of the first byte, and the high nibble of the second byte. A bit that is set in all three
+// results indicates an error. Third and fourth bytes are checked separately.
+
+#define kUTF8Error_TooShort     (1 << 0) // 11______ 0_______, 11______ 11______
+#define kUTF8Error_TooLong      (1 << 1) // 0_______ 10______
+#define kUTF8Error_Overlong3    (1 << 2) // 11100000 100_____
+#define kUTF8Error_TooLarge     (1 << 3) // 11110100 1001____, 11110100 101_____, 1111(0101-1111) 1001____ / 101_____
+#define kUTF8Error_Surrogate    (1 << 4) // 11101101 101_____
+#define kUTF8Error_Overlong2    (1 << 5) // 1100000_ 10______
+#define kUTF8Error_TooLarge1000 (1 << 6) // 1111(0101-1111) 1000____
+#define kUTF8Error_Overlong4    (1 << 6) // 11110000 1000____
+#define kUTF8Error_TwoConts     (1 << 7) // 10______ 10______
+
+#define kUTF8Error_Carry (kUTF8Error_TooShort | kUTF8Error_TooLong | kUTF8Error_TwoConts)
+
+static const uint8_t utf8Byte1High[16] = {
+    // 0_______ ________
+    kUTF8Error_TooLong,
+    kUTF8Error_TooLong,
+    kUTF8Error_TooLong,
+    kUTF8Error_TooLong,
+    kUTF8Error_TooLong,
+    kUTF8Error_TooLong,
+    kUTF8Error_TooLong,
+    kUTF8Error_TooLong,
+    // 10______ ________
+    kUTF8Error_TwoConts,
+    kUTF8Error_TwoConts,
+    kUTF8Error_TwoConts,
+    kUTF8Error_TwoConts,
+    // 1100____ ________
+    kUTF8Error_TooShort | kUTF8Error_Overlong2,
+    // 1101____ ________
+    kUTF8Error_TooShort,
+    // 1110____ ________
+    kUTF8Error_TooShort | kUTF8Error_Overlong3 | kUTF8Error_Surrogate,
+    // 1111____ ________
+    kUTF8Error_TooShort | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000 | kUTF8Error_Overlong4,
+};
+
+static const uint8_t utf8Byte1Low[16] = {
+    // ____0000 ________
+    kUTF8Error_Carry | kUTF8Error_Overlong3 | kUTF8Error_Overlong2 | kUTF8Error_Overlong4,
+    // ____0001 ________
+    kUTF8Error_Carry | kUTF8Error_Overlong2,
+    // ____001_ ________
+    kUTF8Error_Carry,
+    kUTF8Error_Carry,
+    // ____0100 ________
+    kUTF8Error_Carry | kUTF8Error_TooLarge,
+    // ____0101 ________
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    // ____011_ ________
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    // ____1___ ________
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    // ____1101 ________
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000 | kUTF8Error_Surrogate,
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+    kUTF8Error_Carry | kUTF8Error_TooLarge | kUTF8Error_TooLarge1000,
+};
+
+static const uint8_t utf8Byte2High[16] = {
+    // ________ 0_______
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    // ________ 1000____
+    kUTF8Error_TooLong | kUTF8Error_Overlong2 | kUTF8Error_TwoConts | kUTF8Error_Overlong3 |
+            kUTF8Error_TooLarge1000 | kUTF8Error_Overlong4,
+    // ________ 1001____
+    kUTF8Error_TooLong | kUTF8Error_Overlong2 | kUTF8Error_TwoConts | kUTF8Error_Overlong3 | kUTF8Error_TooLarge,
+    // ________ 101_____
+    kUTF8Error_TooLong | kUTF8Error_Overlong2 | kUTF8Error_TwoConts | kUTF8Error_Surrogate | kUTF8Error_TooLarge,
+    kUTF8Error_TooLong | kUTF8Error_Overlong2 | kUTF8Error_TwoConts | kUTF8Error_Surrogate | kUTF8Error_TooLarge,
+    // ________ 11______
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+    kUTF8Error_TooShort,
+};
+
+// Bytes that are greater than these values at the end of a block start a sequence that continues in the next block.
+static const uint8_t utf8MaxValue[16] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+#if UTF8_SSE2
+
+typedef __m128i UTF8Block;
+
+#define UTF8BlockLoad(bytes) _mm_loadu_si128((const __m128i*) (const void*) (bytes))
+#define UTF8BlockIsASCII(x)  (!_mm_movemask_epi8(x))
+#define UTF8BlockIsZero(x)   (_mm_movemask_epi8(_mm_cmpeq_epi8((x), _mm_setzero_si128())) == 0xFFFF)
+#define UTF8BlockOr(x, y)    _mm_or_si128((x), (y))
+
+// Returns errors in a block, given the previous block.
+HAP_RESULT_USE_CHECK
+static UTF8Block UTF8BlockGetErrors(UTF8Block input, UTF8Block prevInput) {
+    __m128i lowNibbleMask = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prevInput, kUTF8_BlockSize - 1);
+    __m128i byte1High = _mm_shuffle_epi8(
+            UTF8BlockLoad(utf8Byte1High), _mm_and_si128(_mm_srli_epi16(prev1, 4), lowNibbleMask));
+    __m128i byte1Low = _mm_shuffle_epi8(UTF8BlockLoad(utf8Byte1Low), _mm_and_si128(prev1, lowNibbleMask));
+    __m128i byte2High = _mm_shuffle_epi8(
+            UTF8BlockLoad(utf8Byte2High), _mm_and_si128(_mm_srli_epi16(input, 4), lowNibbleMask));
+    __m128i specialCases = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+    // Bytes after 111_____ and 1111____ lead bytes must be continuations. Only those are >= 0x80 after subtraction.
+    __m128i prev2 = _mm_alignr_epi8(input, prevInput, kUTF8_BlockSize - 2);
+    __m128i prev3 = _mm_alignr_epi8(input, prevInput, kUTF8_BlockSize - 3);
+    __m128i isThirdByte = _mm_subs_epu8(prev2, _mm_set1_epi8((char) (0xE0 - 0x80)));
+    __m128i isFourthByte = _mm_subs_epu8(prev3, _mm_set1_epi8((char) (0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(isThirdByte, isFourthByte), _mm_set1_epi8((char) 0x80));
+    return _mm_xor_si128(must23, specialCases);
+}
+
+// Returns non-zero bytes if the block ends with an incomplete sequence.
+HAP_RESULT_USE_CHECK
+static UTF8Block UTF8BlockGetIncomplete(UTF8Block input) {
+    return _mm_subs_epu8(input, UTF8BlockLoad(utf8MaxValue));
+}
+
+#else
+
+typedef uint8x16_t UTF8Block;
+
+#define UTF8BlockLoad(bytes) vld1q_u8(bytes)
+#define UTF8BlockIsASCII(x)  (vmaxvq_u8(x) < 0x80)
+#define UTF8BlockIsZero(x)   (vmaxvq_u8(x) == 0)
+#define UTF8BlockOr(x, y)    vorrq_u8((x), (y))
+
+// Returns errors in a block, given the previous block.
+HAP_RESULT_USE_CHECK
+static UTF8Block UTF8BlockGetErrors(UTF8Block input, UTF8Block prevInput) {
+    uint8x16_t prev1 = vextq_u8(prevInput, input, kUTF8_BlockSize - 1);
+    uint8x16_t byte1High = vqtbl1q_u8(vld1q_u8(utf8Byte1High), vshrq_n_u8(prev1, 4));
+    uint8x16_t byte1Low = vqtbl1q_u8(vld1q_u8(utf8Byte1Low), vandq_u8(prev1, vdupq_n_u8(0x0F)));
+    uint8x16_t byte2High = vqtbl1q_u8(vld1q_u8(utf8Byte2High), vshrq_n_u8(input, 4));
+    uint8x16_t specialCases = vandq_u8(vandq_u8(byte1High, byte1Low), byte2High);
+
+    // Bytes after 111_____ and 1111____ lead bytes must be continuations. Only those are >= 0x80 after subtraction.
+    uint8x16_t prev2 = vextq_u8(prevInput, input, kUTF8_BlockSize - 2);
+    uint8x16_t prev3 = vextq_u8(prevInput, input, kUTF8_BlockSize - 3);
+    uint8x16_t isThirdByte = vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80));
+    uint8x16_t isFourthByte = vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80));
+    uint8x16_t must23 = vandq_u8(vorrq_u8(isThirdByte, isFourthByte), vdupq_n_u8(0x80));
+    return veorq_u8(must23, specialCases);
+}
+
+// Returns non-zero bytes if the block ends with an incomplete sequence.
+HAP_RESULT_USE_CHECK
+static UTF8Block UTF8BlockGetIncomplete(UTF8Block input) {
+    return vqsubq_u8(input, vld1q_u8(utf8MaxValue));
+}
+
+#endif
+
+HAP_RESULT_USE_CHECK
+static bool IsValidDataLookup(const uint8_t* bytes, size_t numBytes) {
+    uint8_t zeros[kUTF8_BlockSize] = { 0 };
+    UTF8Block error = UTF8BlockLoad(zeros);
+    UTF8Block prevInput = error;
+    UTF8Block prevIncomplete = error;
+
+    size_t i = 0;
+    while (numBytes - i >= kUTF8_BlockSize) {
+        UTF8Block input = UTF8BlockLoad(&bytes[i]);
+        if (UTF8BlockIsASCII(input)) {
+            // Sequences must not be continued by ASCII characters.
+            error = UTF8BlockOr(error, prevIncomplete);
+        } else {
+            error = UTF8BlockOr(error, UTF8BlockGetErrors(input, prevInput));
+            prevIncomplete = UTF8BlockGetIncomplete(input);
+        }
+        prevInput = input;
+        i += kUTF8_BlockSize;
+    }
+
+    // Validate remaining bytes padded with zeros. This also detects incomplete sequences at the end of the data.
+    uint8_t tail[kUTF8_BlockSize] = { 0 };
+    HAPRawBufferCopyBytes(tail, &bytes[i], numBytes - i);
+    error = UTF8BlockOr(error, UTF8BlockGetErrors(UTF8BlockLoad(tail), prevInput));
+
+    return UTF8BlockIsZero(error);
+}
+
+#endif
+
+HAP_RESULT_USE_CHECK
+bool HAPUTF8IsValidData(const void* bytes, size_t numBytes) {
+    HAPPrecondition(bytes);
+
+    const uint8_t* b = bytes;
+
+    // Most strings are ASCII only.
+    size_t i = GetNumASCIIBlockBytes(b, numBytes);
+    if (i == numBytes) {
+        return true;
+    }
+
+#if UTF8_LOOKUP
+    return IsValidDataLookup(&b[i], numBytes - i);
+#else
+    UTF8State s = { 0 };
+    while (i < numBytes) {
+        if (!s.state) {
+            // Previous block ended at a character boundary.
+            i += GetNumASCIIBlockBytes(&b[i], numBytes - i);
+        }
+        size_t n = numBytes - i < kUTF8_BlockSize ? numBytes - i : kUTF8_BlockSize;
+        UTF8StateUpdate(&s, &b[i], n);
+        i += n;
+    }
+
     // Missing continuations.
-    error |= state >> 7;
+    s.error |= s.state >> 7;
 
-    return (bool) (1 & ~error);
+    return (bool) (1 & ~s.error);
+#endif
 }
@@ -75,7 +75,8 @@ HAP_ENUM_BEGIN(uint8_t, HAPError) {
     kHAPError_InvalidData,    /**< Data has unexpected format. */
     kHAPError_OutOfResources, /**< Out of resources. */
     kHAPError_NotAuthorized,  /**< Insufficient authorization. */
-    kHAPError_Busy            /**< Operation failed temporarily, retry later. */
+    kHAPError_Busy,           /**< Operation failed temporarily, retry later. */
+    kHAPError_InProgress      /**< Operation has been accepted and completes asynchronously. */
 } HAP_ENUM_END(uint8_t, HAPError);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -269,6 +270,22 @@ void HAPRawBufferCopyBytes(void* destinationBytes, const void* sourceBytes, size
 HAP_RESULT_USE_CHECK
 bool HAPRawBufferAreEqual(const void* bytes, const void* otherBytes, size_t numBytes);
 
+/**
+ * Determines equality of two buffers that do not contain secrets.
+ *
+ * - The comparison stops at the first difference, so the time taken reveals where the buffers differ.
+ *   Use HAPRawBufferAreEqual to compare keys, proofs, authentication tags and other secret data.
+ *
+ * @param      bytes                Buffer to compare.
+ * @param      otherBytes           Buffer to compare with.
+ * @param      numBytes             Number of bytes to compare.
+ *
+ * @return true                     If the contents of both buffers are equal.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPRawBufferAreEqualPublic(const void* bytes, const void* otherBytes, size_t numBytes);
+
 /**
  * Determines if a buffer contains only zeros in constant time.
  *
@@ -50,6 +50,14 @@ typedef uint16_t HAPPlatformBLEPeripheralManagerAttributeHandle;
  */
 #define kHAPPlatformBLEPeripheralManager_MaxAttributeBytes ((size_t) 512)
 
+/**
+ * Minimum ATT_MTU of a Bluetooth LE connection.
+ *
+ * @see Bluetooth Core Specification Version 5
+ *      Vol 3 Part G Section 5.2.1 ATT_MTU
+ */
+#define kHAPPlatformBLEPeripheralManager_MinMTU ((uint16_t) 23)
+
 /**
  * Delegate that is used to monitor read, write, and subscription requests from remote central devices.
  */
@@ -160,6 +168,28 @@ typedef struct {
             HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
             HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
             void* _Nullable context);
+
+    /**
+     * Invoked when the ATT_MTU of a connection that was reported to the handleConnectedCentral callback
+     * has been negotiated. Optional.
+     *
+     * - Read responses are transferred over a sequence of "Read Request" and "Read Blob Request" operations
+     *   that carry up to ATT_MTU - 1 bytes each. If the ATT_MTU is known, read responses that span multiple
+     *   read requests are fragmented so that they fill these operations.
+     *
+     * @param      blePeripheralManager BLE peripheral manager.
+     * @param      connectionHandle     Connection handle of the central.
+     * @param      mtu                  Negotiated ATT_MTU. At least kHAPPlatformBLEPeripheralManager_MinMTU.
+     * @param      context              The context pointer of the BLE peripheral manager delegate structure.
+     *
+     * @see Bluetooth Core Specification Version 5
+     *      Vol 3 Part F Section 3.4.2 MTU Exchange
+     */
+    void (*_Nullable handleUpdatedMTU)(
+            HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+            HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+            uint16_t mtu,
+            void* _Nullable context);
 } HAPPlatformBLEPeripheralManagerDelegate;
 
 /**
@@ -168,6 +168,9 @@ void HAPPlatformTCPStreamUpdateInterests(
 /**
  * Reads from a TCP stream.
  *
+ * - If the connection to the peer has been lost, e.g., because keepalive probes have not been answered,
+ *   it should be reported as closed by the peer so that the accessory server closes the TCP stream.
+ *
  * @param      tcpStreamManager     TCP stream manager from which the stream was accepted.
  * @param      tcpStream            TCP stream.
  * @param[out] bytes                Buffer containing received data.
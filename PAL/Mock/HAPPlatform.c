@@ -79,7 +79,8 @@ void HAPPlatformCreate(void) {
     // Accessory setup manager. Does not require initialization.
 
     // TCP stream manager.
-    static HAPPlatformTCPStream tcpStreams[kHAPIPSessionStorage_DefaultNumElements];
+    // Supports more streams than kHAPIPSessionStorage_DefaultNumElements so that tests may use large session storage.
+    static HAPPlatformTCPStream tcpStreams[512];
     HAPPlatformTCPStreamManagerCreate(
             HAPNonnull(platform.ip.tcpStreamManager),
             &(const HAPPlatformTCPStreamManagerOptions) { .tcpStreams = tcpStreams,
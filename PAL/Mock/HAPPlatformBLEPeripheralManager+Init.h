@@ -53,6 +53,22 @@ typedef struct {
     } _;
 } HAPPlatformBLEPeripheralManagerAttribute;
 
+/**
+ * Maximum number of centrals that may be connected concurrently.
+ */
+#define kHAPPlatformBLEPeripheralManager_MaxCentrals ((size_t) 8)
+
+/**
+ * Connected central.
+ */
+typedef struct {
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle;
+    uint16_t mtu;
+    HAPPlatformBLEPeripheralManagerAttributeHandle indicationValueHandle;
+    bool isConnected : 1;
+    bool isCancelled : 1;
+} HAPPlatformBLEPeripheralManagerCentral;
+
 /**
  * BLE peripheral manager initialization options.
  */
@@ -79,10 +95,12 @@ struct HAPPlatformBLEPeripheralManager {
     uint8_t scanResponseBytes[31];
     uint8_t numScanResponseBytes;
     HAPBLEAdvertisingInterval advertisingInterval;
+    HAPPlatformBLEPeripheralManagerCentral centrals[kHAPPlatformBLEPeripheralManager_MaxCentrals];
+    HAPPlatformTimerRef cancellationTimer;
+    size_t numRoundTrips;
 
     bool isDeviceAddressSet : 1;
     bool didPublishAttributes : 1;
-    bool isConnected : 1;
     /**@endcond */
 };
 
@@ -66,6 +66,134 @@ HAPError HAPPlatformBLEPeripheralManagerGetAdvertisingData(
         size_t maxScanResponseBytes,
         size_t* numScanResponseBytes);
 
+/**
+ * Simulates a connection of a central to the BLE peripheral manager.
+ *
+ * - Up to kHAPPlatformBLEPeripheralManager_MaxCentrals centrals may be connected at a time.
+ *   Each connected central must use a different connection handle.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      connectionHandle     Connection handle of the central.
+ */
+void HAPPlatformBLEPeripheralManagerConnectCentral(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle);
+
+/**
+ * Simulates a disconnection of a connected central from the BLE peripheral manager.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      connectionHandle     Connection handle of the central.
+ */
+void HAPPlatformBLEPeripheralManagerDisconnectCentral(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle);
+
+/**
+ * Returns whether a central is connected to the BLE peripheral manager.
+ *
+ * - Connections that are cancelled by the accessory are terminated once the run loop processes expired timers,
+ *   i.e., after HAPPlatformClockAdvance has been called.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      connectionHandle     Connection handle of the central.
+ *
+ * @return true                     If the central is connected.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPPlatformBLEPeripheralManagerIsCentralConnected(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle);
+
+/**
+ * Simulates the negotiation of a new ATT_MTU with a connected central.
+ *
+ * - After a central connects, the ATT_MTU is kHAPPlatformBLEPeripheralManager_MinMTU.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      connectionHandle     Connection handle of the central.
+ * @param      mtu                  ATT_MTU.
+ */
+void HAPPlatformBLEPeripheralManagerSetMTU(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        uint16_t mtu);
+
+/**
+ * Returns the number of ATT round trips that simulated GATT requests would have taken with the current ATT_MTU.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ *
+ * @return Number of ATT round trips since the BLE peripheral manager has been created.
+ */
+HAP_RESULT_USE_CHECK
+size_t HAPPlatformBLEPeripheralManagerGetNumRoundTrips(HAPPlatformBLEPeripheralManagerRef blePeripheralManager);
+
+/**
+ * Simulates the confirmation of the outstanding Handle Value Indication by a connected central.
+ *
+ * - Only one Handle Value Indication may be outstanding per central. Further indications fail with
+ *   kHAPError_InvalidState until the central confirms the outstanding one, after which the delegate is informed that
+ *   it may continue.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      connectionHandle     Connection handle of the central.
+ * @param[out] valueHandle          Attribute handle of the characteristic value of the confirmed indication.
+ *
+ * @return true                     If an indication has been confirmed.
+ * @return false                    If no indication is outstanding.
+ */
+HAP_RESULT_USE_CHECK
+bool HAPPlatformBLEPeripheralManagerConfirmIndication(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* valueHandle);
+
+/**
+ * Simulates a GATT read request from a connected central.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      connectionHandle     Connection handle of the central.
+ * @param      attributeHandle      Attribute handle of the read characteristic value or descriptor.
+ * @param[out] bytes                Buffer to fill with the value.
+ * @param      maxBytes             Capacity of the buffer.
+ * @param[out] numBytes             Length of the value that has been read.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the connection of the central has been cancelled.
+ * @return Other                    Error returned by the delegate.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerReadAttribute(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle,
+        void* bytes,
+        size_t maxBytes,
+        size_t* numBytes);
+
+/**
+ * Simulates a GATT write request from a connected central.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      connectionHandle     Connection handle of the central.
+ * @param      attributeHandle      Attribute handle of the written characteristic value or descriptor.
+ * @param      bytes                Value to write.
+ * @param      numBytes             Length of the value.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_InvalidState   If the connection of the central has been cancelled.
+ * @return Other                    Error returned by the delegate.
+ */
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerWriteAttribute(
+        HAPPlatformBLEPeripheralManagerRef blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle,
+        void* bytes,
+        size_t numBytes);
+
 #if __has_feature(nullability)
 #pragma clang assume_nonnull end
 #endif
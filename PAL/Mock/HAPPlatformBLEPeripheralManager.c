@@ -9,6 +9,49 @@
 
 static const HAPLogObject logObject = { .subsystem = kHAPPlatform_LogSubsystem, .category = "BLEPeripheralManager" };
 
+/**
+ * Gets a connected central.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ * @param      connectionHandle     Connection handle of the central.
+ *
+ * @return Connected central, if found. NULL otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static HAPPlatformBLEPeripheralManagerCentral* _Nullable GetCentral(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle) {
+    HAPPrecondition(blePeripheralManager);
+
+    for (size_t i = 0; i < HAPArrayCount(blePeripheralManager->centrals); i++) {
+        HAPPlatformBLEPeripheralManagerCentral* central = &blePeripheralManager->centrals[i];
+        if (central->isConnected && central->connectionHandle == connectionHandle) {
+            return central;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Returns whether any central is connected.
+ *
+ * @param      blePeripheralManager BLE peripheral manager.
+ *
+ * @return true                     If at least one central is connected.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsAnyCentralConnected(HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    for (size_t i = 0; i < HAPArrayCount(blePeripheralManager->centrals); i++) {
+        if (blePeripheralManager->centrals[i].isConnected) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void HAPPlatformBLEPeripheralManagerCreate(
         HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
         const HAPPlatformBLEPeripheralManagerOptions* _Nonnull options) {
@@ -40,7 +83,7 @@ void HAPPlatformBLEPeripheralManagerSetDeviceAddress(
         HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
         const HAPPlatformBLEPeripheralManagerDeviceAddress* _Nonnull deviceAddress) {
     HAPPrecondition(blePeripheralManager);
-    HAPPrecondition(!blePeripheralManager->isConnected);
+    HAPPrecondition(!IsAnyCentralConnected(blePeripheralManager));
     HAPPrecondition(deviceAddress);
 
     blePeripheralManager->deviceAddress = *deviceAddress;
@@ -63,7 +106,7 @@ void HAPPlatformBLEPeripheralManagerSetDeviceName(
 void HAPPlatformBLEPeripheralManagerRemoveAllServices(
         HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager) {
     HAPPrecondition(blePeripheralManager);
-    HAPPrecondition(!blePeripheralManager->isConnected);
+    HAPPrecondition(!IsAnyCentralConnected(blePeripheralManager));
 
     HAPAssert(blePeripheralManager->numAttributes <= SIZE_MAX / sizeof blePeripheralManager->attributes[0]);
     HAPRawBufferZero(
@@ -409,14 +452,226 @@ HAPError HAPPlatformBLEPeripheralManagerGetAdvertisingData(
     return kHAPError_None;
 }
 
+void HAPPlatformBLEPeripheralManagerConnectCentral(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPrecondition(blePeripheralManager->didPublishAttributes);
+    HAPPrecondition(!GetCentral(blePeripheralManager, connectionHandle));
+
+    HAPPlatformBLEPeripheralManagerCentral* _Nullable central = NULL;
+    for (size_t i = 0; i < HAPArrayCount(blePeripheralManager->centrals); i++) {
+        if (!blePeripheralManager->centrals[i].isConnected) {
+            central = &blePeripheralManager->centrals[i];
+            break;
+        }
+    }
+    HAPPrecondition(central);
+
+    HAPRawBufferZero(central, sizeof *central);
+    central->connectionHandle = connectionHandle;
+    central->mtu = kHAPPlatformBLEPeripheralManager_MinMTU;
+    central->isConnected = true;
+
+    if (blePeripheralManager->delegate.handleConnectedCentral) {
+        blePeripheralManager->delegate.handleConnectedCentral(
+                blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+    }
+}
+
+void HAPPlatformBLEPeripheralManagerDisconnectCentral(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerCentral* _Nullable central = GetCentral(blePeripheralManager, connectionHandle);
+    HAPPrecondition(central);
+
+    HAPRawBufferZero(central, sizeof *central);
+
+    if (blePeripheralManager->delegate.handleDisconnectedCentral) {
+        blePeripheralManager->delegate.handleDisconnectedCentral(
+                blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+    }
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPPlatformBLEPeripheralManagerIsCentralConnected(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle) {
+    HAPPrecondition(blePeripheralManager);
+
+    return GetCentral(blePeripheralManager, connectionHandle) != NULL;
+}
+
+void HAPPlatformBLEPeripheralManagerSetMTU(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        uint16_t mtu) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerCentral* _Nullable central = GetCentral(blePeripheralManager, connectionHandle);
+    HAPPrecondition(central);
+    HAPPrecondition(mtu >= kHAPPlatformBLEPeripheralManager_MinMTU);
+
+    central->mtu = mtu;
+
+    if (blePeripheralManager->delegate.handleUpdatedMTU) {
+        blePeripheralManager->delegate.handleUpdatedMTU(
+                blePeripheralManager, connectionHandle, mtu, blePeripheralManager->delegate.context);
+    }
+}
+
+HAP_RESULT_USE_CHECK
+size_t HAPPlatformBLEPeripheralManagerGetNumRoundTrips(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager) {
+    HAPPrecondition(blePeripheralManager);
+
+    return blePeripheralManager->numRoundTrips;
+}
+
+HAP_RESULT_USE_CHECK
+bool HAPPlatformBLEPeripheralManagerConfirmIndication(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* _Nonnull valueHandle) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerCentral* _Nullable central = GetCentral(blePeripheralManager, connectionHandle);
+    HAPPrecondition(central);
+    HAPPrecondition(valueHandle);
+
+    if (!central->indicationValueHandle) {
+        *valueHandle = 0;
+        return false;
+    }
+    *valueHandle = central->indicationValueHandle;
+    central->indicationValueHandle = 0;
+
+    if (blePeripheralManager->delegate.handleReadyToUpdateSubscribers) {
+        blePeripheralManager->delegate.handleReadyToUpdateSubscribers(
+                blePeripheralManager, connectionHandle, blePeripheralManager->delegate.context);
+    }
+    return true;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerReadAttribute(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle,
+        void* _Nonnull bytes,
+        size_t maxBytes,
+        size_t* _Nonnull numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerCentral* _Nullable central = GetCentral(blePeripheralManager, connectionHandle);
+    HAPPrecondition(central);
+    HAPPrecondition(blePeripheralManager->delegate.handleReadRequest);
+    HAPPrecondition(attributeHandle);
+    HAPPrecondition(bytes);
+    HAPPrecondition(numBytes);
+
+    HAPError err;
+
+    if (central->isCancelled) {
+        HAPLog(&logObject, "Rejecting read request: Connection 0x%04x has been cancelled.", connectionHandle);
+        return kHAPError_InvalidState;
+    }
+
+    err = blePeripheralManager->delegate.handleReadRequest(
+            blePeripheralManager,
+            connectionHandle,
+            attributeHandle,
+            bytes,
+            maxBytes,
+            numBytes,
+            blePeripheralManager->delegate.context);
+    if (err) {
+        return err;
+    }
+
+    // The value is transferred with a "Read Request" followed by "Read Blob Requests" of up to ATT_MTU - 1 bytes
+    // each, until a response is received that is shorter than ATT_MTU - 1 bytes.
+    // See Bluetooth Core Specification Version 5
+    // Vol 3 Part G Section 4.8.3 Read Long Characteristic Values
+    blePeripheralManager->numRoundTrips += *numBytes / (central->mtu - 1U) + 1;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+HAPError HAPPlatformBLEPeripheralManagerWriteAttribute(
+        HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle attributeHandle,
+        void* _Nonnull bytes,
+        size_t numBytes) {
+    HAPPrecondition(blePeripheralManager);
+    HAPPlatformBLEPeripheralManagerCentral* _Nullable central = GetCentral(blePeripheralManager, connectionHandle);
+    HAPPrecondition(central);
+    HAPPrecondition(blePeripheralManager->delegate.handleWriteRequest);
+    HAPPrecondition(attributeHandle);
+    HAPPrecondition(bytes);
+
+    if (central->isCancelled) {
+        HAPLog(&logObject, "Rejecting write request: Connection 0x%04x has been cancelled.", connectionHandle);
+        return kHAPError_InvalidState;
+    }
+
+    // Values that do not fit into a "Write Request" are transferred with "Prepare Write Requests" of up to
+    // ATT_MTU - 5 bytes each, followed by an "Execute Write Request".
+    // See Bluetooth Core Specification Version 5
+    // Vol 3 Part G Section 4.9.3 Write Characteristic Value and Section 4.9.4 Write Long Characteristic Values
+    if (numBytes <= central->mtu - 3U) {
+        blePeripheralManager->numRoundTrips++;
+    } else {
+        size_t numPrepareWriteBytes = central->mtu - 5U;
+        blePeripheralManager->numRoundTrips += (numBytes + numPrepareWriteBytes - 1) / numPrepareWriteBytes + 1;
+    }
+
+    return blePeripheralManager->delegate.handleWriteRequest(
+            blePeripheralManager,
+            connectionHandle,
+            attributeHandle,
+            bytes,
+            numBytes,
+            blePeripheralManager->delegate.context);
+}
+
+static void CancellationTimerExpired(HAPPlatformTimerRef timer, void* _Nullable context) {
+    HAPPrecondition(context);
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = context;
+    HAPPrecondition(timer == blePeripheralManager->cancellationTimer);
+    blePeripheralManager->cancellationTimer = 0;
+
+    for (size_t i = 0; i < HAPArrayCount(blePeripheralManager->centrals); i++) {
+        const HAPPlatformBLEPeripheralManagerCentral* central = &blePeripheralManager->centrals[i];
+        if (central->isConnected && central->isCancelled) {
+            HAPPlatformBLEPeripheralManagerDisconnectCentral(blePeripheralManager, central->connectionHandle);
+        }
+    }
+}
+
 void HAPPlatformBLEPeripheralManagerCancelCentralConnection(
         HAPPlatformBLEPeripheralManagerRef _Nonnull blePeripheralManager,
         HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle) {
     HAPPrecondition(blePeripheralManager);
 
-    (void) connectionHandle;
-    HAPLogError(&logObject, "[NYI] %s.", __func__);
-    HAPFatalError();
+    HAPError err;
+
+    HAPPlatformBLEPeripheralManagerCentral* _Nullable central = GetCentral(blePeripheralManager, connectionHandle);
+    if (!central) {
+        HAPLog(&logObject, "%s: Connection 0x%04x not found.", __func__, connectionHandle);
+        return;
+    }
+    central->isCancelled = true;
+
+    // The disconnection is reported asynchronously, like on a real BLE stack.
+    if (!blePeripheralManager->cancellationTimer) {
+        err = HAPPlatformTimerRegister(
+                &blePeripheralManager->cancellationTimer, 0, CancellationTimerExpired, blePeripheralManager);
+        if (err) {
+            HAPAssert(err == kHAPError_OutOfResources);
+            HAPLogError(&logObject, "Not enough resources to schedule disconnection.");
+            HAPFatalError();
+        }
+    }
 }
 
 HAPError HAPPlatformBLEPeripheralManagerSendHandleValueIndication(
@@ -428,8 +683,14 @@ HAPError HAPPlatformBLEPeripheralManagerSendHandleValueIndication(
     HAPPrecondition(blePeripheralManager);
     HAPPrecondition(valueHandle);
     HAPPrecondition(!numBytes || bytes);
+    HAPPlatformBLEPeripheralManagerCentral* _Nullable central = GetCentral(blePeripheralManager, connectionHandle);
+    HAPPrecondition(central);
 
-    (void) connectionHandle;
-    HAPLogError(&logObject, "[NYI] %s.", __func__);
-    HAPFatalError();
+    // Only one Handle Value Indication may be outstanding until the central confirms it.
+    if (central->indicationValueHandle) {
+        return kHAPError_InvalidState;
+    }
+    central->indicationValueHandle = valueHandle;
+    blePeripheralManager->numRoundTrips++;
+    return kHAPError_None;
 }
@@ -9,7 +9,12 @@
 
 static const HAPLogObject logObject = { .subsystem = kHAPPlatform_LogSubsystem, .category = "Timer" };
 
-#define kTimerStorage_MaxTimers ((size_t) 32)
+/**
+ * Maximum number of concurrently registered timers.
+ *
+ * - Every TCP stream of the mock TCP stream manager may hold a timer to invoke its callback.
+ */
+#define kTimerStorage_MaxTimers ((size_t) 1024)
 
 typedef struct {
     /**
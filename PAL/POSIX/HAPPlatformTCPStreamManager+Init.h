@@ -26,6 +26,10 @@ extern "C" {
  * The following limitations apply if this code is not modified:
  * - Non-null values for the option interfaceName are ignored on platforms without support for the socket option
  *   SO_BINDTODEVICE which binds the socket to a particular network interface.
+ * - The options keepAlive.probeInterval and keepAlive.numProbes are ignored on platforms without support for the
+ *   socket options TCP_KEEPINTVL and TCP_KEEPCNT. The option userTimeout is ignored on platforms without support
+ *   for the socket option TCP_USER_TIMEOUT. Keepalive and user timeout options that the running system rejects
+ *   are logged and skipped.
  *
  * **Example**
 
@@ -43,7 +47,12 @@ extern "C" {
            .port = kHAPNetworkPort_Any,
 
            // Allocate enough concurrent TCP streams to support the IP accessory.
-           .maxConcurrentTCPStreams = kHAPIPSessionStorage_DefaultNumElements
+           // One more TCP stream than IP sessions lets the accessory server evict idle sessions for new connections.
+           .maxConcurrentTCPStreams = kHAPIPSessionStorage_DefaultNumElements + 1,
+
+           // Close TCP streams of controllers that are no longer reachable.
+           .keepAlive = { .idleTime = 60, .probeInterval = 10, .numProbes = 3 },
+           .userTimeout = 60 * 1000
    });
 
    @endcode
@@ -71,6 +80,45 @@ typedef struct {
      * Maximum number of concurrent TCP streams.
      */
     size_t maxConcurrentTCPStreams;
+
+    /**
+     * TCP keepalive configuration of accepted TCP streams.
+     *
+     * - If keepalive is enabled, the system probes TCP streams that have been idle for a while and closes them
+     *   if the peer does not respond. Reads from such a TCP stream report that the peer has closed the connection.
+     */
+    struct {
+        /**
+         * Time in seconds that a TCP stream must be idle before keepalive probes are sent.
+         *
+         * - A value of 0 disables keepalive.
+         */
+        uint32_t idleTime;
+
+        /**
+         * Interval in seconds between keepalive probes.
+         *
+         * - A value of 0 uses the system default.
+         */
+        uint32_t probeInterval;
+
+        /**
+         * Number of unanswered keepalive probes after which a TCP stream is closed.
+         *
+         * - A value of 0 uses the system default.
+         */
+        uint32_t numProbes;
+    } keepAlive;
+
+    /**
+     * Maximum time in milliseconds that sent data may remain unacknowledged before a TCP stream is closed.
+     *
+     * - Keepalive probes are not sent while data is unacknowledged. This timeout bounds the time until a TCP stream
+     *   to an unreachable peer is closed while data is pending, e.g., when event notifications are sent.
+     *
+     * - A value of 0 uses the system default.
+     */
+    uint32_t userTimeout;
 } HAPPlatformTCPStreamManagerOptions;
 
 // Opaque type. Do not use directly.
@@ -115,6 +163,13 @@ struct HAPPlatformTCPStreamManager {
         HAPNetworkPort port;
     } tcpStreamListenerConfiguration;
 
+    struct {
+        uint32_t keepAliveIdleTime;
+        uint32_t keepAliveProbeInterval;
+        uint32_t keepAliveNumProbes;
+        uint32_t userTimeout;
+    } tcpStreamConfiguration;
+
     HAPPlatformTCPStreamListener tcpStreamListener;
     HAPPlatformTCPStream* _Nullable tcpStreams;
     /**@endcond */
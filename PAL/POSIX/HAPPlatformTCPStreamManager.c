@@ -6,6 +6,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/tcp.h>
@@ -115,12 +116,166 @@ static HAPError SetNodelay(int fileDescriptor) {
     return kHAPError_None;
 }
 
+/**
+ * Sets an integer socket option of a TCP stream socket.
+ *
+ * @param      fileDescriptor       Socket file descriptor.
+ * @param      level                Protocol level of the option.
+ * @param      optionName           Option.
+ * @param      optionDescription    Name of the option for logging.
+ * @param      value                Value.
+ *
+ * @return kHAPError_None           If successful.
+ * @return kHAPError_Unknown        If the socket option could not be set.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError SetSocketOption(
+        int fileDescriptor,
+        int level,
+        int optionName,
+        const char* optionDescription,
+        int value) {
+    HAPPrecondition(optionDescription);
+
+    HAPLogBufferDebug(
+            &logObject,
+            &value,
+            sizeof value,
+            "setsockopt(%d, %d, %s, <buffer>);",
+            fileDescriptor,
+            level,
+            optionDescription);
+    int e = setsockopt(fileDescriptor, level, optionName, &value, sizeof value);
+    if (e != 0) {
+        int _errno = errno;
+        HAPAssert(e == -1);
+        HAPPlatformLogPOSIXError(
+                kHAPLogType_Default,
+                "System call 'setsockopt' on TCP stream socket failed.",
+                _errno,
+                __func__,
+                HAP_FILE,
+                __LINE__);
+        HAPLog(&logObject, "Failed to set socket option %s to %d.", optionDescription, value);
+        return kHAPError_Unknown;
+    }
+    return kHAPError_None;
+}
+
+/**
+ * Configures TCP keepalive and the TCP user timeout of a TCP stream socket.
+ *
+ * - These options only tune the detection of unreachable peers. Options that cannot be set are logged and skipped.
+ *
+ * @param      tcpStreamManager     TCP stream manager.
+ * @param      fileDescriptor       Socket file descriptor.
+ */
+static void SetKeepAlive(HAPPlatformTCPStreamManagerRef tcpStreamManager, int fileDescriptor) {
+    HAPPrecondition(tcpStreamManager);
+
+    HAPError err;
+
+    if (tcpStreamManager->tcpStreamConfiguration.keepAliveIdleTime) {
+        err = SetSocketOption(fileDescriptor, SOL_SOCKET, SO_KEEPALIVE, "SO_KEEPALIVE", 1);
+        if (err) {
+            HAPLog(&logObject, "Continuing without keepalive for TCP stream.");
+        } else {
+#if defined(TCP_KEEPIDLE)
+            err = SetSocketOption(
+                    fileDescriptor,
+                    IPPROTO_TCP,
+                    TCP_KEEPIDLE,
+                    "TCP_KEEPIDLE",
+                    (int) tcpStreamManager->tcpStreamConfiguration.keepAliveIdleTime);
+#elif defined(TCP_KEEPALIVE)
+            err = SetSocketOption(
+                    fileDescriptor,
+                    IPPROTO_TCP,
+                    TCP_KEEPALIVE,
+                    "TCP_KEEPALIVE",
+                    (int) tcpStreamManager->tcpStreamConfiguration.keepAliveIdleTime);
+#else
+            HAPLog(&logObject, "Ignoring keepalive idle time of TCP stream.");
+            err = kHAPError_None;
+#endif
+            if (err) {
+                HAPLog(&logObject, "Continuing with default keepalive idle time for TCP stream.");
+            }
+            if (tcpStreamManager->tcpStreamConfiguration.keepAliveProbeInterval) {
+#if defined(TCP_KEEPINTVL)
+                err = SetSocketOption(
+                        fileDescriptor,
+                        IPPROTO_TCP,
+                        TCP_KEEPINTVL,
+                        "TCP_KEEPINTVL",
+                        (int) tcpStreamManager->tcpStreamConfiguration.keepAliveProbeInterval);
+                if (err) {
+                    HAPLog(&logObject, "Continuing with default keepalive probe interval for TCP stream.");
+                }
+#else
+                HAPLog(&logObject, "Ignoring keepalive probe interval of TCP stream.");
+#endif
+            }
+            if (tcpStreamManager->tcpStreamConfiguration.keepAliveNumProbes) {
+#if defined(TCP_KEEPCNT)
+                err = SetSocketOption(
+                        fileDescriptor,
+                        IPPROTO_TCP,
+                        TCP_KEEPCNT,
+                        "TCP_KEEPCNT",
+                        (int) tcpStreamManager->tcpStreamConfiguration.keepAliveNumProbes);
+                if (err) {
+                    HAPLog(&logObject, "Continuing with default number of keepalive probes for TCP stream.");
+                }
+#else
+                HAPLog(&logObject, "Ignoring number of keepalive probes of TCP stream.");
+#endif
+            }
+        }
+    }
+    if (tcpStreamManager->tcpStreamConfiguration.userTimeout) {
+#if defined(TCP_USER_TIMEOUT)
+        err = SetSocketOption(
+                fileDescriptor,
+                IPPROTO_TCP,
+                TCP_USER_TIMEOUT,
+                "TCP_USER_TIMEOUT",
+                (int) tcpStreamManager->tcpStreamConfiguration.userTimeout);
+        if (err) {
+            HAPLog(&logObject, "Continuing with default user timeout for TCP stream.");
+        }
+#else
+        HAPLog(&logObject, "Ignoring user timeout of TCP stream.");
+#endif
+    }
+}
+
+/**
+ * Returns whether an error of a TCP stream socket indicates that the connection to the peer has been lost.
+ *
+ * - This includes TCP streams that have been closed because keepalive probes or sent data were not acknowledged.
+ *
+ * @param      _errno               Error number.
+ *
+ * @return true                     If the connection to the peer has been lost.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool IsConnectionLost(int _errno) {
+    return (_errno == ETIMEDOUT) || (_errno == ECONNRESET) || (_errno == EHOSTUNREACH) || (_errno == ENETUNREACH) ||
+           (_errno == EPIPE);
+}
+
 void HAPPlatformTCPStreamManagerCreate(
         HAPPlatformTCPStreamManagerRef tcpStreamManager,
         const HAPPlatformTCPStreamManagerOptions* options) {
     HAPPrecondition(tcpStreamManager);
     HAPPrecondition(options);
     HAPPrecondition(options->maxConcurrentTCPStreams);
+    HAPPrecondition(options->keepAlive.idleTime <= INT_MAX);
+    HAPPrecondition(options->keepAlive.probeInterval <= INT_MAX);
+    HAPPrecondition(options->keepAlive.numProbes <= INT_MAX);
+    HAPPrecondition(options->userTimeout <= INT_MAX);
 
     HAPRawBufferZero(tcpStreamManager, sizeof *tcpStreamManager);
 
@@ -138,6 +293,10 @@ void HAPPlatformTCPStreamManagerCreate(
     }
     tcpStreamManager->tcpStreamListenerConfiguration.port = options->port;
 
+    tcpStreamManager->tcpStreamConfiguration.keepAliveIdleTime = options->keepAlive.idleTime;
+    tcpStreamManager->tcpStreamConfiguration.keepAliveProbeInterval = options->keepAlive.probeInterval;
+    tcpStreamManager->tcpStreamConfiguration.keepAliveNumProbes = options->keepAlive.numProbes;
+    tcpStreamManager->tcpStreamConfiguration.userTimeout = options->userTimeout;
     tcpStreamManager->numTCPStreams = 0;
     tcpStreamManager->maxTCPStreams = options->maxConcurrentTCPStreams;
 
@@ -478,6 +637,7 @@ HAPError HAPPlatformTCPStreamManagerAcceptTCPStream(
         HAPLogError(&logObject, "Failed to disable Nagle's algorithm for TCP stream socket.");
         HAPFatalError();
     }
+    SetKeepAlive(tcpStreamManager, fileDescriptor);
 
     HAPPlatformFileHandleRef fileHandle;
     err = HAPPlatformFileHandleRegister(
@@ -670,6 +830,18 @@ HAPError HAPPlatformTCPStreamRead(
         n = recv(tcpStream->fileDescriptor, bytes, maxBytes, 0);
     } while ((n == -1) && (errno == EINTR));
     if (n == -1) {
+        if (IsConnectionLost(errno)) {
+            // Report lost connections as closed by the peer so that the TCP stream is closed.
+            HAPPlatformLogPOSIXError(
+                    kHAPLogType_Info,
+                    "System call 'recv' on TCP stream socket failed. Connection lost.",
+                    errno,
+                    __func__,
+                    HAP_FILE,
+                    __LINE__);
+            *numBytes = 0;
+            return kHAPError_None;
+        }
         if (errno != EAGAIN && errno != EWOULDBLOCK) {
             HAPPlatformLogPOSIXError(
                     kHAPLogType_Default,
@@ -0,0 +1,608 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/HAPBenchmark.c"
+#include "Harness/TemplateDB.c"
+
+#define kNumBenchmarkOperations ((size_t) 1000000)
+
+/**
+ * Number of bridged accessories.
+ */
+#define kNumBridgedAccessories kHAPAccessoryServerMaxBridgedAccessories
+
+/**
+ * Number of attributes of the bridge accessory.
+ */
+#define kNumBridgeAttributes (kAttributeCount + 3)
+
+/**
+ * Number of attributes of a bridged accessory.
+ */
+#define kNumBridgedAccessoryAttributes ((size_t)(9 + 3))
+
+/**
+ * Number of characteristic value cache elements that are used to test eviction.
+ */
+#define kNumValueCacheElements ((size_t) 4)
+
+/**
+ * Number of elements required to flatten the attribute database.
+ */
+#define kNumAttributeDatabaseElements \
+    HAPAttributeDatabaseGetNumElements( \
+            1 + kNumBridgedAccessories, kNumBridgeAttributes + kNumBridgedAccessories * kNumBridgedAccessoryAttributes)
+
+/**
+ * Whether the accessory server completed its shutdown.
+ */
+static bool accessoryServerIsStopped;
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server, void* _Nullable context HAP_UNUSED) {
+    HAPPrecondition(server);
+
+    accessoryServerIsStopped = HAPAccessoryServerGetState(server) == kHAPAccessoryServerState_Idle;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+static const HAPUUID kTestServiceType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                            0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x41 } };
+static const HAPUUID kTestCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                   0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x42 } };
+static const HAPUUID kOtherTestCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                        0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x43 } };
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleTestCharacteristicRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPUInt8CharacteristicReadRequest* request HAP_UNUSED,
+        uint8_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = 0;
+    return kHAPError_None;
+}
+
+static const HAPUInt8Characteristic testCharacteristic = {
+    .format = kHAPCharacteristicFormat_UInt8,
+    .iid = 0x0031,
+    .characteristicType = &kTestCharacteristicType,
+    .debugDescription = "test",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = false,
+                    .supportsEventNotification = true,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .cacheable = true,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .units = kHAPCharacteristicUnits_None,
+    .constraints = { .minimumValue = 0, .maximumValue = UINT8_MAX, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleTestCharacteristicRead }
+};
+
+static const HAPUInt8Characteristic otherTestCharacteristic = {
+    .format = kHAPCharacteristicFormat_UInt8,
+    .iid = 0x0032,
+    .characteristicType = &kOtherTestCharacteristicType,
+    .debugDescription = "other test",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = false,
+                    .supportsEventNotification = true,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .units = kHAPCharacteristicUnits_None,
+    .constraints = { .minimumValue = 0, .maximumValue = UINT8_MAX, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleTestCharacteristicRead }
+};
+
+static const HAPService testService = {
+    .iid = 0x0030,
+    .serviceType = &kTestServiceType,
+    .debugDescription = "test",
+    .name = NULL,
+    .properties = { .primaryService = true, .hidden = false, .ble = { .supportsConfiguration = false } },
+    .linkedServices = NULL,
+    .characteristics = (const HAPCharacteristic* const[]) { &testCharacteristic, &otherTestCharacteristic, NULL }
+};
+
+static const HAPAccessory bridgeAccessory = { .aid = 1,
+                                              .category = kHAPAccessoryCategory_Bridges,
+                                              .name = "Acme Test",
+                                              .manufacturer = "Acme",
+                                              .model = "Test1,1",
+                                              .serialNumber = "099DB48E9E28",
+                                              .firmwareVersion = "1",
+                                              .hardwareVersion = "1",
+                                              .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                        &hapProtocolInformationService,
+                                                                                        &pairingService,
+                                                                                        &testService,
+                                                                                        NULL },
+                                              .callbacks = { .identify = IdentifyAccessory } };
+
+static const HAPService* const bridgedAccessoryServices[] = { &accessoryInformationService, &testService, NULL };
+
+static HAPAccessory bridgedAccessories[kNumBridgedAccessories];
+static const HAPAccessory* _Nullable bridgedAccessoryList[kNumBridgedAccessories + 1];
+
+/**
+ * Sets up the bridged accessories.
+ *
+ * @param      sortedByAID          Whether the bridged accessories are registered in ascending accessory instance ID
+ *                                  order.
+ */
+static void PrepareBridgedAccessories(bool sortedByAID) {
+    static char names[kNumBridgedAccessories][32];
+    for (size_t i = 0; i < kNumBridgedAccessories; i++) {
+        HAPError err = HAPStringWithFormat(names[i], sizeof names[i], "Acme Bridged %zu", i);
+        HAPAssert(!err);
+        bridgedAccessories[i] = (HAPAccessory) {
+            .aid = sortedByAID ? 2 + i : 1 + kNumBridgedAccessories - i,
+            .category = kHAPAccessoryCategory_BridgedAccessory,
+            .name = names[i],
+            .manufacturer = "Acme",
+            .model = "Bridged1,1",
+            .serialNumber = "099DB48E9E29",
+            .firmwareVersion = "1",
+            .hardwareVersion = "1",
+            .services = bridgedAccessoryServices,
+            .callbacks = { .identify = IdentifyAccessory }
+        };
+        bridgedAccessoryList[i] = &bridgedAccessories[i];
+    }
+    bridgedAccessoryList[kNumBridgedAccessories] = NULL;
+}
+
+static HAPAccessoryServerRef accessoryServer;
+
+/**
+ * Creates and starts an accessory server that bridges the bridged accessories.
+ *
+ * @param      attributeDatabaseElements Flattened attribute database storage. Optional.
+ * @param      numAttributeDatabaseElements Number of flattened attribute database elements.
+ * @param      numValueCacheElements Number of characteristic value cache elements.
+ */
+static void StartAccessoryServer(
+        HAPAttributeDatabaseElementRef* _Nullable attributeDatabaseElements,
+        size_t numAttributeDatabaseElements,
+        size_t numValueCacheElements) {
+    static HAPIPSession ipSessions[1];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage = {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer }
+    };
+    static HAPCharacteristicValueCacheElementRef valueCacheElements[1 + kNumBridgedAccessories];
+    HAPPrecondition(numValueCacheElements <= HAPArrayCount(valueCacheElements));
+
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .attributeDatabase = { .elements = attributeDatabaseElements,
+                                           .numElements = numAttributeDatabaseElements },
+                    .valueCache = { .elements = valueCacheElements, .numElements = numValueCacheElements },
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    HAPAccessoryServerStartBridge(
+            &accessoryServer, &bridgeAccessory, bridgedAccessoryList, /* configurationChanged: */ false);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+}
+
+/**
+ * Stops and releases the accessory server.
+ */
+static void StopAccessoryServer(void) {
+    accessoryServerIsStopped = false;
+    HAPAccessoryServerStop(&accessoryServer);
+
+    // Timers that are registered while processing expired timers only fire on the next clock advance.
+    for (size_t i = 0; !accessoryServerIsStopped; i++) {
+        HAPAssert(i < 8);
+        HAPPlatformClockAdvance(0);
+    }
+    HAPAssert(!HAPAttributeDatabaseIsFlattened(&accessoryServer));
+    HAPAccessoryServerRelease(&accessoryServer);
+}
+
+/**
+ * Returns the accessory with a given index in registration order.
+ *
+ * @param      index                Index of the accessory. 0 for the bridge accessory.
+ *
+ * @return Accessory.
+ */
+HAP_RESULT_USE_CHECK
+static const HAPAccessory* GetAccessory(size_t index) {
+    return index ? bridgedAccessoryList[index - 1] : &bridgeAccessory;
+}
+
+/**
+ * Looks up a characteristic that is supported over HAP over IP by walking the accessory definitions.
+ *
+ * @param      aid                  Accessory instance ID.
+ * @param      iid                  Characteristic instance ID.
+ * @param[out] characteristic       Characteristic, if found. NULL otherwise.
+ * @param[out] service              The service that contains the characteristic, if found. NULL otherwise.
+ * @param[out] accessory            The accessory that provides the service, if found. NULL otherwise.
+ */
+static void FindIPCharacteristicByWalking(
+        uint64_t aid,
+        uint64_t iid,
+        const HAPCharacteristic* _Nullable* _Nonnull characteristic,
+        const HAPService* _Nullable* _Nonnull service,
+        const HAPAccessory* _Nullable* _Nonnull accessory) {
+    *characteristic = NULL;
+    *service = NULL;
+    *accessory = NULL;
+    for (size_t i = 0; i < 1 + kNumBridgedAccessories; i++) {
+        const HAPAccessory* acc = GetAccessory(i);
+        if (acc->aid != aid) {
+            continue;
+        }
+        for (size_t j = 0; acc->services[j]; j++) {
+            const HAPService* svc = acc->services[j];
+            if (!HAPAccessoryServerSupportsService(&accessoryServer, kHAPTransportType_IP, svc)) {
+                continue;
+            }
+            for (size_t k = 0; svc->characteristics[k]; k++) {
+                const HAPBaseCharacteristic* chr = svc->characteristics[k];
+                if (HAPIPCharacteristicIsSupported(chr) && chr->iid == iid) {
+                    *characteristic = chr;
+                    *service = svc;
+                    *accessory = acc;
+                    return;
+                }
+            }
+        }
+        return;
+    }
+}
+
+/**
+ * Characteristic types that have been found, with their interned characteristic types.
+ */
+static struct {
+    HAPTypeID typeID;
+    const HAPUUID* type;
+} foundCharacteristicTypes[32];
+static size_t numFoundCharacteristicTypes;
+
+/**
+ * Checks that an interned characteristic type is consistent with all previously found characteristic types.
+ *
+ * @param      typeID               Interned characteristic type.
+ * @param      type                 Characteristic type.
+ */
+static void CheckCharacteristicTypeID(HAPTypeID typeID, const HAPUUID* type) {
+    if (HAPUUIDIsAppleDefined(type)) {
+        HAPAssert(typeID == HAPAttributeDatabaseGetTypeID(type));
+    } else {
+        HAPAssert(HAPAttributeDatabaseGetTypeID(type) == kHAPTypeID_Vendor);
+        HAPAssert(typeID & kHAPTypeID_Vendor);
+    }
+    for (size_t i = 0; i < numFoundCharacteristicTypes; i++) {
+        if (foundCharacteristicTypes[i].typeID == typeID || HAPUUIDAreEqual(foundCharacteristicTypes[i].type, type)) {
+            HAPAssert(foundCharacteristicTypes[i].typeID == typeID);
+            HAPAssert(HAPUUIDAreEqual(foundCharacteristicTypes[i].type, type));
+            return;
+        }
+    }
+    HAPAssert(numFoundCharacteristicTypes < HAPArrayCount(foundCharacteristicTypes));
+    foundCharacteristicTypes[numFoundCharacteristicTypes].typeID = typeID;
+    foundCharacteristicTypes[numFoundCharacteristicTypes].type = type;
+    numFoundCharacteristicTypes++;
+}
+
+/**
+ * Checks that a flattened lookup by accessory instance ID and instance ID matches the accessory definitions.
+ *
+ * @param      aid                  Accessory instance ID.
+ * @param      iid                  Characteristic instance ID.
+ */
+static void CheckFindIPCharacteristic(uint64_t aid, uint64_t iid) {
+    const HAPCharacteristic* _Nullable expectedCharacteristic;
+    const HAPService* _Nullable expectedService;
+    const HAPAccessory* _Nullable expectedAccessory;
+    FindIPCharacteristicByWalking(aid, iid, &expectedCharacteristic, &expectedService, &expectedAccessory);
+
+    const HAPCharacteristic* _Nullable characteristic;
+    const HAPService* _Nullable service;
+    const HAPAccessory* _Nullable accessory;
+    HAPTypeID characteristicTypeID;
+    HAPAttributeDatabaseFindIPCharacteristic(
+            &accessoryServer, aid, iid, &characteristic, &service, &accessory, &characteristicTypeID);
+    HAPAssert(characteristic == expectedCharacteristic);
+    HAPAssert(service == expectedService);
+    HAPAssert(accessory == expectedAccessory);
+    if (characteristic) {
+        CheckCharacteristicTypeID(
+                characteristicTypeID, ((const HAPBaseCharacteristic*) characteristic)->characteristicType);
+    }
+}
+
+/**
+ * Checks that all flattened lookups match the accessory definitions.
+ */
+static void CheckAttributeDatabase(void) {
+    HAPAssert(HAPAttributeDatabaseIsFlattened(&accessoryServer));
+
+    // Accessory lookup.
+    for (size_t i = 0; i < 1 + kNumBridgedAccessories; i++) {
+        const HAPAccessory* accessory = GetAccessory(i);
+        HAPAssert(HAPAttributeDatabaseFindAccessory(&accessoryServer, accessory->aid) == accessory);
+    }
+    HAPAssert(!HAPAttributeDatabaseFindAccessory(&accessoryServer, 0));
+    HAPAssert(!HAPAttributeDatabaseFindAccessory(&accessoryServer, 2 + kNumBridgedAccessories));
+    HAPAssert(!HAPAttributeDatabaseFindAccessory(&accessoryServer, UINT64_MAX));
+
+    // Characteristic lookup, including unknown instance IDs and services / characteristics not supported over IP.
+    numFoundCharacteristicTypes = 0;
+    for (uint64_t aid = 0; aid <= 2 + kNumBridgedAccessories; aid++) {
+        for (uint64_t iid = 0; iid <= 0x40; iid++) {
+            CheckFindIPCharacteristic(aid, iid);
+        }
+        CheckFindIPCharacteristic(aid, UINT64_MAX);
+    }
+
+    // Service type index.
+    HAPAssert(HAPAccessoryServerGetNumServiceInstances(&accessoryServer, &kTestServiceType) ==
+              1 + kNumBridgedAccessories);
+    HAPAssert(HAPAccessoryServerGetNumServiceInstances(&accessoryServer, &kHAPServiceType_AccessoryInformation) ==
+              1 + kNumBridgedAccessories);
+    HAPAssert(HAPAccessoryServerGetNumServiceInstances(&accessoryServer, &kHAPServiceType_Pairing) == 1);
+    HAPAssert(!HAPAccessoryServerGetNumServiceInstances(&accessoryServer, &kHAPServiceType_LightBulb));
+    for (size_t i = 0; i < 1 + kNumBridgedAccessories; i++) {
+        const HAPAccessory* accessory = GetAccessory(i);
+        for (size_t j = 0; accessory->services[j]; j++) {
+            const HAPService* service = accessory->services[j];
+            HAPServiceTypeIndex serviceTypeIndex =
+                    HAPAccessoryServerGetServiceTypeIndex(&accessoryServer, service, accessory);
+            bool isSharedServiceType = HAPUUIDAreEqual(service->serviceType, &kTestServiceType) ||
+                                       HAPUUIDAreEqual(service->serviceType, &kHAPServiceType_AccessoryInformation);
+            HAPAssert(serviceTypeIndex == (isSharedServiceType ? i : 0));
+
+            const HAPService* foundService;
+            const HAPAccessory* foundAccessory;
+            HAPAccessoryServerGetServiceFromServiceTypeIndex(
+                    &accessoryServer, service->serviceType, serviceTypeIndex, &foundService, &foundAccessory);
+            HAPAssert(foundService == service);
+            HAPAssert(foundAccessory == accessory);
+        }
+    }
+}
+
+static void TestAttributeDatabase(bool sortedByAID) {
+    static HAPAttributeDatabaseElementRef attributeDatabaseElements[kNumAttributeDatabaseElements];
+
+    PrepareBridgedAccessories(sortedByAID);
+
+    // Exact storage.
+    StartAccessoryServer(
+            attributeDatabaseElements,
+            HAPArrayCount(attributeDatabaseElements),
+            /* numValueCacheElements: */ 0);
+    CheckAttributeDatabase();
+    StopAccessoryServer();
+
+    // Storage too small. Accessory server falls back to walking the accessory definitions.
+    StartAccessoryServer(
+            attributeDatabaseElements,
+            HAPArrayCount(attributeDatabaseElements) - 1,
+            /* numValueCacheElements: */ 0);
+    HAPAssert(!HAPAttributeDatabaseIsFlattened(&accessoryServer));
+    StopAccessoryServer();
+
+    // No storage.
+    StartAccessoryServer(
+            /* attributeDatabaseElements: */ NULL,
+            /* numAttributeDatabaseElements: */ 0,
+            /* numValueCacheElements: */ 0);
+    HAPAssert(!HAPAttributeDatabaseIsFlattened(&accessoryServer));
+    StopAccessoryServer();
+}
+
+static void BenchmarkAttributeDatabase(void) {
+    static HAPAttributeDatabaseElementRef attributeDatabaseElements[kNumAttributeDatabaseElements];
+
+    PrepareBridgedAccessories(/* sortedByAID: */ true);
+    StartAccessoryServer(
+            attributeDatabaseElements,
+            HAPArrayCount(attributeDatabaseElements),
+            /* numValueCacheElements: */ 0);
+
+    HAPLogInfo(
+            &kHAPLog_Default,
+            "Flattened attribute database: %zu elements (%zu bytes).",
+            HAPArrayCount(attributeDatabaseElements),
+            sizeof attributeDatabaseElements);
+
+    // Look up the test characteristic of the last bridged accessory. This is the worst case when walking.
+    uint64_t aid = 1 + kNumBridgedAccessories;
+    uint64_t iid = testCharacteristic.iid;
+    const HAPCharacteristic* _Nullable characteristic;
+    const HAPService* _Nullable service;
+    const HAPAccessory* _Nullable accessory;
+
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations; i++) {
+        FindIPCharacteristicByWalking(aid, iid, &characteristic, &service, &accessory);
+        HAPAssert(characteristic);
+    }
+    HAPBenchmarkLogRate(
+            "Characteristic lookup (walk)", kNumBenchmarkOperations, HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations; i++) {
+        HAPAttributeDatabaseFindIPCharacteristic(
+                &accessoryServer, aid, iid, &characteristic, &service, &accessory, /* characteristicTypeID: */ NULL);
+        HAPAssert(characteristic);
+    }
+    HAPBenchmarkLogRate(
+            "Characteristic lookup (flattened)", kNumBenchmarkOperations, HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    StopAccessoryServer();
+}
+
+/**
+ * Stores the index of an accessory as the cached value of its test characteristic.
+ *
+ * @param      index                Index of the accessory. 0 for the bridge accessory.
+ */
+static void SetCachedValue(size_t index) {
+    uint8_t value = (uint8_t) index;
+    HAPCharacteristicValueCacheSet(
+            &accessoryServer, &testCharacteristic, &testService, GetAccessory(index), &value, sizeof value);
+}
+
+/**
+ * Checks whether the test characteristic of an accessory has a cached value.
+ *
+ * - A cached value counts as use of the cache element.
+ *
+ * @param      index                Index of the accessory. 0 for the bridge accessory.
+ * @param      isCached             Whether a value is expected to be cached.
+ */
+static void CheckCachedValue(size_t index, bool isCached) {
+    uint8_t value;
+    bool found = HAPCharacteristicValueCacheGet(
+            &accessoryServer, &testCharacteristic, &testService, GetAccessory(index), &value, sizeof value);
+    HAPAssert(found == isCached);
+    HAPAssert(!found || value == (uint8_t) index);
+}
+
+static void TestValueCache(bool flattenAttributeDatabase) {
+    static HAPAttributeDatabaseElementRef attributeDatabaseElements[kNumAttributeDatabaseElements];
+
+    PrepareBridgedAccessories(/* sortedByAID: */ true);
+    StartAccessoryServer(
+            flattenAttributeDatabase ? attributeDatabaseElements : NULL,
+            flattenAttributeDatabase ? HAPArrayCount(attributeDatabaseElements) : 0,
+            kNumValueCacheElements);
+    HAPAssert(HAPAttributeDatabaseIsFlattened(&accessoryServer) == flattenAttributeDatabase);
+
+    // Values of a characteristic that is shared between accessories are cached per accessory.
+    for (size_t i = 0; i < kNumValueCacheElements; i++) {
+        SetCachedValue(i);
+    }
+    for (size_t i = 0; i < kNumValueCacheElements; i++) {
+        CheckCachedValue(i, /* isCached: */ true);
+    }
+
+    // The least recently used value is evicted.
+    CheckCachedValue(0, /* isCached: */ true);
+    SetCachedValue(4);
+    CheckCachedValue(1, /* isCached: */ false);
+    CheckCachedValue(0, /* isCached: */ true);
+    CheckCachedValue(2, /* isCached: */ true);
+    CheckCachedValue(3, /* isCached: */ true);
+    CheckCachedValue(4, /* isCached: */ true);
+
+    // Unused elements are reused before values are evicted.
+    HAPCharacteristicValueCacheInvalidate(&accessoryServer, &testCharacteristic, &testService, GetAccessory(2));
+    CheckCachedValue(2, /* isCached: */ false);
+    SetCachedValue(5);
+    CheckCachedValue(0, /* isCached: */ true);
+    CheckCachedValue(3, /* isCached: */ true);
+    CheckCachedValue(4, /* isCached: */ true);
+    CheckCachedValue(5, /* isCached: */ true);
+
+    // Values are found when more characteristics than elements share hash buckets.
+    for (size_t i = 0; i < 1 + kNumBridgedAccessories; i++) {
+        SetCachedValue(i);
+        CheckCachedValue(i, /* isCached: */ true);
+        if (i >= kNumValueCacheElements) {
+            CheckCachedValue(i - kNumValueCacheElements, /* isCached: */ false);
+        }
+    }
+
+    HAPCharacteristicValueCacheInvalidateAll(&accessoryServer);
+    for (size_t i = 0; i < 1 + kNumBridgedAccessories; i++) {
+        CheckCachedValue(i, /* isCached: */ false);
+    }
+
+    StopAccessoryServer();
+}
+
+static void TestTypeIDs(void) {
+    HAPAssert(HAPAttributeDatabaseGetTypeID(&kHAPServiceType_AccessoryInformation) ==
+              kHAPServiceTypeID_AccessoryInformation);
+    HAPAssert(HAPAttributeDatabaseGetTypeID(&kHAPServiceType_Pairing) == kHAPServiceTypeID_Pairing);
+    HAPAssert(HAPAttributeDatabaseGetTypeID(&kHAPServiceType_HAPProtocolInformation) ==
+              kHAPServiceTypeID_HAPProtocolInformation);
+    HAPAssert(HAPAttributeDatabaseGetTypeID(&kHAPCharacteristicType_Identify) == kHAPCharacteristicTypeID_Identify);
+    HAPAssert(HAPAttributeDatabaseGetTypeID(&kHAPCharacteristicType_ProgrammableSwitchEvent) ==
+              kHAPCharacteristicTypeID_ProgrammableSwitchEvent);
+    HAPAssert(HAPAttributeDatabaseGetTypeID(&kHAPCharacteristicType_ServiceSignature) ==
+              kHAPCharacteristicTypeID_ServiceSignature);
+    HAPAssert(HAPAttributeDatabaseGetTypeID(&kTestServiceType) == kHAPTypeID_Vendor);
+    HAPAssert(HAPAttributeDatabaseGetTypeID(&kTestCharacteristicType) == kHAPTypeID_Vendor);
+}
+
+int main() {
+    HAPPlatformCreate();
+
+    TestTypeIDs();
+
+    TestAttributeDatabase(/* sortedByAID: */ true);
+    TestAttributeDatabase(/* sortedByAID: */ false);
+    BenchmarkAttributeDatabase();
+
+    TestValueCache(/* flattenAttributeDatabase: */ true);
+    TestValueCache(/* flattenAttributeDatabase: */ false);
+
+    return 0;
+}
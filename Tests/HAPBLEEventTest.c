@@ -42,6 +42,55 @@ static HAPError IdentifyAccessory(
     HAPFatalError();
 }
 
+static const HAPUUID kTestServiceType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                            0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x41 } };
+static const HAPUUID kTestCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                   0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x42 } };
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleTestCharacteristicRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPUInt8CharacteristicReadRequest* request HAP_UNUSED,
+        uint8_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = 0;
+    return kHAPError_None;
+}
+
+static const HAPUInt8Characteristic testCharacteristic = {
+    .format = kHAPCharacteristicFormat_UInt8,
+    .iid = 0x0031,
+    .characteristicType = &kTestCharacteristicType,
+    .debugDescription = "test",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = false,
+                    .supportsEventNotification = true,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = true,
+                             .supportsDisconnectedNotification = true,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .units = kHAPCharacteristicUnits_None,
+    .constraints = { .minimumValue = 0, .maximumValue = UINT8_MAX, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleTestCharacteristicRead }
+};
+
+static const HAPService testService = {
+    .iid = 0x0030,
+    .serviceType = &kTestServiceType,
+    .debugDescription = "test",
+    .name = NULL,
+    .properties = { .primaryService = true, .hidden = false, .ble = { .supportsConfiguration = false } },
+    .linkedServices = NULL,
+    .characteristics = (const HAPCharacteristic* const[]) { &testCharacteristic, NULL }
+};
+
 static const HAPAccessory accessory = { .aid = 1,
                                         .category = kHAPAccessoryCategory_Other,
                                         .name = "Acme Test",
@@ -53,17 +102,114 @@ static const HAPAccessory accessory = { .aid = 1,
                                         .services = (const HAPService* const[]) { &accessoryInformationService,
                                                                                   &hapProtocolInformationService,
                                                                                   &pairingService,
+                                                                                  &testService,
                                                                                   NULL },
                                         .callbacks = { .identify = IdentifyAccessory } };
 
-int main() {
+/**
+ * Fetches the GSN record from the key-value store.
+ *
+ * @param[out] gsn                  Stored GSN.
+ * @param[out] flags                Stored flags.
+ */
+static void GetStoredGSN(uint16_t* gsn, uint8_t* flags) {
     HAPError err;
-    HAPPlatformCreate();
 
-    //    static TestContext test;
+    bool found;
+    size_t numBytes;
+    uint8_t gsnBytes[3];
+    err = HAPPlatformKeyValueStoreGet(
+            platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_BLEGSN,
+            gsnBytes,
+            sizeof gsnBytes,
+            &numBytes,
+            &found);
+    HAPAssert(!err);
+    HAPAssert(found);
+    HAPAssert(numBytes == sizeof gsnBytes);
+    *gsn = HAPReadLittleUInt16(&gsnBytes[0]);
+    *flags = gsnBytes[2];
+}
+
+/**
+ * Fetches the advertised GSN.
+ *
+ * @return Advertised GSN.
+ */
+HAP_RESULT_USE_CHECK
+static uint16_t GetAdvertisedGSN(void) {
+    HAPError err;
+
+    HAPAccessoryServerInfo serverInfo;
+    HAPPlatformBLEPeripheralManagerDeviceAddress deviceAddress;
+    err = HAPDiscoverBLEAccessoryServer(HAPNonnull(platform.ble.blePeripheralManager), &serverInfo, &deviceAddress);
+    HAPAssert(!err);
+    return serverInfo.stateNumber;
+}
+
+/**
+ * Raises a disconnected event, and reconnects to allow the GSN to be incremented again.
+ */
+static void RaiseDisconnectedEvent(HAPAccessoryServerRef* server) {
+    HAPAccessoryServerRaiseEvent(server, &testCharacteristic, &testService, &accessory);
+    HAPPlatformBLEPeripheralManagerConnectCentral(HAPNonnull(platform.ble.blePeripheralManager), 1);
+    HAPPlatformBLEPeripheralManagerDisconnectCentral(HAPNonnull(platform.ble.blePeripheralManager), 1);
+}
+
+/**
+ * Checks the broadcast configuration of the test characteristic.
+ */
+static void CheckBroadcastConfiguration(
+        HAPAccessoryServerRef* server,
+        bool expectedBroadcastsEnabled,
+        HAPBLECharacteristicBroadcastInterval expectedBroadcastInterval) {
+    bool broadcastsEnabled;
+    HAPBLECharacteristicBroadcastInterval broadcastInterval;
+    HAPBLECharacteristicGetBroadcastConfiguration(
+            &testCharacteristic, &testService, &accessory, &broadcastsEnabled, &broadcastInterval, server);
+    HAPAssert(broadcastsEnabled == expectedBroadcastsEnabled);
+    if (broadcastsEnabled) {
+        HAPAssert(broadcastInterval == expectedBroadcastInterval);
+    }
+}
+
+static void TestBroadcastConfiguration(HAPAccessoryServerRef* server) {
+    HAPError err;
+
+    CheckBroadcastConfiguration(server, false, kHAPBLECharacteristicBroadcastInterval_20Ms);
+
+    // Enabling broadcasts is written through to the key-value store.
+    err = HAPBLECharacteristicEnableBroadcastNotifications(
+            &testCharacteristic, &testService, &accessory, kHAPBLECharacteristicBroadcastInterval_1280Ms, server);
+    HAPAssert(!err);
+    CheckBroadcastConfiguration(server, true, kHAPBLECharacteristicBroadcastInterval_1280Ms);
+    err = HAPBLECharacteristicLoadBroadcastConfiguration(server);
+    HAPAssert(!err);
+    CheckBroadcastConfiguration(server, true, kHAPBLECharacteristicBroadcastInterval_1280Ms);
+
+    err = HAPBLECharacteristicEnableBroadcastNotifications(
+            &testCharacteristic, &testService, &accessory, kHAPBLECharacteristicBroadcastInterval_2560Ms, server);
+    HAPAssert(!err);
+    err = HAPBLECharacteristicLoadBroadcastConfiguration(server);
+    HAPAssert(!err);
+    CheckBroadcastConfiguration(server, true, kHAPBLECharacteristicBroadcastInterval_2560Ms);
+
+    // Disabling broadcasts removes the configuration.
+    err = HAPBLECharacteristicDisableBroadcastNotifications(&testCharacteristic, &testService, &accessory, server);
+    HAPAssert(!err);
+    CheckBroadcastConfiguration(server, false, kHAPBLECharacteristicBroadcastInterval_20Ms);
+    err = HAPBLECharacteristicLoadBroadcastConfiguration(server);
+    HAPAssert(!err);
+    CheckBroadcastConfiguration(server, false, kHAPBLECharacteristicBroadcastInterval_20Ms);
+}
+
+int main() {
+    HAPPlatformCreate();
 
     // Prepare accessory server storage.
-    static HAPBLEGATTTableElementRef gattTableElements[kAttributeCount];
+    static HAPBLEGATTTableElementRef gattTableElements[kAttributeCount + 3];
     static HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
     static HAPSessionRef session;
     static uint8_t procedureBytes[2048];
@@ -101,9 +247,80 @@ int main() {
     // Discover BLE accessory server.
     HAPAccessoryServerInfo serverInfo;
     HAPPlatformBLEPeripheralManagerDeviceAddress deviceAddress;
-    err = HAPDiscoverBLEAccessoryServer(HAPNonnull(platform.ble.blePeripheralManager), &serverInfo, &deviceAddress);
+    HAPError err =
+            HAPDiscoverBLEAccessoryServer(HAPNonnull(platform.ble.blePeripheralManager), &serverInfo, &deviceAddress);
     HAPAssert(!err);
     HAPAssert(serverInfo.statusFlags.isNotPaired);
+    HAPAssert(serverInfo.stateNumber == 1);
+
+    // Broadcast configuration.
+    TestBroadcastConfiguration(&accessoryServer);
+
+    // Disconnected events: The GSN is only written to the key-value store once every few increments.
+    const uint16_t numReservedGSNs = kHAPBLEAccessoryServerGSN_NumReservedGSNs;
+    uint16_t gsn = 1;
+    for (uint16_t i = 0; i < 3 * numReservedGSNs + 1; i++) {
+        RaiseDisconnectedEvent(&accessoryServer);
+        gsn++;
+        HAPAssert(GetAdvertisedGSN() == gsn);
+
+        uint16_t storedGSN;
+        uint8_t storedFlags;
+        GetStoredGSN(&storedGSN, &storedFlags);
+        HAPAssert(storedFlags == 0x02);
+        HAPAssert(storedGSN == 1 + (i / numReservedGSNs + 1) * numReservedGSNs);
+    }
+
+    // GSN does not increment again before the next connection.
+    HAPAccessoryServerRaiseEvent(&accessoryServer, &testCharacteristic, &testService, &accessory);
+    gsn++;
+    HAPAssert(GetAdvertisedGSN() == gsn);
+    HAPAccessoryServerRaiseEvent(&accessoryServer, &testCharacteristic, &testService, &accessory);
+    HAPAssert(GetAdvertisedGSN() == gsn);
+    HAPPlatformBLEPeripheralManagerConnectCentral(HAPNonnull(platform.ble.blePeripheralManager), 1);
+    HAPPlatformBLEPeripheralManagerDisconnectCentral(HAPNonnull(platform.ble.blePeripheralManager), 1);
+
+    // Unexpected restart: The GSN continues after the last reserved GSN.
+    {
+        uint16_t storedGSN;
+        uint8_t storedFlags;
+        GetStoredGSN(&storedGSN, &storedFlags);
+        HAPAssert(storedGSN > gsn);
+
+        err = HAPBLEAccessoryServerLoadPersistentState(&accessoryServer);
+        HAPAssert(!err);
+        HAPAccessoryServerUpdateAdvertisingData(&accessoryServer);
+        HAPAssert(GetAdvertisedGSN() == storedGSN);
+        gsn = storedGSN;
+
+        RaiseDisconnectedEvent(&accessoryServer);
+        gsn++;
+        HAPAssert(GetAdvertisedGSN() == gsn);
+    }
+
+    // Regular restart: The exact GSN is saved and no GSNs are skipped.
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+    {
+        uint16_t storedGSN;
+        uint8_t storedFlags;
+        GetStoredGSN(&storedGSN, &storedFlags);
+        HAPAssert(storedGSN == gsn);
+        HAPAssert(storedFlags == 0x00);
+    }
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPAssert(GetAdvertisedGSN() == gsn);
+    RaiseDisconnectedEvent(&accessoryServer);
+    gsn++;
+    HAPAssert(GetAdvertisedGSN() == gsn);
+
+    HAPAccessoryServerStop(&accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Idle);
+    HAPAccessoryServerRelease(&accessoryServer);
 
-    // TODO Pair, discover, test events... [NYI]
+    return 0;
 }
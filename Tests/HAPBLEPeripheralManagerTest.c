@@ -0,0 +1,1951 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Init.h"
+#include "HAPPlatformBLEPeripheralManager+Test.h"
+
+#include "Harness/HAPBenchmark.c"
+#include "Harness/TemplateDB.c"
+
+/**
+ * Maximum number of characteristics in the test service.
+ */
+#define kMaxTestCharacteristics ((size_t) 256)
+
+/**
+ * Length of the value of the large value characteristic. Responses span multiple GATT reads.
+ */
+#define kNumLargeValueBytes ((size_t) 1500)
+
+/**
+ * Number of BLE GATT table elements required for the largest configuration.
+ */
+#define kMaxGATTTableElements (kAttributeCount + 3 + kMaxTestCharacteristics)
+
+/**
+ * Number of BLE peripheral manager attributes required for the largest configuration.
+ */
+#define kMaxBLEAttributes (2 * kMaxGATTTableElements)
+
+/**
+ * Number of GATT operations per benchmark run.
+ */
+#define kNumBenchmarkOperations ((size_t) 200000)
+
+/**
+ * Connection handle of the central that is connected in every test configuration.
+ */
+#define kConnectionHandle ((HAPPlatformBLEPeripheralManagerConnectionHandle) 1)
+
+#define kIID_TestService              ((uint64_t) 0x0030)
+#define kIID_LargeValueCharacteristic ((uint64_t) 0x0031)
+#define kIID_LockCurrentState         ((uint64_t) 0x0032)
+#define kIID_TestCharacteristic       ((uint64_t) 0x0100)
+
+static const HAPUUID kTestServiceType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                            0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x31 } };
+static const HAPUUID kTestCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                   0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x32 } };
+static const HAPUUID kLargeValueCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                         0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x33 } };
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleTestCharacteristicRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPUInt8CharacteristicReadRequest* request HAP_UNUSED,
+        uint8_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = 0;
+    return kHAPError_None;
+}
+
+static HAPUInt8Characteristic testCharacteristics[kMaxTestCharacteristics];
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLargeValueCharacteristicRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPDataCharacteristicReadRequest* request HAP_UNUSED,
+        void* valueBytes,
+        size_t maxValueBytes,
+        size_t* numValueBytes,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(maxValueBytes >= kNumLargeValueBytes);
+    for (size_t i = 0; i < kNumLargeValueBytes; i++) {
+        ((uint8_t*) valueBytes)[i] = (uint8_t)(i * 7 + 1);
+    }
+    *numValueBytes = kNumLargeValueBytes;
+    return kHAPError_None;
+}
+
+static const HAPDataCharacteristic largeValueCharacteristic = {
+    .format = kHAPCharacteristicFormat_Data,
+    .iid = kIID_LargeValueCharacteristic,
+    .characteristicType = &kLargeValueCharacteristicType,
+    .debugDescription = "large value",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = false,
+                    .supportsEventNotification = false,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = true,
+                             .writableWithoutSecurity = false } },
+    .constraints = { .maxLength = kNumLargeValueBytes },
+    .callbacks = { .handleRead = HandleLargeValueCharacteristicRead }
+};
+
+static const HAPUInt8Characteristic lockCurrentStateCharacteristic = {
+    .format = kHAPCharacteristicFormat_UInt8,
+    .iid = kIID_LockCurrentState,
+    .characteristicType = &kHAPCharacteristicType_LockCurrentState,
+    .debugDescription = kHAPCharacteristicDebugDescription_LockCurrentState,
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = false,
+                    .supportsEventNotification = true,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .units = kHAPCharacteristicUnits_None,
+    .constraints = { .minimumValue = 0, .maximumValue = 3, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleTestCharacteristicRead }
+};
+
+static void PrepareTestCharacteristics(void) {
+    for (size_t i = 0; i < kMaxTestCharacteristics; i++) {
+        testCharacteristics[i] = (HAPUInt8Characteristic) {
+            .format = kHAPCharacteristicFormat_UInt8,
+            .iid = kIID_TestCharacteristic + i,
+            .characteristicType = &kTestCharacteristicType,
+            .debugDescription = "test",
+            .manufacturerDescription = NULL,
+            .properties = { .readable = true,
+                            .writable = false,
+                            .supportsEventNotification = true,
+                            .hidden = false,
+                            .readRequiresAdminPermissions = false,
+                            .writeRequiresAdminPermissions = false,
+                            .requiresTimedWrite = false,
+                            .supportsAuthorizationData = false,
+                            .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                            .ble = { .supportsBroadcastNotification = false,
+                                     .supportsDisconnectedNotification = false,
+                                     .readableWithoutSecurity = false,
+                                     .writableWithoutSecurity = false } },
+            .units = kHAPCharacteristicUnits_None,
+            .constraints = { .minimumValue = 0, .maximumValue = 100, .stepValue = 1 },
+            .callbacks = { .handleRead = HandleTestCharacteristicRead }
+        };
+    }
+}
+
+/**
+ * Test configuration: Accessory server with a BLE GATT database of a given size.
+ */
+typedef struct {
+    const HAPCharacteristic* _Nullable characteristics[2 + kMaxTestCharacteristics + 1];
+    HAPService service;
+    const HAPService* _Nullable services[5];
+    HAPAccessory accessory;
+
+    HAPPlatformBLEPeripheralManagerAttribute attributes[kMaxBLEAttributes];
+    HAPPlatformBLEPeripheralManager blePeripheralManager;
+    HAPPlatform platform;
+
+    HAPAttributeDatabaseElementRef
+            attributeDatabaseElements[HAPAttributeDatabaseGetNumElements(1, kMaxGATTTableElements)];
+    HAPBLEGATTTableElementRef gattTableElements[kMaxGATTTableElements];
+    uint16_t gattHandleTable[kMaxGATTTableElements * kHAPBLEGATTHandleTable_EntriesPerGATTTableElement];
+    uint8_t signatureCacheBytes[kMaxGATTTableElements * kHAPBLESignatureCache_BytesPerGATTTableElement];
+    HAPBLESessionCacheElementRef sessionCacheElements[kHAPBLESessionCache_MinElements];
+    HAPSessionRef sessions[kHAPBLESessions_MaxElements];
+    uint8_t procedureBytes[kHAPBLESessions_MaxElements * 2048];
+    HAPBLEProcedureRef procedures[kHAPBLESessions_MaxElements];
+    HAPBLEAccessoryServerStorage bleAccessoryServerStorage;
+
+    HAPAccessoryServerRef accessoryServer;
+} TestConfiguration;
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server, void* _Nullable context HAP_UNUSED) {
+    HAPPrecondition(server);
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+static void StartTestConfiguration(
+        TestConfiguration* test,
+        size_t numCharacteristics,
+        bool useGATTHandleTable,
+        size_t numSignatureCacheBytes,
+        size_t numSessions,
+        bool flattenAttributeDatabase) {
+    HAPPrecondition(test);
+    HAPPrecondition(numCharacteristics <= kMaxTestCharacteristics);
+    HAPPrecondition(numSignatureCacheBytes <= sizeof test->signatureCacheBytes);
+    HAPPrecondition(numSessions && numSessions <= kHAPBLESessions_MaxElements);
+
+    HAPRawBufferZero(test, sizeof *test);
+
+    // Prepare accessory.
+    test->characteristics[0] = &largeValueCharacteristic;
+    test->characteristics[1] = &lockCurrentStateCharacteristic;
+    for (size_t i = 0; i < numCharacteristics; i++) {
+        test->characteristics[2 + i] = &testCharacteristics[i];
+    }
+    test->service = (HAPService) { .iid = kIID_TestService,
+                                   .serviceType = &kTestServiceType,
+                                   .debugDescription = "test",
+                                   .name = NULL,
+                                   .properties = { .primaryService = true,
+                                                   .hidden = false,
+                                                   .ble = { .supportsConfiguration = false } },
+                                   .linkedServices = NULL,
+                                   .characteristics = test->characteristics };
+    test->services[0] = &accessoryInformationService;
+    test->services[1] = &hapProtocolInformationService;
+    test->services[2] = &pairingService;
+    test->services[3] = &test->service;
+    test->accessory = (HAPAccessory) { .aid = 1,
+                                       .category = kHAPAccessoryCategory_Other,
+                                       .name = "Acme Test",
+                                       .manufacturer = "Acme",
+                                       .model = "Test1,1",
+                                       .serialNumber = "099DB48E9E28",
+                                       .firmwareVersion = "1",
+                                       .hardwareVersion = "1",
+                                       .services = test->services,
+                                       .callbacks = { .identify = IdentifyAccessory } };
+
+    // Prepare dedicated BLE peripheral manager.
+    HAPPlatformBLEPeripheralManagerCreate(
+            &test->blePeripheralManager,
+            &(const HAPPlatformBLEPeripheralManagerOptions) { .attributes = test->attributes,
+                                                              .numAttributes = HAPArrayCount(test->attributes) });
+    test->platform = platform;
+    test->platform.ble.blePeripheralManager = &test->blePeripheralManager;
+
+    // Prepare accessory server storage.
+    test->bleAccessoryServerStorage = (HAPBLEAccessoryServerStorage) {
+        .gattTableElements = test->gattTableElements,
+        .numGATTTableElements = HAPArrayCount(test->gattTableElements),
+        .gattHandleTable = useGATTHandleTable ? test->gattHandleTable : NULL,
+        .numGATTHandleTableEntries = useGATTHandleTable ? HAPArrayCount(test->gattHandleTable) : 0,
+        .signatureCache = { .bytes = numSignatureCacheBytes ? test->signatureCacheBytes : NULL,
+                            .numBytes = numSignatureCacheBytes },
+        .sessionCacheElements = test->sessionCacheElements,
+        .numSessionCacheElements = HAPArrayCount(test->sessionCacheElements),
+        .session = test->sessions,
+        .numSessions = numSessions,
+        .procedures = test->procedures,
+        .numProcedures = numSessions,
+        .procedureBuffer = { .bytes = test->procedureBytes, .numBytes = numSessions * 2048 }
+    };
+
+    // Initialize and start accessory server.
+    HAPAccessoryServerCreate(
+            &test->accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .attributeDatabase = { .elements = flattenAttributeDatabase ? test->attributeDatabaseElements :
+                                                                                  NULL,
+                                           .numElements = flattenAttributeDatabase ?
+                                                                  HAPArrayCount(test->attributeDatabaseElements) :
+                                                                  0 },
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &test->bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &test->platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+    HAPAccessoryServerStart(&test->accessoryServer, &test->accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&test->accessoryServer) == kHAPAccessoryServerState_Running);
+    HAPAssert(HAPAttributeDatabaseIsFlattened(&test->accessoryServer) == flattenAttributeDatabase);
+
+    // Connect central.
+    HAPPlatformBLEPeripheralManagerConnectCentral(&test->blePeripheralManager, kConnectionHandle);
+}
+
+static void StopTestConfiguration(TestConfiguration* test) {
+    HAPPrecondition(test);
+
+    for (size_t i = 0; i < HAPArrayCount(test->blePeripheralManager.centrals); i++) {
+        const HAPPlatformBLEPeripheralManagerCentral* central = &test->blePeripheralManager.centrals[i];
+        if (central->isConnected) {
+            HAPPlatformBLEPeripheralManagerDisconnectCentral(&test->blePeripheralManager, central->connectionHandle);
+        }
+    }
+    HAPAccessoryServerStop(&test->accessoryServer);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&test->accessoryServer) == kHAPAccessoryServerState_Idle);
+    HAPAccessoryServerRelease(&test->accessoryServer);
+}
+
+/**
+ * Collects the attribute handles of all Instance ID descriptors and Client Characteristic Configuration descriptors.
+ */
+static size_t GetDescriptorHandles(
+        const TestConfiguration* test,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* handles,
+        uint16_t* iids,
+        size_t maxHandles) {
+    HAPPrecondition(test);
+    HAPPrecondition(handles);
+    HAPPrecondition(iids);
+
+    size_t numHandles = 0;
+    const HAPService* _Nullable service = NULL;
+    const HAPCharacteristic* _Nullable characteristic = NULL;
+    size_t serviceIndex = 0;
+    size_t characteristicIndex = 0;
+    for (size_t i = 0; i < HAPArrayCount(test->attributes); i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &test->attributes[i];
+        switch (attribute->type) {
+            case kHAPPlatformBLEPeripheralManagerAttributeType_None: {
+                return numHandles;
+            }
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Service: {
+                service = test->accessory.services[serviceIndex++];
+                characteristic = NULL;
+                characteristicIndex = 0;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic: {
+                HAPAssert(service);
+                HAPAssert(numHandles + 2 <= maxHandles);
+                if (!characteristic && attribute->_.characteristic.properties.read &&
+                    !attribute->_.characteristic.properties.write) {
+                    // Service Instance ID characteristic.
+                    handles[numHandles] = attribute->_.characteristic.valueHandle;
+                    iids[numHandles] = (uint16_t) service->iid;
+                    numHandles++;
+                    break;
+                }
+                characteristic = service->characteristics[characteristicIndex++];
+                if (attribute->_.characteristic.cccDescriptorHandle) {
+                    handles[numHandles] = attribute->_.characteristic.cccDescriptorHandle;
+                    iids[numHandles] = 0;
+                    numHandles++;
+                }
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor: {
+                HAPAssert(characteristic);
+                HAPAssert(numHandles < maxHandles);
+                handles[numHandles] = attribute->_.descriptor.handle;
+                iids[numHandles] = (uint16_t)((const HAPBaseCharacteristic*) characteristic)->iid;
+                numHandles++;
+            } break;
+        }
+    }
+    return numHandles;
+}
+
+/**
+ * Reads all descriptors and checks their values.
+ */
+static void TestDescriptorReads(TestConfiguration* test) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxBLEAttributes];
+    static uint16_t iids[kMaxBLEAttributes];
+    size_t numHandles = GetDescriptorHandles(test, handles, iids, HAPArrayCount(handles));
+    HAPAssert(numHandles);
+    for (size_t i = 0; i < numHandles; i++) {
+        uint8_t bytes[2];
+        size_t numBytes;
+        err = HAPPlatformBLEPeripheralManagerReadAttribute(
+                &test->blePeripheralManager, kConnectionHandle, handles[i], bytes, sizeof bytes, &numBytes);
+        HAPAssert(!err);
+        HAPAssert(numBytes == sizeof bytes);
+        HAPAssert(HAPReadLittleUInt16(bytes) == iids[i]);
+    }
+}
+
+/**
+ * Enables and disables events through a Client Characteristic Configuration descriptor.
+ */
+static void TestCCCDescriptorWrite(TestConfiguration* test) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxBLEAttributes];
+    static uint16_t iids[kMaxBLEAttributes];
+    size_t numHandles = GetDescriptorHandles(test, handles, iids, HAPArrayCount(handles));
+    size_t i = numHandles;
+    while (i && iids[i - 1]) {
+        i--;
+    }
+    HAPAssert(i);
+    HAPPlatformBLEPeripheralManagerAttributeHandle cccDescriptorHandle = handles[i - 1];
+
+    for (uint16_t value = 0x0002;; value = 0x0000) {
+        uint8_t bytes[2];
+        size_t numBytes;
+        HAPWriteLittleUInt16(bytes, value);
+        err = HAPPlatformBLEPeripheralManagerWriteAttribute(
+                &test->blePeripheralManager, kConnectionHandle, cccDescriptorHandle, bytes, sizeof bytes);
+        HAPAssert(!err);
+        err = HAPPlatformBLEPeripheralManagerReadAttribute(
+                &test->blePeripheralManager, kConnectionHandle, cccDescriptorHandle, bytes, sizeof bytes, &numBytes);
+        HAPAssert(!err);
+        HAPAssert(numBytes == sizeof bytes);
+        HAPAssert(HAPReadLittleUInt16(bytes) == value);
+        if (!value) {
+            break;
+        }
+    }
+}
+
+/**
+ * Measures GATT reads spread across the whole GATT database.
+ */
+static void BenchmarkGATTReads(TestConfiguration* test, size_t numCharacteristics, bool useGATTHandleTable) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxBLEAttributes];
+    static uint16_t iids[kMaxBLEAttributes];
+    size_t numHandles = GetDescriptorHandles(test, handles, iids, HAPArrayCount(handles));
+    HAPAssert(numHandles);
+
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations; i++) {
+        uint8_t bytes[2];
+        size_t numBytes;
+        err = HAPPlatformBLEPeripheralManagerReadAttribute(
+                &test->blePeripheralManager,
+                kConnectionHandle,
+                handles[i % numHandles],
+                bytes,
+                sizeof bytes,
+                &numBytes);
+        HAPAssert(!err);
+    }
+    char name[64];
+    err = HAPStringWithFormat(
+            name,
+            sizeof name,
+            "GATT read (%zu attributes, %s)",
+            kAttributeCount + 3 + numCharacteristics,
+            useGATTHandleTable ? "handle table" : "search");
+    HAPAssert(!err);
+    HAPBenchmarkLogRate(name, kNumBenchmarkOperations, HAPBenchmarkGetElapsedNanoseconds(&timer));
+}
+
+/**
+ * Collects the value handles of all HAP characteristics.
+ */
+static size_t GetCharacteristicValueHandles(
+        const TestConfiguration* test,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* handles,
+        const HAPCharacteristic** characteristics,
+        const HAPService** services,
+        size_t maxHandles) {
+    HAPPrecondition(test);
+    HAPPrecondition(handles);
+    HAPPrecondition(characteristics);
+    HAPPrecondition(services);
+
+    size_t numHandles = 0;
+    const HAPService* _Nullable service = NULL;
+    size_t serviceIndex = 0;
+    size_t characteristicIndex = 0;
+    bool isServiceInstanceID = false;
+    for (size_t i = 0; i < HAPArrayCount(test->attributes); i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &test->attributes[i];
+        switch (attribute->type) {
+            case kHAPPlatformBLEPeripheralManagerAttributeType_None: {
+                return numHandles;
+            }
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Service: {
+                service = test->accessory.services[serviceIndex++];
+                characteristicIndex = 0;
+                isServiceInstanceID = true;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic: {
+                HAPAssert(service);
+                if (isServiceInstanceID) {
+                    isServiceInstanceID = false;
+                    break;
+                }
+                HAPAssert(numHandles < maxHandles);
+                handles[numHandles] = attribute->_.characteristic.valueHandle;
+                characteristics[numHandles] = HAPNonnull(service)->characteristics[characteristicIndex++];
+                services[numHandles] = HAPNonnull(service);
+                numHandles++;
+            } break;
+            case kHAPPlatformBLEPeripheralManagerAttributeType_Descriptor: {
+            } break;
+        }
+    }
+    return numHandles;
+}
+
+/**
+ * Performs a HAP-BLE signature read procedure and returns the response body.
+ */
+static size_t ReadSignature(
+        TestConfiguration* test,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle,
+        HAPPDUOpcode opcode,
+        uint16_t iid,
+        uint8_t* body,
+        size_t maxBodyBytes) {
+    HAPPrecondition(test);
+    HAPPrecondition(body);
+
+    HAPError err;
+
+    static uint8_t tid;
+    tid++;
+
+    uint8_t bytes[512];
+    bytes[0] = 0x00;
+    bytes[1] = opcode;
+    bytes[2] = tid;
+    HAPWriteLittleUInt16(&bytes[3], iid);
+    err = HAPPlatformBLEPeripheralManagerWriteAttribute(
+            &test->blePeripheralManager, kConnectionHandle, valueHandle, bytes, 5);
+    HAPAssert(!err);
+
+    size_t numBytes;
+    err = HAPPlatformBLEPeripheralManagerReadAttribute(
+            &test->blePeripheralManager, kConnectionHandle, valueHandle, bytes, sizeof bytes, &numBytes);
+    HAPAssert(!err);
+    HAPAssert(numBytes >= 5);
+    HAPAssert(bytes[0] == 0x02);
+    HAPAssert(bytes[1] == tid);
+    HAPAssert(bytes[2] == kHAPBLEPDUStatus_Success);
+    size_t numBodyBytes = HAPReadLittleUInt16(&bytes[3]);
+    HAPAssert(numBytes == 5 + numBodyBytes);
+    HAPAssert(numBodyBytes <= maxBodyBytes);
+    HAPRawBufferCopyBytes(body, &bytes[5], numBodyBytes);
+    return numBodyBytes;
+}
+
+/**
+ * Reads all characteristic and service signatures and compares them with freshly serialized ones.
+ */
+static void TestSignatureReads(TestConfiguration* test) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxGATTTableElements];
+    static const HAPCharacteristic* characteristics[kMaxGATTTableElements];
+    static const HAPService* services[kMaxGATTTableElements];
+    size_t numHandles = GetCharacteristicValueHandles(
+            test, handles, characteristics, services, HAPArrayCount(handles));
+    HAPAssert(numHandles);
+    size_t numServiceSignatures = 0;
+    for (size_t i = 0; i < numHandles; i++) {
+        uint8_t expectedBytes[256];
+        HAPTLVWriterRef writer;
+        void* expectedBody;
+        size_t numExpectedBodyBytes;
+        uint8_t body[256];
+        size_t numBodyBytes;
+
+        HAPTLVWriterCreate(&writer, expectedBytes, sizeof expectedBytes);
+        err = HAPBLECharacteristicGetSignatureReadResponse(characteristics[i], services[i], &writer);
+        HAPAssert(!err);
+        HAPTLVWriterGetBuffer(&writer, &expectedBody, &numExpectedBodyBytes);
+        numBodyBytes = ReadSignature(
+                test,
+                handles[i],
+                kHAPPDUOpcode_CharacteristicSignatureRead,
+                (uint16_t)((const HAPBaseCharacteristic*) characteristics[i])->iid,
+                body,
+                sizeof body);
+        HAPAssert(numBodyBytes == numExpectedBodyBytes);
+        HAPAssert(HAPRawBufferAreEqual(body, expectedBody, numBodyBytes));
+
+        if (HAPBLECharacteristicSupportsServiceProcedures(characteristics[i])) {
+            HAPTLVWriterCreate(&writer, expectedBytes, sizeof expectedBytes);
+            err = HAPBLEServiceGetSignatureReadResponse(services[i], &writer);
+            HAPAssert(!err);
+            HAPTLVWriterGetBuffer(&writer, &expectedBody, &numExpectedBodyBytes);
+            numBodyBytes = ReadSignature(
+                    test,
+                    handles[i],
+                    kHAPPDUOpcode_ServiceSignatureRead,
+                    (uint16_t) services[i]->iid,
+                    body,
+                    sizeof body);
+            HAPAssert(numBodyBytes == numExpectedBodyBytes);
+            HAPAssert(HAPRawBufferAreEqual(body, expectedBody, numBodyBytes));
+            numServiceSignatures++;
+        }
+    }
+    HAPAssert(numServiceSignatures);
+}
+
+/**
+ * Measures HAP-Characteristic-Signature-Read procedures spread across the whole GATT database.
+ */
+static void BenchmarkSignatureReads(TestConfiguration* test, size_t numSignatureCacheBytes) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxGATTTableElements];
+    static const HAPCharacteristic* characteristics[kMaxGATTTableElements];
+    static const HAPService* services[kMaxGATTTableElements];
+    size_t numHandles = GetCharacteristicValueHandles(
+            test, handles, characteristics, services, HAPArrayCount(handles));
+    HAPAssert(numHandles);
+
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations / 4; i++) {
+        uint8_t body[256];
+        size_t j = i % numHandles;
+        ReadSignature(
+                test,
+                handles[j],
+                kHAPPDUOpcode_CharacteristicSignatureRead,
+                (uint16_t)((const HAPBaseCharacteristic*) characteristics[j])->iid,
+                body,
+                sizeof body);
+    }
+    char name[64];
+    err = HAPStringWithFormat(
+            name,
+            sizeof name,
+            "Signature read (%zu characteristics, %s)",
+            numHandles,
+            numSignatureCacheBytes ? "cache" : "no cache");
+    HAPAssert(!err);
+    HAPBenchmarkLogRate(name, kNumBenchmarkOperations / 4, HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    // Response serialization only.
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations; i++) {
+        uint8_t body[256];
+        HAPTLVWriterRef writer;
+        HAPTLVWriterCreate(&writer, body, sizeof body);
+        size_t j = i % numHandles;
+        err = HAPBLESignatureCacheGetCharacteristicSignatureReadResponse(
+                &test->accessoryServer, characteristics[j], services[j], &writer);
+        HAPAssert(!err);
+    }
+    err = HAPStringWithFormat(
+            name,
+            sizeof name,
+            "Signature serialization (%zu characteristics, %s)",
+            numHandles,
+            numSignatureCacheBytes ? "cache" : "no cache");
+    HAPAssert(!err);
+    HAPBenchmarkLogRate(name, kNumBenchmarkOperations, HAPBenchmarkGetElapsedNanoseconds(&timer));
+}
+
+/**
+ * Reads the large value characteristic and returns the number of HAP-BLE response fragments.
+ */
+static size_t ReadLargeValue(TestConfiguration* test, HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    static uint8_t tid;
+    tid++;
+
+    uint8_t bytes[kHAPPlatformBLEPeripheralManager_MaxAttributeBytes];
+    bytes[0] = 0x00;
+    bytes[1] = kHAPPDUOpcode_CharacteristicRead;
+    bytes[2] = tid;
+    HAPWriteLittleUInt16(&bytes[3], kIID_LargeValueCharacteristic);
+    err = HAPPlatformBLEPeripheralManagerWriteAttribute(
+            &test->blePeripheralManager, kConnectionHandle, valueHandle, bytes, 5);
+    HAPAssert(!err);
+
+    // Collect response body.
+    uint8_t body[2 * kNumLargeValueBytes];
+    size_t numBodyBytes = 0;
+    size_t totalBodyBytes = 0;
+    size_t numFragments = 0;
+    do {
+        size_t numBytes;
+        err = HAPPlatformBLEPeripheralManagerReadAttribute(
+                &test->blePeripheralManager, kConnectionHandle, valueHandle, bytes, sizeof bytes, &numBytes);
+        HAPAssert(!err);
+        size_t numHeaderBytes;
+        if (!numFragments) {
+            HAPAssert(numBytes >= 5);
+            HAPAssert(bytes[0] == 0x02);
+            HAPAssert(bytes[1] == tid);
+            HAPAssert(bytes[2] == kHAPBLEPDUStatus_Success);
+            totalBodyBytes = HAPReadLittleUInt16(&bytes[3]);
+            HAPAssert(totalBodyBytes <= sizeof body);
+            numHeaderBytes = 5;
+        } else {
+            HAPAssert(numBytes >= 2);
+            HAPAssert(bytes[0] == 0x82);
+            HAPAssert(bytes[1] == tid);
+            numHeaderBytes = 2;
+        }
+        HAPAssert(numBytes - numHeaderBytes <= totalBodyBytes - numBodyBytes);
+        HAPRawBufferCopyBytes(&body[numBodyBytes], &bytes[numHeaderBytes], numBytes - numHeaderBytes);
+        numBodyBytes += numBytes - numHeaderBytes;
+        numFragments++;
+    } while (numBodyBytes < totalBodyBytes);
+
+    // Check value. It is split into HAP-Param-Value TLV fragments.
+    size_t numValueBytes = 0;
+    for (size_t i = 0; i < numBodyBytes;) {
+        HAPAssert(numBodyBytes - i >= 2);
+        HAPAssert(body[i] == kHAPBLEPDUTLVType_Value);
+        size_t numFragmentBytes = body[i + 1];
+        HAPAssert(numBodyBytes - i - 2 >= numFragmentBytes);
+        for (size_t j = 0; j < numFragmentBytes; j++) {
+            HAPAssert(body[i + 2 + j] == (uint8_t)((numValueBytes + j) * 7 + 1));
+        }
+        numValueBytes += numFragmentBytes;
+        i += 2 + numFragmentBytes;
+    }
+    HAPAssert(numValueBytes == kNumLargeValueBytes);
+    return numFragments;
+}
+
+/**
+ * Reads a value that spans multiple GATT reads with different ATT_MTUs and compares the number of round trips
+ * with response fragments that are sized without knowledge of the ATT_MTU.
+ */
+static void TestLargeValueReads(TestConfiguration* test) {
+    HAPPrecondition(test);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) &test->accessoryServer;
+
+    static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxGATTTableElements];
+    static const HAPCharacteristic* characteristics[kMaxGATTTableElements];
+    static const HAPService* services[kMaxGATTTableElements];
+    size_t numHandles = GetCharacteristicValueHandles(
+            test, handles, characteristics, services, HAPArrayCount(handles));
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle = 0;
+    for (size_t i = 0; i < numHandles; i++) {
+        if (characteristics[i] == &largeValueCharacteristic) {
+            valueHandle = handles[i];
+        }
+    }
+    HAPAssert(valueHandle);
+
+    static const uint16_t mtus[] = { kHAPPlatformBLEPeripheralManager_MinMTU, 104, 185, 247, 517 };
+    for (size_t i = 0; i < HAPArrayCount(mtus); i++) {
+        HAPPlatformBLEPeripheralManagerSetMTU(&test->blePeripheralManager, kConnectionHandle, mtus[i]);
+        HAPAssert(server->ble.connections[0].mtu == mtus[i]);
+
+        size_t numRoundTrips = HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager);
+        size_t numFragments = ReadLargeValue(test, valueHandle);
+        numRoundTrips = HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager) - numRoundTrips;
+
+        // Without knowledge of the ATT_MTU.
+        server->ble.connections[0].mtu = 0;
+        size_t numDefaultRoundTrips = HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager);
+        size_t numDefaultFragments = ReadLargeValue(test, valueHandle);
+        numDefaultRoundTrips =
+                HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager) - numDefaultRoundTrips;
+
+        HAPLog(&kHAPLog_Default,
+               "ATT_MTU %u: %zu fragments, %zu round trips (without ATT_MTU: %zu fragments, %zu round trips).",
+               mtus[i],
+               numFragments,
+               numRoundTrips,
+               numDefaultFragments,
+               numDefaultRoundTrips);
+        HAPAssert(numRoundTrips <= numDefaultRoundTrips);
+    }
+}
+
+/**
+ * Secures the session of a connected central with an admin pairing, without running Pair Verify.
+ */
+static void SecureSession(TestConfiguration* test, HAPSessionRef* session_) {
+    HAPPrecondition(test);
+    HAPPrecondition(session_);
+    HAPSession* session = (HAPSession*) session_;
+
+    HAPError err;
+
+    uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+    pairingBytes[0] = 'A';
+    pairingBytes[36] = 1;
+    pairingBytes[69] = 0x01;
+    err = HAPPlatformKeyValueStoreSet(
+            test->platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Pairings,
+            /* key: */ 0,
+            pairingBytes,
+            sizeof pairingBytes);
+    HAPAssert(!err);
+
+    session->hap.active = true;
+    session->hap.pairingID = 0;
+    HAPAssert(HAPSessionIsSecured(session_));
+}
+
+/**
+ * Confirms Handle Value Indications until no more events are pending.
+ *
+ * @return Number of confirmed indications.
+ */
+static size_t ConfirmIndications(
+        TestConfiguration* test,
+        HAPPlatformBLEPeripheralManagerAttributeHandle* valueHandles,
+        size_t maxValueHandles) {
+    HAPPrecondition(test);
+    HAPPrecondition(valueHandles);
+
+    size_t numValueHandles = 0;
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle;
+    while (HAPPlatformBLEPeripheralManagerConfirmIndication(
+            &test->blePeripheralManager, kConnectionHandle, &valueHandle)) {
+        HAPAssert(numValueHandles < maxValueHandles);
+        valueHandles[numValueHandles++] = valueHandle;
+    }
+    return numValueHandles;
+}
+
+/**
+ * Raises storms of events on all test characteristics with an urgent event at varying positions, and measures
+ * how many indications are sent between raising an event and sending its indication.
+ */
+static void TestEventStorms(TestConfiguration* test, size_t numCharacteristics) {
+    HAPPrecondition(test);
+    HAPPrecondition(numCharacteristics);
+
+    HAPError err;
+
+    static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxGATTTableElements];
+    static const HAPCharacteristic* characteristics[kMaxGATTTableElements];
+    static const HAPService* services[kMaxGATTTableElements];
+    size_t numHandles = GetCharacteristicValueHandles(
+            test, handles, characteristics, services, HAPArrayCount(handles));
+    HAPPlatformBLEPeripheralManagerAttributeHandle lockValueHandle = 0;
+    static HAPPlatformBLEPeripheralManagerAttributeHandle testValueHandles[kMaxTestCharacteristics];
+    for (size_t i = 0; i < numHandles; i++) {
+        if (characteristics[i] == &lockCurrentStateCharacteristic) {
+            lockValueHandle = handles[i];
+        }
+        for (size_t j = 0; j < numCharacteristics; j++) {
+            if (characteristics[i] == &testCharacteristics[j]) {
+                testValueHandles[j] = handles[i];
+            }
+        }
+    }
+    HAPAssert(lockValueHandle);
+
+    // Subscribe to all characteristics that support events.
+    for (size_t i = 0; i < HAPArrayCount(test->attributes); i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &test->attributes[i];
+        if (attribute->type == kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic &&
+            attribute->_.characteristic.cccDescriptorHandle) {
+            uint8_t bytes[2];
+            HAPWriteLittleUInt16(bytes, 0x0002);
+            err = HAPPlatformBLEPeripheralManagerWriteAttribute(
+                    &test->blePeripheralManager,
+                    kConnectionHandle,
+                    attribute->_.characteristic.cccDescriptorHandle, bytes, sizeof bytes);
+            HAPAssert(!err);
+        }
+    }
+    SecureSession(test, &test->sessions[0]);
+
+    size_t maxUrgentLatency = 0;
+    size_t maxLatency = 0;
+    for (size_t urgentPosition = 0; urgentPosition <= numCharacteristics; urgentPosition++) {
+        size_t numRoundTrips = HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager);
+        size_t numSentBeforeUrgentEvent = 0;
+        static size_t numSentBeforeEvent[kMaxTestCharacteristics];
+
+        // Each characteristic changes multiple times. Repeated events are coalesced.
+        // The first event is sent immediately, so a further change of its characteristic would raise a new event.
+        for (size_t round = 0; round < 3; round++) {
+            for (size_t i = round ? 1 : 0; i < numCharacteristics; i++) {
+                if (!round && i == urgentPosition) {
+                    numSentBeforeUrgentEvent =
+                            HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager) -
+                            numRoundTrips;
+                    HAPAccessoryServerRaiseEvent(
+                            &test->accessoryServer, &lockCurrentStateCharacteristic, &test->service, &test->accessory);
+                }
+                if (!round) {
+                    numSentBeforeEvent[i] =
+                            HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager) -
+                            numRoundTrips;
+                }
+                HAPAccessoryServerRaiseEvent(
+                        &test->accessoryServer, &testCharacteristics[i], &test->service, &test->accessory);
+            }
+        }
+        if (urgentPosition == numCharacteristics) {
+            numSentBeforeUrgentEvent =
+                    HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager) - numRoundTrips;
+            HAPAccessoryServerRaiseEvent(
+                    &test->accessoryServer, &lockCurrentStateCharacteristic, &test->service, &test->accessory);
+        }
+
+        static HAPPlatformBLEPeripheralManagerAttributeHandle valueHandles[kMaxTestCharacteristics + 1];
+        size_t numValueHandles = ConfirmIndications(test, valueHandles, HAPArrayCount(valueHandles));
+        HAPAssert(numValueHandles == numCharacteristics + 1);
+        HAPAssert(
+                HAPPlatformBLEPeripheralManagerGetNumRoundTrips(&test->blePeripheralManager) - numRoundTrips ==
+                numValueHandles);
+
+        // Urgent event is sent as soon as the outstanding indication is confirmed. Other events are sent in order.
+        size_t i = 0;
+        for (size_t j = 0; j < numValueHandles; j++) {
+            if (valueHandles[j] == lockValueHandle) {
+                HAPAssert(j >= numSentBeforeUrgentEvent);
+                size_t latency = j - numSentBeforeUrgentEvent;
+                HAPAssert(latency <= 1);
+                maxUrgentLatency = HAPMax(maxUrgentLatency, latency);
+            } else {
+                HAPAssert(i < numCharacteristics);
+                HAPAssert(valueHandles[j] == testValueHandles[i]);
+                HAPAssert(j >= numSentBeforeEvent[i]);
+                maxLatency = HAPMax(maxLatency, j - numSentBeforeEvent[i]);
+                i++;
+            }
+        }
+        HAPAssert(i == numCharacteristics);
+    }
+    HAPLog(&kHAPLog_Default,
+           "Event storms (%zu characteristics): Worst-case latency %zu indications (urgent events: %zu indications).",
+           numCharacteristics,
+           maxLatency,
+           maxUrgentLatency);
+
+    err = HAPPlatformKeyValueStoreRemove(
+            test->platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, /* key: */ 0);
+    HAPAssert(!err);
+}
+
+/**
+ * Finds the value handle of a characteristic.
+ */
+static HAPPlatformBLEPeripheralManagerAttributeHandle
+        GetValueHandle(const TestConfiguration* test, const HAPCharacteristic* characteristic) {
+    HAPPrecondition(test);
+    HAPPrecondition(characteristic);
+
+    static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxGATTTableElements];
+    static const HAPCharacteristic* characteristics[kMaxGATTTableElements];
+    static const HAPService* services[kMaxGATTTableElements];
+    size_t numHandles = GetCharacteristicValueHandles(
+            test, handles, characteristics, services, HAPArrayCount(handles));
+    for (size_t i = 0; i < numHandles; i++) {
+        if (characteristics[i] == characteristic) {
+            return handles[i];
+        }
+    }
+    HAPFatalError();
+}
+
+/**
+ * Finds the Client Characteristic Configuration descriptor handle of a characteristic value handle.
+ */
+static HAPPlatformBLEPeripheralManagerAttributeHandle GetCCCDescriptorHandle(
+        const TestConfiguration* test,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle) {
+    HAPPrecondition(test);
+
+    for (size_t i = 0; i < HAPArrayCount(test->attributes); i++) {
+        const HAPPlatformBLEPeripheralManagerAttribute* attribute = &test->attributes[i];
+        if (attribute->type == kHAPPlatformBLEPeripheralManagerAttributeType_Characteristic &&
+            attribute->_.characteristic.valueHandle == valueHandle) {
+            HAPAssert(attribute->_.characteristic.cccDescriptorHandle);
+            return attribute->_.characteristic.cccDescriptorHandle;
+        }
+    }
+    HAPFatalError();
+}
+
+/**
+ * Writes a Client Characteristic Configuration descriptor value from a central.
+ */
+static void WriteCCCDescriptor(
+        TestConfiguration* test,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle cccDescriptorHandle,
+        uint16_t value) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    uint8_t bytes[2];
+    HAPWriteLittleUInt16(bytes, value);
+    err = HAPPlatformBLEPeripheralManagerWriteAttribute(
+            &test->blePeripheralManager, connectionHandle, cccDescriptorHandle, bytes, sizeof bytes);
+    HAPAssert(!err);
+}
+
+/**
+ * Reads a Client Characteristic Configuration descriptor value from a central.
+ */
+static uint16_t ReadCCCDescriptor(
+        TestConfiguration* test,
+        HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle,
+        HAPPlatformBLEPeripheralManagerAttributeHandle cccDescriptorHandle) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    uint8_t bytes[2];
+    size_t numBytes;
+    err = HAPPlatformBLEPeripheralManagerReadAttribute(
+            &test->blePeripheralManager, connectionHandle, cccDescriptorHandle, bytes, sizeof bytes, &numBytes);
+    HAPAssert(!err);
+    HAPAssert(numBytes == sizeof bytes);
+    return HAPReadLittleUInt16(bytes);
+}
+
+/**
+ * Checks whether any event is pending.
+ */
+HAP_RESULT_USE_CHECK
+static bool AreEventsPending(TestConfiguration* test) {
+    HAPPrecondition(test);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) &test->accessoryServer;
+
+    for (size_t i = 0; i < HAPArrayCount(server->ble.pendingEvents.queues); i++) {
+        if (server->ble.pendingEvents.queues[i].first) {
+            HAPAssert(server->ble.pendingEvents.queues[i].last);
+            return true;
+        }
+        HAPAssert(!server->ble.pendingEvents.queues[i].last);
+    }
+    return false;
+}
+
+/**
+ * Checks that events that cannot be delivered to a connection are dropped instead of staying pending.
+ */
+static void TestUndeliverableEvents(TestConfiguration* test) {
+    HAPPrecondition(test);
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = &test->blePeripheralManager;
+
+    HAPError err;
+
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle = GetValueHandle(test, &testCharacteristics[0]);
+    HAPPlatformBLEPeripheralManagerAttributeHandle cccDescriptorHandle = GetCCCDescriptorHandle(test, valueHandle);
+    HAPPlatformBLEPeripheralManagerAttributeHandle indicatedValueHandle;
+    SecureSession(test, &test->sessions[0]);
+
+    // Events for characteristics that the controller has not subscribed to are dropped.
+    HAPAccessoryServerRaiseEvent(&test->accessoryServer, &testCharacteristics[0], &test->service, &test->accessory);
+    HAPAssert(!AreEventsPending(test));
+    HAPAssert(!HAPPlatformBLEPeripheralManagerConfirmIndication(
+            blePeripheralManager, kConnectionHandle, &indicatedValueHandle));
+
+    // Dropped events are not sent once the controller subscribes. Later events are sent.
+    WriteCCCDescriptor(test, kConnectionHandle, cccDescriptorHandle, 0x0002);
+    HAPAssert(!HAPPlatformBLEPeripheralManagerConfirmIndication(
+            blePeripheralManager, kConnectionHandle, &indicatedValueHandle));
+    HAPAccessoryServerRaiseEvent(&test->accessoryServer, &testCharacteristics[0], &test->service, &test->accessory);
+    HAPAssert(HAPPlatformBLEPeripheralManagerConfirmIndication(
+            blePeripheralManager, kConnectionHandle, &indicatedValueHandle));
+    HAPAssert(indicatedValueHandle == valueHandle);
+    HAPAssert(!AreEventsPending(test));
+
+    // Events for characteristics that require admin permissions are dropped for controllers without them.
+    uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    size_t numPairingBytes;
+    bool found;
+    err = HAPPlatformKeyValueStoreGet(
+            test->platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Pairings,
+            /* key: */ 0,
+            pairingBytes,
+            sizeof pairingBytes,
+            &numPairingBytes,
+            &found);
+    HAPAssert(!err);
+    HAPAssert(found);
+    HAPAssert(numPairingBytes == sizeof pairingBytes);
+    pairingBytes[69] = 0x00;
+    err = HAPPlatformKeyValueStoreSet(
+            test->platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Pairings,
+            /* key: */ 0,
+            pairingBytes,
+            sizeof pairingBytes);
+    HAPAssert(!err);
+    testCharacteristics[0].properties.readRequiresAdminPermissions = true;
+    HAPAccessoryServerRaiseEvent(&test->accessoryServer, &testCharacteristics[0], &test->service, &test->accessory);
+    testCharacteristics[0].properties.readRequiresAdminPermissions = false;
+    HAPAssert(!AreEventsPending(test));
+    HAPAssert(!HAPPlatformBLEPeripheralManagerConfirmIndication(
+            blePeripheralManager, kConnectionHandle, &indicatedValueHandle));
+
+    err = HAPPlatformKeyValueStoreRemove(
+            test->platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, /* key: */ 0);
+    HAPAssert(!err);
+}
+
+/**
+ * Gets the 8-bit configuration number from the current advertisement.
+ *
+ * @param      test                 Test configuration.
+ *
+ * @return Configuration number in the advertisement.
+ */
+HAP_RESULT_USE_CHECK
+static uint8_t GetAdvertisedCN(TestConfiguration* test) {
+    HAPPrecondition(test);
+
+    HAPError err;
+
+    uint8_t advertisingBytes[31];
+    uint8_t scanResponseBytes[31];
+    size_t numAdvertisingBytes;
+    size_t numScanResponseBytes;
+    err = HAPPlatformBLEPeripheralManagerGetAdvertisingData(
+            &test->blePeripheralManager,
+            advertisingBytes,
+            sizeof advertisingBytes,
+            &numAdvertisingBytes,
+            scanResponseBytes,
+            sizeof scanResponseBytes,
+            &numScanResponseBytes);
+    HAPAssert(!err);
+
+    // Flags (3 bytes), followed by the manufacturer data with the CN at offset 0x11.
+    HAPAssert(numAdvertisingBytes > 3 + 0x11);
+    HAPAssert(advertisingBytes[3 + 0x01] == 0xFF);
+    return advertisingBytes[3 + 0x11];
+}
+
+/**
+ * Checks that the advertisement follows configuration number changes without reading the key-value store.
+ */
+static void TestConfigurationNumberAdvertising(TestConfiguration* test) {
+    HAPPrecondition(test);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) &test->accessoryServer;
+    HAPPrecondition(server->ble.numSessions > 1);
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = &test->blePeripheralManager;
+
+    HAPError err;
+
+    HAPAssert(HAPPlatformBLEPeripheralManagerIsAdvertising(blePeripheralManager));
+    uint8_t cn = GetAdvertisedCN(test);
+    HAPAssert(cn == (server->configurationNumber - 1) % UINT8_MAX + 1);
+
+    // Incrementing the CN updates the advertisement while the accessory server is running.
+    err = HAPAccessoryServerIncrementCN(&test->accessoryServer);
+    HAPAssert(!err);
+    HAPAssert(GetAdvertisedCN(test) == cn % UINT8_MAX + 1);
+
+    // Advertising updates use the in-memory CN. A CN that is written to the key-value store behind the back
+    // of the accessory server is only picked up when the accessory server starts.
+    uint8_t cnBytes[sizeof(uint32_t)];
+    HAPWriteLittleUInt32(cnBytes, 100);
+    err = HAPPlatformKeyValueStoreSet(
+            test->platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Configuration,
+            kHAPKeyValueStoreKey_Configuration_ConfigurationNumber,
+            cnBytes,
+            sizeof cnBytes);
+    HAPAssert(!err);
+    HAPAccessoryServerUpdateAdvertisingData(&test->accessoryServer);
+    HAPAssert(GetAdvertisedCN(test) == cn % UINT8_MAX + 1);
+}
+
+/**
+ * Connects multiple centrals and checks that sessions, HAP-BLE procedures and event subscriptions are kept
+ * per connection.
+ */
+static void TestMultipleCentrals(TestConfiguration* test) {
+    HAPPrecondition(test);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) &test->accessoryServer;
+    HAPPrecondition(server->ble.numSessions == 4);
+    HAPPlatformBLEPeripheralManagerRef blePeripheralManager = &test->blePeripheralManager;
+
+    HAPError err;
+
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle = GetValueHandle(test, &testCharacteristics[0]);
+    HAPPlatformBLEPeripheralManagerAttributeHandle cccDescriptorHandle = GetCCCDescriptorHandle(test, valueHandle);
+    HAPPlatformBLEPeripheralManagerAttributeHandle indicatedValueHandle;
+
+    // Connect further centrals through the advertisement. The first central is connected by the test configuration.
+    // Advertising stops once all sessions are in use.
+    for (HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 2; connectionHandle <= 4;
+         connectionHandle++) {
+        HAPAssert(HAPPlatformBLEPeripheralManagerIsAdvertising(blePeripheralManager));
+        HAPPlatformBLEPeripheralManagerConnectCentral(blePeripheralManager, connectionHandle);
+    }
+    HAPAssert(!HAPPlatformBLEPeripheralManagerIsAdvertising(blePeripheralManager));
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        HAPAssert(server->ble.connections[i].connected);
+        HAPAssert(server->ble.connections[i].connectionHandle == i + 1);
+    }
+
+    // A central that connects while all sessions are in use is disconnected.
+    HAPPlatformBLEPeripheralManagerConnectCentral(blePeripheralManager, 5);
+    {
+        uint8_t bytes[2];
+        size_t numBytes;
+        err = HAPPlatformBLEPeripheralManagerReadAttribute(
+                blePeripheralManager, 5, cccDescriptorHandle, bytes, sizeof bytes, &numBytes);
+        HAPAssert(err == kHAPError_InvalidState);
+    }
+    HAPPlatformClockAdvance(0);
+    HAPAssert(!HAPPlatformBLEPeripheralManagerIsCentralConnected(blePeripheralManager, 5));
+    for (HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 1; connectionHandle <= 4;
+         connectionHandle++) {
+        HAPAssert(HAPPlatformBLEPeripheralManagerIsCentralConnected(blePeripheralManager, connectionHandle));
+    }
+
+    // HAP-BLE procedures of different centrals proceed concurrently.
+    for (HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 1; connectionHandle <= 4;
+         connectionHandle++) {
+        uint8_t bytes[5];
+        bytes[0] = 0x00;
+        bytes[1] = kHAPPDUOpcode_CharacteristicSignatureRead;
+        bytes[2] = (uint8_t) connectionHandle;
+        HAPWriteLittleUInt16(&bytes[3], testCharacteristics[0].iid);
+        err = HAPPlatformBLEPeripheralManagerWriteAttribute(
+                blePeripheralManager, connectionHandle, valueHandle, bytes, sizeof bytes);
+        HAPAssert(!err);
+    }
+    for (HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 4; connectionHandle >= 1;
+         connectionHandle--) {
+        uint8_t bytes[256];
+        size_t numBytes;
+        err = HAPPlatformBLEPeripheralManagerReadAttribute(
+                blePeripheralManager, connectionHandle, valueHandle, bytes, sizeof bytes, &numBytes);
+        HAPAssert(!err);
+        HAPAssert(numBytes >= 5);
+        HAPAssert(bytes[0] == 0x02);
+        HAPAssert(bytes[1] == connectionHandle);
+        HAPAssert(bytes[2] == kHAPBLEPDUStatus_Success);
+    }
+
+    // Event subscriptions are per connection.
+    WriteCCCDescriptor(test, 1, cccDescriptorHandle, 0x0002);
+    WriteCCCDescriptor(test, 3, cccDescriptorHandle, 0x0002);
+    for (HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle = 1; connectionHandle <= 4;
+         connectionHandle++) {
+        uint16_t expectedValue = connectionHandle == 1 || connectionHandle == 3 ? 0x0002 : 0x0000;
+        HAPAssert(ReadCCCDescriptor(test, connectionHandle, cccDescriptorHandle) == expectedValue);
+    }
+    for (size_t i = 0; i < server->ble.numSessions; i++) {
+        SecureSession(test, &test->sessions[i]);
+    }
+
+    // Events are sent to subscribed centrals. They are dropped for other centrals.
+    HAPAccessoryServerRaiseEvent(&test->accessoryServer, &testCharacteristics[0], &test->service, &test->accessory);
+    HAPAssert(HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 1, &indicatedValueHandle));
+    HAPAssert(indicatedValueHandle == valueHandle);
+    HAPAssert(!HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 2, &indicatedValueHandle));
+    HAPAssert(HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 3, &indicatedValueHandle));
+    HAPAssert(indicatedValueHandle == valueHandle);
+    HAPAssert(!HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 4, &indicatedValueHandle));
+    WriteCCCDescriptor(test, 2, cccDescriptorHandle, 0x0002);
+    HAPAssert(!HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 2, &indicatedValueHandle));
+    HAPAccessoryServerRaiseEvent(&test->accessoryServer, &testCharacteristics[0], &test->service, &test->accessory);
+    HAPAssert(HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 1, &indicatedValueHandle));
+    HAPAssert(HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 2, &indicatedValueHandle));
+    HAPAssert(indicatedValueHandle == valueHandle);
+    HAPAssert(HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 3, &indicatedValueHandle));
+    HAPAssert(!HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 4, &indicatedValueHandle));
+
+    // Disconnecting a central does not affect the other centrals. Advertising resumes for the released session.
+    HAPPlatformBLEPeripheralManagerDisconnectCentral(blePeripheralManager, 1);
+    HAPAssert(!server->ble.connections[0].connected);
+    HAPAssert(HAPPlatformBLEPeripheralManagerIsAdvertising(blePeripheralManager));
+    HAPAccessoryServerRaiseEvent(&test->accessoryServer, &testCharacteristics[0], &test->service, &test->accessory);
+    HAPAssert(HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 2, &indicatedValueHandle));
+    HAPAssert(HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 3, &indicatedValueHandle));
+    HAPAssert(!HAPPlatformBLEPeripheralManagerConfirmIndication(blePeripheralManager, 4, &indicatedValueHandle));
+
+    // The released session is used by the next central, without the subscriptions of the previous central.
+    HAPPlatformBLEPeripheralManagerConnectCentral(blePeripheralManager, 5);
+    HAPAssert(HAPPlatformBLEPeripheralManagerIsCentralConnected(blePeripheralManager, 5));
+    HAPAssert(!HAPPlatformBLEPeripheralManagerIsAdvertising(blePeripheralManager));
+    HAPAssert(server->ble.connections[0].connected);
+    HAPAssert(server->ble.connections[0].connectionHandle == 5);
+    HAPAssert(!HAPSessionIsSecured(&test->sessions[0]));
+    HAPAssert(ReadCCCDescriptor(test, 5, cccDescriptorHandle) == 0x0000);
+    HAPAssert(ReadCCCDescriptor(test, 3, cccDescriptorHandle) == 0x0002);
+
+    err = HAPPlatformKeyValueStoreRemove(
+            test->platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, /* key: */ 0);
+    HAPAssert(!err);
+}
+
+/**
+ * Controller side of a HAP-BLE connection.
+ */
+typedef struct {
+    HAPPlatformBLEPeripheralManagerConnectionHandle connectionHandle;
+    uint8_t transactionID;
+    uint16_t pairVerifyIID;
+
+    char identifier[sizeof "Controller-0"];
+    uint8_t ltsk[ED25519_SECRET_KEY_BYTES];
+    uint8_t ltpk[ED25519_PUBLIC_KEY_BYTES];
+
+    uint8_t cvSK[X25519_SCALAR_BYTES];
+    uint8_t cvPK[X25519_BYTES];
+    uint8_t accessoryCvPK[X25519_BYTES];
+    uint8_t sharedSecret[X25519_BYTES];
+    uint8_t sessionKey[CHACHA20_POLY1305_KEY_BYTES];
+
+    uint8_t controllerToAccessoryKey[CHACHA20_POLY1305_KEY_BYTES];
+    uint8_t accessoryToControllerKey[CHACHA20_POLY1305_KEY_BYTES];
+    uint64_t controllerToAccessoryNonce;
+    uint64_t accessoryToControllerNonce;
+    bool isSecured;
+} TestController;
+
+/**
+ * Creates a controller with an admin pairing that is stored under a given key.
+ */
+static void CreateTestController(TestConfiguration* test, TestController* controller, size_t index) {
+    HAPPrecondition(test);
+    HAPPrecondition(controller);
+    HAPPrecondition(index < 10);
+
+    HAPError err;
+
+    HAPRawBufferZero(controller, sizeof *controller);
+    controller->connectionHandle = (HAPPlatformBLEPeripheralManagerConnectionHandle)(index + 1);
+    err = HAPStringWithFormat(controller->identifier, sizeof controller->identifier, "Controller-%zu", index);
+    HAPAssert(!err);
+    HAPPlatformRandomNumberFill(controller->ltsk, sizeof controller->ltsk);
+    HAP_ed25519_public_key(controller->ltpk, controller->ltsk);
+
+    size_t numIdentifierBytes = HAPStringGetNumBytes(controller->identifier);
+    uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+    HAPRawBufferCopyBytes(&pairingBytes[0], controller->identifier, numIdentifierBytes);
+    pairingBytes[36] = (uint8_t) numIdentifierBytes;
+    HAPRawBufferCopyBytes(&pairingBytes[37], controller->ltpk, sizeof controller->ltpk);
+    pairingBytes[69] = 0x01;
+    err = HAPPlatformKeyValueStoreSet(
+            test->platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Pairings,
+            (HAPPlatformKeyValueStoreKey) index,
+            pairingBytes,
+            sizeof pairingBytes);
+    HAPAssert(!err);
+}
+
+/**
+ * Sends a HAP-BLE request PDU from a controller. The request is encrypted if the session is secured.
+ *
+ * - The buffer must have room for the authentication tag.
+ */
+static void SendRequest(
+        TestConfiguration* test,
+        TestController* controller,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle,
+        uint8_t* bytes,
+        size_t numBytes) {
+    HAPPrecondition(test);
+    HAPPrecondition(controller);
+    HAPPrecondition(bytes);
+
+    HAPError err;
+
+    if (controller->isSecured) {
+        uint8_t nonce[] = { HAPExpandLittleUInt64(controller->controllerToAccessoryNonce) };
+        HAP_chacha20_poly1305_encrypt(
+                &bytes[numBytes],
+                bytes,
+                bytes,
+                numBytes,
+                nonce,
+                sizeof nonce,
+                controller->controllerToAccessoryKey);
+        controller->controllerToAccessoryNonce++;
+        numBytes += CHACHA20_POLY1305_TAG_BYTES;
+    }
+    err = HAPPlatformBLEPeripheralManagerWriteAttribute(
+            &test->blePeripheralManager, controller->connectionHandle, valueHandle, bytes, numBytes);
+    HAPAssert(!err);
+}
+
+/**
+ * Receives a successful HAP-BLE response from a controller and returns the concatenated HAP-Param-Value fragments.
+ */
+static size_t ReceiveResponseValue(
+        TestConfiguration* test,
+        TestController* controller,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle,
+        uint8_t* value,
+        size_t maxValueBytes) {
+    HAPPrecondition(test);
+    HAPPrecondition(controller);
+    HAPPrecondition(value);
+
+    HAPError err;
+
+    // Collect response body.
+    uint8_t body[1024];
+    size_t numBodyBytes = 0;
+    size_t totalBodyBytes = 0;
+    bool isFirstFragment = true;
+    do {
+        uint8_t bytes[kHAPPlatformBLEPeripheralManager_MaxAttributeBytes];
+        size_t numBytes;
+        err = HAPPlatformBLEPeripheralManagerReadAttribute(
+                &test->blePeripheralManager, controller->connectionHandle, valueHandle, bytes, sizeof bytes, &numBytes);
+        HAPAssert(!err);
+        if (controller->isSecured) {
+            HAPAssert(numBytes >= CHACHA20_POLY1305_TAG_BYTES);
+            numBytes -= CHACHA20_POLY1305_TAG_BYTES;
+            uint8_t nonce[] = { HAPExpandLittleUInt64(controller->accessoryToControllerNonce) };
+            int e = HAP_chacha20_poly1305_decrypt(
+                    &bytes[numBytes],
+                    bytes,
+                    bytes,
+                    numBytes,
+                    nonce,
+                    sizeof nonce,
+                    controller->accessoryToControllerKey);
+            HAPAssert(!e);
+            controller->accessoryToControllerNonce++;
+        }
+        size_t numHeaderBytes;
+        if (isFirstFragment) {
+            HAPAssert(numBytes >= 3);
+            HAPAssert(bytes[0] == 0x02);
+            HAPAssert(bytes[1] == controller->transactionID);
+            HAPAssert(bytes[2] == kHAPBLEPDUStatus_Success);
+            if (numBytes == 3) {
+                return 0;
+            }
+            HAPAssert(numBytes >= 5);
+            totalBodyBytes = HAPReadLittleUInt16(&bytes[3]);
+            HAPAssert(totalBodyBytes <= sizeof body);
+            numHeaderBytes = 5;
+            isFirstFragment = false;
+        } else {
+            HAPAssert(numBytes >= 2);
+            HAPAssert(bytes[0] == 0x82);
+            HAPAssert(bytes[1] == controller->transactionID);
+            numHeaderBytes = 2;
+        }
+        HAPAssert(numBytes - numHeaderBytes <= totalBodyBytes - numBodyBytes);
+        HAPRawBufferCopyBytes(&body[numBodyBytes], &bytes[numHeaderBytes], numBytes - numHeaderBytes);
+        numBodyBytes += numBytes - numHeaderBytes;
+    } while (numBodyBytes < totalBodyBytes);
+
+    // Concatenate HAP-Param-Value fragments.
+    size_t numValueBytes = 0;
+    for (size_t i = 0; i < numBodyBytes;) {
+        HAPAssert(numBodyBytes - i >= 2);
+        size_t numFragmentBytes = body[i + 1];
+        HAPAssert(numBodyBytes - i - 2 >= numFragmentBytes);
+        if (body[i] == kHAPBLEPDUTLVType_Value) {
+            HAPAssert(numFragmentBytes <= maxValueBytes - numValueBytes);
+            HAPRawBufferCopyBytes(&value[numValueBytes], &body[i + 2], numFragmentBytes);
+            numValueBytes += numFragmentBytes;
+        }
+        i += 2 + numFragmentBytes;
+    }
+    return numValueBytes;
+}
+
+/**
+ * Writes a Pair Verify request from a controller.
+ */
+static void WritePairVerifyRequest(
+        TestConfiguration* test,
+        TestController* controller,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle,
+        const void* requestBytes,
+        size_t numRequestBytes) {
+    HAPPrecondition(test);
+    HAPPrecondition(controller);
+    HAPPrecondition(requestBytes);
+    HAPPrecondition(numRequestBytes <= UINT8_MAX);
+
+    controller->transactionID++;
+
+    uint8_t bytes[kHAPPlatformBLEPeripheralManager_MaxAttributeBytes];
+    bytes[0] = 0x00;
+    bytes[1] = kHAPPDUOpcode_CharacteristicWrite;
+    bytes[2] = controller->transactionID;
+    HAPWriteLittleUInt16(&bytes[3], controller->pairVerifyIID);
+    size_t numBytes = 7;
+    bytes[numBytes++] = kHAPBLEPDUTLVType_Value;
+    bytes[numBytes++] = (uint8_t) numRequestBytes;
+    HAPRawBufferCopyBytes(&bytes[numBytes], requestBytes, numRequestBytes);
+    numBytes += numRequestBytes;
+    bytes[numBytes++] = kHAPBLEPDUTLVType_ReturnResponse;
+    bytes[numBytes++] = 1;
+    bytes[numBytes++] = 1;
+    HAPWriteLittleUInt16(&bytes[5], numBytes - 7);
+    SendRequest(test, controller, valueHandle, bytes, numBytes);
+}
+
+/**
+ * Sends Pair Verify M1 from a controller.
+ */
+static void SendPairVerifyM1(
+        TestConfiguration* test,
+        TestController* controller,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle) {
+    HAPPrecondition(test);
+    HAPPrecondition(controller);
+
+    HAPError err;
+
+    HAPPlatformRandomNumberFill(controller->cvSK, sizeof controller->cvSK);
+    HAP_X25519_scalarmult_base(controller->cvPK, controller->cvSK);
+
+    uint8_t bytes[64];
+    HAPTLVWriterRef writer;
+    HAPTLVWriterCreate(&writer, bytes, sizeof bytes);
+    err = HAPTLVWriterAppend(
+            &writer,
+            &(const HAPTLV) { .type = kHAPPairingTLVType_State,
+                              .value = { .bytes = (const uint8_t[]) { 1 }, .numBytes = 1 } });
+    HAPAssert(!err);
+    err = HAPTLVWriterAppend(
+            &writer,
+            &(const HAPTLV) { .type = kHAPPairingTLVType_PublicKey,
+                              .value = { .bytes = controller->cvPK, .numBytes = sizeof controller->cvPK } });
+    HAPAssert(!err);
+    void* requestBytes;
+    size_t numRequestBytes;
+    HAPTLVWriterGetBuffer(&writer, &requestBytes, &numRequestBytes);
+    WritePairVerifyRequest(test, controller, valueHandle, requestBytes, numRequestBytes);
+}
+
+/**
+ * Receives Pair Verify M2 on a controller, verifies the accessory, and sends Pair Verify M3.
+ */
+static void HandlePairVerifyM2(
+        TestConfiguration* test,
+        TestController* controller,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle) {
+    HAPPrecondition(test);
+    HAPPrecondition(controller);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) &test->accessoryServer;
+
+    HAPError err;
+
+    uint8_t bytes[512];
+    size_t numBytes = ReceiveResponseValue(test, controller, valueHandle, bytes, sizeof bytes);
+    HAPTLV stateTLV, publicKeyTLV, encryptedDataTLV;
+    stateTLV.type = kHAPPairingTLVType_State;
+    publicKeyTLV.type = kHAPPairingTLVType_PublicKey;
+    encryptedDataTLV.type = kHAPPairingTLVType_EncryptedData;
+    {
+        HAPTLVReaderRef reader;
+        HAPTLVReaderCreate(&reader, bytes, numBytes);
+        err = HAPTLVReaderGetAll(&reader, (HAPTLV* const[]) { &stateTLV, &publicKeyTLV, &encryptedDataTLV, NULL });
+        HAPAssert(!err);
+    }
+    HAPAssert(stateTLV.value.numBytes == 1);
+    HAPAssert(((const uint8_t*) HAPNonnullVoid(stateTLV.value.bytes))[0] == 2);
+    HAPAssert(publicKeyTLV.value.numBytes == sizeof controller->accessoryCvPK);
+    HAPRawBufferCopyBytes(
+            controller->accessoryCvPK, HAPNonnullVoid(publicKeyTLV.value.bytes), sizeof controller->accessoryCvPK);
+    HAPAssert(encryptedDataTLV.value.numBytes >= CHACHA20_POLY1305_TAG_BYTES);
+
+    // Derive the symmetric session encryption key.
+    HAP_X25519_scalarmult(controller->sharedSecret, controller->cvSK, controller->accessoryCvPK);
+    static const uint8_t salt[] = "Pair-Verify-Encrypt-Salt";
+    static const uint8_t info[] = "Pair-Verify-Encrypt-Info";
+    HAP_hkdf_sha512(
+            controller->sessionKey,
+            sizeof controller->sessionKey,
+            controller->sharedSecret,
+            sizeof controller->sharedSecret,
+            salt,
+            sizeof salt - 1,
+            info,
+            sizeof info - 1);
+
+    // Decrypt and verify AccessoryInfo.
+    uint8_t* encryptedBytes = (uint8_t*) (uintptr_t) HAPNonnullVoid(encryptedDataTLV.value.bytes);
+    size_t numEncryptedBytes = encryptedDataTLV.value.numBytes - CHACHA20_POLY1305_TAG_BYTES;
+    {
+        static const uint8_t nonce[] = "PV-Msg02";
+        int e = HAP_chacha20_poly1305_decrypt(
+                &encryptedBytes[numEncryptedBytes],
+                encryptedBytes,
+                encryptedBytes,
+                numEncryptedBytes,
+                nonce,
+                sizeof nonce - 1,
+                controller->sessionKey);
+        HAPAssert(!e);
+    }
+    HAPTLV identifierTLV, signatureTLV;
+    identifierTLV.type = kHAPPairingTLVType_Identifier;
+    signatureTLV.type = kHAPPairingTLVType_Signature;
+    {
+        HAPTLVReaderRef reader;
+        HAPTLVReaderCreate(&reader, encryptedBytes, numEncryptedBytes);
+        err = HAPTLVReaderGetAll(&reader, (HAPTLV* const[]) { &identifierTLV, &signatureTLV, NULL });
+        HAPAssert(!err);
+    }
+    HAPAssert(identifierTLV.value.numBytes <= sizeof(HAPDeviceIDString));
+    HAPAssert(signatureTLV.value.numBytes == ED25519_BYTES);
+    {
+        uint8_t infoBytes[X25519_BYTES + sizeof(HAPDeviceIDString) + X25519_BYTES];
+        size_t numInfoBytes = 0;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->accessoryCvPK, X25519_BYTES);
+        numInfoBytes += X25519_BYTES;
+        HAPRawBufferCopyBytes(
+                &infoBytes[numInfoBytes], HAPNonnullVoid(identifierTLV.value.bytes), identifierTLV.value.numBytes);
+        numInfoBytes += identifierTLV.value.numBytes;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->cvPK, X25519_BYTES);
+        numInfoBytes += X25519_BYTES;
+        int e = HAP_ed25519_verify(
+                HAPNonnullVoid(signatureTLV.value.bytes), infoBytes, numInfoBytes, server->identity.ed_LTPK);
+        HAPAssert(!e);
+    }
+
+    // Construct and encrypt iOSDeviceInfo.
+    size_t numIdentifierBytes = HAPStringGetNumBytes(controller->identifier);
+    uint8_t subBytes[128];
+    HAPTLVWriterRef subWriter;
+    HAPTLVWriterCreate(&subWriter, subBytes, sizeof subBytes - CHACHA20_POLY1305_TAG_BYTES);
+    err = HAPTLVWriterAppend(
+            &subWriter,
+            &(const HAPTLV) { .type = kHAPPairingTLVType_Identifier,
+                              .value = { .bytes = controller->identifier, .numBytes = numIdentifierBytes } });
+    HAPAssert(!err);
+    {
+        uint8_t infoBytes[X25519_BYTES + sizeof controller->identifier + X25519_BYTES];
+        size_t numInfoBytes = 0;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->cvPK, X25519_BYTES);
+        numInfoBytes += X25519_BYTES;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->identifier, numIdentifierBytes);
+        numInfoBytes += numIdentifierBytes;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->accessoryCvPK, X25519_BYTES);
+        numInfoBytes += X25519_BYTES;
+        uint8_t signature[ED25519_BYTES];
+        HAP_ed25519_sign(signature, infoBytes, numInfoBytes, controller->ltsk, controller->ltpk);
+        err = HAPTLVWriterAppend(
+                &subWriter,
+                &(const HAPTLV) { .type = kHAPPairingTLVType_Signature,
+                                  .value = { .bytes = signature, .numBytes = sizeof signature } });
+        HAPAssert(!err);
+    }
+    void* subTLVBytes;
+    size_t numSubTLVBytes;
+    HAPTLVWriterGetBuffer(&subWriter, &subTLVBytes, &numSubTLVBytes);
+    {
+        static const uint8_t nonce[] = "PV-Msg03";
+        HAP_chacha20_poly1305_encrypt(
+                &((uint8_t*) subTLVBytes)[numSubTLVBytes],
+                subTLVBytes,
+                subTLVBytes,
+                numSubTLVBytes,
+                nonce,
+                sizeof nonce - 1,
+                controller->sessionKey);
+        numSubTLVBytes += CHACHA20_POLY1305_TAG_BYTES;
+    }
+
+    // Send M3.
+    HAPTLVWriterRef writer;
+    HAPTLVWriterCreate(&writer, bytes, sizeof bytes);
+    err = HAPTLVWriterAppend(
+            &writer,
+            &(const HAPTLV) { .type = kHAPPairingTLVType_State,
+                              .value = { .bytes = (const uint8_t[]) { 3 }, .numBytes = 1 } });
+    HAPAssert(!err);
+    err = HAPTLVWriterAppend(
+            &writer,
+            &(const HAPTLV) { .type = kHAPPairingTLVType_EncryptedData,
+                              .value = { .bytes = subTLVBytes, .numBytes = numSubTLVBytes } });
+    HAPAssert(!err);
+    void* requestBytes;
+    size_t numRequestBytes;
+    HAPTLVWriterGetBuffer(&writer, &requestBytes, &numRequestBytes);
+    WritePairVerifyRequest(test, controller, valueHandle, requestBytes, numRequestBytes);
+}
+
+/**
+ * Receives Pair Verify M4 on a controller and derives the session keys.
+ */
+static void HandlePairVerifyM4(
+        TestConfiguration* test,
+        TestController* controller,
+        HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle) {
+    HAPPrecondition(test);
+    HAPPrecondition(controller);
+
+    HAPError err;
+
+    uint8_t bytes[64];
+    size_t numBytes = ReceiveResponseValue(test, controller, valueHandle, bytes, sizeof bytes);
+    HAPTLV stateTLV, errorTLV;
+    stateTLV.type = kHAPPairingTLVType_State;
+    errorTLV.type = kHAPPairingTLVType_Error;
+    {
+        HAPTLVReaderRef reader;
+        HAPTLVReaderCreate(&reader, bytes, numBytes);
+        err = HAPTLVReaderGetAll(&reader, (HAPTLV* const[]) { &stateTLV, &errorTLV, NULL });
+        HAPAssert(!err);
+    }
+    HAPAssert(stateTLV.value.numBytes == 1);
+    HAPAssert(((const uint8_t*) HAPNonnullVoid(stateTLV.value.bytes))[0] == 4);
+    HAPAssert(!errorTLV.value.bytes);
+
+    static const uint8_t salt[] = "Control-Salt";
+    {
+        static const uint8_t info[] = "Control-Write-Encryption-Key";
+        HAP_hkdf_sha512(
+                controller->controllerToAccessoryKey,
+                sizeof controller->controllerToAccessoryKey,
+                controller->sharedSecret,
+                sizeof controller->sharedSecret,
+                salt,
+                sizeof salt - 1,
+                info,
+                sizeof info - 1);
+    }
+    {
+        static const uint8_t info[] = "Control-Read-Encryption-Key";
+        HAP_hkdf_sha512(
+                controller->accessoryToControllerKey,
+                sizeof controller->accessoryToControllerKey,
+                controller->sharedSecret,
+                sizeof controller->sharedSecret,
+                salt,
+                sizeof salt - 1,
+                info,
+                sizeof info - 1);
+    }
+    controller->controllerToAccessoryNonce = 0;
+    controller->accessoryToControllerNonce = 0;
+    controller->isSecured = true;
+}
+
+/**
+ * Connects multiple centrals that each run Pair Verify and then read a characteristic over their secured session.
+ * All centrals interleave their requests.
+ */
+static void BenchmarkMultipleCentrals(TestConfiguration* test, size_t numCentrals) {
+    HAPPrecondition(test);
+    HAPPrecondition(numCentrals && numCentrals <= kHAPBLESessions_MaxElements);
+
+    HAPError err;
+
+    HAPPlatformBLEPeripheralManagerAttributeHandle pairVerifyHandle = 0;
+    uint16_t pairVerifyIID = 0;
+    {
+        static HAPPlatformBLEPeripheralManagerAttributeHandle handles[kMaxGATTTableElements];
+        static const HAPCharacteristic* characteristics[kMaxGATTTableElements];
+        static const HAPService* services[kMaxGATTTableElements];
+        size_t numHandles = GetCharacteristicValueHandles(
+                test, handles, characteristics, services, HAPArrayCount(handles));
+        for (size_t i = 0; i < numHandles; i++) {
+            const HAPBaseCharacteristic* characteristic = characteristics[i];
+            if (HAPUUIDAreEqual(characteristic->characteristicType, &kHAPCharacteristicType_PairVerify)) {
+                pairVerifyHandle = handles[i];
+                pairVerifyIID = (uint16_t) characteristic->iid;
+            }
+        }
+    }
+    HAPAssert(pairVerifyHandle);
+    HAPPlatformBLEPeripheralManagerAttributeHandle valueHandle = GetValueHandle(test, &testCharacteristics[0]);
+
+    // Connect centrals. The first central is connected by the test configuration.
+    static TestController controllers[kHAPBLESessions_MaxElements];
+    for (size_t i = 0; i < numCentrals; i++) {
+        CreateTestController(test, &controllers[i], i);
+        controllers[i].pairVerifyIID = pairVerifyIID;
+        if (i) {
+            HAPPlatformBLEPeripheralManagerConnectCentral(&test->blePeripheralManager, controllers[i].connectionHandle);
+        }
+    }
+
+    // Pair Verify.
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < numCentrals; i++) {
+        SendPairVerifyM1(test, &controllers[i], pairVerifyHandle);
+    }
+    for (size_t i = 0; i < numCentrals; i++) {
+        HandlePairVerifyM2(test, &controllers[i], pairVerifyHandle);
+    }
+    for (size_t i = 0; i < numCentrals; i++) {
+        HandlePairVerifyM4(test, &controllers[i], pairVerifyHandle);
+    }
+    uint64_t elapsedNanoseconds = HAPBenchmarkGetElapsedNanoseconds(&timer);
+    for (size_t i = 0; i < numCentrals; i++) {
+        HAPAssert(HAPSessionIsSecured(&test->sessions[i]));
+    }
+    char name[64];
+    err = HAPStringWithFormat(name, sizeof name, "Pair Verify (%zu centrals)", numCentrals);
+    HAPAssert(!err);
+    HAPBenchmarkLogRate(name, numCentrals, elapsedNanoseconds);
+
+    // Encrypted characteristic reads.
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations / 20; i++) {
+        TestController* controller = &controllers[i % numCentrals];
+        controller->transactionID++;
+        uint8_t bytes[5 + CHACHA20_POLY1305_TAG_BYTES];
+        bytes[0] = 0x00;
+        bytes[1] = kHAPPDUOpcode_CharacteristicRead;
+        bytes[2] = controller->transactionID;
+        HAPWriteLittleUInt16(&bytes[3], testCharacteristics[0].iid);
+        SendRequest(test, controller, valueHandle, bytes, 5);
+        uint8_t value[1];
+        size_t numValueBytes = ReceiveResponseValue(test, controller, valueHandle, value, sizeof value);
+        HAPAssert(numValueBytes == 1);
+    }
+    err = HAPStringWithFormat(name, sizeof name, "Encrypted read (%zu centrals)", numCentrals);
+    HAPAssert(!err);
+    HAPBenchmarkLogRate(name, kNumBenchmarkOperations / 20, HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    for (size_t i = 0; i < numCentrals; i++) {
+        err = HAPPlatformKeyValueStoreRemove(
+                test->platform.keyValueStore, kHAPKeyValueStoreDomain_Pairings, (HAPPlatformKeyValueStoreKey) i);
+        HAPAssert(!err);
+    }
+}
+
+int main() {
+    HAPPlatformCreate();
+    PrepareTestCharacteristics();
+
+    static const size_t numCharacteristics[] = { 8, 32, 128, kMaxTestCharacteristics };
+    static TestConfiguration test;
+    for (size_t i = 0; i < HAPArrayCount(numCharacteristics); i++) {
+        for (int useGATTHandleTable = 1; useGATTHandleTable >= 0; useGATTHandleTable--) {
+            StartTestConfiguration(
+                    &test,
+                    numCharacteristics[i],
+                    useGATTHandleTable,
+                    /* numSignatureCacheBytes: */ 0,
+                    /* numSessions: */ 1,
+                    /* flattenAttributeDatabase: */ false);
+            TestDescriptorReads(&test);
+            TestCCCDescriptorWrite(&test);
+            BenchmarkGATTReads(&test, numCharacteristics[i], useGATTHandleTable);
+            StopTestConfiguration(&test);
+        }
+    }
+
+    // Responses that span multiple GATT reads.
+    StartTestConfiguration(
+            &test,
+            numCharacteristics[0],
+            /* useGATTHandleTable: */ true,
+            /* numSignatureCacheBytes: */ 0,
+            /* numSessions: */ 1,
+            /* flattenAttributeDatabase: */ false);
+    TestLargeValueReads(&test);
+    StopTestConfiguration(&test);
+
+    // Event storms.
+    for (size_t i = 0; i < HAPArrayCount(numCharacteristics); i++) {
+        for (int flattenAttributeDatabase = 1; flattenAttributeDatabase >= 0; flattenAttributeDatabase--) {
+            StartTestConfiguration(
+                    &test,
+                    numCharacteristics[i],
+                    /* useGATTHandleTable: */ true,
+                    /* numSignatureCacheBytes: */ 0,
+                    /* numSessions: */ 1,
+                    flattenAttributeDatabase);
+            TestEventStorms(&test, numCharacteristics[i]);
+            StopTestConfiguration(&test);
+        }
+    }
+
+    // Undeliverable events.
+    for (int flattenAttributeDatabase = 1; flattenAttributeDatabase >= 0; flattenAttributeDatabase--) {
+        StartTestConfiguration(
+                &test,
+                numCharacteristics[0],
+                /* useGATTHandleTable: */ true,
+                /* numSignatureCacheBytes: */ 0,
+                /* numSessions: */ 1,
+                flattenAttributeDatabase);
+        TestUndeliverableEvents(&test);
+        StopTestConfiguration(&test);
+    }
+
+    // Signature cache: disabled, too small for all signatures, large enough for all signatures.
+    static const size_t numSignatureCacheBytes[] = { 0, 1024, sizeof test.signatureCacheBytes };
+    for (size_t i = 0; i < HAPArrayCount(numSignatureCacheBytes); i++) {
+        StartTestConfiguration(
+                &test,
+                kMaxTestCharacteristics,
+                /* useGATTHandleTable: */ true,
+                numSignatureCacheBytes[i],
+                /* numSessions: */ 1,
+                /* flattenAttributeDatabase: */ false);
+        TestSignatureReads(&test);
+        BenchmarkSignatureReads(&test, numSignatureCacheBytes[i]);
+        StopTestConfiguration(&test);
+    }
+
+    // Configuration number changes.
+    StartTestConfiguration(
+            &test,
+            numCharacteristics[0],
+            /* useGATTHandleTable: */ true,
+            /* numSignatureCacheBytes: */ 0,
+            /* numSessions: */ 2,
+            /* flattenAttributeDatabase: */ false);
+    TestConfigurationNumberAdvertising(&test);
+    StopTestConfiguration(&test);
+
+    // Concurrent centrals.
+    StartTestConfiguration(
+            &test,
+            numCharacteristics[0],
+            /* useGATTHandleTable: */ true,
+            /* numSignatureCacheBytes: */ 0,
+            /* numSessions: */ 4,
+            /* flattenAttributeDatabase: */ false);
+    TestMultipleCentrals(&test);
+    StopTestConfiguration(&test);
+
+    static const size_t numCentrals[] = { 1, 2, 4, kHAPBLESessions_MaxElements };
+    for (size_t i = 0; i < HAPArrayCount(numCentrals); i++) {
+        StartTestConfiguration(
+                &test,
+                numCharacteristics[0],
+                /* useGATTHandleTable: */ true,
+                /* numSignatureCacheBytes: */ 0,
+                numCentrals[i],
+                /* flattenAttributeDatabase: */ true);
+        BenchmarkMultipleCentrals(&test, numCentrals[i]);
+        StopTestConfiguration(&test);
+    }
+
+    return 0;
+}
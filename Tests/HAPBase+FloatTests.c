@@ -4,8 +4,13 @@
 // you may not use this file except in compliance with the License.
 // See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include "HAPPlatform.h"
 
+#include "Harness/HAPBenchmark.c"
+
 HAP_DIAGNOSTIC_IGNORED_CLANG("-Wfloat-equal")
 
 #define TEST_FROM_STRING(description, expectedValue) \
@@ -108,6 +113,143 @@ HAP_DIAGNOSTIC_IGNORED_CLANG("-Wfloat-equal")
 #define INF (1.0F / 0.0F)
 #define NAN (0.0F / 0.0F)
 
+#define kNumBenchmarkRuns 100
+
+/**
+ * Compares the description of a float against the C library.
+ *
+ * - The description must be parsed back to the same value, both by HAPFloatFromString and by strtof.
+ * - It must not have more significant digits than the shortest representation found with snprintf.
+ * - If it has as many digits, they must be the ones of the correctly rounded snprintf representation.
+ *   Fewer digits are possible at powers of 2 where the rounding interval is asymmetric.
+ */
+static void TestDescriptionMatchesReference(float value) {
+    HAPError err;
+
+    char string[kHAPFloat_MaxDescriptionBytes + 1];
+    err = HAPFloatGetDescription(string, sizeof string, value);
+    HAPAssert(!err);
+
+    float newValue;
+    err = HAPFloatFromString(string, &newValue);
+    HAPAssert(!err);
+    HAPAssert(HAPFloatGetBitPattern(newValue) == HAPFloatGetBitPattern(value));
+    HAPAssert(HAPFloatGetBitPattern(strtof(string, NULL)) == HAPFloatGetBitPattern(value));
+
+    // Collect significant digits.
+    char digits[sizeof string];
+    size_t numDigits = 0;
+    for (size_t i = 0; string[i] && string[i] != 'e'; i++) {
+        if (string[i] >= '0' && string[i] <= '9' && (numDigits || string[i] != '0')) {
+            digits[numDigits++] = string[i];
+        }
+    }
+    while (numDigits > 1 && digits[numDigits - 1] == '0') {
+        numDigits--;
+    }
+
+    // Find shortest representation with the C library.
+    char reference[32];
+    int precision;
+    for (precision = 1; precision <= 9; precision++) {
+        int numBytes = snprintf(reference, sizeof reference, "%.*e", precision - 1, (double) value);
+        HAPAssert(numBytes > 0 && (size_t) numBytes < sizeof reference);
+        if (HAPFloatGetBitPattern(strtof(reference, NULL)) == HAPFloatGetBitPattern(value)) {
+            break;
+        }
+    }
+    HAPAssert(precision <= 9);
+    HAPAssert(numDigits <= (size_t) precision);
+    if (numDigits == (size_t) precision) {
+        size_t j = 0;
+        for (size_t i = 0; reference[i] && reference[i] != 'e'; i++) {
+            if (reference[i] >= '0' && reference[i] <= '9') {
+                HAPAssert(j >= numDigits || reference[i] == digits[j]);
+                j++;
+            }
+        }
+    } else {
+        HAPAssert(!(HAPFloatGetBitPattern(value) & 0x7FFFFF));
+    }
+}
+
+/**
+ * Compares HAPFloatFromString against strtof for a decimal string.
+ */
+static void TestFromStringMatchesReference(const char* string) {
+    float value;
+    HAPError err = HAPFloatFromString(string, &value);
+    HAPAssert(!err);
+    HAPAssert(HAPFloatGetBitPattern(value) == HAPFloatGetBitPattern(strtof(string, NULL)));
+}
+
+static void TestReference(uint32_t bitPattern) {
+    float value = HAPFloatFromBitPattern(bitPattern);
+    TestDescriptionMatchesReference(value);
+    TestDescriptionMatchesReference(-value);
+
+    // Strings with more digits than needed, up to the 18 significant digits that HAPFloatFromString considers.
+    static const int precisions[] = { 3, 6, 9, 12, 17 };
+    for (size_t i = 0; i < HAPArrayCount(precisions); i++) {
+        char string[32];
+        int numBytes = snprintf(string, sizeof string, "%.*e", precisions[i], (double) value);
+        HAPAssert(numBytes > 0 && (size_t) numBytes < sizeof string);
+        TestFromStringMatchesReference(string);
+    }
+}
+
+static void TestRandomStrings(void) {
+    for (size_t i = 0; i < 100000; i++) {
+        uint64_t random;
+        HAPPlatformRandomNumberFill(&random, sizeof random);
+        char string[32];
+        int numBytes = snprintf(
+                string,
+                sizeof string,
+                "%llue%d",
+                (unsigned long long) (random % 100000000000000000),
+                (int) ((random >> 57) % 100) - 70);
+        HAPAssert(numBytes > 0 && (size_t) numBytes < sizeof string);
+        TestFromStringMatchesReference(string);
+    }
+}
+
+static void BenchmarkSensorValues(void) {
+    // Values as reported by temperature, humidity and power sensors.
+    float values[1000];
+    for (size_t i = 0; i < HAPArrayCount(values); i++) {
+        values[i] = (float) ((int) i - 300) / 10.0F;
+    }
+    char strings[HAPArrayCount(values)][kHAPFloat_MaxDescriptionBytes + 1];
+    HAPBenchmarkTimer timer;
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        for (size_t j = 0; j < HAPArrayCount(values); j++) {
+            HAPError err = HAPFloatGetDescription(strings[j], sizeof strings[j], values[j]);
+            HAPAssert(!err);
+        }
+    }
+    HAPBenchmarkLogRate(
+            "HAPFloatGetDescription",
+            (uint64_t) kNumBenchmarkRuns * HAPArrayCount(values),
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        for (size_t j = 0; j < HAPArrayCount(values); j++) {
+            float value;
+            HAPError err = HAPFloatFromString(strings[j], &value);
+            HAPAssert(!err);
+            HAPAssert(value == values[j]);
+        }
+    }
+    HAPBenchmarkLogRate(
+            "HAPFloatFromString",
+            (uint64_t) kNumBenchmarkRuns * HAPArrayCount(values),
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+}
+
 int main() {
     // Zero.
     TEST_FROM_STRING("0", 0.0F);
@@ -215,12 +357,36 @@ int main() {
     TEST_GET_DESCRIPTION(0x1.000000P127F);
     TEST_GET_DESCRIPTION(0x0.FFFFFFP128F);
 
+    // Formatting and parsing compared against the C library.
+    TEST_FROM_STRING("1e-46", 0.0F);
+    TEST_FROM_STRING("7.006492e-46", 0.0F);        // Just below half of the smallest denormalized float.
+    TEST_FROM_STRING("7.006493e-46", 0x1.0P-149F); // Just above half of the smallest denormalized float.
+    TEST_FROM_STRING("1.1754942e-38", 0x0.FFFFFEP-126F);
+    TEST_FROM_STRING("1.17549429e-38", 0x1.000000P-126F); // Rounds up to the smallest normalized float.
+    TEST_FROM_STRING("3.40282356e38", 0x1.FFFFFEP127F);
+    TEST_FROM_STRING("3.40282357e38", INF);
+    for (uint32_t exp2 = 0; exp2 < 0xFF; exp2++) {
+        // Powers of 2 and their neighbors.
+        TestReference(exp2 << 23);
+        TestReference((exp2 << 23) + 1);
+        TestReference((exp2 << 23) + 0x7FFFFF);
+    }
+    for (uint32_t bitPattern = 1; bitPattern < 0x1000; bitPattern++) {
+        // Small denormalized floats.
+        TestReference(bitPattern);
+    }
+    for (uint32_t bitPattern = 0; bitPattern < 0x7F800000; bitPattern += 32749) {
+        TestReference(bitPattern);
+    }
+    TestRandomStrings();
+
 #if defined(HAP_LONG_TESTS) && HAP_LONG_TESTS != 0
     // Full to string / from string test (runs for hours)
     uint32_t bitPattern;
     for (bitPattern = 0; bitPattern < 0x7F800000; bitPattern++) {
         float floatValue = HAPFloatFromBitPattern(bitPattern);
         TEST_GET_DESCRIPTION(floatValue);
+        TestReference(bitPattern);
     }
 #endif
 
@@ -280,4 +446,6 @@ int main() {
     TEST_IS_INFINITE(INF, true);
     TEST_IS_INFINITE(-INF, true);
     TEST_IS_INFINITE(NAN, false);
+
+    BenchmarkSensorValues();
 }
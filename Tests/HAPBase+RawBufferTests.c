@@ -0,0 +1,151 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAPPlatform.h"
+
+#include "Harness/HAPBenchmark.c"
+
+#define kMaxTestBytes 80
+
+#define kNumBenchmarkBytes 1024
+#define kNumBenchmarkRuns  20000
+
+static void Fill(uint8_t* bytes, size_t numBytes) {
+    for (size_t i = 0; i < numBytes; i++) {
+        bytes[i] = (uint8_t)(i * 7 + 1);
+    }
+}
+
+static void TestZero(void) {
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t numBytes = 0; numBytes <= kMaxTestBytes; numBytes++) {
+            uint8_t bytes[16 + kMaxTestBytes + 16];
+            Fill(bytes, sizeof bytes);
+            HAPRawBufferZero(&bytes[offset], numBytes);
+            for (size_t i = 0; i < sizeof bytes; i++) {
+                if (i >= offset && i < offset + numBytes) {
+                    HAPAssert(bytes[i] == 0);
+                } else {
+                    HAPAssert(bytes[i] == (uint8_t)(i * 7 + 1));
+                }
+            }
+        }
+    }
+}
+
+static void TestCopyBytes(void) {
+    // All combinations of source and destination offsets within the same buffer, including overlaps.
+    for (size_t sourceOffset = 0; sourceOffset < 24; sourceOffset++) {
+        for (size_t destinationOffset = 0; destinationOffset < 24; destinationOffset++) {
+            for (size_t numBytes = 0; numBytes <= kMaxTestBytes; numBytes++) {
+                uint8_t bytes[24 + kMaxTestBytes];
+                uint8_t expectedBytes[sizeof bytes];
+                Fill(bytes, sizeof bytes);
+                Fill(expectedBytes, sizeof expectedBytes);
+
+                // Reference: Copy through a temporary buffer.
+                uint8_t temp[kMaxTestBytes];
+                for (size_t i = 0; i < numBytes; i++) {
+                    temp[i] = expectedBytes[sourceOffset + i];
+                }
+                for (size_t i = 0; i < numBytes; i++) {
+                    expectedBytes[destinationOffset + i] = temp[i];
+                }
+
+                HAPRawBufferCopyBytes(&bytes[destinationOffset], &bytes[sourceOffset], numBytes);
+                for (size_t i = 0; i < sizeof bytes; i++) {
+                    HAPAssert(bytes[i] == expectedBytes[i]);
+                }
+            }
+        }
+    }
+}
+
+static void TestAreEqual(void) {
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t otherOffset = 0; otherOffset < 16; otherOffset++) {
+            for (size_t numBytes = 0; numBytes <= kMaxTestBytes; numBytes++) {
+                uint8_t bytes[16 + kMaxTestBytes];
+                uint8_t otherBytes[16 + kMaxTestBytes];
+                Fill(&bytes[offset], numBytes);
+                Fill(&otherBytes[otherOffset], numBytes);
+                HAPAssert(HAPRawBufferAreEqualPublic(&bytes[offset], &otherBytes[otherOffset], numBytes));
+                HAPAssert(HAPRawBufferAreEqual(&bytes[offset], &otherBytes[otherOffset], numBytes));
+
+                // A difference at any position must be detected.
+                for (size_t i = 0; i < numBytes; i++) {
+                    otherBytes[otherOffset + i] ^= 0x80;
+                    HAPAssert(!HAPRawBufferAreEqualPublic(&bytes[offset], &otherBytes[otherOffset], numBytes));
+                    HAPAssert(!HAPRawBufferAreEqual(&bytes[offset], &otherBytes[otherOffset], numBytes));
+                    otherBytes[otherOffset + i] ^= 0x80;
+                }
+            }
+        }
+    }
+}
+
+static void BenchmarkRawBuffer(void) {
+    static uint8_t bytes[kNumBenchmarkBytes + 1];
+    static uint8_t otherBytes[kNumBenchmarkBytes + 1];
+    Fill(bytes, sizeof bytes);
+    Fill(otherBytes, sizeof otherBytes);
+    HAPBenchmarkTimer timer;
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        HAPRawBufferCopyBytes(&otherBytes[i & 1], &bytes[1], kNumBenchmarkBytes);
+    }
+    HAPBenchmarkLogThroughput(
+            "HAPRawBufferCopyBytes",
+            (uint64_t) kNumBenchmarkBytes * kNumBenchmarkRuns,
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        HAPRawBufferZero(&otherBytes[i & 1], kNumBenchmarkBytes);
+    }
+    HAPBenchmarkLogThroughput(
+            "HAPRawBufferZero",
+            (uint64_t) kNumBenchmarkBytes * kNumBenchmarkRuns,
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    Fill(otherBytes, sizeof otherBytes);
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        HAPAssert(HAPRawBufferAreEqual(bytes, otherBytes, kNumBenchmarkBytes));
+    }
+    HAPBenchmarkLogThroughput(
+            "HAPRawBufferAreEqual",
+            (uint64_t) kNumBenchmarkBytes * kNumBenchmarkRuns,
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        HAPAssert(HAPRawBufferAreEqualPublic(bytes, otherBytes, kNumBenchmarkBytes));
+    }
+    HAPBenchmarkLogThroughput(
+            "HAPRawBufferAreEqualPublic",
+            (uint64_t) kNumBenchmarkBytes * kNumBenchmarkRuns,
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    // Typical public comparison: Request URI.
+    static const char uri[] = "/characteristics";
+    static const char otherURI[] = "/characteristics";
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        HAPAssert(HAPRawBufferAreEqualPublic(uri, otherURI, sizeof uri - 1));
+    }
+    HAPBenchmarkLogRate(
+            "HAPRawBufferAreEqualPublic (URI)", kNumBenchmarkRuns, HAPBenchmarkGetElapsedNanoseconds(&timer));
+}
+
+int main() {
+    TestZero();
+    TestCopyBytes();
+    TestAreEqual();
+    BenchmarkRawBuffer();
+    return 0;
+}
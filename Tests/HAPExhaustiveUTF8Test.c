@@ -127,8 +127,25 @@ static bool HAPUTF8IsValidDataRef(const void* bytes, size_t numBytes) {
 }
 
 int main() {
+    uint8_t bytes[64];
+    for (size_t i = 0; i < sizeof bytes; i++) {
+        bytes[i] = 'a';
+    }
+
     for (uint32_t value = 0;; value++) {
-        HAPAssert(HAPUTF8IsValidData(&value, sizeof value) == HAPUTF8IsValidDataRef(&value, sizeof value));
+        bool isValid = HAPUTF8IsValidDataRef(&value, sizeof value);
+        HAPAssert(HAPUTF8IsValidData(&value, sizeof value) == isValid);
+
+        // Crossing the blocks of the vectorized implementation, followed by more data.
+        HAPRawBufferCopyBytes(&bytes[30], &value, sizeof value);
+        HAPAssert(HAPUTF8IsValidData(bytes, sizeof bytes) == isValid);
+        HAPRawBufferCopyBytes(&bytes[30], "aaaa", sizeof value);
+
+        // Crossing the blocks of the vectorized implementation, at the end of the data.
+        HAPRawBufferCopyBytes(&bytes[14], &value, sizeof value);
+        HAPAssert(HAPUTF8IsValidData(bytes, 14 + sizeof value) == isValid);
+        HAPRawBufferCopyBytes(&bytes[14], "aaaa", sizeof value);
+
         if (value == UINT32_MAX) {
             break;
         }
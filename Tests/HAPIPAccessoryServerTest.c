@@ -0,0 +1,2743 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+#include "HAPPlatformTCPStreamManager+Init.h"
+#include "util_base64.h"
+
+#include "Harness/HAPBenchmark.c"
+#include "Harness/TemplateDB.c"
+
+/**
+ * Maximum length of the value of the large value characteristic.
+ * Exceeds both the scratch buffer and the outbound buffer.
+ */
+#define kMaxLargeValueBytes ((size_t) 256 * 1024)
+
+/**
+ * Maximum number of bytes of a HTTP response, including chunked transfer encoding overhead.
+ */
+#define kMaxResponseBytes (2 * util_base64_encoded_len(kMaxLargeValueBytes))
+
+/**
+ * Whether the accessory server completed its shutdown.
+ */
+static bool accessoryServerIsStopped;
+
+/**
+ * Number of requests with asynchronous handlers that have been cancelled.
+ */
+static size_t numCancelledRequests;
+
+/**
+ * Completion token of the most recent request that has been cancelled.
+ */
+static HAPCompletionToken cancelledCompletionToken;
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server, void* _Nullable context HAP_UNUSED) {
+    HAPPrecondition(server);
+
+    accessoryServerIsStopped = HAPAccessoryServerGetState(server) == kHAPAccessoryServerState_Idle;
+}
+
+static void HandleCancelledRequest(
+        HAPAccessoryServerRef* server,
+        HAPCompletionToken completionToken,
+        void* _Nullable context HAP_UNUSED) {
+    HAPPrecondition(server);
+    HAPPrecondition(completionToken != kHAPCompletionToken_None);
+
+    numCancelledRequests++;
+    cancelledCompletionToken = completionToken;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+static const HAPUUID kTestServiceType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                            0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x51 } };
+static const HAPUUID kLargeValueCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                         0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x52 } };
+static const HAPUUID kTimedValueCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                         0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x53 } };
+static const HAPUUID kAsynchronousValueCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                                0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x54 } };
+static const HAPUUID kCachedValueCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                          0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x55 } };
+static const HAPUUID kEventValueCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                         0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x56 } };
+
+/**
+ * Time to live of cached characteristic values in milliseconds.
+ */
+#define kValueCacheTTL ((HAPTime) 1000)
+
+/**
+ * Value of the large value characteristic.
+ */
+static uint8_t largeValue[kMaxLargeValueBytes];
+
+/**
+ * Length of the value of the large value characteristic.
+ */
+static size_t numLargeValueBytes;
+
+/**
+ * Maximum number of bytes that the streaming read handler returns per invocation.
+ */
+static size_t maxChunkBytes;
+
+/**
+ * Offset at which the streaming read handler fails.
+ */
+static size_t failingChunkOffset;
+
+/**
+ * Number of read requests that have been handled.
+ */
+static size_t numReadRequests;
+
+/**
+ * Number of streaming read requests that have been handled.
+ */
+static size_t numReadChunkRequests;
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLargeValueRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPDataCharacteristicReadRequest* request HAP_UNUSED,
+        void* valueBytes,
+        size_t maxValueBytes,
+        size_t* numValueBytes,
+        void* _Nullable context HAP_UNUSED) {
+    numReadRequests++;
+    if (failingChunkOffset == 0) {
+        return kHAPError_Busy;
+    }
+    if (numLargeValueBytes > maxValueBytes) {
+        return kHAPError_OutOfResources;
+    }
+    HAPRawBufferCopyBytes(valueBytes, largeValue, numLargeValueBytes);
+    *numValueBytes = numLargeValueBytes;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLargeValueReadChunk(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPDataCharacteristicReadRequest* request HAP_UNUSED,
+        size_t offset,
+        void* valueBytes,
+        size_t maxValueBytes,
+        size_t* numValueBytes,
+        bool* isComplete,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(offset <= numLargeValueBytes);
+    numReadChunkRequests++;
+    if (offset >= failingChunkOffset) {
+        return kHAPError_Busy;
+    }
+    *numValueBytes = HAPMin(HAPMin(numLargeValueBytes - offset, maxValueBytes), maxChunkBytes);
+    HAPRawBufferCopyBytes(valueBytes, &largeValue[offset], *numValueBytes);
+    *isComplete = offset + *numValueBytes == numLargeValueBytes;
+    return kHAPError_None;
+}
+
+/**
+ * Value that has last been written.
+ */
+static uint8_t writtenValue[kMaxLargeValueBytes];
+
+/**
+ * Length of the value that has last been written.
+ */
+static size_t numWrittenValueBytes;
+
+/**
+ * Number of write requests that have been handled.
+ */
+static size_t numWriteRequests;
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleLargeValueWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPDataCharacteristicWriteRequest* request HAP_UNUSED,
+        const void* valueBytes,
+        size_t numValueBytes,
+        void* _Nullable context HAP_UNUSED) {
+    HAPAssert(numValueBytes <= sizeof writtenValue);
+    numWriteRequests++;
+    HAPRawBufferCopyBytes(writtenValue, valueBytes, numValueBytes);
+    numWrittenValueBytes = numValueBytes;
+    return kHAPError_None;
+}
+
+static const HAPDataCharacteristic largeValueCharacteristic = {
+    .format = kHAPCharacteristicFormat_Data,
+    .iid = 0x0031,
+    .characteristicType = &kLargeValueCharacteristicType,
+    .debugDescription = "large value",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = true,
+                    .supportsEventNotification = false,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .constraints = { .maxLength = kMaxLargeValueBytes },
+    .callbacks = { .handleRead = HandleLargeValueRead,
+                   .handleWrite = HandleLargeValueWrite,
+                   .handleReadChunk = HandleLargeValueReadChunk }
+};
+
+static const HAPDataCharacteristic timedValueCharacteristic = {
+    .format = kHAPCharacteristicFormat_Data,
+    .iid = 0x0032,
+    .characteristicType = &kTimedValueCharacteristicType,
+    .debugDescription = "timed value",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = false,
+                    .writable = true,
+                    .supportsEventNotification = false,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = true,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .constraints = { .maxLength = kMaxLargeValueBytes },
+    .callbacks = { .handleWrite = HandleLargeValueWrite }
+};
+
+/**
+ * Value of the asynchronous value characteristic.
+ */
+static uint8_t asynchronousValue;
+
+/**
+ * Whether reads of the asynchronous value characteristic complete synchronously.
+ */
+static bool asynchronousValueIsReady;
+
+/**
+ * Error that is returned by writes of the asynchronous value characteristic.
+ */
+static HAPError asynchronousWriteError;
+
+/**
+ * Number of calls to the read handler of the asynchronous value characteristic.
+ */
+static size_t numAsynchronousReadRequests;
+
+/**
+ * Completion token of the most recent request that has been handled on the asynchronous value characteristic.
+ */
+static HAPCompletionToken asynchronousCompletionToken;
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleAsynchronousValueRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPUInt8CharacteristicReadRequest* request,
+        uint8_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    numAsynchronousReadRequests++;
+    asynchronousCompletionToken = request->completionToken;
+    if (!asynchronousValueIsReady) {
+        return kHAPError_InProgress;
+    }
+    *value = asynchronousValue;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleAsynchronousValueWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPUInt8CharacteristicWriteRequest* request,
+        uint8_t value,
+        void* _Nullable context HAP_UNUSED) {
+    numWriteRequests++;
+    asynchronousCompletionToken = request->completionToken;
+    asynchronousValue = value;
+    return asynchronousWriteError;
+}
+
+static const HAPUInt8Characteristic asynchronousValueCharacteristic = {
+    .format = kHAPCharacteristicFormat_UInt8,
+    .iid = 0x0033,
+    .characteristicType = &kAsynchronousValueCharacteristicType,
+    .debugDescription = "asynchronous value",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = true,
+                    .supportsEventNotification = false,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .units = kHAPCharacteristicUnits_None,
+    .constraints = { .minimumValue = 0,
+                     .maximumValue = UINT8_MAX,
+                     .stepValue = 1,
+                     .validValues = NULL,
+                     .validValuesRanges = NULL },
+    .callbacks = { .handleRead = HandleAsynchronousValueRead, .handleWrite = HandleAsynchronousValueWrite }
+};
+
+/**
+ * Value of the cached value characteristic.
+ */
+static uint8_t cachedValue;
+
+/**
+ * Number of read requests of the cached value characteristic that have been handled.
+ */
+static size_t numCachedValueReads;
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleCachedValueRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPUInt8CharacteristicReadRequest* request HAP_UNUSED,
+        uint8_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    numCachedValueReads++;
+    *value = cachedValue;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleCachedValueWrite(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPUInt8CharacteristicWriteRequest* request HAP_UNUSED,
+        uint8_t value,
+        void* _Nullable context HAP_UNUSED) {
+    cachedValue = value;
+    return kHAPError_None;
+}
+
+static const HAPUInt8Characteristic cachedValueCharacteristic = {
+    .format = kHAPCharacteristicFormat_UInt8,
+    .iid = 0x0034,
+    .characteristicType = &kCachedValueCharacteristicType,
+    .debugDescription = "cached value",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = true,
+                    .supportsEventNotification = false,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .cacheable = true,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .units = kHAPCharacteristicUnits_None,
+    .constraints = { .minimumValue = 0,
+                     .maximumValue = UINT8_MAX,
+                     .stepValue = 1,
+                     .validValues = NULL,
+                     .validValuesRanges = NULL },
+    .callbacks = { .handleRead = HandleCachedValueRead, .handleWrite = HandleCachedValueWrite }
+};
+
+/**
+ * Characteristics with event notifications. Their value is the value of the large value characteristic.
+ */
+static const HAPDataCharacteristic eventValueCharacteristics[] = {
+    { .format = kHAPCharacteristicFormat_Data,
+      .iid = 0x0035,
+      .characteristicType = &kEventValueCharacteristicType,
+      .debugDescription = "event value",
+      .manufacturerDescription = NULL,
+      .properties = { .readable = true,
+                      .writable = false,
+                      .supportsEventNotification = true,
+                      .hidden = false,
+                      .readRequiresAdminPermissions = false,
+                      .writeRequiresAdminPermissions = false,
+                      .requiresTimedWrite = false,
+                      .supportsAuthorizationData = false,
+                      .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                      .ble = { .supportsBroadcastNotification = false,
+                               .supportsDisconnectedNotification = false,
+                               .readableWithoutSecurity = false,
+                               .writableWithoutSecurity = false } },
+      .constraints = { .maxLength = kMaxLargeValueBytes },
+      .callbacks = { .handleRead = HandleLargeValueRead } },
+    { .format = kHAPCharacteristicFormat_Data,
+      .iid = 0x0036,
+      .characteristicType = &kEventValueCharacteristicType,
+      .debugDescription = "event value",
+      .manufacturerDescription = NULL,
+      .properties = { .readable = true,
+                      .writable = false,
+                      .supportsEventNotification = true,
+                      .hidden = false,
+                      .readRequiresAdminPermissions = false,
+                      .writeRequiresAdminPermissions = false,
+                      .requiresTimedWrite = false,
+                      .supportsAuthorizationData = false,
+                      .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                      .ble = { .supportsBroadcastNotification = false,
+                               .supportsDisconnectedNotification = false,
+                               .readableWithoutSecurity = false,
+                               .writableWithoutSecurity = false } },
+      .constraints = { .maxLength = kMaxLargeValueBytes },
+      .callbacks = { .handleRead = HandleLargeValueRead } }
+};
+
+static const HAPService testService = {
+    .iid = 0x0030,
+    .serviceType = &kTestServiceType,
+    .debugDescription = "test",
+    .name = NULL,
+    .properties = { .primaryService = true, .hidden = false, .ble = { .supportsConfiguration = false } },
+    .linkedServices = NULL,
+    .characteristics = (const HAPCharacteristic* const[]) { &largeValueCharacteristic,
+                                                             &timedValueCharacteristic,
+                                                             &asynchronousValueCharacteristic,
+                                                             &cachedValueCharacteristic,
+                                                             &eventValueCharacteristics[0],
+                                                             &eventValueCharacteristics[1],
+                                                             NULL }
+};
+
+static const HAPAccessory accessory = { .aid = 1,
+                                        .category = kHAPAccessoryCategory_Other,
+                                        .name = "Acme Test",
+                                        .manufacturer = "Acme",
+                                        .model = "Test1,1",
+                                        .serialNumber = "099DB48E9E28",
+                                        .firmwareVersion = "1",
+                                        .hardwareVersion = "1",
+                                        .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                  &hapProtocolInformationService,
+                                                                                  &pairingService,
+                                                                                  &testService,
+                                                                                  NULL },
+                                        .callbacks = { .identify = IdentifyAccessory } };
+
+static HAPAccessoryServerRef accessoryServer;
+
+/**
+ * Maximum number of IP sessions of the accessory server.
+ */
+#define kMaxIPSessions ((size_t) 256)
+
+/**
+ * Maximum number of pooled session buffers of the accessory server.
+ */
+#define kMaxPooledSessionBuffers ((size_t) 2)
+
+/**
+ * Number of IP sessions of the accessory server.
+ */
+static size_t numIPSessions = 2;
+
+/**
+ * Number of pooled session buffers of the accessory server.
+ * If 0, sessions use dedicated buffers. Otherwise, sessions only keep resident buffers.
+ */
+static size_t numPooledSessionBuffers;
+
+/**
+ * Number of bytes of session buffers that are configured for the accessory server.
+ */
+static size_t numSessionBufferBytes;
+
+/**
+ * Idle timeout of IP sessions on which Pair Verify has not been completed. 0 if not configured.
+ */
+static HAPTime unverifiedSessionIdleTimeout;
+
+/**
+ * Idle timeout of IP sessions on which Pair Verify has been completed. 0 if not configured.
+ */
+static HAPTime verifiedSessionIdleTimeout;
+
+/**
+ * Creates and starts an accessory server.
+ */
+static void StartAccessoryServer(void) {
+    HAPPrecondition(numIPSessions <= kMaxIPSessions);
+    HAPPrecondition(numPooledSessionBuffers <= kMaxPooledSessionBuffers);
+
+    static HAPIPSession ipSessions[kMaxIPSessions];
+    // PUT /characteristics requests with large values are parsed while they are received.
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][4096];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    numSessionBufferBytes = 0;
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        if (numPooledSessionBuffers) {
+            ipSessions[i].inboundBuffer.numBytes = kHAPIPSession_DefaultResidentBufferSize;
+            ipSessions[i].outboundBuffer.numBytes = kHAPIPSession_DefaultResidentBufferSize;
+        }
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+        if (i < numIPSessions) {
+            numSessionBufferBytes += ipSessions[i].inboundBuffer.numBytes + ipSessions[i].outboundBuffer.numBytes;
+        }
+    }
+    static HAPIPSessionBuffers pooledSessionBuffers[kMaxPooledSessionBuffers];
+    static uint8_t pooledInboundBuffers[kMaxPooledSessionBuffers][4096];
+    static uint8_t pooledOutboundBuffers[kMaxPooledSessionBuffers][kHAPIPSession_DefaultOutboundBufferSize];
+    for (size_t i = 0; i < numPooledSessionBuffers; i++) {
+        pooledSessionBuffers[i].inboundBuffer.bytes = pooledInboundBuffers[i];
+        pooledSessionBuffers[i].inboundBuffer.numBytes = sizeof pooledInboundBuffers[i];
+        pooledSessionBuffers[i].outboundBuffer.bytes = pooledOutboundBuffers[i];
+        pooledSessionBuffers[i].outboundBuffer.numBytes = sizeof pooledOutboundBuffers[i];
+        numSessionBufferBytes += sizeof pooledInboundBuffers[i] + sizeof pooledOutboundBuffers[i];
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static uint8_t ipWriteStagingBuffer[kMaxLargeValueBytes];
+    static HAPCharacteristicValueCacheElementRef valueCacheElements[1];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage;
+    ipAccessoryServerStorage = (HAPIPAccessoryServerStorage) {
+        .sessions = ipSessions,
+        .numSessions = numIPSessions,
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer },
+        .writeStagingBuffer = { .bytes = ipWriteStagingBuffer, .numBytes = sizeof ipWriteStagingBuffer },
+        .pooledSessionBuffers = numPooledSessionBuffers ? pooledSessionBuffers : NULL,
+        .numPooledSessionBuffers = numPooledSessionBuffers
+    };
+
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .valueCache = { .elements = valueCacheElements,
+                                    .numElements = HAPArrayCount(valueCacheElements),
+                                    .ttl = kValueCacheTTL },
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage,
+                            .sessionIdleTimeouts = { .unverifiedSession = unverifiedSessionIdleTimeout,
+                                                     .verifiedSession = verifiedSessionIdleTimeout } } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState,
+                                                   .handleCancelledRequest = HandleCancelledRequest },
+            /* context: */ NULL);
+
+    HAPAccessoryServerStart(&accessoryServer, &accessory);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+}
+
+/**
+ * Stops and releases the accessory server.
+ */
+static void StopAccessoryServer(void) {
+    accessoryServerIsStopped = false;
+    HAPAccessoryServerStop(&accessoryServer);
+
+    // Timers that are registered while processing expired timers only fire on the next clock advance.
+    for (size_t i = 0; !accessoryServerIsStopped; i++) {
+        HAPAssert(i < 8);
+        HAPPlatformClockAdvance(0);
+    }
+    HAPAccessoryServerRelease(&accessoryServer);
+}
+
+/**
+ * Controller side of a HAP-IP connection.
+ */
+typedef struct {
+    HAPPlatformTCPStreamRef tcpStream;
+
+    char identifier[sizeof "Controller-0"];
+    uint8_t ltsk[ED25519_SECRET_KEY_BYTES];
+    uint8_t ltpk[ED25519_PUBLIC_KEY_BYTES];
+
+    uint8_t cvSK[X25519_SCALAR_BYTES];
+    uint8_t cvPK[X25519_BYTES];
+    uint8_t accessoryCvPK[X25519_BYTES];
+    uint8_t sharedSecret[X25519_BYTES];
+    uint8_t sessionKey[CHACHA20_POLY1305_KEY_BYTES];
+
+    uint8_t controllerToAccessoryKey[CHACHA20_POLY1305_KEY_BYTES];
+    uint8_t accessoryToControllerKey[CHACHA20_POLY1305_KEY_BYTES];
+    uint64_t controllerToAccessoryNonce;
+    uint64_t accessoryToControllerNonce;
+    bool isSecured;
+
+    /** Received bytes that have not yet been decrypted. */
+    uint8_t encryptedBytes[2 * kHAPPlatformTCPStreamManager_NumBufferBytes];
+    size_t numEncryptedBytes;
+} TestController;
+
+/**
+ * Creates a controller with an admin pairing that is stored under key 0.
+ */
+static void CreateTestController(TestController* controller) {
+    HAPPrecondition(controller);
+
+    HAPError err;
+
+    HAPRawBufferZero(controller, sizeof *controller);
+    err = HAPStringWithFormat(controller->identifier, sizeof controller->identifier, "Controller-0");
+    HAPAssert(!err);
+    HAPPlatformRandomNumberFill(controller->ltsk, sizeof controller->ltsk);
+    HAP_ed25519_public_key(controller->ltpk, controller->ltsk);
+
+    size_t numIdentifierBytes = HAPStringGetNumBytes(controller->identifier);
+    uint8_t pairingBytes[sizeof(HAPPairingID) + sizeof(uint8_t) + sizeof(HAPPairingPublicKey) + sizeof(uint8_t)];
+    HAPRawBufferZero(pairingBytes, sizeof pairingBytes);
+    HAPRawBufferCopyBytes(&pairingBytes[0], controller->identifier, numIdentifierBytes);
+    pairingBytes[36] = (uint8_t) numIdentifierBytes;
+    HAPRawBufferCopyBytes(&pairingBytes[37], controller->ltpk, sizeof controller->ltpk);
+    pairingBytes[69] = 0x01;
+    err = HAPPlatformKeyValueStoreSet(
+            platform.keyValueStore,
+            kHAPKeyValueStoreDomain_Pairings,
+            /* key: */ 0,
+            pairingBytes,
+            sizeof pairingBytes);
+    HAPAssert(!err);
+}
+
+/**
+ * Sends bytes from a controller. The bytes are encrypted if the session is secured.
+ */
+static void SendBytes(TestController* controller, const void* bytes, size_t numBytes) {
+    HAPPrecondition(controller);
+    HAPPrecondition(bytes);
+
+    HAPError err;
+
+    for (size_t i = 0; i < numBytes;) {
+        uint8_t frameBytes[2 + kHAPIPSecurityProtocol_MaxFrameBytes + CHACHA20_POLY1305_TAG_BYTES];
+        size_t numPlaintextBytes = HAPMin(numBytes - i, kHAPIPSecurityProtocol_MaxFrameBytes);
+        size_t numFrameBytes;
+        if (controller->isSecured) {
+            HAPWriteLittleUInt16(&frameBytes[0], numPlaintextBytes);
+            uint8_t nonce[] = { HAPExpandLittleUInt64(controller->controllerToAccessoryNonce) };
+            HAP_chacha20_poly1305_encrypt_aad(
+                    &frameBytes[2 + numPlaintextBytes],
+                    &frameBytes[2],
+                    &((const uint8_t*) bytes)[i],
+                    numPlaintextBytes,
+                    frameBytes,
+                    2,
+                    nonce,
+                    sizeof nonce,
+                    controller->controllerToAccessoryKey);
+            controller->controllerToAccessoryNonce++;
+            numFrameBytes = 2 + numPlaintextBytes + CHACHA20_POLY1305_TAG_BYTES;
+        } else {
+            HAPRawBufferCopyBytes(frameBytes, &((const uint8_t*) bytes)[i], numPlaintextBytes);
+            numFrameBytes = numPlaintextBytes;
+        }
+        i += numPlaintextBytes;
+
+        for (size_t j = 0; j < numFrameBytes;) {
+            size_t n;
+            err = HAPPlatformTCPStreamClientWrite(
+                    HAPNonnull(platform.ip.tcpStreamManager),
+                    controller->tcpStream,
+                    &frameBytes[j],
+                    numFrameBytes - j,
+                    &n);
+            HAPAssert(!err);
+            j += n;
+        }
+    }
+}
+
+/**
+ * Receives bytes on a controller. The bytes are decrypted if the session is secured.
+ *
+ * @return kHAPError_None           If successful. If numBytes is 0, the accessory has closed the connection.
+ * @return kHAPError_Busy           If no data is available at the time.
+ */
+HAP_RESULT_USE_CHECK
+static HAPError ReceiveBytes(TestController* controller, uint8_t* bytes, size_t maxBytes, size_t* numBytes) {
+    HAPPrecondition(controller);
+    HAPPrecondition(bytes);
+    HAPPrecondition(numBytes);
+
+    HAPError err;
+
+    if (!controller->isSecured) {
+        return HAPPlatformTCPStreamClientRead(
+                HAPNonnull(platform.ip.tcpStreamManager), controller->tcpStream, bytes, maxBytes, numBytes);
+    }
+
+    for (;;) {
+        if (controller->numEncryptedBytes >= 2) {
+            size_t numFrameBytes = HAPReadLittleUInt16(controller->encryptedBytes);
+            HAPAssert(numFrameBytes <= kHAPIPSecurityProtocol_MaxFrameBytes);
+            HAPAssert(numFrameBytes <= maxBytes);
+            if (controller->numEncryptedBytes >= 2 + numFrameBytes + CHACHA20_POLY1305_TAG_BYTES) {
+                uint8_t nonce[] = { HAPExpandLittleUInt64(controller->accessoryToControllerNonce) };
+                int e = HAP_chacha20_poly1305_decrypt_aad(
+                        &controller->encryptedBytes[2 + numFrameBytes],
+                        bytes,
+                        &controller->encryptedBytes[2],
+                        numFrameBytes,
+                        controller->encryptedBytes,
+                        2,
+                        nonce,
+                        sizeof nonce,
+                        controller->accessoryToControllerKey);
+                HAPAssert(!e);
+                controller->accessoryToControllerNonce++;
+                size_t numConsumedBytes = 2 + numFrameBytes + CHACHA20_POLY1305_TAG_BYTES;
+                HAPRawBufferCopyBytes(
+                        controller->encryptedBytes,
+                        &controller->encryptedBytes[numConsumedBytes],
+                        controller->numEncryptedBytes - numConsumedBytes);
+                controller->numEncryptedBytes -= numConsumedBytes;
+                *numBytes = numFrameBytes;
+                return kHAPError_None;
+            }
+        }
+        size_t n;
+        err = HAPPlatformTCPStreamClientRead(
+                HAPNonnull(platform.ip.tcpStreamManager),
+                controller->tcpStream,
+                &controller->encryptedBytes[controller->numEncryptedBytes],
+                sizeof controller->encryptedBytes - controller->numEncryptedBytes,
+                &n);
+        if (err) {
+            HAPAssert(err == kHAPError_Busy);
+            return err;
+        }
+        if (!n) {
+            HAPAssert(!controller->numEncryptedBytes);
+            *numBytes = 0;
+            return kHAPError_None;
+        }
+        controller->numEncryptedBytes += n;
+    }
+}
+
+/**
+ * HTTP response received by a controller.
+ */
+typedef struct {
+    /** Status code. */
+    unsigned int status;
+
+    /** Whether the body used chunked transfer encoding. */
+    bool isChunked;
+
+    /** Body. Chunked transfer encoding is removed. */
+    char* body;
+
+    /** Length of body. */
+    size_t numBodyBytes;
+
+    /** Whether the accessory closed the connection. */
+    bool isClosed;
+
+    /** Whether the response is an EVENT message. */
+    bool isEvent;
+} TestResponse;
+
+/**
+ * Returns the offset of a string within a buffer.
+ */
+HAP_RESULT_USE_CHECK
+static size_t FindString(const char* bytes, size_t numBytes, const char* string) {
+    size_t numStringBytes = HAPStringGetNumBytes(string);
+    for (size_t i = 0; i + numStringBytes <= numBytes; i++) {
+        if (HAPRawBufferAreEqual(&bytes[i], string, numStringBytes)) {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+/**
+ * Tries to parse a complete HTTP response.
+ *
+ * @return true                     If the response is complete.
+ * @return false                    If more bytes are needed.
+ */
+HAP_RESULT_USE_CHECK
+static bool ParseResponse(char* bytes, size_t numBytes, TestResponse* response) {
+    size_t numHeaderBytes = FindString(bytes, numBytes, "\r\n\r\n");
+    if (numHeaderBytes == SIZE_MAX) {
+        return false;
+    }
+    numHeaderBytes += 4;
+    response->isEvent = HAPRawBufferAreEqual(bytes, "EVENT/1.0 ", 10);
+    HAPAssert(response->isEvent || HAPRawBufferAreEqual(bytes, "HTTP/1.1 ", 9));
+    const char* statusBytes = &bytes[response->isEvent ? 10 : 9];
+    response->status =
+            (unsigned int) ((statusBytes[0] - '0') * 100 + (statusBytes[1] - '0') * 10 + (statusBytes[2] - '0'));
+    response->isChunked = FindString(bytes, numHeaderBytes, "Transfer-Encoding: chunked\r\n") != SIZE_MAX;
+    response->body = &bytes[numHeaderBytes];
+
+    if (!response->isChunked) {
+        size_t i = FindString(bytes, numHeaderBytes, "Content-Length: ");
+        size_t numContentBytes = 0;
+        if (i != SIZE_MAX) {
+            for (i += 16; bytes[i] >= '0' && bytes[i] <= '9'; i++) {
+                numContentBytes = numContentBytes * 10 + (size_t)(bytes[i] - '0');
+            }
+        }
+        if (numBytes - numHeaderBytes < numContentBytes) {
+            return false;
+        }
+        response->numBodyBytes = numContentBytes;
+        return true;
+    }
+
+    // Remove chunked transfer encoding in place.
+    size_t i = numHeaderBytes;
+    response->numBodyBytes = 0;
+    for (;;) {
+        size_t numChunkBytes = 0;
+        for (; i < numBytes && bytes[i] != '\r'; i++) {
+            char c = bytes[i];
+            HAPAssert((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F'));
+            numChunkBytes = numChunkBytes * 16 + (size_t)(c <= '9' ? c - '0' : c - 'A' + 10);
+        }
+        if (numBytes - i < 2 + numChunkBytes + 2) {
+            return false;
+        }
+        HAPAssert(HAPRawBufferAreEqual(&bytes[i], "\r\n", 2));
+        i += 2;
+        HAPAssert(HAPRawBufferAreEqual(&bytes[i + numChunkBytes], "\r\n", 2));
+        HAPRawBufferCopyBytes(&response->body[response->numBodyBytes], &bytes[i], numChunkBytes);
+        response->numBodyBytes += numChunkBytes;
+        i += numChunkBytes + 2;
+        if (!numChunkBytes) {
+            return true;
+        }
+    }
+}
+
+/**
+ * Receives a HTTP response on a controller.
+ *
+ * - If the accessory closes the connection before the response is complete, the partial body is returned.
+ */
+static void ReceiveResponse(TestController* controller, TestResponse* response) {
+    HAPPrecondition(controller);
+    HAPPrecondition(response);
+
+    HAPError err;
+
+    static char bytes[kMaxResponseBytes];
+    size_t numBytes = 0;
+    HAPRawBufferZero(response, sizeof *response);
+    for (;;) {
+        static char parsedBytes[kMaxResponseBytes];
+        HAPRawBufferCopyBytes(parsedBytes, bytes, numBytes);
+        if (ParseResponse(parsedBytes, numBytes, response)) {
+            return;
+        }
+        size_t n;
+        err = ReceiveBytes(controller, (uint8_t*) &bytes[numBytes], sizeof bytes - numBytes, &n);
+        HAPAssert(!err);
+        if (!n) {
+            response->isClosed = true;
+            return;
+        }
+        numBytes += n;
+    }
+}
+
+/**
+ * Sends a HTTP request from a controller without receiving the response.
+ */
+static void StartRequest(
+        TestController* controller,
+        const char* method,
+        const char* uri,
+        const char* _Nullable contentType,
+        const void* _Nullable bodyBytes,
+        size_t numBodyBytes) {
+    HAPPrecondition(controller);
+    HAPPrecondition(method);
+    HAPPrecondition(uri);
+
+    HAPError err;
+
+    char bytes[1024];
+    if (contentType) {
+        err = HAPStringWithFormat(
+                bytes,
+                sizeof bytes,
+                "%s %s HTTP/1.1\r\nHost: AcmeTest._hap._tcp.local\r\nContent-Type: %s\r\nContent-Length: %zu\r\n\r\n",
+                method,
+                uri,
+                contentType,
+                numBodyBytes);
+    } else {
+        err = HAPStringWithFormat(
+                bytes, sizeof bytes, "%s %s HTTP/1.1\r\nHost: AcmeTest._hap._tcp.local\r\n\r\n", method, uri);
+    }
+    HAPAssert(!err);
+    size_t numBytes = HAPStringGetNumBytes(bytes);
+    HAPAssert(numBodyBytes <= sizeof bytes - numBytes);
+    if (numBodyBytes) {
+        HAPRawBufferCopyBytes(&bytes[numBytes], HAPNonnullVoid(bodyBytes), numBodyBytes);
+        numBytes += numBodyBytes;
+    }
+    SendBytes(controller, bytes, numBytes);
+}
+
+/**
+ * Sends a HTTP request from a controller and receives the response.
+ */
+static void SendRequest(
+        TestController* controller,
+        const char* method,
+        const char* uri,
+        const char* _Nullable contentType,
+        const void* _Nullable bodyBytes,
+        size_t numBodyBytes,
+        TestResponse* response) {
+    HAPPrecondition(response);
+
+    StartRequest(controller, method, uri, contentType, bodyBytes, numBodyBytes);
+    ReceiveResponse(controller, response);
+}
+
+/**
+ * Sends a HTTP request with a body that may exceed the inbound buffer of the accessory and receives the response.
+ */
+static void SendLargeRequest(
+        TestController* controller,
+        const char* method,
+        const char* uri,
+        const char* bodyBytes,
+        size_t numBodyBytes,
+        TestResponse* response) {
+    HAPPrecondition(controller);
+    HAPPrecondition(method);
+    HAPPrecondition(uri);
+    HAPPrecondition(bodyBytes);
+    HAPPrecondition(response);
+
+    HAPError err;
+
+    char bytes[256];
+    err = HAPStringWithFormat(
+            bytes,
+            sizeof bytes,
+            "%s %s HTTP/1.1\r\nHost: AcmeTest._hap._tcp.local\r\nContent-Type: application/hap+json\r\n"
+            "Content-Length: %zu\r\n\r\n",
+            method,
+            uri,
+            numBodyBytes);
+    HAPAssert(!err);
+    SendBytes(controller, bytes, HAPStringGetNumBytes(bytes));
+    SendBytes(controller, bodyBytes, numBodyBytes);
+    ReceiveResponse(controller, response);
+}
+
+/**
+ * Sends a Pair Verify request from a controller and returns the response TLVs.
+ */
+static void SendPairVerifyRequest(
+        TestController* controller,
+        const void* requestBytes,
+        size_t numRequestBytes,
+        TestResponse* response) {
+    SendRequest(
+            controller,
+            "POST",
+            "/pair-verify",
+            "application/pairing+tlv8",
+            requestBytes,
+            numRequestBytes,
+            response);
+    HAPAssert(response->status == 200);
+    HAPAssert(!response->isClosed);
+}
+
+/**
+ * Connects a controller and runs the first half of Pair Verify (M1 and M2).
+ */
+static void ConnectTestControllerAndStartPairVerify(TestController* controller) {
+    HAPPrecondition(controller);
+    HAPAccessoryServer* server = (HAPAccessoryServer*) &accessoryServer;
+
+    HAPError err;
+
+    err = HAPPlatformTCPStreamManagerConnectToListener(
+            HAPNonnull(platform.ip.tcpStreamManager), &controller->tcpStream);
+    HAPAssert(!err);
+    controller->isSecured = false;
+    controller->numEncryptedBytes = 0;
+    controller->controllerToAccessoryNonce = 0;
+    controller->accessoryToControllerNonce = 0;
+
+    // M1.
+    HAPPlatformRandomNumberFill(controller->cvSK, sizeof controller->cvSK);
+    HAP_X25519_scalarmult_base(controller->cvPK, controller->cvSK);
+    TestResponse response;
+    {
+        uint8_t bytes[64];
+        HAPTLVWriterRef writer;
+        HAPTLVWriterCreate(&writer, bytes, sizeof bytes);
+        err = HAPTLVWriterAppend(
+                &writer,
+                &(const HAPTLV) { .type = kHAPPairingTLVType_State,
+                                  .value = { .bytes = (const uint8_t[]) { 1 }, .numBytes = 1 } });
+        HAPAssert(!err);
+        err = HAPTLVWriterAppend(
+                &writer,
+                &(const HAPTLV) { .type = kHAPPairingTLVType_PublicKey,
+                                  .value = { .bytes = controller->cvPK, .numBytes = sizeof controller->cvPK } });
+        HAPAssert(!err);
+        void* requestBytes;
+        size_t numRequestBytes;
+        HAPTLVWriterGetBuffer(&writer, &requestBytes, &numRequestBytes);
+        SendPairVerifyRequest(controller, requestBytes, numRequestBytes, &response);
+    }
+
+    // M2.
+    HAPTLV stateTLV, publicKeyTLV, encryptedDataTLV;
+    stateTLV.type = kHAPPairingTLVType_State;
+    publicKeyTLV.type = kHAPPairingTLVType_PublicKey;
+    encryptedDataTLV.type = kHAPPairingTLVType_EncryptedData;
+    {
+        HAPTLVReaderRef reader;
+        HAPTLVReaderCreate(&reader, response.body, response.numBodyBytes);
+        err = HAPTLVReaderGetAll(&reader, (HAPTLV* const[]) { &stateTLV, &publicKeyTLV, &encryptedDataTLV, NULL });
+        HAPAssert(!err);
+    }
+    HAPAssert(stateTLV.value.numBytes == 1);
+    HAPAssert(((const uint8_t*) HAPNonnullVoid(stateTLV.value.bytes))[0] == 2);
+    HAPAssert(publicKeyTLV.value.numBytes == sizeof controller->accessoryCvPK);
+    HAPRawBufferCopyBytes(
+            controller->accessoryCvPK, HAPNonnullVoid(publicKeyTLV.value.bytes), sizeof controller->accessoryCvPK);
+    HAPAssert(encryptedDataTLV.value.numBytes >= CHACHA20_POLY1305_TAG_BYTES);
+
+    HAP_X25519_scalarmult(controller->sharedSecret, controller->cvSK, controller->accessoryCvPK);
+    {
+        static const uint8_t salt[] = "Pair-Verify-Encrypt-Salt";
+        static const uint8_t info[] = "Pair-Verify-Encrypt-Info";
+        HAP_hkdf_sha512(
+                controller->sessionKey,
+                sizeof controller->sessionKey,
+                controller->sharedSecret,
+                sizeof controller->sharedSecret,
+                salt,
+                sizeof salt - 1,
+                info,
+                sizeof info - 1);
+    }
+    uint8_t* encryptedBytes = (uint8_t*) (uintptr_t) HAPNonnullVoid(encryptedDataTLV.value.bytes);
+    size_t numEncryptedBytes = encryptedDataTLV.value.numBytes - CHACHA20_POLY1305_TAG_BYTES;
+    {
+        static const uint8_t nonce[] = "PV-Msg02";
+        int e = HAP_chacha20_poly1305_decrypt(
+                &encryptedBytes[numEncryptedBytes],
+                encryptedBytes,
+                encryptedBytes,
+                numEncryptedBytes,
+                nonce,
+                sizeof nonce - 1,
+                controller->sessionKey);
+        HAPAssert(!e);
+    }
+    HAPTLV identifierTLV, signatureTLV;
+    identifierTLV.type = kHAPPairingTLVType_Identifier;
+    signatureTLV.type = kHAPPairingTLVType_Signature;
+    {
+        HAPTLVReaderRef reader;
+        HAPTLVReaderCreate(&reader, encryptedBytes, numEncryptedBytes);
+        err = HAPTLVReaderGetAll(&reader, (HAPTLV* const[]) { &identifierTLV, &signatureTLV, NULL });
+        HAPAssert(!err);
+    }
+    HAPAssert(identifierTLV.value.numBytes <= sizeof(HAPDeviceIDString));
+    HAPAssert(signatureTLV.value.numBytes == ED25519_BYTES);
+    {
+        uint8_t infoBytes[X25519_BYTES + sizeof(HAPDeviceIDString) + X25519_BYTES];
+        size_t numInfoBytes = 0;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->accessoryCvPK, X25519_BYTES);
+        numInfoBytes += X25519_BYTES;
+        HAPRawBufferCopyBytes(
+                &infoBytes[numInfoBytes], HAPNonnullVoid(identifierTLV.value.bytes), identifierTLV.value.numBytes);
+        numInfoBytes += identifierTLV.value.numBytes;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->cvPK, X25519_BYTES);
+        numInfoBytes += X25519_BYTES;
+        int e = HAP_ed25519_verify(
+                HAPNonnullVoid(signatureTLV.value.bytes), infoBytes, numInfoBytes, server->identity.ed_LTPK);
+        HAPAssert(!e);
+    }
+}
+
+/**
+ * Runs the second half of Pair Verify (M3 and M4) to establish a secured session.
+ */
+static void FinishPairVerify(TestController* controller) {
+    HAPPrecondition(controller);
+
+    HAPError err;
+
+    // M3.
+    TestResponse response;
+    {
+        size_t numIdentifierBytes = HAPStringGetNumBytes(controller->identifier);
+        uint8_t subBytes[128];
+        HAPTLVWriterRef subWriter;
+        HAPTLVWriterCreate(&subWriter, subBytes, sizeof subBytes - CHACHA20_POLY1305_TAG_BYTES);
+        err = HAPTLVWriterAppend(
+                &subWriter,
+                &(const HAPTLV) { .type = kHAPPairingTLVType_Identifier,
+                                  .value = { .bytes = controller->identifier, .numBytes = numIdentifierBytes } });
+        HAPAssert(!err);
+        uint8_t infoBytes[X25519_BYTES + sizeof controller->identifier + X25519_BYTES];
+        size_t numInfoBytes = 0;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->cvPK, X25519_BYTES);
+        numInfoBytes += X25519_BYTES;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->identifier, numIdentifierBytes);
+        numInfoBytes += numIdentifierBytes;
+        HAPRawBufferCopyBytes(&infoBytes[numInfoBytes], controller->accessoryCvPK, X25519_BYTES);
+        numInfoBytes += X25519_BYTES;
+        uint8_t signature[ED25519_BYTES];
+        HAP_ed25519_sign(signature, infoBytes, numInfoBytes, controller->ltsk, controller->ltpk);
+        err = HAPTLVWriterAppend(
+                &subWriter,
+                &(const HAPTLV) { .type = kHAPPairingTLVType_Signature,
+                                  .value = { .bytes = signature, .numBytes = sizeof signature } });
+        HAPAssert(!err);
+        void* subTLVBytes;
+        size_t numSubTLVBytes;
+        HAPTLVWriterGetBuffer(&subWriter, &subTLVBytes, &numSubTLVBytes);
+        static const uint8_t nonce[] = "PV-Msg03";
+        HAP_chacha20_poly1305_encrypt(
+                &((uint8_t*) subTLVBytes)[numSubTLVBytes],
+                subTLVBytes,
+                subTLVBytes,
+                numSubTLVBytes,
+                nonce,
+                sizeof nonce - 1,
+                controller->sessionKey);
+        numSubTLVBytes += CHACHA20_POLY1305_TAG_BYTES;
+
+        uint8_t bytes[256];
+        HAPTLVWriterRef writer;
+        HAPTLVWriterCreate(&writer, bytes, sizeof bytes);
+        err = HAPTLVWriterAppend(
+                &writer,
+                &(const HAPTLV) { .type = kHAPPairingTLVType_State,
+                                  .value = { .bytes = (const uint8_t[]) { 3 }, .numBytes = 1 } });
+        HAPAssert(!err);
+        err = HAPTLVWriterAppend(
+                &writer,
+                &(const HAPTLV) { .type = kHAPPairingTLVType_EncryptedData,
+                                  .value = { .bytes = subTLVBytes, .numBytes = numSubTLVBytes } });
+        HAPAssert(!err);
+        void* requestBytes;
+        size_t numRequestBytes;
+        HAPTLVWriterGetBuffer(&writer, &requestBytes, &numRequestBytes);
+        SendPairVerifyRequest(controller, requestBytes, numRequestBytes, &response);
+    }
+
+    // M4.
+    HAPTLV stateTLV, errorTLV;
+    stateTLV.type = kHAPPairingTLVType_State;
+    errorTLV.type = kHAPPairingTLVType_Error;
+    {
+        HAPTLVReaderRef reader;
+        HAPTLVReaderCreate(&reader, response.body, response.numBodyBytes);
+        err = HAPTLVReaderGetAll(&reader, (HAPTLV* const[]) { &stateTLV, &errorTLV, NULL });
+        HAPAssert(!err);
+    }
+    HAPAssert(stateTLV.value.numBytes == 1);
+    HAPAssert(((const uint8_t*) HAPNonnullVoid(stateTLV.value.bytes))[0] == 4);
+    HAPAssert(!errorTLV.value.bytes);
+
+    static const uint8_t salt[] = "Control-Salt";
+    {
+        static const uint8_t info[] = "Control-Write-Encryption-Key";
+        HAP_hkdf_sha512(
+                controller->controllerToAccessoryKey,
+                sizeof controller->controllerToAccessoryKey,
+                controller->sharedSecret,
+                sizeof controller->sharedSecret,
+                salt,
+                sizeof salt - 1,
+                info,
+                sizeof info - 1);
+    }
+    {
+        static const uint8_t info[] = "Control-Read-Encryption-Key";
+        HAP_hkdf_sha512(
+                controller->accessoryToControllerKey,
+                sizeof controller->accessoryToControllerKey,
+                controller->sharedSecret,
+                sizeof controller->sharedSecret,
+                salt,
+                sizeof salt - 1,
+                info,
+                sizeof info - 1);
+    }
+    controller->isSecured = true;
+}
+
+/**
+ * Connects a controller and runs Pair Verify to establish a secured session.
+ */
+static void ConnectTestController(TestController* controller) {
+    HAPPrecondition(controller);
+
+    ConnectTestControllerAndStartPairVerify(controller);
+    FinishPairVerify(controller);
+}
+
+/**
+ * Disconnects a controller.
+ */
+static void DisconnectTestController(TestController* controller) {
+    HAPPrecondition(controller);
+
+    HAPPlatformTCPStreamManagerClientClose(HAPNonnull(platform.ip.tcpStreamManager), controller->tcpStream);
+    HAPPlatformClockAdvance(0);
+}
+
+/**
+ * Sends a GET /characteristics request for the large value characteristic without receiving the response.
+ */
+static void StartLargeValueRead(TestController* controller, const char* parameters) {
+    HAPPrecondition(controller);
+    HAPPrecondition(parameters);
+
+    HAPError err;
+
+    char uri[64];
+    err = HAPStringWithFormat(
+            uri,
+            sizeof uri,
+            "/characteristics?id=%llu.%llu%s",
+            (unsigned long long) accessory.aid,
+            (unsigned long long) largeValueCharacteristic.iid,
+            parameters);
+    HAPAssert(!err);
+    StartRequest(controller, "GET", uri, /* contentType: */ NULL, /* bodyBytes: */ NULL, 0);
+}
+
+/**
+ * Reads the large value characteristic with a GET /characteristics request.
+ */
+static void ReadLargeValue(TestController* controller, const char* parameters, TestResponse* response) {
+    HAPPrecondition(controller);
+    HAPPrecondition(parameters);
+    HAPPrecondition(response);
+
+    StartLargeValueRead(controller, parameters);
+    ReceiveResponse(controller, response);
+}
+
+/**
+ * Returns the expected body of a successful read of the large value characteristic.
+ */
+HAP_RESULT_USE_CHECK
+static size_t GetExpectedBody(char* bytes, size_t maxBytes) {
+    HAPError err;
+
+    err = HAPStringWithFormat(
+            bytes,
+            maxBytes,
+            "{\"characteristics\":[{\"aid\":%llu,\"iid\":%llu,\"value\":\"",
+            (unsigned long long) accessory.aid,
+            (unsigned long long) largeValueCharacteristic.iid);
+    HAPAssert(!err);
+    size_t numBytes = HAPStringGetNumBytes(bytes);
+    size_t numEncodedBytes;
+    util_base64_encode(largeValue, numLargeValueBytes, &bytes[numBytes], maxBytes - numBytes, &numEncodedBytes);
+    numBytes += numEncodedBytes;
+    HAPAssert(maxBytes - numBytes >= 4);
+    HAPRawBufferCopyBytes(&bytes[numBytes], "\"}]}", 4);
+    numBytes += 4;
+    return numBytes;
+}
+
+static void TestStreamingReads(void) {
+    static char expectedBody[kMaxResponseBytes];
+
+    HAPPlatformRandomNumberFill(largeValue, sizeof largeValue);
+
+    StartAccessoryServer();
+    TestController controller;
+    CreateTestController(&controller);
+    ConnectTestController(&controller);
+
+    // Values of any length are streamed, independent of the chunk sizes returned by the read handler.
+    static const size_t valueLengths[] = { 0, 1, 2, 3, 4, 767, 768, 769, 4096, 32 * 1024, kMaxLargeValueBytes };
+    static const size_t chunkLengths[] = { 1, 2, 1000, SIZE_MAX };
+    failingChunkOffset = SIZE_MAX;
+    for (size_t i = 0; i < HAPArrayCount(valueLengths); i++) {
+        for (size_t j = 0; j < HAPArrayCount(chunkLengths); j++) {
+            if (chunkLengths[j] < 1000 && valueLengths[i] > 32 * 1024) {
+                continue;
+            }
+            numLargeValueBytes = valueLengths[i];
+            maxChunkBytes = chunkLengths[j];
+            numReadRequests = 0;
+            numReadChunkRequests = 0;
+
+            TestResponse response;
+            ReadLargeValue(&controller, "", &response);
+            HAPAssert(response.status == 200);
+            HAPAssert(response.isChunked);
+            HAPAssert(!response.isClosed);
+            size_t numExpectedBytes = GetExpectedBody(expectedBody, sizeof expectedBody);
+            HAPAssert(response.numBodyBytes == numExpectedBytes);
+            HAPAssert(HAPRawBufferAreEqual(response.body, expectedBody, numExpectedBytes));
+            HAPAssert(!numReadRequests);
+            HAPAssert(numReadChunkRequests);
+        }
+    }
+
+    // Reads with additional parameters use the regular read handler.
+    numLargeValueBytes = 16;
+    numReadRequests = 0;
+    numReadChunkRequests = 0;
+    {
+        TestResponse response;
+        ReadLargeValue(&controller, "&type=1", &response);
+        HAPAssert(response.status == 200);
+        HAPAssert(!response.isChunked);
+        HAPAssert(numReadRequests == 1);
+        HAPAssert(!numReadChunkRequests);
+    }
+
+    // Errors while reading the first chunk are reported with a regular response.
+    failingChunkOffset = 0;
+    numReadRequests = 0;
+    {
+        TestResponse response;
+        ReadLargeValue(&controller, "", &response);
+        HAPAssert(response.status == 207);
+        HAPAssert(!response.isChunked);
+        HAPAssert(!response.isClosed);
+        HAPAssert(numReadRequests == 1);
+    }
+
+    // Errors after the response was started close the connection without terminating the response.
+    numLargeValueBytes = kMaxLargeValueBytes;
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = 64 * 1024;
+    {
+        TestResponse response;
+        ReadLargeValue(&controller, "", &response);
+        HAPAssert(response.status == 200);
+        HAPAssert(response.isChunked);
+        HAPAssert(response.isClosed);
+    }
+    DisconnectTestController(&controller);
+
+    // The accessory server accepts new connections afterwards.
+    failingChunkOffset = SIZE_MAX;
+    numLargeValueBytes = 4096;
+    ConnectTestController(&controller);
+    {
+        TestResponse response;
+        ReadLargeValue(&controller, "", &response);
+        HAPAssert(response.status == 200);
+        size_t numExpectedBytes = GetExpectedBody(expectedBody, sizeof expectedBody);
+        HAPAssert(response.numBodyBytes == numExpectedBytes);
+        HAPAssert(HAPRawBufferAreEqual(response.body, expectedBody, numExpectedBytes));
+    }
+    DisconnectTestController(&controller);
+
+    StopAccessoryServer();
+}
+
+/**
+ * Serializes a PUT /characteristics request that writes a prefix of the large value to a characteristic.
+ *
+ * @param      bytes                Buffer to serialize the request body into.
+ * @param      maxBytes             Capacity of @p bytes.
+ * @param      characteristic       Characteristic to write.
+ * @param      numValueBytes        Number of bytes of the large value to write.
+ * @param      isValueFirst         Whether "value" precedes "aid" and "iid".
+ * @param      requestPrefix        Members of the request object before the "characteristics" array.
+ * @param      requestSuffix        Members of the request object after the "characteristics" array.
+ *
+ * @return Length of the request body.
+ */
+HAP_RESULT_USE_CHECK
+static size_t GetWriteRequestBody(
+        char* bytes,
+        size_t maxBytes,
+        const HAPDataCharacteristic* characteristic,
+        size_t numValueBytes,
+        bool isValueFirst,
+        const char* requestPrefix,
+        const char* requestSuffix) {
+    HAPError err;
+
+    static char encodedBytes[util_base64_encoded_len(kMaxLargeValueBytes)];
+    size_t numEncodedBytes;
+    util_base64_encode(largeValue, numValueBytes, encodedBytes, sizeof encodedBytes, &numEncodedBytes);
+
+    char idBytes[64];
+    err = HAPStringWithFormat(
+            idBytes,
+            sizeof idBytes,
+            "\"aid\":%llu,\"iid\":%llu",
+            (unsigned long long) accessory.aid,
+            (unsigned long long) characteristic->iid);
+    HAPAssert(!err);
+    err = HAPStringWithFormat(
+            bytes,
+            maxBytes,
+            "{%s\"characteristics\":[{%s%s\"value\":\"",
+            requestPrefix,
+            isValueFirst ? "" : idBytes,
+            isValueFirst ? "" : ",");
+    HAPAssert(!err);
+    size_t numBytes = HAPStringGetNumBytes(bytes);
+
+    // Slashes are escaped to cover unescaping while the value is received.
+    for (size_t i = 0; i < numEncodedBytes; i++) {
+        HAPAssert(maxBytes - numBytes >= 2);
+        if (encodedBytes[i] == '/') {
+            bytes[numBytes++] = '\\';
+        }
+        bytes[numBytes++] = encodedBytes[i];
+    }
+    err = HAPStringWithFormat(
+            &bytes[numBytes],
+            maxBytes - numBytes,
+            "\"%s%s}]%s}",
+            isValueFirst ? "," : "",
+            isValueFirst ? idBytes : "",
+            requestSuffix);
+    HAPAssert(!err);
+    return numBytes + HAPStringGetNumBytes(&bytes[numBytes]);
+}
+
+static void TestStreamingWrites(void) {
+    static char body[kMaxResponseBytes];
+
+    HAPPlatformRandomNumberFill(largeValue, sizeof largeValue);
+
+    StartAccessoryServer();
+    TestController controller;
+    CreateTestController(&controller);
+    ConnectTestController(&controller);
+
+    // Values are decoded while they are received, or staged and decoded once the characteristic is known.
+    static const size_t valueLengths[] = { 3 * 1024, 64 * 1024, kMaxLargeValueBytes };
+    for (size_t i = 0; i < HAPArrayCount(valueLengths); i++) {
+        for (size_t j = 0; j < 2; j++) {
+            bool isValueFirst = j == 1;
+            if (isValueFirst && valueLengths[i] == kMaxLargeValueBytes) {
+                continue;
+            }
+            numWriteRequests = 0;
+            size_t numBodyBytes = GetWriteRequestBody(
+                    body, sizeof body, &largeValueCharacteristic, valueLengths[i], isValueFirst, "", "");
+            TestResponse response;
+            SendLargeRequest(&controller, "PUT", "/characteristics", body, numBodyBytes, &response);
+            HAPAssert(response.status == 204);
+            HAPAssert(!response.isClosed);
+            HAPAssert(numWriteRequests == 1);
+            HAPAssert(numWrittenValueBytes == valueLengths[i]);
+            HAPAssert(HAPRawBufferAreEqual(writtenValue, largeValue, valueLengths[i]));
+        }
+    }
+
+    // Staged values that do not fit into the staging buffer are rejected.
+    numWriteRequests = 0;
+    {
+        size_t numBodyBytes = GetWriteRequestBody(
+                body,
+                sizeof body,
+                &largeValueCharacteristic,
+                kMaxLargeValueBytes,
+                /* isValueFirst: */ true,
+                "",
+                "");
+        TestResponse response;
+        SendLargeRequest(&controller, "PUT", "/characteristics", body, numBodyBytes, &response);
+        HAPAssert(response.status == 207);
+        HAPAssert(!response.isClosed);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"status\":-70407") != SIZE_MAX);
+        HAPAssert(!numWriteRequests);
+    }
+
+    // Characteristics that require timed writes reject standard writes.
+    {
+        size_t numBodyBytes = GetWriteRequestBody(
+                body,
+                sizeof body,
+                &timedValueCharacteristic,
+                64 * 1024,
+                /* isValueFirst: */ false,
+                "",
+                "");
+        TestResponse response;
+        SendLargeRequest(&controller, "PUT", "/characteristics", body, numBodyBytes, &response);
+        HAPAssert(response.status == 207);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"status\":-70410") != SIZE_MAX);
+        HAPAssert(!numWriteRequests);
+    }
+
+    // Timed writes are executed if the PID matches the prepared timed write, even if it follows the write requests.
+    static const char prepareBody[] = "{\"ttl\":10000,\"pid\":42}";
+    for (size_t i = 0; i < 2; i++) {
+        bool isPIDValid = i == 0;
+        TestResponse response;
+        SendRequest(
+                &controller,
+                "PUT",
+                "/prepare",
+                "application/hap+json",
+                prepareBody,
+                sizeof prepareBody - 1,
+                &response);
+        HAPAssert(response.status == 200);
+
+        numWriteRequests = 0;
+        size_t numBodyBytes = GetWriteRequestBody(
+                body,
+                sizeof body,
+                &timedValueCharacteristic,
+                64 * 1024,
+                /* isValueFirst: */ false,
+                isPIDValid ? "" : "\"pid\":43,",
+                isPIDValid ? ",\"pid\":42" : "");
+        SendLargeRequest(&controller, "PUT", "/characteristics", body, numBodyBytes, &response);
+        if (isPIDValid) {
+            HAPAssert(response.status == 204);
+            HAPAssert(numWriteRequests == 1);
+            HAPAssert(numWrittenValueBytes == 64 * 1024);
+            HAPAssert(HAPRawBufferAreEqual(writtenValue, largeValue, numWrittenValueBytes));
+        } else {
+            HAPAssert(response.status == 207);
+            HAPAssert(FindString(response.body, response.numBodyBytes, "\"status\":-70410") != SIZE_MAX);
+            HAPAssert(!numWriteRequests);
+        }
+    }
+
+    // While a timed write is prepared, write requests to characteristics that do not require timed writes are
+    // handled without waiting for the PID.
+    {
+        TestResponse response;
+        SendRequest(
+                &controller,
+                "PUT",
+                "/prepare",
+                "application/hap+json",
+                prepareBody,
+                sizeof prepareBody - 1,
+                &response);
+        HAPAssert(response.status == 200);
+
+        static char writeRequestBody[kMaxResponseBytes];
+        size_t numWriteRequestBodyBytes = GetWriteRequestBody(
+                writeRequestBody,
+                sizeof writeRequestBody,
+                &largeValueCharacteristic,
+                16 * 1024,
+                /* isValueFirst: */ false,
+                "",
+                ",\"pid\":42");
+        size_t writeRequestStart = FindString(writeRequestBody, numWriteRequestBodyBytes, "[") + 1;
+        size_t writeRequestEnd = FindString(writeRequestBody, numWriteRequestBodyBytes, "]");
+        HAPAssert(writeRequestEnd < numWriteRequestBodyBytes);
+        size_t numWriteRequestBytes = writeRequestEnd - writeRequestStart;
+        size_t numBodyBytes = 0;
+        HAPRawBufferCopyBytes(&body[numBodyBytes], writeRequestBody, writeRequestEnd);
+        numBodyBytes += writeRequestEnd;
+        body[numBodyBytes++] = ',';
+        HAPRawBufferCopyBytes(&body[numBodyBytes], &writeRequestBody[writeRequestStart], numWriteRequestBytes);
+        numBodyBytes += numWriteRequestBytes;
+        HAPRawBufferCopyBytes(
+                &body[numBodyBytes],
+                &writeRequestBody[writeRequestEnd],
+                numWriteRequestBodyBytes - writeRequestEnd);
+        numBodyBytes += numWriteRequestBodyBytes - writeRequestEnd;
+
+        numWriteRequests = 0;
+        SendLargeRequest(&controller, "PUT", "/characteristics", body, numBodyBytes, &response);
+        HAPAssert(response.status == 204);
+        HAPAssert(numWriteRequests == 2);
+        HAPAssert(numWrittenValueBytes == 16 * 1024);
+        HAPAssert(HAPRawBufferAreEqual(writtenValue, largeValue, numWrittenValueBytes));
+    }
+
+    // Malformed requests are rejected once they have been received completely.
+    {
+        size_t numBodyBytes = GetWriteRequestBody(
+                body,
+                sizeof body,
+                &largeValueCharacteristic,
+                64 * 1024,
+                /* isValueFirst: */ false,
+                "\"characteristics\":{},",
+                "");
+        TestResponse response;
+        SendLargeRequest(&controller, "PUT", "/characteristics", body, numBodyBytes, &response);
+        HAPAssert(response.status == 400);
+        HAPAssert(!response.isClosed);
+    }
+
+    // Write requests that precede the malformed part of a request have already been handled.
+    // Their status is reported.
+    {
+        numWriteRequests = 0;
+        size_t numBodyBytes = GetWriteRequestBody(
+                body,
+                sizeof body,
+                &largeValueCharacteristic,
+                64 * 1024,
+                /* isValueFirst: */ false,
+                "",
+                ",\"pid\":{}");
+        TestResponse response;
+        SendLargeRequest(&controller, "PUT", "/characteristics", body, numBodyBytes, &response);
+        HAPAssert(response.status == 207);
+        HAPAssert(!response.isClosed);
+        HAPAssert(numWriteRequests == 1);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"status\":0") != SIZE_MAX);
+    }
+    {
+        static char writeRequestBody[kMaxResponseBytes];
+        size_t numWriteRequestBodyBytes = GetWriteRequestBody(
+                writeRequestBody,
+                sizeof writeRequestBody,
+                &largeValueCharacteristic,
+                16 * 1024,
+                /* isValueFirst: */ false,
+                "",
+                "");
+        size_t writeRequestEnd = FindString(writeRequestBody, numWriteRequestBodyBytes, "]");
+        HAPAssert(writeRequestEnd < numWriteRequestBodyBytes);
+        static const char malformedWriteRequest[] = ",{\"aid\":1,";
+        size_t numBodyBytes = 0;
+        HAPRawBufferCopyBytes(&body[numBodyBytes], writeRequestBody, writeRequestEnd);
+        numBodyBytes += writeRequestEnd;
+        HAPRawBufferCopyBytes(&body[numBodyBytes], malformedWriteRequest, sizeof malformedWriteRequest - 1);
+        numBodyBytes += sizeof malformedWriteRequest - 1;
+        HAPRawBufferCopyBytes(
+                &body[numBodyBytes],
+                &writeRequestBody[writeRequestEnd],
+                numWriteRequestBodyBytes - writeRequestEnd);
+        numBodyBytes += numWriteRequestBodyBytes - writeRequestEnd;
+
+        numWriteRequests = 0;
+        numWrittenValueBytes = 0;
+        TestResponse response;
+        SendLargeRequest(&controller, "PUT", "/characteristics", body, numBodyBytes, &response);
+        HAPAssert(response.status == 207);
+        HAPAssert(!response.isClosed);
+        HAPAssert(numWriteRequests == 1);
+        HAPAssert(numWrittenValueBytes == 16 * 1024);
+        char expectedBytes[64];
+        HAPError err = HAPStringWithFormat(
+                expectedBytes,
+                sizeof expectedBytes,
+                "{\"characteristics\":[{\"aid\":%llu,\"iid\":%llu,\"status\":0}]}",
+                (unsigned long long) accessory.aid,
+                (unsigned long long) largeValueCharacteristic.iid);
+        HAPAssert(!err);
+        HAPAssert(response.numBodyBytes == HAPStringGetNumBytes(expectedBytes));
+        HAPAssert(HAPRawBufferAreEqual(response.body, expectedBytes, response.numBodyBytes));
+    }
+
+    // The session remains usable.
+    numLargeValueBytes = 4096;
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+    {
+        TestResponse response;
+        ReadLargeValue(&controller, "", &response);
+        HAPAssert(response.status == 200);
+    }
+    DisconnectTestController(&controller);
+
+    StopAccessoryServer();
+}
+
+/**
+ * Asserts that no response is available on a controller.
+ */
+static void AssertNoResponse(TestController* controller) {
+    HAPPrecondition(controller);
+
+    uint8_t bytes[kHAPIPSecurityProtocol_MaxFrameBytes];
+    size_t numBytes;
+    HAPError err = ReceiveBytes(controller, bytes, sizeof bytes, &numBytes);
+    HAPAssert(err == kHAPError_Busy);
+}
+
+/**
+ * Writes the asynchronous value characteristic with a PUT /characteristics request without receiving the response.
+ */
+static void StartAsynchronousValueWrite(TestController* controller, uint8_t value) {
+    HAPPrecondition(controller);
+
+    HAPError err;
+
+    char body[128];
+    err = HAPStringWithFormat(
+            body,
+            sizeof body,
+            "{\"characteristics\":[{\"aid\":%llu,\"iid\":%llu,\"value\":%u}]}",
+            (unsigned long long) accessory.aid,
+            (unsigned long long) asynchronousValueCharacteristic.iid,
+            value);
+    HAPAssert(!err);
+    StartRequest(controller, "PUT", "/characteristics", "application/hap+json", body, HAPStringGetNumBytes(body));
+}
+
+static void TestAsynchronousRequests(void) {
+    HAPError err;
+
+    StartAccessoryServer();
+    TestController controller;
+    CreateTestController(&controller);
+    ConnectTestController(&controller);
+    TestController otherController = controller;
+    ConnectTestController(&otherController);
+
+    char uri[64];
+    err = HAPStringWithFormat(
+            uri,
+            sizeof uri,
+            "/characteristics?id=%llu.%llu",
+            (unsigned long long) accessory.aid,
+            (unsigned long long) asynchronousValueCharacteristic.iid);
+    HAPAssert(!err);
+
+    // Pending reads do not block other sessions.
+    asynchronousValueIsReady = false;
+    numAsynchronousReadRequests = 0;
+    asynchronousCompletionToken = kHAPCompletionToken_None;
+    StartRequest(&controller, "GET", uri, /* contentType: */ NULL, /* bodyBytes: */ NULL, 0);
+    AssertNoResponse(&controller);
+    HAPCompletionToken completionToken = asynchronousCompletionToken;
+    HAPAssert(completionToken != kHAPCompletionToken_None);
+    numLargeValueBytes = 16;
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+    {
+        TestResponse response;
+        ReadLargeValue(&otherController, "", &response);
+        HAPAssert(response.status == 200);
+    }
+
+    // Reads may be pending on several sessions at the same time. They are completed in any order.
+    StartRequest(&otherController, "GET", uri, /* contentType: */ NULL, /* bodyBytes: */ NULL, 0);
+    AssertNoResponse(&otherController);
+    HAPCompletionToken otherCompletionToken = asynchronousCompletionToken;
+    HAPAssert(otherCompletionToken != kHAPCompletionToken_None);
+    HAPAssert(otherCompletionToken != completionToken);
+    HAPAccessoryServerCompleteRead(
+            &accessoryServer, otherCompletionToken, kHAPError_Busy, /* valueBytes: */ NULL, 0);
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&otherController, &response);
+        HAPAssert(response.status == 207);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"status\":-70403") != SIZE_MAX);
+    }
+    AssertNoResponse(&controller);
+
+    // The read is answered with the value that is passed to the completion. The read handler is not called again.
+    uint8_t value = 7;
+    HAPAccessoryServerCompleteRead(&accessoryServer, completionToken, kHAPError_None, &value, sizeof value);
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 200);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"value\":7") != SIZE_MAX);
+    }
+    HAPAssert(numAsynchronousReadRequests == 2);
+
+    // Values of other reads are kept while other sessions read. Completions of earlier requests are ignored.
+    {
+        char multipleUri[96];
+        err = HAPStringWithFormat(
+                multipleUri,
+                sizeof multipleUri,
+                "/characteristics?id=%llu.%llu,%llu.%llu",
+                (unsigned long long) accessory.aid,
+                (unsigned long long) largeValueCharacteristic.iid,
+                (unsigned long long) accessory.aid,
+                (unsigned long long) asynchronousValueCharacteristic.iid);
+        HAPAssert(!err);
+        char expectedValue[64];
+        size_t numExpectedValueBytes;
+        HAPRawBufferCopyBytes(largeValue, "0123456789abcdef", numLargeValueBytes);
+        util_base64_encode(largeValue, numLargeValueBytes, expectedValue, sizeof expectedValue, &numExpectedValueBytes);
+        numReadRequests = 0;
+        StartRequest(&controller, "GET", multipleUri, /* contentType: */ NULL, /* bodyBytes: */ NULL, 0);
+        AssertNoResponse(&controller);
+        HAPAssert(numReadRequests == 1);
+        HAPCompletionToken earlierCompletionToken = completionToken;
+        completionToken = asynchronousCompletionToken;
+        HAPAssert(completionToken != earlierCompletionToken);
+
+        largeValue[0] = 'X';
+        err = HAPStringWithFormat(
+                multipleUri,
+                sizeof multipleUri,
+                "/characteristics?id=%llu.%llu,%llu.%llu",
+                (unsigned long long) accessory.aid,
+                (unsigned long long) largeValueCharacteristic.iid,
+                (unsigned long long) accessory.aid,
+                (unsigned long long) largeValueCharacteristic.iid);
+        HAPAssert(!err);
+        {
+            TestResponse response;
+            SendRequest(
+                    &otherController, "GET", multipleUri, /* contentType: */ NULL, /* bodyBytes: */ NULL, 0, &response);
+            HAPAssert(response.status == 200);
+        }
+        HAPAssert(numReadRequests == 3);
+
+        value = 9;
+        HAPAccessoryServerCompleteRead(&accessoryServer, earlierCompletionToken, kHAPError_None, &value, sizeof value);
+        HAPPlatformClockAdvance(0);
+        AssertNoResponse(&controller);
+
+        value = 8;
+        HAPAccessoryServerCompleteRead(&accessoryServer, completionToken, kHAPError_None, &value, sizeof value);
+        HAPPlatformClockAdvance(0);
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 200);
+        HAPAssert(numReadRequests == 3);
+        HAPAssert(numAsynchronousReadRequests == 3);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"value\":8") != SIZE_MAX);
+        expectedValue[numExpectedValueBytes] = '\0';
+        HAPAssert(FindString(response.body, response.numBodyBytes, expectedValue) != SIZE_MAX);
+    }
+
+    // Writes of other sessions are handled while a write is pending.
+    asynchronousWriteError = kHAPError_InProgress;
+    numWriteRequests = 0;
+    StartAsynchronousValueWrite(&controller, 9);
+    AssertNoResponse(&controller);
+    HAPAssert(numWriteRequests == 1);
+    HAPAssert(asynchronousValue == 9);
+    HAPCompletionToken writeCompletionToken = asynchronousCompletionToken;
+    StartAsynchronousValueWrite(&otherController, 10);
+    AssertNoResponse(&otherController);
+    HAPAssert(numWriteRequests == 2);
+    HAPAssert(asynchronousValue == 10);
+    HAPAssert(asynchronousCompletionToken != writeCompletionToken);
+    completionToken = asynchronousCompletionToken;
+
+    HAPAccessoryServerCompleteWrite(&accessoryServer, writeCompletionToken, kHAPError_None);
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 204);
+    }
+    HAPPlatformClockAdvance(0);
+    AssertNoResponse(&otherController);
+
+    // Errors of completed writes are reported in a multi-status response.
+    HAPAccessoryServerCompleteWrite(&accessoryServer, completionToken, kHAPError_Busy);
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&otherController, &response);
+        HAPAssert(response.status == 207);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"status\":-70403") != SIZE_MAX);
+    }
+
+    // Writes that are not completed in time are reported as busy and cancelled. Later completions are ignored.
+    numCancelledRequests = 0;
+    StartAsynchronousValueWrite(&controller, 11);
+    AssertNoResponse(&controller);
+    completionToken = asynchronousCompletionToken;
+    HAPPlatformClockAdvance(9 * HAPSecond);
+    AssertNoResponse(&controller);
+    HAPAssert(!numCancelledRequests);
+    HAPPlatformClockAdvance(1 * HAPSecond);
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 207);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"status\":-70403") != SIZE_MAX);
+    }
+    HAPAssert(numCancelledRequests == 1);
+    HAPAssert(cancelledCompletionToken == completionToken);
+    HAPAccessoryServerCompleteWrite(&accessoryServer, completionToken, kHAPError_None);
+    HAPPlatformClockAdvance(0);
+    AssertNoResponse(&controller);
+
+    asynchronousWriteError = kHAPError_None;
+    DisconnectTestController(&controller);
+    DisconnectTestController(&otherController);
+    StopAccessoryServer();
+
+    // Requests are cancelled when their session is closed. Later completions are ignored.
+    verifiedSessionIdleTimeout = 5 * HAPSecond;
+    StartAccessoryServer();
+    ConnectTestController(&controller);
+    asynchronousValueIsReady = false;
+    numCancelledRequests = 0;
+    StartRequest(&controller, "GET", uri, /* contentType: */ NULL, /* bodyBytes: */ NULL, 0);
+    AssertNoResponse(&controller);
+    completionToken = asynchronousCompletionToken;
+    ConnectTestController(&otherController);
+    HAPPlatformClockAdvance(verifiedSessionIdleTimeout);
+    HAPAssert(numCancelledRequests == 1);
+    HAPAssert(cancelledCompletionToken == completionToken);
+    value = 12;
+    HAPAccessoryServerCompleteRead(&accessoryServer, completionToken, kHAPError_None, &value, sizeof value);
+    HAPPlatformClockAdvance(0);
+    asynchronousValueIsReady = true;
+    DisconnectTestController(&controller);
+    DisconnectTestController(&otherController);
+    StopAccessoryServer();
+    verifiedSessionIdleTimeout = 0;
+}
+
+/**
+ * Reads the cached value characteristic and checks the value and the number of calls to the read handler.
+ */
+static void CheckCachedValue(TestController* controller, uint8_t expectedValue, size_t expectedNumReads) {
+    HAPPrecondition(controller);
+
+    HAPError err;
+
+    char uri[64];
+    err = HAPStringWithFormat(
+            uri,
+            sizeof uri,
+            "/characteristics?id=%llu.%llu",
+            (unsigned long long) accessory.aid,
+            (unsigned long long) cachedValueCharacteristic.iid);
+    HAPAssert(!err);
+    char expectedValueBytes[16];
+    err = HAPStringWithFormat(expectedValueBytes, sizeof expectedValueBytes, "\"value\":%u}", expectedValue);
+    HAPAssert(!err);
+
+    TestResponse response;
+    SendRequest(controller, "GET", uri, /* contentType: */ NULL, /* bodyBytes: */ NULL, 0, &response);
+    HAPAssert(response.status == 200);
+    HAPAssert(FindString(response.body, response.numBodyBytes, expectedValueBytes) != SIZE_MAX);
+    HAPAssert(numCachedValueReads == expectedNumReads);
+}
+
+static void TestValueCache(void) {
+    StartAccessoryServer();
+    TestController controller;
+    CreateTestController(&controller);
+    ConnectTestController(&controller);
+    TestController otherController = controller;
+    ConnectTestController(&otherController);
+
+    // Repeated reads are served from the cache, also for other sessions.
+    cachedValue = 3;
+    numCachedValueReads = 0;
+    CheckCachedValue(&controller, 3, 1);
+    CheckCachedValue(&controller, 3, 1);
+    CheckCachedValue(&otherController, 3, 1);
+    HAPCharacteristicValueCacheStatistics statistics;
+    HAPAccessoryServerGetCharacteristicValueCacheStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numHits == 2);
+    HAPAssert(statistics.numMisses == 1);
+
+    // Raising an event invalidates the cached value.
+    cachedValue = 4;
+    CheckCachedValue(&controller, 3, 1);
+    HAPAccessoryServerRaiseEvent(&accessoryServer, &cachedValueCharacteristic, &testService, &accessory);
+    CheckCachedValue(&controller, 4, 2);
+
+    // Writing invalidates the cached value.
+    {
+        static const char body[] = "{\"characteristics\":[{\"aid\":1,\"iid\":52,\"value\":5}]}";
+        TestResponse response;
+        SendRequest(
+                &otherController,
+                "PUT",
+                "/characteristics",
+                "application/hap+json",
+                body,
+                sizeof body - 1,
+                &response);
+        HAPAssert(response.status == 204);
+    }
+    CheckCachedValue(&controller, 5, 3);
+
+    // Cached values expire once their time to live has passed.
+    cachedValue = 6;
+    HAPPlatformClockAdvance(kValueCacheTTL - 1);
+    CheckCachedValue(&controller, 5, 3);
+    HAPPlatformClockAdvance(1);
+    CheckCachedValue(&controller, 6, 4);
+
+    HAPAccessoryServerGetCharacteristicValueCacheStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numHits == 4);
+    HAPAssert(statistics.numMisses == 4);
+
+    DisconnectTestController(&controller);
+    DisconnectTestController(&otherController);
+
+    StopAccessoryServer();
+}
+
+/**
+ * Raises an event on an event value characteristic.
+ */
+static void RaiseEventValueEvent(size_t index) {
+    HAPPrecondition(index < HAPArrayCount(eventValueCharacteristics));
+
+    HAPAccessoryServerRaiseEvent(&accessoryServer, &eventValueCharacteristics[index], &testService, &accessory);
+}
+
+/**
+ * Receives an EVENT message and checks which event value characteristics it contains.
+ */
+static void ReceiveEventValueEvent(TestController* controller, bool containsFirst, bool containsSecond) {
+    HAPPrecondition(controller);
+
+    TestResponse response;
+    ReceiveResponse(controller, &response);
+    HAPAssert(response.isEvent);
+    HAPAssert(response.status == 200);
+    HAPAssert((FindString(response.body, response.numBodyBytes, "\"iid\":53,") != SIZE_MAX) == containsFirst);
+    HAPAssert((FindString(response.body, response.numBodyBytes, "\"iid\":54,") != SIZE_MAX) == containsSecond);
+}
+
+static void TestEventNotificationQueue(void) {
+    HAPPlatformRandomNumberFill(largeValue, sizeof largeValue);
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+
+    StartAccessoryServer();
+    TestController controller;
+    CreateTestController(&controller);
+    ConnectTestController(&controller);
+    {
+        static const char body[] =
+                "{\"characteristics\":[{\"aid\":1,\"iid\":53,\"ev\":true},{\"aid\":1,\"iid\":54,\"ev\":true}]}";
+        TestResponse response;
+        SendRequest(
+                &controller,
+                "PUT",
+                "/characteristics",
+                "application/hap+json",
+                body,
+                sizeof body - 1,
+                &response);
+        HAPAssert(response.status == 204);
+    }
+    HAPIPEventNotificationStatistics statistics;
+
+    // Events that do not fit into the outbound buffer together are sent in consecutive EVENT messages.
+    numLargeValueBytes = 12200;
+    HAPPlatformClockAdvance(1000);
+    RaiseEventValueEvent(0);
+    RaiseEventValueEvent(1);
+    HAPAccessoryServerGetIPEventNotificationStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numQueuedEvents == 2);
+    HAPAssert(statistics.maxQueuedEvents == 2);
+    HAPPlatformClockAdvance(0);
+    ReceiveEventValueEvent(&controller, /* containsFirst: */ true, /* containsSecond: */ false);
+    ReceiveEventValueEvent(&controller, /* containsFirst: */ false, /* containsSecond: */ true);
+    HAPAccessoryServerGetIPEventNotificationStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numQueuedEvents == 0);
+    HAPAssert(statistics.numDeferredEvents == 1);
+    HAPAssert(!statistics.numDroppedEvents);
+
+    // Events that do not fit into an empty outbound buffer are dropped.
+    numLargeValueBytes = 24500;
+    RaiseEventValueEvent(0);
+    HAPPlatformClockAdvance(1000);
+    AssertNoResponse(&controller);
+    HAPAccessoryServerGetIPEventNotificationStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numQueuedEvents == 0);
+    HAPAssert(statistics.numDeferredEvents == 1);
+    HAPAssert(statistics.numDroppedEvents == 1);
+
+    // Later events are still sent.
+    numLargeValueBytes = 16;
+    RaiseEventValueEvent(1);
+    HAPPlatformClockAdvance(1000);
+    ReceiveEventValueEvent(&controller, /* containsFirst: */ false, /* containsSecond: */ true);
+
+    DisconnectTestController(&controller);
+
+    StopAccessoryServer();
+}
+
+/**
+ * Subscribes a controller to events of the first event value characteristic.
+ */
+static void SubscribeToEventValue(TestController* controller) {
+    HAPPrecondition(controller);
+
+    static const char body[] = "{\"characteristics\":[{\"aid\":1,\"iid\":53,\"ev\":true}]}";
+    TestResponse response;
+    SendRequest(controller, "PUT", "/characteristics", "application/hap+json", body, sizeof body - 1, &response);
+    HAPAssert(response.status == 204);
+}
+
+static void TestSessionBufferPool(void) {
+    HAPError err;
+
+    HAPPlatformRandomNumberFill(largeValue, sizeof largeValue);
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+
+    numPooledSessionBuffers = 1;
+    StartAccessoryServer();
+    TestController controller;
+    CreateTestController(&controller);
+    ConnectTestController(&controller);
+    TestController otherController = controller;
+    ConnectTestController(&otherController);
+    HAPIPSessionBufferPoolStatistics statistics;
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(!statistics.numBorrowedBuffers);
+    HAPAssert(statistics.maxBorrowedBuffers == 1);
+    HAPAssert(statistics.numBorrows);
+    HAPAssert(!statistics.numWaits);
+
+    // Requests wait while the pooled buffers are lent to another session.
+    numLargeValueBytes = 8 * 1024;
+    StartLargeValueRead(&controller, "");
+    StartLargeValueRead(&otherController, "");
+    AssertNoResponse(&otherController);
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numBorrowedBuffers == 1);
+    HAPAssert(statistics.numWaits == 1);
+    {
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 200);
+    }
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&otherController, &response);
+        HAPAssert(response.status == 200);
+    }
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(!statistics.numBorrowedBuffers);
+    HAPAssert(statistics.maxBorrowedBuffers == 1);
+
+    // Request headers that exceed the resident inbound buffer are received into the pooled buffers.
+    {
+        static char bytes[3 * kHAPIPSession_DefaultResidentBufferSize / 2];
+        err = HAPStringWithFormat(
+                bytes,
+                sizeof bytes,
+                "GET /characteristics?id=%llu.%llu HTTP/1.1\r\nHost: AcmeTest._hap._tcp.local\r\nX-Padding: ",
+                (unsigned long long) accessory.aid,
+                (unsigned long long) largeValueCharacteristic.iid);
+        HAPAssert(!err);
+        size_t numBytes = HAPStringGetNumBytes(bytes);
+        for (; numBytes < sizeof bytes - 4; numBytes++) {
+            bytes[numBytes] = 'a';
+        }
+        HAPRawBufferCopyBytes(&bytes[sizeof bytes - 4], "\r\n\r\n", 4);
+        SendBytes(&controller, bytes, sizeof bytes);
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 200);
+    }
+
+    // Small events are sent from the resident outbound buffer without borrowing pooled buffers.
+    SubscribeToEventValue(&otherController);
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    uint64_t numBorrows = statistics.numBorrows;
+    numLargeValueBytes = 16;
+    HAPPlatformClockAdvance(1000);
+    RaiseEventValueEvent(0);
+    HAPPlatformClockAdvance(0);
+    ReceiveEventValueEvent(&otherController, /* containsFirst: */ true, /* containsSecond: */ false);
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numBorrows == numBorrows);
+
+    // Sessions that wait for asynchronous handlers return the pooled buffers if their request fits into the resident
+    // buffers. Other sessions borrow them in the meantime.
+    asynchronousWriteError = kHAPError_InProgress;
+    numWriteRequests = 0;
+    StartAsynchronousValueWrite(&controller, 1);
+    AssertNoResponse(&controller);
+    HAPAssert(numWriteRequests == 1);
+    HAPCompletionToken completionToken = asynchronousCompletionToken;
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(!statistics.numBorrowedBuffers);
+    numLargeValueBytes = kHAPIPSession_DefaultResidentBufferSize;
+    HAPPlatformClockAdvance(1000);
+    RaiseEventValueEvent(0);
+    HAPPlatformClockAdvance(0);
+    ReceiveEventValueEvent(&otherController, /* containsFirst: */ true, /* containsSecond: */ false);
+    {
+        TestResponse response;
+        ReadLargeValue(&otherController, "", &response);
+        HAPAssert(response.status == 200);
+    }
+    HAPAccessoryServerCompleteWrite(&accessoryServer, completionToken, kHAPError_None);
+    asynchronousWriteError = kHAPError_None;
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 204);
+    }
+    HAPAssert(numWriteRequests == 1);
+
+    // Read contexts are moved along with the request.
+    char uri[64];
+    err = HAPStringWithFormat(
+            uri,
+            sizeof uri,
+            "/characteristics?id=%llu.%llu",
+            (unsigned long long) accessory.aid,
+            (unsigned long long) asynchronousValueCharacteristic.iid);
+    HAPAssert(!err);
+    asynchronousValueIsReady = false;
+    StartRequest(&controller, "GET", uri, /* contentType: */ NULL, /* bodyBytes: */ NULL, 0);
+    AssertNoResponse(&controller);
+    completionToken = asynchronousCompletionToken;
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(!statistics.numBorrowedBuffers);
+    numLargeValueBytes = 8 * 1024;
+    {
+        TestResponse response;
+        ReadLargeValue(&otherController, "", &response);
+        HAPAssert(response.status == 200);
+    }
+    asynchronousValue = 12;
+    asynchronousValueIsReady = true;
+    HAPAccessoryServerCompleteRead(
+            &accessoryServer, completionToken, kHAPError_None, &asynchronousValue, sizeof asynchronousValue);
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 200);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"value\":12") != SIZE_MAX);
+    }
+
+    // Sessions whose request does not fit into the resident buffers keep the pooled buffers while they wait.
+    // Small events are sent from the resident outbound buffer in the meantime.
+    asynchronousValueIsReady = false;
+    {
+        static char bytes[3 * kHAPIPSession_DefaultResidentBufferSize / 2];
+        err = HAPStringWithFormat(
+                bytes, sizeof bytes, "GET %s HTTP/1.1\r\nHost: AcmeTest._hap._tcp.local\r\nX-Padding: ", uri);
+        HAPAssert(!err);
+        size_t numBytes = HAPStringGetNumBytes(bytes);
+        for (; numBytes < sizeof bytes - 4; numBytes++) {
+            bytes[numBytes] = 'a';
+        }
+        HAPRawBufferCopyBytes(&bytes[sizeof bytes - 4], "\r\n\r\n", 4);
+        SendBytes(&controller, bytes, sizeof bytes);
+    }
+    AssertNoResponse(&controller);
+    completionToken = asynchronousCompletionToken;
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(statistics.numBorrowedBuffers == 1);
+    numLargeValueBytes = 16;
+    HAPPlatformClockAdvance(1000);
+    RaiseEventValueEvent(0);
+    HAPPlatformClockAdvance(0);
+    ReceiveEventValueEvent(&otherController, /* containsFirst: */ true, /* containsSecond: */ false);
+
+    // Larger events wait until the pooled buffers are returned.
+    numLargeValueBytes = kHAPIPSession_DefaultResidentBufferSize;
+    HAPPlatformClockAdvance(1000);
+    RaiseEventValueEvent(0);
+    HAPPlatformClockAdvance(0);
+    AssertNoResponse(&otherController);
+    asynchronousValue = 13;
+    asynchronousValueIsReady = true;
+    HAPAccessoryServerCompleteRead(
+            &accessoryServer, completionToken, kHAPError_None, &asynchronousValue, sizeof asynchronousValue);
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 200);
+        HAPAssert(FindString(response.body, response.numBodyBytes, "\"value\":13") != SIZE_MAX);
+    }
+    HAPPlatformClockAdvance(0);
+    ReceiveEventValueEvent(&otherController, /* containsFirst: */ true, /* containsSecond: */ false);
+    HAPIPEventNotificationStatistics eventNotificationStatistics;
+    HAPAccessoryServerGetIPEventNotificationStatistics(&accessoryServer, &eventNotificationStatistics);
+    HAPAssert(!eventNotificationStatistics.numDroppedEvents);
+
+    DisconnectTestController(&controller);
+    DisconnectTestController(&otherController);
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(!statistics.numBorrowedBuffers);
+
+    StopAccessoryServer();
+    numPooledSessionBuffers = 0;
+}
+
+static void TestMovedWriteContexts(void) {
+    HAPError err;
+
+    HAPPlatformRandomNumberFill(largeValue, sizeof largeValue);
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+
+    numPooledSessionBuffers = 2;
+    StartAccessoryServer();
+    TestController controller;
+    CreateTestController(&controller);
+    ConnectTestController(&controller);
+    TestController otherController = controller;
+    ConnectTestController(&otherController);
+
+    // The write of the large value is handled once the asynchronous write has been completed.
+    asynchronousWriteError = kHAPError_InProgress;
+    numWriteRequests = 0;
+    {
+        char body[256];
+        err = HAPStringWithFormat(
+                body,
+                sizeof body,
+                "{\"characteristics\":[{\"aid\":%llu,\"iid\":%llu,\"value\":1},"
+                "{\"aid\":%llu,\"iid\":%llu,\"value\":\"MDEyMzQ1Njc4OWFiY2RlZg==\"}]}",
+                (unsigned long long) accessory.aid,
+                (unsigned long long) asynchronousValueCharacteristic.iid,
+                (unsigned long long) accessory.aid,
+                (unsigned long long) largeValueCharacteristic.iid);
+        HAPAssert(!err);
+        StartRequest(&controller, "PUT", "/characteristics", "application/hap+json", body, HAPStringGetNumBytes(body));
+    }
+    AssertNoResponse(&controller);
+    HAPAssert(numWriteRequests == 1);
+    HAPCompletionToken completionToken = asynchronousCompletionToken;
+
+    // Another session overwrites the pooled buffers that have been returned and keeps them.
+    // The resumed request borrows the other pooled buffers.
+    numLargeValueBytes = 8 * 1024;
+    {
+        static char bytes[kHAPIPSession_DefaultResidentBufferSize / 2];
+        err = HAPStringWithFormat(
+                bytes,
+                sizeof bytes,
+                "GET /characteristics?id=%llu.%llu HTTP/1.1\r\nHost: AcmeTest._hap._tcp.local\r\nX-Padding: ",
+                (unsigned long long) accessory.aid,
+                (unsigned long long) largeValueCharacteristic.iid);
+        HAPAssert(!err);
+        size_t numBytes = HAPStringGetNumBytes(bytes);
+        for (; numBytes < sizeof bytes - 4; numBytes++) {
+            bytes[numBytes] = 'a';
+        }
+        HAPRawBufferCopyBytes(&bytes[sizeof bytes - 4], "\r\n\r\n", 4);
+        SendBytes(&otherController, bytes, sizeof bytes);
+    }
+    HAPAccessoryServerCompleteWrite(&accessoryServer, completionToken, kHAPError_None);
+    asynchronousWriteError = kHAPError_None;
+    HAPPlatformClockAdvance(0);
+    {
+        TestResponse response;
+        ReceiveResponse(&controller, &response);
+        HAPAssert(response.status == 204);
+    }
+    HAPAssert(numWriteRequests == 2);
+    HAPAssert(numWrittenValueBytes == 16);
+    HAPAssert(HAPRawBufferAreEqual(writtenValue, "0123456789abcdef", 16));
+    {
+        TestResponse response;
+        ReceiveResponse(&otherController, &response);
+        HAPAssert(response.status == 200);
+    }
+
+    DisconnectTestController(&controller);
+    DisconnectTestController(&otherController);
+    HAPIPSessionBufferPoolStatistics statistics;
+    HAPAccessoryServerGetIPSessionBufferPoolStatistics(&accessoryServer, &statistics);
+    HAPAssert(!statistics.numBorrowedBuffers);
+    HAPAssert(statistics.maxBorrowedBuffers == 2);
+
+    StopAccessoryServer();
+    numPooledSessionBuffers = 0;
+}
+
+/**
+ * Number of request rounds of the session buffer pool benchmark.
+ */
+#define kNumBenchmarkRounds ((size_t) 100)
+
+/**
+ * Compares request rates and buffer memory of dedicated session buffers and a session buffer pool.
+ *
+ * - Every connection reads a value whose response exceeds the TCP stream buffers of the mock transport,
+ *   so the pooled buffers stay lent until the controller receives the response.
+ */
+static void BenchmarkSessionBufferPool(void) {
+    HAPError err;
+
+    HAPPlatformRandomNumberFill(largeValue, sizeof largeValue);
+    numLargeValueBytes = 8 * 1024;
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+
+    static const size_t numConnectionsValues[] = { 1, 4, 8 };
+    static TestController controllers[8];
+    for (size_t i = 0; i < HAPArrayCount(numConnectionsValues); i++) {
+        size_t numConnections = numConnectionsValues[i];
+        HAPAssert(numConnections <= HAPArrayCount(controllers));
+        for (size_t numBuffers = 0; numBuffers <= kMaxPooledSessionBuffers; numBuffers += kMaxPooledSessionBuffers) {
+            numIPSessions = numConnections;
+            numPooledSessionBuffers = numBuffers;
+            StartAccessoryServer();
+            CreateTestController(&controllers[0]);
+            ConnectTestController(&controllers[0]);
+            for (size_t j = 1; j < numConnections; j++) {
+                controllers[j] = controllers[0];
+                ConnectTestController(&controllers[j]);
+            }
+
+            HAPBenchmarkTimer timer;
+            HAPBenchmarkStart(&timer);
+            for (size_t round = 0; round < kNumBenchmarkRounds; round++) {
+                for (size_t j = 0; j < numConnections; j++) {
+                    StartLargeValueRead(&controllers[j], "");
+                }
+                for (size_t j = 0; j < numConnections; j++) {
+                    HAPPlatformClockAdvance(0);
+                    TestResponse response;
+                    ReceiveResponse(&controllers[j], &response);
+                    HAPAssert(response.status == 200);
+                }
+            }
+            uint64_t elapsedNanoseconds = HAPBenchmarkGetElapsedNanoseconds(&timer);
+
+            char name[64];
+            err = HAPStringWithFormat(
+                    name,
+                    sizeof name,
+                    "GET /characteristics (%zu connections, %zu pooled buffers)",
+                    numConnections,
+                    numBuffers);
+            HAPAssert(!err);
+            HAPBenchmarkLogRate(name, kNumBenchmarkRounds * numConnections, elapsedNanoseconds);
+            HAPLog(&logObject, "%s: %zu bytes of session buffers.", name, numSessionBufferBytes);
+
+            for (size_t j = 0; j < numConnections; j++) {
+                DisconnectTestController(&controllers[j]);
+            }
+            StopAccessoryServer();
+        }
+    }
+    numIPSessions = 2;
+    numPooledSessionBuffers = 0;
+}
+
+/**
+ * Number of events of the session table benchmark.
+ */
+#define kNumBenchmarkEvents ((size_t) 10)
+
+static void TestManySessions(void) {
+    HAPPlatformRandomNumberFill(largeValue, sizeof largeValue);
+    numLargeValueBytes = 16;
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+
+    numIPSessions = kMaxIPSessions;
+    numPooledSessionBuffers = kMaxPooledSessionBuffers;
+    StartAccessoryServer();
+    static TestController controllers[kMaxIPSessions];
+    CreateTestController(&controllers[0]);
+    ConnectTestController(&controllers[0]);
+    for (size_t i = 1; i < HAPArrayCount(controllers); i++) {
+        controllers[i] = controllers[0];
+        ConnectTestController(&controllers[i]);
+    }
+
+    // Requests of a single session do not depend on the number of idle sessions.
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRounds; i++) {
+        TestResponse response;
+        ReadLargeValue(&controllers[i % HAPArrayCount(controllers)], "", &response);
+        HAPAssert(response.status == 200);
+    }
+    HAPBenchmarkLogRate(
+            "GET /characteristics (256 sessions)", kNumBenchmarkRounds, HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    // Events are sent to all subscribed sessions.
+    for (size_t i = 0; i < HAPArrayCount(controllers); i++) {
+        SubscribeToEventValue(&controllers[i]);
+    }
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkEvents; i++) {
+        HAPPlatformClockAdvance(1000);
+        RaiseEventValueEvent(0);
+        HAPPlatformClockAdvance(0);
+        for (size_t j = 0; j < HAPArrayCount(controllers); j++) {
+            ReceiveEventValueEvent(&controllers[j], /* containsFirst: */ true, /* containsSecond: */ false);
+        }
+    }
+    HAPBenchmarkLogRate(
+            "EVENT (256 sessions)",
+            kNumBenchmarkEvents * HAPArrayCount(controllers),
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+    HAPIPEventNotificationStatistics statistics;
+    HAPAccessoryServerGetIPEventNotificationStatistics(&accessoryServer, &statistics);
+    HAPAssert(!statistics.numQueuedEvents);
+    HAPAssert(!statistics.numDroppedEvents);
+
+    // Sessions of closed connections are reused.
+    for (size_t i = 0; i < HAPArrayCount(controllers); i += 2) {
+        DisconnectTestController(&controllers[i]);
+    }
+    HAPPlatformClockAdvance(0);
+    for (size_t i = 0; i < HAPArrayCount(controllers); i += 2) {
+        ConnectTestController(&controllers[i]);
+    }
+    for (size_t i = 0; i < HAPArrayCount(controllers); i++) {
+        TestResponse response;
+        ReadLargeValue(&controllers[i], "", &response);
+        HAPAssert(response.status == 200);
+    }
+
+    // Events are only sent to sessions that are still subscribed.
+    HAPPlatformClockAdvance(1000);
+    RaiseEventValueEvent(0);
+    HAPPlatformClockAdvance(0);
+    for (size_t i = 0; i < HAPArrayCount(controllers); i++) {
+        if (i % 2) {
+            ReceiveEventValueEvent(&controllers[i], /* containsFirst: */ true, /* containsSecond: */ false);
+        } else {
+            AssertNoResponse(&controllers[i]);
+        }
+    }
+
+    for (size_t i = 0; i < HAPArrayCount(controllers); i++) {
+        DisconnectTestController(&controllers[i]);
+    }
+    StopAccessoryServer();
+    numIPSessions = 2;
+    numPooledSessionBuffers = 0;
+}
+
+/**
+ * Connects a controller without performing Pair Verify.
+ */
+static void ConnectUnverifiedTestController(TestController* controller) {
+    HAPPrecondition(controller);
+
+    HAPError err;
+
+    err = HAPPlatformTCPStreamManagerConnectToListener(
+            HAPNonnull(platform.ip.tcpStreamManager), &controller->tcpStream);
+    HAPAssert(!err);
+    controller->isSecured = false;
+    controller->numEncryptedBytes = 0;
+}
+
+/**
+ * Asserts that the accessory has closed the connection of a controller.
+ */
+static void AssertClosed(TestController* controller) {
+    HAPPrecondition(controller);
+
+    uint8_t bytes[kHAPIPSecurityProtocol_MaxFrameBytes];
+    size_t numBytes;
+    HAPError err = ReceiveBytes(controller, bytes, sizeof bytes, &numBytes);
+    HAPAssert(!err);
+    HAPAssert(!numBytes);
+}
+
+static void TestSessionAdmission(void) {
+    HAPError err;
+
+    numLargeValueBytes = 16;
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+
+    unverifiedSessionIdleTimeout = 5 * HAPSecond;
+    StartAccessoryServer();
+    HAPAssert(numIPSessions == 2);
+    TestController subscribedController;
+    CreateTestController(&subscribedController);
+    ConnectTestController(&subscribedController);
+    SubscribeToEventValue(&subscribedController);
+    HAPPlatformClockAdvance(1000);
+    TestController idleController = subscribedController;
+    ConnectTestController(&idleController);
+    TestController unverifiedController = subscribedController;
+
+    // If Pair Verify has been completed on all sessions, idle sessions without subscriptions are evicted.
+    // Sessions with subscriptions are not evicted, even if they have been inactive for longer.
+    ConnectUnverifiedTestController(&unverifiedController);
+    AssertClosed(&idleController);
+    DisconnectTestController(&idleController);
+    {
+        TestResponse response;
+        ReadLargeValue(&subscribedController, "", &response);
+        HAPAssert(response.status == 200);
+    }
+
+    // Sessions on which Pair Verify has not been completed are evicted first.
+    HAPPlatformClockAdvance(1000);
+    ConnectTestController(&idleController);
+    AssertClosed(&unverifiedController);
+    DisconnectTestController(&unverifiedController);
+
+    // This also applies if an idle session without subscriptions has been inactive for longer.
+    DisconnectTestController(&subscribedController);
+    HAPPlatformClockAdvance(1000);
+    ConnectUnverifiedTestController(&unverifiedController);
+    HAPPlatformClockAdvance(1000);
+    ConnectTestController(&subscribedController);
+    AssertClosed(&unverifiedController);
+    DisconnectTestController(&unverifiedController);
+    SubscribeToEventValue(&subscribedController);
+    {
+        TestResponse response;
+        ReadLargeValue(&idleController, "", &response);
+        HAPAssert(response.status == 200);
+    }
+
+    // Connections are rejected if all sessions are handling requests or have subscriptions.
+    static const char requestStart[] = "GET /characteristics?id=";
+    SendBytes(&idleController, requestStart, sizeof requestStart - 1);
+    ConnectUnverifiedTestController(&unverifiedController);
+    AssertClosed(&unverifiedController);
+    DisconnectTestController(&unverifiedController);
+    char requestEnd[128];
+    err = HAPStringWithFormat(
+            requestEnd,
+            sizeof requestEnd,
+            "%llu.%llu HTTP/1.1\r\nHost: AcmeTest._hap._tcp.local\r\n\r\n",
+            (unsigned long long) accessory.aid,
+            (unsigned long long) largeValueCharacteristic.iid);
+    HAPAssert(!err);
+    SendBytes(&idleController, requestEnd, HAPStringGetNumBytes(requestEnd));
+    {
+        TestResponse response;
+        ReceiveResponse(&idleController, &response);
+        HAPAssert(response.status == 200);
+    }
+
+    // Sessions on which Pair Verify has not been completed are closed after their idle timeout.
+    DisconnectTestController(&idleController);
+    ConnectUnverifiedTestController(&unverifiedController);
+    HAPPlatformClockAdvance(unverifiedSessionIdleTimeout - 1);
+    AssertNoResponse(&unverifiedController);
+    HAPPlatformClockAdvance(1);
+    AssertClosed(&unverifiedController);
+    DisconnectTestController(&unverifiedController);
+
+    // Sessions on which Pair Verify has been completed stay open while sessions are available.
+    HAPPlatformClockAdvance(2 * 60 * HAPSecond);
+    {
+        TestResponse response;
+        ReadLargeValue(&subscribedController, "", &response);
+        HAPAssert(response.status == 200);
+    }
+
+    DisconnectTestController(&subscribedController);
+    StopAccessoryServer();
+    unverifiedSessionIdleTimeout = 0;
+}
+
+static void TestSessionAdmissionDuringPairVerify(void) {
+    numLargeValueBytes = 16;
+    maxChunkBytes = SIZE_MAX;
+    failingChunkOffset = SIZE_MAX;
+
+    StartAccessoryServer();
+    HAPAssert(numIPSessions == 2);
+    TestController subscribedController;
+    CreateTestController(&subscribedController);
+    ConnectTestController(&subscribedController);
+    SubscribeToEventValue(&subscribedController);
+    TestController verifyingController = subscribedController;
+    TestController floodController = subscribedController;
+
+    // A flood of connections does not evict a session on which Pair Verify is in progress.
+    ConnectTestControllerAndStartPairVerify(&verifyingController);
+    for (size_t i = 0; i < 16; i++) {
+        HAPPlatformClockAdvance(100);
+        ConnectUnverifiedTestController(&floodController);
+        AssertClosed(&floodController);
+        DisconnectTestController(&floodController);
+    }
+    FinishPairVerify(&verifyingController);
+    {
+        TestResponse response;
+        ReadLargeValue(&verifyingController, "", &response);
+        HAPAssert(response.status == 200);
+    }
+    DisconnectTestController(&verifyingController);
+
+    // Sessions that stall during Pair Verify are evicted once they have been inactive for the grace period.
+    ConnectTestControllerAndStartPairVerify(&verifyingController);
+    HAPPlatformClockAdvance(10 * HAPSecond - 1);
+    ConnectUnverifiedTestController(&floodController);
+    AssertClosed(&floodController);
+    DisconnectTestController(&floodController);
+    HAPPlatformClockAdvance(1);
+    ConnectUnverifiedTestController(&floodController);
+    AssertClosed(&verifyingController);
+    DisconnectTestController(&verifyingController);
+    AssertNoResponse(&floodController);
+    DisconnectTestController(&floodController);
+
+    DisconnectTestController(&subscribedController);
+    StopAccessoryServer();
+}
+
+int main() {
+    HAPPlatformCreate();
+
+    TestStreamingReads();
+    TestStreamingWrites();
+    TestAsynchronousRequests();
+    TestValueCache();
+    TestEventNotificationQueue();
+    TestSessionBufferPool();
+    TestMovedWriteContexts();
+    BenchmarkSessionBufferPool();
+    TestManySessions();
+    TestSessionAdmission();
+    TestSessionAdmissionDuringPairVerify();
+
+    return 0;
+}
@@ -0,0 +1,538 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/HAPBenchmark.c"
+#include "Harness/TemplateDB.c"
+
+#define kNumBenchmarkOperations ((size_t) 1000)
+
+/**
+ * Number of bridged accessories.
+ */
+#define kNumBridgedAccessories ((size_t) 32)
+
+/**
+ * Number of attributes of the bridge accessory and of all bridged accessories.
+ */
+#define kNumAttributes (kAttributeCount + 4 + kNumBridgedAccessories * (9 + 4))
+
+/**
+ * Maximum number of bytes of a serialized GET /accessories response.
+ */
+#define kMaxResponseBytes ((size_t) 65536)
+
+/**
+ * Whether the accessory server completed its shutdown.
+ */
+static bool accessoryServerIsStopped;
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server, void* _Nullable context HAP_UNUSED) {
+    HAPPrecondition(server);
+
+    accessoryServerIsStopped = HAPAccessoryServerGetState(server) == kHAPAccessoryServerState_Idle;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError IdentifyAccessory(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPAccessoryIdentifyRequest* request HAP_UNUSED,
+        void* _Nullable context HAP_UNUSED) {
+    HAPFatalError();
+}
+
+static const HAPUUID kTestServiceType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                            0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x41 } };
+static const HAPUUID kTestCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                   0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x42 } };
+static const HAPUUID kTestStringCharacteristicType = { { 0x8F, 0xB4, 0x30, 0xA4, 0x2C, 0x6D, 0x4C, 0x5B,
+                                                         0x9E, 0x34, 0x69, 0x1C, 0x41, 0x4B, 0xE0, 0x43 } };
+
+/**
+ * Value of the test characteristic.
+ */
+static uint8_t testValue;
+
+/**
+ * Value of the test string characteristic.
+ */
+static const char* testStringValue = "";
+
+/**
+ * Number of read requests that have been handled.
+ */
+static size_t numReadRequests;
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleTestCharacteristicRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPUInt8CharacteristicReadRequest* request HAP_UNUSED,
+        uint8_t* value,
+        void* _Nullable context HAP_UNUSED) {
+    *value = testValue;
+    numReadRequests++;
+    return kHAPError_None;
+}
+
+HAP_RESULT_USE_CHECK
+static HAPError HandleTestStringCharacteristicRead(
+        HAPAccessoryServerRef* server HAP_UNUSED,
+        const HAPStringCharacteristicReadRequest* request HAP_UNUSED,
+        char* value,
+        size_t maxValueBytes,
+        void* _Nullable context HAP_UNUSED) {
+    size_t numBytes = HAPStringGetNumBytes(testStringValue);
+    HAPAssert(numBytes < maxValueBytes);
+    HAPRawBufferCopyBytes(value, testStringValue, numBytes + 1);
+    numReadRequests++;
+    return kHAPError_None;
+}
+
+static const HAPUInt8Characteristic testCharacteristic = {
+    .format = kHAPCharacteristicFormat_UInt8,
+    .iid = 0x0031,
+    .characteristicType = &kTestCharacteristicType,
+    .debugDescription = "test",
+    .manufacturerDescription = NULL,
+    .properties = { .readable = true,
+                    .writable = false,
+                    .supportsEventNotification = true,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .units = kHAPCharacteristicUnits_Percentage,
+    .constraints = { .minimumValue = 0, .maximumValue = 100, .stepValue = 1 },
+    .callbacks = { .handleRead = HandleTestCharacteristicRead }
+};
+
+static const HAPStringCharacteristic testStringCharacteristic = {
+    .format = kHAPCharacteristicFormat_String,
+    .iid = 0x0032,
+    .characteristicType = &kTestStringCharacteristicType,
+    .debugDescription = "test string",
+    .manufacturerDescription = "Test \"\x01\x02\x03\"",
+    .properties = { .readable = true,
+                    .writable = false,
+                    .supportsEventNotification = false,
+                    .hidden = false,
+                    .readRequiresAdminPermissions = false,
+                    .writeRequiresAdminPermissions = false,
+                    .requiresTimedWrite = false,
+                    .supportsAuthorizationData = false,
+                    .ip = { .controlPoint = false, .supportsWriteResponse = false },
+                    .ble = { .supportsBroadcastNotification = false,
+                             .supportsDisconnectedNotification = false,
+                             .readableWithoutSecurity = false,
+                             .writableWithoutSecurity = false } },
+    .constraints = { .maxLength = 64 },
+    .callbacks = { .handleRead = HandleTestStringCharacteristicRead }
+};
+
+static const HAPService testService = {
+    .iid = 0x0030,
+    .serviceType = &kTestServiceType,
+    .debugDescription = "test",
+    .name = NULL,
+    .properties = { .primaryService = true, .hidden = false, .ble = { .supportsConfiguration = false } },
+    .linkedServices = NULL,
+    .characteristics = (const HAPCharacteristic* const[]) { &testCharacteristic, &testStringCharacteristic, NULL }
+};
+
+static const HAPAccessory bridgeAccessory = { .aid = 1,
+                                              .category = kHAPAccessoryCategory_Bridges,
+                                              .name = "Acme Test",
+                                              .manufacturer = "Acme",
+                                              .model = "Test1,1",
+                                              .serialNumber = "099DB48E9E28",
+                                              .firmwareVersion = "1",
+                                              .hardwareVersion = "1",
+                                              .services = (const HAPService* const[]) { &accessoryInformationService,
+                                                                                        &hapProtocolInformationService,
+                                                                                        &pairingService,
+                                                                                        &testService,
+                                                                                        NULL },
+                                              .callbacks = { .identify = IdentifyAccessory } };
+
+static const HAPService* const bridgedAccessoryServices[] = { &accessoryInformationService, &testService, NULL };
+
+static HAPAccessory bridgedAccessories[kNumBridgedAccessories];
+static const HAPAccessory* _Nullable bridgedAccessoryList[kNumBridgedAccessories + 1];
+
+/**
+ * Sets up the bridged accessories.
+ */
+static void PrepareBridgedAccessories(void) {
+    static char names[kNumBridgedAccessories][32];
+    for (size_t i = 0; i < kNumBridgedAccessories; i++) {
+        HAPError err = HAPStringWithFormat(names[i], sizeof names[i], "Acme Bridged %zu", i);
+        HAPAssert(!err);
+        bridgedAccessories[i] = (HAPAccessory) { .aid = 2 + i,
+                                                 .category = kHAPAccessoryCategory_BridgedAccessory,
+                                                 .name = names[i],
+                                                 .manufacturer = "Acme",
+                                                 .model = "Bridged1,1",
+                                                 .serialNumber = "099DB48E9E29",
+                                                 .firmwareVersion = "1",
+                                                 .hardwareVersion = "1",
+                                                 .services = bridgedAccessoryServices,
+                                                 .callbacks = { .identify = IdentifyAccessory } };
+        bridgedAccessoryList[i] = &bridgedAccessories[i];
+    }
+    bridgedAccessoryList[kNumBridgedAccessories] = NULL;
+}
+
+static HAPAccessoryServerRef accessoryServer;
+
+/**
+ * Creates and starts an accessory server that bridges the bridged accessories.
+ *
+ * @param      accessoriesCacheBytes GET /accessories cache buffer. Optional.
+ * @param      numAccessoriesCacheBytes Size of GET /accessories cache buffer.
+ * @param      flattenAttributeDatabase Whether flattened attribute database storage is provided.
+ */
+static void StartAccessoryServer(
+        void* _Nullable accessoriesCacheBytes,
+        size_t numAccessoriesCacheBytes,
+        bool flattenAttributeDatabase) {
+    static HAPAttributeDatabaseElementRef
+            attributeDatabaseElements[HAPAttributeDatabaseGetNumElements(1 + kNumBridgedAccessories, kNumAttributes)];
+    static HAPIPSession ipSessions[1];
+    static uint8_t ipInboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultInboundBufferSize];
+    static uint8_t ipOutboundBuffers[HAPArrayCount(ipSessions)][kHAPIPSession_DefaultOutboundBufferSize];
+    static HAPIPEventNotificationRef ipEventNotifications[HAPArrayCount(ipSessions)][kAttributeCount];
+    for (size_t i = 0; i < HAPArrayCount(ipSessions); i++) {
+        ipSessions[i].inboundBuffer.bytes = ipInboundBuffers[i];
+        ipSessions[i].inboundBuffer.numBytes = sizeof ipInboundBuffers[i];
+        ipSessions[i].outboundBuffer.bytes = ipOutboundBuffers[i];
+        ipSessions[i].outboundBuffer.numBytes = sizeof ipOutboundBuffers[i];
+        ipSessions[i].eventNotifications = ipEventNotifications[i];
+        ipSessions[i].numEventNotifications = HAPArrayCount(ipEventNotifications[i]);
+    }
+    static HAPIPReadContextRef ipReadContexts[kAttributeCount];
+    static HAPIPWriteContextRef ipWriteContexts[kAttributeCount];
+    static uint8_t ipScratchBuffer[kHAPIPSession_DefaultScratchBufferSize];
+    static HAPIPAccessoryServerStorage ipAccessoryServerStorage;
+    ipAccessoryServerStorage = (HAPIPAccessoryServerStorage) {
+        .sessions = ipSessions,
+        .numSessions = HAPArrayCount(ipSessions),
+        .readContexts = ipReadContexts,
+        .numReadContexts = HAPArrayCount(ipReadContexts),
+        .writeContexts = ipWriteContexts,
+        .numWriteContexts = HAPArrayCount(ipWriteContexts),
+        .scratchBuffer = { .bytes = ipScratchBuffer, .numBytes = sizeof ipScratchBuffer },
+        .accessoriesCache = { .bytes = accessoriesCacheBytes, .numBytes = numAccessoriesCacheBytes }
+    };
+
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .attributeDatabase = { .elements = flattenAttributeDatabase ? attributeDatabaseElements : NULL,
+                                           .numElements = flattenAttributeDatabase ?
+                                                                  HAPArrayCount(attributeDatabaseElements) :
+                                                                  0 },
+                    .ip = { .transport = &kHAPAccessoryServerTransport_IP,
+                            .accessoryServerStorage = &ipAccessoryServerStorage } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+
+    HAPAccessoryServerStartBridge(
+            &accessoryServer, &bridgeAccessory, bridgedAccessoryList, /* configurationChanged: */ false);
+    HAPPlatformClockAdvance(0);
+    HAPAssert(HAPAccessoryServerGetState(&accessoryServer) == kHAPAccessoryServerState_Running);
+}
+
+/**
+ * Stops and releases the accessory server.
+ */
+static void StopAccessoryServer(void) {
+    accessoryServerIsStopped = false;
+    HAPAccessoryServerStop(&accessoryServer);
+
+    // Timers that are registered while processing expired timers only fire on the next clock advance.
+    for (size_t i = 0; !accessoryServerIsStopped; i++) {
+        HAPAssert(i < 8);
+        HAPPlatformClockAdvance(0);
+    }
+    HAPAccessoryServerRelease(&accessoryServer);
+}
+
+/**
+ * Event notification state of the fake IP session.
+ */
+static HAPIPEventNotificationRef sessionEventNotifications[1];
+
+/**
+ * Sets up a secured IP session that has event notifications enabled for the test characteristic of an accessory.
+ *
+ * @param[out] session              IP session descriptor.
+ * @param      aid                  Accessory instance ID of the accessory with enabled event notifications.
+ */
+static void PrepareSession(HAPIPSessionDescriptor* session, uint64_t aid) {
+    HAPRawBufferZero(session, sizeof *session);
+    session->server = &accessoryServer;
+    session->securitySession.type = kHAPIPSecuritySessionType_HAP;
+    session->securitySession.isOpen = true;
+    session->securitySession.isSecured = true;
+
+    HAPIPEventNotification* eventNotification = (HAPIPEventNotification*) &sessionEventNotifications[0];
+    HAPRawBufferZero(eventNotification, sizeof *eventNotification);
+    eventNotification->aid = aid;
+    eventNotification->iid = testCharacteristic.iid;
+    session->eventNotifications = sessionEventNotifications;
+    session->maxEventNotifications = HAPArrayCount(sessionEventNotifications);
+    session->numEventNotifications = 1;
+}
+
+/**
+ * Serializes a GET /accessories response.
+ *
+ * @param      session              IP session descriptor.
+ * @param[out] bytes                Buffer to fill.
+ * @param      maxBytes             Capacity of buffer.
+ * @param      maxChunkBytes        Maximum number of bytes to serialize per invocation of the serializer.
+ *
+ * @return Number of bytes serialized.
+ */
+HAP_RESULT_USE_CHECK
+static size_t SerializeAccessories(
+        HAPIPSessionDescriptor* session,
+        char* bytes,
+        size_t maxBytes,
+        size_t maxChunkBytes) {
+    HAPError err;
+
+    HAPIPAccessorySerializationContext context;
+    HAPIPAccessoryCreateSerializationContext(&context, &accessoryServer);
+    size_t numBytes = 0;
+    while (!HAPIPAccessorySerializationIsComplete(&context)) {
+        size_t maxSerializedBytes = HAPMin(maxChunkBytes, maxBytes - numBytes);
+        size_t numSerializedBytes;
+        err = HAPIPAccessorySerializeReadResponse(
+                &context,
+                &accessoryServer,
+                (HAPIPSessionDescriptorRef*) session,
+                &bytes[numBytes],
+                /* minBytes: */ 1,
+                maxSerializedBytes,
+                &numSerializedBytes);
+        HAPAssert(!err);
+        HAPAssert(numSerializedBytes);
+        HAPAssert(numSerializedBytes <= maxSerializedBytes);
+        numBytes += numSerializedBytes;
+    }
+    return numBytes;
+}
+
+/**
+ * Serializes a GET /accessories response with and without the cache and checks that both responses match.
+ *
+ * @param      session              IP session descriptor.
+ * @param      maxChunkBytes        Maximum number of bytes to serialize per invocation of the serializer.
+ */
+static void CheckCachedResponse(HAPIPSessionDescriptor* session, size_t maxChunkBytes) {
+    static char cachedBytes[kMaxResponseBytes];
+    static char expectedBytes[kMaxResponseBytes];
+
+    HAPAssert(HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    numReadRequests = 0;
+    size_t numCachedBytes = SerializeAccessories(session, cachedBytes, sizeof cachedBytes, maxChunkBytes);
+    size_t numCachedReadRequests = numReadRequests;
+
+    HAPIPAccessoryReleaseAccessoriesCache(&accessoryServer);
+    HAPAssert(!HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    numReadRequests = 0;
+    size_t numExpectedBytes = SerializeAccessories(session, expectedBytes, sizeof expectedBytes, maxChunkBytes);
+    HAPAssert(numReadRequests == numCachedReadRequests);
+    HAPIPAccessoryCreateAccessoriesCache(&accessoryServer);
+    HAPAssert(HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+
+    HAPAssert(numCachedBytes == numExpectedBytes);
+    HAPAssert(HAPRawBufferAreEqual(cachedBytes, expectedBytes, numExpectedBytes));
+
+    // Cache markers must not leak into the response.
+    for (size_t i = 0; i < numCachedBytes; i++) {
+        HAPAssert((uint8_t) cachedBytes[i] >= 0x20);
+    }
+}
+
+/**
+ * Returns whether a GET /accessories response contains a string.
+ *
+ * @param      bytes                Response.
+ * @param      numBytes             Length of response.
+ * @param      string               String to search for.
+ *
+ * @return true                     If the response contains the string.
+ * @return false                    Otherwise.
+ */
+HAP_RESULT_USE_CHECK
+static bool ResponseContainsString(const char* bytes, size_t numBytes, const char* string) {
+    size_t numStringBytes = HAPStringGetNumBytes(string);
+    for (size_t i = 0; i + numStringBytes <= numBytes; i++) {
+        if (HAPRawBufferAreEqual(&bytes[i], string, numStringBytes)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void TestAccessoriesCache(void) {
+    static uint8_t accessoriesCacheBytes[kNumAttributes * kHAPIPAccessoriesCache_BytesPerAttribute];
+    static char bytes[kMaxResponseBytes];
+
+    PrepareBridgedAccessories();
+
+    StartAccessoryServer(accessoriesCacheBytes, sizeof accessoriesCacheBytes, /* flattenAttributeDatabase: */ true);
+    HAPAssert(HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    HAPAccessoryServer* server = (HAPAccessoryServer*) &accessoryServer;
+    size_t numCacheBytes = server->ip.accessoriesCache.numBytes;
+    HAPLogInfo(
+            &kHAPLog_Default, "GET /accessories cache: %zu bytes for %zu attributes.", numCacheBytes, kNumAttributes);
+
+    HAPIPSessionDescriptor session;
+    PrepareSession(&session, /* aid: */ 3);
+
+    // Cached responses match serialized responses, independent of chunking.
+    testValue = 42;
+    testStringValue = "Value \"\x01\x02\"";
+    CheckCachedResponse(&session, /* maxChunkBytes: */ 128);
+    CheckCachedResponse(&session, /* maxChunkBytes: */ 256);
+    CheckCachedResponse(&session, /* maxChunkBytes: */ kMaxResponseBytes);
+
+    // Characteristic values are read on every request.
+    testValue = 23;
+    size_t numBytes = SerializeAccessories(&session, bytes, sizeof bytes, kMaxResponseBytes);
+    HAPAssert(ResponseContainsString(bytes, numBytes, "\"value\":23,"));
+    HAPAssert(!ResponseContainsString(bytes, numBytes, "\"value\":42,"));
+    HAPAssert(ResponseContainsString(bytes, numBytes, "\"ev\":true"));
+    CheckCachedResponse(&session, /* maxChunkBytes: */ 128);
+
+    // Event notification state is per session.
+    PrepareSession(&session, /* aid: */ 4);
+    CheckCachedResponse(&session, /* maxChunkBytes: */ 128);
+
+    // Cache is set up again when the configuration number changes.
+    HAPError err = HAPAccessoryServerIncrementCN(&accessoryServer);
+    HAPAssert(!err);
+    HAPAssert(HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    HAPAssert(server->ip.accessoriesCache.configurationNumber == server->configurationNumber);
+    CheckCachedResponse(&session, /* maxChunkBytes: */ 128);
+
+    // Cache is not set up again while a session is serializing a response from it.
+    {
+        HAPIPSessionDescriptor* activeSession =
+                (HAPIPSessionDescriptor*) &HAPNonnull(server->ip.storage)->sessions[0].descriptor;
+        HAPAssert(!activeSession->server);
+        PrepareSession(activeSession, /* aid: */ 3);
+        activeSession->state = kHAPIPSessionState_Writing;
+        HAPIPAccessoryCreateSerializationContext(&activeSession->accessorySerializationContext, &accessoryServer);
+        size_t numSerializedBytes;
+        err = HAPIPAccessorySerializeReadResponse(
+                &activeSession->accessorySerializationContext,
+                &accessoryServer,
+                (HAPIPSessionDescriptorRef*) activeSession,
+                bytes,
+                /* minBytes: */ 1,
+                /* maxBytes: */ 128,
+                &numSerializedBytes);
+        HAPAssert(!err);
+        HAPAssert(activeSession->accessorySerializationContext.isCached);
+        HAPAssert(!HAPIPAccessorySerializationIsComplete(&activeSession->accessorySerializationContext));
+
+        err = HAPAccessoryServerIncrementCN(&accessoryServer);
+        HAPAssert(!err);
+        HAPAssert(!HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+        HAPAssert(server->ip.accessoriesCache.configurationNumber != server->configurationNumber);
+
+        // Once the session is done, the cache is set up again.
+        HAPRawBufferZero(activeSession, sizeof *activeSession);
+        HAPAssert(HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+        HAPAssert(server->ip.accessoriesCache.configurationNumber == server->configurationNumber);
+        PrepareSession(&session, /* aid: */ 3);
+        CheckCachedResponse(&session, /* maxChunkBytes: */ 128);
+    }
+    StopAccessoryServer();
+
+    // Cache is rebuilt for the new configuration number when the accessory server starts.
+    StartAccessoryServer(accessoriesCacheBytes, sizeof accessoriesCacheBytes, /* flattenAttributeDatabase: */ true);
+    HAPAssert(HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    PrepareSession(&session, /* aid: */ 3);
+    CheckCachedResponse(&session, /* maxChunkBytes: */ 128);
+    StopAccessoryServer();
+
+    // Exact storage.
+    StartAccessoryServer(accessoriesCacheBytes, numCacheBytes, /* flattenAttributeDatabase: */ true);
+    HAPAssert(HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    StopAccessoryServer();
+
+    // Storage too small. Responses are serialized on request.
+    StartAccessoryServer(accessoriesCacheBytes, numCacheBytes - 1, /* flattenAttributeDatabase: */ true);
+    HAPAssert(!HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    StopAccessoryServer();
+
+    // No storage.
+    StartAccessoryServer(
+            /* accessoriesCacheBytes: */ NULL, /* numAccessoriesCacheBytes: */ 0, /* flattenAttributeDatabase: */ true);
+    HAPAssert(!HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    StopAccessoryServer();
+
+    // Attribute database not flattened. Cache markers refer to flattened characteristic records.
+    StartAccessoryServer(accessoriesCacheBytes, sizeof accessoriesCacheBytes, /* flattenAttributeDatabase: */ false);
+    HAPAssert(!HAPIPAccessoryAccessoriesCacheIsValid(&accessoryServer));
+    StopAccessoryServer();
+}
+
+static void BenchmarkAccessoriesCache(void) {
+    static uint8_t accessoriesCacheBytes[kNumAttributes * kHAPIPAccessoriesCache_BytesPerAttribute];
+    static char bytes[kMaxResponseBytes];
+
+    PrepareBridgedAccessories();
+    HAPIPSessionDescriptor session;
+
+    StartAccessoryServer(
+            /* accessoriesCacheBytes: */ NULL, /* numAccessoriesCacheBytes: */ 0, /* flattenAttributeDatabase: */ true);
+    PrepareSession(&session, /* aid: */ 3);
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations; i++) {
+        size_t numBytes = SerializeAccessories(&session, bytes, sizeof bytes, kHAPIPSecurityProtocol_MaxFrameBytes);
+        HAPAssert(numBytes);
+    }
+    HAPBenchmarkLogRate(
+            "GET /accessories (serialized)", kNumBenchmarkOperations, HAPBenchmarkGetElapsedNanoseconds(&timer));
+    StopAccessoryServer();
+
+    StartAccessoryServer(accessoriesCacheBytes, sizeof accessoriesCacheBytes, /* flattenAttributeDatabase: */ true);
+    PrepareSession(&session, /* aid: */ 3);
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations; i++) {
+        size_t numBytes = SerializeAccessories(&session, bytes, sizeof bytes, kHAPIPSecurityProtocol_MaxFrameBytes);
+        HAPAssert(numBytes);
+    }
+    HAPBenchmarkLogRate(
+            "GET /accessories (cached)", kNumBenchmarkOperations, HAPBenchmarkGetElapsedNanoseconds(&timer));
+    StopAccessoryServer();
+}
+
+int main() {
+    HAPPlatformCreate();
+
+    TestAccessoriesCache();
+    BenchmarkAccessoriesCache();
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+
+#include "util_json_scanner.h"
+
+#include "Harness/HAPBenchmark.c"
+
+#define kNumWrites        64
+#define kNumBenchmarkRuns 200
+
+static char requestBytes[16 * 1024];
+
+/**
+ * Builds a PUT /characteristics body similar to a scene activation with many writes.
+ */
+HAP_RESULT_USE_CHECK
+static size_t BuildSceneRequest(void) {
+    HAPStringBuilderRef stringBuilder;
+    HAPStringBuilderCreate(&stringBuilder, requestBytes, sizeof requestBytes);
+    HAPStringBuilderAppend(&stringBuilder, "{\n    \"characteristics\": [\n");
+    for (size_t i = 0; i < kNumWrites; i++) {
+        switch (i % 4) {
+            case 0: {
+                HAPStringBuilderAppend(
+                        &stringBuilder, "        {\"aid\": %zu, \"iid\": %zu, \"value\": true}", i + 2, i * 16 + 9);
+            } break;
+            case 1: {
+                HAPStringBuilderAppend(
+                        &stringBuilder,
+                        "        {\"aid\": %zu, \"iid\": %zu, \"value\": -12.5e+1, \"ev\": false}",
+                        i + 2,
+                        i * 16 + 10);
+            } break;
+            case 2: {
+                HAPStringBuilderAppend(
+                        &stringBuilder,
+                        "        {\"aid\": %zu, \"iid\": %zu, \"value\": \"Living Room \\\"Scene\\\" %zu\"}",
+                        i + 2,
+                        i * 16 + 11,
+                        i);
+            } break;
+            default: {
+                HAPStringBuilderAppend(
+                        &stringBuilder,
+                        "        {\"aid\": %zu, \"iid\": %zu, \"value\": 1234567890123456789, \"r\": null}",
+                        i + 2,
+                        i * 16 + 12);
+            } break;
+        }
+        HAPStringBuilderAppend(&stringBuilder, "%s\n", i + 1 < kNumWrites ? "," : "");
+    }
+    HAPStringBuilderAppend(&stringBuilder, "    ]\n}\n");
+    HAPAssert(!HAPStringBuilderDidOverflow(&stringBuilder));
+    return HAPStringBuilderGetNumBytes(&stringBuilder);
+}
+
+static void TestClassifyMatchesScalar(void) {
+    static const char alphabet[] = " \t\n\r{}[]:,\"\\0123456789-+.eEtrufalsn/\x7f\x80\xff";
+
+    for (size_t i = 0; i < 10000; i++) {
+        uint8_t randomBytes[util_JSON_SCANNER_BLOCK_SIZE];
+        HAPPlatformRandomNumberFill(randomBytes, sizeof randomBytes);
+
+        char block[util_JSON_SCANNER_BLOCK_SIZE];
+        for (size_t j = 0; j < sizeof block; j++) {
+            // Mix arbitrary bytes with bytes that are relevant to JSON.
+            block[j] = (randomBytes[j] & 1) ? (char) randomBytes[j] :
+                                              alphabet[randomBytes[j] % (sizeof alphabet - 1)];
+        }
+
+        struct util_json_block masks;
+        struct util_json_block scalarMasks;
+        util_json_scanner_classify(block, &masks);
+        util_json_scanner_classify_scalar(block, &scalarMasks);
+        HAPAssert(masks.whitespace == scalarMasks.whitespace);
+        HAPAssert(masks.structural == scalarMasks.structural);
+        HAPAssert(masks.quote == scalarMasks.quote);
+        HAPAssert(masks.backslash == scalarMasks.backslash);
+        HAPAssert(masks.digit == scalarMasks.digit);
+    }
+}
+
+static void Fill(char* bytes, size_t numBytes, char value) {
+    for (size_t i = 0; i < numBytes; i++) {
+        bytes[i] = value;
+    }
+}
+
+static void TestScannerBoundaries(void) {
+    char bytes[3 * util_JSON_SCANNER_BLOCK_SIZE];
+
+    for (size_t i = 0; i <= sizeof bytes; i++) {
+        Fill(bytes, sizeof bytes, ' ');
+        if (i < sizeof bytes) {
+            bytes[i] = '{';
+        }
+        HAPAssert(util_json_scanner_skip_whitespace(bytes, sizeof bytes) == i);
+
+        Fill(bytes, sizeof bytes, '7');
+        if (i < sizeof bytes) {
+            bytes[i] = ',';
+        }
+        HAPAssert(util_json_scanner_skip_digits(bytes, sizeof bytes) == i);
+
+        Fill(bytes, sizeof bytes, 'x');
+        if (i < sizeof bytes) {
+            bytes[i] = (i & 1) ? '"' : '\\';
+        }
+        HAPAssert(util_json_scanner_skip_string_characters(bytes, sizeof bytes) == i);
+    }
+}
+
+/**
+ * Reads all tokens of a buffer, handing the reader at most maxChunkBytes at a time.
+ */
+HAP_RESULT_USE_CHECK
+static size_t ReadTokens(const char* bytes, size_t numBytes, size_t maxChunkBytes, int* states, size_t maxStates) {
+    struct util_json_reader reader;
+    util_json_reader_init(&reader);
+
+    size_t numStates = 0;
+    size_t n = 0;
+    while (n < numBytes) {
+        size_t chunkBytes = numBytes - n < maxChunkBytes ? numBytes - n : maxChunkBytes;
+        size_t numBytesRead = util_json_reader_read(&reader, &bytes[n], chunkBytes);
+        n += numBytesRead;
+        HAPAssert(reader.state != util_JSON_READER_STATE_ERROR);
+        if (reader.state != util_JSON_READER_STATE_READING_WHITESPACE) {
+            HAPAssert(numStates < maxStates);
+            states[numStates++] = reader.state;
+        }
+    }
+    return numStates;
+}
+
+static void TestReaderChunking(size_t numRequestBytes) {
+    static int states[4096];
+    static int byteAtATimeStates[4096];
+
+    size_t numStates = ReadTokens(requestBytes, numRequestBytes, numRequestBytes, states, HAPArrayCount(states));
+
+    // Reading one byte at a time only exercises the scalar tails of the scanner.
+    // Apart from the intermediate states of tokens that are split across reads, the same tokens must be reported.
+    size_t numByteAtATimeStates =
+            ReadTokens(requestBytes, numRequestBytes, 1, byteAtATimeStates, HAPArrayCount(byteAtATimeStates));
+    size_t j = 0;
+    for (size_t i = 0; i < numByteAtATimeStates; i++) {
+        int state = byteAtATimeStates[i];
+        if (state == util_JSON_READER_STATE_READING_NUMBER || state == util_JSON_READER_STATE_READING_STRING ||
+            state == util_JSON_READER_STATE_READING_FALSE || state == util_JSON_READER_STATE_READING_TRUE ||
+            state == util_JSON_READER_STATE_READING_NULL) {
+            continue;
+        }
+        HAPAssert(j < numStates);
+        HAPAssert(states[j] == state);
+        j++;
+    }
+    HAPAssert(j == numStates);
+}
+
+static void BenchmarkSkipValue(size_t numRequestBytes) {
+    HAPBenchmarkTimer timer;
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        struct util_json_reader reader;
+        util_json_reader_init(&reader);
+        size_t numBytesSkipped;
+        HAPError err = HAPJSONUtilsSkipValue(&reader, requestBytes, numRequestBytes, &numBytesSkipped);
+        HAPAssert(!err);
+        HAPAssert(numBytesSkipped <= numRequestBytes);
+    }
+    HAPBenchmarkLogThroughput(
+            "HAPJSONUtilsSkipValue",
+            (uint64_t) numRequestBytes * kNumBenchmarkRuns,
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    // Reference: feed the reader one byte at a time, which is equivalent to the previous byte-by-byte scanning.
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        struct util_json_reader reader;
+        util_json_reader_init(&reader);
+        for (size_t n = 0; n < numRequestBytes;) {
+            n += util_json_reader_read(&reader, &requestBytes[n], 1);
+        }
+        HAPAssert(reader.state != util_JSON_READER_STATE_ERROR);
+    }
+    HAPBenchmarkLogThroughput(
+            "util_json_reader_read (byte at a time)",
+            (uint64_t) numRequestBytes * kNumBenchmarkRuns,
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+}
+
+static void BenchmarkClassify(size_t numRequestBytes) {
+    size_t numBlocks = numRequestBytes / util_JSON_SCANNER_BLOCK_SIZE;
+    uint32_t checksum = 0;
+    uint32_t scalarChecksum = 0;
+    HAPBenchmarkTimer timer;
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        for (size_t j = 0; j < numBlocks; j++) {
+            struct util_json_block masks;
+            util_json_scanner_classify(&requestBytes[j * util_JSON_SCANNER_BLOCK_SIZE], &masks);
+            checksum += masks.whitespace ^ masks.structural ^ masks.quote ^ masks.backslash ^ masks.digit;
+        }
+    }
+    HAPBenchmarkLogThroughput(
+            "util_json_scanner_classify",
+            (uint64_t) numBlocks * util_JSON_SCANNER_BLOCK_SIZE * kNumBenchmarkRuns,
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        for (size_t j = 0; j < numBlocks; j++) {
+            struct util_json_block masks;
+            util_json_scanner_classify_scalar(&requestBytes[j * util_JSON_SCANNER_BLOCK_SIZE], &masks);
+            scalarChecksum += masks.whitespace ^ masks.structural ^ masks.quote ^ masks.backslash ^ masks.digit;
+        }
+    }
+    HAPBenchmarkLogThroughput(
+            "util_json_scanner_classify_scalar",
+            (uint64_t) numBlocks * util_JSON_SCANNER_BLOCK_SIZE * kNumBenchmarkRuns,
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    HAPAssert(checksum == scalarChecksum);
+}
+
+int main() {
+    size_t numRequestBytes = BuildSceneRequest();
+
+    TestClassifyMatchesScalar();
+    TestScannerBoundaries();
+    TestReaderChunking(numRequestBytes);
+
+    BenchmarkSkipValue(numRequestBytes);
+    BenchmarkClassify(numRequestBytes);
+
+    return 0;
+}
@@ -0,0 +1,316 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "HAP+Internal.h"
+#include "HAPPlatform+Init.h"
+
+#include "Harness/HAPBenchmark.c"
+#include "Harness/TemplateDB.c"
+
+/**
+ * Maximum number of session cache elements that are tested.
+ */
+#define kMaxSessionCacheElements ((size_t) 1024)
+
+/**
+ * Number of random operations per cache size.
+ */
+#define kNumRandomOperations ((size_t) 20000)
+
+/**
+ * Number of Pair Resume round trips per benchmark run.
+ */
+#define kNumBenchmarkOperations ((size_t) 100000)
+
+/**
+ * Reference entry.
+ */
+typedef struct {
+    HAPPairingBLESessionID sessionID;
+    uint8_t sharedSecret[X25519_SCALAR_BYTES];
+    int pairingID;
+} ReferenceEntry;
+
+/**
+ * Reference cache. Entries are ordered from least recently used to most recently used.
+ */
+typedef struct {
+    ReferenceEntry entries[kMaxSessionCacheElements];
+    size_t numEntries;
+    size_t capacity;
+} ReferenceCache;
+
+static void ReferenceRemove(ReferenceCache* cache, size_t index) {
+    HAPPrecondition(index < cache->numEntries);
+    HAPRawBufferCopyBytes(
+            &cache->entries[index],
+            &cache->entries[index + 1],
+            (cache->numEntries - index - 1) * sizeof cache->entries[0]);
+    cache->numEntries--;
+}
+
+HAP_RESULT_USE_CHECK
+static bool ReferenceFind(const ReferenceCache* cache, const HAPPairingBLESessionID* sessionID, size_t* index) {
+    for (size_t i = 0; i < cache->numEntries; i++) {
+        if (HAPRawBufferAreEqual(&cache->entries[i].sessionID, sessionID, sizeof *sessionID)) {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ReferenceSave(
+        ReferenceCache* cache,
+        const HAPPairingBLESessionID* sessionID,
+        const uint8_t sharedSecret[X25519_SCALAR_BYTES],
+        int pairingID) {
+    size_t index;
+    if (ReferenceFind(cache, sessionID, &index)) {
+        ReferenceRemove(cache, index);
+    } else if (cache->numEntries == cache->capacity) {
+        ReferenceRemove(cache, 0);
+    }
+    ReferenceEntry* entry = &cache->entries[cache->numEntries++];
+    entry->sessionID = *sessionID;
+    HAPRawBufferCopyBytes(entry->sharedSecret, sharedSecret, X25519_SCALAR_BYTES);
+    entry->pairingID = pairingID;
+}
+
+static void HandleUpdatedAccessoryServerState(HAPAccessoryServerRef* server, void* _Nullable context HAP_UNUSED) {
+    HAPPrecondition(server);
+}
+
+static HAPBLEGATTTableElementRef gattTableElements[kAttributeCount];
+static HAPBLESessionCacheElementRef sessionCacheElements[kMaxSessionCacheElements];
+static HAPSessionRef session;
+static uint8_t procedureBytes[2048];
+static HAPBLEProcedureRef procedures[1];
+static HAPBLEAccessoryServerStorage bleAccessoryServerStorage;
+static HAPAccessoryServerRef accessoryServer;
+
+static void CreateAccessoryServer(size_t numSessionCacheElements) {
+    HAPPrecondition(numSessionCacheElements <= HAPArrayCount(sessionCacheElements));
+
+    bleAccessoryServerStorage = (HAPBLEAccessoryServerStorage) {
+        .gattTableElements = gattTableElements,
+        .numGATTTableElements = HAPArrayCount(gattTableElements),
+        .sessionCacheElements = sessionCacheElements,
+        .numSessionCacheElements = numSessionCacheElements,
+        .session = &session,
+        .procedures = procedures,
+        .numProcedures = HAPArrayCount(procedures),
+        .procedureBuffer = { .bytes = procedureBytes, .numBytes = sizeof procedureBytes }
+    };
+    HAPAccessoryServerCreate(
+            &accessoryServer,
+            &(const HAPAccessoryServerOptions) {
+                    .maxPairings = kHAPPairingStorage_MinElements,
+                    .ble = { .transport = &kHAPAccessoryServerTransport_BLE,
+                             .accessoryServerStorage = &bleAccessoryServerStorage,
+                             .preferredAdvertisingInterval = kHAPBLEAdvertisingInterval_Minimum,
+                             .preferredNotificationDuration = kHAPBLENotification_MinDuration } },
+            &platform,
+            &(const HAPAccessoryServerCallbacks) { .handleUpdatedState = HandleUpdatedAccessoryServerState },
+            /* context: */ NULL);
+}
+
+/**
+ * Checks that a shared secret no longer appears in session cache storage.
+ */
+static void CheckSharedSecretIsZeroed(size_t numSessionCacheElements, const uint8_t sharedSecret[X25519_SCALAR_BYTES]) {
+    const uint8_t* bytes = (const uint8_t*) sessionCacheElements;
+    size_t numBytes = numSessionCacheElements * sizeof sessionCacheElements[0];
+    for (size_t i = 0; i + X25519_SCALAR_BYTES / 2 <= numBytes; i++) {
+        HAPAssert(!HAPRawBufferAreEqualPublic(&bytes[i], sharedSecret, X25519_SCALAR_BYTES / 2));
+    }
+}
+
+/**
+ * Checks that the shared secrets of all sessions that have been removed from the reference cache
+ * no longer appear in session cache storage.
+ */
+static void CheckRemovedSharedSecretsAreZeroed(
+        size_t numSessionCacheElements,
+        const ReferenceCache* previousReference,
+        const ReferenceCache* reference) {
+    for (size_t i = 0; i < previousReference->numEntries; i++) {
+        const ReferenceEntry* entry = &previousReference->entries[i];
+        bool isRemoved = true;
+        for (size_t j = 0; j < reference->numEntries; j++) {
+            if (HAPRawBufferAreEqual(entry->sharedSecret, reference->entries[j].sharedSecret, X25519_SCALAR_BYTES)) {
+                isRemoved = false;
+                break;
+            }
+        }
+        if (isRemoved) {
+            CheckSharedSecretIsZeroed(numSessionCacheElements, entry->sharedSecret);
+        }
+    }
+}
+
+static void RandomSessionID(HAPPairingBLESessionID* sessionID) {
+    HAPPlatformRandomNumberFill(sessionID->value, sizeof sessionID->value);
+}
+
+static void TestRandomOperations(size_t numSessionCacheElements) {
+    CreateAccessoryServer(numSessionCacheElements);
+
+    static ReferenceCache reference;
+    static ReferenceCache previousReference;
+    HAPRawBufferZero(&reference, sizeof reference);
+    reference.capacity = numSessionCacheElements;
+
+    // Scanning storage for removed shared secrets is only feasible for small caches.
+    bool checkSharedSecrets = numSessionCacheElements <= 64;
+
+    for (size_t i = 0; i < kNumRandomOperations; i++) {
+        if (checkSharedSecrets) {
+            previousReference = reference;
+        }
+
+        uint8_t operation;
+        HAPPlatformRandomNumberFill(&operation, sizeof operation);
+        operation %= 16;
+
+        HAPPairingBLESessionID sessionID;
+        RandomSessionID(&sessionID);
+        if (reference.numEntries && (operation & 1)) {
+            // Use a known session ID.
+            size_t index;
+            HAPPlatformRandomNumberFill(&index, sizeof index);
+            sessionID = reference.entries[index % reference.numEntries].sessionID;
+        }
+
+        if (operation < 9) {
+            uint8_t sharedSecret[X25519_SCALAR_BYTES];
+            HAPPlatformRandomNumberFill(sharedSecret, sizeof sharedSecret);
+            int pairingID = operation % 4;
+            HAPPairingBLESessionCacheSave(&accessoryServer, &sessionID, sharedSecret, pairingID);
+            ReferenceSave(&reference, &sessionID, sharedSecret, pairingID);
+        } else if (operation < 15) {
+            uint8_t sharedSecret[X25519_SCALAR_BYTES];
+            int pairingID;
+            HAPPairingBLESessionCacheFetch(&accessoryServer, &sessionID, sharedSecret, &pairingID);
+            size_t index;
+            if (ReferenceFind(&reference, &sessionID, &index)) {
+                HAPAssert(pairingID == reference.entries[index].pairingID);
+                HAPAssert(HAPRawBufferAreEqual(
+                        sharedSecret, reference.entries[index].sharedSecret, sizeof sharedSecret));
+                ReferenceRemove(&reference, index);
+            } else {
+                HAPAssert(pairingID == -1);
+            }
+        } else {
+            int pairingID = (int) (i % 4);
+            HAPPairingBLESessionCacheInvalidateEntriesForPairing(&accessoryServer, pairingID);
+            for (size_t j = 0; j < reference.numEntries;) {
+                if (reference.entries[j].pairingID == pairingID) {
+                    ReferenceRemove(&reference, j);
+                } else {
+                    j++;
+                }
+            }
+        }
+        if (checkSharedSecrets) {
+            CheckRemovedSharedSecretsAreZeroed(numSessionCacheElements, &previousReference, &reference);
+        }
+    }
+
+    // Fetch remaining sessions. Afterwards, no secrets may remain in storage.
+    while (reference.numEntries) {
+        ReferenceEntry* entry = &reference.entries[reference.numEntries - 1];
+        uint8_t sharedSecret[X25519_SCALAR_BYTES];
+        int pairingID;
+        HAPPairingBLESessionCacheFetch(&accessoryServer, &entry->sessionID, sharedSecret, &pairingID);
+        HAPAssert(pairingID == entry->pairingID);
+        HAPAssert(HAPRawBufferAreEqual(sharedSecret, entry->sharedSecret, sizeof sharedSecret));
+        if (checkSharedSecrets) {
+            CheckSharedSecretIsZeroed(numSessionCacheElements, entry->sharedSecret);
+        }
+        reference.numEntries--;
+    }
+
+    HAPAccessoryServerRelease(&accessoryServer);
+}
+
+static void TestLeastRecentlyUsedEviction(void) {
+    CreateAccessoryServer(kHAPBLESessionCache_MinElements);
+
+    HAPPairingBLESessionID sessionIDs[kHAPBLESessionCache_MinElements + 1];
+    uint8_t sharedSecret[X25519_SCALAR_BYTES];
+    HAPRawBufferZero(sharedSecret, sizeof sharedSecret);
+    for (size_t i = 0; i < HAPArrayCount(sessionIDs); i++) {
+        RandomSessionID(&sessionIDs[i]);
+        sharedSecret[0] = (uint8_t) i;
+        HAPPairingBLESessionCacheSave(&accessoryServer, &sessionIDs[i], sharedSecret, (int) i);
+    }
+
+    // Oldest session has been evicted.
+    int pairingID;
+    HAPPairingBLESessionCacheFetch(&accessoryServer, &sessionIDs[0], sharedSecret, &pairingID);
+    HAPAssert(pairingID == -1);
+    for (size_t i = 1; i < HAPArrayCount(sessionIDs); i++) {
+        HAPPairingBLESessionCacheFetch(&accessoryServer, &sessionIDs[i], sharedSecret, &pairingID);
+        HAPAssert(pairingID == (int) i);
+        HAPAssert(sharedSecret[0] == (uint8_t) i);
+
+        // Sessions are invalidated after fetching.
+        HAPPairingBLESessionCacheFetch(&accessoryServer, &sessionIDs[i], sharedSecret, &pairingID);
+        HAPAssert(pairingID == -1);
+    }
+
+    HAPAccessoryServerRelease(&accessoryServer);
+}
+
+static void BenchmarkSessionCache(size_t numSessionCacheElements) {
+    CreateAccessoryServer(numSessionCacheElements);
+
+    // Fill cache.
+    uint8_t sharedSecret[X25519_SCALAR_BYTES];
+    HAPPlatformRandomNumberFill(sharedSecret, sizeof sharedSecret);
+    for (size_t i = 0; i < numSessionCacheElements; i++) {
+        HAPPairingBLESessionID sessionID;
+        RandomSessionID(&sessionID);
+        HAPPairingBLESessionCacheSave(&accessoryServer, &sessionID, sharedSecret, 0);
+    }
+
+    // Pair Resume: Fetch unknown session ID (controller resumes with stale session), then save a new session.
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkOperations; i++) {
+        HAPPairingBLESessionID sessionID;
+        HAPWriteLittleUInt64(sessionID.value, i * UINT64_C(0x2545F4914F6CDD1D));
+        int pairingID;
+        HAPPairingBLESessionCacheFetch(&accessoryServer, &sessionID, sharedSecret, &pairingID);
+        HAPPairingBLESessionCacheSave(&accessoryServer, &sessionID, sharedSecret, 0);
+    }
+    char name[64];
+    HAPError err =
+            HAPStringWithFormat(name, sizeof name, "Pair Resume cache (%zu elements)", numSessionCacheElements);
+    HAPAssert(!err);
+    HAPBenchmarkLogRate(name, kNumBenchmarkOperations, HAPBenchmarkGetElapsedNanoseconds(&timer));
+
+    HAPAccessoryServerRelease(&accessoryServer);
+}
+
+int main() {
+    HAPPlatformCreate();
+
+    TestLeastRecentlyUsedEviction();
+
+    static const size_t numSessionCacheElements[] = {
+        kHAPBLESessionCache_MinElements, 13, 64, kMaxSessionCacheElements
+    };
+    for (size_t i = 0; i < HAPArrayCount(numSessionCacheElements); i++) {
+        TestRandomOperations(numSessionCacheElements[i]);
+    }
+    for (size_t i = 0; i < HAPArrayCount(numSessionCacheElements); i++) {
+        BenchmarkSessionCache(numSessionCacheElements[i]);
+    }
+
+    return 0;
+}
@@ -6,6 +6,8 @@
 
 #include "HAP+Internal.h"
 
+#include "Harness/HAPBenchmark.c"
+
 #define kPattern1a 0x23                   //  6 bit, 1 byte: '#'
 #define kPattern1b 0x61                   //  7 bit, 1 byte: 'a'
 #define kPattern2a 0xC3, 0xA4             //  8 bit, 2 byte: 'ä'
@@ -36,6 +38,99 @@ static const uint8_t testE[] = { kPattern1a, 0xC3, kPattern2b };
 static const uint8_t testF[] = { 0xF0, 0x96, 0xB9, kPattern3a };
 static const uint8_t testG[] = { kPattern2b, 0xEF, 0xBC };
 
+// Illegal values.
+static const uint8_t testH[] = { 0xC0, 0x80 };             // Overlong 2 byte.
+static const uint8_t testI[] = { 0xE0, 0x9F, 0xBF };       // Overlong 3 byte.
+static const uint8_t testJ[] = { 0xED, 0xA0, 0x80 };       // Surrogate.
+static const uint8_t testK[] = { 0xF0, 0x8F, 0xBF, 0xBF }; // Overlong 4 byte.
+static const uint8_t testL[] = { 0xF4, 0x90, 0x80, 0x80 }; // Above U+10FFFF.
+static const uint8_t testM[] = { 0xF8, 0x88, 0x80, 0x80 }; // 5 byte.
+
+typedef struct {
+    const uint8_t* bytes;
+    size_t numBytes;
+    bool isValid;
+} TestCase;
+
+#define TEST_CASE(test, valid) \
+    { .bytes = test, .numBytes = sizeof test, .isValid = valid }
+
+static const TestCase testCases[] = {
+    TEST_CASE(test0, true),
+    TEST_CASE(test1, true),
+    TEST_CASE(test2, true),
+    TEST_CASE(test3, true),
+    TEST_CASE(test4, true),
+    TEST_CASE(test5, true),
+    TEST_CASE(test6, true),
+    TEST_CASE(test7, true),
+    TEST_CASE(test8, true),
+    TEST_CASE(test9, true),
+    TEST_CASE(testA, false),
+    TEST_CASE(testB, false),
+    TEST_CASE(testC, false),
+    TEST_CASE(testD, false),
+    TEST_CASE(testE, false),
+    TEST_CASE(testF, false),
+    TEST_CASE(testG, false),
+    TEST_CASE(testH, false),
+    TEST_CASE(testI, false),
+    TEST_CASE(testJ, false),
+    TEST_CASE(testK, false),
+    TEST_CASE(testL, false),
+    TEST_CASE(testM, false),
+};
+
+/**
+ * Places each test case at every position of a longer buffer, so that it crosses the blocks of the vectorized
+ * implementation at every possible offset.
+ */
+static void TestBlockBoundaries(void) {
+    static const uint8_t fillers[][2] = { { kPattern1a, kPattern1b }, { kPattern2a } };
+
+    for (size_t f = 0; f < HAPArrayCount(fillers); f++) {
+        for (size_t t = 0; t < HAPArrayCount(testCases); t++) {
+            const TestCase* testCase = &testCases[t];
+            for (size_t offset = 0; offset <= 70; offset += 2) {
+                for (size_t numTrailingBytes = 0; numTrailingBytes <= 34; numTrailingBytes += 2) {
+                    uint8_t bytes[128];
+                    size_t numBytes = offset + testCase->numBytes + numTrailingBytes;
+                    HAPAssert(numBytes <= sizeof bytes);
+                    for (size_t i = 0; i < offset; i += 2) {
+                        HAPRawBufferCopyBytes(&bytes[i], fillers[f], sizeof fillers[f]);
+                    }
+                    HAPRawBufferCopyBytes(&bytes[offset], testCase->bytes, testCase->numBytes);
+                    for (size_t i = 0; i < numTrailingBytes; i += 2) {
+                        HAPRawBufferCopyBytes(
+                                &bytes[offset + testCase->numBytes + i], fillers[f], sizeof fillers[f]);
+                    }
+                    HAPAssert(HAPUTF8IsValidData(bytes, numBytes) == testCase->isValid);
+                }
+            }
+        }
+    }
+}
+
+#define kNumBenchmarkBytes (64 * 1024)
+#define kNumBenchmarkRuns  100
+
+static void BenchmarkIsValidData(const char* name, const uint8_t* pattern, size_t numPatternBytes) {
+    static uint8_t bytes[kNumBenchmarkBytes];
+    size_t numBytes = 0;
+    while (numBytes + numPatternBytes <= sizeof bytes) {
+        HAPRawBufferCopyBytes(&bytes[numBytes], pattern, numPatternBytes);
+        numBytes += numPatternBytes;
+    }
+
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        HAPAssert(HAPUTF8IsValidData(bytes, numBytes));
+    }
+    HAPBenchmarkLogThroughput(
+            name, (uint64_t) numBytes * kNumBenchmarkRuns, HAPBenchmarkGetElapsedNanoseconds(&timer));
+}
+
 int main() {
     HAPAssert(HAPUTF8IsValidData(test0, 0));
 
@@ -59,5 +154,14 @@ int main() {
     HAPAssert(!HAPUTF8IsValidData(testF, sizeof testF));
     HAPAssert(!HAPUTF8IsValidData(testG, sizeof testG));
 
+    TestBlockBoundaries();
+
+    static const uint8_t asciiText[] = "Living Room Lamp, Kitchen Ceiling Light, Garage Door Opener. ";
+    static const uint8_t mixedText[] = "Wohnzimmer Stehlampe \xC3\xA4\xC3\xB6\xC3\xBC, K\xC3\xBC" "che. ";
+    static const uint8_t multibyteText[] = { kPattern2a, kPattern2b, kPattern3a, kPattern3b, kPattern4a };
+    BenchmarkIsValidData("HAPUTF8IsValidData (ASCII)", asciiText, sizeof asciiText - 1);
+    BenchmarkIsValidData("HAPUTF8IsValidData (mixed)", mixedText, sizeof mixedText - 1);
+    BenchmarkIsValidData("HAPUTF8IsValidData (multibyte)", multibyteText, sizeof multibyteText);
+
     return 0;
 }
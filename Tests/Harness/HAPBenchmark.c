@@ -0,0 +1,63 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include <time.h>
+
+#include "HAPBenchmark.h"
+
+static const HAPLogObject logObject = { .subsystem = "com.apple.mfi.HomeKit.Core.Test", .category = "Benchmark" };
+
+HAP_RESULT_USE_CHECK
+static uint64_t GetMonotonicNanoseconds(void) {
+    struct timespec t;
+    int e = clock_gettime(CLOCK_MONOTONIC, &t);
+    HAPAssert(!e);
+    return (uint64_t) t.tv_sec * 1000000000ull + (uint64_t) t.tv_nsec;
+}
+
+void HAPBenchmarkStart(HAPBenchmarkTimer* timer) {
+    HAPPrecondition(timer);
+
+    timer->startNanoseconds = GetMonotonicNanoseconds();
+}
+
+HAP_RESULT_USE_CHECK
+uint64_t HAPBenchmarkGetElapsedNanoseconds(const HAPBenchmarkTimer* timer) {
+    HAPPrecondition(timer);
+
+    uint64_t now = GetMonotonicNanoseconds();
+    HAPAssert(now >= timer->startNanoseconds);
+    uint64_t elapsed = now - timer->startNanoseconds;
+    return elapsed ? elapsed : 1;
+}
+
+void HAPBenchmarkLogThroughput(const char* name, uint64_t numBytes, uint64_t elapsedNanoseconds) {
+    HAPPrecondition(name);
+    HAPPrecondition(elapsedNanoseconds);
+
+    // Throughput in kB/s to avoid floating point formatting in the log.
+    uint64_t kilobytesPerSecond = numBytes * 1000000ull / elapsedNanoseconds;
+    HAPLog(&logObject,
+           "%s: %llu bytes in %llu us (%llu.%03llu MB/s).",
+           name,
+           (unsigned long long) numBytes,
+           (unsigned long long) (elapsedNanoseconds / 1000),
+           (unsigned long long) (kilobytesPerSecond / 1000),
+           (unsigned long long) (kilobytesPerSecond % 1000));
+}
+
+void HAPBenchmarkLogRate(const char* name, uint64_t numOperations, uint64_t elapsedNanoseconds) {
+    HAPPrecondition(name);
+    HAPPrecondition(elapsedNanoseconds);
+
+    uint64_t operationsPerSecond = numOperations * 1000000000ull / elapsedNanoseconds;
+    HAPLog(&logObject,
+           "%s: %llu operations in %llu us (%llu ops/s).",
+           name,
+           (unsigned long long) numOperations,
+           (unsigned long long) (elapsedNanoseconds / 1000),
+           (unsigned long long) operationsPerSecond);
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#ifndef HAP_BENCHMARK_H
+#define HAP_BENCHMARK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "HAPPlatform.h"
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull begin
+#endif
+
+/**
+ * Wall clock stopwatch for micro benchmarks.
+ *
+ * - The Mock PAL clock only advances explicitly, so benchmarks measure time using the host's monotonic clock.
+ */
+typedef struct {
+    /** Start time in nanoseconds. */
+    uint64_t startNanoseconds;
+} HAPBenchmarkTimer;
+
+/**
+ * Starts a benchmark timer.
+ *
+ * @param[out] timer                Timer to start.
+ */
+void HAPBenchmarkStart(HAPBenchmarkTimer* timer);
+
+/**
+ * Returns the number of nanoseconds that elapsed since a benchmark timer was started.
+ *
+ * @param      timer                Started timer.
+ *
+ * @return Elapsed time in nanoseconds. At least 1.
+ */
+HAP_RESULT_USE_CHECK
+uint64_t HAPBenchmarkGetElapsedNanoseconds(const HAPBenchmarkTimer* timer);
+
+/**
+ * Logs the throughput of a benchmark in MB/s.
+ *
+ * @param      name                 Name of the benchmark.
+ * @param      numBytes             Number of bytes that were processed.
+ * @param      elapsedNanoseconds   Elapsed time in nanoseconds.
+ */
+void HAPBenchmarkLogThroughput(const char* name, uint64_t numBytes, uint64_t elapsedNanoseconds);
+
+/**
+ * Logs the rate of a benchmark in operations per second.
+ *
+ * @param      name                 Name of the benchmark.
+ * @param      numOperations        Number of operations that were processed.
+ * @param      elapsedNanoseconds   Elapsed time in nanoseconds.
+ */
+void HAPBenchmarkLogRate(const char* name, uint64_t numOperations, uint64_t elapsedNanoseconds);
+
+#if __has_feature(nullability)
+#pragma clang assume_nonnull end
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,217 @@
+// Copyright (c) 2015-2019 The HomeKit ADK Contributors
+//
+// Licensed under the Apache License, Version 2.0 (the “License”);
+// you may not use this file except in compliance with the License.
+// See [CONTRIBUTORS.md] for the list of HomeKit ADK project authors.
+
+#include "util_http_reader.h"
+
+#include "Harness/HAPBenchmark.c"
+
+#define kNumBenchmarkRuns 20000
+
+/**
+ * Request mix as recorded from a controller during a typical session.
+ */
+static const char* const requests[] = {
+    "POST /pair-verify HTTP/1.1\r\n"
+    "Host: Bridge._hap._tcp.local\r\n"
+    "Content-Length: 37\r\n"
+    "Content-Type: application/pairing+tlv8\r\n"
+    "\r\n",
+    "GET /accessories HTTP/1.1\r\n"
+    "Host: Bridge._hap._tcp.local\r\n"
+    "\r\n",
+    "GET /characteristics?id=1.10,1.11,2.10,2.11,3.10,3.11,4.10&ev=1&meta=1 HTTP/1.1\r\n"
+    "Host: Bridge._hap._tcp.local\r\n"
+    "\r\n",
+    "PUT /characteristics HTTP/1.1\r\n"
+    "Host: Bridge._hap._tcp.local\r\n"
+    "Content-Type: application/hap+json\r\n"
+    "Content-Length: 1432\r\n"
+    "\r\n",
+    "PUT /prepare HTTP/1.1\r\n"
+    "Host: Bridge._hap._tcp.local\r\n"
+    "Content-Type: application/hap+json\r\n"
+    "content-length: 29\r\n"
+    "X-Vendor-Header: \"quoted \\\" value\"\r\n"
+    "\r\n",
+};
+
+typedef struct {
+    char* _Nullable method;
+    size_t numMethodBytes;
+    char* _Nullable uri;
+    size_t numURIBytes;
+    size_t numHeaders;
+    size_t numHeaderValueBytes;
+} ParsedRequest;
+
+static void UpdateToken(struct util_http_reader* r, char* _Nullable* token, size_t* length) {
+    if (!*token) {
+        *token = r->result_token;
+        *length = r->result_length;
+    } else if (r->result_token) {
+        HAPAssert(&(*token)[*length] == r->result_token);
+        *length += r->result_length;
+    }
+}
+
+/**
+ * Parses a request, handing the reader at most maxChunkBytes at a time.
+ *
+ * @return Final state of the reader.
+ */
+HAP_RESULT_USE_CHECK
+static int ParseRequest(char* bytes, size_t numBytes, size_t maxChunkBytes, ParsedRequest* parsedRequest) {
+    HAPRawBufferZero(parsedRequest, sizeof *parsedRequest);
+
+    struct util_http_reader r;
+    util_http_reader_init(&r, util_HTTP_READER_TYPE_REQUEST);
+    size_t n = 0;
+    char* _Nullable headerValue = NULL;
+    size_t numHeaderValueBytes = 0;
+    do {
+        size_t chunkBytes = numBytes - n < maxChunkBytes ? numBytes - n : maxChunkBytes;
+        n += util_http_reader_read(&r, &bytes[n], chunkBytes);
+        switch (r.state) {
+            case util_HTTP_READER_STATE_READING_METHOD:
+            case util_HTTP_READER_STATE_COMPLETED_METHOD: {
+                UpdateToken(&r, &parsedRequest->method, &parsedRequest->numMethodBytes);
+            } break;
+            case util_HTTP_READER_STATE_READING_URI:
+            case util_HTTP_READER_STATE_COMPLETED_URI: {
+                UpdateToken(&r, &parsedRequest->uri, &parsedRequest->numURIBytes);
+            } break;
+            case util_HTTP_READER_STATE_READING_HEADER_VALUE: {
+                UpdateToken(&r, &headerValue, &numHeaderValueBytes);
+            } break;
+            case util_HTTP_READER_STATE_COMPLETED_HEADER_VALUE: {
+                UpdateToken(&r, &headerValue, &numHeaderValueBytes);
+                parsedRequest->numHeaders++;
+                parsedRequest->numHeaderValueBytes += numHeaderValueBytes;
+                headerValue = NULL;
+                numHeaderValueBytes = 0;
+            } break;
+            default: {
+            } break;
+        }
+    } while ((n < numBytes) && (r.state != util_HTTP_READER_STATE_DONE) &&
+             (r.state != util_HTTP_READER_STATE_ERROR));
+    return r.state;
+}
+
+static void TestRequestMix(void) {
+    for (size_t i = 0; i < HAPArrayCount(requests); i++) {
+        char bytes[256];
+        size_t numBytes = HAPStringGetNumBytes(requests[i]);
+        HAPAssert(numBytes <= sizeof bytes);
+        HAPRawBufferCopyBytes(bytes, requests[i], numBytes);
+
+        ParsedRequest parsedRequest;
+        int state = ParseRequest(bytes, numBytes, numBytes, &parsedRequest);
+        HAPAssert(state == util_HTTP_READER_STATE_DONE);
+        HAPAssert(parsedRequest.method);
+        HAPAssert(parsedRequest.uri);
+
+        // Parsing the same request one byte at a time must produce the same tokens.
+        ParsedRequest byteAtATimeRequest;
+        state = ParseRequest(bytes, numBytes, 1, &byteAtATimeRequest);
+        HAPAssert(state == util_HTTP_READER_STATE_DONE);
+        HAPAssert(byteAtATimeRequest.method == parsedRequest.method);
+        HAPAssert(byteAtATimeRequest.numMethodBytes == parsedRequest.numMethodBytes);
+        HAPAssert(byteAtATimeRequest.uri == parsedRequest.uri);
+        HAPAssert(byteAtATimeRequest.numURIBytes == parsedRequest.numURIBytes);
+        HAPAssert(byteAtATimeRequest.numHeaders == parsedRequest.numHeaders);
+        HAPAssert(byteAtATimeRequest.numHeaderValueBytes == parsedRequest.numHeaderValueBytes);
+    }
+}
+
+/**
+ * Reference character classes as specified by RFC 7230 and RFC 3986.
+ */
+/**@{*/
+static bool IsTokenChar(int c) {
+    return (33 <= c) && (c < 127) && (c != '(') && (c != ')') && (c != '<') && (c != '>') && (c != '@') && (c != ',') &&
+           (c != ';') && (c != ':') && (c != '\\') && (c != '"') && (c != '/') && (c != '[') && (c != ']') &&
+           (c != '?') && (c != '=') && (c != '{') && (c != '}');
+}
+
+static bool IsURIChar(int c) {
+    return (('A' <= c) && (c <= 'Z')) || (('a' <= c) && (c <= 'z')) || (('0' <= c) && (c <= '9')) || (c == '%') ||
+           (c == '-') || (c == '.') || (c == '_') || (c == '~') || (c == ':') || (c == '/') || (c == '?') ||
+           (c == '#') || (c == '[') || (c == ']') || (c == '@') || (c == '!') || (c == '$') || (c == '&') ||
+           (c == '\'') || (c == '(') || (c == ')') || (c == '*') || (c == '+') || (c == ',') || (c == ';') ||
+           (c == '=');
+}
+
+static bool IsTextChar(int c) {
+    return ((32 <= c) && (c < 127)) || (128 <= c) || (c == '\t');
+}
+/**@}*/
+
+static void TestCharacterClasses(void) {
+    for (int c = 0; c < 256; c++) {
+        // Header field name: "X<c>: v" is only valid if <c> is a token character.
+        {
+            char bytes[] = "GET / HTTP/1.1\r\nX?: v\r\n\r\n";
+            bytes[17] = (char) c;
+            ParsedRequest parsedRequest;
+            int state = ParseRequest(bytes, sizeof bytes - 1, sizeof bytes - 1, &parsedRequest);
+            HAPAssert((state == util_HTTP_READER_STATE_DONE) == (IsTokenChar(c) || c == ':'));
+        }
+        // URI: "/<c>" is only read as a single URI token if <c> is a URI character.
+        {
+            char bytes[] = "GET /? HTTP/1.1\r\n\r\n";
+            bytes[5] = (char) c;
+            ParsedRequest parsedRequest;
+            int state = ParseRequest(bytes, sizeof bytes - 1, sizeof bytes - 1, &parsedRequest);
+            HAPAssert(state != util_HTTP_READER_STATE_DONE || IsURIChar(c) || c == ' ' || c == '\t');
+            HAPAssert(parsedRequest.uri);
+            HAPAssert((parsedRequest.numURIBytes == 2) == IsURIChar(c));
+        }
+        // Header value: Long value with <c> after the first vector block.
+        {
+            char bytes[] = "GET / HTTP/1.1\r\nX: 0123456789abcdefghijklmnopqrstuv?wxyz\r\n\r\n";
+            bytes[51] = (char) c;
+            ParsedRequest parsedRequest;
+            int state = ParseRequest(bytes, sizeof bytes - 1, sizeof bytes - 1, &parsedRequest);
+            if (IsTextChar(c) && c != '"') {
+                HAPAssert(state == util_HTTP_READER_STATE_DONE);
+                HAPAssert(parsedRequest.numHeaderValueBytes == 38);
+            } else if (c != '"') {
+                HAPAssert(state != util_HTTP_READER_STATE_DONE || parsedRequest.numHeaderValueBytes != 38);
+            }
+        }
+    }
+}
+
+static void BenchmarkRequestMix(void) {
+    static char bytes[HAPArrayCount(requests)][256];
+    size_t numBytes[HAPArrayCount(requests)];
+    for (size_t i = 0; i < HAPArrayCount(requests); i++) {
+        numBytes[i] = HAPStringGetNumBytes(requests[i]);
+        HAPRawBufferCopyBytes(bytes[i], requests[i], numBytes[i]);
+    }
+
+    HAPBenchmarkTimer timer;
+    HAPBenchmarkStart(&timer);
+    for (size_t i = 0; i < kNumBenchmarkRuns; i++) {
+        for (size_t j = 0; j < HAPArrayCount(requests); j++) {
+            ParsedRequest parsedRequest;
+            int state = ParseRequest(bytes[j], numBytes[j], numBytes[j], &parsedRequest);
+            HAPAssert(state == util_HTTP_READER_STATE_DONE);
+        }
+    }
+    HAPBenchmarkLogRate(
+            "util_http_reader_read (requests)",
+            (uint64_t) kNumBenchmarkRuns * HAPArrayCount(requests),
+            HAPBenchmarkGetElapsedNanoseconds(&timer));
+}
+
+int main() {
+    TestRequestMix();
+    TestCharacterClasses();
+    BenchmarkRequestMix();
+    return 0;
+}